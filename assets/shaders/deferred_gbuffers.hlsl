@@ -1,5 +1,25 @@
 #include "octahedron_encoding.hlsli"
+#include "vertex_compression.hlsli"
 
+#ifndef NEB_COMPACT_VERTEX_FORMAT
+#define NEB_COMPACT_VERTEX_FORMAT 0
+#endif
+
+// Draws of ExecuteIndirect cannot change descriptor tables, their material textures are indexed from the start of the heap instead
+#ifndef NEB_BINDLESS_MATERIALS
+#define NEB_BINDLESS_MATERIALS 0
+#endif
+
+// refer to StaticMeshInputLayout and StaticMeshCompactInputLayout
+#if NEB_COMPACT_VERTEX_FORMAT
+struct VSInput
+{
+    float4 position : POSITION; // quantized, see InstanceInfo.PositionScale and InstanceInfo.PositionBias
+    float2 normal : NORMAL; // octahedral
+    float2 texUvs : TEXCOORD;
+    uint tangent : TANGENT; // see DecodeCompactTangent
+};
+#else
 struct VSInput
 {
     float3 position : POSITION;
@@ -7,6 +27,7 @@ struct VSInput
     float2 texUvs : TEXCOORD;
     float4 tangent : TANGENT;
 };
+#endif
 
 struct VSOutput
 {
@@ -16,6 +37,7 @@ struct VSOutput
     float3 bitangent : BITANGENT;
     float3 worldNormal : WORLDNORMAL;
     float3 worldPos : WORLDPOS;
+    nointerpolation uint materialFlags : MATERIALFLAGS;
 };
 
 // from Material.h
@@ -24,32 +46,60 @@ struct VSOutput
 #define kMaterialFlag_HasNormalMap 2
 #define kMaterialFlag_HasRoughnessMetalnessMap 4
 
-struct InstanceInfo
+struct ViewInfo
 {
     // Requires 256 alignment
+    float4x4 ViewProj;
+};
+ConstantBuffer<ViewInfo> cbViewInfo : register(b0);
+
+// Instances of a draw call follow each other, SV_InstanceID does not include StartInstanceLocation thus the first one is a root constant
+struct DrawInfo
+{
+    uint FirstInstance;
+    uint MaterialIndex; // first descriptor of material textures in the heap, NEB_BINDLESS_MATERIALS only
+};
+ConstantBuffer<DrawInfo> cbDrawInfo : register(b1);
+
+// refer to GbufferInstanceInfo
+struct InstanceInfo
+{
     float4x4 InstanceToWorld;
-    float4x4 ViewProj; // Currently view-proj is in instance info, just for the time being
+    float3 PositionScale; // dequantization of compact vertex positions, identity for the full format
     uint MaterialFlags; // refer to kMaterialFlag_*
+    float3 PositionBias;
+    uint _pad0;
 };
-ConstantBuffer<InstanceInfo> cbInstanceInfo : register(b0);
+StructuredBuffer<InstanceInfo> Instances : register(t0, space1);
 
-VSOutput VSMain(VSInput input)
+VSOutput VSMain(VSInput input, uint instanceId : SV_InstanceID)
 {
-    float4 worldPos = mul(float4(input.position, 1.0), cbInstanceInfo.InstanceToWorld);
+    InstanceInfo instance = Instances[cbDrawInfo.FirstInstance + instanceId];
 
+#if NEB_COMPACT_VERTEX_FORMAT
+    float3 position = DecodeCompactPosition(input.position.xyz, instance.PositionScale, instance.PositionBias);
+    float3 N = DecodeCompactNormal(input.normal);
+    float4 T = DecodeCompactTangent(input.tangent);
+#else
+    float3 position = input.position;
     float3 N = normalize(input.normal);
-    float3 tangent = input.tangent.xyz;
-    float3 bitangent = normalize(cross(N, tangent) * input.tangent.w);
+    float4 T = input.tangent;
+#endif
+    float4 worldPos = mul(float4(position, 1.0), instance.InstanceToWorld);
+
+    float3 tangent = T.xyz;
+    float3 bitangent = normalize(cross(N, tangent) * T.w);
 
     VSOutput output;
-    output.pos = mul(worldPos, cbInstanceInfo.ViewProj);
+    output.pos = mul(worldPos, cbViewInfo.ViewProj);
     output.texUv = input.texUvs;
     output.tangent = tangent;
     output.bitangent = bitangent;
 
     // TODO: we can now multiply normal with world matrix as we do not use scaling
-    output.worldNormal = normalize(mul(float4(input.normal, 0.0), cbInstanceInfo.InstanceToWorld).xyz);
+    output.worldNormal = normalize(mul(float4(N, 0.0), instance.InstanceToWorld).xyz);
     output.worldPos = worldPos.xyz;
+    output.materialFlags = instance.MaterialFlags;
     return output;
 }
 
@@ -57,7 +107,13 @@ VSOutput VSMain(VSInput input)
 #define kMaterialTextures_NormalMapIndex 1
 #define kMaterialTextures_RoughnessMetalnessMapIndex 2
 #define kMaterialTextures_NumTextureTypes 3
+#if NEB_BINDLESS_MATERIALS
+Texture2D BindlessTextures[] : register(t0, space2);
+Texture2D GetMaterialTexture(uint type) { return BindlessTextures[cbDrawInfo.MaterialIndex + type]; }
+#else
 Texture2D MaterialTextures[kMaterialTextures_NumTextureTypes] : register(t0, space0);
+Texture2D GetMaterialTexture(uint type) { return MaterialTextures[type]; }
+#endif
 SamplerState StaticSampler : register(s0);
 
 struct PSOutput
@@ -71,28 +127,31 @@ struct PSOutput
 PSOutput PSMain(VSOutput input)
 {
     float4 albedo = 0.0;
-    if (cbInstanceInfo.MaterialFlags & kMaterialFlag_HasAlbedoMap)
+    if (input.materialFlags & kMaterialFlag_HasAlbedoMap)
     {
-        albedo = MaterialTextures[kMaterialTextures_AlbedoMapIndex].Sample(StaticSampler, input.texUv);
+        albedo = GetMaterialTexture(kMaterialTextures_AlbedoMapIndex).Sample(StaticSampler, input.texUv);
     }
 
     float3 GN = normalize(input.worldNormal);
     float3 SN = GN;
-    if (cbInstanceInfo.MaterialFlags & kMaterialFlag_HasNormalMap)
+    if (input.materialFlags & kMaterialFlag_HasNormalMap)
     {
         float3 tangent = normalize(input.tangent);
         float3 bitangent = normalize(input.bitangent);
         float3x3 TBN = float3x3(tangent, bitangent, SN);
-        float3 NSample = MaterialTextures[kMaterialTextures_NormalMapIndex].Sample(StaticSampler, input.texUv).xyz * 2.0 - 1.0;
+        // Only xy is read, compressed normal maps (BC5) do not store z
+        float3 NSample;
+        NSample.xy = GetMaterialTexture(kMaterialTextures_NormalMapIndex).Sample(StaticSampler, input.texUv).xy * 2.0 - 1.0;
+        NSample.z = sqrt(saturate(1.0 - dot(NSample.xy, NSample.xy)));
         SN = normalize(mul(NSample, TBN));
     }
     
     // TODO: Make it roughness factor + metalness factor from Cbuffer
     float2 roughnessMetalness = float2(1.0, 0.0);
-    if (cbInstanceInfo.MaterialFlags & kMaterialFlag_HasRoughnessMetalnessMap)
+    if (input.materialFlags & kMaterialFlag_HasRoughnessMetalnessMap)
     {
         // Gltf stores roughness in green channel and metalness in blue channel
-        roughnessMetalness = MaterialTextures[kMaterialTextures_RoughnessMetalnessMapIndex].Sample(StaticSampler, input.texUv).gb;
+        roughnessMetalness = GetMaterialTexture(kMaterialTextures_RoughnessMetalnessMapIndex).Sample(StaticSampler, input.texUv).gb;
     }
     
     PSOutput output;
@@ -0,0 +1,193 @@
+// GPU side of nri::IndirectDrawList::CullAndCompact, both should produce the same argument streams bit by bit.
+// Records are culled against the frustum exactly as IsAABBInFrustum does, visible ones are compacted into the stream
+// of their pipeline in the order of records. Order is kept by a scan over groups of kGroupSize records in three dispatches
+// (see nri::IndirectDrawCuller):
+//  - CSCount counts visible records of every group in every stream
+//  - CSScanGroups (a single group) turns the counts into offsets of groups in the streams and writes totals of streams
+//  - CSCompact culls records of every group again and writes them at the offsets of their group
+
+#define kNumStreams 2 // nri::NumIndirectDrawStreams
+#define kNumAttributeTypes 4 // nri::eAttributeType_NumTypes
+#define kGroupSize 256 // nri::IndirectDrawCuller::NumRecordsPerGroup
+
+// refer to nri::IndirectDrawRecord
+struct IndirectDrawRecord
+{
+    float3 BoxMin;
+    uint NumIndices;
+    float3 BoxMax;
+    uint InstanceIndex;
+    uint GeometryIndex;
+    uint MaterialIndex;
+    uint StreamIndex;
+    uint _pad0;
+};
+
+// refer to nri::IndirectGeometry, views are copied as they are
+struct IndirectGeometry
+{
+    uint4 VertexViews[kNumAttributeTypes];
+    uint4 IndexView;
+};
+
+// refer to nri::IndirectDrawArguments
+struct IndirectDrawArguments
+{
+    uint InstanceIndex;
+    uint MaterialIndex;
+    uint4 VertexViews[kNumAttributeTypes];
+    uint4 IndexView;
+    uint IndexCountPerInstance;
+    uint InstanceCount;
+    uint StartIndexLocation;
+    int BaseVertexLocation;
+    uint StartInstanceLocation;
+    uint _pad0;
+};
+
+// refer to nri::CbIndirectCullInfo
+struct CullInfo
+{
+    float4 FrustumPlanes[6]; // refer to Frustum
+    uint NumRecords;
+    uint StreamCapacity; // stream s starts at argument s * StreamCapacity
+    uint NumGroups; // of CSCount and CSCompact
+};
+ConstantBuffer<CullInfo> cbCullInfo : register(b0);
+
+StructuredBuffer<IndirectDrawRecord> Records : register(t0);
+StructuredBuffer<IndirectGeometry> Geometries : register(t1);
+RWStructuredBuffer<IndirectDrawArguments> Arguments : register(u0);
+RWStructuredBuffer<uint> Counts : register(u1); // kNumStreams
+RWStructuredBuffer<uint> GroupOffsets : register(u2); // kNumStreams per group, counts of CSCount until CSScanGroups
+
+// Same operations in the same order as IsAABBInFrustum, precise keeps them from being fused
+bool IsBoxInFrustum(float3 boxMin, float3 boxMax)
+{
+    [unroll]
+    for (uint i = 0; i < 6; ++i)
+    {
+        float4 plane = cbCullInfo.FrustumPlanes[i];
+        float3 p = float3(plane.x >= 0.0 ? boxMax.x : boxMin.x, plane.y >= 0.0 ? boxMax.y : boxMin.y, plane.z >= 0.0 ? boxMax.z : boxMin.z);
+        precise float distance = plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w;
+        if (!(distance >= 0.0))
+            return false;
+    }
+    return true;
+}
+
+// Records past the end are never visible
+bool LoadRecord(uint recordIndex, out IndirectDrawRecord record)
+{
+    record = (IndirectDrawRecord)0;
+    if (recordIndex >= cbCullInfo.NumRecords)
+        return false;
+
+    record = Records[recordIndex];
+    return IsBoxInFrustum(record.BoxMin, record.BoxMax);
+}
+
+groupshared uint gsPrefix[kNumStreams][kGroupSize];
+groupshared uint gsStreamOffsets[kNumStreams];
+
+// Inclusive prefix sums of gsPrefix in every stream, values of the thread should be written before the call
+void ScanGroup(uint threadIndex)
+{
+    GroupMemoryBarrierWithGroupSync();
+    for (uint offset = 1; offset < kGroupSize; offset <<= 1)
+    {
+        uint values[kNumStreams];
+        [unroll]
+        for (uint s = 0; s < kNumStreams; ++s)
+            values[s] = (threadIndex >= offset) ? gsPrefix[s][threadIndex - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+
+        [unroll]
+        for (uint s = 0; s < kNumStreams; ++s)
+            gsPrefix[s][threadIndex] += values[s];
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+[numthreads(kGroupSize, 1, 1)]
+void CSCount(uint threadIndex : SV_GroupThreadID, uint groupIndex : SV_GroupID)
+{
+    IndirectDrawRecord record;
+    bool isVisible = LoadRecord(groupIndex * kGroupSize + threadIndex, record);
+
+    [unroll]
+    for (uint s = 0; s < kNumStreams; ++s)
+        gsPrefix[s][threadIndex] = (isVisible && record.StreamIndex == s) ? 1 : 0;
+    ScanGroup(threadIndex);
+
+    if (threadIndex < kNumStreams)
+        GroupOffsets[groupIndex * kNumStreams + threadIndex] = gsPrefix[threadIndex][kGroupSize - 1];
+}
+
+// Groups are scanned kGroupSize at a time, thus the amount of them is only limited by the dispatches of CSCount and CSCompact
+[numthreads(kGroupSize, 1, 1)]
+void CSScanGroups(uint threadIndex : SV_GroupThreadID)
+{
+    if (threadIndex < kNumStreams)
+        gsStreamOffsets[threadIndex] = 0;
+
+    for (uint first = 0; first < cbCullInfo.NumGroups; first += kGroupSize)
+    {
+        uint groupIndex = first + threadIndex;
+        uint counts[kNumStreams];
+        [unroll]
+        for (uint s = 0; s < kNumStreams; ++s)
+        {
+            counts[s] = (groupIndex < cbCullInfo.NumGroups) ? GroupOffsets[groupIndex * kNumStreams + s] : 0;
+            gsPrefix[s][threadIndex] = counts[s];
+        }
+        ScanGroup(threadIndex);
+
+        if (groupIndex < cbCullInfo.NumGroups)
+        {
+            [unroll]
+            for (uint s = 0; s < kNumStreams; ++s)
+                GroupOffsets[groupIndex * kNumStreams + s] = s * cbCullInfo.StreamCapacity + gsStreamOffsets[s] + gsPrefix[s][threadIndex] - counts[s];
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (threadIndex < kNumStreams)
+            gsStreamOffsets[threadIndex] += gsPrefix[threadIndex][kGroupSize - 1];
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (threadIndex < kNumStreams)
+        Counts[threadIndex] = gsStreamOffsets[threadIndex];
+}
+
+[numthreads(kGroupSize, 1, 1)]
+void CSCompact(uint threadIndex : SV_GroupThreadID, uint groupIndex : SV_GroupID)
+{
+    IndirectDrawRecord record;
+    bool isVisible = LoadRecord(groupIndex * kGroupSize + threadIndex, record);
+
+    [unroll]
+    for (uint s = 0; s < kNumStreams; ++s)
+        gsPrefix[s][threadIndex] = (isVisible && record.StreamIndex == s) ? 1 : 0;
+    ScanGroup(threadIndex);
+
+    if (isVisible)
+    {
+        IndirectGeometry geometry = Geometries[record.GeometryIndex];
+
+        IndirectDrawArguments arguments;
+        arguments.InstanceIndex = record.InstanceIndex;
+        arguments.MaterialIndex = record.MaterialIndex;
+        arguments.VertexViews = geometry.VertexViews;
+        arguments.IndexView = geometry.IndexView;
+        arguments.IndexCountPerInstance = record.NumIndices;
+        arguments.InstanceCount = 1;
+        arguments.StartIndexLocation = 0;
+        arguments.BaseVertexLocation = 0;
+        arguments.StartInstanceLocation = 0;
+        arguments._pad0 = 0;
+
+        uint stream = record.StreamIndex;
+        Arguments[GroupOffsets[groupIndex * kNumStreams + stream] + gsPrefix[stream][threadIndex] - 1] = arguments;
+    }
+}
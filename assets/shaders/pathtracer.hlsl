@@ -2,6 +2,7 @@
 #include "rtxgi/Nrc.hlsli"
 #include "rtxgi/NrcStructures.h"
 #include "octahedron_encoding.hlsli"
+#include "vertex_compression.hlsli"
 #include "rand.hlsli"
 #include "brdf.hlsli"
 #include "sun_disk_sampling.hlsli"
@@ -84,8 +85,16 @@ struct GeometryData
     uint attributeBufferOffsets[GeometryAttribute_NumTypes]; // in bytes
     uint attributeBufferStrides[GeometryAttribute_NumTypes]; // in bytes
     uint numVertices; // all attributes match this number of elements
+
+    uint vertexFormat; // refer to VertexFormat_*
+    float3 positionScale; // dequantization of compact positions
+    float3 positionBias;
 };
 
+// @see StaticMesh.h (EVertexFormat)
+#define VertexFormat_Full 0
+#define VertexFormat_Compact 1
+
 // @see Material.h
 enum MaterialTextureType
 {
@@ -296,6 +305,51 @@ uint3 ReadUint16Indices(in ByteAddressBuffer buf, in uint offsetInBytes)
     return indices;
 }
 
+uint GetVertexAttributeAddress(in GeometryData geometry, in uint attribute, in uint index)
+{
+    return geometry.attributeBufferOffsets[attribute] + index * geometry.attributeBufferStrides[attribute];
+}
+
+// Vertex loads below handle both vertex formats, compact one is decoded the same way as in VertexCompression.cpp
+float3 LoadVertexPosition(in GeometryData geometry, in ByteAddressBuffer buffer, in uint index)
+{
+    uint address = GetVertexAttributeAddress(geometry, GeometryAttribute_Position, index);
+    if (geometry.vertexFormat == VertexFormat_Compact)
+    {
+        uint2 packed = buffer.Load2(address);
+        float3 position = float3(UnpackSnorm16x2(packed.x), UnpackSnorm16x2(packed.y).x);
+        return DecodeCompactPosition(position, geometry.positionScale, geometry.positionBias);
+    }
+    return asfloat(buffer.Load3(address));
+}
+
+float3 LoadVertexNormal(in GeometryData geometry, in ByteAddressBuffer buffer, in uint index)
+{
+    uint address = GetVertexAttributeAddress(geometry, GeometryAttribute_Normal, index);
+    if (geometry.vertexFormat == VertexFormat_Compact)
+        return DecodeCompactNormal(UnpackSnorm16x2(buffer.Load(address)));
+
+    return asfloat(buffer.Load3(address));
+}
+
+float2 LoadVertexTexCoords(in GeometryData geometry, in ByteAddressBuffer buffer, in uint index)
+{
+    uint address = GetVertexAttributeAddress(geometry, GeometryAttribute_TexCoords, index);
+    if (geometry.vertexFormat == VertexFormat_Compact)
+        return UnpackHalf2(buffer.Load(address));
+
+    return asfloat(buffer.Load2(address));
+}
+
+float4 LoadVertexTangent(in GeometryData geometry, in ByteAddressBuffer buffer, in uint index)
+{
+    uint address = GetVertexAttributeAddress(geometry, GeometryAttribute_Tangents, index);
+    if (geometry.vertexFormat == VertexFormat_Compact)
+        return DecodeCompactTangent(buffer.Load(address));
+
+    return asfloat(buffer.Load4(address));
+}
+
 bool ReconstructSurfaceData(
     in uint triangleIndex,
     in uint geometryIndex,
@@ -324,26 +378,25 @@ bool ReconstructSurfaceData(
 
     ByteAddressBuffer positionBuffer = t_BindlessBuffers[NonUniformResourceIndex(geometry.attributeBufferIndices[GeometryAttribute_Position])];
     float3 rawPositions[3];
-    rawPositions[0] = asfloat(positionBuffer.Load3(geometry.attributeBufferOffsets[GeometryAttribute_Position] + indices[0] * geometry.attributeBufferStrides[GeometryAttribute_Position]));
-    rawPositions[1] = asfloat(positionBuffer.Load3(geometry.attributeBufferOffsets[GeometryAttribute_Position] + indices[1] * geometry.attributeBufferStrides[GeometryAttribute_Position]));
-    rawPositions[2] = asfloat(positionBuffer.Load3(geometry.attributeBufferOffsets[GeometryAttribute_Position] + indices[2] * geometry.attributeBufferStrides[GeometryAttribute_Position]));
+    rawPositions[0] = LoadVertexPosition(geometry, positionBuffer, indices[0]);
+    rawPositions[1] = LoadVertexPosition(geometry, positionBuffer, indices[1]);
+    rawPositions[2] = LoadVertexPosition(geometry, positionBuffer, indices[2]);
     float3 vertexPosition = InterpolateBary(rawPositions, barycentrics);
 
-    // Potentially normals could be stored as a uint32_t (or 24 bytes only, 8 byte per float, RGB8_SNORM format)
-    // But specifically in Nebulae this is not done, so just unpack them as you normally would
+    // Normals are either float3 or octahedral snorm16x2 (compact vertex format)
     ByteAddressBuffer normalBuffer = t_BindlessBuffers[NonUniformResourceIndex(geometry.attributeBufferIndices[GeometryAttribute_Normal])];
     float3 rawGeometryNormals[3];
-    rawGeometryNormals[0] = asfloat(normalBuffer.Load3(geometry.attributeBufferOffsets[GeometryAttribute_Normal] + indices[0] * geometry.attributeBufferStrides[GeometryAttribute_Normal]));
-    rawGeometryNormals[1] = asfloat(normalBuffer.Load3(geometry.attributeBufferOffsets[GeometryAttribute_Normal] + indices[1] * geometry.attributeBufferStrides[GeometryAttribute_Normal]));
-    rawGeometryNormals[2] = asfloat(normalBuffer.Load3(geometry.attributeBufferOffsets[GeometryAttribute_Normal] + indices[2] * geometry.attributeBufferStrides[GeometryAttribute_Normal]));
+    rawGeometryNormals[0] = LoadVertexNormal(geometry, normalBuffer, indices[0]);
+    rawGeometryNormals[1] = LoadVertexNormal(geometry, normalBuffer, indices[1]);
+    rawGeometryNormals[2] = LoadVertexNormal(geometry, normalBuffer, indices[2]);
     surfaceSample.GN = normalize(InterpolateBary(rawGeometryNormals, barycentrics));
     surfaceSample.GN = normalize(mul(float4(surfaceSample.GN, 0.0), geometry.surfaceToWorld).xyz);
 
     ByteAddressBuffer uvBuffer = t_BindlessBuffers[NonUniformResourceIndex(geometry.attributeBufferIndices[GeometryAttribute_TexCoords])];
     float2 rawUvs[3];
-    rawUvs[0] = asfloat(uvBuffer.Load2(geometry.attributeBufferOffsets[GeometryAttribute_TexCoords] + indices[0] * geometry.attributeBufferStrides[GeometryAttribute_TexCoords]));
-    rawUvs[1] = asfloat(uvBuffer.Load2(geometry.attributeBufferOffsets[GeometryAttribute_TexCoords] + indices[1] * geometry.attributeBufferStrides[GeometryAttribute_TexCoords]));
-    rawUvs[2] = asfloat(uvBuffer.Load2(geometry.attributeBufferOffsets[GeometryAttribute_TexCoords] + indices[2] * geometry.attributeBufferStrides[GeometryAttribute_TexCoords]));
+    rawUvs[0] = LoadVertexTexCoords(geometry, uvBuffer, indices[0]);
+    rawUvs[1] = LoadVertexTexCoords(geometry, uvBuffer, indices[1]);
+    rawUvs[2] = LoadVertexTexCoords(geometry, uvBuffer, indices[2]);
     float2 uv = InterpolateBary(rawUvs, barycentrics);
 
     if (geometry.materialIndex == InvalidIndex)
@@ -365,16 +418,19 @@ bool ReconstructSurfaceData(
     {
         ByteAddressBuffer tangentBuffer = t_BindlessBuffers[NonUniformResourceIndex(geometry.attributeBufferIndices[GeometryAttribute_Tangents])];
         float4 rawTangents[3]; // float4 as last element is a length of bitangent
-        rawTangents[0] = asfloat(tangentBuffer.Load4(geometry.attributeBufferOffsets[GeometryAttribute_Tangents] + indices[0] * geometry.attributeBufferStrides[GeometryAttribute_Tangents]));
-        rawTangents[1] = asfloat(tangentBuffer.Load4(geometry.attributeBufferOffsets[GeometryAttribute_Tangents] + indices[1] * geometry.attributeBufferStrides[GeometryAttribute_Tangents]));
-        rawTangents[2] = asfloat(tangentBuffer.Load4(geometry.attributeBufferOffsets[GeometryAttribute_Tangents] + indices[2] * geometry.attributeBufferStrides[GeometryAttribute_Tangents]));
+        rawTangents[0] = LoadVertexTangent(geometry, tangentBuffer, indices[0]);
+        rawTangents[1] = LoadVertexTangent(geometry, tangentBuffer, indices[1]);
+        rawTangents[2] = LoadVertexTangent(geometry, tangentBuffer, indices[2]);
         float4 tangent = normalize(InterpolateBary(rawTangents, barycentrics));
         float3 bitangent = normalize(cross(surfaceSample.GN, tangent.xyz) * tangent.w);
 
         surfaceSample.SN = surfaceSample.GN; // if no normal map then surface normal == geometry normal
         Texture2D normalMap = t_BindlessTextures[material.textureIndices[MaterialTexture_Normal]];
         float3x3 TBN = float3x3(tangent.xyz, bitangent, surfaceSample.GN);
-        float3 N = normalMap.SampleLevel(s_MaterialSampler, uv, 0).xyz * 2.0 - 1.0;
+        // Only xy is read, compressed normal maps (BC5) do not store z
+        float3 N;
+        N.xy = normalMap.SampleLevel(s_MaterialSampler, uv, 0).xy * 2.0 - 1.0;
+        N.z = sqrt(saturate(1.0 - dot(N.xy, N.xy)));
         surfaceSample.SN = normalize(mul(N, TBN));
     }
 
@@ -638,6 +694,6 @@ void PathtracerCH(
     payload.hitDistance = RayTCurrent();
     payload.instanceID = InstanceID();
     payload.primitiveIndex = PrimitiveIndex();
-    payload.geometryIndex = GeometryIndex();
+    payload.geometryIndex = InstanceID() + GeometryIndex(); // InstanceID() is the first geometry of the instance, see GIProcessedScene.cpp
     payload.barycentrics = attrib.uv;
 }
\ No newline at end of file
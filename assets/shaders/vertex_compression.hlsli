@@ -0,0 +1,45 @@
+#ifndef __VERTEX_COMPRESSION_H__
+#define __VERTEX_COMPRESSION_H__
+
+#include "octahedron_encoding.hlsli"
+
+// Decoding of the compact vertex format, mirrors VertexCompression.h
+// Input assembler already converts positions (R16G16B16A16_SNORM), normals (R16G16_SNORM) and texcoords (R16G16_FLOAT),
+// helpers below are for raw loads from byte address buffers and for tangents, that are always fetched as R32_UINT
+
+float DecodeSnorm16(in int v)
+{
+    return max(float(v) / 32767.0, -1.0);
+}
+
+// Sign-extends both halves of the packed value
+float2 UnpackSnorm16x2(in uint packed)
+{
+    int2 v = asint(uint2(packed << 16, packed)) >> 16;
+    return float2(DecodeSnorm16(v.x), DecodeSnorm16(v.y));
+}
+
+float2 UnpackHalf2(in uint packed)
+{
+    return f16tof32(uint2(packed, packed >> 16));
+}
+
+// position = bias + scale * snorm(position)
+float3 DecodeCompactPosition(in float3 position, in float3 scale, in float3 bias)
+{
+    return bias + scale * position;
+}
+
+float3 DecodeCompactNormal(in float2 encodedN)
+{
+    return Oct16_FastUnpack(encodedN);
+}
+
+// x is unorm16 in bits [0, 16), y is unorm15 in bits [16, 31), bit 31 is set if handedness is negative
+float4 DecodeCompactTangent(in uint packed)
+{
+    float2 encodedT = float2(packed & 0xffff, (packed >> 16) & 0x7fff) * float2(2.0 / 65535.0, 2.0 / 32767.0) - 1.0;
+    return float4(Oct16_FastUnpack(encodedT), (packed & 0x80000000) ? -1.0 : 1.0);
+}
+
+#endif // __VERTEX_COMPRESSION_H__
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Shared by every benchmark of a run, see BenchMain.cpp
+    struct BenchContext
+    {
+        std::filesystem::path WorkingDirectory; // generated scenes and their caches are written here
+        std::filesystem::path ScenePath;        // passed with --scene=, benchmarks of imports generate their own scenes if it is empty
+    };
+
+    using BenchFunction = void (*)(const BenchContext& context);
+
+    struct BenchCase
+    {
+        std::string_view Name;
+        BenchFunction Function = nullptr;
+        bool NeedsDevice = false; // nri::NRIDevice is initialized before the first of those is run
+    };
+
+    std::vector<BenchCase>& GetBenchCases();
+
+    struct BenchRegistration
+    {
+        BenchRegistration(std::string_view name, BenchFunction function, bool needsDevice)
+        {
+            GetBenchCases().push_back(BenchCase{ .Name = name, .Function = function, .NeedsDevice = needsDevice });
+        }
+    };
+
+    size_t GetWorkingSetBytes();
+
+    // Peak working set of the process only grows, thus it cannot tell runs of the same process apart. Sampler polls the current
+    // working set on a thread of its own instead, peak of the samples is the peak of whatever ran between Begin() and End()
+    class WorkingSetSampler
+    {
+    public:
+        ~WorkingSetSampler() { End(); }
+
+        void Begin();
+        size_t End(); // returns the peak working set in bytes
+
+    private:
+        std::thread m_thread;
+        std::atomic<bool> m_isSampling = false;
+        std::atomic<size_t> m_peakBytes = 0;
+    };
+
+    inline float ToMegabytes(uint64_t numBytes) { return numBytes / (1024.0f * 1024.0f); }
+
+} // Neb::bench namespace
+
+#define NEB_BENCH_IMPL(name, needsDevice)                                                                      \
+    static void NebBench_##name(const Neb::bench::BenchContext& context);                                      \
+    static const Neb::bench::BenchRegistration s_nebBench_##name(#name, &NebBench_##name, needsDevice);        \
+    static void NebBench_##name([[maybe_unused]] const Neb::bench::BenchContext& context)
+
+// Benchmark of CPU-side modules
+#define NEB_BENCH(name) NEB_BENCH_IMPL(name, false)
+
+// Benchmark that needs the device, e.g. imports that upload resources
+#define NEB_BENCH_DEVICE(name) NEB_BENCH_IMPL(name, true)
@@ -0,0 +1,117 @@
+#include "Bench.h"
+
+#include "common/Configuration.h"
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "nri/Device.h"
+#include "ArgumentParser.h"
+#include "Win.h"
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace Neb::bench
+{
+
+    std::vector<BenchCase>& GetBenchCases()
+    {
+        static std::vector<BenchCase> benchCases;
+        return benchCases;
+    }
+
+    size_t GetWorkingSetBytes()
+    {
+        PROCESS_MEMORY_COUNTERS counters = {};
+        return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.WorkingSetSize : 0;
+    }
+
+    void WorkingSetSampler::Begin()
+    {
+        End();
+        m_peakBytes = GetWorkingSetBytes();
+        m_isSampling = true;
+        m_thread = std::thread([this]()
+            {
+                while (m_isSampling.load(std::memory_order_relaxed))
+                {
+                    const size_t numBytes = GetWorkingSetBytes();
+                    if (numBytes > m_peakBytes.load(std::memory_order_relaxed))
+                        m_peakBytes.store(numBytes, std::memory_order_relaxed);
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+    }
+
+    size_t WorkingSetSampler::End()
+    {
+        if (m_thread.joinable())
+        {
+            m_isSampling = false;
+            m_thread.join();
+        }
+        return std::max(m_peakBytes.load(), GetWorkingSetBytes());
+    }
+
+} // Neb::bench namespace
+
+int32_t main(int argc, char* argv[])
+{
+    using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+    /* clang-format off */
+    Neb::ArgumentParser argParser(argc, argv);
+    const std::string_view filter = argParser.Get<std::string_view>(/*key*/ "filter", /*default-value*/ "");
+    Neb::bench::BenchContext context = {
+        .WorkingDirectory = argParser.Get<std::string_view>(/*key*/ "working-dir", /*default-value*/ ""),
+        .ScenePath = argParser.Get<std::string_view>(/*key*/ "scene", /*default-value*/ ""),
+    };
+
+    // Benchmarks measure release paths, debug layers would dominate every GPU-side number
+    Neb::Config::SetValue(Neb::EConfigKey::EnableDebugLayer,        false);
+    Neb::Config::SetValue(Neb::EConfigKey::EnableGpuValidation,     false);
+    Neb::Config::SetValue(Neb::EConfigKey::EnableDeviceDebugging,   false);
+    Neb::Config::SetValue(Neb::EConfigKey::EnableNvDriver,          false);
+    Neb::Config::SetValue(Neb::EConfigKey::NumWorkerThreads,        argParser.Get<int32_t>(/*key*/ "num-worker-threads", /*default-value*/ 0));
+    /* clang-format on */
+
+    if (context.WorkingDirectory.empty())
+        context.WorkingDirectory = std::filesystem::temp_directory_path() / "NebulaeBench";
+    std::filesystem::create_directories(context.WorkingDirectory);
+
+    bool isDeviceInitialized = false;
+    int32_t numFailed = 0;
+    for (const Neb::bench::BenchCase& benchCase : Neb::bench::GetBenchCases())
+    {
+        if (!filter.empty() && benchCase.Name.find(filter) == std::string_view::npos)
+            continue;
+
+        try
+        {
+            if (benchCase.NeedsDevice && !isDeviceInitialized)
+            {
+                Neb::nri::NRIDevice::Get().Init();
+                isDeviceInitialized = true;
+            }
+
+            NEB_LOG_INFO("NebulaeBench -> {}", benchCase.Name);
+            Neb::TimeWatch timeWatch;
+            timeWatch.Begin();
+            benchCase.Function(context);
+            NEB_LOG_INFO("NebulaeBench -> {} took {:.1f}ms", benchCase.Name, timeWatch.Elapsed<MillisecondsF32>().count());
+        }
+        catch (const std::exception& exception)
+        {
+            NEB_LOG_ERROR("NebulaeBench -> {} failed: {}", benchCase.Name, exception.what());
+            ++numFailed;
+        }
+    }
+
+    if (isDeviceInitialized)
+        Neb::nri::NRIDevice::Get().Deinit();
+
+    return numFailed == 0 ? 0 : 1;
+}
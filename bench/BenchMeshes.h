@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Separate streams of a bent grid in XZ, u grows along +x and v along +z
+    struct BenchGrid
+    {
+        explicit BenchGrid(uint32_t numVerticesPerSide)
+            : NumVertices(numVerticesPerSide * numVerticesPerSide)
+        {
+            for (uint32_t z = 0; z < numVerticesPerSide; ++z)
+            {
+                for (uint32_t x = 0; x < numVerticesPerSide; ++x)
+                {
+                    const float u = float(x) / float(numVerticesPerSide - 1);
+                    const float v = float(z) / float(numVerticesPerSide - 1);
+                    Positions.insert(Positions.end(), { u, 0.5f * std::sin(3.0f * u), v });
+                    Normals.insert(Normals.end(), { -std::sin(u), std::cos(u), 0.0f });
+                    TexCoords.insert(TexCoords.end(), { u, v });
+                }
+            }
+
+            for (uint32_t z = 0; z + 1 < numVerticesPerSide; ++z)
+            {
+                for (uint32_t x = 0; x + 1 < numVerticesPerSide; ++x)
+                {
+                    const uint32_t i = z * numVerticesPerSide + x;
+                    Indices.insert(Indices.end(), { i, i + numVerticesPerSide, i + 1, i + 1, i + numVerticesPerSide, i + numVerticesPerSide + 1 });
+                }
+            }
+        }
+
+        uint32_t GetNumIndices() const { return static_cast<uint32_t>(Indices.size()); }
+
+        uint32_t NumVertices = 0;
+        std::vector<float> Positions;
+        std::vector<float> Normals;
+        std::vector<float> TexCoords;
+        std::vector<uint32_t> Indices;
+    };
+
+} // Neb::bench namespace
@@ -0,0 +1,204 @@
+#include "BenchScene.h"
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "core/SceneCache.h"
+
+#include <TinyGLTF/tiny_gltf.h>
+#include <TinyGLTF/stb_image_write.h>
+
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    namespace
+    {
+        // Appends the elements to the single buffer of the scene and returns their accessor
+        template<typename T>
+        int32_t AddAccessor(tinygltf::Model& model, const std::vector<T>& elements, int32_t componentType, int32_t type, int32_t target)
+        {
+            tinygltf::Buffer& buffer = model.buffers.front();
+            const size_t byteOffset = buffer.data.size();
+            buffer.data.resize(byteOffset + elements.size() * sizeof(T));
+            std::memcpy(buffer.data.data() + byteOffset, elements.data(), elements.size() * sizeof(T));
+
+            tinygltf::BufferView& bufferView = model.bufferViews.emplace_back();
+            bufferView.buffer = 0;
+            bufferView.byteOffset = byteOffset;
+            bufferView.byteLength = elements.size() * sizeof(T);
+            bufferView.target = target;
+
+            tinygltf::Accessor& accessor = model.accessors.emplace_back();
+            accessor.bufferView = static_cast<int32_t>(model.bufferViews.size() - 1);
+            accessor.componentType = componentType;
+            accessor.type = type;
+            accessor.count = type == TINYGLTF_TYPE_SCALAR ? elements.size() : elements.size() / tinygltf::GetNumComponentsInType(type);
+            return static_cast<int32_t>(model.accessors.size() - 1);
+        }
+
+        // Grid in XZ with a bump of its own, so that meshes are not identical
+        void AddGridMesh(tinygltf::Model& model, uint32_t meshIndex, uint32_t numGridVertices, int32_t materialIndex)
+        {
+            std::vector<float> positions, normals, texCoords;
+            const float phase = 0.37f * float(meshIndex);
+            for (uint32_t z = 0; z < numGridVertices; ++z)
+            {
+                for (uint32_t x = 0; x < numGridVertices; ++x)
+                {
+                    const float u = float(x) / float(numGridVertices - 1);
+                    const float v = float(z) / float(numGridVertices - 1);
+                    positions.insert(positions.end(), { u - 0.5f, 0.1f * std::sin(6.0f * u + phase) * std::cos(6.0f * v), v - 0.5f });
+                    normals.insert(normals.end(), { 0.0f, 1.0f, 0.0f });
+                    texCoords.insert(texCoords.end(), { u, v });
+                }
+            }
+
+            std::vector<uint32_t> indices;
+            for (uint32_t z = 0; z + 1 < numGridVertices; ++z)
+            {
+                for (uint32_t x = 0; x + 1 < numGridVertices; ++x)
+                {
+                    const uint32_t i = z * numGridVertices + x;
+                    indices.insert(indices.end(), { i, i + numGridVertices, i + 1, i + 1, i + numGridVertices, i + numGridVertices + 1 });
+                }
+            }
+
+            tinygltf::Primitive primitive;
+            primitive.mode = TINYGLTF_MODE_TRIANGLES;
+            primitive.material = materialIndex;
+            primitive.attributes["POSITION"] = AddAccessor(model, positions, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, TINYGLTF_TARGET_ARRAY_BUFFER);
+            primitive.attributes["NORMAL"] = AddAccessor(model, normals, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, TINYGLTF_TARGET_ARRAY_BUFFER);
+            primitive.attributes["TEXCOORD_0"] = AddAccessor(model, texCoords, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2, TINYGLTF_TARGET_ARRAY_BUFFER);
+            primitive.indices = AddAccessor(model, indices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR, TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+
+            tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes["POSITION"]];
+            positionAccessor.minValues = { -0.5, -0.1, -0.5 };
+            positionAccessor.maxValues = { 0.5, 0.1, 0.5 };
+
+            tinygltf::Mesh& mesh = model.meshes.emplace_back();
+            mesh.name = std::format("grid_{}", meshIndex);
+            mesh.primitives.push_back(std::move(primitive));
+        }
+
+        // Smooth gradient with noise on top, so that PNG decoding and block compression both have some work to do
+        bool WriteTexture(const std::filesystem::path& filepath, uint32_t textureIndex, uint32_t size)
+        {
+            std::vector<uint8_t> texels(size_t(size) * size * 4);
+            uint32_t state = 0x9E3779B9u * (textureIndex + 1);
+            for (uint32_t y = 0; y < size; ++y)
+            {
+                for (uint32_t x = 0; x < size; ++x)
+                {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+
+                    uint8_t* texel = &texels[(size_t(y) * size + x) * 4];
+                    texel[0] = static_cast<uint8_t>((x * 255 / size + textureIndex * 31) & 0xff);
+                    texel[1] = static_cast<uint8_t>((y * 255 / size + textureIndex * 17) & 0xff);
+                    texel[2] = static_cast<uint8_t>(state & 0x3f);
+                    texel[3] = 255;
+                }
+            }
+            return stbi_write_png(filepath.string().c_str(), int(size), int(size), 4, texels.data(), int(size * 4)) != 0;
+        }
+    } // anonymous namespace
+
+    std::filesystem::path WriteBenchScene(const std::filesystem::path& workingDirectory, const BenchSceneDesc& desc, EGLTFType type)
+    {
+        const std::filesystem::path directory = workingDirectory / std::format("scene_m{}_n{}_g{}_t{}x{}",
+            desc.NumMeshes, desc.NumNodes, desc.NumGridVertices, desc.NumTextures, desc.TextureSize);
+        // Stems differ, so that both files have scene caches of their own
+        const std::filesystem::path filepath = directory / "scene.gltf";
+        const std::filesystem::path binaryFilepath = directory / "scene_binary.glb";
+        const std::filesystem::path& requestedFilepath = (type == EGLTFType::Binary) ? binaryFilepath : filepath;
+        if (std::filesystem::exists(filepath) && std::filesystem::exists(binaryFilepath))
+            return requestedFilepath;
+
+        std::filesystem::create_directories(directory / "textures");
+
+        tinygltf::Model model;
+        model.asset.version = "2.0";
+        model.asset.generator = "NebulaeBench";
+
+        model.buffers.emplace_back().uri = "scene.bin";
+
+        // Textures are in a subdirectory on purpose, scene caches should track files the glTF references wherever they are
+        for (uint32_t i = 0; i < desc.NumTextures; ++i)
+        {
+            const std::string uri = std::format("textures/base_color_{}.png", i);
+            if (!WriteTexture(directory / uri, i, desc.TextureSize))
+                throw std::runtime_error(std::format("Failed to write '{}'", (directory / uri).string()));
+
+            tinygltf::Image& image = model.images.emplace_back();
+            image.uri = uri;
+            image.mimeType = "image/png";
+
+            tinygltf::Texture& texture = model.textures.emplace_back();
+            texture.source = static_cast<int32_t>(i);
+
+            tinygltf::Material& material = model.materials.emplace_back();
+            material.pbrMetallicRoughness.baseColorTexture.index = static_cast<int32_t>(i);
+        }
+
+        for (uint32_t i = 0; i < desc.NumMeshes; ++i)
+            AddGridMesh(model, i, desc.NumGridVertices, desc.NumTextures > 0 ? int32_t(i % desc.NumTextures) : -1);
+
+        tinygltf::Scene& scene = model.scenes.emplace_back();
+        const uint32_t numNodesInRow = static_cast<uint32_t>(std::ceil(std::sqrt(float(desc.NumNodes))));
+        for (uint32_t i = 0; i < desc.NumNodes; ++i)
+        {
+            tinygltf::Node& node = model.nodes.emplace_back();
+            node.mesh = static_cast<int32_t>(i % desc.NumMeshes);
+            node.translation = { 1.5 * double(i % numNodesInRow), 0.0, 1.5 * double(i / numNodesInRow) };
+            scene.nodes.push_back(static_cast<int32_t>(i));
+        }
+        model.defaultScene = 0;
+
+        tinygltf::TinyGLTF writer;
+        if (!writer.WriteGltfSceneToFile(&model, filepath.string(), /*embedImages*/ false, /*embedBuffers*/ false, /*prettyPrint*/ false, /*writeBinary*/ false))
+            throw std::runtime_error(std::format("Failed to write '{}'", filepath.string()));
+
+        // Buffer without a URI is the BIN chunk of .glb, textures are referenced by the same URIs
+        model.buffers.front().uri.clear();
+        if (!writer.WriteGltfSceneToFile(&model, binaryFilepath.string(), /*embedImages*/ false, /*embedBuffers*/ true, /*prettyPrint*/ false, /*writeBinary*/ true))
+            throw std::runtime_error(std::format("Failed to write '{}'", binaryFilepath.string()));
+
+        NEB_LOG_INFO("BenchScene -> Generated '{}' and '{}' ({} meshes, {} nodes, {} textures of {}x{})",
+            filepath.string(), binaryFilepath.filename().string(), desc.NumMeshes, desc.NumNodes, desc.NumTextures, desc.TextureSize, desc.TextureSize);
+        return requestedFilepath;
+    }
+
+    BenchImport ImportBenchScene(const std::filesystem::path& filepath, bool isCold)
+    {
+        if (isCold)
+        {
+            std::error_code error;
+            std::filesystem::remove(GetSceneCachePath(filepath), error);
+        }
+
+        WorkingSetSampler sampler;
+        sampler.Begin();
+
+        GLTFSceneImporter importer;
+        if (!importer.ImportScenesFromFile(filepath, filepath.extension() == ".glb" ? EGLTFType::Binary : EGLTFType::AsciiFile))
+            throw std::runtime_error(std::format("Failed to import '{}'", filepath.string()));
+
+        BenchImport result = {
+            .Stats = importer.GetImportStats(),
+            .PeakWorkingSetBytes = sampler.End(),
+        };
+        for (const Scoped<Scene>& scene : importer.ImportedScenes)
+        {
+            result.NumMeshes += scene->StaticMeshes.size();
+            result.NumInstances += scene->StaticMeshInstances.size();
+        }
+        return result;
+    }
+
+} // Neb::bench namespace
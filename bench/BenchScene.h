@@ -0,0 +1,38 @@
+#pragma once
+
+#include "core/GLTFSceneImporter.h"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace Neb::bench
+{
+
+    // Synthetic glTF scene for import benchmarks. Meshes are grids with positions, normals and texture coordinates (tangents are
+    // generated on import), node i places mesh i % NumMeshes in a square layout. Material i samples texture i % NumTextures
+    struct BenchSceneDesc
+    {
+        uint32_t NumMeshes = 1;
+        uint32_t NumNodes = 1;
+        uint32_t NumGridVertices = 64; // per side of the grid of every mesh
+        uint32_t NumTextures = 0;      // each texture is of its own material and contents, thus none are deduplicated
+        uint32_t TextureSize = 512;
+    };
+
+    // Writes .gltf with its buffer next to it and .glb with the buffer in its BIN chunk, both sharing PNG textures in a subdirectory,
+    // under a directory named after the desc. Scenes that were written earlier are reused (their caches as well, delete the .nebscene
+    // for a cold import). Returns the path of the .gltf or of the .glb
+    std::filesystem::path WriteBenchScene(const std::filesystem::path& workingDirectory, const BenchSceneDesc& desc, EGLTFType type = EGLTFType::AsciiFile);
+
+    struct BenchImport
+    {
+        GLTFImportStats Stats;
+        size_t PeakWorkingSetBytes = 0; // of the process while the scene was imported
+        size_t NumMeshes = 0;
+        size_t NumInstances = 0;
+    };
+
+    // Imports .gltf or .glb with an importer of its own, that is destroyed before returning. Cold imports delete the scene cache first
+    BenchImport ImportBenchScene(const std::filesystem::path& filepath, bool isCold);
+
+} // Neb::bench namespace
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // RGBA8 gradient with noise on top, so that filters and block encoders both have some work to do
+    inline std::vector<std::byte> MakeBenchTexels(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        std::vector<std::byte> texels(size_t(width) * height * 4);
+        uint32_t state = 0x9E3779B9u * (seed + 1);
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+
+                std::byte* texel = &texels[(size_t(y) * width + x) * 4];
+                texel[0] = std::byte((x * 255 / width + seed * 31) & 0xff);
+                texel[1] = std::byte((y * 255 / height + seed * 17) & 0xff);
+                texel[2] = std::byte(state & 0x3f);
+                texel[3] = std::byte(255);
+            }
+        }
+        return texels;
+    }
+
+} // Neb::bench namespace
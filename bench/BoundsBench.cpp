@@ -0,0 +1,66 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/Bounds.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Throughput of world boxes of 2M instances: the 8-corner scalar transform, the vectorized one, and the vectorized one on the shared pool
+    NEB_BENCH(Bounds)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumBoxes = 1u << 21;
+
+        std::mt19937_64 random(0xB0C5);
+        std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> scaleDistribution(0.25f, 4.0f);
+
+        std::vector<AABB> boxes(NumBoxes);
+        std::vector<Mat4> transforms(NumBoxes);
+        for (uint32_t i = 0; i < NumBoxes; ++i)
+        {
+            const Vec3 center = Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random)) * 10.0f;
+            const Vec3 extent = Vec3(scaleDistribution(random), scaleDistribution(random), scaleDistribution(random));
+            boxes[i] = AABB{ .min = center - extent, .max = center + extent };
+            transforms[i] = Mat4::CreateScale(scaleDistribution(random)) *
+                Mat4::CreateFromAxisAngle(Vec3::UnitY, unitDistribution(random) * std::numbers::pi_v<float>) *
+                Mat4::CreateTranslation(Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random)) * 100.0f);
+        }
+
+        std::vector<AABB> transformed(NumBoxes);
+        TimeWatch timeWatch;
+
+        timeWatch.Begin();
+        for (uint32_t i = 0; i < NumBoxes; ++i)
+            transformed[i] = TransformAABB(boxes[i], transforms[i]);
+        const float scalarMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        timeWatch.Begin();
+        for (uint32_t i = 0; i < NumBoxes; ++i)
+            transformed[i] = TransformAABBFast(boxes[i], transforms[i]);
+        const float fastMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        timeWatch.Begin();
+        TransformAABBs(transformed, boxes, transforms, threadPool);
+        const float parallelMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        auto getBoxesPerSecond = [](float milliseconds) { return NumBoxes / std::max(milliseconds * 1000.0f, 1e-3f); };
+        NEB_LOG_INFO("Bounds -> Transformed {} boxes: scalar {:.2f}ms ({:.1f} M/s), vectorized {:.2f}ms ({:.1f} M/s), vectorized on {} threads {:.2f}ms ({:.1f} M/s)",
+            NumBoxes,
+            scalarMs, getBoxesPerSecond(scalarMs),
+            fastMs, getBoxesPerSecond(fastMs),
+            threadPool.GetNumThreads(), parallelMs, getBoxesPerSecond(parallelMs));
+    }
+
+} // Neb::bench namespace
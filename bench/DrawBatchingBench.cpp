@@ -0,0 +1,52 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/DrawBatching.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Draw call reduction and batching time of a synthetic scene of 100k draws, where a few meshes are repeated a lot while most
+    // of the others only a couple of times. Unsorted keys go through the hash map, sorted ones only need a linear scan
+    NEB_BENCH(DrawBatching)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumDraws = 100'000;
+
+        std::mt19937_64 random(0x42A7);
+        std::vector<uint64_t> keys(NumDraws);
+        for (uint64_t& key : keys)
+        {
+            const double t = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+            key = static_cast<uint64_t>(std::pow(t, 4.0) * (NumDraws / 8));
+        }
+
+        DrawBatcher batcher;
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        batcher.Build(keys, UINT32_MAX);
+        const float unsortedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        std::ranges::sort(keys);
+        timeWatch.Begin();
+        const DrawBatchStats sortedStats = batcher.Build(keys, UINT32_MAX);
+        const float sortedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        NEB_LOG_INFO("DrawBatching -> {} draws in {} draw calls ({} instanced, largest of {} draws). Batched in {:.2f}ms unsorted, {:.2f}ms sorted",
+            sortedStats.NumDraws,
+            sortedStats.NumBatches,
+            sortedStats.NumInstancedBatches,
+            sortedStats.MaxBatchSize,
+            unsortedMs,
+            sortedMs);
+    }
+
+} // Neb::bench namespace
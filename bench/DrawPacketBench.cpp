@@ -0,0 +1,217 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/DrawBatching.h"
+#include "nri/DrawPacket.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        // Stands for ID3D12GraphicsCommandList, only keeps bound state and counts commands. About as cheap as a command list
+        // could ever be, so that mostly the cost of fetching draw state is measured
+        class StubCommandList
+        {
+        public:
+            void SetPipelineState(ID3D12PipelineState* pipelineState) { m_pipelineState = pipelineState; ++m_numCommands; }
+            void SetGraphicsRoot32BitConstant(UINT rootIndex, UINT value, UINT /*offset*/) { m_roots[rootIndex] = value; ++m_numCommands; }
+            void SetGraphicsRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table) { m_roots[rootIndex] = table.ptr; ++m_numCommands; }
+            void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) { m_topology = topology; ++m_numCommands; }
+            void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views) { std::copy_n(views, numViews, m_vertexViews.begin() + startSlot); ++m_numCommands; }
+            void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) { m_indexView = *view; ++m_numCommands; }
+            void DrawIndexedInstanced(UINT numIndices, UINT numInstances, UINT /*firstIndex*/, INT /*baseVertex*/, UINT /*firstInstance*/) { m_numIndices += uint64_t(numIndices) * numInstances; ++m_numCommands; }
+
+            uint64_t GetNumCommands() const { return m_numCommands; }
+
+        private:
+            ID3D12PipelineState* m_pipelineState = nullptr;
+            std::array<uint64_t, 4> m_roots = {};
+            D3D12_PRIMITIVE_TOPOLOGY m_topology = {};
+            std::array<D3D12_VERTEX_BUFFER_VIEW, nri::eAttributeType_NumTypes> m_vertexViews = {};
+            D3D12_INDEX_BUFFER_VIEW m_indexView = {};
+            uint64_t m_numIndices = 0;
+            uint64_t m_numCommands = 0;
+        };
+
+        struct SceneDraw
+        {
+            uint32_t InstanceIndex = 0;
+            uint32_t SubmeshIndex = 0;
+        };
+
+        // Submeshes of 256 materials on a mesh per 64 draws, resources are never touched by the stub
+        void BuildScene(std::vector<nri::StaticMesh>& meshes, std::vector<nri::StaticMeshInstance>& instances, std::vector<SceneDraw>& draws, uint32_t numDraws, std::mt19937_64& random)
+        {
+            const uint32_t numMeshes = std::max(numDraws / 64, 1u);
+            meshes.resize(numMeshes);
+            for (nri::StaticMesh& staticMesh : meshes)
+            {
+                staticMesh.Submeshes.resize(1 + random() % 4);
+                staticMesh.SubmeshMaterials.resize(staticMesh.Submeshes.size());
+                for (size_t submeshIndex = 0; submeshIndex < staticMesh.Submeshes.size(); ++submeshIndex)
+                {
+                    nri::StaticSubmesh& submesh = staticMesh.Submeshes[submeshIndex];
+                    submesh.VertexFormat = static_cast<nri::EVertexFormat>(random() % nri::eVertexFormat_NumFormats);
+                    for (D3D12_VERTEX_BUFFER_VIEW& view : submesh.AttributeViews)
+                        view.BufferLocation = (random() & 0xFFFFFFFF) << 16;
+                    submesh.NumIndices = static_cast<UINT>(3 * (1 + random() % 8192));
+                    submesh.IBView = D3D12_INDEX_BUFFER_VIEW{ .BufferLocation = (random() & 0xFFFFFFFF) << 16, .Format = DXGI_FORMAT_R32_UINT };
+                    staticMesh.SubmeshMaterials[submeshIndex].SrvRange.GpuAddress.ptr = 0x100000 + (random() % 256) * nri::eMaterialTextureType_NumTypes * 32;
+                }
+            }
+
+            while (draws.size() < numDraws)
+            {
+                const uint32_t instanceIndex = static_cast<uint32_t>(instances.size());
+                instances.push_back(nri::StaticMeshInstance{ .MeshIndex = static_cast<uint32_t>(random() % numMeshes) });
+                for (uint32_t submeshIndex = 0; submeshIndex < meshes[instances.back().MeshIndex].Submeshes.size(); ++submeshIndex)
+                    draws.push_back(SceneDraw{ .InstanceIndex = instanceIndex, .SubmeshIndex = submeshIndex });
+            }
+        }
+    } // anonymous namespace
+
+    // Recording cost of G-buffer draws of a synthetic scene of 100k draws, half of which are visible: walking scene objects one by one
+    // (the way the pass used to) against batches of draw packets, in scene order and sorted by keys. Best of a few runs each
+    NEB_BENCH(DrawPacket)
+    {
+        static constexpr uint32_t NumDraws = 100'000;
+        static constexpr uint32_t NumRuns = 8;
+        static constexpr float NearZ = 0.1f;
+        static constexpr float FarZ = 100.0f;
+
+        std::mt19937_64 random(0xD4A);
+        std::vector<nri::StaticMesh> meshes;
+        std::vector<nri::StaticMeshInstance> instances;
+        std::vector<SceneDraw> sceneDraws;
+        BuildScene(meshes, instances, sceneDraws, NumDraws, random);
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        nri::DrawPacketCache cache;
+        cache.Build(meshes, instances);
+        const float buildMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        std::vector<uint32_t> visibleDraws;
+        for (uint32_t i = 0; i < sceneDraws.size(); ++i)
+        {
+            if (random() % 2 == 0)
+                visibleDraws.push_back(i);
+        }
+
+        NEB_LOG_INFO("DrawPacket -> {} packets ({} geometries, {} materials) built in {:.2f}ms, {} draws are recorded",
+            cache.GetNumPackets(),
+            cache.GetNumGeometries(),
+            cache.GetNumMaterials(),
+            buildMs,
+            visibleDraws.size());
+
+        const nri::DrawRecordDesc desc = nri::DrawRecordDesc{
+            .Pipelines = { reinterpret_cast<ID3D12PipelineState*>(uintptr_t(0x1000)), reinterpret_cast<ID3D12PipelineState*>(uintptr_t(0x2000)) },
+            .FirstInstanceRootIndex = 0,
+            .MaterialTableRootIndex = 1,
+        };
+
+        auto runRecording = [](auto&& record)
+            {
+                float bestMs = FLT_MAX;
+                StubCommandList commandList;
+                for (uint32_t run = 0; run < NumRuns; ++run)
+                {
+                    commandList = StubCommandList();
+                    TimeWatch timeWatch;
+                    timeWatch.Begin();
+                    record(&commandList);
+                    bestMs = std::min(bestMs, timeWatch.Elapsed<MillisecondsF32>().count());
+                }
+                return std::make_pair(commandList.GetNumCommands(), bestMs);
+            };
+
+        DrawBatcher batcher;
+        std::vector<uint64_t> stateKeys;
+        std::vector<uint32_t> compactedDraws;
+        auto recordDraws = [&](std::string_view name, std::span<const uint32_t> draws, uint32_t maxDrawsPerBatch)
+            {
+                stateKeys.resize(draws.size());
+                for (size_t i = 0; i < draws.size(); ++i)
+                    stateKeys[i] = cache.GetPacket(draws[i]).SortKey;
+
+                const DrawBatchStats batchStats = batcher.Build(stateKeys, maxDrawsPerBatch);
+                compactedDraws.resize(draws.size());
+                for (size_t i = 0; i < draws.size(); ++i)
+                    compactedDraws[i] = draws[batcher.GetOrder()[i]];
+
+                const auto [numSceneCommands, sceneMs] = runRecording([&](StubCommandList* commandList)
+                    {
+                        ID3D12PipelineState* currentPipelineState = nullptr;
+                        for (UINT i = 0; i < compactedDraws.size(); ++i)
+                        {
+                            const SceneDraw& draw = sceneDraws[compactedDraws[i]];
+                            const nri::StaticMesh& staticMesh = meshes[instances[draw.InstanceIndex].MeshIndex];
+                            const nri::StaticSubmesh& submesh = staticMesh.Submeshes[draw.SubmeshIndex];
+                            if (desc.Pipelines[submesh.VertexFormat] != currentPipelineState)
+                            {
+                                currentPipelineState = desc.Pipelines[submesh.VertexFormat];
+                                commandList->SetPipelineState(currentPipelineState);
+                            }
+                            commandList->SetGraphicsRoot32BitConstant(desc.FirstInstanceRootIndex, i, 0);
+                            commandList->SetGraphicsRootDescriptorTable(desc.MaterialTableRootIndex, staticMesh.SubmeshMaterials[draw.SubmeshIndex].SrvRange.GpuAddress);
+                            commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                            commandList->IASetVertexBuffers(0, nri::eAttributeType_NumTypes, submesh.AttributeViews.data());
+                            commandList->IASetIndexBuffer(&submesh.IBView);
+                            commandList->DrawIndexedInstanced(submesh.NumIndices, 1, 0, 0, 0);
+                        }
+                    });
+                nri::DrawRecordStats stats;
+                const auto [numPacketCommands, packetMs] = runRecording([&](StubCommandList* commandList)
+                    {
+                        stats = nri::RecordDrawPackets(commandList, cache, compactedDraws, batcher.GetBatches(), desc);
+                    });
+
+                const float numDraws = static_cast<float>(std::max<size_t>(draws.size(), 1));
+                NEB_LOG_INFO("DrawPacket -> {}: scene objects {:.1f}ns/draw, packets {:.1f}ns/draw. {} draw calls ({} instanced), {} -> {} commands. "
+                    "State changes: {} pipeline, {} material, {} vertex buffer, {} index buffer ({} redundant skipped)",
+                    name,
+                    sceneMs * 1e6f / numDraws,
+                    packetMs * 1e6f / numDraws,
+                    stats.NumDrawCalls,
+                    batchStats.NumInstancedBatches,
+                    numSceneCommands,
+                    numPacketCommands,
+                    stats.NumPipelineChanges,
+                    stats.NumMaterialChanges,
+                    stats.NumVertexBufferChanges,
+                    stats.NumIndexBufferChanges,
+                    stats.GetNumRedundantChanges());
+            };
+
+        recordDraws("Scene order", visibleDraws, 1);
+        recordDraws("Scene order, instanced", visibleDraws, UINT32_MAX);
+
+        std::vector<float> distances(visibleDraws.size());
+        for (float& distance : distances)
+            distance = std::uniform_real_distribution<float>(0.0f, FarZ * 1.5f)(random);
+
+        std::vector<uint32_t> sortedDraws = visibleDraws;
+        nri::DrawPacketSorter sorter;
+        timeWatch.Begin();
+        sorter.Sort(cache, sortedDraws, distances, NearZ, FarZ, ThreadPool::Get());
+        NEB_LOG_INFO("DrawPacket -> Sorted in {:.2f}ms", timeWatch.Elapsed<MillisecondsF32>().count());
+
+        recordDraws("Sorted", sortedDraws, 1);
+        recordDraws("Sorted, instanced", sortedDraws, UINT32_MAX);
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,62 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/FrameRing.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace Neb::bench
+{
+
+    // Throughput of 256-byte constants, the same as G-buffer draws allocate them, against a single bulk allocation per frame.
+    // The ring fits every frame in flight, completion lags 3 frames behind
+    NEB_BENCH(FrameRing)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint64_t NumBytesPerDraw = 256;
+        static constexpr uint32_t NumDrawsPerFrame = 16384;
+        static constexpr uint32_t NumFrames = 256;
+        static constexpr uint64_t NumInflightFrames = 3;
+
+        FrameRing ring((NumInflightFrames + 1) * NumDrawsPerFrame * NumBytesPerDraw);
+        uint32_t numFailedAllocations = 0;
+        auto runFrames = [&ring, &numFailedAllocations](auto&& allocateFrame)
+            {
+                TimeWatch timeWatch;
+                timeWatch.Begin();
+                for (uint64_t frame = 1; frame <= NumFrames; ++frame)
+                {
+                    numFailedAllocations += allocateFrame();
+                    ring.EndFrame(frame);
+                    ring.Release(frame > NumInflightFrames ? frame - NumInflightFrames : 0);
+                }
+                ring.Release(NumFrames);
+                return timeWatch.Elapsed<MillisecondsF32>().count();
+            };
+
+        const float perDrawMs = runFrames([&ring]()
+            {
+                uint32_t numFailed = 0;
+                for (uint32_t draw = 0; draw < NumDrawsPerFrame; ++draw)
+                    numFailed += (ring.Allocate(NumBytesPerDraw, NumBytesPerDraw) == FrameRing::InvalidOffset) ? 1 : 0;
+                return numFailed;
+            });
+        const float bulkMs = runFrames([&ring]()
+            {
+                return (ring.Allocate(NumBytesPerDraw * NumDrawsPerFrame, NumBytesPerDraw) == FrameRing::InvalidOffset) ? 1u : 0u;
+            });
+
+        const uint64_t numDraws = uint64_t(NumDrawsPerFrame) * NumFrames;
+        NEB_LOG_INFO("FrameRing -> {} frames of {} draws: per-draw allocations took {:.2f}ms ({:.1f} M allocations/s), bulk allocations {:.3f}ms, {} failed allocations",
+            NumFrames,
+            NumDrawsPerFrame,
+            perDrawMs,
+            numDraws / (std::max(perDrawMs, 0.001f) * 1000.0f),
+            bulkMs,
+            numFailedAllocations);
+    }
+
+} // Neb::bench namespace
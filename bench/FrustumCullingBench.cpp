@@ -0,0 +1,76 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/FrustumCulling.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Scalar reference, SIMD and SIMD on the shared pool for 10k, 100k and 1M draws around the camera
+    NEB_BENCH(FrustumCulling)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumDrawsToBenchmark[] = { 10'000, 100'000, 1'000'000 };
+
+        const Mat4 viewProj = Mat4::CreateLookAt(Vec3(0.0f), Vec3(0.0f, 0.0f, -1.0f), Vec3::UnitY) *
+            Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        const Frustum frustum = ExtractFrustum(viewProj);
+
+        std::mt19937_64 random(0xF5C);
+        std::uniform_real_distribution<float> positionDistribution(-150.0f, 150.0f);
+        std::uniform_real_distribution<float> extentDistribution(0.1f, 5.0f);
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        for (uint32_t numDraws : NumDrawsToBenchmark)
+        {
+            std::vector<AABB> boxes(numDraws);
+            FrustumCuller culler;
+            culler.Resize(numDraws);
+            for (uint32_t i = 0; i < numDraws; ++i)
+            {
+                const Vec3 center = Vec3(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+                const Vec3 extent = Vec3(extentDistribution(random), extentDistribution(random), extentDistribution(random));
+                boxes[i] = AABB{ .min = center - extent, .max = center + extent };
+                culler.SetBox(i, boxes[i]);
+            }
+
+            // Best of a few runs, as a single cull of 10k draws is way below the resolution of anything else here
+            static constexpr uint32_t NumRuns = 8;
+            float scalarMs = FLT_MAX;
+            float serialMs = FLT_MAX;
+            float parallelMs = FLT_MAX;
+            CullingStats stats;
+            for (uint32_t run = 0; run < NumRuns; ++run)
+            {
+                TimeWatch timeWatch;
+                timeWatch.Begin();
+                uint32_t numScalarVisible = 0;
+                for (const AABB& box : boxes)
+                    numScalarVisible += IsAABBInFrustum(frustum, box) ? 1 : 0;
+                scalarMs = std::min(scalarMs, timeWatch.Elapsed<MillisecondsF32>().count());
+
+                serialMs = std::min(serialMs, culler.Cull(frustum, threadPool, UINT32_MAX).Milliseconds);
+
+                stats = culler.Cull(frustum, threadPool);
+                parallelMs = std::min(parallelMs, stats.Milliseconds);
+            }
+
+            auto getDrawsPerSecond = [numDraws](float milliseconds) { return numDraws / std::max(milliseconds * 1000.0f, 1e-3f); };
+            NEB_LOG_INFO("FrustumCulling -> {} draws ({} visible): scalar {:.3f}ms ({:.1f} M/s), SIMD {:.3f}ms ({:.1f} M/s), SIMD on {} threads {:.3f}ms ({:.1f} M/s)",
+                numDraws, stats.NumVisible,
+                scalarMs, getDrawsPerSecond(scalarMs),
+                serialMs, getDrawsPerSecond(serialMs),
+                threadPool.GetNumThreads(), parallelMs, getDrawsPerSecond(parallelMs));
+        }
+    }
+
+} // Neb::bench namespace
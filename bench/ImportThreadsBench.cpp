@@ -0,0 +1,54 @@
+#include "Bench.h"
+#include "BenchScene.h"
+
+#include "common/Log.h"
+#include "core/GLTFSceneImporter.h"
+#include "core/SceneCache.h"
+#include "util/ThreadPool.h"
+
+#include <stdexcept>
+
+namespace Neb::bench
+{
+
+    // Cold imports of a scene with many textures on pools of 1 to 16 threads. Decoding, mips and compression of images
+    // scale with threads, while so does the memory of images that are processed at once, thus both are reported for every size
+    NEB_BENCH_DEVICE(ImportThreadSweep)
+    {
+        static constexpr uint32_t ThreadCounts[] = { 1, 2, 4, 8, 16 };
+
+        const std::filesystem::path filepath = !context.ScenePath.empty() ? context.ScenePath
+            : WriteBenchScene(context.WorkingDirectory, BenchSceneDesc{ .NumMeshes = 16, .NumNodes = 16, .NumTextures = 128, .TextureSize = 1024 });
+        const EGLTFType type = filepath.extension() == ".glb" ? EGLTFType::Binary : EGLTFType::AsciiFile;
+
+        float baseMilliseconds = 0.0f;
+        for (uint32_t numThreads : ThreadCounts)
+        {
+            std::error_code error;
+            std::filesystem::remove(GetSceneCachePath(filepath), error);
+
+            // Every job of the import (upload fills included) runs on the pool that is handed to the importer
+            ThreadPool threadPool(numThreads - 1);
+
+            WorkingSetSampler sampler;
+            sampler.Begin();
+
+            GLTFSceneImporter importer(/*sharedTextureRegistry*/ nullptr, &threadPool);
+            if (!importer.ImportScenesFromFile(filepath, type))
+                throw std::runtime_error("Failed to import " + filepath.string());
+
+            const size_t peakWorkingSetBytes = sampler.End();
+            const GLTFImportStats& stats = importer.GetImportStats();
+            if (numThreads == ThreadCounts[0])
+                baseMilliseconds = stats.Milliseconds;
+
+            NEB_LOG_INFO("ImportThreadSweep -> {:2} threads: {:.1f}ms ({:.2f}x), copied {:.1f} MB, peak working set {:.1f} MB",
+                numThreads,
+                stats.Milliseconds,
+                baseMilliseconds / stats.Milliseconds,
+                ToMegabytes(stats.NumCopiedBytes),
+                ToMegabytes(peakWorkingSetBytes));
+        }
+    }
+
+} // Neb::bench namespace
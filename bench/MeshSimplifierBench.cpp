@@ -0,0 +1,80 @@
+#include "Bench.h"
+#include "BenchMeshes.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/MeshSimplifier.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // LOD chains of 16 grids of 128x128 vertices (512K triangles) with the default settings, one after another and on the shared pool.
+    // Then triangles and the max error of every level over all of the grids
+    NEB_BENCH(MeshSimplifier)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumMeshes = 16;
+        const BenchGrid grid(/*numVerticesPerSide*/ 128);
+
+        const std::vector<MeshSimplifierSourceDesc> srcs(NumMeshes, MeshSimplifierSourceDesc{
+            .NumVertices = grid.NumVertices,
+            .Positions = reinterpret_cast<const std::byte*>(grid.Positions.data()),
+            .Normals = reinterpret_cast<const std::byte*>(grid.Normals.data()),
+            .TexCoords = reinterpret_cast<const std::byte*>(grid.TexCoords.data()),
+            .NumIndices = grid.GetNumIndices(),
+            .IndicesStride = sizeof(uint32_t),
+            .Indices = reinterpret_cast<const std::byte*>(grid.Indices.data()),
+        });
+
+        const MeshLodDesc desc;
+        std::vector<MeshLodChain> chains(NumMeshes);
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        for (uint32_t i = 0; i < NumMeshes; ++i)
+            BuildMeshLodChain(chains[i], srcs[i], desc);
+        const float serialMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        timeWatch.Begin();
+        BuildMeshLodChains(chains, srcs, desc, threadPool);
+        const float parallelMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        std::vector<uint64_t> numLevelTriangles(desc.MaxLods, 0);
+        std::vector<float> maxLevelErrors(desc.MaxLods, 0.0f);
+        uint64_t numRemovedTriangles = 0;
+        for (const MeshLodChain& chain : chains)
+        {
+            for (size_t level = 0; level < chain.Lods.size(); ++level)
+            {
+                numLevelTriangles[level] += chain.Lods[level].NumIndices / 3;
+                maxLevelErrors[level] = std::max(maxLevelErrors[level], chain.Lods[level].Error);
+                if (level > 0)
+                    numRemovedTriangles += (chain.Lods[level - 1].NumIndices - chain.Lods[level].NumIndices) / 3;
+            }
+        }
+
+        NEB_LOG_INFO("MeshSimplifier -> LODs of {} submeshes: serial {:.1f}ms ({:.2f} M removed triangles/s), {} threads {:.1f}ms ({:.2f} M removed triangles/s)",
+            NumMeshes,
+            serialMs,
+            numRemovedTriangles / (std::max(serialMs, 0.001f) * 1000.0f),
+            threadPool.GetNumThreads(),
+            parallelMs,
+            numRemovedTriangles / (std::max(parallelMs, 0.001f) * 1000.0f));
+
+        for (uint32_t level = 0; level < desc.MaxLods && numLevelTriangles[level] > 0; ++level)
+        {
+            NEB_LOG_INFO("MeshSimplifier -> LOD {}: {} triangles, max error {}",
+                level,
+                numLevelTriangles[level],
+                maxLevelErrors[level]);
+        }
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,66 @@
+#include "Bench.h"
+#include "BenchMeshes.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/MeshTangents.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // 64 bent grids of 256x256 vertices (8M triangles), SIMD path on the shared pool against the scalar reference
+    NEB_BENCH(MeshTangents)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumMeshes = 64;
+        const BenchGrid grid(/*numVerticesPerSide*/ 256);
+
+        // Meshes share the source streams, only tangents are separate
+        std::vector<float> tangents(size_t(NumMeshes) * grid.NumVertices * 4);
+        std::vector<TangentGenerationDesc> descs(NumMeshes);
+        for (uint32_t i = 0; i < NumMeshes; ++i)
+        {
+            descs[i] = TangentGenerationDesc{
+                .NumVertices = grid.NumVertices,
+                .Positions = reinterpret_cast<const std::byte*>(grid.Positions.data()),
+                .Normals = reinterpret_cast<const std::byte*>(grid.Normals.data()),
+                .TexCoords = reinterpret_cast<const std::byte*>(grid.TexCoords.data()),
+                .NumIndices = grid.GetNumIndices(),
+                .IndicesStride = sizeof(uint32_t),
+                .Indices = reinterpret_cast<const std::byte*>(grid.Indices.data()),
+                .Tangents = tangents.data() + size_t(i) * grid.NumVertices * 4,
+            };
+        }
+        const uint64_t numTriangles = uint64_t(NumMeshes) * grid.GetNumIndices() / 3;
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        GenerateTangents(descs, threadPool);
+        const float parallelMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        std::vector<float> referenceTangents(size_t(grid.NumVertices) * 4);
+        timeWatch.Begin();
+        for (TangentGenerationDesc desc : descs)
+        {
+            desc.Tangents = referenceTangents.data();
+            GenerateTangentsReference(desc);
+        }
+        const float referenceMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        NEB_LOG_INFO("MeshTangents -> {} triangles: scalar reference {:.1f}ms ({:.1f} Mtri/s), SIMD on {} threads {:.1f}ms ({:.1f} Mtri/s)",
+            numTriangles,
+            referenceMs,
+            numTriangles / (std::max(referenceMs, 0.001f) * 1000.0f),
+            threadPool.GetNumThreads(),
+            parallelMs,
+            numTriangles / (std::max(parallelMs, 0.001f) * 1000.0f));
+    }
+
+} // Neb::bench namespace
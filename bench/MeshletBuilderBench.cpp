@@ -0,0 +1,62 @@
+#include "Bench.h"
+#include "BenchMeshes.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/MeshletBuilder.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // 64 grids of 256x256 vertices (8M triangles) with the default limits, one after another and on the shared pool
+    NEB_BENCH(MeshletBuilder)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumMeshes = 64;
+        const BenchGrid grid(/*numVerticesPerSide*/ 256);
+
+        const std::vector<MeshletSourceDesc> srcs(NumMeshes, MeshletSourceDesc{
+            .NumVertices = grid.NumVertices,
+            .Positions = reinterpret_cast<const std::byte*>(grid.Positions.data()),
+            .NumIndices = grid.GetNumIndices(),
+            .IndicesStride = sizeof(uint32_t),
+            .Indices = reinterpret_cast<const std::byte*>(grid.Indices.data()),
+        });
+
+        const MeshletBuilderDesc desc;
+        std::vector<MeshletData> meshlets(NumMeshes);
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        for (uint32_t i = 0; i < NumMeshes; ++i)
+            BuildMeshlets(meshlets[i], srcs[i], desc);
+        const float serialMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        timeWatch.Begin();
+        BuildMeshlets(meshlets, srcs, desc, threadPool);
+        const float parallelMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        size_t numMeshlets = 0;
+        for (const MeshletData& data : meshlets)
+            numMeshlets += data.Meshlets.size();
+
+        NEB_LOG_INFO("MeshletBuilder -> {} meshlets ({} vertices, {} triangles max) of {} submeshes: serial {:.1f}ms ({:.1f} K meshlets/s), {} threads {:.1f}ms ({:.1f} K meshlets/s)",
+            numMeshlets,
+            desc.MaxVertices,
+            desc.MaxTriangles,
+            NumMeshes,
+            serialMs,
+            numMeshlets / std::max(serialMs, 0.001f),
+            threadPool.GetNumThreads(),
+            parallelMs,
+            numMeshlets / std::max(parallelMs, 0.001f));
+    }
+
+} // Neb::bench namespace
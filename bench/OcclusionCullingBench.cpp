@@ -0,0 +1,128 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/FrustumCulling.h"
+#include "core/OcclusionCulling.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Synthetic city of 100k draws: blocks of buildings along a street, that goes down the view direction. Buildings are occluders,
+    // draws are small props scattered between them. Frames run the whole stage of DeferredRenderer (selection of the largest
+    // occluders, rasterization and tests), repeated for the triangle budget to settle
+    NEB_BENCH(OcclusionCulling)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumDraws = 100'000;
+        static constexpr uint32_t NumFrames = 16;
+
+        std::mt19937_64 random(0x0CC);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        auto getRandom = [&](float min, float max) { return min + (max - min) * unitDistribution(random); };
+        auto getBox = [](const Vec3& center, const Vec3& size) { return AABB{ .min = center - size * 0.5f, .max = center + size * 0.5f }; };
+
+        OccluderMesh buildingMesh;
+        for (uint32_t i = 0; i < 8; ++i)
+            buildingMesh.Positions.push_back(Vec3((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+        buildingMesh.Indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5 };
+
+        std::vector<Mat4> buildings;
+        std::vector<AABB> buildingBoxes;
+        for (int32_t x = -10; x <= 10; ++x)
+        {
+            for (int32_t z = 1; z <= 25; ++z)
+            {
+                if (x == 0)
+                    continue;
+
+                const Vec3 size = Vec3(getRandom(10.0f, 14.0f), getRandom(10.0f, 40.0f), getRandom(10.0f, 14.0f));
+                const Vec3 center = Vec3(float(x) * 20.0f, size.y * 0.5f, float(z) * -20.0f);
+                buildings.push_back(Mat4::CreateScale(size) * Mat4::CreateTranslation(center));
+                buildingBoxes.push_back(getBox(center, size));
+            }
+        }
+
+        std::vector<AABB> draws(NumDraws);
+        for (AABB& draw : draws)
+            draw = getBox(Vec3(getRandom(-210.0f, 210.0f), getRandom(0.0f, 6.0f), getRandom(-510.0f, -5.0f)), Vec3(getRandom(0.5f, 2.0f)));
+
+        const OcclusionCullerDesc desc;
+        const Vec3 eye = Vec3(2.0f, 1.7f, 0.0f);
+        const Mat4 viewProj = Mat4::CreateLookAt(eye, eye + Vec3(0.0f, 0.0f, -1.0f), Vec3::UnitY) *
+            Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), float(desc.Width) / float(desc.Height), 0.1f, 1000.0f);
+        const Frustum frustum = ExtractFrustum(viewProj);
+        std::erase_if(draws, [&frustum](const AABB& draw) { return !IsAABBInFrustum(frustum, draw); });
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        OcclusionCuller culler;
+        culler.Init(desc);
+
+        std::vector<float> screenSizes(buildings.size());
+        std::vector<uint32_t> candidates;
+        std::vector<uint8_t> visible(draws.size());
+        float stageMs = 0.0f;
+        for (uint32_t frame = 0; frame < NumFrames; ++frame)
+        {
+            TimeWatch timeWatch;
+            timeWatch.Begin();
+
+            threadPool.ParallelForRange(buildings.size(), 4096, [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const AABB& box = buildingBoxes[i];
+                        screenSizes[i] = IsAABBInFrustum(frustum, box) ?
+                            (box.max - box.min).LengthSquared() / std::max(Vec3::DistanceSquared((box.min + box.max) * 0.5f, eye), 1e-4f) : 0.0f;
+                    }
+                });
+
+            candidates.clear();
+            for (uint32_t i = 0; i < buildings.size(); ++i)
+            {
+                if (screenSizes[i] > 0.0f)
+                    candidates.push_back(i);
+            }
+
+            auto isLarger = [&screenSizes](uint32_t a, uint32_t b) { return screenSizes[a] > screenSizes[b]; };
+            culler.BeginFrame(viewProj);
+            bool isBudgetExhausted = false;
+            for (size_t numSelected = 0; numSelected < candidates.size() && !isBudgetExhausted;)
+            {
+                const size_t numToSelect = std::min(candidates.size(), std::max<size_t>(numSelected * 2, 64));
+                std::nth_element(candidates.begin() + numSelected, candidates.begin() + numToSelect - 1, candidates.end(), isLarger);
+                std::sort(candidates.begin() + numSelected, candidates.begin() + numToSelect, isLarger);
+                for (; numSelected < numToSelect && !isBudgetExhausted; ++numSelected)
+                    isBudgetExhausted = !culler.AddOccluder(buildingMesh, buildings[candidates[numSelected]]);
+            }
+            culler.Rasterize(threadPool);
+            culler.TestBoxes(draws, visible, threadPool);
+
+            stageMs = timeWatch.Elapsed<MillisecondsF32>().count();
+        }
+
+        const OcclusionStats& stats = culler.GetStats();
+        NEB_LOG_INFO("OcclusionCulling -> {} draws, {} in frustum, {} occluded ({:.1f}%). {} occluders ({} triangles, budget {}) rasterized at {}x{} on {} threads in {:.3f}ms, tested in {:.3f}ms, whole stage {:.3f}ms of {:.1f}ms budget",
+            NumDraws,
+            draws.size(),
+            stats.NumOccluded,
+            100.0f * stats.NumOccluded / std::max<size_t>(draws.size(), 1),
+            stats.NumOccluders,
+            stats.NumRasterized,
+            stats.TriangleBudget,
+            desc.Width, desc.Height,
+            threadPool.GetNumThreads(),
+            stats.RasterMilliseconds,
+            stats.TestMilliseconds,
+            stageMs,
+            desc.BudgetMilliseconds);
+    }
+
+} // Neb::bench namespace
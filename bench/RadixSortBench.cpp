@@ -0,0 +1,76 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/RadixSort.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // 1M keys on the thread pool against std::sort of key and value pairs, best of a few runs for both. Random 64-bit keys need
+    // every pass, keys of draw packets (pipeline, material, geometry and depth) only use some of their bytes
+    NEB_BENCH(RadixSort)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumKeys = 1 << 20;
+        static constexpr uint32_t NumRuns = 5;
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        std::mt19937_64 random(0x5047);
+        RadixSorter sorter;
+
+        const std::pair<const char*, uint64_t> distributions[] = {
+            { "random", UINT64_MAX },
+            { "draw packet", 0xF00FFFFF0000FFFF },
+        };
+        for (const auto& [name, mask] : distributions)
+        {
+            std::vector<uint64_t> srcKeys(NumKeys);
+            for (uint64_t& key : srcKeys)
+                key = random() & mask;
+
+            std::vector<uint64_t> keys;
+            std::vector<uint32_t> values(NumKeys);
+            std::vector<std::pair<uint64_t, uint32_t>> pairs(NumKeys);
+            float radixMs = FLT_MAX;
+            float stdMs = FLT_MAX;
+            for (uint32_t run = 0; run < NumRuns; ++run)
+            {
+                keys = srcKeys;
+                std::iota(values.begin(), values.end(), 0);
+
+                TimeWatch timeWatch;
+                timeWatch.Begin();
+                sorter.Sort(keys, values, threadPool);
+                radixMs = std::min(radixMs, timeWatch.Elapsed<MillisecondsF32>().count());
+
+                for (uint32_t i = 0; i < NumKeys; ++i)
+                    pairs[i] = std::make_pair(srcKeys[i], i);
+
+                timeWatch.Begin();
+                std::ranges::sort(pairs, {}, &std::pair<uint64_t, uint32_t>::first);
+                stdMs = std::min(stdMs, timeWatch.Elapsed<MillisecondsF32>().count());
+            }
+
+            NEB_LOG_INFO("RadixSort -> {} {} keys on {} threads: radix sort {:.2f}ms ({:.1f} M keys/s, {} passes skipped), std::sort {:.2f}ms",
+                NumKeys,
+                name,
+                threadPool.GetNumThreads(),
+                radixMs,
+                NumKeys / (std::max(radixMs, 0.001f) * 1000.0f),
+                sorter.GetNumSkippedPasses(),
+                stdMs);
+        }
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,109 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/RenderGraph.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+#include <span>
+
+namespace Neb::bench
+{
+
+    namespace
+    {
+        // Passes read a few resources written not long before them and accumulate into one of their own, like passes of a frame do
+        void BuildFrameLikeRenderGraph(RenderGraph& graph, uint32_t numPasses, std::mt19937_64& random)
+        {
+            static constexpr auto ReadStates = std::to_array<RenderGraphStates>({
+                eRenderGraphState_NonPixelShaderResource,
+                eRenderGraphState_PixelShaderResource,
+                eRenderGraphState_DepthRead,
+                eRenderGraphState_CopySource,
+            });
+            static constexpr auto WriteStates = std::to_array<RenderGraphStates>({
+                eRenderGraphState_RenderTarget,
+                eRenderGraphState_UnorderedAccess,
+                eRenderGraphState_DepthWrite,
+            });
+
+            graph.Reset();
+            const uint32_t numResources = std::max(8u, numPasses / 4);
+            for (uint32_t i = 0; i < numResources; ++i)
+                graph.AddResource(eRenderGraphState_Common, eRenderGraphState_Common, (i % 8 == 0) ? eRenderGraphResourceFlag_External : eRenderGraphResourceFlag_None);
+
+            std::array<RenderGraphAccess, 6> accesses;
+            for (uint32_t pass = 0; pass < numPasses; ++pass)
+            {
+                // Newest resource of a window sliding over them is accumulated into, older ones of the window are read
+                const uint32_t windowFirst = std::min(pass / 4, numResources - 8);
+                accesses[0] = RenderGraphAccess{ .Resource = windowFirst + 7, .State = WriteStates[random() % WriteStates.size()], .Type = eRenderGraphAccess_ReadWrite };
+
+                const uint32_t numReads = 1 + uint32_t(random() % (accesses.size() - 1));
+                uint32_t count = 1;
+                for (uint32_t i = 0; i < numReads; ++i)
+                {
+                    const uint32_t resource = windowFirst + uint32_t(random() % 7);
+                    if (std::ranges::any_of(std::span(accesses).first(count), [resource](const RenderGraphAccess& a) { return a.Resource == resource; }))
+                        continue;
+
+                    accesses[count++] = RenderGraphAccess{ .Resource = resource, .State = ReadStates[random() % ReadStates.size()], .Type = eRenderGraphAccess_Read };
+                }
+                graph.AddPass(std::span(accesses).first(count));
+            }
+        }
+    } // anonymous namespace
+
+    // Build and compile times of a 500 pass graph, rebuilt every run as DeferredRenderer does every frame (average of 100 runs),
+    // in the order passes were added and reordered by levels. Transitions are compared against passes that bring every resource
+    // they touch back to Common after themselves
+    NEB_BENCH(RenderGraph)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumPasses = 500;
+        static constexpr uint32_t NumRuns = 100;
+
+        RenderGraph graph;
+        for (const RenderGraphCompileOptions& options : { RenderGraphCompileOptions(), RenderGraphCompileOptions{ .ReorderPasses = true } })
+        {
+            std::mt19937_64 random(0x26A);
+            float buildMs = 0.0f;
+            float compileMs = 0.0f;
+            for (uint32_t run = 0; run < NumRuns; ++run)
+            {
+                TimeWatch timeWatch;
+                timeWatch.Begin();
+                BuildFrameLikeRenderGraph(graph, NumPasses, random);
+                buildMs += timeWatch.Elapsed<MillisecondsF32>().count();
+
+                timeWatch.Begin();
+                graph.Compile(options);
+                compileMs += timeWatch.Elapsed<MillisecondsF32>().count();
+            }
+
+            uint32_t numRoundTrips = 0;
+            for (uint32_t pass : graph.GetExecutionOrder())
+                numRoundTrips += 2 * static_cast<uint32_t>(graph.GetAccesses(pass).size());
+
+            const RenderGraphStats& stats = graph.GetStats();
+            NEB_LOG_INFO("RenderGraph -> {} passes ({} culled, {} levels), reorder {}: built in {:.3f}ms, compiled in {:.3f}ms. "
+                "{} transitions ({} skipped) and {} UAV barriers in {} batches, round trips through Common would take {} transitions",
+                stats.NumPasses,
+                stats.NumCulledPasses,
+                stats.NumLevels,
+                options.ReorderPasses,
+                buildMs / NumRuns,
+                compileMs / NumRuns,
+                stats.NumTransitions,
+                stats.NumSkippedTransitions,
+                stats.NumUnorderedAccessBarriers,
+                stats.NumBarrierBatches,
+                numRoundTrips);
+        }
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,82 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/SceneGraph.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <numbers>
+#include <random>
+
+namespace Neb::bench
+{
+
+    // Full update of 1M nodes of a random hierarchy, then incremental updates with 1% of nodes changed, serial and on the shared pool
+    NEB_BENCH(SceneGraph)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumNodes = 1'000'000;
+        static constexpr uint32_t NumDirtyNodes = NumNodes / 100;
+
+        std::mt19937_64 random(0x5CE9E);
+        std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+        auto generateTransform = [&]()
+            {
+                return SceneNodeTransform{
+                    .Translation = Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random)) * 10.0f,
+                    .Rotation = Quaternion::CreateFromAxisAngle(Vec3::UnitY, unitDistribution(random) * std::numbers::pi_v<float>),
+                    .Scale = Vec3(1.0f + 0.1f * unitDistribution(random)),
+                };
+            };
+
+        // Each node is a child of the last node or of one of its close ancestors, the same shape as nested glTF hierarchies
+        SceneGraph graph;
+        graph.Reserve(NumNodes);
+        uint32_t lastNode = SceneGraphInvalidNode;
+        for (uint32_t i = 0; i < NumNodes; ++i)
+        {
+            uint32_t parentIndex = lastNode;
+            const uint32_t numLevelsUp = static_cast<uint32_t>(random() % 4);
+            for (uint32_t level = 0; level < numLevelsUp && parentIndex != SceneGraphInvalidNode; ++level)
+                parentIndex = graph.GetParent(parentIndex);
+
+            lastNode = graph.AddNode(parentIndex, generateTransform());
+        }
+
+        auto dirtyRandomNodes = [&]()
+            {
+                for (uint32_t i = 0; i < NumDirtyNodes; ++i)
+                    graph.SetLocalTransform(static_cast<uint32_t>(random() % NumNodes), generateTransform());
+            };
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        graph.UpdateWorldMatrices();
+        const float fullMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        dirtyRandomNodes();
+        timeWatch.Begin();
+        const uint32_t numSerialNodes = graph.UpdateWorldMatrices();
+        const float serialMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        dirtyRandomNodes();
+        timeWatch.Begin();
+        const uint32_t numParallelNodes = graph.UpdateWorldMatricesParallel(threadPool);
+        const float parallelMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        NEB_LOG_INFO("SceneGraph -> {} nodes, full update {:.2f}ms. {} dirty nodes: serial {:.2f}ms ({} recomputed), {} threads {:.2f}ms ({} recomputed)",
+            NumNodes,
+            fullMs,
+            NumDirtyNodes,
+            serialMs,
+            numSerialNodes,
+            threadPool.GetNumThreads(),
+            parallelMs,
+            numParallelNodes);
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,111 @@
+#include "Bench.h"
+#include "BenchScene.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/GLTFSceneImporter.h"
+#include "core/SceneLoader.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace Neb::bench
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumWarmImports = 3;
+
+        std::filesystem::path GetImportBenchScene(const BenchContext& context, EGLTFType type = EGLTFType::AsciiFile)
+        {
+            if (!context.ScenePath.empty())
+                return context.ScenePath;
+
+            return WriteBenchScene(context.WorkingDirectory, BenchSceneDesc{ .NumMeshes = 64, .NumNodes = 1024, .NumGridVertices = 128, .NumTextures = 32, .TextureSize = 1024 }, type);
+        }
+
+        EGLTFType GetGLTFType(const std::filesystem::path& filepath)
+        {
+            return filepath.extension() == ".glb" ? EGLTFType::Binary : EGLTFType::AsciiFile;
+        }
+    } // anonymous namespace
+
+    // Cold import bakes the scene cache, warm imports that follow only map it. The generated scene is also imported cold from .glb,
+    // whose submesh streams stay views into its memory-mapped BIN chunk instead of being copied like the ones of .gltf
+    NEB_BENCH_DEVICE(SceneCacheColdWarm)
+    {
+        const std::filesystem::path filepath = GetImportBenchScene(context);
+
+        const BenchImport cold = ImportBenchScene(filepath, /*isCold*/ true);
+        NEB_LOG_INFO("SceneCacheColdWarm -> cold '{}': {:.1f}ms, copied {:.1f} MB, peak working set {:.1f} MB",
+            filepath.filename().string(), cold.Stats.Milliseconds, ToMegabytes(cold.Stats.NumCopiedBytes), ToMegabytes(cold.PeakWorkingSetBytes));
+
+        if (context.ScenePath.empty())
+        {
+            const std::filesystem::path binaryFilepath = GetImportBenchScene(context, EGLTFType::Binary);
+            const BenchImport binaryCold = ImportBenchScene(binaryFilepath, /*isCold*/ true);
+            NEB_LOG_INFO("SceneCacheColdWarm -> cold '{}': {:.1f}ms, copied {:.1f} MB, peak working set {:.1f} MB",
+                binaryFilepath.filename().string(), binaryCold.Stats.Milliseconds, ToMegabytes(binaryCold.Stats.NumCopiedBytes), ToMegabytes(binaryCold.PeakWorkingSetBytes));
+        }
+
+        float minWarmMilliseconds = FLT_MAX;
+        for (uint32_t i = 0; i < NumWarmImports; ++i)
+        {
+            const BenchImport warm = ImportBenchScene(filepath, /*isCold*/ false);
+            if (!warm.Stats.IsWarm)
+                throw std::runtime_error("Scene cache was not used by the warm import");
+
+            minWarmMilliseconds = std::min(minWarmMilliseconds, warm.Stats.Milliseconds);
+            NEB_LOG_INFO("SceneCacheColdWarm -> warm #{}: {:.1f}ms, mapped {:.1f} MB, copied {:.1f} MB, peak working set {:.1f} MB",
+                i, warm.Stats.Milliseconds, ToMegabytes(warm.Stats.NumMappedBytes), ToMegabytes(warm.Stats.NumCopiedBytes), ToMegabytes(warm.PeakWorkingSetBytes));
+        }
+
+        NEB_LOG_INFO("SceneCacheColdWarm -> warm import is {:.1f}x faster than the cold one", cold.Stats.Milliseconds / minWarmMilliseconds);
+    }
+
+    // SceneLoader without a window or a renderer. The calling thread stands for the render thread and polls the loader once per tick,
+    // the way Nebulae::Render() does, so that both the load time and the longest tick the render thread saw are reported
+    NEB_BENCH_DEVICE(SceneLoaderHeadless)
+    {
+        const std::filesystem::path filepath = GetImportBenchScene(context);
+
+        SceneLoader loader;
+        TimeWatch loadWatch;
+        loadWatch.Begin();
+        loader.RequestLoad(filepath, GetGLTFType(filepath));
+
+        Scoped<LoadedScene> loadedScene;
+        uint32_t numTicks = 0;
+        float maxTickMilliseconds = 0.0f;
+        while (!loadedScene.IsValid() && loader.IsLoading())
+        {
+            TimeWatch tickWatch;
+            tickWatch.Begin();
+            loadedScene = loader.TakeLoaded();
+            maxTickMilliseconds = std::max(maxTickMilliseconds, tickWatch.Elapsed<MillisecondsF32>().count());
+            ++numTicks;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Scene might have been published after the last tick
+        if (!loadedScene.IsValid())
+            loadedScene = loader.TakeLoaded();
+        if (!loadedScene.IsValid())
+            throw std::runtime_error("SceneLoader failed to load " + filepath.string());
+
+        NEB_LOG_INFO("SceneLoaderHeadless -> '{}' loaded in {:.1f}ms ({:.1f}ms on the loader thread, {} import), {} ticks, longest tick {:.3f}ms",
+            filepath.filename().string(),
+            loadWatch.Elapsed<MillisecondsF32>().count(),
+            loadedScene->LoadMilliseconds,
+            loadedScene->Importer->GetImportStats().IsWarm ? "warm" : "cold",
+            numTicks,
+            maxTickMilliseconds);
+    }
+
+} // Neb::bench namespace
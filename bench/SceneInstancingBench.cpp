@@ -0,0 +1,39 @@
+#include "Bench.h"
+#include "BenchScene.h"
+
+#include "common/Log.h"
+
+namespace Neb::bench
+{
+
+    // 10k nodes of a single mesh are imported as a single mesh with 10k instances. Same nodes with a mesh of their own each
+    // are what every node costs when nothing is instanced, both are imported cold and warm
+    NEB_BENCH_DEVICE(SceneInstancing)
+    {
+        static constexpr uint32_t NumNodes = 10'000;
+
+        const std::pair<const char*, BenchSceneDesc> scenes[] = {
+            { "instanced", BenchSceneDesc{ .NumMeshes = 1, .NumNodes = NumNodes, .NumGridVertices = 32 } },
+            { "unique", BenchSceneDesc{ .NumMeshes = NumNodes, .NumNodes = NumNodes, .NumGridVertices = 32 } },
+        };
+
+        for (const auto& [name, desc] : scenes)
+        {
+            const std::filesystem::path filepath = WriteBenchScene(context.WorkingDirectory, desc);
+            for (bool isCold : { true, false })
+            {
+                const BenchImport import = ImportBenchScene(filepath, isCold);
+                NEB_LOG_INFO("SceneInstancing -> {} meshes ({}), {} import: {} meshes, {} instances in {:.1f}ms, copied {:.1f} MB, peak working set {:.1f} MB",
+                    desc.NumMeshes,
+                    name,
+                    import.Stats.IsWarm ? "warm" : "cold",
+                    import.NumMeshes,
+                    import.NumInstances,
+                    import.Stats.Milliseconds,
+                    ToMegabytes(import.Stats.NumCopiedBytes),
+                    ToMegabytes(import.PeakWorkingSetBytes));
+            }
+        }
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,77 @@
+#include "Bench.h"
+#include "BenchTextures.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/TextureCompression.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // 16 images of 1024x1024 in every format and quality on the shared pool, with PSNR of the result against the source
+    NEB_BENCH(TextureCompression)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumImages = 16;
+        static constexpr uint32_t ImageSize = 1024;
+        static constexpr const char* FormatNames[eTextureBlockFormat_NumFormats] = { "BC1", "BC4", "BC5", "BC7" };
+        static constexpr const char* QualityNames[eTextureCompressionQuality_NumQualities] = { "fast", "normal", "high" };
+
+        std::vector<std::vector<std::byte>> texels(NumImages);
+        std::vector<TextureLevelDesc> levels(NumImages);
+        for (uint32_t i = 0; i < NumImages; ++i)
+        {
+            texels[i] = MakeBenchTexels(ImageSize, ImageSize, i);
+            levels[i] = TextureLevelDesc{ .Width = ImageSize, .Height = ImageSize, .Texels = texels[i].data() };
+        }
+        const uint64_t numSourceTexels = uint64_t(NumImages) * ImageSize * ImageSize;
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        for (uint32_t format = 0; format < eTextureBlockFormat_NumFormats; ++format)
+        {
+            std::vector<TextureCompressionSourceDesc> srcs(NumImages);
+            for (uint32_t i = 0; i < NumImages; ++i)
+                srcs[i] = TextureCompressionSourceDesc{ .Format = ETextureBlockFormat(format), .Levels = { &levels[i], 1 } };
+
+            for (uint32_t quality = 0; quality < eTextureCompressionQuality_NumQualities; ++quality)
+            {
+                std::vector<CompressedTexture> compressed(NumImages);
+
+                TimeWatch timeWatch;
+                timeWatch.Begin();
+                CompressTextures(compressed, srcs, ETextureCompressionQuality(quality), threadPool);
+                const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+                // Overall PSNR is computed from the summed squared errors of every image
+                double sumSquaredErrors = 0.0;
+                uint32_t maxError = 0;
+                for (uint32_t i = 0; i < NumImages; ++i)
+                {
+                    const TextureCompressionError error = MeasureTextureCompressionError(compressed[i], srcs[i]);
+                    if (std::isfinite(error.Psnr))
+                        sumSquaredErrors += double(error.NumTexels) * 255.0 * 255.0 / std::pow(10.0, error.Psnr / 10.0);
+                    maxError = std::max(maxError, error.MaxError);
+                }
+                const double meanSquaredError = sumSquaredErrors / double(numSourceTexels);
+
+                NEB_LOG_INFO("TextureCompression -> {} {}: {:.1f} source megapixels on {} threads in {:.1f}ms ({:.1f} MP/s), PSNR {:.2f} dB, max error {} codes",
+                    FormatNames[format],
+                    QualityNames[quality],
+                    numSourceTexels / 1e6f,
+                    threadPool.GetNumThreads(),
+                    elapsedMs,
+                    numSourceTexels / (std::max(elapsedMs, 0.001f) * 1000.0f),
+                    (meanSquaredError > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / meanSquaredError) : INFINITY,
+                    maxError);
+            }
+        }
+    }
+
+} // Neb::bench namespace
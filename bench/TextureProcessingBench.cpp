@@ -0,0 +1,56 @@
+#include "Bench.h"
+#include "BenchTextures.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/TextureProcessing.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Full chains of 16 color images of 1024x1024 on the shared pool, and the double precision reference of the same chains
+    NEB_BENCH(MipChains)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumImages = 16;
+        static constexpr uint32_t ImageSize = 1024;
+
+        std::vector<std::vector<std::byte>> texels(NumImages);
+        std::vector<TextureSourceDesc> srcs(NumImages);
+        for (uint32_t i = 0; i < NumImages; ++i)
+        {
+            texels[i] = MakeBenchTexels(ImageSize, ImageSize, i);
+            srcs[i] = TextureSourceDesc{ .Width = ImageSize, .Height = ImageSize, .Texels = texels[i].data(), .Content = eTextureContent_Color };
+        }
+        const uint64_t numSourceTexels = uint64_t(NumImages) * ImageSize * ImageSize;
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        std::vector<TextureMipChain> chains(NumImages);
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        GenerateMipChains(chains, srcs, threadPool);
+        const float parallelMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        timeWatch.Begin();
+        uint32_t maxError = 0;
+        for (uint32_t i = 0; i < NumImages; ++i)
+            maxError = std::max(maxError, MeasureMipChainError(chains[i], srcs[i]).MaxError);
+        const float referenceMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        NEB_LOG_INFO("MipChains -> {:.1f} source megapixels: {} threads {:.1f}ms ({:.1f} MP/s), reference filter {:.1f}ms, max error {} codes",
+            numSourceTexels / 1e6f,
+            threadPool.GetNumThreads(),
+            parallelMs,
+            numSourceTexels / (std::max(parallelMs, 0.001f) * 1000.0f),
+            referenceMs,
+            maxError);
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,85 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/TransientAliasing.h"
+#include "util/Memory.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <random>
+
+namespace Neb::bench
+{
+
+    namespace
+    {
+        // Render targets of a frame: mostly short lived ones of the resolution of the frame or its fractions, some live longer
+        void AddRandomTransientResources(TransientAliasingPlanner& planner, uint32_t numResources, uint32_t numPasses, uint32_t numHeapGroups, std::mt19937_64& random)
+        {
+            static constexpr uint64_t TextureAlignment = 64 * 1024;
+            static constexpr std::array<uint64_t, 5> BytesPerPixel = { 2, 4, 4, 8, 16 };
+            static constexpr std::array<uint64_t, 3> ResolutionDivisors = { 1, 2, 4 };
+
+            planner.Reset();
+            for (uint32_t i = 0; i < numResources; ++i)
+            {
+                const uint32_t firstPass = random() % numPasses;
+                const uint32_t maxLength = (random() % 8 == 0) ? numPasses : 4;
+                const uint32_t lastPass = std::min(numPasses - 1, firstPass + static_cast<uint32_t>(random() % maxLength));
+                const uint64_t divisor = ResolutionDivisors[random() % ResolutionDivisors.size()];
+                const uint64_t size = (1920 / divisor) * (1080 / divisor) * BytesPerPixel[random() % BytesPerPixel.size()];
+                planner.AddResource(TransientResourceDesc{
+                    .FirstPass = firstPass,
+                    .LastPass = lastPass,
+                    .Size = AlignUp(size, TextureAlignment),
+                    .Alignment = TextureAlignment,
+                    .HeapGroup = static_cast<uint32_t>(random() % numHeapGroups),
+                });
+            }
+        }
+    } // anonymous namespace
+
+    // Plan times of 256 transient resources over 64 passes (average of 100 runs), in one heap group and in two as on resource heap tier 1.
+    // Memory of heaps is compared against the peak of live resources and against allocating every resource separately
+    NEB_BENCH(TransientAliasing)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumResources = 256;
+        static constexpr uint32_t NumPasses = NumResources / 4;
+        static constexpr uint32_t NumRuns = 100;
+        static constexpr float MiB = 1024.0f * 1024.0f;
+
+        TransientAliasingPlanner planner;
+        for (uint32_t numHeapGroups : { 1u, 2u })
+        {
+            std::mt19937_64 random(0x7A5);
+            float planMs = 0.0f;
+            for (uint32_t run = 0; run < NumRuns; ++run)
+            {
+                AddRandomTransientResources(planner, NumResources, NumPasses, numHeapGroups, random);
+
+                TimeWatch timeWatch;
+                timeWatch.Begin();
+                planner.Plan();
+                planMs += timeWatch.Elapsed<MillisecondsF32>().count();
+            }
+
+            const TransientAliasingStats& stats = planner.GetStats();
+            NEB_LOG_INFO("TransientAliasing -> {} resources over {} passes in {} heap groups: planned in {:.3f}ms. "
+                "Heaps take {:.1f}MB, peak is {:.1f}MB, separate allocations would take {:.1f}MB ({:.1f}x), {} aliasing barriers",
+                stats.NumResources,
+                NumPasses,
+                numHeapGroups,
+                planMs / NumRuns,
+                stats.HeapBytes / MiB,
+                stats.PeakBytes / MiB,
+                stats.NaiveBytes / MiB,
+                stats.HeapBytes ? stats.NaiveBytes / float(stats.HeapBytes) : 0.0f,
+                stats.NumAliasingBarriers);
+        }
+    }
+
+} // Neb::bench namespace
@@ -0,0 +1,87 @@
+#include "Bench.h"
+
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/UploadPlanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace Neb::bench
+{
+
+    // Plans of a scene-sized batch (4096 textures of 11 mips and 4096 buffers) in chunks of 16 MB, as UploadService plans them
+    // with the default ring of 64 MB. Chunks of the plans are then run through the staging ring, completion lags 3 submissions behind
+    NEB_BENCH(UploadPlanner)
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t NumTextures = 4096;
+        static constexpr uint32_t NumBuffers = 4096;
+        static constexpr uint32_t NumMips = 11;
+        static constexpr uint32_t NumRuns = 16;
+        static constexpr uint64_t RingCapacity = 64 * 1024 * 1024;
+        static constexpr uint64_t ChunkSize = RingCapacity / 4;
+        static constexpr uint64_t NumLaggingSubmissions = 3;
+
+        std::mt19937_64 random(0);
+        std::vector<UploadRequestDesc> requests;
+        for (uint32_t i = 0; i < NumTextures; ++i)
+        {
+            // BC7 mips of 1024x1024, rows of blocks are 256 byte aligned
+            for (uint32_t mip = 0; mip < NumMips; ++mip)
+            {
+                const uint64_t numBlocks = std::max<uint64_t>((1024 >> mip) / 4, 1);
+                const uint64_t rowPitch = std::max<uint64_t>(numBlocks * 16, 256);
+                requests.push_back(UploadRequestDesc{ .NumBytes = rowPitch * numBlocks, .Alignment = 512, .SplitGranularity = rowPitch });
+            }
+        }
+        for (uint32_t i = 0; i < NumBuffers; ++i)
+            requests.push_back(UploadRequestDesc{ .NumBytes = 1 + random() % (256 * 1024), .Alignment = 1, .SplitGranularity = 1 });
+
+        UploadPlan plan;
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        for (uint32_t i = 0; i < NumRuns; ++i)
+            PlanUploads(plan, requests, ChunkSize);
+        const float planMs = timeWatch.Elapsed<MillisecondsF32>().count() / NumRuns;
+
+        uint64_t numBytes = 0;
+        for (const UploadChunk& chunk : plan.Chunks)
+            numBytes += chunk.NumBytes;
+
+        // Chunks of a single submission each, the ring waits the same way UploadService does
+        StagingRing ring(RingCapacity);
+        uint64_t fenceValue = 0;
+        uint32_t numWaits = 0;
+        timeWatch.Begin();
+        for (uint32_t i = 0; i < NumRuns; ++i)
+        {
+            for (const UploadChunk& chunk : plan.Chunks)
+            {
+                ++fenceValue;
+                const uint64_t waitFenceValue = ring.GetFenceValueToAllocate(chunk.NumBytes, chunk.Alignment);
+                if (waitFenceValue == UINT64_MAX)
+                    continue;
+
+                numWaits += (waitFenceValue > 0) ? 1 : 0;
+                ring.Release(std::max(waitFenceValue, fenceValue > NumLaggingSubmissions ? fenceValue - NumLaggingSubmissions : 0));
+                ring.Allocate(chunk.NumBytes, chunk.Alignment, fenceValue);
+            }
+        }
+        const float ringMs = timeWatch.Elapsed<MillisecondsF32>().count() / NumRuns;
+
+        NEB_LOG_INFO("UploadPlanner -> {} requests ({:.1f} MB) in {} chunks of {} pieces: plan {:.3f}ms ({:.1f} M requests/s), staging ring {:.3f}ms per plan, {} waits",
+            requests.size(),
+            ToMegabytes(numBytes),
+            plan.Chunks.size(),
+            plan.Pieces.size(),
+            planMs,
+            requests.size() / (std::max(planMs, 0.001f) * 1000.0f),
+            ringMs,
+            numWaits);
+    }
+
+} // Neb::bench namespace
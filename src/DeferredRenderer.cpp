@@ -1,7 +1,10 @@
 #include "DeferredRenderer.h"
 
 #include "Nebulae.h" // TODO: Needed for assets directory, should be removed
+#include "common/Configuration.h"
 #include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "core/Bounds.h"
 #include "core/Math.h"
 #include "nri/Device.h"
 #include "nri/DescriptorHeap.h"
@@ -9,12 +12,16 @@
 #include "nri/imgui/UiContext.h"
 #include "nri/PIXRuntime.h"
 #include "util/Memory.h"
+#include "util/ThreadPool.h"
 #include "input/InputManager.h"
 
 #include "DXRHelper/nv_helpers_dx12/RaytracingPipelineGenerator.h"
 
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <array>
+#include <numeric>
 #include <vector>
 
 // Helper to compute aligned buffer sizes
@@ -23,19 +30,42 @@
 namespace Neb
 {
 
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+    } // anonymous namespace
+
+    // Frame graph barriers are passed to D3D12 as they are
+    static_assert(eRenderGraphState_Common == D3D12_RESOURCE_STATE_COMMON);
+    static_assert(eRenderGraphState_VertexAndConstantBuffer == D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+    static_assert(eRenderGraphState_IndexBuffer == D3D12_RESOURCE_STATE_INDEX_BUFFER);
+    static_assert(eRenderGraphState_RenderTarget == D3D12_RESOURCE_STATE_RENDER_TARGET);
+    static_assert(eRenderGraphState_UnorderedAccess == D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    static_assert(eRenderGraphState_DepthWrite == D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    static_assert(eRenderGraphState_DepthRead == D3D12_RESOURCE_STATE_DEPTH_READ);
+    static_assert(eRenderGraphState_NonPixelShaderResource == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    static_assert(eRenderGraphState_PixelShaderResource == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    static_assert(eRenderGraphState_IndirectArgument == D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    static_assert(eRenderGraphState_CopyDest == D3D12_RESOURCE_STATE_COPY_DEST);
+    static_assert(eRenderGraphState_CopySource == D3D12_RESOURCE_STATE_COPY_SOURCE);
+
     bool DeferredRenderer::Init(UINT width, UINT height, nri::Swapchain* swapchain)
     {   
         m_width = width;
         m_height = height;
         m_swapchain = swapchain;
 
-        InitGbuffers();
+        InitTransientTargets();
         InitGbufferHeaps();
         InitGbufferDepthStencilBuffer();
         InitGbufferDepthStencilSrv();
         InitGbufferShadersAndRootSignatures();
         InitGbufferPipelineState();
-        InitGbufferInstanceCb();
+        m_frameUploadAllocator.Init();
+
+        // Occluders are only there if importer built them
+        m_gbufferOcclusionCulling = Config::GetValue<bool>(EConfigKey::OcclusionCulling, false);
+        m_gbufferOccluder.Init(OcclusionCullerDesc());
 
         InitPBRConstantBuffers();
         InitPBRShadersAndRootSignature();
@@ -48,11 +78,12 @@ namespace Neb
         InitPathtracerPipeline();
         InitPathtracerSBT();
         InitPathtracerConstantBuffers();
-        InitPathtracerNRCQueryDebugResources(width, height);
+        InitPathtracerNRCQueryDebugResources();
 
         InitRadianceResolveShadersAndPSO();
 
         nri::ThrowIfFalse(m_svgfDenoiser.Init(width, height));
+        m_svgfDenoiser.SetTransientVariance(m_svgfVariance.Get());
         return true;
     }
 
@@ -66,11 +97,12 @@ namespace Neb
         m_height = height;
 
         nri::ThrowIfFalse(m_svgfDenoiser.Resize(width, height));
-        InitGbuffers();
+        InitTransientTargets();
+        m_svgfDenoiser.SetTransientVariance(m_svgfVariance.Get());
         InitGbufferHeaps();
         InitGbufferDepthStencilSrv();
 
-        InitPathtracerNRCQueryDebugResources(width, height);
+        InitPathtracerNRCQueryDebugResources();
 
         if (nri::NvRtxgiNRCIntegration::Get()->IsInitialised())
         {
@@ -92,13 +124,14 @@ namespace Neb
         
         m_frameIndex = info.frameIndex;
         m_renderInfo = info;
+        m_frameUploadAllocator.BeginFrame();
 
         if (m_scene != info.scene)
         {
             // scene update
             m_scene = info.scene;
             m_needsASUpdate = true;
-            InitPathtracerScene(info.scene);
+            InitPathtracerScene(info.scene, info.giScene);
         }
 
         nrc::ContextSettings nrcContextSettings = nrc::ContextSettings();
@@ -145,7 +178,153 @@ namespace Neb
             m_resetHistory = true;
         }
         const float aspectRatio = m_width / static_cast<float>(m_height);
-        m_proj = Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), aspectRatio, 0.1f, 100.0f);
+        m_proj = Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), aspectRatio, ProjectionNearZ, ProjectionFarZ);
+
+        // After the camera, SVGF is skipped while it moves
+        BuildFrameGraph();
+    }
+
+    void DeferredRenderer::BuildFrameGraph()
+    {
+        RenderGraph& graph = m_frameGraph;
+        graph.Reset();
+        m_frameGraphResources.clear();
+        auto addResource = [this, &graph](ID3D12Resource* resource, ERenderGraphResourceFlags flags)
+            {
+                m_frameGraphResources.push_back(resource);
+                return graph.AddResource(eRenderGraphState_Common, eRenderGraphState_Common, flags);
+            };
+
+        // Normals, depth, radiance and moments are history of SVGF the next frame. Bindless buffers of the path tracer are not tracked,
+        // buffers are promoted from COMMON on their first use and decay back to it after every command list
+        SVGFDenoiser& svgf = m_svgfDenoiser;
+        const uint32_t albedo = addResource(GetGbufferAlbedo(), eRenderGraphResourceFlag_None);
+        const uint32_t roughnessMetalness = addResource(GetGbufferRoughnessMetalness(), eRenderGraphResourceFlag_None);
+        const uint32_t worldPos = addResource(GetGbufferWorldPos(), eRenderGraphResourceFlag_None);
+        const uint32_t normals = addResource(svgf.GetNormalArray(), eRenderGraphResourceFlag_External);
+        const uint32_t depth = addResource(svgf.GetDepthArray(), eRenderGraphResourceFlag_External);
+        const uint32_t radiance = addResource(GetRadianceOutput(), eRenderGraphResourceFlag_External);
+        const uint32_t radianceHistory = addResource(svgf.GetHistoryRadianceTexture(), eRenderGraphResourceFlag_None);
+        const uint32_t moments = addResource(svgf.GetCurrentMomentsTexture(), eRenderGraphResourceFlag_External);
+        const uint32_t momentsHistory = addResource(svgf.GetHistoryMomentsTexture(), eRenderGraphResourceFlag_None);
+        const uint32_t variance = addResource(svgf.GetVarianceTexture(), eRenderGraphResourceFlag_None);
+        const uint32_t backbuffer = addResource(m_swapchain->GetCurrentBackbuffer(), eRenderGraphResourceFlag_External);
+        const uint32_t nrcQueryThroughput = addResource(m_NRCDebugQueryThroughputMap.Get(), eRenderGraphResourceFlag_None);
+        const uint32_t nrcQueryHit = addResource(m_NRCDebugQueryHitMap.Get(), eRenderGraphResourceFlag_None);
+
+        // Lighting and path tracing read every G-buffer from compute and ray generation shaders
+        auto withGbufferReads = [&](const auto&... accesses)
+            {
+                return std::to_array<RenderGraphAccess>({
+                    { albedo, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { roughnessMetalness, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { worldPos, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { normals, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { depth, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    accesses...,
+                });
+            };
+
+        m_framePasses.fill(RenderGraph::InvalidIndex);
+        m_framePasses[FRAME_PASS_GBUFFER] = graph.AddPass(std::to_array<RenderGraphAccess>({
+            { albedo, eRenderGraphState_RenderTarget, eRenderGraphAccess_Write },
+            { roughnessMetalness, eRenderGraphState_RenderTarget, eRenderGraphAccess_Write },
+            { worldPos, eRenderGraphState_RenderTarget, eRenderGraphAccess_Write },
+            { normals, eRenderGraphState_RenderTarget, eRenderGraphAccess_Write },
+            { depth, eRenderGraphState_DepthWrite, eRenderGraphAccess_Write },
+        }));
+        m_framePasses[FRAME_PASS_PBR_LIGHTING] = graph.AddPass(withGbufferReads(
+            RenderGraphAccess{ radiance, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_Write }));
+
+        // NRC resolve accumulates into the lighting result, NRC trains its own buffers. Debug maps of NRC queries are only looked at in captures
+        m_framePasses[FRAME_PASS_GI_PATHTRACE] = graph.AddPass(withGbufferReads(
+            RenderGraphAccess{ radiance, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_ReadWrite },
+            RenderGraphAccess{ nrcQueryThroughput, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_Write },
+            RenderGraphAccess{ nrcQueryHit, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_Write }),
+            eRenderGraphPassFlag_SideEffects);
+
+        if (!m_dynamicSceneThisFrame)
+        {
+            // Once the camera stopped, history of SVGF starts over from the current radiance
+            if (m_resetHistory)
+            {
+                m_framePasses[FRAME_PASS_SVGF_RESET_HISTORY] = graph.AddPass(std::to_array<RenderGraphAccess>({
+                    { radiance, eRenderGraphState_CopySource, eRenderGraphAccess_Read },
+                    { radianceHistory, eRenderGraphState_CopyDest, eRenderGraphAccess_Write },
+                }));
+            }
+
+            m_framePasses[FRAME_PASS_SVGF_TEMPORAL_ACCUMULATION] = graph.AddPass(std::to_array<RenderGraphAccess>({
+                { radiance, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_ReadWrite },
+                { radianceHistory, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                { moments, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_Write },
+                { momentsHistory, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                { variance, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_Write },
+                { normals, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                { depth, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+            }));
+
+            // A-Trous passes ping-pong between both radiance textures, the last one writes the current radiance
+            for (uint32_t pass = 0; pass < SVGFDenoiser::NumAtrousPasses; ++pass)
+            {
+                const bool readsCurrent = svgf.GetATrousInputIndex(pass) == svgf.GetCurrentResourceIndex();
+                m_framePasses[FRAME_PASS_SVGF_ATROUS_WAVELET + pass] = graph.AddPass(std::to_array<RenderGraphAccess>({
+                    { readsCurrent ? radiance : radianceHistory, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { variance, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { normals, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { depth, eRenderGraphState_NonPixelShaderResource, eRenderGraphAccess_Read },
+                    { readsCurrent ? radianceHistory : radiance, eRenderGraphState_UnorderedAccess, eRenderGraphAccess_Write },
+                }));
+            }
+        }
+
+        m_framePasses[FRAME_PASS_HDR_TONEMAPPING] = graph.AddPass(std::to_array<RenderGraphAccess>({
+            { radiance, eRenderGraphState_PixelShaderResource, eRenderGraphAccess_Read },
+            { backbuffer, eRenderGraphState_RenderTarget, eRenderGraphAccess_Write },
+        }));
+
+        graph.Compile(RenderGraphCompileOptions());
+    }
+
+    void DeferredRenderer::BeginFramePass(ID3D12GraphicsCommandList4* commandList, EFramePass pass)
+    {
+        NEB_ASSERT(m_framePasses[pass] != RenderGraph::InvalidIndex && !m_frameGraph.IsPassCulled(m_framePasses[pass]), "Pass {} is not executed this frame", int32_t(pass));
+        SubmitFrameGraphBarriers(commandList, m_frameGraph.GetPassPosition(m_framePasses[pass]), m_transientPlanner.GetAliasingBarriers(pass));
+    }
+
+    void DeferredRenderer::EndFramePass(ID3D12GraphicsCommandList4* commandList, EFramePass pass)
+    {
+        const uint32_t position = m_frameGraph.GetPassPosition(m_framePasses[pass]);
+        if (position + 1 == m_frameGraph.GetNumExecutedPasses())
+            SubmitFrameGraphBarriers(commandList, position + 1);
+    }
+
+    void DeferredRenderer::SubmitFrameGraphBarriers(ID3D12GraphicsCommandList4* commandList, uint32_t position, std::span<const TransientAliasingBarrier> aliasingBarriers)
+    {
+        std::vector<D3D12_RESOURCE_BARRIER>& barriers = m_frameGraphBarriers;
+        barriers.clear();
+
+        // Transient targets are activated before they are transitioned out of COMMON, where the previous frame left every one of them
+        for (const TransientAliasingBarrier& barrier : aliasingBarriers)
+        {
+            ID3D12Resource* resourceBefore = (barrier.ResourceBefore != TransientAliasingPlanner::InvalidIndex) ? GetTransientTarget(ETransientTarget(barrier.ResourceBefore)) : nullptr;
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(resourceBefore, GetTransientTarget(ETransientTarget(barrier.ResourceAfter))));
+        }
+
+        for (const RenderGraphBarrier& barrier : m_frameGraph.GetBarriers(position))
+        {
+            ID3D12Resource* resource = m_frameGraphResources[barrier.Resource];
+            if (barrier.Type == eRenderGraphBarrier_UnorderedAccess)
+            {
+                barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+                continue;
+            }
+
+            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATES(barrier.StateBefore), D3D12_RESOURCE_STATES(barrier.StateAfter)));
+        }
+
+        if (!barriers.empty())
+            commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
     }
 
     void DeferredRenderer::EndFrame()
@@ -153,6 +332,7 @@ namespace Neb
         nri::EndEvent(nri::NRIDevice::Get().GetCommandQueue(nri::eCommandContextType_Graphics));
 
         m_svgfDenoiser.EndFrame();
+        m_frameUploadAllocator.EndFrame(nri::NRIDevice::Get().GetCommandQueue(nri::eCommandContextType_Graphics));
 
         // Explicitly end RTXGI frame context
         nri::NvRtxgiNRCIntegration::Get()->EndFrame(nri::NRIDevice::Get().GetCommandQueue(nri::eCommandContextType_Graphics));
@@ -243,6 +423,52 @@ namespace Neb
         }
         ImGui::End();
 
+        ImGui::Begin("G-buffer culling");
+        {
+            ImGui::Text("Visible draws: %u", m_gbufferCullingStats.NumVisible);
+            ImGui::Text("Culled draws: %u", m_gbufferCullingStats.NumCulled);
+            ImGui::Text("Culling time: %.3fms", m_gbufferCullingStats.Milliseconds);
+
+            if (Config::GetValue<bool>(EConfigKey::OcclusionCulling, false))
+            {
+                const OcclusionStats& occlusion = m_gbufferOcclusionStats;
+                ImGui::Separator();
+                ImGui::Checkbox("Occlusion culling", &m_gbufferOcclusionCulling);
+                ImGui::Text("Occluders: %u (%u / %u triangles)", occlusion.NumOccluders, occlusion.NumRasterized, occlusion.TriangleBudget);
+                ImGui::Text("Occluded draws: %u of %u", occlusion.NumOccluded, occlusion.NumTested);
+                ImGui::Text("Rasterization time: %.3fms", occlusion.RasterMilliseconds);
+                ImGui::Text("Testing time: %.3fms", occlusion.TestMilliseconds);
+                ImGui::Text("Total time: %.3fms (budget %.1fms)", m_gbufferOcclusionMilliseconds, m_gbufferOccluder.GetDesc().BudgetMilliseconds);
+            }
+
+            const nri::DrawRecordStats& record = m_gbufferRecordStats;
+            ImGui::Separator();
+            ImGui::Checkbox("Sort draws", &m_gbufferSortDraws);
+            ImGui::Text("Sorting time: %.3fms", m_gbufferSortMilliseconds);
+            ImGui::Text("Pipeline changes: %u", record.NumPipelineChanges);
+            ImGui::Text("Material changes: %u", record.NumMaterialChanges);
+            ImGui::Text("Vertex/index buffer changes: %u / %u", record.NumVertexBufferChanges, record.NumIndexBufferChanges);
+            ImGui::Text("Redundant changes skipped: %u", record.GetNumRedundantChanges());
+
+            const DrawBatchStats& batches = m_gbufferBatchStats;
+            ImGui::Separator();
+            ImGui::Checkbox("Instancing", &m_gbufferInstancing);
+            ImGui::Text("Draw calls: %u for %u draws", batches.NumBatches, batches.NumDraws);
+            ImGui::Text("Instanced draw calls: %u (largest of %u instances)", batches.NumInstancedBatches, batches.MaxBatchSize);
+
+            // Indirect path replaces everything above
+            const CullingStats& indirect = m_gbufferIndirectStats;
+            ImGui::Separator();
+            ImGui::Checkbox("ExecuteIndirect", &m_gbufferIndirect);
+            ImGui::Checkbox("Cull on GPU", &m_gbufferIndirectGpuCulling);
+            ImGui::Text("Records: %u", m_gbufferIndirectDraws.GetNumRecords());
+            if (m_gbufferIndirectGpuCulling)
+                ImGui::Text("Visible records: not read back from the GPU");
+            else
+                ImGui::Text("Visible records: %u (compacted in %.3fms)", indirect.NumVisible, indirect.Milliseconds);
+        }
+        ImGui::End();
+
         ImGui::Begin("SVGF denoising");
         SVGFDenoiser::SVGFTemporalConstants& temporal = m_svgfDenoiser.GetTemporalConstants();
         {
@@ -267,11 +493,7 @@ namespace Neb
             NEB_PIX_SCOPED_EVENT(commandList, "Deferred G-Buffers (geometry)");
             SetupDescriptorHeaps(commandList);
 
-            TransitionGbuffers(commandList,
-                D3D12_RESOURCE_STATE_COMMON,
-                D3D12_RESOURCE_STATE_RENDER_TARGET,
-                D3D12_RESOURCE_STATE_COMMON,
-                D3D12_RESOURCE_STATE_DEPTH_WRITE);
+            BeginFramePass(commandList, FRAME_PASS_GBUFFER);
             {
                 SetupGbufferRtvs(commandList);
                 SetupViewports(commandList);
@@ -279,50 +501,375 @@ namespace Neb
 
             // Setup PSO
             commandList->SetGraphicsRootSignature(m_gbufferRS.GetD3D12RootSignature());
-            commandList->SetGraphicsRootConstantBufferView(DEFERRED_RENDERER_ROOTS_INSTANCE_INFO, m_cbInstance.GetGpuVirtualAddress(info.backbufferIndex));
             commandList->SetPipelineState(m_pipelineState.Get());
             commandList->OMSetStencilRef(0xff);
 
             Mat4 viewProj = m_view * m_proj;
 
-            // Now finally submit commands per-mesh
-            for (nri::StaticMesh& staticMesh : info.scene->StaticMeshes)
+            UpdateGbufferDraws();
+            commandList->SetGraphicsRootConstantBufferView(DEFERRED_RENDERER_ROOTS_VIEW_INFO, m_frameUploadAllocator.UploadConstants(CbGbufferViewInfo{ .ViewProj = viewProj }));
+
+            if (m_gbufferIndirect)
+            {
+                SubmitCommandsGbufferIndirect(commandList, viewProj);
+            }
+            else
             {
-                const size_t numSubmeshes = staticMesh.Submeshes.size();
-                NEB_ASSERT(numSubmeshes == staticMesh.SubmeshMaterials.size(),
-                    "Static mesh is invalid. It has {} submeshes while only {} materials",
-                    numSubmeshes, staticMesh.SubmeshMaterials.size());
+                // Only draws that intersect the camera frustum and are not hidden behind occluders are submitted
+                m_gbufferCullingStats = m_gbufferCuller.Cull(ExtractFrustum(viewProj), ThreadPool::Get());
+                CullGbufferDrawsByOcclusion(viewProj);
+                SortGbufferDraws();
+                BatchGbufferDraws();
+
+                // Every visible draw is an instance, in the order of draw calls. Draw calls find their instances by SV_InstanceID (see deferred_gbuffers.hlsl)
+                const nri::FrameUploadAllocation instances = UploadGbufferInstances(m_gbufferVisibleDraws);
+                if (instances.NumElements > 0)
+                    commandList->SetGraphicsRootShaderResourceView(DEFERRED_RENDERER_ROOTS_INSTANCES, instances.GpuAddress);
+
+                // Now finally submit commands per draw call, geometry of instances of the same mesh is shared.
+                // Input layout differs between vertex formats, so does the pipeline
+                m_gbufferRecordStats = nri::RecordDrawPackets(commandList, m_gbufferDraws, m_gbufferVisibleDraws, m_gbufferBatcher.GetBatches(), nri::DrawRecordDesc{
+                    .Pipelines = { m_pipelineState.Get(), m_pipelineStateCompact.Get() },
+                    .FirstInstanceRootIndex = DEFERRED_RENDERER_ROOTS_DRAW_INFO,
+                    .MaterialTableRootIndex = DEFERRED_RENDERER_ROOTS_MATERIAL_TEXTURES,
+                });
+            }
 
-                for (size_t i = 0; i < numSubmeshes; ++i)
-                {
-                    nri::StaticSubmesh& submesh = staticMesh.Submeshes[i];
-                    nri::Material& material = staticMesh.SubmeshMaterials[i];
+            EndFramePass(commandList, FRAME_PASS_GBUFFER);
+        }
+    }
 
-                    CbInstanceInfo cbInstanceInfo = CbInstanceInfo{
-                        .InstanceToWorld = staticMesh.InstanceToWorld,
-                        .ViewProj = viewProj,
-                        .MaterialFlags = material.Flags // TODO: Would be nice to have a separate constant buffer for material properties
+    nri::FrameUploadAllocation DeferredRenderer::UploadGbufferInstances(std::span<const uint32_t> packetIndices)
+    {
+        // Instances are written at once into a single structured buffer of the frame
+        const std::vector<nri::StaticMeshInstance>& sceneInstances = m_renderInfo.scene->StaticMeshInstances;
+        const nri::FrameUploadAllocation instances = m_frameUploadAllocator.AllocateStructured<GbufferInstanceInfo>(static_cast<UINT>(packetIndices.size()));
+        ThreadPool::Get().ParallelForRange(packetIndices.size(), 1024, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const nri::DrawPacket& packet = m_gbufferDraws.GetPacket(packetIndices[i]);
+                    const PositionQuantization& quantization = m_gbufferDraws.GetQuantization(packet.GeometryIndex);
+                    const GbufferInstanceInfo instanceInfo = GbufferInstanceInfo{
+                        .InstanceToWorld = sceneInstances[packet.TransformIndex].InstanceToWorld,
+                        .PositionScale = Vec3(quantization.Scale[0], quantization.Scale[1], quantization.Scale[2]),
+                        .MaterialFlags = packet.MaterialFlags, // TODO: Would be nice to have a separate constant buffer for material properties
+                        .PositionBias = Vec3(quantization.Bias[0], quantization.Bias[1], quantization.Bias[2]),
                     };
-                    std::memcpy(m_cbInstance.GetMapping<CbInstanceInfo>(info.backbufferIndex), &cbInstanceInfo, sizeof(CbInstanceInfo));
 
-                    commandList->SetGraphicsRootDescriptorTable(DEFERRED_RENDERER_ROOTS_MATERIAL_TEXTURES, material.SrvRange.GpuAddress);
+                    // Upload memory is write-combined, instances are written to it as a whole
+                    std::memcpy(instances.GetElement<GbufferInstanceInfo>(static_cast<UINT>(i)), &instanceInfo, sizeof(GbufferInstanceInfo));
+                }
+            });
+        return instances;
+    }
+
+    void DeferredRenderer::SubmitCommandsGbufferIndirect(ID3D12GraphicsCommandList4* commandList, const Mat4& viewProj)
+    {
+        const UINT numRecords = m_gbufferIndirectDraws.GetNumRecords();
+        if (numRecords == 0)
+        {
+            m_gbufferIndirectStats = CullingStats();
+            return;
+        }
 
-                    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-                    commandList->IASetVertexBuffers(0, nri::eAttributeType_NumTypes, submesh.AttributeViews.data());
-                    commandList->IASetIndexBuffer(&submesh.IBView);
-                    commandList->DrawIndexedInstanced(submesh.NumIndices, 1, 0, 0, 0);
+        const Frustum frustum = ExtractFrustum(viewProj);
+        ID3D12Resource* argumentBuffer = nullptr;
+        ID3D12Resource* countBuffer = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS instancesAddress = 0;
+        std::array<UINT64, nri::NumIndirectDrawStreams> argumentOffsets = {};
+        nri::IndirectDrawCounts maxCommandCounts = {};
+        if (m_gbufferIndirectGpuCulling)
+        {
+            // Records and instances change with the scene or its transforms only, then they are copied from upload memory of the frame
+            if (m_gbufferIndirectRecordsDirty)
+            {
+                m_gbufferIndirectCuller.UploadRecords(commandList, m_gbufferIndirectDraws, m_frameUploadAllocator);
+
+                const nri::FrameUploadAllocation instances = UploadGbufferInstances(m_gbufferAllDraws);
+                commandList->CopyBufferRegion(m_gbufferIndirectInstanceBuffer.Get(), 0, instances.Resource, instances.Offset, instances.NumBytes);
+                const D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_gbufferIndirectInstanceBuffer.Get(),
+                    D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+                commandList->ResourceBarrier(1, &barrier);
+                m_gbufferIndirectRecordsDirty = false;
+            }
+
+            m_gbufferIndirectCuller.CullAndCompact(commandList, frustum, m_frameUploadAllocator);
+
+            // Instances are the ones of every packet, InstanceIndex of a record is its packet
+            argumentBuffer = m_gbufferIndirectCuller.GetArgumentBuffer();
+            countBuffer = m_gbufferIndirectCuller.GetCountBuffer();
+            instancesAddress = m_gbufferIndirectInstanceBuffer->GetGPUVirtualAddress();
+            for (UINT stream = 0; stream < nri::NumIndirectDrawStreams; ++stream)
+            {
+                argumentOffsets[stream] = UINT64(stream) * numRecords * sizeof(nri::IndirectDrawArguments);
+                maxCommandCounts[stream] = numRecords;
+            }
+            m_gbufferIndirectStats = CullingStats();
+        }
+        else
+        {
+            // Fallback, same streams are compacted on the CPU. Only visible commands are uploaded, streams back to back, and
+            // InstanceIndex of each of them is turned into its position, so that instances are uploaded for visible packets only
+            TimeWatch timeWatch;
+            timeWatch.Begin();
+
+            const nri::IndirectDrawCounts counts = m_gbufferIndirectDraws.CullAndCompact(frustum, m_gbufferIndirectCpuArguments, ThreadPool::Get());
+            nri::IndirectDrawCounts firstCommands = {};
+            uint32_t numVisible = 0;
+            for (UINT stream = 0; stream < nri::NumIndirectDrawStreams; ++stream)
+            {
+                firstCommands[stream] = numVisible;
+                numVisible += counts[stream];
+            }
+
+            if (numVisible > 0)
+            {
+                const nri::FrameUploadAllocation arguments = m_frameUploadAllocator.AllocateStructured<nri::IndirectDrawArguments>(numVisible);
+                m_gbufferIndirectVisibleDraws.resize(numVisible);
+                for (UINT stream = 0; stream < nri::NumIndirectDrawStreams; ++stream)
+                {
+                    const nri::IndirectDrawArguments* streamArguments = m_gbufferIndirectCpuArguments.data() + size_t(stream) * numRecords;
+                    const uint32_t firstCommand = firstCommands[stream];
+                    ThreadPool::Get().ParallelForRange(counts[stream], 1024, [&](size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                const uint32_t command = firstCommand + static_cast<uint32_t>(i);
+                                nri::IndirectDrawArguments drawArguments = streamArguments[i];
+                                m_gbufferIndirectVisibleDraws[command] = drawArguments.InstanceIndex;
+                                drawArguments.InstanceIndex = command;
+
+                                // Upload memory is write-combined, commands are written to it as a whole
+                                std::memcpy(arguments.GetElement<nri::IndirectDrawArguments>(command), &drawArguments, sizeof(nri::IndirectDrawArguments));
+                            }
+                        });
+
+                    argumentOffsets[stream] = arguments.Offset + UINT64(firstCommand) * sizeof(nri::IndirectDrawArguments);
+                    maxCommandCounts[stream] = counts[stream];
                 }
+                argumentBuffer = arguments.Resource;
+                instancesAddress = UploadGbufferInstances(m_gbufferIndirectVisibleDraws).GpuAddress;
             }
 
-            // transition every gbuffer from render state to common
-            TransitionGbuffers(commandList,
-                D3D12_RESOURCE_STATE_RENDER_TARGET,
-                D3D12_RESOURCE_STATE_COMMON,
-                D3D12_RESOURCE_STATE_DEPTH_WRITE,
-                D3D12_RESOURCE_STATE_COMMON);
+            m_gbufferIndirectStats = CullingStats{
+                .NumVisible = numVisible,
+                .NumCulled = numRecords - numVisible,
+                .Milliseconds = timeWatch.Elapsed<MillisecondsF32>().count(),
+            };
+            if (numVisible == 0)
+                return;
+        }
+
+        commandList->SetGraphicsRootShaderResourceView(DEFERRED_RENDERER_ROOTS_INSTANCES, instancesAddress);
+        commandList->SetGraphicsRootDescriptorTable(DEFERRED_RENDERER_ROOTS_MATERIAL_HEAP,
+            nri::NRIDevice::Get().GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetHeap()->GetGPUDescriptorHandleForHeapStart());
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        // Counts of the CPU path are known, thus its commands are executed without a count buffer
+        const std::array<ID3D12PipelineState*, nri::NumIndirectDrawStreams> pipelines = { m_pipelineStateIndirect.Get(), m_pipelineStateIndirectCompact.Get() };
+        for (UINT stream = 0; stream < nri::NumIndirectDrawStreams; ++stream)
+        {
+            if (maxCommandCounts[stream] == 0)
+                continue;
+
+            commandList->SetPipelineState(pipelines[stream]);
+            commandList->ExecuteIndirect(m_gbufferCommandSignature.Get(),
+                maxCommandCounts[stream],
+                argumentBuffer, argumentOffsets[stream],
+                countBuffer, countBuffer ? stream * sizeof(uint32_t) : 0);
         }
     }
 
+    void DeferredRenderer::CreateGbufferIndirectBuffers()
+    {
+        m_gbufferIndirectCuller.Resize(m_gbufferIndirectDraws);
+        m_gbufferIndirectCpuArguments.resize(size_t(m_gbufferIndirectDraws.GetNumRecords()) * nri::NumIndirectDrawStreams);
+
+        // Buffer is never empty, so that it can always be bound
+        D3D12MA::Allocator* allocator = nri::NRIDevice::Get().GetResourceAllocator();
+        D3D12MA::ALLOCATION_DESC allocDesc = {
+            .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+            .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+        };
+        const UINT64 numBytes = UINT64(m_gbufferIndirectDraws.GetNumRecords()) * sizeof(GbufferInstanceInfo);
+        const D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(std::max<UINT64>(numBytes, sizeof(GbufferInstanceInfo)));
+        nri::Rc<D3D12MA::Allocation> allocation;
+        nri::ThrowIfFailed(allocator->CreateResource(&allocDesc, &desc, D3D12_RESOURCE_STATE_COMMON,
+            nullptr,
+            allocation.GetAddressOf(),
+            IID_PPV_ARGS(m_gbufferIndirectInstanceBuffer.ReleaseAndGetAddressOf())));
+        NEB_SET_HANDLE_NAME(m_gbufferIndirectInstanceBuffer, "{}", "G-Buffer indirect instances");
+    }
+
+    void DeferredRenderer::UpdateGbufferDraws()
+    {
+        Scene* scene = m_renderInfo.scene;
+        if (scene == m_gbufferDrawsScene && scene->TransformVersion == m_gbufferDrawsTransformVersion)
+            return;
+
+        if (scene != m_gbufferDrawsScene)
+        {
+            m_gbufferDraws.Build(scene->StaticMeshes, scene->StaticMeshInstances);
+            m_gbufferCuller.Resize(m_gbufferDraws.GetNumPackets());
+
+            // Renderer waits for the GPU to be idle before the scene changes, buffers of the last scene are not in use anymore
+            nri::NRIDevice& device = nri::NRIDevice::Get();
+            m_gbufferIndirectDraws.Build(m_gbufferDraws,
+                device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).GetHeap()->GetGPUDescriptorHandleForHeapStart(),
+                device.GetD3D12Device()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
+            CreateGbufferIndirectBuffers();
+            m_gbufferAllDraws.resize(m_gbufferDraws.GetNumPackets());
+            std::iota(m_gbufferAllDraws.begin(), m_gbufferAllDraws.end(), 0);
+        }
+
+        // Boxes of submeshes are tighter than the box of the whole instance
+        ThreadPool::Get().ParallelForRange(m_gbufferDraws.GetNumPackets(), 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const nri::DrawPacket& packet = m_gbufferDraws.GetPacket(static_cast<uint32_t>(i));
+                    const Mat4& instanceToWorld = scene->StaticMeshInstances[packet.TransformIndex].InstanceToWorld;
+                    const AABB box = TransformAABBFast(m_gbufferDraws.GetLocalBox(packet.GeometryIndex), instanceToWorld);
+                    m_gbufferCuller.SetBox(static_cast<uint32_t>(i), box);
+                    m_gbufferIndirectDraws.SetBox(static_cast<uint32_t>(i), box);
+                }
+            });
+        m_gbufferIndirectRecordsDirty = true;
+
+        m_gbufferDrawsScene = scene;
+        m_gbufferDrawsTransformVersion = scene->TransformVersion;
+    }
+
+    void DeferredRenderer::SortGbufferDraws()
+    {
+        if (!m_gbufferSortDraws)
+        {
+            m_gbufferSortMilliseconds = 0.0f;
+            return;
+        }
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        ThreadPool& threadPool = ThreadPool::Get();
+        m_gbufferDrawDistances.resize(m_gbufferVisibleDraws.size());
+        threadPool.ParallelForRange(m_gbufferVisibleDraws.size(), 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const AABB& box = m_gbufferCuller.GetBox(m_gbufferVisibleDraws[i]);
+                    m_gbufferDrawDistances[i] = Vec3::Distance((box.min + box.max) * 0.5f, m_eyePos);
+                }
+            });
+        m_gbufferSorter.Sort(m_gbufferDraws, m_gbufferVisibleDraws, m_gbufferDrawDistances, ProjectionNearZ, ProjectionFarZ, threadPool);
+
+        m_gbufferSortMilliseconds = timeWatch.Elapsed<MillisecondsF32>().count();
+    }
+
+    void DeferredRenderer::BatchGbufferDraws()
+    {
+        // Keys of packets hold state of draws only, depth buckets are added when sorting
+        m_gbufferStateKeys.resize(m_gbufferVisibleDraws.size());
+        for (size_t i = 0; i < m_gbufferVisibleDraws.size(); ++i)
+            m_gbufferStateKeys[i] = m_gbufferDraws.GetPacket(m_gbufferVisibleDraws[i]).SortKey;
+
+        m_gbufferBatchStats = m_gbufferBatcher.Build(m_gbufferStateKeys, m_gbufferInstancing ? UINT32_MAX : 1);
+
+        const std::span<const uint32_t> order = m_gbufferBatcher.GetOrder();
+        m_gbufferBatchedDraws.resize(m_gbufferVisibleDraws.size());
+        for (size_t i = 0; i < m_gbufferVisibleDraws.size(); ++i)
+            m_gbufferBatchedDraws[i] = m_gbufferVisibleDraws[order[i]];
+        m_gbufferVisibleDraws.swap(m_gbufferBatchedDraws);
+    }
+
+    void DeferredRenderer::CullGbufferDrawsByOcclusion(const Mat4& viewProj)
+    {
+        const std::span<const uint32_t> frustumVisibleDraws = m_gbufferCuller.GetVisibleDraws();
+        m_gbufferVisibleDraws.assign(frustumVisibleDraws.begin(), frustumVisibleDraws.end());
+        if (!m_gbufferOcclusionCulling)
+        {
+            m_gbufferOcclusionStats = OcclusionStats();
+            m_gbufferOcclusionMilliseconds = 0.0f;
+            return;
+        }
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        Scene* scene = m_renderInfo.scene;
+        ThreadPool& threadPool = ThreadPool::Get();
+
+        // Instances that cover more of the screen hide more, they take the triangle budget first.
+        // Tiny ones are not worth rasterizing at all, as well as ones outside of the frustum (their size is 0)
+        static constexpr float MinOccluderScreenSize = 0.05f; // radius over distance
+        const Frustum frustum = ExtractFrustum(viewProj);
+        const Vec3 eye = m_view.Invert().Translation();
+
+        const uint32_t numInstances = static_cast<uint32_t>(scene->StaticMeshInstances.size());
+        m_gbufferOccluderScreenSizes.resize(numInstances);
+        threadPool.ParallelForRange(numInstances, 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const nri::StaticMeshInstance& instance = scene->StaticMeshInstances[i];
+                    float screenSize = 0.0f;
+                    if (scene->StaticMeshes[instance.MeshIndex].Occluder.GetNumTriangles() > 0 && IsAABBInFrustum(frustum, instance.WorldBox))
+                    {
+                        const Sphere& sphere = instance.WorldSphere;
+                        screenSize = (sphere.radius * sphere.radius) / std::max(Vec3::DistanceSquared(sphere.center, eye), 1e-4f);
+                    }
+                    m_gbufferOccluderScreenSizes[i] = (screenSize >= MinOccluderScreenSize * MinOccluderScreenSize) ? screenSize : 0.0f;
+                }
+            });
+
+        m_gbufferOccluderInstances.clear();
+        for (uint32_t instanceIndex = 0; instanceIndex < numInstances; ++instanceIndex)
+        {
+            if (m_gbufferOccluderScreenSizes[instanceIndex] > 0.0f)
+                m_gbufferOccluderInstances.push_back(instanceIndex);
+        }
+
+        // Only the largest instances fit the triangle budget, so candidates are never fully sorted. The next largest ones are
+        // selected with nth_element and sorted in batches of growing size, until an occluder does not fit
+        auto isLarger = [this](uint32_t a, uint32_t b) { return m_gbufferOccluderScreenSizes[a] > m_gbufferOccluderScreenSizes[b]; };
+        const auto candidates = m_gbufferOccluderInstances.begin();
+        const size_t numCandidates = m_gbufferOccluderInstances.size();
+
+        m_gbufferOccluder.BeginFrame(viewProj);
+        bool isBudgetExhausted = false;
+        for (size_t numSelected = 0; numSelected < numCandidates && !isBudgetExhausted;)
+        {
+            const size_t numToSelect = std::min(numCandidates, std::max<size_t>(numSelected * 2, 64));
+            std::nth_element(candidates + numSelected, candidates + numToSelect - 1, candidates + numCandidates, isLarger);
+            std::sort(candidates + numSelected, candidates + numToSelect, isLarger);
+
+            for (; numSelected < numToSelect && !isBudgetExhausted; ++numSelected)
+            {
+                const nri::StaticMeshInstance& instance = scene->StaticMeshInstances[candidates[numSelected]];
+                isBudgetExhausted = !m_gbufferOccluder.AddOccluder(scene->StaticMeshes[instance.MeshIndex].Occluder, instance.InstanceToWorld);
+            }
+        }
+        m_gbufferOccluder.Rasterize(threadPool);
+
+        m_gbufferOcclusionBoxes.resize(frustumVisibleDraws.size());
+        m_gbufferOcclusionVisibility.resize(frustumVisibleDraws.size());
+        for (size_t i = 0; i < frustumVisibleDraws.size(); ++i)
+            m_gbufferOcclusionBoxes[i] = m_gbufferCuller.GetBox(frustumVisibleDraws[i]);
+        m_gbufferOccluder.TestBoxes(m_gbufferOcclusionBoxes, m_gbufferOcclusionVisibility, threadPool);
+
+        // Order of draws is kept
+        size_t numVisibleDraws = 0;
+        for (size_t i = 0; i < frustumVisibleDraws.size(); ++i)
+        {
+            if (m_gbufferOcclusionVisibility[i])
+                m_gbufferVisibleDraws[numVisibleDraws++] = frustumVisibleDraws[i];
+        }
+        m_gbufferVisibleDraws.resize(numVisibleDraws);
+        m_gbufferOcclusionStats = m_gbufferOccluder.GetStats();
+        m_gbufferOcclusionMilliseconds = timeWatch.Elapsed<MillisecondsF32>().count();
+    }
+
     void DeferredRenderer::SubmitCommandsPBRLighting()
     {
         const RenderInfo& info = m_renderInfo;
@@ -342,17 +889,7 @@ namespace Neb
             SetupDescriptorHeaps(commandList);
             SetupViewports(commandList);
 
-            ID3D12Resource* resultBuffer = GetRadianceOutput();
-            {
-                std::array barriers = { CD3DX12_RESOURCE_BARRIER::Transition(resultBuffer, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS) };
-                commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-
-                TransitionGbuffers(commandList,
-                    D3D12_RESOURCE_STATE_COMMON,
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_COMMON,
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-            }
+            BeginFramePass(commandList, FRAME_PASS_PBR_LIGHTING);
 
             commandList->SetComputeRootSignature(m_pbrRS.GetD3D12RootSignature());
             commandList->SetComputeRootConstantBufferView(PBR_ROOT_CB_VIEW_DATA, m_cbViewData.GetGpuVirtualAddress(info.backbufferIndex));
@@ -380,16 +917,7 @@ namespace Neb
             std::memcpy(m_cbLightEnv.GetMapping(info.backbufferIndex), &lightEnv, sizeof(CbLightEnvironment));
 
             commandList->Dispatch((width + 7) / 8, (height + 7) / 8, 1); 
-            {
-                TransitionGbuffers(commandList,
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_COMMON,
-                    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
-                    D3D12_RESOURCE_STATE_COMMON);
-
-                auto pbrBarrier = CD3DX12_RESOURCE_BARRIER::Transition(resultBuffer, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON);
-                commandList->ResourceBarrier(1, &pbrBarrier);
-            }
+            EndFramePass(commandList, FRAME_PASS_PBR_LIGHTING);
         }
     }
 
@@ -422,12 +950,8 @@ namespace Neb
         
         ID3D12GraphicsCommandList4* commandList = info.commandList;
 
-        std::vector<D3D12_RESOURCE_BARRIER> bindlessBarriers;
-        for (nri::Rc<ID3D12Resource> resource : m_giScene.GetBindlessBuffers().resources)
-        {
-            bindlessBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-        }
-        commandList->ResourceBarrier(UINT(bindlessBarriers.size()), bindlessBarriers.data());
+        // Bindless buffers need no barriers, they are promoted from COMMON by ray tracing shaders (see BuildFrameGraph())
+        BeginFramePass(commandList, FRAME_PASS_GI_PATHTRACE);
 
         // NRC QUERY PASS
         {
@@ -455,10 +979,10 @@ namespace Neb
                     commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_SCENE_STENCIL, m_svgfDenoiser.GetStencilSrv(m_svgfDenoiser.GetCurrentResourceIndex()));
                     commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_SCENE_BVH, m_tlasSrvHeap.GpuAddress);
 
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_TEXTURES, m_giScene.GetBindlessTextureHeap().GpuAddress);
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_BUFFERS, m_giScene.GetBindlessBufferHeap().GpuAddress);
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_GEOMETRY_DATA, m_giScene.GetGeometryDataHeap().GpuAddress);
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_MATERIAL_DATA, m_giScene.GetMaterialDataHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_TEXTURES, m_giScene->GetBindlessTextureHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_BUFFERS, m_giScene->GetBindlessBufferHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_GEOMETRY_DATA, m_giScene->GetGeometryDataHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_MATERIAL_DATA, m_giScene->GetMaterialDataHeap().GpuAddress);
                 }
 
                 // Setup the raytracing task
@@ -514,10 +1038,10 @@ namespace Neb
                     commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_SCENE_STENCIL, m_svgfDenoiser.GetStencilSrv(m_svgfDenoiser.GetCurrentResourceIndex()) );
                     commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_SCENE_BVH, m_tlasSrvHeap.GpuAddress);
 
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_TEXTURES, m_giScene.GetBindlessTextureHeap().GpuAddress);
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_BUFFERS, m_giScene.GetBindlessBufferHeap().GpuAddress);
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_GEOMETRY_DATA, m_giScene.GetGeometryDataHeap().GpuAddress);
-                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_MATERIAL_DATA, m_giScene.GetMaterialDataHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_TEXTURES, m_giScene->GetBindlessTextureHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_BINDLESS_BUFFERS, m_giScene->GetBindlessBufferHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_GEOMETRY_DATA, m_giScene->GetGeometryDataHeap().GpuAddress);
+                    commandList->SetComputeRootDescriptorTable(PATHTRACER_ROOT_MATERIAL_DATA, m_giScene->GetMaterialDataHeap().GpuAddress);
                 }
 
                 // Setup the raytracing task
@@ -548,22 +1072,12 @@ namespace Neb
             }
         }
 
-        for (D3D12_RESOURCE_BARRIER& barrier : bindlessBarriers)
-        {
-            barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-            barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COMMON;
-        }
-        commandList->ResourceBarrier(UINT(bindlessBarriers.size()), bindlessBarriers.data());
-
         {
             NEB_PIX_SCOPED_EVENT(commandList, "GI: NRC Query & Train");
             nri::NvRtxgiNRCIntegration::Get()->QueryAndTrain(commandList, nullptr);
         }
 
         {
-            auto beforeBarriers = CD3DX12_RESOURCE_BARRIER::Transition(GetRadianceOutput(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
-            commandList->ResourceBarrier(1, &beforeBarriers);
-
             NEB_PIX_SCOPED_EVENT(commandList, "GI: Resolve NRC query data");
 #if 0
             SetupDescriptorHeaps(commandList);
@@ -585,9 +1099,8 @@ namespace Neb
 #else
             nri::NvRtxgiNRCIntegration::Get()->Resolve(commandList, GetRadianceOutput());
 #endif
-            auto afterBarriers = CD3DX12_RESOURCE_BARRIER::Transition(GetRadianceOutput(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON);
-            commandList->ResourceBarrier(1, &afterBarriers);
         }
+        EndFramePass(commandList, FRAME_PASS_GI_PATHTRACE);
     }
 
     void DeferredRenderer::SubmitCommandsSVGFDenoising()
@@ -598,19 +1111,31 @@ namespace Neb
         ID3D12GraphicsCommandList4* commandList = m_renderInfo.commandList;
         NEB_PIX_SCOPED_EVENT(commandList, "SVGF Denoising");
 
-        // Pre-SVGF Barriers
+        // Passes of SVGF share this command list, their barriers come from the frame graph
         SVGFDenoiser& svgf = m_svgfDenoiser;
         SetupDescriptorHeaps(commandList); // update descriptor heaps after NRC
+        if (m_resetHistory)
         {
-            if (m_resetHistory)
+            m_resetHistory = false;
+            BeginFramePass(commandList, FRAME_PASS_SVGF_RESET_HISTORY);
+            svgf.ResetHistory(commandList);
+            EndFramePass(commandList, FRAME_PASS_SVGF_RESET_HISTORY);
+        }
+
+        BeginFramePass(commandList, FRAME_PASS_SVGF_TEMPORAL_ACCUMULATION);
+        svgf.SubmitTemporalAccumulation(commandList);
+        EndFramePass(commandList, FRAME_PASS_SVGF_TEMPORAL_ACCUMULATION);
+
+        {
+            NEB_PIX_SCOPED_EVENT(commandList, "SVGF: A-Trous Wavelet");
+            for (uint32_t pass = 0; pass < SVGFDenoiser::NumAtrousPasses; ++pass)
             {
-                m_resetHistory = false;
-                svgf.ResetHistory(commandList);
+                const EFramePass framePass = EFramePass(FRAME_PASS_SVGF_ATROUS_WAVELET + pass);
+                BeginFramePass(commandList, framePass);
+                svgf.SubmitATrousComputeWavelet(commandList, pass);
+                EndFramePass(commandList, framePass);
             }
         }
-        // SVGF
-        svgf.SubmitTemporalAccumulation(commandList);
-        svgf.SubmitATrousComputeWavelet(commandList);
     }
 
     void DeferredRenderer::SubmitCommandsHDRTonemapping(ID3D12GraphicsCommandList4* commandList)
@@ -629,14 +1154,7 @@ namespace Neb
             D3D12_RECT scissorRect = CD3DX12_RECT(0, 0, width, height);
             commandList->RSSetScissorRects(1, &scissorRect);
 
-            ID3D12Resource* backbuffer = swapchain->GetCurrentBackbuffer();
-
-            // Transition HDR input and backbuffer output
-            std::array barriers = {
-                CD3DX12_RESOURCE_BARRIER::Transition(this->GetRadianceOutput(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-                CD3DX12_RESOURCE_BARRIER::Transition(backbuffer, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET),
-            };
-            commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+            BeginFramePass(commandList, FRAME_PASS_HDR_TONEMAPPING);
 
             D3D12_CPU_DESCRIPTOR_HANDLE backbufferRtv = swapchain->GetBackbufferRtvHandle(swapchain->GetCurrentBackbufferIndex());
             commandList->OMSetRenderTargets(1, &backbufferRtv, FALSE, nullptr);
@@ -648,34 +1166,10 @@ namespace Neb
             // Fullscreen triangle
             commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
             commandList->DrawInstanced(3, 1, 0, 0);
-            {
-                // Transition HDR input and backbuffer output
-                std::array barriers = {
-                    CD3DX12_RESOURCE_BARRIER::Transition(this->GetRadianceOutput(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON),
-                    CD3DX12_RESOURCE_BARRIER::Transition(backbuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COMMON),
-                };
-                commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-            }
+            EndFramePass(commandList, FRAME_PASS_HDR_TONEMAPPING);
         }
     }
 
-    void DeferredRenderer::TransitionGbuffers(ID3D12GraphicsCommandList4* commandList,
-        D3D12_RESOURCE_STATES prev,
-        D3D12_RESOURCE_STATES next,
-        D3D12_RESOURCE_STATES depthPrev,
-        D3D12_RESOURCE_STATES depthNext)
-    {
-        std::array barriers = {
-            CD3DX12_RESOURCE_BARRIER::Transition(GetGbufferAlbedo(), prev, next),
-            CD3DX12_RESOURCE_BARRIER::Transition(m_svgfDenoiser.GetNormalArray(), prev, next),
-            CD3DX12_RESOURCE_BARRIER::Transition(GetGbufferRoughnessMetalness(), prev, next),
-            CD3DX12_RESOURCE_BARRIER::Transition(GetGbufferWorldPos(), prev, next),
-            //CD3DX12_RESOURCE_BARRIER::Transition(m_depthStencilBuffer.GetBufferResource(), depthPrev, depthNext),
-            CD3DX12_RESOURCE_BARRIER::Transition(m_svgfDenoiser.GetDepthArray(), depthPrev, depthNext),
-        };
-        commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-    }
-
     void DeferredRenderer::SetupDescriptorHeaps(ID3D12GraphicsCommandList4* commandList)
     {
         nri::NRIDevice& device = nri::NRIDevice::Get();
@@ -720,56 +1214,165 @@ namespace Neb
         commandList->RSSetScissorRects(1, &scissorRect);
     }
 
-    void DeferredRenderer::InitGbuffers()
+    void DeferredRenderer::InitTransientTargets()
     {
-        UINT width = m_width;
-        UINT height = m_height;
+        nri::NRIDevice& device = nri::NRIDevice::Get();
+        D3D12MA::Allocator* allocator = device.GetResourceAllocator();
 
-        static constexpr auto CreateGbufferResource = [](
-                                                          UINT width,
-                                                          UINT height,
-                                                          DXGI_FORMAT format) -> nri::Rc<D3D12MA::Allocation>
+        struct TransientTarget
         {
-            nri::NRIDevice& device = nri::NRIDevice::Get();
+            D3D12_RESOURCE_DESC Desc;
+            EFramePass FirstPass;
+            EFramePass LastPass;
+        };
+        auto renderTarget = [this](DXGI_FORMAT format)
+            {
+                D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, m_width, m_height, 1, 1);
+                resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+                return TransientTarget{ resourceDesc, FRAME_PASS_GBUFFER, FRAME_PASS_GI_PATHTRACE };
+            };
+        auto unorderedAccessTarget = [this](DXGI_FORMAT format, EFramePass firstPass, EFramePass lastPass)
+            {
+                D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, m_width, m_height, 1, 1);
+                resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+                return TransientTarget{ resourceDesc, firstPass, lastPass };
+            };
+
+        // G-buffers are read up to path tracing, NRC debug maps are written by its queries. SVGF variance is written by temporal accumulation
+        // and read by every A-Trous pass, so it takes memory of the ones above (only of NRC debug maps on resource heap tier 1).
+        // Same passes as in BuildFrameGraph()
+        static constexpr EFramePass LastATrousPass = EFramePass(FRAME_PASS_SVGF_ATROUS_WAVELET + SVGFDenoiser::NumAtrousPasses - 1);
+        const std::array<TransientTarget, TRANSIENT_TARGET_NUM_TARGETS> targets = {
+            renderTarget(DXGI_FORMAT_R11G11B10_FLOAT),
+            renderTarget(DXGI_FORMAT_R16G16_FLOAT),
+            renderTarget(DXGI_FORMAT_R16G16B16A16_FLOAT),
+            unorderedAccessTarget(DXGI_FORMAT_R16G16B16A16_FLOAT, FRAME_PASS_GI_PATHTRACE, FRAME_PASS_GI_PATHTRACE),
+            unorderedAccessTarget(DXGI_FORMAT_R16_UINT, FRAME_PASS_GI_PATHTRACE, FRAME_PASS_GI_PATHTRACE),
+            unorderedAccessTarget(m_svgfDenoiser.GetVarianceFormat(), FRAME_PASS_SVGF_TEMPORAL_ACCUMULATION, LastATrousPass),
+        };
+
+        // On resource heap tier 1 render targets and other textures cannot share a heap
+        const bool isHeapTier1 = allocator->GetD3D12Options().ResourceHeapTier == D3D12_RESOURCE_HEAP_TIER_1;
+        auto getHeapGroup = [isHeapTier1](const D3D12_RESOURCE_DESC& resourceDesc) -> uint32_t
+            {
+                return (isHeapTier1 && !(resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)) ? 1 : 0;
+            };
+
+        m_transientPlanner.Reset();
+        for (const TransientTarget& target : targets)
+        {
+            const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device.GetD3D12Device()->GetResourceAllocationInfo(0, 1, &target.Desc);
+            m_transientPlanner.AddResource(TransientResourceDesc{
+                .FirstPass = target.FirstPass,
+                .LastPass = target.LastPass,
+                .Size = allocationInfo.SizeInBytes,
+                .Alignment = allocationInfo.Alignment,
+                .HeapGroup = getHeapGroup(target.Desc),
+            });
+        }
+        m_transientPlanner.Plan();
+
+        // Targets are released before heaps they were placed in
+        m_gbufferAlbedo = nullptr;
+        m_gbufferRoughnessMetalness = nullptr;
+        m_gbufferWorldPos = nullptr;
+        m_NRCDebugQueryThroughputMap = nullptr;
+        m_NRCDebugQueryHitMap = nullptr;
+        m_svgfVariance = nullptr;
+
+        // Heaps keep their groups, targets are the same ones at every resolution
+        m_transientHeaps.resize(m_transientPlanner.GetNumHeaps());
+        for (uint32_t heap = 0; heap < m_transientPlanner.GetNumHeaps(); ++heap)
+        {
+            const uint64_t heapSize = AlignUp<uint64_t>(m_transientPlanner.GetHeapSize(heap), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+            if (m_transientHeaps[heap] && m_transientHeaps[heap]->GetSize() >= heapSize)
+                continue;
+
+            D3D12_HEAP_FLAGS heapFlags = D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+            if (isHeapTier1)
+                heapFlags = (m_transientPlanner.GetHeapGroup(heap) == 0) ? D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
 
-            D3D12MA::Allocator* allocator = device.GetResourceAllocator();
             D3D12MA::ALLOCATION_DESC allocDesc = {
                 .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
                 .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+                .ExtraHeapFlags = heapFlags,
+            };
+            const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {
+                .SizeInBytes = heapSize,
+                .Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
             };
 
-            D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, width, height, 1, 1);
-            resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-
-            Vec4 v = Vec4(0.0f);
-            D3D12_CLEAR_VALUE clearValue = { .Format = format };
-            std::memcpy(clearValue.Color, &v.x, sizeof(clearValue.Color));
-
-            nri::Rc<D3D12MA::Allocation> allocation;
-            nri::ThrowIfFailed(allocator->CreateResource(
-                                   &allocDesc,
-                                   &resourceDesc,
-                                   D3D12_RESOURCE_STATE_COMMON, &clearValue,
-                                   allocation.GetAddressOf(), nri::NullRIID, nullptr),
-                "Failed to create gbuffer");
-            return allocation;
-        };
+            m_transientHeaps[heap] = nullptr;
+            nri::ThrowIfFailed(allocator->AllocateMemory(&allocDesc, &allocationInfo, m_transientHeaps[heap].GetAddressOf()),
+                "Failed to allocate transient heap");
+            NEB_SET_HANDLE_NAME(m_transientHeaps[heap], "Transient heap {}", heap);
+        }
 
-        m_gbufferAlbedo = CreateGbufferResource(width, height, DXGI_FORMAT_R11G11B10_FLOAT);
-        NEB_SET_HANDLE_NAME(m_gbufferAlbedo, "Albedo GBuffer DXGI_FORMAT_R11G11B10_FLOAT allocation");
-        NEB_SET_HANDLE_NAME(m_gbufferAlbedo->GetResource(), "Albedo GBuffer DXGI_FORMAT_R11G11B10_FLOAT");
+        auto createTarget = [this, allocator, &targets](ETransientTarget target)
+            {
+                const TransientPlacement& placement = m_transientPlanner.GetPlacement(target);
+                NEB_ASSERT(m_transientPlanner.GetResource(target).Alignment <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+                    "Transient heaps are not aligned for target {}", int32_t(target));
+
+                // Render targets are cleared by the G-buffer pass before they are drawn to, that initializes them after aliasing
+                const D3D12_RESOURCE_DESC& resourceDesc = targets[target].Desc;
+                const bool isRenderTarget = (resourceDesc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET) != 0;
+                const D3D12_CLEAR_VALUE clearValue = { .Format = resourceDesc.Format }; // zero, as the G-buffer pass clears them to
+
+                nri::Rc<ID3D12Resource> resource;
+                nri::ThrowIfFailed(allocator->CreateAliasingResource(
+                                       m_transientHeaps[placement.Heap].Get(),
+                                       placement.Offset,
+                                       &resourceDesc,
+                                       D3D12_RESOURCE_STATE_COMMON,
+                                       isRenderTarget ? &clearValue : nullptr,
+                                       IID_PPV_ARGS(resource.GetAddressOf())),
+                    "Failed to create transient target");
+                return resource;
+            };
+
+        m_gbufferAlbedo = createTarget(TRANSIENT_TARGET_GBUFFER_ALBEDO);
+        NEB_SET_HANDLE_NAME(m_gbufferAlbedo, "Albedo GBuffer DXGI_FORMAT_R11G11B10_FLOAT");
+
+        m_gbufferRoughnessMetalness = createTarget(TRANSIENT_TARGET_GBUFFER_ROUGHNESS_METALNESS);
+        NEB_SET_HANDLE_NAME(m_gbufferRoughnessMetalness, "Roughness/Metalness GBuffer DXGI_FORMAT_R16G16_FLOAT");
 
-        //m_gbufferNormal = CreateGbufferResource(width, height, DXGI_FORMAT_R16G16B16A16_FLOAT);
-        //NEB_SET_HANDLE_NAME(m_gbufferNormal, "Normal GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT allocation");
-        //NEB_SET_HANDLE_NAME(m_gbufferNormal->GetResource(), "Normal GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT");
+        m_gbufferWorldPos = createTarget(TRANSIENT_TARGET_GBUFFER_WORLD_POS);
+        NEB_SET_HANDLE_NAME(m_gbufferWorldPos, "World Position GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT");
 
-        m_gbufferRoughnessMetalness = CreateGbufferResource(width, height, DXGI_FORMAT_R16G16_FLOAT);
-        NEB_SET_HANDLE_NAME(m_gbufferRoughnessMetalness, "Roughness/Metalness GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT allocation");
-        NEB_SET_HANDLE_NAME(m_gbufferRoughnessMetalness->GetResource(), "Roughness/Metalness GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT");
+        m_NRCDebugQueryThroughputMap = createTarget(TRANSIENT_TARGET_NRC_DEBUG_QUERY_THROUGHPUT_MAP);
+        NEB_SET_HANDLE_NAME(m_NRCDebugQueryThroughputMap, "NRC-Debug QueryThroughputMap");
+
+        m_NRCDebugQueryHitMap = createTarget(TRANSIENT_TARGET_NRC_DEBUG_QUERY_HIT_MAP);
+        NEB_SET_HANDLE_NAME(m_NRCDebugQueryHitMap, "NRC-Debug HitMap");
+
+        m_svgfVariance = createTarget(TRANSIENT_TARGET_SVGF_VARIANCE);
+        NEB_SET_HANDLE_NAME(m_svgfVariance, "Variance texture");
+
+        const TransientAliasingStats& stats = m_transientPlanner.GetStats();
+        NEB_LOG_INFO("DeferredRenderer -> {} transient targets of {}x{} in {} heaps of {:.1f}MB (peak {:.1f}MB, {:.1f}MB separately), {} aliasing barriers",
+            stats.NumResources,
+            m_width,
+            m_height,
+            stats.NumHeaps,
+            stats.HeapBytes / (1024.0f * 1024.0f),
+            stats.PeakBytes / (1024.0f * 1024.0f),
+            stats.NaiveBytes / (1024.0f * 1024.0f),
+            stats.NumAliasingBarriers);
+    }
 
-        m_gbufferWorldPos = CreateGbufferResource(width, height, DXGI_FORMAT_R16G16B16A16_FLOAT);
-        NEB_SET_HANDLE_NAME(m_gbufferWorldPos, "World Position GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT allocation");
-        NEB_SET_HANDLE_NAME(m_gbufferWorldPos->GetResource(), "World Position GBuffer DXGI_FORMAT_R16G16B16A16_FLOAT");
+    ID3D12Resource* DeferredRenderer::GetTransientTarget(ETransientTarget target) const
+    {
+        switch (target)
+        {
+        case TRANSIENT_TARGET_GBUFFER_ALBEDO: return m_gbufferAlbedo.Get();
+        case TRANSIENT_TARGET_GBUFFER_ROUGHNESS_METALNESS: return m_gbufferRoughnessMetalness.Get();
+        case TRANSIENT_TARGET_GBUFFER_WORLD_POS: return m_gbufferWorldPos.Get();
+        case TRANSIENT_TARGET_NRC_DEBUG_QUERY_THROUGHPUT_MAP: return m_NRCDebugQueryThroughputMap.Get();
+        case TRANSIENT_TARGET_NRC_DEBUG_QUERY_HIT_MAP: return m_NRCDebugQueryHitMap.Get();
+        case TRANSIENT_TARGET_SVGF_VARIANCE: return m_svgfVariance.Get();
+        default: NEB_ASSERT(false, "Unknown transient target {}", int32_t(target)); return nullptr;
+        }
     }
 
     void DeferredRenderer::InitGbufferHeaps()
@@ -870,17 +1473,37 @@ namespace Neb
             nri::ShaderCompilationDesc("VSMain", nri::EShaderModel::sm_6_5, nri::EShaderType::Vertex),
             nri::eShaderCompilationFlag_None);
 
+        m_vsGbufferCompact = compiler->CompileShader(
+            shaderFilepath,
+            nri::ShaderCompilationDesc("VSMain", nri::EShaderModel::sm_6_5, nri::EShaderType::Vertex)
+                .AddDefine(nri::ShaderDefine("NEB_COMPACT_VERTEX_FORMAT", "1")),
+            nri::eShaderCompilationFlag_None);
+
         m_psGbuffer = compiler->CompileShader(
             shaderFilepath,
             nri::ShaderCompilationDesc("PSMain", nri::EShaderModel::sm_6_5, nri::EShaderType::Pixel),
             nri::eShaderCompilationFlag_None);
 
+        m_psGbufferBindless = compiler->CompileShader(
+            shaderFilepath,
+            nri::ShaderCompilationDesc("PSMain", nri::EShaderModel::sm_6_5, nri::EShaderType::Pixel)
+                .AddDefine(nri::ShaderDefine("NEB_BINDLESS_MATERIALS", "1")),
+            nri::eShaderCompilationFlag_None);
+
+        // Whole heap is a single unbounded range, most of its descriptors are not material textures and may not be initialized
         m_gbufferRS = nri::RootSignature(DEFERRED_RENDERER_ROOTS_NUM_ROOTS, 1);
-        m_gbufferRS.AddParamCbv(DEFERRED_RENDERER_ROOTS_INSTANCE_INFO, 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);
+        m_gbufferRS.AddParamCbv(DEFERRED_RENDERER_ROOTS_VIEW_INFO, 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_VERTEX);
+        m_gbufferRS.AddParam32BitConstants(DEFERRED_RENDERER_ROOTS_DRAW_INFO, 2, 1, 0, D3D12_SHADER_VISIBILITY_ALL);
+        m_gbufferRS.AddParamSrv(DEFERRED_RENDERER_ROOTS_INSTANCES, 0, 1, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_VERTEX);
         m_gbufferRS.AddParamDescriptorTable(DEFERRED_RENDERER_ROOTS_MATERIAL_TEXTURES, CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, nri::eMaterialTextureType_NumTypes, 0, 0), D3D12_SHADER_VISIBILITY_PIXEL);
+        m_gbufferRS.AddParamDescriptorTable(DEFERRED_RENDERER_ROOTS_MATERIAL_HEAP,
+            CD3DX12_DESCRIPTOR_RANGE1(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 2, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE),
+            D3D12_SHADER_VISIBILITY_PIXEL);
         m_gbufferRS.AddStaticSampler(0, CD3DX12_STATIC_SAMPLER_DESC(0));
 
         nri::ThrowIfFalse(m_gbufferRS.Init(&nri::NRIDevice::Get(), D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT));
+
+        m_gbufferIndirectCuller.Init(shaderDir);
     }
 
     void DeferredRenderer::InitGbufferPipelineState()
@@ -919,13 +1542,34 @@ namespace Neb
         psoDesc.NodeMask = 0;
         psoDesc.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
         nri::ThrowIfFailed(device.GetD3D12Device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(m_pipelineState.ReleaseAndGetAddressOf())));
-    }
 
-    void DeferredRenderer::InitGbufferInstanceCb()
-    {
-        nri::ThrowIfFalse(m_cbInstance.Init(nri::ConstantBufferDesc{
-            .NumBuffers = Renderer::NumInflightFrames,
-            .NumBytesPerBuffer = sizeof(CbInstanceInfo) }));
+        // Same pipeline for quantized vertices (see VertexCompression.h)
+        psoDesc.VS = m_vsGbufferCompact.GetBinaryBytecode();
+        psoDesc.InputLayout = D3D12_INPUT_LAYOUT_DESC{
+            .pInputElementDescs = nri::StaticMeshCompactInputLayout.data(),
+            .NumElements = nri::StaticMeshCompactInputLayout.size(),
+        };
+        nri::ThrowIfFailed(device.GetD3D12Device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(m_pipelineStateCompact.ReleaseAndGetAddressOf())));
+
+        // Indirect draws only differ by the way material textures are found
+        psoDesc.PS = m_psGbufferBindless.GetBinaryBytecode();
+        nri::ThrowIfFailed(device.GetD3D12Device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(m_pipelineStateIndirectCompact.ReleaseAndGetAddressOf())));
+
+        psoDesc.VS = m_vsGbuffer.GetBinaryBytecode();
+        psoDesc.InputLayout = D3D12_INPUT_LAYOUT_DESC{
+            .pInputElementDescs = nri::StaticMeshInputLayout.data(),
+            .NumElements = nri::StaticMeshInputLayout.size(),
+        };
+        nri::ThrowIfFailed(device.GetD3D12Device()->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(m_pipelineStateIndirect.ReleaseAndGetAddressOf())));
+
+        const std::array argumentDescs = nri::GetIndirectDrawArgumentDescs(DEFERRED_RENDERER_ROOTS_DRAW_INFO);
+        const D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc = D3D12_COMMAND_SIGNATURE_DESC{
+            .ByteStride = sizeof(nri::IndirectDrawArguments),
+            .NumArgumentDescs = static_cast<UINT>(argumentDescs.size()),
+            .pArgumentDescs = argumentDescs.data(),
+        };
+        nri::ThrowIfFailed(device.GetD3D12Device()->CreateCommandSignature(&commandSignatureDesc, m_gbufferRS.GetD3D12RootSignature(),
+            IID_PPV_ARGS(m_gbufferCommandSignature.ReleaseAndGetAddressOf())));
     }
 
     void DeferredRenderer::InitPBRShadersAndRootSignature()
@@ -979,7 +1623,7 @@ namespace Neb
     {
         // Avoid rebuilding AS if scenes are same
         // TODO: this should not be just a pointer check really...
-        if (m_blas.IsValid() && m_tlas.IsValid() && !m_needsASUpdate)
+        if (!m_blases.empty() && m_tlas.IsValid() && !m_needsASUpdate)
         {
             return;
         }
@@ -989,21 +1633,30 @@ namespace Neb
         NEB_LOG_INFO("Creating BLAS/TLAS structures...");
 
         NEB_ASSERT(!scene->StaticMeshes.empty());
-        NEB_LOG_WARN_IF(scene->StaticMeshes.size() > 1, "Currently theres is only ray tracing support for a single static mesh in a scene");
-        
-        nri::StaticMesh& staticMesh = scene->StaticMeshes.front();
-        m_blas = m_asBuilder.CreateBlas(commandList, m_asBuilder.QueryGeometryDescArray(staticMesh));
-
-        nri::RTTopLevelInstance instance = {
-            .blasAccelerationStructure = m_blas.accelerationStructureBuffer,
-            .transformation = staticMesh.InstanceToWorld,
-            .instanceID = 0,    // TODO: Figure it out
-            .hitGroupIndex = 0, // TODO: Change to actually match SBT entry
-            .flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE,
-            //.flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE,
-        };
+        NEB_ASSERT(m_giScene->GetStaticMeshInstances().size() == scene->StaticMeshInstances.size(), "GI scene should be initialized before acceleration structures");
+
+        // One BLAS per unique mesh, instances only reference them
+        m_blases.clear();
+        m_blases.reserve(scene->StaticMeshes.size());
+        for (const nri::StaticMesh& staticMesh : scene->StaticMeshes)
+            m_blases.push_back(m_asBuilder.CreateBlas(commandList, staticMesh));
+
+        std::vector<nri::RTTopLevelInstance> instances;
+        instances.reserve(scene->StaticMeshInstances.size());
+        for (uint32_t i = 0; i < scene->StaticMeshInstances.size(); ++i)
+        {
+            const nri::StaticMeshInstance& instance = scene->StaticMeshInstances[i];
+            instances.push_back(nri::RTTopLevelInstance{
+                .blasAccelerationStructure = m_blases[instance.MeshIndex].accelerationStructureBuffer,
+                .transformation = instance.InstanceToWorld,
+                .instanceID = m_giScene->GetInstanceGeometryOffset(i), // see GIProcessedScene::InitScene
+                .hitGroupIndex = 0, // TODO: Change to actually match SBT entry
+                .flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE,
+                //.flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE,
+            });
+        }
 
-        m_tlas = m_asBuilder.CreateTlas(commandList, std::span(&instance, 1));
+        m_tlas = m_asBuilder.CreateTlas(commandList, instances);
         NEB_LOG_INFO("Creating BLAS/TLAS structures - Done!");
 
         NEB_LOG_INFO("Creating TLAS SRV...");
@@ -1080,9 +1733,17 @@ namespace Neb
         return false;
     }
 
-    void DeferredRenderer::InitPathtracerScene(Scene* scene)
+    void DeferredRenderer::InitPathtracerScene(Scene* scene, nri::GIProcessedScene* giScene)
     {
-        nri::ThrowIfFalse(m_giScene.InitScene(scene->StaticMeshes), "Failed to initialize GI scene for pathtracer");
+        if (giScene)
+        {
+            NEB_ASSERT(giScene->GetStaticMeshInstances().size() == scene->StaticMeshInstances.size(), "Prebuilt GI scene should be built from the same scene");
+            m_giScene = giScene;
+            return;
+        }
+
+        nri::ThrowIfFalse(m_ownGIScene.InitScene(scene->StaticMeshes, scene->StaticMeshInstances), "Failed to initialize GI scene for pathtracer");
+        m_giScene = &m_ownGIScene;
     }
     
     void DeferredRenderer::InitPathtracerDescriptors()
@@ -1298,33 +1959,18 @@ namespace Neb
         m_globalConstantsCB.SetName("GI: Global constant buffer");
     }
 
-    void DeferredRenderer::InitPathtracerNRCQueryDebugResources(UINT width, UINT height)
+    void DeferredRenderer::InitPathtracerNRCQueryDebugResources()
     {
         nri::NRIDevice& device = nri::NRIDevice::Get();
-        m_NRCDebugBuffersHeap = device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).AllocateDescriptors(NRC_NEB_DEBUG_BUFFER_NUM_BUFFERS);
+        if (m_NRCDebugBuffersHeap.IsNull())
+        {
+            m_NRCDebugBuffersHeap = device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).AllocateDescriptors(NRC_NEB_DEBUG_BUFFER_NUM_BUFFERS);
+            NEB_ASSERT(!m_NRCDebugBuffersHeap.IsNull(), "Failed to allocate NRC debug UAV descriptors");
+        }
 
-        D3D12MA::Allocator* allocator = device.GetResourceAllocator();
-        D3D12MA::ALLOCATION_DESC allocDesc = {
-            .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-            .HeapType = D3D12_HEAP_TYPE_DEFAULT,
-        };
+        // Maps themselves are transient targets, see InitTransientTargets()
         {
             // NRC_NEB_DEBUG_BUFFER_QUERY_THROUGHPUT_MAP
-            D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, width, height);
-            resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-            nri::D3D12Rc<D3D12MA::Allocation> allocation;
-            nri::ThrowIfFailed(allocator->CreateResource(
-                &allocDesc,
-                &resourceDesc,
-                D3D12_RESOURCE_STATE_COMMON, // No need to use copy dest state. Buffers are effectively created in state D3D12_RESOURCE_STATE_COMMON.
-                nullptr, allocation.GetAddressOf(),
-                IID_PPV_ARGS(m_NRCDebugQueryThroughputMap.ReleaseAndGetAddressOf())));
-
-            // hack to convert from string to wstring using <filesystem>. Not sure if that ok to do
-            NEB_SET_HANDLE_NAME(m_NRCDebugQueryThroughputMap, "NRC-Debug QueryThroughputMap");
-
-
             D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
                 .Format = DXGI_FORMAT_R16G16B16A16_FLOAT,
                 .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D,
@@ -1338,20 +1984,6 @@ namespace Neb
         
         {
             // NRC_NEB_DEBUG_BUFFER_QUERY_HIT_MAP
-            D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16_UINT, width, height);
-            resourceDesc.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-
-            nri::D3D12Rc<D3D12MA::Allocation> allocation;
-            nri::ThrowIfFailed(allocator->CreateResource(
-                &allocDesc,
-                &resourceDesc,
-                D3D12_RESOURCE_STATE_COMMON, // No need to use copy dest state. Buffers are effectively created in state D3D12_RESOURCE_STATE_COMMON.
-                nullptr, allocation.GetAddressOf(),
-                IID_PPV_ARGS(m_NRCDebugQueryHitMap.ReleaseAndGetAddressOf())));
-
-            // hack to convert from string to wstring using <filesystem>. Not sure if that ok to do
-            NEB_SET_HANDLE_NAME(m_NRCDebugQueryHitMap, "NRC-Debug HitMap");
-
             D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
                 .Format = DXGI_FORMAT_R16_UINT,
                 .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D,
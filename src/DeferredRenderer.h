@@ -1,11 +1,18 @@
 #pragma once
 
+#include "core/FrustumCulling.h"
+#include "core/OcclusionCulling.h"
+#include "core/RenderGraph.h"
 #include "core/Scene.h"
+#include "core/TransientAliasing.h"
 #include "nri/stdafx.h"
 #include "nri/ConstantBuffer.h"
 #include "nri/Device.h"
 #include "nri/DescriptorHeapAllocation.h"
 #include "nri/DepthStencilBuffer.h"
+#include "nri/DrawPacket.h"
+#include "nri/FrameUploadAllocator.h"
+#include "nri/IndirectDrawCuller.h"
 #include "nri/Swapchain.h"
 #include "nri/Shader.h"
 #include "nri/RootSignature.h"
@@ -21,12 +28,21 @@
 namespace Neb
 {
 
-    CONSTANT_BUFFER_STRUCT CbInstanceInfo
+    CONSTANT_BUFFER_STRUCT CbGbufferViewInfo
     {
-        Mat4 InstanceToWorld;
         Mat4 ViewProj;
+    };
+
+    // Element of the per-frame structured buffer of G-buffer instances, instances of a draw call are contiguous
+    struct GbufferInstanceInfo
+    {
+        Mat4 InstanceToWorld;
+        Vec3 PositionScale; // dequantization of compact vertex positions, identity for the full format
         uint32_t MaterialFlags;
+        Vec3 PositionBias;
+        uint32_t _pad0;
     };
+    static_assert(sizeof(GbufferInstanceInfo) % 16 == 0, "G-buffer instances are expected to be 16-byte aligned in the structured buffer");
 
     CONSTANT_BUFFER_STRUCT CbViewData
     {
@@ -56,6 +72,7 @@ namespace Neb
         struct RenderInfo
         {
             Scene* scene;
+            nri::GIProcessedScene* giScene; // optional, prebuilt for the scene (see SceneLoader). Built by the renderer if null
             ID3D12GraphicsCommandList4* commandList;
             UINT backbufferIndex;
             UINT frameIndex;
@@ -64,10 +81,10 @@ namespace Neb
         void BeginFrame(const RenderInfo& info);
         void EndFrame();
 
-        ID3D12Resource* GetGbufferAlbedo() const { return m_gbufferAlbedo->GetResource(); }
+        ID3D12Resource* GetGbufferAlbedo() const { return m_gbufferAlbedo.Get(); }
         //ID3D12Resource* GetGbufferNormal() const { return m_gbufferNormal->GetResource(); }
-        ID3D12Resource* GetGbufferRoughnessMetalness() const { return m_gbufferRoughnessMetalness->GetResource(); }
-        ID3D12Resource* GetGbufferWorldPos() const { return m_gbufferWorldPos->GetResource(); }
+        ID3D12Resource* GetGbufferRoughnessMetalness() const { return m_gbufferRoughnessMetalness.Get(); }
+        ID3D12Resource* GetGbufferWorldPos() const { return m_gbufferWorldPos.Get(); }
 
         //ID3D12Resource* GetHDROutputResource() const { return m_hdrResult->GetResource(); }
 
@@ -80,11 +97,6 @@ namespace Neb
         void SubmitCommandsSVGFDenoising();
         void SubmitCommandsHDRTonemapping(ID3D12GraphicsCommandList4* commandList);
 
-        void TransitionGbuffers(ID3D12GraphicsCommandList4* commandList,
-            D3D12_RESOURCE_STATES prev,
-            D3D12_RESOURCE_STATES next,
-            D3D12_RESOURCE_STATES depthPrev,
-            D3D12_RESOURCE_STATES depthNext);
         void SetupDescriptorHeaps(ID3D12GraphicsCommandList4* commandList);
         void SetupGbufferRtvs(ID3D12GraphicsCommandList4* commandList);
         void SetupViewports(ID3D12GraphicsCommandList4* commandList);
@@ -94,6 +106,15 @@ namespace Neb
 
         Scene* GetCurrentScene() const { return m_scene; }
 
+        // Frustum culling of G-buffer draws of the last frame
+        const CullingStats& GetGbufferCullingStats() const { return m_gbufferCullingStats; }
+        const OcclusionStats& GetGbufferOcclusionStats() const { return m_gbufferOcclusionStats; }
+        const nri::DrawRecordStats& GetGbufferRecordStats() const { return m_gbufferRecordStats; }
+        const DrawBatchStats& GetGbufferBatchStats() const { return m_gbufferBatchStats; }
+        const CullingStats& GetGbufferIndirectStats() const { return m_gbufferIndirectStats; }
+        const RenderGraphStats& GetFrameGraphStats() const { return m_frameGraph.GetStats(); }
+        const TransientAliasingStats& GetTransientTargetStats() const { return m_transientPlanner.GetStats(); }
+
     private:
         UINT m_width = 0;
         UINT m_height = 0;
@@ -106,8 +127,53 @@ namespace Neb
         Vec3 m_eyePos;
         Mat4 m_view;
         Mat4 m_proj;
+        static constexpr float ProjectionNearZ = 0.1f;
+        static constexpr float ProjectionFarZ = 100.0f;
 
         bool m_showUI = true;
+
+        // Transitions between passes of the frame are derived from the resources every pass reads and writes, the graph is rebuilt
+        // in BeginFrame(). Passes are never reordered, passes of SVGF share a command list and the others are command lists of their own
+        // (see Renderer::RenderSceneDeferred). Only textures are tracked, their states are kept between command lists
+        enum EFramePass
+        {
+            FRAME_PASS_GBUFFER = 0,
+            FRAME_PASS_PBR_LIGHTING,
+            FRAME_PASS_GI_PATHTRACE,
+            FRAME_PASS_SVGF_RESET_HISTORY,
+            FRAME_PASS_SVGF_TEMPORAL_ACCUMULATION,
+            FRAME_PASS_SVGF_ATROUS_WAVELET, // first of SVGFDenoiser::NumAtrousPasses passes
+            FRAME_PASS_HDR_TONEMAPPING = FRAME_PASS_SVGF_ATROUS_WAVELET + SVGFDenoiser::NumAtrousPasses,
+            FRAME_PASS_NUM_PASSES,
+        };
+        void BuildFrameGraph();
+        void BeginFramePass(ID3D12GraphicsCommandList4* commandList, EFramePass pass);
+        void EndFramePass(ID3D12GraphicsCommandList4* commandList, EFramePass pass); // final barriers of the frame after its last pass
+        void SubmitFrameGraphBarriers(ID3D12GraphicsCommandList4* commandList, uint32_t position, std::span<const TransientAliasingBarrier> aliasingBarriers = {});
+
+        RenderGraph m_frameGraph;
+        std::array<uint32_t, FRAME_PASS_NUM_PASSES> m_framePasses = {}; // RenderGraph::InvalidIndex for passes that are skipped this frame
+        std::vector<ID3D12Resource*> m_frameGraphResources;              // by resources of m_frameGraph
+        std::vector<D3D12_RESOURCE_BARRIER> m_frameGraphBarriers;       // kept between frames, so that its memory is reused
+
+        // Targets that never outlive a frame are placed in heaps planned by m_transientPlanner from the passes that use them, targets
+        // of passes that never meet share memory and are activated by aliasing barriers in BeginFramePass(). Plans follow the resolution,
+        // heaps are only reallocated when a plan does not fit into them
+        enum ETransientTarget
+        {
+            TRANSIENT_TARGET_GBUFFER_ALBEDO = 0,
+            TRANSIENT_TARGET_GBUFFER_ROUGHNESS_METALNESS,
+            TRANSIENT_TARGET_GBUFFER_WORLD_POS,
+            TRANSIENT_TARGET_NRC_DEBUG_QUERY_THROUGHPUT_MAP,
+            TRANSIENT_TARGET_NRC_DEBUG_QUERY_HIT_MAP,
+            TRANSIENT_TARGET_SVGF_VARIANCE,
+            TRANSIENT_TARGET_NUM_TARGETS,
+        };
+        void InitTransientTargets();
+        ID3D12Resource* GetTransientTarget(ETransientTarget target) const;
+
+        TransientAliasingPlanner m_transientPlanner; // passes are EFramePass, resources are ETransientTarget
+        std::vector<nri::Rc<D3D12MA::Allocation>> m_transientHeaps;
         struct SceneSunUI
         {
             float roughDiameter = 0.58f; // Rough estimate of sun diameter as seen from Earth
@@ -124,18 +190,16 @@ namespace Neb
             float throughputThreshold = 0.01f;
         } m_globalIlluminationUI;
 
-        void InitGbuffers();
         void InitGbufferHeaps();
         void InitGbufferDepthStencilBuffer();
         void InitGbufferDepthStencilSrv();
         void InitGbufferShadersAndRootSignatures();
         void InitGbufferPipelineState();
-        void InitGbufferInstanceCb();
         
-        nri::Rc<D3D12MA::Allocation> m_gbufferAlbedo;
+        nri::Rc<ID3D12Resource> m_gbufferAlbedo; // transient targets, see InitTransientTargets()
         //nri::Rc<D3D12MA::Allocation> m_gbufferNormal;
-        nri::Rc<D3D12MA::Allocation> m_gbufferRoughnessMetalness;
-        nri::Rc<D3D12MA::Allocation> m_gbufferWorldPos;
+        nri::Rc<ID3D12Resource> m_gbufferRoughnessMetalness;
+        nri::Rc<ID3D12Resource> m_gbufferWorldPos;
         enum EGbufferSlot
         {
             GBUFFER_SLOT_ALBEDO = 0,
@@ -149,15 +213,89 @@ namespace Neb
         //nri::DescriptorHeapAllocation m_depthStencilSrvHeap; // depth at index 0, stencil at index 1
         enum EDeferredRendererRoots
         {
-            DEFERRED_RENDERER_ROOTS_INSTANCE_INFO = 0,
-            DEFERRED_RENDERER_ROOTS_MATERIAL_TEXTURES = 1,
+            DEFERRED_RENDERER_ROOTS_VIEW_INFO = 0,
+            DEFERRED_RENDERER_ROOTS_DRAW_INFO, // first instance and material index, see DrawInfo of deferred_gbuffers.hlsl
+            DEFERRED_RENDERER_ROOTS_INSTANCES,
+            DEFERRED_RENDERER_ROOTS_MATERIAL_TEXTURES,
+            DEFERRED_RENDERER_ROOTS_MATERIAL_HEAP, // whole shader-visible heap, for indirect draws
             DEFERRED_RENDERER_ROOTS_NUM_ROOTS,
         };
         nri::RootSignature m_gbufferRS;
         nri::Shader m_vsGbuffer;
+        nri::Shader m_vsGbufferCompact; // for submeshes in nri::eVertexFormat_Compact
         nri::Shader m_psGbuffer;
+        nri::Shader m_psGbufferBindless; // for indirect draws
         nri::Rc<ID3D12PipelineState> m_pipelineState;
-        nri::ConstantBuffer m_cbInstance;
+        nri::Rc<ID3D12PipelineState> m_pipelineStateCompact;
+        nri::Rc<ID3D12PipelineState> m_pipelineStateIndirect;
+        nri::Rc<ID3D12PipelineState> m_pipelineStateIndirectCompact;
+        nri::Rc<ID3D12CommandSignature> m_gbufferCommandSignature; // see nri::IndirectDrawArguments
+        nri::FrameUploadAllocator m_frameUploadAllocator; // per-frame constants and instances, see GbufferInstanceInfo
+
+        // Every submesh of every instance is a separate G-buffer draw, a packet of m_gbufferDraws. Packets are only rebuilt when the scene changes.
+        // Draws are culled against the camera frustum each frame, their world boxes are only refreshed when the scene or its transforms change
+        void UpdateGbufferDraws();
+
+        nri::DrawPacketCache m_gbufferDraws;
+        FrustumCuller m_gbufferCuller;
+        CullingStats m_gbufferCullingStats;
+        Scene* m_gbufferDrawsScene = nullptr;
+        uint32_t m_gbufferDrawsTransformVersion = 0;
+
+        // Draws that survived frustum culling are then tested against occluders (EConfigKey::OcclusionCulling), the largest
+        // instances on screen are picked as occluders until the triangle budget of OcclusionCuller is reached.
+        // The whole stage (selection of occluders, rasterization and tests) is timed against the budget of OcclusionCullerDesc
+        void CullGbufferDrawsByOcclusion(const Mat4& viewProj);
+
+        bool m_gbufferOcclusionCulling = false;
+        OcclusionCuller m_gbufferOccluder;
+        OcclusionStats m_gbufferOcclusionStats;
+        float m_gbufferOcclusionMilliseconds = 0.0f;
+        std::vector<float> m_gbufferOccluderScreenSizes; // of every instance, 0 if it is not a candidate
+        std::vector<uint32_t> m_gbufferOccluderInstances;
+        std::vector<AABB> m_gbufferOcclusionBoxes;
+        std::vector<uint8_t> m_gbufferOcclusionVisibility;
+        std::vector<uint32_t> m_gbufferVisibleDraws; // packets of m_gbufferDraws, that are finally submitted
+
+        // Visible draws are sorted by their state and then front to back, so that recording skips redundant state changes
+        void SortGbufferDraws();
+
+        bool m_gbufferSortDraws = true;
+        nri::DrawPacketSorter m_gbufferSorter;
+        std::vector<float> m_gbufferDrawDistances;
+        float m_gbufferSortMilliseconds = 0.0f;
+        nri::DrawRecordStats m_gbufferRecordStats;
+
+        // Sorted draws of the same submesh and material are then drawn as instances of a single draw call (unless instancing is disabled,
+        // in which case every draw is a draw call of its own). Draws are compacted, so that instances of each draw call are contiguous
+        void BatchGbufferDraws();
+
+        bool m_gbufferInstancing = true;
+        DrawBatcher m_gbufferBatcher;
+        DrawBatchStats m_gbufferBatchStats;
+        std::vector<uint64_t> m_gbufferStateKeys;
+        std::vector<uint32_t> m_gbufferBatchedDraws;
+
+        // Per-frame instances of packets, in the order of packetIndices
+        nri::FrameUploadAllocation UploadGbufferInstances(std::span<const uint32_t> packetIndices);
+
+        // Indirect path instead of everything above: every packet is a persistent record, records are culled and compacted into
+        // argument streams either by gbuffer_cull.hlsl or on the CPU (the reference of it), then drawn with an ExecuteIndirect per stream.
+        // Only frustum culling is done. On the GPU records and instances of every packet are persistent, they are copied to the GPU
+        // when the scene or its transforms change. The CPU path uploads arguments and instances of visible records only each frame
+        void SubmitCommandsGbufferIndirect(ID3D12GraphicsCommandList4* commandList, const Mat4& viewProj);
+        void CreateGbufferIndirectBuffers();
+
+        bool m_gbufferIndirect = false;
+        bool m_gbufferIndirectGpuCulling = true;
+        bool m_gbufferIndirectRecordsDirty = false;
+        nri::IndirectDrawList m_gbufferIndirectDraws;
+        nri::IndirectDrawCuller m_gbufferIndirectCuller;
+        std::vector<uint32_t> m_gbufferAllDraws; // every packet, instances of GPU culled draws
+        nri::Rc<ID3D12Resource> m_gbufferIndirectInstanceBuffer; // GbufferInstanceInfo of every packet
+        std::vector<nri::IndirectDrawArguments> m_gbufferIndirectCpuArguments; // streams of the CPU path, before they are uploaded
+        std::vector<uint32_t> m_gbufferIndirectVisibleDraws; // packets of the CPU path, instances of its draws
+        CullingStats m_gbufferIndirectStats; // of the CPU path only, GPU culling is not read back
 
         void InitPBRShadersAndRootSignature();
         void InitPBRConstantBuffers();
@@ -188,7 +326,7 @@ namespace Neb
         //      usage may expand soon
         Scene* m_scene = nullptr;
         nri::RTAccelerationStructureBuilder m_asBuilder;
-        nri::RTBlasBuffers m_blas;
+        std::vector<nri::RTBlasBuffers> m_blases; // per static mesh
         nri::RTTlasBuffers m_tlas;
         nri::DescriptorHeapAllocation m_tlasSrvHeap;
         bool m_needsASUpdate = false;
@@ -208,13 +346,13 @@ namespace Neb
 
         // returns true if NRC was re-configured, otherwise false
         bool ConfigureNRCState(const nrc::ContextSettings& nrcContextSettings);
-        void InitPathtracerScene(Scene* scene); // scene is specified explicitly to allow for independent re-configurations of heaps
+        void InitPathtracerScene(Scene* scene, nri::GIProcessedScene* giScene); // scene is specified explicitly to allow for independent re-configurations of heaps
         void InitPathtracerDescriptors();
         void InitPathtracerShadersAndRootSignatures();
         void InitPathtracerPipeline();
         void InitPathtracerSBT();
         void InitPathtracerConstantBuffers();
-        void InitPathtracerNRCQueryDebugResources(UINT width, UINT height);
+        void InitPathtracerNRCQueryDebugResources();
 
         CONSTANT_BUFFER_STRUCT GlobalConstants
         {
@@ -237,7 +375,8 @@ namespace Neb
             float throughputThreshold;
         };
 
-        nri::GIProcessedScene m_giScene;
+        nri::GIProcessedScene* m_giScene = nullptr; // either prebuilt one of the current scene or m_ownGIScene
+        nri::GIProcessedScene m_ownGIScene;
         nri::DescriptorHeapAllocation m_nrcBufferUavHeap;
 
         NrcConstants m_nrcConstants;
@@ -284,7 +423,7 @@ namespace Neb
             NRC_NEB_DEBUG_BUFFER_QUERY_HIT_MAP,
             NRC_NEB_DEBUG_BUFFER_NUM_BUFFERS
         };
-        nri::Rc<ID3D12Resource> m_NRCDebugQueryThroughputMap;
+        nri::Rc<ID3D12Resource> m_NRCDebugQueryThroughputMap; // transient targets, see InitTransientTargets()
         nri::Rc<ID3D12Resource> m_NRCDebugQueryHitMap;
         nri::DescriptorHeapAllocation m_NRCDebugBuffersHeap;
 
@@ -307,6 +446,7 @@ namespace Neb
 
         bool m_resetHistory = false;
         SVGFDenoiser m_svgfDenoiser;
+        nri::Rc<ID3D12Resource> m_svgfVariance; // transient target, see InitTransientTargets()
     };
 
 } // Neb namespace
\ No newline at end of file
@@ -1,9 +1,13 @@
 #include "Nebulae.h"
 
 #include "common/Assert.h"
+#include "common/Configuration.h"
 #include "common/Log.h"
 #include "input/InputManager.h"
 #include "nri/Device.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
 
 namespace Neb
 {
@@ -30,35 +34,26 @@ namespace Neb
             return false;
         }
 
-        m_sceneImporter = MakeScoped<GLTFSceneImporter>();
-        //nri::ThrowIfFalse(m_sceneImporter->ImportScenesFromFile(appSpec.AssetsDirectory / "a-beautiful-game" / "ABeautifulGame.gltf"));
-        //nri::ThrowIfFalse(m_sceneImporter->ImportScenesFromFile(appSpec.AssetsDirectory / "cornell_box" / "cornell_box.gltf"));
-        nri::ThrowIfFalse(m_sceneImporter->ImportScenesFromFile(appSpec.AssetsDirectory / "sponza-gltf-pbr" / "Sponza.glb", EGLTFType::Binary));
-        //nri::ThrowIfFalse(m_sceneImporter->ImportScenesFromFile(appSpec.AssetsDirectory / "sponza" / "Sponza.gltf"));
-        //nri::ThrowIfFalse(m_sceneImporter->ImportScenesFromFile(appSpec.AssetsDirectory / "DamagedHelmet" / "DamagedHelmet.gltf"));
+        // Scene is imported in background, frames are rendered in the meantime (see Render())
+        m_sceneLoader = MakeScoped<SceneLoader>();
+        //m_sceneLoader->RequestLoad(appSpec.AssetsDirectory / "a-beautiful-game" / "ABeautifulGame.gltf");
+        //m_sceneLoader->RequestLoad(appSpec.AssetsDirectory / "cornell_box" / "cornell_box.gltf");
+        m_sceneLoader->RequestLoad(appSpec.AssetsDirectory / "sponza-gltf-pbr" / "Sponza.glb", EGLTFType::Binary);
+        //m_sceneLoader->RequestLoad(appSpec.AssetsDirectory / "sponza" / "Sponza.gltf");
+        //m_sceneLoader->RequestLoad(appSpec.AssetsDirectory / "DamagedHelmet" / "DamagedHelmet.gltf");
 
-        // TODO: This is currently hardcoded as we know that very first scene will be used for rendering, thus we register its callbacks
-        Neb::Scene* scene = m_sceneImporter->ImportedScenes.front();
         Neb::Mouse& mouse = Neb::InputManager::Get().GetMouse();
         {
-            mouse.RegisterCallback<Neb::MouseEvent_Scrolled>(&Neb::Scene::OnMouseScroll, scene);
-            mouse.RegisterCallback<Neb::MouseEvent_CursorHotspotChanged>(&Neb::Scene::OnMouseCursorMoved, scene);
-            mouse.RegisterCallback<Neb::MouseEvent_ButtonInteraction>(&Neb::Scene::OnMouseButtonInteract, scene);
+            mouse.RegisterCallback<Neb::MouseEvent_Scrolled>(&Neb::Nebulae::OnMouseScroll, this);
+            mouse.RegisterCallback<Neb::MouseEvent_CursorHotspotChanged>(&Neb::Nebulae::OnMouseCursorMoved, this);
+            mouse.RegisterCallback<Neb::MouseEvent_ButtonInteraction>(&Neb::Nebulae::OnMouseButtonInteract, this);
         }
         Neb::Keyboard& keyboard = Neb::InputManager::Get().GetKeyboard();
         {
             keyboard.RegisterCallback<Neb::KeyboardEvent_KeyInteraction>(&Neb::Nebulae::OnKeyInteraction, this);
-            keyboard.RegisterCallback<Neb::KeyboardEvent_KeyInteraction>(&Neb::Scene::OnKeyboardInteract, scene);
             keyboard.RegisterCallback<Neb::KeyboardEvent_KeyInteraction>(&Neb::DeferredRenderer::OnKeyInteraction, m_renderer->GetDeferredRenderer());
         }
 
-        if (!m_renderer->InitSceneContext(scene))
-        {
-            NEB_ASSERT(false, "Failed to initialize ray traced scene");
-            NEB_LOG_ERROR("Nebulae -> Failed to init ray traced scene");
-            return false;
-        }
-
         // At the very end begin the time watch
         m_timeWatch.Begin();
         m_isInitialized = true;
@@ -67,8 +62,10 @@ namespace Neb
 
     void Nebulae::Shutdown()
     {
-        m_sceneImporter.Release();
+        // Loader first, as it might still be uploading. Renderer waits for the GPU, thus the scene is released the last
+        m_sceneLoader.Release();
         m_renderer.Release();
+        m_loadedScene.Release();
     }
 
     void Nebulae::Render()
@@ -89,7 +86,40 @@ namespace Neb
 
         secondsSinceLastFps += timestep;
 
-        m_renderer->RenderSceneDeferred(timestep);
+        // Frame boundary, the only place where scenes are swapped
+        SwapLoadedScene();
+        if (m_sceneLoader->IsLoading())
+        {
+            ++m_numLoadingFrames;
+            m_maxLoadingFrameMilliseconds = std::max(m_maxLoadingFrameMilliseconds, timestep * 1000.0f);
+        }
+
+        if (m_renderer->HasSceneContext())
+            m_renderer->RenderSceneDeferred(timestep);
+        else
+            m_renderer->RenderLoadingFrame();
+    }
+
+    void Nebulae::SwapLoadedScene()
+    {
+        Scoped<LoadedScene> loadedScene = m_sceneLoader->TakeLoaded();
+        if (!loadedScene.IsValid())
+            return;
+
+        // Waits for the GPU, so that the previous scene is not referenced by in-flight frames anymore
+        if (!m_renderer->InitSceneContext(loadedScene->GetScene(), loadedScene->GIScene))
+        {
+            NEB_LOG_ERROR("Nebulae -> Failed to init scene context of '{}'", loadedScene->Filepath.string());
+            return;
+        }
+
+        NEB_LOG_INFO("Nebulae -> Swapped to '{}' (loaded in {:.1f}ms), {} frames were rendered during the load, max frametime {:.1f}ms",
+            loadedScene->Filepath.filename().string(), loadedScene->LoadMilliseconds, m_numLoadingFrames, m_maxLoadingFrameMilliseconds);
+        m_numLoadingFrames = 0;
+        m_maxLoadingFrameMilliseconds = 0.0f;
+
+        m_loadedScene.Release();
+        m_loadedScene = std::move(loadedScene);
     }
 
     void Nebulae::Resize(UINT width, UINT height)
@@ -109,6 +139,27 @@ namespace Neb
                 break;
             }
         }
+
+        if (Scene* scene = GetScene())
+            scene->OnKeyboardInteract(event);
+    }
+
+    void Nebulae::OnMouseScroll(const MouseEvent_Scrolled& event)
+    {
+        if (Scene* scene = GetScene())
+            scene->OnMouseScroll(event);
+    }
+
+    void Nebulae::OnMouseCursorMoved(const MouseEvent_CursorHotspotChanged& event)
+    {
+        if (Scene* scene = GetScene())
+            scene->OnMouseCursorMoved(event);
+    }
+
+    void Nebulae::OnMouseButtonInteract(const MouseEvent_ButtonInteraction& event)
+    {
+        if (Scene* scene = GetScene())
+            scene->OnMouseButtonInteract(event);
     }
 
 } // Neb namespace
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "common/TimeWatch.h"
 #include "core/Scene.h"
 #include "core/GLTFSceneImporter.h"
+#include "core/SceneLoader.h"
 #include "Renderer.h"
 #include "Raytracer.h"
 #include "util/ScopedPointer.h"
@@ -39,28 +40,44 @@ namespace Neb
         // TODO: Currently render just takes the first imported scene in GLTFSceneImporter, if any
         // this behavior should be expanded upon by allowing more control on the API, but the idea should
         // still be the same
+        // Scenes are loaded by m_sceneLoader and swapped in at the beginning of a frame, until then loading frames are rendered
         void Render();
         void Resize(UINT width, UINT height);
 
         const AppSpec& GetSpecification() const { return m_appSpec; }
 
-        GLTFSceneImporter* GetSceneImporter() { return m_sceneImporter; }
-        const GLTFSceneImporter* GetSceneImporter() const { return m_sceneImporter; }
+        SceneLoader* GetSceneLoader() { return m_sceneLoader; }
+        const SceneLoader* GetSceneLoader() const { return m_sceneLoader; }
+
+        // Null while the first scene is loading
+        Scene* GetScene() { return m_loadedScene.IsValid() ? m_loadedScene->GetScene() : nullptr; }
 
         Renderer* GetRenderer() { return m_renderer; }
         const Renderer* GetRenderer() const { return m_renderer; }
 
         void OnKeyInteraction(const KeyboardEvent_KeyInteraction& event);
 
+        // Input callbacks are registered once and forwarded to the current scene, as scenes are swapped during runtime
+        void OnMouseScroll(const MouseEvent_Scrolled& event);
+        void OnMouseCursorMoved(const MouseEvent_CursorHotspotChanged& event);
+        void OnMouseButtonInteract(const MouseEvent_ButtonInteraction& event);
+
     private:
+        void SwapLoadedScene();
+
         bool m_isInitialized = false;
         AppSpec m_appSpec = {};
 
         TimeWatch m_timeWatch;
         SecondsF32 m_lastFrameSeconds = SecondsF32(0.0f);
 
-        Scoped<GLTFSceneImporter> m_sceneImporter;
+        Scoped<SceneLoader> m_sceneLoader;
+        Scoped<LoadedScene> m_loadedScene; // currently rendered one
         Scoped<Renderer> m_renderer;
+
+        // Statistics of frames, that were rendered while a scene was loading
+        uint32_t m_numLoadingFrames = 0;
+        float m_maxLoadingFrameMilliseconds = 0.0f;
     };
 
 }
\ No newline at end of file
@@ -57,10 +57,11 @@ namespace Neb
         return TRUE;
     }
 
-    BOOL Renderer::InitSceneContext(Scene* scene)
+    BOOL Renderer::InitSceneContext(Scene* scene, nri::GIProcessedScene* giScene)
     {
         NEB_ASSERT(scene, "Invalid scene!");
         m_scene = scene;
+        m_giScene = giScene;
 
         //nri::ThrowIfFalse(m_raytracer.Init(&m_swapchain), "Failed to init scene context for ray tracing");
 
@@ -102,6 +103,7 @@ namespace Neb
                 {
                     m_deferredRenderer.BeginFrame(DeferredRenderer::RenderInfo{
                         .scene = m_scene,
+                        .giScene = m_giScene,
                         .commandList = GetCommandList(),
                         .backbufferIndex = backbufferIndex,
                         .frameIndex = GetFrameIndex(),
@@ -151,6 +153,31 @@ namespace Neb
         m_swapchain.Present(FALSE);
     }
 
+    void Renderer::RenderLoadingFrame()
+    {
+        UINT backbufferIndex = NextFrame();
+
+        nri::UiContext::Get()->BeginFrame();
+        ExecuteCommandList(nri::eCommandContextType_Graphics, backbufferIndex,
+            [this, backbufferIndex]
+            {
+                ID3D12GraphicsCommandList4* commandList = GetCommandList();
+                ID3D12Resource* backbuffer = m_swapchain.GetBackbuffer(backbufferIndex);
+
+                static constexpr FLOAT ClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(backbuffer, D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_RENDER_TARGET);
+                commandList->ResourceBarrier(1, &barrier);
+                commandList->ClearRenderTargetView(m_swapchain.GetCurrentBackbufferRtvHandle(), ClearColor, 0, nullptr);
+                barrier = CD3DX12_RESOURCE_BARRIER::Transition(backbuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COMMON);
+                commandList->ResourceBarrier(1, &barrier);
+
+                nri::UiContext::Get()->EndFrame();
+                nri::UiContext::Get()->SubmitCommands(backbufferIndex, commandList, &m_swapchain);
+            });
+
+        m_swapchain.Present(FALSE);
+    }
+
     void Renderer::RenderScene(float timestep)
     {
         //if (!m_scene)
@@ -29,9 +29,13 @@ namespace Neb
         ~Renderer();
 
         BOOL Init(HWND hwnd);
-        BOOL InitSceneContext(Scene* scene);
+        // giScene is optional, prebuilt for the scene on the loader thread (see SceneLoader). Waits for the GPU to be idle,
+        // thus resources of the previous scene can be released right after the call
+        BOOL InitSceneContext(Scene* scene, nri::GIProcessedScene* giScene = nullptr);
+        bool HasSceneContext() const { return m_scene != nullptr; }
 
         void RenderSceneDeferred(float timestep);
+        void RenderLoadingFrame(); // only clears the backbuffer and draws UI, used while there is no scene
 
         [[deprecated("not used anymore")]] void RenderScene(float timestep);
         [[deprecated("not used anymore")]] void RenderSceneRaytraced(float timestep);
@@ -73,6 +77,7 @@ namespace Neb
 
         HWND m_hwnd = nullptr;
         Scene* m_scene = nullptr;
+        nri::GIProcessedScene* m_giScene = nullptr;
         UINT m_frameIndex = 0;
 
         nri::Swapchain m_swapchain;
@@ -36,6 +36,30 @@ namespace Neb
         return false;
     }
 
+    void SVGFDenoiser::SetTransientVariance(ID3D12Resource* variance)
+    {
+        NEB_ASSERT(IsInitialized());
+        nri::NRIDevice& device = nri::NRIDevice::Get();
+
+        m_variance = variance;
+
+        // 0 srv, 1 uav (only 1 resource, no ping-pong)
+        const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {
+            .Format = m_varianceFormat,
+            .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+            .Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+            .Texture2D = { .MostDetailedMip = 0, .MipLevels = 1 }
+        };
+        const D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {
+            .Format = m_varianceFormat,
+            .ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D,
+            .Texture2D = { .MipSlice = 0, .PlaneSlice = 0 }
+        };
+        m_varianceSrvUavHeap = device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).AllocateDescriptors(2);
+        device.GetD3D12Device()->CreateShaderResourceView(m_variance, &srvDesc, m_varianceSrvUavHeap.CpuAt(0));
+        device.GetD3D12Device()->CreateUnorderedAccessView(m_variance, nullptr, &uavDesc, m_varianceSrvUavHeap.CpuAt(1));
+    }
+
     void SVGFDenoiser::BeginFrame(UINT frameIndex)
     {
         m_currentIndex = frameIndex & 1;
@@ -48,19 +72,7 @@ namespace Neb
 
     void SVGFDenoiser::ResetHistory(ID3D12GraphicsCommandList4* commandList)
     {
-        std::array barriers = {
-            CD3DX12_RESOURCE_BARRIER::Transition(GetHistoryRadianceTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_DEST),
-            CD3DX12_RESOURCE_BARRIER::Transition(GetCurrentRadianceTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_COPY_SOURCE),
-        };
-        commandList->ResourceBarrier(UINT(barriers.size()), barriers.data());
-        {
-            commandList->CopyResource(GetHistoryRadianceTexture(), GetCurrentRadianceTexture());
-        }
-        barriers = {
-            CD3DX12_RESOURCE_BARRIER::Transition(GetHistoryRadianceTexture(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COMMON),
-            CD3DX12_RESOURCE_BARRIER::Transition(GetCurrentRadianceTexture(), D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COMMON),
-        };
-        commandList->ResourceBarrier(UINT(barriers.size()), barriers.data());
+        commandList->CopyResource(GetHistoryRadianceTexture(), GetCurrentRadianceTexture());
     }
 
     void SVGFDenoiser::SubmitTemporalAccumulation(ID3D12GraphicsCommandList4* commandList)
@@ -73,22 +85,6 @@ namespace Neb
         {
             m_temporalConstants.resolution[0] = width;
             m_temporalConstants.resolution[1] = height;
-            
-            // Pre-barriers
-            {
-                std::array barriers = {
-                    // CD3DX12_RESOURCE_BARRIER::UAV(GetRadianceOutput() /*same as svgf.GetCurrentRadianceTexture()*/),
-                    // transition current radiance & history radiance
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetHistoryRadianceTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetCurrentRadianceTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-                    //  Depth & History depth will already be in SRV state from previous passes
-                    //  Normals will also be in SRV state as they are read in pathtracer beforehand
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetCurrentMomentsTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetHistoryMomentsTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetVarianceTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-                };
-                commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-            }
 
             commandList->SetPipelineState(m_svgfTemporalPSO.Get());
             commandList->SetComputeRootSignature(m_svgfTemporalRS.GetD3D12RootSignature());
@@ -114,91 +110,44 @@ namespace Neb
             commandList->SetComputeRootDescriptorTable(SVGF_TEMPORAL_ROOT_MOMENT_CURRENT_UAV, GetCurrentMomentUav());
             commandList->SetComputeRootDescriptorTable(SVGF_TEMPORAL_ROOT_VARIANCE_UAV, GetVarianceUav());
             commandList->Dispatch(width / 8, height / 8, 1);
-            // Post-SVGF barriers
-            {
-                std::array barriers = {
-                    //CD3DX12_RESOURCE_BARRIER::UAV(GetCurrentRadianceTexture()),
-                    // Transition resources unused in A-Trous to their final state
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetHistoryRadianceTexture(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetHistoryMomentsTexture(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetCurrentMomentsTexture(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetCurrentRadianceTexture(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON),
-                    CD3DX12_RESOURCE_BARRIER::Transition(GetVarianceTexture(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON),
-                };
-                commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-            }
         }
     }
 
-    void SVGFDenoiser::SubmitATrousComputeWavelet(ID3D12GraphicsCommandList4* commandList)
+    void SVGFDenoiser::SubmitATrousComputeWavelet(ID3D12GraphicsCommandList4* commandList, uint32_t pass)
     {
         NEB_ASSERT(IsInitialized());
-        NEB_PIX_SCOPED_EVENT(commandList, "SVGF: A-Trous Wavelet");
+        NEB_ASSERT(pass < NumAtrousPasses, "SVGF has {} A-Trous passes", NumAtrousPasses);
+
+        const uint32_t step = 1u << pass;
+        NEB_PIX_SCOPED_EVENT(commandList, "SVGF: A-Trous compute {} (step {})", pass, step);
 
         UINT width = m_width;
         UINT height = m_height;
         {
-            static constexpr float kSigmaColor = 4.0f / 255.0f;
-            static constexpr float kSigmaNormal = 128.0f;
-            static constexpr float kSigmaDepth = 0.002f; // 2 mm eye-space
-            uint32_t step = 1;
-
-            uint32_t srcIndex = GetCurrentResourceIndex();
-            uint32_t dstIndex = GetHistoryResourceIndex();
-            {
-                auto varianceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(GetVarianceTexture(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
-                commandList->ResourceBarrier(1, &varianceBarrier);
-            }
-
-            for (uint32_t i = 0; i < NumAtrousPasses; ++i)
-            {
-                NEB_PIX_SCOPED_EVENT(commandList, "SVGF: A-Trous compute {} (step {})", i, step);
-                
-                // only change non-tweakable params. Tweakable ones are defined via UI
-                m_aTrousConstants.resolution[0] = width;
-                m_aTrousConstants.resolution[1] = height;
-                m_aTrousConstants.step = static_cast<float>(step);
-                // at the beginning of each loop transition radiance src/uav resources to the correct state
-                {
-                    std::array barriers = {
-                        CD3DX12_RESOURCE_BARRIER::UAV(GetRadianceTexture(srcIndex)),
-                        CD3DX12_RESOURCE_BARRIER::Transition(GetRadianceTexture(srcIndex), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
-                        CD3DX12_RESOURCE_BARRIER::Transition(GetRadianceTexture(dstIndex), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
-                    };
-                    commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-                }
-                commandList->SetPipelineState(m_svgfATrousPSO.Get());
-                commandList->SetComputeRootSignature(m_svgfATrousRS.GetD3D12RootSignature());
-                // SVGF_ATROUS_ROOT_CONSTANTS = 0,
-                // SVGF_ATROUS_ROOT_RADIANCE_SRV,
-                // SVGF_ATROUS_ROOT_VARIANCE_SRV,
-                // SVGF_ATROUS_ROOT_DEPTH_SRV,
-                // SVGF_ATROUS_ROOT_NORMAL_SRV,
-                // SVGF_ATROUS_ROOT_OUTPUT,
-                // SVGF_ATROUS_ROOT_NUM_ROOTS,
-                commandList->SetComputeRoot32BitConstants(SVGF_ATROUS_ROOT_CONSTANTS, sizeof(SVGFAtrousConstants) / sizeof(UINT), &m_aTrousConstants, 0);
-                commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_RADIANCE_SRV, GetRadianceSrv(srcIndex));
-                commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_VARIANCE_SRV, GetVarianceSrv());
-                commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_DEPTH_SRV, GetCurrentDepthSrv());
-                commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_NORMAL_SRV, GetCurrentNormalSrv());
-                commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_OUTPUT, GetRadianceUav(dstIndex));
-                commandList->Dispatch(width / 8, height / 8, 1);
-                {
-                    std::array barriers = {
-                        CD3DX12_RESOURCE_BARRIER::UAV(GetRadianceTexture(srcIndex)),
-                        CD3DX12_RESOURCE_BARRIER::Transition(GetRadianceTexture(srcIndex), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON),
-                        CD3DX12_RESOURCE_BARRIER::Transition(GetRadianceTexture(dstIndex), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COMMON),
-                    };
-                    commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
-                }
-                step <<= 1;
-                std::swap(srcIndex, dstIndex);
-            }
-            NEB_ASSERT(srcIndex == GetCurrentResourceIndex());
-            {
-                auto varianceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(GetVarianceTexture(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COMMON);
-                commandList->ResourceBarrier(1, &varianceBarrier);
-            }
+            const uint32_t srcIndex = GetATrousInputIndex(pass);
+            const uint32_t dstIndex = srcIndex ^ 1;
+
+            // only change non-tweakable params. Tweakable ones are defined via UI
+            m_aTrousConstants.resolution[0] = width;
+            m_aTrousConstants.resolution[1] = height;
+            m_aTrousConstants.step = static_cast<float>(step);
+
+            commandList->SetPipelineState(m_svgfATrousPSO.Get());
+            commandList->SetComputeRootSignature(m_svgfATrousRS.GetD3D12RootSignature());
+            // SVGF_ATROUS_ROOT_CONSTANTS = 0,
+            // SVGF_ATROUS_ROOT_RADIANCE_SRV,
+            // SVGF_ATROUS_ROOT_VARIANCE_SRV,
+            // SVGF_ATROUS_ROOT_DEPTH_SRV,
+            // SVGF_ATROUS_ROOT_NORMAL_SRV,
+            // SVGF_ATROUS_ROOT_OUTPUT,
+            // SVGF_ATROUS_ROOT_NUM_ROOTS,
+            commandList->SetComputeRoot32BitConstants(SVGF_ATROUS_ROOT_CONSTANTS, sizeof(SVGFAtrousConstants) / sizeof(UINT), &m_aTrousConstants, 0);
+            commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_RADIANCE_SRV, GetRadianceSrv(srcIndex));
+            commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_VARIANCE_SRV, GetVarianceSrv());
+            commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_DEPTH_SRV, GetCurrentDepthSrv());
+            commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_NORMAL_SRV, GetCurrentNormalSrv());
+            commandList->SetComputeRootDescriptorTable(SVGF_ATROUS_ROOT_OUTPUT, GetRadianceUav(dstIndex));
+            commandList->Dispatch(width / 8, height / 8, 1);
         }
     }
 
@@ -351,11 +300,7 @@ namespace Neb
             m_moments[i] = CreateArrayResource(width, height, m_momentFormat, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, DXGI_FORMAT_UNKNOWN, 1);
             NEB_SET_HANDLE_NAME(m_moments[i], "Moments {}", i);
         }
-        m_variance = CreateArrayResource(width, height, m_varianceFormat, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, DXGI_FORMAT_UNKNOWN, 1);
-        NEB_SET_HANDLE_NAME(m_variance, "Variance texture");
-
-        m_denoisedOutput = CreateArrayResource(width, height, m_denoisedFormat, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, DXGI_FORMAT_UNKNOWN, 1);
-        NEB_SET_HANDLE_NAME(m_denoisedOutput, "SVGF-denoised output texture");
+        // Variance is placed by DeferredRenderer, see SetTransientVariance()
     }
 
     void SVGFDenoiser::InitSVGFDescriptors()
@@ -484,24 +429,6 @@ namespace Neb
             device.GetD3D12Device()->CreateShaderResourceView(GetMomentsTexture(i), &srvDesc, m_momentArraySrvUavHeap.CpuAt(FirstMomentSrvIndex + i));
             device.GetD3D12Device()->CreateUnorderedAccessView(GetMomentsTexture(i), nullptr, &uavDesc, m_momentArraySrvUavHeap.CpuAt(FirstMomentUavIndex + i));
         }
-
-        // 0 srv, 1 uav (only 1 resource, no ping-pong)
-        {
-            m_varianceSrvUavHeap = device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).AllocateDescriptors(2);
-            auto srvDesc = CreateSRV(m_varianceFormat);
-            auto uavDesc = CreateUAV(m_varianceFormat);
-            device.GetD3D12Device()->CreateShaderResourceView(GetVarianceTexture(), &srvDesc, m_varianceSrvUavHeap.CpuAt(0));
-            device.GetD3D12Device()->CreateUnorderedAccessView(GetVarianceTexture(), nullptr, &uavDesc, m_varianceSrvUavHeap.CpuAt(1));
-        }
-        
-        // 0 srv, 1 uav (only 1 resource, no ping-pong)
-        {
-            m_denoisedSrvUavHeap = device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV).AllocateDescriptors(2);
-            auto srvDesc = CreateSRV(m_denoisedFormat);
-            auto uavDesc = CreateUAV(m_denoisedFormat);
-            device.GetD3D12Device()->CreateShaderResourceView(GetDenoisedTexture(), &srvDesc, m_denoisedSrvUavHeap.CpuAt(0));
-            device.GetD3D12Device()->CreateUnorderedAccessView(GetDenoisedTexture(), nullptr, &uavDesc, m_denoisedSrvUavHeap.CpuAt(1));
-        }
     }
 
 } // Neb namespace
\ No newline at end of file
@@ -11,11 +11,18 @@ namespace Neb
     class SVGFDenoiser
     {
     public:
+        static constexpr uint32_t NumAtrousPasses = 4; // 1->8 px radius
+        static_assert(NumAtrousPasses % 2 == 0, "A-Trous passes should end in the current radiance");
+
         bool IsInitialized() const { return m_initialized; }
 
         bool Init(UINT width, UINT height);
         bool Resize(UINT width, UINT height);
 
+        // Variance never outlives SVGF passes, DeferredRenderer places it as a transient target over G-buffer memory.
+        // Its views are created here, after every placement
+        void SetTransientVariance(ID3D12Resource* variance);
+
         // This should be called to properly query gbuffer resources
         void BeginFrame(UINT frameIndex);
         void EndFrame();
@@ -34,8 +41,7 @@ namespace Neb
         ID3D12Resource* GetMomentsTexture(uint32_t index) const { return m_moments[index].Get(); }
         ID3D12Resource* GetCurrentMomentsTexture() const { return GetMomentsTexture(GetCurrentResourceIndex()); }
         ID3D12Resource* GetHistoryMomentsTexture() const { return GetMomentsTexture(GetHistoryResourceIndex()); }
-        ID3D12Resource* GetVarianceTexture() const { return m_variance.Get(); }
-        ID3D12Resource* GetDenoisedTexture() const { return m_denoisedOutput.Get(); }
+        ID3D12Resource* GetVarianceTexture() const { return m_variance; }
 
         D3D12_GPU_DESCRIPTOR_HANDLE GetRadianceUav(uint32_t index) const { return m_radianceSrvUavHeap.GpuAt(FirstRadianceUavIndex + index); }
         D3D12_GPU_DESCRIPTOR_HANDLE GetRadianceSrv(uint32_t index) const { return m_radianceSrvUavHeap.GpuAt(FirstRadianceSrvIndex + index); }
@@ -63,15 +69,20 @@ namespace Neb
         D3D12_GPU_DESCRIPTOR_HANDLE GetVarianceUav() const { return m_varianceSrvUavHeap.GpuAt(1); } // 0 srv, 1 uav (only 1 resource, no ping-pong)
         D3D12_GPU_DESCRIPTOR_HANDLE GetVarianceSrv() const { return m_varianceSrvUavHeap.GpuAt(0); } // 0 srv, 1 uav (only 1 resource, no ping-pong)
         
-        D3D12_GPU_DESCRIPTOR_HANDLE GetDenoisedUav() const { return m_denoisedSrvUavHeap.GpuAt(1); } // 0 srv, 1 uav (only 1 resource, no ping-pong)
-        D3D12_GPU_DESCRIPTOR_HANDLE GetDenoisedSrv() const { return m_denoisedSrvUavHeap.GpuAt(0); } // 0 srv, 1 uav (only 1 resource, no ping-pong)
-
         DXGI_FORMAT GetNormalFormat() const { return m_normalFormat; }
         DXGI_FORMAT GetRadianceFormat() const { return m_radianceFormat; }
+        DXGI_FORMAT GetVarianceFormat() const { return m_varianceFormat; }
+
+        // A-Trous passes ping-pong between both radiance textures, pass i reads radiance of GetATrousInputIndex(i) and writes the other one
+        uint32_t GetATrousInputIndex(uint32_t pass) const { return (pass % 2 == 0) ? GetCurrentResourceIndex() : GetHistoryResourceIndex(); }
 
+        // Passes do not transition resources, the caller does (see DeferredRenderer::BuildFrameGraph()).
+        // Copy of the current radiance into the history one, from COPY_SOURCE into COPY_DEST
         void ResetHistory(ID3D12GraphicsCommandList4* commandList);
+        // Accumulates the current radiance (UAV) with its history (SRV) and writes current moments and variance (UAV)
         void SubmitTemporalAccumulation(ID3D12GraphicsCommandList4* commandList);
-        void SubmitATrousComputeWavelet(ID3D12GraphicsCommandList4* commandList);
+        // Filters radiance of GetATrousInputIndex(pass) (SRV) with variance (SRV) into the other one (UAV)
+        void SubmitATrousComputeWavelet(ID3D12GraphicsCommandList4* commandList, uint32_t pass);
 
         struct SVGFTemporalConstants
         {
@@ -144,8 +155,7 @@ namespace Neb
         nri::Rc<ID3D12Resource> m_depths;           // Resources are created as 2D textures with 2 slices
         nri::Rc<ID3D12Resource> m_normals;          // Resources are created as 2D textures with 2 slices
         nri::Rc<ID3D12Resource> m_moments[NumPingPongResources]; // For some reason SRV/UAV on different slices upsets the compiler
-        nri::Rc<ID3D12Resource> m_variance;
-        nri::Rc<ID3D12Resource> m_denoisedOutput;
+        ID3D12Resource* m_variance = nullptr;       // transient target of DeferredRenderer, see SetTransientVariance()
 
         // A-Trous output index shows which image in m_svgfATrousTargets is a denoised output image
         uint32_t m_aTrousOutputIndex;
@@ -165,7 +175,6 @@ namespace Neb
         DXGI_FORMAT m_radianceFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
         DXGI_FORMAT m_momentFormat = DXGI_FORMAT_R16G16_FLOAT; // m1, m2
         DXGI_FORMAT m_varianceFormat = DXGI_FORMAT_R16_FLOAT;
-        DXGI_FORMAT m_denoisedFormat = m_radianceFormat; // same as radiance format
 
         static constexpr uint32_t FirstRadianceSrvIndex = 0;
         static constexpr uint32_t FirstRadianceUavIndex = FirstRadianceSrvIndex + NumPingPongResources;
@@ -180,7 +189,6 @@ namespace Neb
         static constexpr uint32_t FirstMomentUavIndex = FirstMomentSrvIndex + NumPingPongResources;
         nri::DescriptorHeapAllocation m_momentArraySrvUavHeap;
         nri::DescriptorHeapAllocation m_varianceSrvUavHeap; // 0 srv, 1 uav (only 1 resource, no ping-pong)
-        nri::DescriptorHeapAllocation m_denoisedSrvUavHeap;
 
         SVGFTemporalConstants m_temporalConstants;
         // Texture2D<float3> t_RadianceSample  : register(t0, space0);
@@ -195,9 +203,7 @@ namespace Neb
         // RWTexture2D<float2> t_Moment   : register(u1, space0);
         // RWTexture2D<float>  t_Variance : register(u2, space0);
         nri::DescriptorHeapAllocation m_svgfTemporalUavHeap;
-        
-        static constexpr uint32_t NumAtrousPasses = 4; // 1->8 px radius
-        
+
         SVGFAtrousConstants m_aTrousConstants;
         // Texture2D<float3> t_Radiance   : register(t0, space0);
         // Texture2D<float>  t_Variance   : register(t1, space0);
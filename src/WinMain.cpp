@@ -295,6 +295,18 @@ int32_t main(int argc, char* argv[])
     Neb::Config::SetValue(Neb::EConfigKey::EnableGpuValidation,     argParser.Get<bool>(/*key*/ "enable-gpu-validation",    /*default-value*/ true));
     Neb::Config::SetValue(Neb::EConfigKey::EnableDeviceDebugging,   argParser.Get<bool>(/*key*/ "enable-device-debug",      /*default-value*/ true));
     Neb::Config::SetValue(Neb::EConfigKey::EnableNvDriver,          argParser.Get<bool>(/*key*/ "enable-nv-driver",         /*default-value*/ true));
+    Neb::Config::SetValue(Neb::EConfigKey::EnableSceneCache,        argParser.Get<bool>(/*key*/ "enable-scene-cache",       /*default-value*/ true));
+    Neb::Config::SetValue(Neb::EConfigKey::NumWorkerThreads,        argParser.Get<int32_t>(/*key*/ "num-worker-threads",    /*default-value*/ 0));
+    Neb::Config::SetValue(Neb::EConfigKey::OptimizeMeshes,          argParser.Get<bool>(/*key*/ "optimize-meshes",          /*default-value*/ false));
+    Neb::Config::SetValue(Neb::EConfigKey::BuildMeshlets,           argParser.Get<bool>(/*key*/ "build-meshlets",           /*default-value*/ false));
+    Neb::Config::SetValue(Neb::EConfigKey::BuildMeshLods,           argParser.Get<bool>(/*key*/ "build-mesh-lods",          /*default-value*/ false));
+    Neb::Config::SetValue(Neb::EConfigKey::CompactVertexFormat,     argParser.Get<bool>(/*key*/ "compact-vertex-format",    /*default-value*/ false));
+    Neb::Config::SetValue(Neb::EConfigKey::GenerateMipmaps,         argParser.Get<bool>(/*key*/ "generate-mipmaps",         /*default-value*/ true));
+    Neb::Config::SetValue(Neb::EConfigKey::CompressTextures,        argParser.Get<bool>(/*key*/ "compress-textures",        /*default-value*/ false));
+    Neb::Config::SetValue(Neb::EConfigKey::TextureCompressionQuality, argParser.Get<int32_t>(/*key*/ "texture-compression-quality", /*default-value*/ 1));
+    Neb::Config::SetValue(Neb::EConfigKey::UploadRingSizeMb,        argParser.Get<int32_t>(/*key*/ "upload-ring-size-mb",   /*default-value*/ 64));
+    Neb::Config::SetValue(Neb::EConfigKey::OcclusionCulling,        argParser.Get<bool>(/*key*/ "occlusion-culling",        /*default-value*/ false));
+    Neb::Config::SetValue(Neb::EConfigKey::FrameUploadRingSizeMb,   argParser.Get<int32_t>(/*key*/ "frame-upload-ring-size-mb", /*default-value*/ 32));
     /* clang-format on */
 
     constexpr const char* lpClassName = "DXRNebulae";
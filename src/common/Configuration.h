@@ -3,6 +3,7 @@
 #include <variant>
 #include <array>
 #include <optional>
+#include <cstdint>
 
 namespace Neb
 {
@@ -13,6 +14,18 @@ namespace Neb
         EnableGpuValidation,    // Debug layer MUST be enabled for this!
         EnableDeviceDebugging,  // Debug layer MUST be enabled for this!
         EnableNvDriver,
+        EnableSceneCache,       // Use (and bake on cold import) .nebscene caches next to glTF files
+        NumWorkerThreads,       // Threads used by ThreadPool including the calling one, 0 to use all hardware threads
+        OptimizeMeshes,         // Reorder triangles and vertices of imported meshes for post-transform cache and vertex fetch
+        BuildMeshlets,          // Build meshlets with culling bounds for every imported submesh
+        BuildMeshLods,          // Build discrete LOD chains with quadric simplification for every imported submesh
+        CompactVertexFormat,    // Store imported vertices quantized (20 bytes instead of 48), see VertexCompression.h
+        GenerateMipmaps,        // Generate full mip chains of imported images on the CPU
+        CompressTextures,       // Block compress imported images (BC1/BC4/BC5/BC7 depending on the material slots), see TextureCompression.h
+        TextureCompressionQuality, // 0 - fast, 1 - normal, 2 - high, see ETextureCompressionQuality
+        UploadRingSizeMb,       // Size of the staging ring of nri::UploadService, uploads are split into chunks of a quarter of it
+        OcclusionCulling,       // Build occluders of imported meshes and cull G-buffer draws with the software rasterizer, see OcclusionCulling.h
+        FrameUploadRingSizeMb,  // Size of the ring of nri::FrameUploadAllocator, that holds per-draw constants of every frame in flight
         NumConfigKeys
     };
 
@@ -23,6 +36,10 @@ namespace Neb
             : m_val(value)
         {
         }
+        ConfigValue(int32_t value)
+            : m_val(value)
+        {
+        }
 
         template<typename T>
         T Get() const { return std::get<T>(m_val); }
@@ -31,7 +48,7 @@ namespace Neb
         T Get(T defaultValue) const { return std::holds_alternative<std::monostate>(m_val) ? defaultValue : Get<T>(); }
 
     private:
-        std::variant<std::monostate, bool> m_val;
+        std::variant<std::monostate, bool, int32_t> m_val;
     };
 
     class Config
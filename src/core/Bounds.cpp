@@ -0,0 +1,139 @@
+#include "Bounds.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Neb
+{
+
+    namespace
+    {
+        Vec3 LoadPosition(const std::byte* positions, uint32_t positionsStride, uint32_t index)
+        {
+            Vec3 position;
+            std::memcpy(&position.x, positions + size_t(index) * positionsStride, sizeof(float) * 3);
+            return position;
+        }
+
+        uint32_t FindFarthestPosition(const std::byte* positions, uint32_t positionsStride, uint32_t numVertices, const Vec3& from)
+        {
+            uint32_t farthest = 0;
+            float farthestDistanceSq = -1.0f;
+            for (uint32_t i = 0; i < numVertices; ++i)
+            {
+                const float distanceSq = Vec3::DistanceSquared(LoadPosition(positions, positionsStride, i), from);
+                if (distanceSq > farthestDistanceSq)
+                {
+                    farthest = i;
+                    farthestDistanceSq = distanceSq;
+                }
+            }
+            return farthest;
+        }
+    } // anonymous namespace
+
+    void ComputeBounds(const std::byte* positions, uint32_t positionsStride, uint32_t numVertices, AABB& box, Sphere& sphere)
+    {
+        box = AABB();
+        sphere = Sphere();
+        if (!positions || numVertices == 0)
+            return;
+
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const Vec3 position = LoadPosition(positions, positionsStride, i);
+            box.min = Vec3::Min(box.min, position);
+            box.max = Vec3::Max(box.max, position);
+        }
+
+        const Vec3 boxCenter = (box.min + box.max) * 0.5f;
+        float boxRadiusSq = 0.0f;
+        for (uint32_t i = 0; i < numVertices; ++i)
+            boxRadiusSq = std::max(boxRadiusSq, Vec3::DistanceSquared(LoadPosition(positions, positionsStride, i), boxCenter));
+
+        // Ritter's sphere. Starts with the sphere around two (approximately) most distant points and grows it to every point outside
+        const Vec3 a = LoadPosition(positions, positionsStride, FindFarthestPosition(positions, positionsStride, numVertices, LoadPosition(positions, positionsStride, 0)));
+        const Vec3 b = LoadPosition(positions, positionsStride, FindFarthestPosition(positions, positionsStride, numVertices, a));
+
+        Vec3 center = (a + b) * 0.5f;
+        float radius = Vec3::Distance(a, b) * 0.5f;
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const Vec3 position = LoadPosition(positions, positionsStride, i);
+            const float distance = Vec3::Distance(position, center);
+            if (distance > radius)
+            {
+                const float grownRadius = (radius + distance) * 0.5f;
+                center += (position - center) * ((grownRadius - radius) / distance);
+                radius = grownRadius;
+            }
+        }
+
+        const float boxRadius = std::sqrt(boxRadiusSq);
+        sphere = (radius < boxRadius) ? Sphere{ .center = center, .radius = radius } : Sphere{ .center = boxCenter, .radius = boxRadius };
+    }
+
+    AABB TransformAABBFast(const AABB& box, const Mat4& transform)
+    {
+        using namespace DirectX;
+
+        if (IsEmptyAABB(box))
+            return AABB();
+
+        const XMMATRIX m = XMLoadFloat4x4(&transform);
+        const XMVECTOR boxMin = XMLoadFloat3(&box.min);
+        const XMVECTOR extent = XMVectorSubtract(XMLoadFloat3(&box.max), boxMin);
+
+        // Every corner is boxMin plus a subset of the box edges, and so are transformed corners with transformed edges
+        const XMVECTOR edgeX = XMVectorMultiply(XMVectorSplatX(extent), m.r[0]);
+        const XMVECTOR edgeY = XMVectorMultiply(XMVectorSplatY(extent), m.r[1]);
+        const XMVECTOR edgeZ = XMVectorMultiply(XMVectorSplatZ(extent), m.r[2]);
+
+        const XMVECTOR c0 = XMVector3Transform(boxMin, m);
+        const XMVECTOR c1 = XMVectorAdd(c0, edgeX);
+        const XMVECTOR c2 = XMVectorAdd(c0, edgeY);
+        const XMVECTOR c3 = XMVectorAdd(c1, edgeY);
+        const XMVECTOR c4 = XMVectorAdd(c0, edgeZ);
+        const XMVECTOR c5 = XMVectorAdd(c1, edgeZ);
+        const XMVECTOR c6 = XMVectorAdd(c2, edgeZ);
+        const XMVECTOR c7 = XMVectorAdd(c3, edgeZ);
+
+        const XMVECTOR min = XMVectorMin(XMVectorMin(XMVectorMin(c0, c1), XMVectorMin(c2, c3)), XMVectorMin(XMVectorMin(c4, c5), XMVectorMin(c6, c7)));
+        const XMVECTOR max = XMVectorMax(XMVectorMax(XMVectorMax(c0, c1), XMVectorMax(c2, c3)), XMVectorMax(XMVectorMax(c4, c5), XMVectorMax(c6, c7)));
+
+        AABB result;
+        XMStoreFloat3(&result.min, min);
+        XMStoreFloat3(&result.max, max);
+        return result;
+    }
+
+    void TransformAABBs(std::span<AABB> dst, std::span<const AABB> boxes, std::span<const Mat4> transforms, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(dst.size() == boxes.size() && boxes.size() == transforms.size(), "Every box should have its transform and destination");
+
+        static constexpr size_t GrainSize = 16384;
+        threadPool.ParallelForRange(boxes.size(), GrainSize, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    dst[i] = TransformAABBFast(boxes[i], transforms[i]);
+            });
+    }
+
+    Sphere TransformSphere(const Sphere& sphere, const Mat4& transform)
+    {
+        const float scaleSq = std::max({
+            Vec3(transform._11, transform._12, transform._13).LengthSquared(),
+            Vec3(transform._21, transform._22, transform._23).LengthSquared(),
+            Vec3(transform._31, transform._32, transform._33).LengthSquared() });
+
+        return Sphere{
+            .center = Vec3::Transform(sphere.center, transform),
+            .radius = sphere.radius * std::sqrt(scaleSq),
+        };
+    }
+
+} // Neb namespace
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Math.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    struct Sphere
+    {
+        Vec3 center = Vec3(0.0f);
+        float radius = 0.0f;
+    };
+
+    inline bool IsEmptyAABB(const AABB& box) { return box.min.x > box.max.x || box.min.y > box.max.y || box.min.z > box.max.z; }
+
+    // Tight box and sphere of float3 positions (may be strided). The sphere is the smaller one of Ritter's sphere
+    // and the sphere around the center of the box
+    void ComputeBounds(const std::byte* positions, uint32_t positionsStride, uint32_t numVertices, AABB& box, Sphere& sphere);
+
+    // Same result as TransformAABB() (all 8 corners are transformed), but with DirectXMath. The first corner is transformed
+    // by the matrix, every other corner is built from it by adding scaled rows of the matrix. Transform should be affine
+    AABB TransformAABBFast(const AABB& box, const Mat4& transform);
+
+    // dst[i] = TransformAABBFast(boxes[i], transforms[i])
+    void TransformAABBs(std::span<AABB> dst, std::span<const AABB> boxes, std::span<const Mat4> transforms, ThreadPool& threadPool);
+
+    // Radius is scaled by the largest scale of the transform
+    Sphere TransformSphere(const Sphere& sphere, const Mat4& transform);
+
+} // Neb namespace
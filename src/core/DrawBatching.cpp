@@ -0,0 +1,83 @@
+#include "DrawBatching.h"
+
+#include "../common/Assert.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Neb
+{
+
+    DrawBatchStats DrawBatcher::Build(std::span<const uint64_t> stateKeys, uint32_t maxDrawsPerBatch)
+    {
+        NEB_ASSERT(maxDrawsPerBatch > 0, "Batches should hold at least a single draw");
+
+        const uint32_t numDraws = static_cast<uint32_t>(stateKeys.size());
+        DrawBatchStats stats = DrawBatchStats{ .NumDraws = numDraws };
+        m_batches.clear();
+        m_order.resize(numDraws);
+
+        // Draws of the same state are already next to each other, order does not change
+        if (std::ranges::is_sorted(stateKeys))
+        {
+            std::iota(m_order.begin(), m_order.end(), 0);
+            for (uint32_t first = 0; first < numDraws;)
+            {
+                uint32_t last = first + 1;
+                while (last < numDraws && stateKeys[last] == stateKeys[first])
+                    ++last;
+
+                AddBatches(first, last - first, maxDrawsPerBatch, stats);
+                first = last;
+            }
+            return stats;
+        }
+
+        // Buckets are numbered in the order their first draws appear, then draws are scattered to offsets of their buckets
+        m_bucketIndices.clear();
+        m_bucketOffsets.clear();
+        m_drawBuckets.resize(numDraws);
+        for (uint32_t i = 0; i < numDraws; ++i)
+        {
+            const auto [it, isInserted] = m_bucketIndices.try_emplace(stateKeys[i], static_cast<uint32_t>(m_bucketOffsets.size()));
+            if (isInserted)
+                m_bucketOffsets.push_back(0);
+
+            m_drawBuckets[i] = it->second;
+            ++m_bucketOffsets[it->second];
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& bucketOffset : m_bucketOffsets)
+        {
+            const uint32_t numInBucket = bucketOffset;
+            bucketOffset = offset;
+            offset += numInBucket;
+        }
+
+        for (uint32_t bucket = 0; bucket < m_bucketOffsets.size(); ++bucket)
+        {
+            const uint32_t end = (bucket + 1 < m_bucketOffsets.size()) ? m_bucketOffsets[bucket + 1] : numDraws;
+            AddBatches(m_bucketOffsets[bucket], end - m_bucketOffsets[bucket], maxDrawsPerBatch, stats);
+        }
+
+        for (uint32_t i = 0; i < numDraws; ++i)
+            m_order[m_bucketOffsets[m_drawBuckets[i]]++] = i;
+
+        return stats;
+    }
+
+    void DrawBatcher::AddBatches(uint32_t firstDraw, uint32_t numDraws, uint32_t maxDrawsPerBatch, DrawBatchStats& stats)
+    {
+        for (uint32_t offset = 0; offset < numDraws; offset += maxDrawsPerBatch)
+        {
+            const uint32_t numBatchDraws = std::min(maxDrawsPerBatch, numDraws - offset);
+            m_batches.push_back(DrawBatch{ .FirstDraw = firstDraw + offset, .NumDraws = numBatchDraws });
+
+            ++stats.NumBatches;
+            stats.NumInstancedBatches += (numBatchDraws > 1) ? 1 : 0;
+            stats.MaxBatchSize = std::max(stats.MaxBatchSize, numBatchDraws);
+        }
+    }
+
+} // Neb namespace
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace Neb
+{
+
+    // Draws of the same state, that are drawn with a single instanced draw. Draws of a batch follow each other in the compacted
+    // order of DrawBatcher, thus FirstDraw is also the first instance of the batch in per-instance data of the frame
+    struct DrawBatch
+    {
+        uint32_t FirstDraw = 0;
+        uint32_t NumDraws = 0;
+    };
+
+    struct DrawBatchStats
+    {
+        uint32_t NumDraws = 0;
+        uint32_t NumBatches = 0;          // draw calls
+        uint32_t NumInstancedBatches = 0; // of more than a single draw
+        uint32_t MaxBatchSize = 0;
+    };
+
+    // Buckets draws with equal state keys into batches. Draws are compacted so that draws of a batch follow each other in their
+    // relative order, batches follow in the order of the first draw of their state. Keys that are sorted already (see nri::DrawPacketSorter)
+    // only need a linear scan, otherwise draws are bucketed by a hash map first. Batches larger than maxDrawsPerBatch are split,
+    // thus maxDrawsPerBatch of 1 draws everything one by one
+    class DrawBatcher
+    {
+    public:
+        DrawBatchStats Build(std::span<const uint64_t> stateKeys, uint32_t maxDrawsPerBatch);
+
+        std::span<const DrawBatch> GetBatches() const { return m_batches; }
+
+        // Compacted order, i-th draw of batches is draw order[i] of state keys
+        std::span<const uint32_t> GetOrder() const { return m_order; }
+
+    private:
+        void AddBatches(uint32_t firstDraw, uint32_t numDraws, uint32_t maxDrawsPerBatch, DrawBatchStats& stats);
+
+        std::vector<DrawBatch> m_batches;
+        std::vector<uint32_t> m_order;
+
+        // Scratch of unsorted keys, kept between frames
+        std::unordered_map<uint64_t, uint32_t> m_bucketIndices;
+        std::vector<uint32_t> m_drawBuckets;
+        std::vector<uint32_t> m_bucketOffsets;
+    };
+
+} // Neb namespace
@@ -0,0 +1,86 @@
+#include "FrameRing.h"
+
+#include "../common/Assert.h"
+#include "../util/Memory.h"
+
+namespace Neb
+{
+
+    FrameRing::FrameRing(uint64_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    uint64_t FrameRing::GetAllocationBegin(uint64_t numBytes, uint64_t alignment) const
+    {
+        NEB_CHECK_POW2_ALIGNMENT(alignment);
+        NEB_ASSERT(m_capacity % alignment == 0, "Ring capacity {} is not a multiple of alignment {}", m_capacity, alignment);
+
+        // Allocations never wrap, if it does not fit before the end of the ring it starts from the beginning
+        const uint64_t begin = AlignUp(m_head, alignment);
+        const uint64_t physicalBegin = begin % m_capacity;
+        return (physicalBegin + numBytes > m_capacity) ? begin + (m_capacity - physicalBegin) : begin;
+    }
+
+    uint64_t FrameRing::Allocate(uint64_t numBytes, uint64_t alignment)
+    {
+        if (numBytes == 0 || numBytes > m_capacity)
+            return InvalidOffset;
+
+        const uint64_t begin = GetAllocationBegin(numBytes, alignment);
+        const uint64_t end = begin + numBytes;
+        if (end - m_tail > m_capacity)
+            return InvalidOffset;
+
+        m_head = end;
+        return begin % m_capacity;
+    }
+
+    void FrameRing::EndFrame(uint64_t fenceValue)
+    {
+        NEB_ASSERT(fenceValue > 0, "Fence value 0 is reserved, as it is always completed");
+        NEB_ASSERT(m_frames.empty() || m_frames.back().FenceValue <= fenceValue, "Fence values of the ring should not decrease");
+
+        // Empty frames are kept as well, so that frames in flight match submitted ones
+        m_frames.push_back(Frame{ .End = m_head, .FenceValue = fenceValue });
+        m_frameBegin = m_head;
+    }
+
+    void FrameRing::Release(uint64_t completedFenceValue)
+    {
+        while (!m_frames.empty() && m_frames.front().FenceValue <= completedFenceValue)
+        {
+            m_tail = m_frames.front().End;
+            m_frames.pop_front();
+        }
+
+        // Empty ring starts over, so that skipped tail does not keep large allocations from fitting
+        if (m_frames.empty() && m_head == m_frameBegin)
+        {
+            m_head = 0;
+            m_tail = 0;
+            m_frameBegin = 0;
+        }
+    }
+
+    uint64_t FrameRing::GetFenceValueToAllocate(uint64_t numBytes, uint64_t alignment) const
+    {
+        if (numBytes == 0 || numBytes > m_capacity)
+            return UINT64_MAX;
+
+        // Releasing frames does not move the head, so the allocation begins at the same place no matter how many are released
+        const uint64_t end = GetAllocationBegin(numBytes, alignment) + numBytes;
+        if (end - m_tail <= m_capacity)
+            return 0;
+
+        for (const Frame& frame : m_frames)
+        {
+            if (end - frame.End <= m_capacity)
+                return frame.FenceValue;
+        }
+
+        // Only fits once the ring is empty and starts over, which is not going to happen while the open frame has allocations
+        return (!m_frames.empty() && m_head == m_frameBegin) ? m_frames.back().FenceValue : UINT64_MAX;
+    }
+
+} // Neb namespace
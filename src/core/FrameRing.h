@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+namespace Neb
+{
+
+    // CPU side of per-frame transient memory (constants of draws and alike), does not depend on D3D12
+    // (see nri::FrameUploadAllocator for the GPU side).
+    //
+    // Linear allocator over a ring of fixed capacity. Allocations of the open frame are bumped one after another and
+    // are released all at once, when the fence value the frame was closed with is completed. Same as StagingRing,
+    // offsets are never split across the end of the ring, the tail of the ring is skipped instead
+    class FrameRing
+    {
+    public:
+        static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+        FrameRing() = default;
+
+        // Capacity should be a multiple of every alignment that is going to be requested
+        explicit FrameRing(uint64_t capacity);
+
+        // Allocation belongs to the open frame. Returns InvalidOffset if there is not enough contiguous free space
+        uint64_t Allocate(uint64_t numBytes, uint64_t alignment);
+
+        // Closes the open frame, its allocations are released once fenceValue is completed. Fence values should not decrease and cannot be 0
+        void EndFrame(uint64_t fenceValue);
+
+        // Releases every closed frame, whose fence value is completed
+        void Release(uint64_t completedFenceValue);
+
+        // Fence value that has to be completed before the allocation fits, 0 if it fits already.
+        // UINT64_MAX if it does not fit even after every closed frame is released (together with the open frame it is larger than capacity)
+        uint64_t GetFenceValueToAllocate(uint64_t numBytes, uint64_t alignment) const;
+
+        uint64_t GetCapacity() const { return m_capacity; }
+        uint64_t GetNumUsedBytes() const { return m_head - m_tail; } // including skipped tails
+        uint64_t GetNumOpenFrameBytes() const { return m_head - m_frameBegin; }
+        uint32_t GetNumFramesInFlight() const { return static_cast<uint32_t>(m_frames.size()); }
+
+    private:
+        // Offsets are virtual and only ever grow, physical offset is virtual one modulo capacity
+        uint64_t GetAllocationBegin(uint64_t numBytes, uint64_t alignment) const;
+
+        struct Frame
+        {
+            uint64_t End = 0;
+            uint64_t FenceValue = 0;
+        };
+
+        uint64_t m_capacity = 0;
+        uint64_t m_head = 0;
+        uint64_t m_tail = 0;
+        uint64_t m_frameBegin = 0; // of the open frame
+        std::deque<Frame> m_frames;
+    };
+
+} // Neb namespace
@@ -0,0 +1,218 @@
+#include "FrustumCulling.h"
+
+#include "../common/Assert.h"
+#include "../common/TimeWatch.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <immintrin.h>
+
+namespace Neb
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+#if defined(__AVX2__)
+        using FloatV = __m256;
+        static constexpr uint32_t SimdWidth = 8;
+
+        FloatV SetV(float v) { return _mm256_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm256_loadu_ps(p); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        FloatV AndV(FloatV a, FloatV b) { return _mm256_and_ps(a, b); }
+        FloatV GreaterEqualV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        uint32_t MoveMaskV(FloatV mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+#else
+        // SSE2 is always there on x64
+        using FloatV = __m128;
+        static constexpr uint32_t SimdWidth = 4;
+
+        FloatV SetV(float v) { return _mm_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm_loadu_ps(p); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        FloatV AndV(FloatV a, FloatV b) { return _mm_and_ps(a, b); }
+        FloatV GreaterEqualV(FloatV a, FloatV b) { return _mm_cmpge_ps(a, b); }
+        uint32_t MoveMaskV(FloatV mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+#endif
+
+        Vec4 NormalizePlane(const Vec4& plane)
+        {
+            const float length = Vec3(plane.x, plane.y, plane.z).Length();
+            return (length > 0.0f) ? plane / length : plane;
+        }
+
+        // Both the scalar and the SIMD paths compute the distance in the same order, so they agree exactly
+        float GetPlaneDistance(const Vec4& plane, float x, float y, float z)
+        {
+            return plane.x * x + plane.y * y + plane.z * z + plane.w;
+        }
+    } // anonymous namespace
+
+    Frustum ExtractFrustum(const Mat4& viewProj)
+    {
+        // With row vectors clip = p * viewProj, so each clip coordinate is a dot product with a column of the matrix
+        const Vec4 column0 = Vec4(viewProj._11, viewProj._21, viewProj._31, viewProj._41);
+        const Vec4 column1 = Vec4(viewProj._12, viewProj._22, viewProj._32, viewProj._42);
+        const Vec4 column2 = Vec4(viewProj._13, viewProj._23, viewProj._33, viewProj._43);
+        const Vec4 column3 = Vec4(viewProj._14, viewProj._24, viewProj._34, viewProj._44);
+
+        Frustum frustum;
+        frustum.Planes[0] = NormalizePlane(column3 + column0); // -w <= x
+        frustum.Planes[1] = NormalizePlane(column3 - column0); // x <= w
+        frustum.Planes[2] = NormalizePlane(column3 + column1); // -w <= y
+        frustum.Planes[3] = NormalizePlane(column3 - column1); // y <= w
+        frustum.Planes[4] = NormalizePlane(column2);           // 0 <= z
+        frustum.Planes[5] = NormalizePlane(column3 - column2); // z <= w
+        return frustum;
+    }
+
+    bool IsAABBInFrustum(const Frustum& frustum, const AABB& box)
+    {
+        // The corner that is the farthest along the normal of a plane (p-vertex) is enough to tell if the box is behind it.
+        // Written as !(d >= 0), so that NaN distances of empty boxes are culled the same way as in FrustumCuller
+        for (const Vec4& plane : frustum.Planes)
+        {
+            const float x = (plane.x >= 0.0f) ? box.max.x : box.min.x;
+            const float y = (plane.y >= 0.0f) ? box.max.y : box.min.y;
+            const float z = (plane.z >= 0.0f) ? box.max.z : box.min.z;
+            if (!(GetPlaneDistance(plane, x, y, z) >= 0.0f))
+                return false;
+        }
+        return true;
+    }
+
+    void FrustumCuller::Resize(uint32_t numDraws)
+    {
+        const AABB emptyBox = AABB();
+        const size_t numPaddedDraws = (size_t(numDraws) + SimdWidth - 1) / SimdWidth * SimdWidth;
+
+        // Padding lanes are never written to the visible list, their values do not matter
+        m_minX.resize(numPaddedDraws, emptyBox.min.x);
+        m_minY.resize(numPaddedDraws, emptyBox.min.y);
+        m_minZ.resize(numPaddedDraws, emptyBox.min.z);
+        m_maxX.resize(numPaddedDraws, emptyBox.max.x);
+        m_maxY.resize(numPaddedDraws, emptyBox.max.y);
+        m_maxZ.resize(numPaddedDraws, emptyBox.max.z);
+
+        m_numDraws = numDraws;
+        m_visibleDraws.resize(numDraws);
+        m_numVisibleDraws = 0;
+    }
+
+    void FrustumCuller::SetBox(uint32_t drawIndex, const AABB& box)
+    {
+        NEB_ASSERT(drawIndex < m_numDraws, "Draw {} is out of range ({} draws)", drawIndex, m_numDraws);
+        m_minX[drawIndex] = box.min.x;
+        m_minY[drawIndex] = box.min.y;
+        m_minZ[drawIndex] = box.min.z;
+        m_maxX[drawIndex] = box.max.x;
+        m_maxY[drawIndex] = box.max.y;
+        m_maxZ[drawIndex] = box.max.z;
+    }
+
+    AABB FrustumCuller::GetBox(uint32_t drawIndex) const
+    {
+        NEB_ASSERT(drawIndex < m_numDraws, "Draw {} is out of range ({} draws)", drawIndex, m_numDraws);
+        return AABB{
+            .min = Vec3(m_minX[drawIndex], m_minY[drawIndex], m_minZ[drawIndex]),
+            .max = Vec3(m_maxX[drawIndex], m_maxY[drawIndex], m_maxZ[drawIndex]),
+        };
+    }
+
+    CullingStats FrustumCuller::Cull(const Frustum& frustum, ThreadPool& threadPool, uint32_t minDrawsPerTask)
+    {
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        if (m_numDraws <= minDrawsPerTask)
+        {
+            m_numVisibleDraws = CullRange(frustum, 0, m_numDraws);
+        }
+        else
+        {
+            // Ranges should start at SIMD boundaries
+            const uint32_t numDrawsPerTask = (std::max(minDrawsPerTask, SimdWidth) + SimdWidth - 1) / SimdWidth * SimdWidth;
+            m_numVisibleInRanges.resize((m_numDraws + numDrawsPerTask - 1) / numDrawsPerTask);
+            threadPool.ParallelForRange(m_numDraws, numDrawsPerTask, [&](size_t begin, size_t end)
+                {
+                    m_numVisibleInRanges[begin / numDrawsPerTask] = CullRange(frustum, static_cast<uint32_t>(begin), static_cast<uint32_t>(end));
+                });
+
+            // Each range wrote its visible draws at its own beginning, move them next to each other. Destination never passes the source
+            m_numVisibleDraws = 0;
+            for (size_t i = 0; i < m_numVisibleInRanges.size(); ++i)
+            {
+                const auto rangeBegin = m_visibleDraws.begin() + i * numDrawsPerTask;
+                std::copy(rangeBegin, rangeBegin + m_numVisibleInRanges[i], m_visibleDraws.begin() + m_numVisibleDraws);
+                m_numVisibleDraws += m_numVisibleInRanges[i];
+            }
+        }
+
+        return CullingStats{
+            .NumVisible = m_numVisibleDraws,
+            .NumCulled = m_numDraws - m_numVisibleDraws,
+            .Milliseconds = timeWatch.Elapsed<MillisecondsF32>().count(),
+        };
+    }
+
+    uint32_t FrustumCuller::CullRange(const Frustum& frustum, uint32_t begin, uint32_t end)
+    {
+        NEB_ASSERT(begin % SimdWidth == 0, "Range should start at a SIMD boundary");
+
+        // Sign of the normal tells which one of min/max is the p-vertex, and it is the same for every box
+        struct PlaneV
+        {
+            FloatV A, B, C, D;
+            const float* X;
+            const float* Y;
+            const float* Z;
+        };
+
+        PlaneV planes[Frustum::NumPlanes];
+        for (uint32_t i = 0; i < Frustum::NumPlanes; ++i)
+        {
+            const Vec4& plane = frustum.Planes[i];
+            planes[i] = PlaneV{
+                .A = SetV(plane.x),
+                .B = SetV(plane.y),
+                .C = SetV(plane.z),
+                .D = SetV(plane.w),
+                .X = (plane.x >= 0.0f) ? m_maxX.data() : m_minX.data(),
+                .Y = (plane.y >= 0.0f) ? m_maxY.data() : m_minY.data(),
+                .Z = (plane.z >= 0.0f) ? m_maxZ.data() : m_minZ.data(),
+            };
+        }
+
+        const FloatV zero = SetV(0.0f);
+        const uint32_t allLanes = (1u << SimdWidth) - 1;
+
+        uint32_t numVisible = 0;
+        for (uint32_t i = begin; i < end; i += SimdWidth)
+        {
+            FloatV isInside = GreaterEqualV(zero, zero);
+            for (const PlaneV& plane : planes)
+            {
+                const FloatV distance = AddV(AddV(AddV(MulV(plane.A, LoadV(plane.X + i)), MulV(plane.B, LoadV(plane.Y + i))), MulV(plane.C, LoadV(plane.Z + i))), plane.D);
+                isInside = AndV(isInside, GreaterEqualV(distance, zero));
+            }
+
+            uint32_t visibleLanes = MoveMaskV(isInside);
+            if (end - i < SimdWidth)
+                visibleLanes &= allLanes >> (SimdWidth - (end - i));
+
+            while (visibleLanes)
+            {
+                m_visibleDraws[begin + numVisible++] = i + static_cast<uint32_t>(std::countr_zero(visibleLanes));
+                visibleLanes &= visibleLanes - 1;
+            }
+        }
+        return numVisible;
+    }
+
+} // Neb namespace
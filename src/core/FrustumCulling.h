@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Math.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Planes are (normal, distance) with normals pointing inside, thus dot(normal, p) + distance >= 0 for every point inside.
+    // Order is left, right, bottom, top, near, far
+    struct Frustum
+    {
+        static constexpr uint32_t NumPlanes = 6;
+        Vec4 Planes[NumPlanes];
+    };
+
+    // Normalized planes of the clip volume of a view-projection matrix (row vectors, D3D depth range [0, 1])
+    Frustum ExtractFrustum(const Mat4& viewProj);
+
+    // Scalar reference of the test used by FrustumCuller. Conservative: boxes that intersect the frustum (and a few of those
+    // near its edges, that are outside of it but not fully behind any single plane) are visible
+    bool IsAABBInFrustum(const Frustum& frustum, const AABB& box);
+
+    struct CullingStats
+    {
+        uint32_t NumVisible = 0;
+        uint32_t NumCulled = 0;
+        float Milliseconds = 0.0f;
+    };
+
+    // Culls world boxes of draws against a frustum. Boxes are stored in SoA, so that each plane is tested against SIMD-width boxes at once,
+    // and indices of visible draws are compacted into a list, sorted in the order of draws.
+    // Large lists are split into ranges of draws, that are culled in parallel and compacted afterwards
+    class FrustumCuller
+    {
+    public:
+        // Boxes of new draws are empty (never visible) until set
+        void Resize(uint32_t numDraws);
+        void SetBox(uint32_t drawIndex, const AABB& box);
+        AABB GetBox(uint32_t drawIndex) const;
+
+        uint32_t GetNumDraws() const { return m_numDraws; }
+
+        CullingStats Cull(const Frustum& frustum, ThreadPool& threadPool, uint32_t minDrawsPerTask = 16384);
+
+        // Valid until the next Cull()
+        std::span<const uint32_t> GetVisibleDraws() const { return std::span(m_visibleDraws.data(), m_numVisibleDraws); }
+
+    private:
+        // Writes indices of visible draws of [begin, end) to m_visibleDraws starting at begin. Returns amount of them
+        uint32_t CullRange(const Frustum& frustum, uint32_t begin, uint32_t end);
+
+        uint32_t m_numDraws = 0;
+        std::vector<float> m_minX;
+        std::vector<float> m_minY;
+        std::vector<float> m_minZ;
+        std::vector<float> m_maxX;
+        std::vector<float> m_maxY;
+        std::vector<float> m_maxZ;
+
+        std::vector<uint32_t> m_visibleDraws; // as many as draws, only the first m_numVisibleDraws are valid
+        uint32_t m_numVisibleDraws = 0;
+        std::vector<uint32_t> m_numVisibleInRanges; // scratch of parallel culls
+    };
+
+} // Neb namespace
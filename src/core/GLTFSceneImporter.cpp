@@ -2,31 +2,192 @@
 
 #include <array>
 #include "../common/Assert.h"
+#include "../common/Configuration.h"
 #include "../common/Log.h"
+#include "../common/TimeWatch.h"
 #include "../nri/Device.h"
+#include "../util/Hash.h"
+#include "../util/Memory.h"
+#include "../util/ThreadPool.h"
+
+#include <TinyGLTF/stb_image.h>
+#include <psapi.h>
+
+#include <atomic>
+#include <numeric>
+#include <unordered_map>
 
 namespace Neb
 {
 
-    GLTFSceneImporter::GLTFSceneImporter()
+    namespace
     {
-        nri::NRIDevice& device = nri::NRIDevice::Get();
-        nri::ThrowIfFailed(device.GetD3D12Device()->CreateFence(
-            m_copyFenceValue,
-            D3D12_FENCE_FLAG_NONE,
-            IID_PPV_ARGS(m_copyFence.GetAddressOf())));
-    }
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr uint32_t InvalidMeshIndex = UINT32_MAX;
+
+        static_assert(nri::eAttributeType_NumTypes == SceneCacheNumAttributes, "Scene cache should store every attribute");
+        static_assert(nri::eVertexFormat_NumFormats == SceneCacheNumVertexFormats, "Scene cache should store every vertex format");
+
+        DXGI_FORMAT GetIndexFormatFromStride(UINT stride)
+        {
+            switch (stride)
+            {
+            case sizeof(uint8_t): return DXGI_FORMAT_R8_UINT;
+            case sizeof(uint16_t): return DXGI_FORMAT_R16_UINT;
+            case sizeof(uint32_t): return DXGI_FORMAT_R32_UINT;
+            default: NEB_ASSERT(false, "Unsupported index stride {}", stride); return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+
+        // Indices are widened to 32 bits for processing, no matter how they are stored
+        std::vector<uint32_t> ReadIndices(const nri::StaticSubmesh& submesh)
+        {
+            std::vector<uint32_t> indices(submesh.NumIndices);
+            const std::byte* src = submesh.Indices.data();
+            switch (submesh.IndicesStride)
+            {
+            case sizeof(uint8_t):
+                for (size_t i = 0; i < indices.size(); ++i)
+                    indices[i] = std::to_integer<uint32_t>(src[i]);
+                break;
+            case sizeof(uint16_t):
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    uint16_t index;
+                    std::memcpy(&index, src + i * sizeof(uint16_t), sizeof(uint16_t));
+                    indices[i] = index;
+                }
+                break;
+            case sizeof(uint32_t): std::memcpy(indices.data(), src, indices.size() * sizeof(uint32_t)); break;
+            default: NEB_ASSERT(false, "Unsupported index stride {}", submesh.IndicesStride);
+            }
+            return indices;
+        }
+
+        size_t GetPeakWorkingSetBytes()
+        {
+            PROCESS_MEMORY_COUNTERS counters = {};
+            return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+        }
+
+        // Image loader for tinygltf, that does not decode anything. Encoded bytes are stored as is
+        bool StoreEncodedImageData(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+            int reqWidth, int reqHeight, const unsigned char* bytes, int numBytes, void* userData)
+        {
+            if (!bytes || numBytes <= 0)
+            {
+                if (err)
+                    (*err) += std::format("Image {} \"{}\" has no data\n", imageIndex, image->name);
+                return false;
+            }
+
+            // Images stored in buffer views are decoded straight from the buffer (or the mapped BIN chunk), no need to copy them
+            if (image->bufferView < 0)
+                image->image.assign(bytes, bytes + numBytes);
+
+            image->as_is = true;
+            return true;
+        }
+
+        // Checks a single channel of tightly packed RGBA8 texels
+        bool IsChannelEqualTo(const std::vector<unsigned char>& texels, uint32_t channel, unsigned char value)
+        {
+            for (size_t i = channel; i < texels.size(); i += 4)
+            {
+                if (texels[i] != value)
+                    return false;
+            }
+            return true;
+        }
+
+        DXGI_FORMAT GetTextureBlockDxgiFormat(ETextureBlockFormat format)
+        {
+            switch (format)
+            {
+            case eTextureBlockFormat_BC1: return DXGI_FORMAT_BC1_UNORM;
+            case eTextureBlockFormat_BC4: return DXGI_FORMAT_BC4_UNORM;
+            case eTextureBlockFormat_BC5: return DXGI_FORMAT_BC5_UNORM;
+            case eTextureBlockFormat_BC7: return DXGI_FORMAT_BC7_UNORM;
+            default: NEB_ASSERT(false, "Unknown texture block format {}", uint32_t(format)); return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+    } // anonymous namespace
 
     bool GLTFSceneImporter::ImportScenesFromFile(const std::filesystem::path& filepath, EGLTFType type)
     {
         Clear(); // cleanup before work
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        // Try the baked cache first, tinygltf is only used on cold imports
+        const bool useSceneCache = Config::GetValue<bool>(EConfigKey::EnableSceneCache, true);
+        const bool optimizeMeshes = Config::GetValue<bool>(EConfigKey::OptimizeMeshes, false);
+        const bool buildMeshLods = Config::GetValue<bool>(EConfigKey::BuildMeshLods, false);
+        const bool compactVertexFormat = Config::GetValue<bool>(EConfigKey::CompactVertexFormat, false);
+        const bool generateMipmaps = Config::GetValue<bool>(EConfigKey::GenerateMipmaps, true);
+        const bool compressTextures = Config::GetValue<bool>(EConfigKey::CompressTextures, false);
+        const int32_t textureCompressionQuality = Config::GetValue<int32_t>(EConfigKey::TextureCompressionQuality, eTextureCompressionQuality_Normal);
+        const uint64_t imageProcessing = (generateMipmaps ? 1 : 0) | (compressTextures ? (2 | (uint64_t(textureCompressionQuality & 0xff) << 2)) : 0);
+        const std::filesystem::path cachePath = GetSceneCachePath(filepath);
+
+        // Optional passes are baked into the cache, so caches with and without them should not be mixed up
+        const uint64_t bakedPasses = (optimizeMeshes ? 1 : 0) | (buildMeshLods ? 2 : 0) | (compactVertexFormat ? 4 : 0) | (generateMipmaps ? 8 : 0) |
+            (compressTextures ? (16 | (uint64_t(textureCompressionQuality & 0xff) << 5)) : 0);
+        if (useSceneCache)
+        {
+            // Reader is kept alive together with imported scenes, as submeshes view its mapping
+            if (m_sceneCacheReader.Open(cachePath, filepath, /*seed*/ bakedPasses))
+            {
+                const bool result = ImportScenesFromCache(m_sceneCacheReader);
+                if (result)
+                {
+                    BuildSubmeshMeshlets();
+                    BuildMeshOccluders();
+                }
+
+                m_importStats = GLTFImportStats{
+                    .IsWarm = true,
+                    .Milliseconds = timeWatch.Elapsed<MillisecondsF32>().count(),
+                    .NumCopiedBytes = m_numCopiedBytes,
+                    .NumMappedBytes = m_sceneCacheReader.GetNumMappedBytes(),
+                };
+                NEB_LOG_INFO("GLTFSceneImporter -> Warm import of '{}' from scene cache took {:.1f}ms ({:.1f} MB mapped, peak working set {:.1f} MB)",
+                    filepath.filename().string(),
+                    m_importStats.Milliseconds,
+                    m_importStats.NumMappedBytes / (1024.0f * 1024.0f),
+                    GetPeakWorkingSetBytes() / (1024.0f * 1024.0f));
+                return result;
+            }
+
+            m_sceneCacheWriter = MakeScoped<SceneCacheWriter>();
+        }
+
         std::string err, warn;
 
+        // tinygltf would decode every image serially while parsing, instead we only keep the encoded bytes
+        // and decode them later in DecodeImages() on the worker pool
+        m_GLTFLoader.SetImageLoader(&StoreEncodedImageData, nullptr);
+
         bool result = false;
         switch (type)
         {
         case EGLTFType::AsciiFile: result = m_GLTFLoader.LoadASCIIFromFile(&m_GLTFModel, &err, &warn, filepath.string()); break;
-        case EGLTFType::Binary: result = m_GLTFLoader.LoadBinaryFromFile(&m_GLTFModel, &err, &warn, filepath.string()); break;
+        case EGLTFType::Binary:
+        {
+            // Binary glTF is memory-mapped instead of read into memory. Submeshes view the BIN chunk of the mapping directly
+            if (!m_sourceFile.Open(filepath))
+            {
+                NEB_LOG_ERROR("GLTFSceneImporter -> Failed to map '{}'", filepath.string());
+                break;
+            }
+
+            result = m_GLTFLoader.LoadBinaryFromMemory(&m_GLTFModel, &err, &warn,
+                reinterpret_cast<const unsigned char*>(m_sourceFile.GetData()),
+                static_cast<unsigned int>(m_sourceFile.GetSize()),
+                filepath.parent_path().string());
+        };
+        break;
         default:
             NEB_LOG_ERROR("Unknown GLTF file type");
         }
@@ -35,6 +196,7 @@ namespace Neb
         {
             NEB_ASSERT(!err.empty(), "Failed to load glTF file ({})", err);
             NEB_LOG_ERROR("{}", err);
+            m_sceneCacheWriter.Release();
             return false;
         }
 
@@ -43,99 +205,945 @@ namespace Neb
             NEB_LOG_WARN("{}", warn);
         }
 
+        InitBufferViews();
+        nri::ThrowIfFalse(DecodeImages());
+        DeduplicateImages(imageProcessing);
+        if (generateMipmaps)
+            GenerateImageMips();
+        if (compressTextures)
+            CompressImages();
         nri::ThrowIfFalse(SubmitD3D12Resources());
 
         for (tinygltf::Scene& src : m_GLTFModel.scenes)
         {
+            const size_t numTangentGenerationDescs = m_tangentGenerationDescs.size();
+
             Scoped<Scene> scene = MakeScoped<Scene>();
             if (ImportScene(scene, src))
             {
                 // If successfully imported - move the scene to the list of imported ones,
                 // otherwise just discard
                 ImportedScenes.push_back(std::move(scene));
+                continue;
+            }
+
+            // Discarded submeshes must not get their tangents generated, as their storage is gone
+            m_tangentGenerationDescs.resize(numTangentGenerationDescs);
+            if (m_sceneCacheWriter.IsValid())
+            {
+                // Do not bake partially imported files, just import them each time
+                NEB_LOG_WARN("GLTFSceneImporter -> Scene cache will not be written for '{}' as some of its scenes failed to import", filepath.filename().string());
+                m_sceneCacheWriter.Release();
             }
         }
 
+        GenerateSubmeshTangents();
+        if (optimizeMeshes)
+            OptimizeSubmeshes();
+        if (buildMeshLods)
+            BuildSubmeshLods();
+        BuildSubmeshMeshlets();
+        if (compactVertexFormat)
+            CompressSubmeshVertices();
+        BuildMeshOccluders();
+
         // Before returning wait for scene to be fully loaded
         WaitD3D12ResourcesOnCopyQueue();
 
         // At the very end submit postprocessing work for static mesh
-        // Postprocessing work may vary, but as of now it is just generating GPU buffer to store tangents
-        if (IsTangentPostprocessingNeeded())
+        // Postprocessing work may vary, but as of now it is just generating GPU buffer to store generated tangents and optimized geometry
+        if (IsGeometryPostprocessingNeeded())
         {
             nri::ThrowIfFalse(SubmitPostprocessingD3D12Resources());
             WaitD3D12ResourcesOnCopyQueue();
         }
 
-        m_stagingBuffers.clear();       // cleanup staging buffers
+        size_t numMeshes = 0, numInstances = 0;
+        for (const Scoped<Scene>& scene : ImportedScenes)
+        {
+            numMeshes += scene->StaticMeshes.size();
+            numInstances += scene->StaticMeshInstances.size();
+        }
+
+        m_importStats = GLTFImportStats{
+            .IsWarm = false,
+            .Milliseconds = timeWatch.Elapsed<MillisecondsF32>().count(),
+            .NumCopiedBytes = m_numCopiedBytes,
+        };
+        NEB_LOG_INFO("GLTFSceneImporter -> Cold import of '{}' took {:.1f}ms ({} meshes, {} instances, copied {:.1f} MB on CPU, peak working set {:.1f} MB)",
+            filepath.filename().string(),
+            m_importStats.Milliseconds,
+            numMeshes,
+            numInstances,
+            m_importStats.NumCopiedBytes / (1024.0f * 1024.0f),
+            GetPeakWorkingSetBytes() / (1024.0f * 1024.0f));
+
+        if (m_sceneCacheWriter.IsValid() && !ImportedScenes.empty())
+        {
+            timeWatch.Begin();
+            if (WriteSceneCache(cachePath, filepath, bakedPasses))
+            {
+                NEB_LOG_INFO("GLTFSceneImporter -> Baked scene cache '{}' ({:.1f} MB) in {:.1f}ms",
+                    cachePath.filename().string(),
+                    (m_sceneCacheWriter->GetNumGeometryBytes() + m_sceneCacheWriter->GetNumTexelBytes()) / (1024.0f * 1024.0f),
+                    timeWatch.Elapsed<MillisecondsF32>().count());
+            }
+        }
+        m_sceneCacheWriter.Release();
+
         return !ImportedScenes.empty(); // If no scenes were imported then we failed apparently
     }
 
     void GLTFSceneImporter::Clear()
     {
         // You should not cleanup the importer while it is processing resources
-        NEB_ASSERT(m_stagingBuffers.empty(), "GLTFSceneImporter should not be cleaned while processing resources");
+        NEB_ASSERT(nri::NRIDevice::Get().GetUploadService().IsCompleted(m_uploadTicket), "GLTFSceneImporter should not be cleaned while processing resources");
 
         ImportedScenes.clear();
         m_GLTFLoader = tinygltf::TinyGLTF(); // just in case clean it up as well
         m_GLTFModel = tinygltf::Model();     // destroy this as well
         m_GLTFTextures.clear();
         m_GLTFBuffers.clear();
+        m_imageContentHashes.clear();
+        m_imageSources.clear();
+        m_imageMipChains.clear();
+        m_compressedImages.clear();
+
+        // Textures of released scenes are only kept if something else still uses them
+        GetTextureRegistry().ReleaseUnreferenced();
+
+        // Sources can only be released after scenes, as submeshes view them
+        m_bufferBytes.clear();
+        m_tangentGenerationDescs.clear();
+        m_submeshMaterialIndices.clear();
+        m_sceneMeshIndices.clear();
+        m_sourceFile.Close();
+        m_sceneCacheReader.Close();
+        m_numCopiedBytes = 0;
+        m_importStats = {};
+    }
+
+    void GLTFSceneImporter::InitBufferViews()
+    {
+        // Find BIN chunk of the mapped binary glTF, if any
+        // https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#binary-gltf-layout
+        static constexpr uint32_t GLBHeaderSize = 12;
+        static constexpr uint32_t GLBChunkHeaderSize = 8;
+        static constexpr uint32_t GLBChunkTypeBIN = 0x004E4942;
+
+        std::span<const std::byte> binaryChunk;
+        std::span<const std::byte> file = m_sourceFile.GetBytes();
+        for (size_t offset = GLBHeaderSize; file.size() >= GLBHeaderSize && offset + GLBChunkHeaderSize <= file.size();)
+        {
+            uint32_t chunkLength, chunkType;
+            std::memcpy(&chunkLength, file.data() + offset, sizeof(uint32_t));
+            std::memcpy(&chunkType, file.data() + offset + sizeof(uint32_t), sizeof(uint32_t));
+            offset += GLBChunkHeaderSize;
+
+            if (chunkLength > file.size() - offset)
+                break;
+
+            if (chunkType == GLBChunkTypeBIN)
+            {
+                binaryChunk = file.subspan(offset, chunkLength);
+                break;
+            }
+            offset += chunkLength;
+        }
+
+        // Per spec only a buffer without uri may refer to the BIN chunk. tinygltf still copies the chunk into
+        // that buffer while parsing, we release that copy immediately and view the mapping instead
+        m_bufferBytes.clear();
+        m_bufferBytes.resize(m_GLTFModel.buffers.size());
+        for (size_t i = 0; i < m_GLTFModel.buffers.size(); ++i)
+        {
+            tinygltf::Buffer& buffer = m_GLTFModel.buffers[i];
+            if (buffer.uri.empty() && !binaryChunk.empty() && buffer.data.size() <= binaryChunk.size())
+            {
+                m_numCopiedBytes += buffer.data.size(); // transient copy made by tinygltf
+                m_bufferBytes[i] = binaryChunk.first(buffer.data.size());
+
+                buffer.data.clear();
+                buffer.data.shrink_to_fit();
+                continue;
+            }
+
+            m_bufferBytes[i] = std::as_bytes(std::span(buffer.data));
+        }
+    }
+
+    std::span<const std::byte> GLTFSceneImporter::GetBufferViewBytes(int32_t bufferViewIndex) const
+    {
+        const tinygltf::BufferView& bufferView = m_GLTFModel.bufferViews[bufferViewIndex];
+        return m_bufferBytes[bufferView.buffer].subspan(bufferView.byteOffset, bufferView.byteLength);
+    }
+
+    bool GLTFSceneImporter::ImportScene(Scene* scene, tinygltf::Scene& src)
+    {
+        m_sceneMeshIndices.assign(m_GLTFModel.meshes.size(), InvalidMeshIndex);
+        for (int32_t nodeID : src.nodes)
+        {
+            if (!ImportGLTFNode(scene, src, nodeID, SceneGraphInvalidNode))
+            {
+                NEB_LOG_ERROR("Failed to import node with nodeID {}", nodeID);
+                return false;
+            }
+        }
+
+        scene->UpdateTransforms();
+        return true;
+    }
+
+    bool GLTFSceneImporter::ImportScenesFromCache(const SceneCacheReader& reader)
+    {
+        nri::ThrowIfFalse(SubmitD3D12ResourcesFromCache(reader));
+
+        // Scene cache geometry is uploaded as a single buffer
+        NEB_ASSERT(m_GLTFBuffers.size() <= 1, "Scene cache geometry should be uploaded as a single buffer");
+        nri::D3D12Rc<ID3D12Resource> geometryBuffer = m_GLTFBuffers.empty() ? nullptr : m_GLTFBuffers.front();
+        std::span<const std::byte> geometryBytes = reader.GetGeometryBytes();
+
+        std::span<const SceneCacheMesh> meshes = reader.GetMeshes();
+        std::span<const SceneCacheNode> nodes = reader.GetNodes();
+        std::span<const SceneCacheInstance> instances = reader.GetInstances();
+        std::span<const SceneCacheSubmesh> submeshes = reader.GetSubmeshes();
+        std::span<const SceneCacheMaterial> materials = reader.GetMaterials();
+
+        for (const SceneCacheScene& srcScene : reader.GetScenes())
+        {
+            Scoped<Scene> scene = MakeScoped<Scene>();
+            scene->StaticMeshes.resize(srcScene.NumMeshes);
+            scene->StaticMeshInstances.resize(srcScene.NumInstances);
+
+            // Nodes are baked in the order of the graph, thus indices stay the same
+            scene->Graph.Reserve(srcScene.NumNodes);
+            for (const SceneCacheNode& srcNode : nodes.subspan(srcScene.FirstNode, srcScene.NumNodes))
+            {
+                scene->Graph.AddNode(srcNode.Parent == SceneCacheInvalidIndex ? SceneGraphInvalidNode : srcNode.Parent, SceneNodeTransform{
+                    .Translation = Vec3(srcNode.Translation),
+                    .Rotation = Quaternion(srcNode.Rotation),
+                    .Scale = Vec3(srcNode.Scale),
+                });
+            }
+
+            for (uint32_t instanceIndex = 0; instanceIndex < srcScene.NumInstances; ++instanceIndex)
+            {
+                const SceneCacheInstance& srcInstance = instances[srcScene.FirstInstance + instanceIndex];
+                nri::StaticMeshInstance& instance = scene->StaticMeshInstances[instanceIndex];
+                instance.MeshIndex = srcInstance.MeshIndex;
+                instance.NodeIndex = srcInstance.NodeIndex;
+            }
+
+            for (uint32_t meshIndex = 0; meshIndex < srcScene.NumMeshes; ++meshIndex)
+            {
+                const SceneCacheMesh& srcMesh = meshes[srcScene.FirstMesh + meshIndex];
+                nri::StaticMesh& mesh = scene->StaticMeshes[meshIndex];
+
+                mesh.Submeshes.resize(srcMesh.NumSubmeshes);
+                mesh.SubmeshMaterials.resize(srcMesh.NumSubmeshes);
+                for (uint32_t submeshIndex = 0; submeshIndex < srcMesh.NumSubmeshes; ++submeshIndex)
+                {
+                    const SceneCacheSubmesh& src = submeshes[srcMesh.FirstSubmesh + submeshIndex];
+                    nri::StaticSubmesh& submesh = mesh.Submeshes[submeshIndex];
+                    submesh.NumVertices = src.NumVertices;
+                    submesh.VertexFormat = nri::EVertexFormat(src.VertexFormat);
+                    std::copy_n(src.PositionScale, 3, submesh.Quantization.Scale);
+                    std::copy_n(src.PositionBias, 3, submesh.Quantization.Bias);
+                    submesh.LocalBox = AABB{ .min = Vec3(src.BoxMin), .max = Vec3(src.BoxMax) };
+                    submesh.LocalSphere = Sphere{ .center = Vec3(src.SphereCenter), .radius = src.SphereRadius };
+
+                    for (uint32_t i = 0; i < nri::eAttributeType_NumTypes; ++i)
+                    {
+                        const UINT stride = src.AttributeStrides[i];
+                        if (stride == 0)
+                            continue;
+
+                        const size_t numBytes = size_t(stride) * src.NumVertices;
+                        submesh.Attributes[i] = geometryBytes.subspan(src.AttributeOffsets[i], numBytes);
+
+                        submesh.AttributeStrides[i] = stride;
+                        submesh.AttributeOffsets[i] = src.AttributeOffsets[i];
+                        submesh.AttributeBuffers[i] = geometryBuffer;
+                        submesh.AttributeViews[i] = D3D12_VERTEX_BUFFER_VIEW{
+                            .BufferLocation = geometryBuffer->GetGPUVirtualAddress() + src.AttributeOffsets[i],
+                            .SizeInBytes = static_cast<UINT>(numBytes),
+                            .StrideInBytes = stride,
+                        };
+                    }
+
+                    // Cache stores indices of every LOD, full resolution ones are the first LOD then
+                    submesh.NumIndices = (src.NumLods > 0) ? src.Lods[0].NumIndices : src.NumIndices;
+                    submesh.IndicesStride = src.IndicesStride;
+                    submesh.IndicesOffset = src.IndicesOffset;
+                    for (const SceneCacheLod& lod : std::span(src.Lods, src.NumLods))
+                        submesh.Lods.push_back(MeshLod{ .FirstIndex = lod.FirstIndex, .NumIndices = lod.NumIndices, .Error = lod.Error });
+
+                    if (src.NumIndices > 0)
+                    {
+                        const size_t numBytes = size_t(src.IndicesStride) * src.NumIndices;
+                        submesh.Indices = geometryBytes.subspan(src.IndicesOffset, numBytes);
+
+                        submesh.IndexBuffer = geometryBuffer;
+                        submesh.IBView = D3D12_INDEX_BUFFER_VIEW{
+                            .BufferLocation = geometryBuffer->GetGPUVirtualAddress() + src.IndicesOffset,
+                            .SizeInBytes = static_cast<UINT>(numBytes),
+                            .Format = GetIndexFormatFromStride(src.IndicesStride),
+                        };
+                    }
+
+                    if (src.MaterialIndex != SceneCacheInvalidIndex)
+                        InitMaterialFromCache(mesh.SubmeshMaterials[submeshIndex], materials[src.MaterialIndex]);
+                }
+                mesh.UpdateBounds();
+            }
+
+            // Needs local boxes of meshes for SceneBox
+            scene->UpdateTransforms();
+            ImportedScenes.push_back(std::move(scene));
+        }
+
+        WaitD3D12ResourcesOnCopyQueue();
+        return !ImportedScenes.empty();
+    }
+
+    bool GLTFSceneImporter::SubmitD3D12ResourcesFromCache(const SceneCacheReader& reader)
+    {
+        nri::NRIDevice& device = nri::NRIDevice::Get();
+        nri::UploadBatch batch;
+
+        // All of the geometry goes into a single buffer, that is staged straight from the mapping
+        std::span<const std::byte> geometryBytes = reader.GetGeometryBytes();
+        m_GLTFBuffers.clear();
+        if (!geometryBytes.empty())
+        {
+            nri::D3D12Rc<ID3D12Resource> geometryBuffer = m_GLTFBuffers.emplace_back(CreateDefaultBuffer(geometryBytes.size()));
+            NEB_SET_HANDLE_NAME(geometryBuffer, "GLTFSceneImporter: Buffer '{}'", "scene_cache_geometry");
+            batch.AddBuffer(geometryBuffer.Get(), 0, geometryBytes);
+        }
+
+        std::span<const std::byte> texelBytes = reader.GetTexelBytes();
+        std::span<const SceneCacheTexture> textures = reader.GetTextures();
+        std::span<const SceneCacheSubresource> subresources = reader.GetSubresources();
+
+        m_GLTFTextures.clear();
+        m_GLTFTextures.resize(textures.size());
+        uint32_t numReusedTextures = 0;
+        uint64_t numReusedBytes = 0;
+        if (!texelBytes.empty())
+        {
+            for (size_t i = 0; i < textures.size(); ++i)
+            {
+                const SceneCacheTexture& src = textures[i];
+                if (src.MipLevels == 0)
+                    continue;
+
+                const DXGI_FORMAT format = static_cast<DXGI_FORMAT>(src.Format);
+                D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, src.Width, src.Height, 1, static_cast<UINT16>(src.MipLevels));
+                const uint64_t numResourceBytes = device.GetD3D12Device()->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+
+                // Cold imports key textures the same way, so they are shared between warm and cold imports as well
+                const TextureRegistryKey registryKey = { .ContentHash = src.ContentHash, .Format = src.Format };
+                m_GLTFTextures[i] = GetTextureRegistry().Find(registryKey);
+                if (m_GLTFTextures[i])
+                {
+                    numReusedBytes += numResourceBytes;
+                    ++numReusedTextures;
+                    continue;
+                }
+
+                D3D12MA::Allocator* resourceAllocator = device.GetResourceAllocator();
+                D3D12MA::ALLOCATION_DESC allocDesc = {
+                    .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+                    .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+                };
+
+                nri::D3D12Rc<D3D12MA::Allocation> allocation;
+                nri::ThrowIfFailed(resourceAllocator->CreateResource(
+                    &allocDesc,
+                    &resourceDesc,
+                    D3D12_RESOURCE_STATE_COMMON,
+                    nullptr, allocation.GetAddressOf(),
+                    IID_PPV_ARGS(m_GLTFTextures[i].ReleaseAndGetAddressOf())));
+                NEB_SET_HANDLE_NAME(m_GLTFTextures[i], "GLTFSceneImporter: Image '{}'", std::format("scene_cache_image_{}", i));
+                GetTextureRegistry().Add(registryKey, m_GLTFTextures[i], numResourceBytes);
+
+                // Texels are already laid out as copyable footprints, so whole pitches are staged at once
+                for (UINT mip = 0; mip < src.MipLevels; ++mip)
+                {
+                    const SceneCacheSubresource& subresource = subresources[src.FirstSubresource + mip];
+                    const D3D12_SUBRESOURCE_FOOTPRINT footprint = {
+                        .Format = format,
+                        .Width = subresource.Width,
+                        .Height = subresource.Height,
+                        .Depth = 1,
+                        .RowPitch = subresource.RowPitch,
+                    };
+                    batch.AddTexture(m_GLTFTextures[i].Get(), mip, footprint, subresource.NumRows, subresource.RowPitch, texelBytes.data() + subresource.Offset, subresource.RowPitch);
+                }
+            }
+        }
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Reused {} textures of earlier imports ({:.1f} MB of video memory saved), {} textures ({:.1f} MB) are shared in total",
+            numReusedTextures,
+            numReusedBytes / (1024.0f * 1024.0f),
+            GetTextureRegistry().GetNumTextures(),
+            GetTextureRegistry().GetNumBytes() / (1024.0f * 1024.0f));
+
+        m_uploadTicket = device.GetUploadService().Submit(batch, GetThreadPool());
+        return true;
+    }
+
+    void GLTFSceneImporter::InitMaterialFromCache(nri::Material& material, const SceneCacheMaterial& src)
+    {
+        for (UINT i = 0; i < nri::eMaterialTextureType_NumTypes; ++i)
+        {
+            if (src.TextureIndices[i] != SceneCacheInvalidIndex)
+                material.Textures[i] = m_GLTFTextures[src.TextureIndices[i]];
+        }
+
+        material.AlbedoFactor = Vec4(src.AlbedoFactor);
+        material.RoughnessMetalnessFactor = Vec2(src.RoughnessMetalnessFactor);
+        material.Flags = src.Flags;
+
+        nri::NRIDevice& device = nri::NRIDevice::Get();
+        nri::DescriptorHeap& descriptorHeap = device.GetDescriptorHeap(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+        material.SrvRange = descriptorHeap.AllocateDescriptors(nri::eMaterialTextureType_NumTypes);
+        for (UINT i = 0; i < nri::eMaterialTextureType_NumTypes; ++i)
+            InitMaterialTextureDescriptor(material.Textures[i].Get(), (nri::EMaterialTextureType)i, material.SrvRange);
+    }
+
+    std::vector<std::filesystem::path> GLTFSceneImporter::GetSourceFiles() const
+    {
+        std::vector<std::filesystem::path> sourceFiles;
+        auto addSourceFile = [&sourceFiles](const std::string& uri)
+        {
+            // Empty uri is the BIN chunk of binary glTF. Uris are percent-encoded UTF-8, the same way tinygltf resolves them
+            std::string decodedUri;
+            if (uri.empty() || tinygltf::IsDataURI(uri) || !tinygltf::URIDecode(uri, &decodedUri, nullptr))
+                return;
+
+            sourceFiles.push_back(std::filesystem::path(std::u8string(decodedUri.begin(), decodedUri.end())).lexically_normal());
+        };
+
+        for (const tinygltf::Buffer& buffer : m_GLTFModel.buffers)
+            addSourceFile(buffer.uri);
+        for (const tinygltf::Image& image : m_GLTFModel.images)
+            addSourceFile(image.uri);
+
+        std::ranges::sort(sourceFiles);
+        const auto [first, last] = std::ranges::unique(sourceFiles);
+        sourceFiles.erase(first, last);
+        return sourceFiles;
+    }
+
+    bool GLTFSceneImporter::WriteSceneCache(const std::filesystem::path& cachePath, const std::filesystem::path& filepath, uint64_t bakedPasses)
+    {
+        NEB_ASSERT(m_sceneCacheWriter.IsValid(), "Scene cache writer should be valid when writing the cache");
+
+        // Bake the final streams (with generated tangents, if any), so that warm imports skip all of the import work.
+        // Submeshes are visited in the same order they were imported in
+        size_t submeshIndex = 0;
+        for (const Scoped<Scene>& scene : ImportedScenes)
+        {
+            m_sceneCacheWriter->BeginScene();
+            for (const nri::StaticMesh& mesh : scene->StaticMeshes)
+            {
+                m_sceneCacheWriter->BeginMesh();
+                for (const nri::StaticSubmesh& submesh : mesh.Submeshes)
+                {
+                    NEB_ASSERT(submeshIndex < m_submeshMaterialIndices.size(), "Material index of submesh {} is missing", submeshIndex);
+
+                    SceneCacheSubmeshSource cacheSrc = {
+                        .NumVertices = submesh.NumVertices,
+                        .NumIndices = submesh.GetNumStoredIndices(),
+                        .IndicesStride = submesh.IndicesStride,
+                        .Indices = submesh.Indices.data(),
+                        .MaterialIndex = m_submeshMaterialIndices[submeshIndex++],
+                        .NumLods = static_cast<uint32_t>(submesh.Lods.size()),
+                        .VertexFormat = static_cast<uint32_t>(submesh.VertexFormat),
+                        .SphereRadius = submesh.LocalSphere.radius,
+                    };
+                    std::copy_n(submesh.Quantization.Scale, 3, cacheSrc.PositionScale);
+                    std::copy_n(submesh.Quantization.Bias, 3, cacheSrc.PositionBias);
+                    std::copy_n(&submesh.LocalBox.min.x, 3, cacheSrc.BoxMin);
+                    std::copy_n(&submesh.LocalBox.max.x, 3, cacheSrc.BoxMax);
+                    std::copy_n(&submesh.LocalSphere.center.x, 3, cacheSrc.SphereCenter);
+                    for (size_t i = 0; i < submesh.Lods.size(); ++i)
+                    {
+                        const MeshLod& lod = submesh.Lods[i];
+                        cacheSrc.Lods[i] = SceneCacheLod{ .FirstIndex = lod.FirstIndex, .NumIndices = lod.NumIndices, .Error = lod.Error };
+                    }
+                    for (uint32_t i = 0; i < nri::eAttributeType_NumTypes; ++i)
+                    {
+                        if (submesh.Attributes[i].empty())
+                            continue;
+
+                        cacheSrc.Attributes[i] = submesh.Attributes[i].data();
+                        cacheSrc.AttributeStrides[i] = submesh.AttributeStrides[i];
+                        cacheSrc.AttributeElementSizes[i] = nri::StaticMeshAttributeSizes[submesh.VertexFormat][i];
+                    }
+                    m_sceneCacheWriter->AddSubmesh(cacheSrc);
+                }
+            }
+
+            for (uint32_t nodeIndex = 0; nodeIndex < scene->Graph.GetNumNodes(); ++nodeIndex)
+            {
+                const SceneNodeTransform transform = scene->Graph.GetLocalTransform(nodeIndex);
+                const uint32_t parentIndex = scene->Graph.GetParent(nodeIndex);
+
+                SceneCacheNode node = { .Parent = (parentIndex == SceneGraphInvalidNode) ? SceneCacheInvalidIndex : parentIndex };
+                std::memcpy(node.Translation, &transform.Translation.x, sizeof(node.Translation));
+                std::memcpy(node.Rotation, &transform.Rotation.x, sizeof(node.Rotation));
+                std::memcpy(node.Scale, &transform.Scale.x, sizeof(node.Scale));
+                m_sceneCacheWriter->AddNode(node);
+            }
+
+            for (const nri::StaticMeshInstance& instance : scene->StaticMeshInstances)
+                m_sceneCacheWriter->AddInstance(instance.NodeIndex, instance.MeshIndex);
+
+            m_sceneCacheWriter->EndScene(&scene->SceneBox.min.x, &scene->SceneBox.max.x);
+        }
+
+        // Texture indices of the cache are glTF image indices. Duplicate images are baked empty, materials reference the first one
+        auto getImageIndex = [this](int32_t textureIndex) -> uint32_t
+        {
+            return GetTextureFromGLTFScene(textureIndex) ? m_imageSources[m_GLTFModel.textures[textureIndex].source] : SceneCacheInvalidIndex;
+        };
+
+        // Same logic as in ImportStaticMesh, material indices of the cache are glTF material indices
+        for (const tinygltf::Material& srcMaterial : m_GLTFModel.materials)
+        {
+            const tinygltf::PbrMetallicRoughness& pbrMaterial = srcMaterial.pbrMetallicRoughness;
+
+            SceneCacheMaterial material;
+            material.TextureIndices[nri::eMaterialTextureType_Albedo] = getImageIndex(pbrMaterial.baseColorTexture.index);
+            material.TextureIndices[nri::eMaterialTextureType_Normal] = getImageIndex(srcMaterial.normalTexture.index);
+            material.TextureIndices[nri::eMaterialTextureType_RoughnessMetalness] = getImageIndex(pbrMaterial.metallicRoughnessTexture.index);
+
+            if (material.TextureIndices[nri::eMaterialTextureType_Albedo] == SceneCacheInvalidIndex)
+            {
+                for (uint32_t i = 0; i < 4; ++i)
+                    material.AlbedoFactor[i] = float(pbrMaterial.baseColorFactor[i]);
+            }
+
+            if (material.TextureIndices[nri::eMaterialTextureType_RoughnessMetalness] == SceneCacheInvalidIndex)
+            {
+                material.RoughnessMetalnessFactor[0] = float(pbrMaterial.roughnessFactor);
+                material.RoughnessMetalnessFactor[1] = float(pbrMaterial.metallicFactor);
+            }
+
+            material.Flags |= (material.TextureIndices[nri::eMaterialTextureType_Albedo] != SceneCacheInvalidIndex) ? nri::eMaterialFlag_HasAlbedoMap : 0;
+            material.Flags |= (material.TextureIndices[nri::eMaterialTextureType_Normal] != SceneCacheInvalidIndex) ? nri::eMaterialFlag_HasNormalMap : 0;
+            material.Flags |= (material.TextureIndices[nri::eMaterialTextureType_RoughnessMetalness] != SceneCacheInvalidIndex) ? nri::eMaterialFlag_HasRoughnessMetalnessMap : 0;
+            m_sceneCacheWriter->AddMaterial(material);
+        }
+
+        std::vector<SceneCacheSubresourceSource> subresources;
+        for (size_t i = 0; i < m_GLTFModel.images.size(); ++i)
+        {
+            if (!m_GLTFTextures[i])
+            {
+                m_sceneCacheWriter->AddTexture(DXGI_FORMAT_R8G8B8A8_UNORM, 0, {});
+                continue;
+            }
+
+            const DXGI_FORMAT format = GetImageSubresources(uint32_t(i), subresources);
+            m_sceneCacheWriter->AddTexture(format, m_imageContentHashes[i], subresources);
+        }
+
+        // Hashed after the import, references of the glTF are only known once it is parsed
+        const std::vector<std::filesystem::path> sourceFiles = GetSourceFiles();
+        const uint64_t sourceHash = HashSceneCacheSource(filepath, sourceFiles, /*seed*/ bakedPasses);
+        return m_sceneCacheWriter->WriteToFile(cachePath, sourceHash, sourceFiles);
+    }
+
+    bool GLTFSceneImporter::SubmitD3D12Resources()
+    {
+        nri::UploadBatch batch;
+        {
+            nri::ThrowIfFalse(SubmitD3D12Images(batch));
+            nri::ThrowIfFalse(SubmitD3D12Buffers(batch));
+        }
+        m_uploadTicket = nri::NRIDevice::Get().GetUploadService().Submit(batch, GetThreadPool());
+        return true;
+    }
+
+    nri::D3D12Rc<ID3D12Resource> GLTFSceneImporter::CreateDefaultBuffer(UINT64 numBytes)
+    {
+        nri::NRIDevice& device = nri::NRIDevice::Get();
+
+        D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{ .SizeInBytes = numBytes, .Alignment = 0 });
+        D3D12MA::Allocator* allocator = device.GetResourceAllocator();
+        D3D12MA::ALLOCATION_DESC allocDesc = {
+            .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+            .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+        };
+
+        nri::D3D12Rc<ID3D12Resource> buffer;
+        nri::D3D12Rc<D3D12MA::Allocation> allocation;
+        nri::ThrowIfFailed(allocator->CreateResource(
+            &allocDesc,
+            &resourceDesc,
+            D3D12_RESOURCE_STATE_COMMON, // No need to use copy dest state. Buffers are effectively created in state D3D12_RESOURCE_STATE_COMMON.
+            nullptr, allocation.GetAddressOf(),
+            IID_PPV_ARGS(buffer.GetAddressOf())));
+        return buffer;
+    }
+
+    bool GLTFSceneImporter::DecodeImages()
+    {
+        // Images were only read by tinygltf (see StoreEncodedImageData), decode them here on the worker pool.
+        // stb_image is reentrant, each image is fully independent
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        std::atomic<uint32_t> numFailedImages = 0;
+        std::atomic<uint64_t> numDecodedBytes = 0;
+
+        ThreadPool& threadPool = GetThreadPool();
+        threadPool.ParallelFor(m_GLTFModel.images.size(), [this, &numFailedImages, &numDecodedBytes](size_t i)
+            {
+                tinygltf::Image& image = m_GLTFModel.images[i];
+                if (!image.as_is)
+                    return;
+
+                std::span<const std::byte> encoded = (image.bufferView >= 0) ? GetBufferViewBytes(image.bufferView) : std::as_bytes(std::span(image.image));
+                if (encoded.empty())
+                    return;
+
+                // Always expand to RGBA8, as that is what we upload. 16-bit images are converted to 8-bit by stb
+                int32_t width = 0, height = 0, numComponents = 0;
+                stbi_uc* texels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encoded.data()), static_cast<int>(encoded.size()), &width, &height, &numComponents, STBI_rgb_alpha);
+
+                image.as_is = false;
+                if (!texels || width < 1 || height < 1)
+                {
+                    NEB_LOG_WARN("GLTFSceneImporter -> Failed to decode image {} \"{}\" ({})", i, image.name, stbi_failure_reason());
+                    image.image.clear();
+                    stbi_image_free(texels);
+                    ++numFailedImages;
+                    return;
+                }
+
+                const size_t numBytes = size_t(width) * size_t(height) * STBI_rgb_alpha;
+                image.width = width;
+                image.height = height;
+                image.component = STBI_rgb_alpha;
+                image.bits = 8;
+                image.pixel_type = TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE;
+                image.image.assign(texels, texels + numBytes);
+                stbi_image_free(texels);
+
+                numDecodedBytes += numBytes;
+            });
+
+        NEB_LOG_WARN_IF(numFailedImages > 0, "GLTFSceneImporter -> {} images failed to decode and will be treated as missing", numFailedImages.load());
+        NEB_LOG_INFO("GLTFSceneImporter -> Decoded {} images ({:.1f} MB) on {} threads in {:.1f}ms",
+            m_GLTFModel.images.size(),
+            numDecodedBytes.load() / (1024.0f * 1024.0f),
+            threadPool.GetNumThreads(),
+            timeWatch.Elapsed<MillisecondsF32>().count());
+        return true;
+    }
+
+    void GLTFSceneImporter::DeduplicateImages(uint64_t processingSeed)
+    {
+        // Slots decide filtering and the block format, processing seed decides whether mips and compression are done at all,
+        // thus the same texels only map to the same resource if everything that is uploaded from them is the same
+        const size_t numImages = m_GLTFModel.images.size();
+        const std::vector<uint32_t> imageSlots = GetImageMaterialSlots();
+        m_imageContentHashes.assign(numImages, 0);
+        GetThreadPool().ParallelFor(numImages, [this, &imageSlots, processingSeed](size_t i)
+            {
+                const tinygltf::Image& image = m_GLTFModel.images[i];
+                if (image.image.empty())
+                    return;
+
+                const uint64_t desc[] = { uint64_t(image.width), uint64_t(image.height), uint64_t(image.component), imageSlots[i], processingSeed };
+                m_imageContentHashes[i] = HashBytes64(image.image.data(), image.image.size(), /*seed*/ HashBytes64(desc, sizeof(desc)));
+            });
+
+        uint32_t numDuplicates = 0;
+        uint64_t numDuplicateBytes = 0;
+        std::unordered_map<uint64_t, uint32_t> firstImages;
+        m_imageSources.resize(numImages);
+        for (uint32_t i = 0; i < static_cast<uint32_t>(numImages); ++i)
+        {
+            m_imageSources[i] = i;
+
+            tinygltf::Image& image = m_GLTFModel.images[i];
+            if (image.image.empty())
+                continue;
+
+            auto [it, inserted] = firstImages.emplace(m_imageContentHashes[i], i);
+            if (inserted || image.image != m_GLTFModel.images[it->second].image)
+                continue; // unique, or just a hash collision
+
+            // Texels of the copy are released right away, so that no work is done on them later
+            m_imageSources[i] = it->second;
+            numDuplicateBytes += image.image.size();
+            ++numDuplicates;
+            image.image = std::vector<unsigned char>();
+        }
+
+        NEB_LOG_INFO("GLTFSceneImporter -> {} of {} images are duplicates ({:.1f} MB of decoded texels saved)",
+            numDuplicates,
+            numImages,
+            numDuplicateBytes / (1024.0f * 1024.0f));
+    }
+
+    void GLTFSceneImporter::GenerateImageMips()
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        // Content of an image is decided by the material slots it is used in. Images used in slots of different kinds
+        // (or in none at all) are filtered as plain linear data
+        const size_t numImages = m_GLTFModel.images.size();
+        const std::vector<uint32_t> imageSlots = GetImageMaterialSlots();
+        auto getContent = [&imageSlots](size_t i)
+            {
+                switch (imageSlots[i])
+                {
+                case (1 << nri::eMaterialTextureType_Albedo): return eTextureContent_Color;
+                case (1 << nri::eMaterialTextureType_Normal): return eTextureContent_Normal;
+                default: return eTextureContent_Linear;
+                }
+            };
+
+        uint64_t numSourceTexels = 0;
+        std::vector<TextureSourceDesc> srcs(numImages);
+        for (size_t i = 0; i < numImages; ++i)
+        {
+            const tinygltf::Image& image = m_GLTFModel.images[i];
+            if (image.image.empty() || image.component != 4 || image.bits != 8)
+                continue; // images that failed to decode, they get no chain
+
+            srcs[i] = TextureSourceDesc{
+                .Width = uint32_t(image.width),
+                .Height = uint32_t(image.height),
+                .Texels = reinterpret_cast<const std::byte*>(image.image.data()),
+                .Content = getContent(i),
+            };
+            numSourceTexels += uint64_t(image.width) * uint64_t(image.height);
+        }
+
+        ThreadPool& threadPool = GetThreadPool();
+        m_imageMipChains.resize(numImages);
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        GenerateMipChains(m_imageMipChains, srcs, threadPool);
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        uint64_t numMipBytes = 0;
+        for (const TextureMipChain& mipChain : m_imageMipChains)
+            numMipBytes += mipChain.Texels.size();
+        m_numCopiedBytes += numMipBytes;
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Generated mips of {} images ({:.1f} source megapixels, {:.1f} MB of mips) in {:.1f}ms on {} threads ({:.1f} MP/s)",
+            numImages,
+            numSourceTexels / 1e6f,
+            numMipBytes / (1024.0f * 1024.0f),
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            numSourceTexels / (std::max(elapsedMs, 0.001f) * 1000.0f));
+    }
+
+    void GLTFSceneImporter::CompressImages()
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        const int32_t qualityValue = Config::GetValue<int32_t>(EConfigKey::TextureCompressionQuality, eTextureCompressionQuality_Normal);
+        const ETextureCompressionQuality quality = ETextureCompressionQuality(std::clamp(qualityValue, 0, int32_t(eTextureCompressionQuality_NumQualities) - 1));
+
+        // Format is picked by the slots the image is used in. Normal maps only need xy (z is reconstructed in shaders),
+        // roughness-metalness only needs gb. Images used in several kinds of slots keep every channel
+        const size_t numImages = m_GLTFModel.images.size();
+        const std::vector<uint32_t> imageSlots = GetImageMaterialSlots();
+        std::vector<std::vector<TextureLevelDesc>> imageLevels(numImages);
+        std::vector<TextureCompressionSourceDesc> srcs(numImages);
+        for (size_t i = 0; i < numImages; ++i)
+        {
+            const tinygltf::Image& image = m_GLTFModel.images[i];
+            if (imageSlots[i] == 0 || image.image.empty() || image.component != 4 || image.bits != 8)
+                continue; // unused images and images that failed to decode stay as they are
+
+            // BC formats require the top level to be made of whole blocks
+            if (image.width % 4 != 0 || image.height % 4 != 0)
+                continue;
+
+            TextureCompressionSourceDesc& src = srcs[i];
+            switch (imageSlots[i])
+            {
+            case (1 << nri::eMaterialTextureType_Albedo):
+                src.Format = (quality == eTextureCompressionQuality_Fast && IsChannelEqualTo(image.image, 3, 255)) ? eTextureBlockFormat_BC1 : eTextureBlockFormat_BC7;
+                break;
+            case (1 << nri::eMaterialTextureType_Normal):
+                src.Format = eTextureBlockFormat_BC5;
+                src.Channels[0] = 0;
+                src.Channels[1] = 1;
+                break;
+            case (1 << nri::eMaterialTextureType_RoughnessMetalness):
+                // Metalness is often left empty, then roughness alone is enough
+                src.Format = IsChannelEqualTo(image.image, 2, 0) ? eTextureBlockFormat_BC4 : eTextureBlockFormat_BC5;
+                src.Channels[0] = 1;
+                src.Channels[1] = 2;
+                break;
+            default:
+                src.Format = eTextureBlockFormat_BC7;
+                break;
+            }
+
+            std::vector<TextureLevelDesc>& levels = imageLevels[i];
+            levels.push_back(TextureLevelDesc{
+                .Width = uint32_t(image.width),
+                .Height = uint32_t(image.height),
+                .Texels = reinterpret_cast<const std::byte*>(image.image.data()),
+            });
+
+            if (i < m_imageMipChains.size())
+            {
+                const TextureMipChain& mipChain = m_imageMipChains[i];
+                for (const TextureMipLevel& level : mipChain.Levels)
+                {
+                    levels.push_back(TextureLevelDesc{
+                        .Width = level.Width,
+                        .Height = level.Height,
+                        .Texels = mipChain.Texels.data() + level.Offset,
+                    });
+                }
+            }
+            src.Levels = levels;
+        }
+
+        ThreadPool& threadPool = GetThreadPool();
+        m_compressedImages.resize(numImages);
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        CompressTextures(m_compressedImages, srcs, quality, threadPool);
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        uint32_t numImagesPerFormat[eTextureBlockFormat_NumFormats] = {};
+        uint64_t numTexels = 0;
+        uint64_t numCompressedBytes = 0;
+        for (size_t i = 0; i < numImages; ++i)
+        {
+            if (srcs[i].Levels.empty())
+                continue;
+
+            ++numImagesPerFormat[srcs[i].Format];
+            for (const TextureLevelDesc& level : srcs[i].Levels)
+                numTexels += uint64_t(level.Width) * uint64_t(level.Height);
+            numCompressedBytes += m_compressedImages[i].Blocks.size();
+        }
+        m_numCopiedBytes += numCompressedBytes;
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Compressed {} images (BC1 {}, BC4 {}, BC5 {}, BC7 {}; {:.1f} megapixels, {:.1f} MB -> {:.1f} MB) in {:.1f}ms on {} threads ({:.1f} MP/s)",
+            std::accumulate(std::begin(numImagesPerFormat), std::end(numImagesPerFormat), 0u),
+            numImagesPerFormat[eTextureBlockFormat_BC1],
+            numImagesPerFormat[eTextureBlockFormat_BC4],
+            numImagesPerFormat[eTextureBlockFormat_BC5],
+            numImagesPerFormat[eTextureBlockFormat_BC7],
+            numTexels / 1e6f,
+            numTexels * 4 / (1024.0f * 1024.0f),
+            numCompressedBytes / (1024.0f * 1024.0f),
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            numTexels / (std::max(elapsedMs, 0.001f) * 1000.0f));
     }
 
-    bool GLTFSceneImporter::ImportScene(Scene* scene, tinygltf::Scene& src)
+    std::vector<uint32_t> GLTFSceneImporter::GetImageMaterialSlots() const
     {
-        for (int32_t nodeID : src.nodes)
-        {
-            if (!ImportGLTFNode(scene, src, nodeID))
+        std::vector<uint32_t> imageSlots(m_GLTFModel.images.size(), 0);
+        auto useImage = [this, &imageSlots](int32_t textureIndex, nri::EMaterialTextureType type)
             {
-                NEB_LOG_ERROR("Failed to import node with nodeID {}", nodeID);
-                return false;
-            }
+                if (textureIndex < 0 || size_t(textureIndex) >= m_GLTFModel.textures.size())
+                    return;
+
+                const int32_t imageIndex = m_GLTFModel.textures[textureIndex].source;
+                if (imageIndex >= 0 && size_t(imageIndex) < imageSlots.size())
+                    imageSlots[imageIndex] |= (1 << type);
+            };
+
+        for (const tinygltf::Material& material : m_GLTFModel.materials)
+        {
+            useImage(material.pbrMetallicRoughness.baseColorTexture.index, nri::eMaterialTextureType_Albedo);
+            useImage(material.normalTexture.index, nri::eMaterialTextureType_Normal);
+            useImage(material.pbrMetallicRoughness.metallicRoughnessTexture.index, nri::eMaterialTextureType_RoughnessMetalness);
         }
-        return true;
+        return imageSlots;
     }
 
-    bool GLTFSceneImporter::SubmitD3D12Resources()
+    DXGI_FORMAT GLTFSceneImporter::GetImageSubresources(uint32_t imageIndex, std::vector<SceneCacheSubresourceSource>& subresources) const
     {
-        nri::NRIDevice& device = nri::NRIDevice::Get();
+        subresources.clear();
 
-        // Check if staging command list is created. If not - lazy initialize it
-        if (!m_stagingCommandList)
+        // Block compressed levels are described by their footprint, that is aligned to whole blocks
+        if (imageIndex < m_compressedImages.size() && !m_compressedImages[imageIndex].Levels.empty())
         {
-            nri::ThrowIfFailed(device.GetD3D12Device()->CreateCommandList1(0,
-                D3D12_COMMAND_LIST_TYPE_COPY,
-                D3D12_COMMAND_LIST_FLAG_NONE,
-                IID_PPV_ARGS(m_stagingCommandList.GetAddressOf())));
+            const CompressedTexture& compressed = m_compressedImages[imageIndex];
+            const uint32_t blockSize = GetBlockSize(compressed.Format);
+            for (const CompressedTextureLevel& level : compressed.Levels)
+            {
+                subresources.push_back(SceneCacheSubresourceSource{
+                    .Width = level.NumBlocksX * 4,
+                    .Height = level.NumBlocksY * 4,
+                    .NumBytesInRow = level.NumBlocksX * blockSize,
+                    .NumRows = level.NumBlocksY,
+                    .Data = compressed.Blocks.data() + level.Offset,
+                });
+            }
+            return GetTextureBlockDxgiFormat(compressed.Format);
         }
 
-        nri::CommandAllocatorPool& allocatorPool = device.GetCommandAllocatorPool(nri::eCommandContextType_Copy);
-        nri::D3D12Rc<ID3D12CommandAllocator> allocator = allocatorPool.QueryAllocator();
-        nri::ThrowIfFailed(m_stagingCommandList->Reset(allocator.Get(), nullptr));
+        // Source level is stored by tinygltf, the rest of the chain is generated (see GenerateImageMips)
+        const tinygltf::Image& src = m_GLTFModel.images[imageIndex];
+        NEB_ASSERT(src.component == 4, "Images are always uploaded as RGBA8");
+        subresources.push_back(SceneCacheSubresourceSource{
+            .Width = uint32_t(src.width),
+            .Height = uint32_t(src.height),
+            .NumBytesInRow = uint32_t(src.width * src.component),
+            .NumRows = uint32_t(src.height),
+            .Data = reinterpret_cast<const std::byte*>(src.image.data()),
+        });
+
+        if (imageIndex < m_imageMipChains.size())
         {
-            nri::ThrowIfFalse(SubmitD3D12Images());
-            nri::ThrowIfFalse(SubmitD3D12Buffers());
+            const TextureMipChain& mipChain = m_imageMipChains[imageIndex];
+            for (const TextureMipLevel& level : mipChain.Levels)
+            {
+                subresources.push_back(SceneCacheSubresourceSource{
+                    .Width = level.Width,
+                    .Height = level.Height,
+                    .NumBytesInRow = level.Width * uint32_t(src.component),
+                    .NumRows = level.Height,
+                    .Data = mipChain.Texels.data() + level.Offset,
+                });
+            }
         }
-        nri::ThrowIfFailed(m_stagingCommandList->Close());
-
-        ID3D12CommandList* pCommandLists[] = { m_stagingCommandList.Get() };
-        ID3D12CommandQueue* copyQueue = device.GetCommandQueue(nri::eCommandContextType_Copy);
-        copyQueue->ExecuteCommandLists(_countof(pCommandLists), pCommandLists);
-
-        nri::ThrowIfFailed(copyQueue->Signal(m_copyFence.Get(), ++m_copyFenceValue));
-        allocatorPool.DiscardAllocator(allocator, m_copyFence.Get(), m_copyFenceValue);
-        return true;
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
     }
 
-    bool GLTFSceneImporter::SubmitD3D12Images()
+    bool GLTFSceneImporter::SubmitD3D12Images(nri::UploadBatch& batch)
     {
         nri::NRIDevice& device = nri::NRIDevice::Get();
 
         const size_t numImages = m_GLTFModel.images.size();
         m_GLTFTextures.clear();
         m_GLTFTextures.resize(numImages);
-        m_stagingBuffers.reserve(m_stagingBuffers.size() + numImages);
 
+        std::vector<SceneCacheSubresourceSource> subresources;
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints;
+        std::vector<UINT> numRows;
+        std::vector<UINT64> numBytesInRow;
+        uint32_t numReusedTextures = 0;
+        uint64_t numReusedBytes = 0;
+
+        // Resource creation is cheap, keep it serial. Row-pitch repacking into staging memory is done by the upload service
         for (size_t i = 0; i < numImages; ++i)
         {
             // they cannot be valid here
@@ -146,14 +1154,22 @@ namespace Neb
 
             src.name = src.name.empty() ? std::format("gltf_image_{}", i) : src.name;
 
-            // Information for upload resource
-            D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
-            UINT numRows = 0;
-            UINT64 numBytesInRow, numTotalBytes;
+            // Same contents may already be uploaded by an earlier import
+            const DXGI_FORMAT format = GetImageSubresources(uint32_t(i), subresources);
+            const TextureRegistryKey registryKey = { .ContentHash = m_imageContentHashes[i], .Format = uint32_t(format) };
+            m_GLTFTextures[i] = GetTextureRegistry().Find(registryKey);
+            if (m_GLTFTextures[i])
+            {
+                const D3D12_RESOURCE_DESC resourceDesc = m_GLTFTextures[i]->GetDesc();
+                numReusedBytes += device.GetD3D12Device()->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+                ++numReusedTextures;
+                continue;
+            }
 
             // Destination resource
+            const UINT16 numMipLevels = static_cast<UINT16>(subresources.size());
+            D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, src.width, src.height, 1, numMipLevels);
             {
-                D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, src.width, src.height, 1, 1);
                 D3D12MA::Allocator* allocator = device.GetResourceAllocator();
                 D3D12MA::ALLOCATION_DESC allocDesc = {
                     .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
@@ -168,312 +1184,690 @@ namespace Neb
                     nullptr, allocation.GetAddressOf(),
                     IID_PPV_ARGS(m_GLTFTextures[i].ReleaseAndGetAddressOf())) // Release just in case despite we assume it is null
                 );
-
-                UINT numSubresources = resourceDesc.MipLevels * resourceDesc.DepthOrArraySize;
-                device.GetD3D12Device()->GetCopyableFootprints(
-                    &resourceDesc,
-                    0, numSubresources,
-                    0,
-                    &footprint,
-                    &numRows, &numBytesInRow, &numTotalBytes);
+                GetTextureRegistry().Add(registryKey, m_GLTFTextures[i], device.GetD3D12Device()->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes);
             }
             NEB_SET_HANDLE_NAME(m_GLTFTextures[i], "GLTFSceneImporter: Image '{}'", src.name);
-            
-            // Upload desc
-            nri::D3D12Rc<ID3D12Resource> uploadBuffer;
-            {
-                D3D12_RESOURCE_DESC uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{ .SizeInBytes = numTotalBytes, .Alignment = 0 });
-                D3D12MA::Allocator* allocator = device.GetResourceAllocator();
-                D3D12MA::ALLOCATION_DESC allocDesc = {
-                    .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-                    .HeapType = D3D12_HEAP_TYPE_UPLOAD,
-                };
-
-                nri::D3D12Rc<D3D12MA::Allocation> allocation;
-                nri::ThrowIfFailed(allocator->CreateResource(
-                    &allocDesc,
-                    &uploadDesc,
-                    D3D12_RESOURCE_STATE_GENERIC_READ, // This is the required starting state for an upload heap
-                    nullptr, allocation.GetAddressOf(),
-                    IID_PPV_ARGS(uploadBuffer.GetAddressOf())) // Release just in case despite we assume it is null
-                );
-                m_stagingBuffers.push_back(uploadBuffer);
 
-                // Now we want to map staging buffer and copy data into it
-                void* mapping = nullptr;
-                nri::ThrowIfFailed(uploadBuffer->Map(0, nullptr, &mapping));
+            // Only the layout of each subresource is needed, the service places them into staging memory on its own
+            const UINT numSubresources = resourceDesc.MipLevels * resourceDesc.DepthOrArraySize;
+            footprints.resize(numSubresources);
+            numRows.resize(numSubresources);
+            numBytesInRow.resize(numSubresources);
+            device.GetD3D12Device()->GetCopyableFootprints(
+                &resourceDesc,
+                0, numSubresources,
+                0,
+                footprints.data(),
+                numRows.data(), numBytesInRow.data(), nullptr);
 
-                // Copy each row into mapping
-                uint8_t* data = reinterpret_cast<uint8_t*>(mapping);
-                for (UINT i = 0; i < numRows; ++i)
-                {
-                    uint8_t* copyTo = data + (numBytesInRow * i);
-                    uint8_t* copyFrom = src.image.data() + (src.width * src.component * i);
-                    const size_t numBytesToCopy = src.width * src.component;
-                    std::memcpy(copyTo, copyFrom, numBytesToCopy);
-                }
+            for (UINT mip = 0; mip < numSubresources; ++mip)
+            {
+                // Rows of BC formats are rows of blocks
+                const SceneCacheSubresourceSource& subresource = subresources[mip];
+                NEB_ASSERT(subresource.NumBytesInRow == numBytesInRow[mip] && subresource.NumRows == numRows[mip], "Image subresources should match the footprint");
+                batch.AddTexture(m_GLTFTextures[i].Get(), mip, footprints[mip].Footprint, numRows[mip], numBytesInRow[mip], subresource.Data, subresource.NumBytesInRow);
             }
-            NEB_SET_HANDLE_NAME(uploadBuffer, "GLTFSceneImporter: Upload buffer for image '{}'", src.name);
-
-            // Finally, submit copy work from upload buffer to destination texture
-            D3D12_TEXTURE_COPY_LOCATION dstLocation = CD3DX12_TEXTURE_COPY_LOCATION(m_GLTFTextures[i].Get(), 0);
-            D3D12_TEXTURE_COPY_LOCATION srcLocation = CD3DX12_TEXTURE_COPY_LOCATION(uploadBuffer.Get(), footprint);
-            m_stagingCommandList->CopyTextureRegion(&dstLocation, 0, 0, 0, &srcLocation, nullptr);
         }
 
+        NEB_LOG_INFO("GLTFSceneImporter -> Reused {} textures of earlier imports ({:.1f} MB of video memory saved), {} textures ({:.1f} MB) are shared in total",
+            numReusedTextures,
+            numReusedBytes / (1024.0f * 1024.0f),
+            GetTextureRegistry().GetNumTextures(),
+            GetTextureRegistry().GetNumBytes() / (1024.0f * 1024.0f));
         return true;
     }
 
-    bool GLTFSceneImporter::SubmitD3D12Buffers()
+    bool GLTFSceneImporter::SubmitD3D12Buffers(nri::UploadBatch& batch)
     {
-        nri::NRIDevice& device = nri::NRIDevice::Get();
-
         const size_t numBuffers = m_GLTFModel.buffers.size();
         m_GLTFBuffers.clear();
         m_GLTFBuffers.resize(numBuffers);
-        m_stagingBuffers.reserve(m_stagingBuffers.size() + numBuffers);
 
         for (size_t i = 0; i < numBuffers; ++i)
         {
             tinygltf::Buffer& src = m_GLTFModel.buffers[i];
             src.name = src.name.empty() ? std::format("gltf_buffer_{}", i) : src.name;
 
-            SIZE_T numBytes = src.data.size();
+            std::span<const std::byte> bytes = m_bufferBytes[i];
+            m_GLTFBuffers[i] = CreateDefaultBuffer(bytes.size());
+            NEB_SET_HANDLE_NAME(m_GLTFBuffers[i], "GLTFSceneImporter: Buffer '{}'", src.name);
 
-            // destination
-            {
-                D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{ .SizeInBytes = numBytes, .Alignment = 0 });
-                D3D12MA::Allocator* allocator = device.GetResourceAllocator();
-                D3D12MA::ALLOCATION_DESC allocDesc = {
-                    .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-                    .HeapType = D3D12_HEAP_TYPE_DEFAULT,
-                };
+            batch.AddBuffer(m_GLTFBuffers[i].Get(), 0, bytes);
+        }
 
-                nri::D3D12Rc<D3D12MA::Allocation> allocation;
-                nri::ThrowIfFailed(allocator->CreateResource(
-                    &allocDesc,
-                    &resourceDesc,
-                    D3D12_RESOURCE_STATE_COMMON, // No need to use copy dest state. Buffers are effectively created in state D3D12_RESOURCE_STATE_COMMON.
-                    nullptr, allocation.GetAddressOf(),
-                    IID_PPV_ARGS(m_GLTFBuffers[i].GetAddressOf())));
-            }
-            NEB_SET_HANDLE_NAME(m_GLTFBuffers[i], "GLTFSceneImporter: Buffer '{}'", src.name);
+        return true;
+    }
 
-            nri::D3D12Rc<ID3D12Resource> uploadBuffer;
-            {
-                D3D12_RESOURCE_DESC uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{ .SizeInBytes = numBytes, .Alignment = 0 });
-                D3D12MA::Allocator* allocator = device.GetResourceAllocator();
-                D3D12MA::ALLOCATION_DESC allocDesc = {
-                    .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-                    .HeapType = D3D12_HEAP_TYPE_UPLOAD,
-                };
+    void GLTFSceneImporter::GenerateSubmeshTangents()
+    {
+        if (m_tangentGenerationDescs.empty())
+            return;
 
-                nri::D3D12Rc<D3D12MA::Allocation> allocation;
-                nri::ThrowIfFailed(allocator->CreateResource(
-                    &allocDesc,
-                    &uploadDesc,
-                    D3D12_RESOURCE_STATE_GENERIC_READ, // This is the required starting state for an upload heap
-                    nullptr, allocation.GetAddressOf(),
-                    IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
-                m_stagingBuffers.push_back(uploadBuffer);
+        uint64_t numTriangles = 0;
+        for (const TangentGenerationDesc& desc : m_tangentGenerationDescs)
+            numTriangles += desc.NumIndices / 3;
 
-                void* data;
-                nri::ThrowIfFailed(uploadBuffer->Map(0, nullptr, &data));
-                std::memcpy(data, src.data.data(), numBytes);
-                uploadBuffer->Unmap(0, nullptr);
-            }
-            NEB_SET_HANDLE_NAME(uploadBuffer, "GLTFSceneImporter: Upload buffer for buffer '{}'", src.name);
+        ThreadPool& threadPool = GetThreadPool();
 
-            m_stagingCommandList->CopyBufferRegion(m_GLTFBuffers[i].Get(), 0, uploadBuffer.Get(), 0, numBytes);
-        }
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        GenerateTangents(m_tangentGenerationDescs, threadPool);
 
-        return true;
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+        NEB_LOG_INFO("GLTFSceneImporter -> Generated tangents of {} submeshes ({} triangles) in {:.1f}ms on {} threads ({:.1f} Mtri/s)",
+            m_tangentGenerationDescs.size(),
+            numTriangles,
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            numTriangles / (std::max(elapsedMs, 0.001f) * 1000.0f));
+
+        m_tangentGenerationDescs.clear();
     }
 
-    bool GLTFSceneImporter::IsTangentPostprocessingNeeded()
+    void GLTFSceneImporter::OptimizeSubmeshes()
     {
+        std::vector<nri::StaticSubmesh*> submeshes;
         for (auto& scene : ImportedScenes)
             for (nri::StaticMesh& mesh : scene->StaticMeshes)
                 for (nri::StaticSubmesh& submesh : mesh.Submeshes)
                 {
-                    const bool hasRawTangents = !submesh.Attributes[nri::eAttributeType_Tangents].empty();
-                    if (hasRawTangents && !submesh.AttributeBuffers[nri::eAttributeType_Tangents])
-                        return true;
+                    if (submesh.NumIndices > 0 && submesh.NumIndices % 3 == 0)
+                        submeshes.push_back(&submesh);
                 }
 
-        return false;
+        if (submeshes.empty())
+            return;
+
+        struct SubmeshOptimizationResult
+        {
+            VertexCacheStatistics Before;
+            VertexCacheStatistics After;
+            uint32_t NumVerticesBefore = 0;
+            uint32_t NumVerticesAfter = 0;
+            uint64_t NumMaterializedBytes = 0;
+        };
+        std::vector<SubmeshOptimizationResult> results(submeshes.size());
+
+        ThreadPool& threadPool = GetThreadPool();
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        threadPool.ParallelFor(submeshes.size(), [&submeshes, &results](size_t i)
+            {
+                nri::StaticSubmesh& submesh = *submeshes[i];
+                SubmeshOptimizationResult& result = results[i];
+
+                const std::vector<uint32_t> indices = ReadIndices(submesh);
+                result.Before = SimulateVertexCache(indices, submesh.NumVertices);
+                result.NumVerticesBefore = submesh.NumVertices;
+
+                std::vector<uint32_t> optimizedIndices(indices.size());
+                OptimizeVertexCache(optimizedIndices, indices, submesh.NumVertices);
+
+                // Vertices are then ordered as the optimized triangles reference them, unreferenced ones are dropped
+                std::vector<uint32_t> remap(submesh.NumVertices);
+                const uint32_t numVertices = OptimizeVertexFetchRemap(remap, optimizedIndices);
+                RemapIndices(optimizedIndices, remap);
+                result.After = SimulateVertexCache(optimizedIndices, numVertices);
+                result.NumVerticesAfter = numVertices;
+
+                // Every stream is rewritten into tight storage. GPU buffers for them are created in SubmitPostprocessingD3D12Resources()
+                for (uint32_t j = 0; j < nri::eAttributeType_NumTypes; ++j)
+                {
+                    const nri::EAttributeType type = nri::EAttributeType(j);
+                    if (submesh.Attributes[type].empty())
+                        continue;
+
+                    const uint32_t elementSize = nri::StaticMeshAttributeSizes[submesh.VertexFormat][type];
+                    std::vector<std::byte> bytes(size_t(numVertices) * elementSize);
+                    RemapVertexStream(bytes.data(), submesh.Attributes[type].data(), submesh.AttributeStrides[type], elementSize, remap);
+                    result.NumMaterializedBytes += bytes.size();
+
+                    submesh.MaterializeAttribute(type, std::move(bytes));
+                    submesh.AttributeStrides[type] = elementSize;
+                    submesh.AttributeOffsets[type] = 0;
+                    submesh.AttributeBuffers[type] = nullptr;
+                    submesh.AttributeViews[type] = {};
+                }
+
+                // 8-bit indices are widened, as D3D12 index buffers do not support them. Remap never increases the amount of vertices,
+                // so 16-bit indices stay 16-bit
+                const UINT indicesStride = std::max<UINT>(submesh.IndicesStride, sizeof(uint16_t));
+                std::vector<std::byte> indexBytes(size_t(submesh.NumIndices) * indicesStride);
+                if (indicesStride == sizeof(uint16_t))
+                {
+                    for (size_t k = 0; k < optimizedIndices.size(); ++k)
+                    {
+                        const uint16_t index = static_cast<uint16_t>(optimizedIndices[k]);
+                        std::memcpy(indexBytes.data() + k * sizeof(uint16_t), &index, sizeof(uint16_t));
+                    }
+                }
+                else std::memcpy(indexBytes.data(), optimizedIndices.data(), indexBytes.size());
+                result.NumMaterializedBytes += indexBytes.size();
+
+                submesh.MaterializeIndices(std::move(indexBytes));
+                submesh.IndicesStride = indicesStride;
+                submesh.IndicesOffset = 0;
+                submesh.IndexBuffer = nullptr;
+                submesh.IBView = {};
+                submesh.NumVertices = numVertices;
+            });
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        VertexCacheStatistics totalBefore, totalAfter;
+        uint64_t numVerticesBefore = 0;
+        uint64_t numVerticesAfter = 0;
+        for (const SubmeshOptimizationResult& result : results)
+        {
+            numVerticesBefore += result.NumVerticesBefore;
+            numVerticesAfter += result.NumVerticesAfter;
+            totalBefore.NumTransformedVertices += result.Before.NumTransformedVertices;
+            totalBefore.NumTriangles += result.Before.NumTriangles;
+            totalBefore.NumReferencedVertices += result.Before.NumReferencedVertices;
+            totalAfter.NumTransformedVertices += result.After.NumTransformedVertices;
+            totalAfter.NumTriangles += result.After.NumTriangles;
+            totalAfter.NumReferencedVertices += result.After.NumReferencedVertices;
+            m_numCopiedBytes += result.NumMaterializedBytes;
+        }
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Optimized {} submeshes ({} triangles) in {:.1f}ms on {} threads: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} -> {} vertices",
+            submeshes.size(),
+            totalBefore.NumTriangles,
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            float(totalBefore.NumTransformedVertices) / std::max(totalBefore.NumTriangles, 1u),
+            float(totalAfter.NumTransformedVertices) / std::max(totalAfter.NumTriangles, 1u),
+            float(totalBefore.NumTransformedVertices) / std::max(totalBefore.NumReferencedVertices, 1u),
+            float(totalAfter.NumTransformedVertices) / std::max(totalAfter.NumReferencedVertices, 1u),
+            numVerticesBefore,
+            numVerticesAfter);
     }
 
-    bool GLTFSceneImporter::SubmitPostprocessingD3D12Resources()
+    void GLTFSceneImporter::BuildSubmeshLods()
     {
-        // The main goal if this method is to ensure that all of the post-processing work is submitted to the GPU
-        //
-        // Initial idea here was to handle manually calculated tangents, as we need to submit them into buffers as well
-        // And also we need to create buffer views for each submesh
-        nri::NRIDevice& device = nri::NRIDevice::Get();
-        NEB_ASSERT(m_stagingCommandList, "Command list for staging resources must already be created here");
+        std::vector<nri::StaticSubmesh*> submeshes;
+        std::vector<MeshSimplifierSourceDesc> srcs;
+        for (auto& scene : ImportedScenes)
+            for (nri::StaticMesh& mesh : scene->StaticMeshes)
+                for (nri::StaticSubmesh& submesh : mesh.Submeshes)
+                {
+                    // 8-bit indices are only widened by OptimizeSubmeshes(), such submeshes just do not get LODs otherwise
+                    if (submesh.NumIndices == 0 || submesh.NumIndices % 3 != 0 || submesh.IndicesStride == sizeof(uint8_t))
+                        continue;
+
+                    submeshes.push_back(&submesh);
+                    srcs.push_back(MeshSimplifierSourceDesc{
+                        .NumVertices = submesh.NumVertices,
+                        .Positions = submesh.Attributes[nri::eAttributeType_Position].data(),
+                        .PositionsStride = submesh.AttributeStrides[nri::eAttributeType_Position],
+                        .Normals = submesh.Attributes[nri::eAttributeType_Normal].data(),
+                        .NormalsStride = submesh.AttributeStrides[nri::eAttributeType_Normal],
+                        .TexCoords = submesh.Attributes[nri::eAttributeType_TexCoords].data(),
+                        .TexCoordsStride = submesh.AttributeStrides[nri::eAttributeType_TexCoords],
+                        .NumIndices = submesh.NumIndices,
+                        .IndicesStride = submesh.IndicesStride,
+                        .Indices = submesh.Indices.data(),
+                    });
+                }
 
-        nri::CommandAllocatorPool& allocatorPool = device.GetCommandAllocatorPool(nri::eCommandContextType_Copy);
-        nri::D3D12Rc<ID3D12CommandAllocator> allocator = allocatorPool.QueryAllocator();
-        nri::ThrowIfFailed(m_stagingCommandList->Reset(allocator.Get(), nullptr));
+        if (submeshes.empty())
+            return;
+
+        ThreadPool& threadPool = GetThreadPool();
+        const MeshLodDesc desc;
+        static_assert(MeshLodDesc().MaxLods <= SceneCacheMaxLods, "Scene cache should be able to store every LOD");
+        std::vector<MeshLodChain> chains(submeshes.size());
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        BuildMeshLodChains(chains, srcs, desc, threadPool);
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        // Errors only grow with the level, so the last one of every chain is its largest
+        size_t numLods = 0;
+        float maxError = 0.0f;
+        for (size_t i = 0; i < submeshes.size(); ++i)
         {
-            nri::ThrowIfFalse(SubmitTangentPostprocessingD3D12Buffer());
-        }
-        nri::ThrowIfFailed(m_stagingCommandList->Close());
+            MeshLodChain& chain = chains[i];
+            if (chain.Lods.size() <= 1)
+                continue;
 
-        ID3D12CommandList* pCommandLists[] = { m_stagingCommandList.Get() };
-        ID3D12CommandQueue* copyQueue = device.GetCommandQueue(nri::eCommandContextType_Copy);
-        copyQueue->ExecuteCommandLists(_countof(pCommandLists), pCommandLists);
+            numLods += chain.Lods.size() - 1;
+            maxError = std::max(maxError, chain.Lods.back().Error);
 
-        nri::ThrowIfFailed(copyQueue->Signal(m_copyFence.Get(), ++m_copyFenceValue));
-        allocatorPool.DiscardAllocator(allocator, m_copyFence.Get(), m_copyFenceValue);
-        return true;
+            // LODs only index the same vertices, thus the index stride stays the same
+            nri::StaticSubmesh& submesh = *submeshes[i];
+            std::vector<std::byte> indexBytes(chain.Indices.size() * submesh.IndicesStride);
+            if (submesh.IndicesStride == sizeof(uint16_t))
+            {
+                for (size_t k = 0; k < chain.Indices.size(); ++k)
+                {
+                    const uint16_t index = static_cast<uint16_t>(chain.Indices[k]);
+                    std::memcpy(indexBytes.data() + k * sizeof(uint16_t), &index, sizeof(uint16_t));
+                }
+            }
+            else std::memcpy(indexBytes.data(), chain.Indices.data(), indexBytes.size());
+            m_numCopiedBytes += indexBytes.size();
+
+            submesh.MaterializeIndices(std::move(indexBytes));
+            submesh.Lods = std::move(chain.Lods);
+            submesh.IndicesOffset = 0;
+            submesh.IndexBuffer = nullptr;
+            submesh.IBView = {};
+        }
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Built {} LODs of {} submeshes in {:.1f}ms on {} threads, max error {}",
+            numLods,
+            submeshes.size(),
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            maxError);
     }
-    //problem is here with that we reprocess tangents for everything
-    bool GLTFSceneImporter::SubmitTangentPostprocessingD3D12Buffer()
+
+    void GLTFSceneImporter::BuildSubmeshMeshlets()
     {
-        static constexpr size_t TangentStride = sizeof(Vec4);
+        if (!Config::GetValue<bool>(EConfigKey::BuildMeshlets, false))
+            return;
 
-        // Firstly we need to calculate the total amount of tangents in the entire scene hiearachy
-        uint32_t numTotalVertices = 0;
+        std::vector<nri::StaticSubmesh*> submeshes;
+        std::vector<MeshletSourceDesc> srcs;
+        std::vector<std::vector<float>> decodedPositions; // of compact submeshes (warm imports), moving does not invalidate them
         for (auto& scene : ImportedScenes)
             for (nri::StaticMesh& mesh : scene->StaticMeshes)
                 for (nri::StaticSubmesh& submesh : mesh.Submeshes)
                 {
-                    // We shoud assume that there are raw tangents everywhere
-                    NEB_ASSERT(!submesh.Attributes[nri::eAttributeType_Tangents].empty(), "No attributes in tangent buffer?");
-                    NEB_ASSERT(submesh.AttributeStrides[nri::eAttributeType_Tangents] == TangentStride, "Tangent stride differs from {}", TangentStride);
-                    numTotalVertices += submesh.NumVertices;
+                    // 8-bit indices are only widened by OptimizeSubmeshes(), such submeshes just do not get meshlets otherwise
+                    if (submesh.NumIndices == 0 || submesh.NumIndices % 3 != 0 || submesh.IndicesStride == sizeof(uint8_t))
+                        continue;
+
+                    const std::byte* positions = submesh.Attributes[nri::eAttributeType_Position].data();
+                    uint32_t positionsStride = submesh.AttributeStrides[nri::eAttributeType_Position];
+                    if (submesh.VertexFormat == nri::eVertexFormat_Compact)
+                    {
+                        std::vector<float>& decoded = decodedPositions.emplace_back(size_t(submesh.NumVertices) * 3);
+                        DecodePositions(decoded.data(),
+                            std::span(reinterpret_cast<const CompactPosition*>(positions), submesh.NumVertices),
+                            submesh.Quantization);
+
+                        positions = reinterpret_cast<const std::byte*>(decoded.data());
+                        positionsStride = sizeof(float) * 3;
+                    }
+
+                    submeshes.push_back(&submesh);
+                    srcs.push_back(MeshletSourceDesc{
+                        .NumVertices = submesh.NumVertices,
+                        .Positions = positions,
+                        .PositionsStride = positionsStride,
+                        .NumIndices = submesh.NumIndices,
+                        .IndicesStride = submesh.IndicesStride,
+                        .Indices = submesh.Indices.data(),
+                    });
                 }
 
-        NEB_ASSERT(numTotalVertices > 0, "Number of vertices cannot be 0 here...");
-        nri::NRIDevice& device = nri::NRIDevice::Get();
+        if (submeshes.empty())
+            return;
+
+        ThreadPool& threadPool = GetThreadPool();
+        const MeshletBuilderDesc desc;
+        std::vector<MeshletData> meshlets(submeshes.size());
 
-        size_t numTotalBytes = TangentStride * numTotalVertices;
-        nri::D3D12Rc<ID3D12Resource> tangentBuffer = m_GLTFBuffers.emplace_back();
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        BuildMeshlets(meshlets, srcs, desc, threadPool);
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        size_t numMeshlets = 0;
+        for (size_t i = 0; i < submeshes.size(); ++i)
         {
-            D3D12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{
-                .SizeInBytes = numTotalBytes,
-                .Alignment = 0 });
-            D3D12MA::Allocator* allocator = device.GetResourceAllocator();
-            D3D12MA::ALLOCATION_DESC allocDesc = {
-                .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-                .HeapType = D3D12_HEAP_TYPE_DEFAULT,
-            };
+            numMeshlets += meshlets[i].Meshlets.size();
+            submeshes[i]->Meshlets = std::move(meshlets[i]);
+        }
 
-            nri::D3D12Rc<D3D12MA::Allocation> allocation;
-            nri::ThrowIfFailed(allocator->CreateResource(
-                &allocDesc,
-                &resourceDesc,
-                D3D12_RESOURCE_STATE_COMMON, // No need to use copy dest state. Buffers are effectively created in state D3D12_RESOURCE_STATE_COMMON.
-                nullptr, allocation.GetAddressOf(),
-                IID_PPV_ARGS(tangentBuffer.GetAddressOf())));
+        NEB_LOG_INFO("GLTFSceneImporter -> Built {} meshlets ({} vertices, {} triangles max) for {} submeshes in {:.1f}ms on {} threads ({:.1f} K meshlets/s)",
+            numMeshlets,
+            desc.MaxVertices,
+            desc.MaxTriangles,
+            submeshes.size(),
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            numMeshlets / std::max(elapsedMs, 0.001f));
+    }
+
+    void GLTFSceneImporter::BuildMeshOccluders()
+    {
+        if (!Config::GetValue<bool>(EConfigKey::OcclusionCulling, false))
+            return;
+
+        // Occluders are rasterized every frame, submeshes that do not have a level within that amount are left out
+        static constexpr uint32_t MaxOccluderTrianglesPerSubmesh = 2048;
+
+        std::vector<nri::StaticMesh*> meshes;
+        for (auto& scene : ImportedScenes)
+            for (nri::StaticMesh& mesh : scene->StaticMeshes)
+                meshes.push_back(&mesh);
+
+        if (meshes.empty())
+            return;
+
+        ThreadPool& threadPool = GetThreadPool();
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        threadPool.ParallelFor(meshes.size(), [&meshes](size_t i)
+            {
+                nri::StaticMesh& mesh = *meshes[i];
+                std::vector<OccluderSourceDesc> srcs;
+                for (const nri::StaticSubmesh& submesh : mesh.Submeshes)
+                {
+                    if (submesh.NumIndices == 0 || submesh.NumIndices % 3 != 0 || submesh.IndicesStride == sizeof(uint8_t))
+                        continue;
+
+                    // Finest level that fits, Lods[0] (if there are any) is the full resolution
+                    MeshLod lod = MeshLod{ .FirstIndex = 0, .NumIndices = submesh.NumIndices };
+                    for (const MeshLod& level : submesh.Lods)
+                    {
+                        lod = level;
+                        if (level.NumIndices / 3 <= MaxOccluderTrianglesPerSubmesh)
+                            break;
+                    }
+                    if (lod.NumIndices / 3 > MaxOccluderTrianglesPerSubmesh)
+                        continue;
+
+                    const bool isCompact = submesh.VertexFormat == nri::eVertexFormat_Compact;
+                    srcs.push_back(OccluderSourceDesc{
+                        .NumVertices = submesh.NumVertices,
+                        .Positions = submesh.Attributes[nri::eAttributeType_Position].data(),
+                        .PositionsStride = submesh.AttributeStrides[nri::eAttributeType_Position],
+                        .Quantization = isCompact ? &submesh.Quantization : nullptr,
+                        .NumIndices = lod.NumIndices,
+                        .IndicesStride = submesh.IndicesStride,
+                        .Indices = submesh.Indices.data() + size_t(lod.FirstIndex) * submesh.IndicesStride,
+                    });
+                }
+                BuildOccluderMesh(mesh.Occluder, srcs);
+            });
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        size_t numOccluders = 0, numTriangles = 0;
+        for (const nri::StaticMesh* mesh : meshes)
+        {
+            numOccluders += mesh->Occluder.GetNumTriangles() > 0 ? 1 : 0;
+            numTriangles += mesh->Occluder.GetNumTriangles();
         }
-        NEB_SET_HANDLE_NAME(tangentBuffer, "GLTFSceneImporter: Buffer '{}'", std::format("gltf_tangent_buffer"));
 
-        nri::D3D12Rc<ID3D12Resource> uploadBuffer;
+        NEB_LOG_INFO("GLTFSceneImporter -> Built occluders of {} meshes ({} triangles) in {:.1f}ms on {} threads",
+            numOccluders,
+            numTriangles,
+            elapsedMs,
+            threadPool.GetNumThreads());
+    }
+
+    void GLTFSceneImporter::CompressSubmeshVertices()
+    {
+        std::vector<nri::StaticSubmesh*> submeshes;
+        std::vector<VertexCompressionSourceDesc> srcs;
+        for (auto& scene : ImportedScenes)
+            for (nri::StaticMesh& mesh : scene->StaticMeshes)
+                for (nri::StaticSubmesh& submesh : mesh.Submeshes)
+                {
+                    // Format covers all of the streams at once, tangents are always there after GenerateSubmeshTangents()
+                    const bool hasEveryAttribute = std::ranges::none_of(submesh.Attributes, [](std::span<const std::byte> attribute) { return attribute.empty(); });
+                    if (submesh.VertexFormat != nri::eVertexFormat_Full || submesh.NumVertices == 0 || !hasEveryAttribute)
+                        continue;
+
+                    submeshes.push_back(&submesh);
+                    srcs.push_back(VertexCompressionSourceDesc{
+                        .NumVertices = submesh.NumVertices,
+                        .Positions = submesh.Attributes[nri::eAttributeType_Position].data(),
+                        .PositionsStride = submesh.AttributeStrides[nri::eAttributeType_Position],
+                        .Normals = submesh.Attributes[nri::eAttributeType_Normal].data(),
+                        .NormalsStride = submesh.AttributeStrides[nri::eAttributeType_Normal],
+                        .TexCoords = submesh.Attributes[nri::eAttributeType_TexCoords].data(),
+                        .TexCoordsStride = submesh.AttributeStrides[nri::eAttributeType_TexCoords],
+                        .Tangents = submesh.Attributes[nri::eAttributeType_Tangents].data(),
+                        .TangentsStride = submesh.AttributeStrides[nri::eAttributeType_Tangents],
+                    });
+                }
+
+        if (submeshes.empty())
+            return;
+
+        ThreadPool& threadPool = GetThreadPool();
+        std::vector<CompressedVertexData> compressed(submeshes.size());
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+        CompressVertices(compressed, srcs, threadPool);
+        const float elapsedMs = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        // Round-trip is always checked, as it is the only way to find out if the source fits the format at all
+        std::vector<VertexCompressionError> errors(submeshes.size());
+        threadPool.ParallelFor(submeshes.size(), [&errors, &compressed, &srcs](size_t i)
+            {
+                errors[i] = MeasureVertexCompressionError(compressed[i], srcs[i]);
+            });
+
+        VertexCompressionError maxError;
+        uint64_t numVertices = 0, numBytesBefore = 0, numBytesAfter = 0;
+        for (size_t i = 0; i < submeshes.size(); ++i)
         {
-            D3D12_RESOURCE_DESC uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{
-                .SizeInBytes = numTotalBytes,
-                .Alignment = 0 });
-            D3D12MA::Allocator* allocator = device.GetResourceAllocator();
-            D3D12MA::ALLOCATION_DESC allocDesc = {
-                .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-                .HeapType = D3D12_HEAP_TYPE_UPLOAD,
+            nri::StaticSubmesh& submesh = *submeshes[i];
+            const VertexCompressionError& error = errors[i];
+            numVertices += submesh.NumVertices;
+            if (!IsVertexCompressionErrorAcceptable(error))
+            {
+                NEB_LOG_WARN("GLTFSceneImporter -> Submesh {} does not fit the compact vertex format and is kept as is "
+                    "(position {}, normal {} rad, texcoord {}, tangent {} rad, {} handedness mismatches)",
+                    i, error.MaxPositionError, error.MaxNormalAngle, error.MaxTexCoordError, error.MaxTangentAngle, error.NumHandednessMismatches);
+                continue;
+            }
+
+            maxError.MaxPositionError = std::max(maxError.MaxPositionError, error.MaxPositionError);
+            maxError.MaxNormalAngle = std::max(maxError.MaxNormalAngle, error.MaxNormalAngle);
+            maxError.MaxTexCoordError = std::max(maxError.MaxTexCoordError, error.MaxTexCoordError);
+            maxError.MaxTangentAngle = std::max(maxError.MaxTangentAngle, error.MaxTangentAngle);
+
+            // Streams are replaced with tight compressed ones. GPU buffers for them are created in SubmitPostprocessingD3D12Resources()
+            CompressedVertexData& data = compressed[i];
+            const std::array<std::span<const std::byte>, nri::eAttributeType_NumTypes> streams = {
+                std::as_bytes(std::span(data.Positions)),
+                std::as_bytes(std::span(data.Normals)),
+                std::as_bytes(std::span(data.TexCoords)),
+                std::as_bytes(std::span(data.Tangents)),
             };
+            for (uint32_t j = 0; j < nri::eAttributeType_NumTypes; ++j)
+            {
+                const nri::EAttributeType type = nri::EAttributeType(j);
+                numBytesBefore += size_t(submesh.NumVertices) * nri::StaticMeshAttributeSizes[nri::eVertexFormat_Full][type];
+                numBytesAfter += streams[type].size();
+
+                submesh.MaterializeAttribute(type, std::vector<std::byte>(streams[type].begin(), streams[type].end()));
+                submesh.AttributeStrides[type] = nri::StaticMeshAttributeSizes[nri::eVertexFormat_Compact][type];
+                submesh.AttributeOffsets[type] = 0;
+                submesh.AttributeBuffers[type] = nullptr;
+                submesh.AttributeViews[type] = {};
+            }
+            submesh.VertexFormat = nri::eVertexFormat_Compact;
+            submesh.Quantization = data.Quantization;
+        }
+        m_numCopiedBytes += numBytesAfter;
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Compressed vertices of {} submeshes in {:.1f}ms on {} threads ({:.1f} M vertices/s), {:.1f} MB -> {:.1f} MB",
+            submeshes.size(),
+            elapsedMs,
+            threadPool.GetNumThreads(),
+            numVertices / (std::max(elapsedMs, 0.001f) * 1000.0f),
+            numBytesBefore / (1024.0f * 1024.0f),
+            numBytesAfter / (1024.0f * 1024.0f));
+
+        NEB_LOG_INFO("GLTFSceneImporter -> Max round-trip error: position {} (of the box half-extent), normal {} rad, texcoord {} (relative), tangent {} rad",
+            maxError.MaxPositionError,
+            maxError.MaxNormalAngle,
+            maxError.MaxTexCoordError,
+            maxError.MaxTangentAngle);
+    }
 
-            nri::D3D12Rc<D3D12MA::Allocation> allocation;
-            nri::ThrowIfFailed(allocator->CreateResource(
-                &allocDesc,
-                &uploadDesc,
-                D3D12_RESOURCE_STATE_GENERIC_READ, // This is the required starting state for an upload heap
-                nullptr, allocation.GetAddressOf(),
-                IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
-            m_stagingBuffers.push_back(uploadBuffer);
-
-            // Map the data
-            void* mapping;
-            nri::ThrowIfFailed(uploadBuffer->Map(0, nullptr, &mapping));
-
-            // Now the idea here is for each submesh we would get its data and copy it to the offset buffer
-            // Afterwards we would create and offset information for that submesh
-            // and create a view for that submesh finally
-            std::byte* data = reinterpret_cast<std::byte*>(mapping);
-            size_t currentOffsetInBytes = 0;
-            for (auto& scene : ImportedScenes)
-                for (nri::StaticMesh& mesh : scene->StaticMeshes)
-                    for (nri::StaticSubmesh& submesh : mesh.Submeshes)
+    bool GLTFSceneImporter::IsGeometryPostprocessingNeeded()
+    {
+        for (auto& scene : ImportedScenes)
+            for (nri::StaticMesh& mesh : scene->StaticMeshes)
+                for (nri::StaticSubmesh& submesh : mesh.Submeshes)
+                {
+                    for (uint32_t i = 0; i < nri::eAttributeType_NumTypes; ++i)
                     {
-                        size_t numBytes = submesh.Attributes[nri::eAttributeType_Tangents].size();
-                        std::memcpy(data + currentOffsetInBytes, submesh.Attributes[nri::eAttributeType_Tangents].data(), numBytes);
+                        if (!submesh.Attributes[i].empty() && !submesh.AttributeBuffers[i])
+                            return true;
+                    }
 
-                        submesh.AttributeOffsets[nri::eAttributeType_Tangents] = currentOffsetInBytes;
-                        submesh.AttributeBuffers[nri::eAttributeType_Tangents] = tangentBuffer;
-                        submesh.AttributeViews[nri::eAttributeType_Tangents] = D3D12_VERTEX_BUFFER_VIEW{
-                            .BufferLocation = tangentBuffer->GetGPUVirtualAddress() + currentOffsetInBytes,
-                            .SizeInBytes = static_cast<UINT>(numBytes),
-                            .StrideInBytes = static_cast<UINT>(TangentStride),
-                        };
+                    if (!submesh.Indices.empty() && !submesh.IndexBuffer)
+                        return true;
+                }
 
-                        currentOffsetInBytes += numBytes;
-                    }
+        return false;
+    }
+
+    bool GLTFSceneImporter::SubmitPostprocessingD3D12Resources()
+    {
+        // The main goal if this method is to ensure that all of the post-processing work is submitted to the GPU
+        //
+        // Initial idea here was to handle manually calculated tangents, as we need to submit them into buffers as well
+        // And also we need to create buffer views for each submesh
+        nri::UploadBatch batch;
+        {
+            nri::ThrowIfFalse(SubmitGeometryPostprocessingD3D12Buffer(batch));
         }
-        NEB_SET_HANDLE_NAME(uploadBuffer, "GLTFSceneImporter: Upload buffer for '{}'", std::format("gltf_tangent_buffer"));
+        m_uploadTicket = nri::NRIDevice::Get().GetUploadService().Submit(batch, GetThreadPool());
+        return true;
+    }
+
+    bool GLTFSceneImporter::SubmitGeometryPostprocessingD3D12Buffer(nri::UploadBatch& batch)
+    {
+        // Every stream that has no GPU buffer yet is packed into a single buffer. Streams are tight, but each of them
+        // starts at 16 bytes, so that both input assembler and bindless access in the pathtracer are happy
+        static constexpr size_t StreamAlignment = 16;
+
+        auto forEachPendingStream = [this](auto&& func)
+            {
+                for (auto& scene : ImportedScenes)
+                    for (nri::StaticMesh& mesh : scene->StaticMeshes)
+                        for (nri::StaticSubmesh& submesh : mesh.Submeshes)
+                        {
+                            for (uint32_t i = 0; i < nri::eAttributeType_NumTypes; ++i)
+                            {
+                                const nri::EAttributeType type = nri::EAttributeType(i);
+                                if (!submesh.Attributes[type].empty() && !submesh.AttributeBuffers[type])
+                                    func(submesh, type);
+                            }
+
+                            if (!submesh.Indices.empty() && !submesh.IndexBuffer)
+                                func(submesh, nri::eAttributeType_NumTypes); // eAttributeType_NumTypes stands for indices here
+                        }
+            };
+
+        auto getStreamSize = [](const nri::StaticSubmesh& submesh, nri::EAttributeType type) -> size_t
+            {
+                return (type == nri::eAttributeType_NumTypes)
+                    ? size_t(submesh.GetNumStoredIndices()) * submesh.IndicesStride
+                    : size_t(submesh.NumVertices) * submesh.AttributeStrides[type];
+            };
+
+        // Firstly we need to calculate the total amount of bytes in the entire scene hiearachy
+        size_t numTotalBytes = 0;
+        forEachPendingStream([&numTotalBytes, &getStreamSize](nri::StaticSubmesh& submesh, nri::EAttributeType type)
+            {
+                numTotalBytes = AlignUp(numTotalBytes, StreamAlignment) + getStreamSize(submesh, type);
+            });
+
+        NEB_ASSERT(numTotalBytes > 0, "Number of bytes cannot be 0 here...");
+
+        nri::D3D12Rc<ID3D12Resource> geometryBuffer = CreateDefaultBuffer(numTotalBytes);
+        NEB_SET_HANDLE_NAME(geometryBuffer, "GLTFSceneImporter: Buffer '{}'", std::format("gltf_postprocessed_geometry_buffer"));
+        m_GLTFBuffers.push_back(geometryBuffer);
+
+        // Now the idea here is for each stream we would stage its data at the offset in the buffer
+        // Afterwards we would store offset information for that submesh and create a view for it finally.
+        // Streams are staged straight from submesh storage, they are not packed on the CPU beforehand
+        size_t currentOffsetInBytes = 0;
+        forEachPendingStream([&](nri::StaticSubmesh& submesh, nri::EAttributeType type)
+            {
+                currentOffsetInBytes = AlignUp(currentOffsetInBytes, StreamAlignment);
+                const size_t numBytes = getStreamSize(submesh, type);
+                const D3D12_GPU_VIRTUAL_ADDRESS location = geometryBuffer->GetGPUVirtualAddress() + currentOffsetInBytes;
+
+                if (type == nri::eAttributeType_NumTypes)
+                {
+                    batch.AddBuffer(geometryBuffer.Get(), currentOffsetInBytes, submesh.Indices.first(numBytes));
+                    submesh.IndicesOffset = currentOffsetInBytes;
+                    submesh.IndexBuffer = geometryBuffer;
+                    submesh.IBView = D3D12_INDEX_BUFFER_VIEW{
+                        .BufferLocation = location,
+                        .SizeInBytes = static_cast<UINT>(numBytes),
+                        .Format = GetIndexFormatFromStride(submesh.IndicesStride),
+                    };
+                }
+                else
+                {
+                    batch.AddBuffer(geometryBuffer.Get(), currentOffsetInBytes, submesh.Attributes[type].first(numBytes));
+                    submesh.AttributeOffsets[type] = currentOffsetInBytes;
+                    submesh.AttributeBuffers[type] = geometryBuffer;
+                    submesh.AttributeViews[type] = D3D12_VERTEX_BUFFER_VIEW{
+                        .BufferLocation = location,
+                        .SizeInBytes = static_cast<UINT>(numBytes),
+                        .StrideInBytes = submesh.AttributeStrides[type],
+                    };
+                }
 
-        m_stagingCommandList->CopyBufferRegion(tangentBuffer.Get(), 0, uploadBuffer.Get(), 0, numTotalBytes);
+                currentOffsetInBytes += numBytes;
+            });
         return true;
     }
 
     void GLTFSceneImporter::WaitD3D12ResourcesOnCopyQueue()
     {
-        nri::NRIDevice& device = nri::NRIDevice::Get();
-
         // At the very end, when we are done - wait asset processing for completion
-        if (m_copyFence->GetCompletedValue() < m_copyFenceValue)
-        {
-            // Wait until the fence is completed.
-            HANDLE fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-            NEB_ASSERT(fenceEvent != NULL, "Failed to create HANDLE for event");
-
-            nri::ThrowIfFailed(m_copyFence->SetEventOnCompletion(m_copyFenceValue, fenceEvent));
-            WaitForSingleObject(fenceEvent, INFINITE);
-        }
+        nri::NRIDevice::Get().GetUploadService().Wait(m_uploadTicket);
     }
 
-    bool GLTFSceneImporter::ImportGLTFNode(Scene* scene, tinygltf::Scene& src, int32_t nodeID)
+    bool GLTFSceneImporter::ImportGLTFNode(Scene* scene, tinygltf::Scene& src, int32_t nodeID, uint32_t parentNodeIndex)
     {
         NEB_ASSERT(nodeID >= 0, "Invalid node (-1) should not be passed here");
         tinygltf::Node& node = m_GLTFModel.nodes[nodeID];
 
+        // Nodes are visited depth-first, which is exactly the order SceneGraph expects. Nodes without meshes are still added,
+        // as they transform their children. World matrices are computed once the whole scene is imported
+        const uint32_t sceneNodeIndex = scene->Graph.AddNode(parentNodeIndex, GetNodeTransform(node));
+
         if (node.mesh != -1)
         {
-            nri::StaticMesh& staticMesh = scene->StaticMeshes.emplace_back();
-
-            // Get instance-to-world transformation before importing static mesh to calculate scene AABB correctly
-            staticMesh.InstanceToWorld = GetTransformationMatrix(node);
-
-            tinygltf::Mesh& mesh = m_GLTFModel.meshes[node.mesh];
-            if (!ImportStaticMesh(staticMesh, mesh, &scene->SceneBox))
+            // Each glTF mesh is imported only once per scene, every node referencing it just becomes its instance
+            NEB_ASSERT(node.mesh < int32_t(m_sceneMeshIndices.size()), "Invalid mesh index {}", node.mesh);
+            if (m_sceneMeshIndices[node.mesh] == InvalidMeshIndex)
             {
-                NEB_LOG_ERROR("GLTFSceneImporter::ImportScene -> Failed to import static mesh \"{}\"... Returning!", mesh.name);
-                return false;
+                tinygltf::Mesh& mesh = m_GLTFModel.meshes[node.mesh];
+                nri::StaticMesh& staticMesh = scene->StaticMeshes.emplace_back();
+                if (!ImportStaticMesh(staticMesh, mesh))
+                {
+                    NEB_LOG_ERROR("GLTFSceneImporter::ImportScene -> Failed to import static mesh \"{}\"... Returning!", mesh.name);
+                    return false;
+                }
+                m_sceneMeshIndices[node.mesh] = static_cast<uint32_t>(scene->StaticMeshes.size() - 1);
             }
-        }
-        else
-        {
-            // If node has no mesh still return true, as we dont want to fail on such nodes
-            NEB_LOG_WARN("GLTFSceneImporter::ImportScene -> Skipping node \"{}\" as it does not have mesh component", node.name);
+
+            scene->StaticMeshInstances.push_back(nri::StaticMeshInstance{
+                .MeshIndex = m_sceneMeshIndices[node.mesh],
+                .NodeIndex = sceneNodeIndex,
+            });
         }
 
         for (int32_t childID : node.children)
         {
-            if (!ImportGLTFNode(scene, src, childID))
+            if (!ImportGLTFNode(scene, src, childID, sceneNodeIndex))
                 return false;
         }
         return true;
     }
 
-    bool GLTFSceneImporter::ImportStaticMesh(nri::StaticMesh& mesh, tinygltf::Mesh& src, AABB* pUpdatedSceneAABB)
+    bool GLTFSceneImporter::ImportStaticMesh(nri::StaticMesh& mesh, tinygltf::Mesh& src)
     {
         // For glTF 2.0 Spec meshes overview chill here - https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#meshes-overview
         for (tinygltf::Primitive& primitive : src.primitives)
@@ -503,10 +1897,6 @@ namespace Neb
             // Set amount of vertices before processing (to get more healthy checks)
             submesh.NumVertices = m_GLTFModel.accessors[primitive.attributes["POSITION"]].count;
 
-            // update scene AABB for each position attribute
-            NEB_ASSERT(pUpdatedSceneAABB != nullptr);
-            AABB& sceneAABB = *pUpdatedSceneAABB;
-
             // Process each attribute separately
             for (auto& [attribute, type] : AttributeMap)
             {
@@ -515,29 +1905,8 @@ namespace Neb
                     continue;
 
                 tinygltf::Accessor& accessor = m_GLTFModel.accessors[primitive.attributes[attribute]];
-                if (type == nri::eAttributeType_Position)
-                {
-                    NEB_ASSERT(!accessor.minValues.empty(), "No 'minValue' in accessor {}", accessor.name);
-                    NEB_ASSERT(!accessor.maxValues.empty(), "No 'maxValue' in accessor {}", accessor.name);                    
-                    NEB_ASSERT(accessor.minValues.size() == 3 && accessor.maxValues.size() == 3, "only vec3");
-
-                    Vec4 min4 = Vec4::Transform(Vec4(
-                                                    float(accessor.minValues[0]),
-                                                    float(accessor.minValues[1]),
-                                                    float(accessor.minValues[2]), 1.0f),
-                        mesh.InstanceToWorld);
-                    Vec3 min = Vec3(min4.x, min4.y, min4.z);
-
-                    Vec4 max4 = Vec4::Transform(Vec4(
-                                                    float(accessor.maxValues[0]),
-                                                    float(accessor.maxValues[1]),
-                                                    float(accessor.maxValues[2]), 1.0f),
-                        mesh.InstanceToWorld);
-                    Vec3 max = Vec3(max4.x, max4.y, max4.z);
-
-                    sceneAABB.min = Vec3::Min(sceneAABB.min, min);
-                    sceneAABB.max = Vec3::Max(sceneAABB.max, max);
-                }
+                NEB_ASSERT(type != nri::eAttributeType_Position || (accessor.type == TINYGLTF_TYPE_VEC3 && accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT),
+                    "Only float3 positions are supported");
 
                 // should be equal, otherwise our bad
                 NEB_ASSERT(accessor.count == submesh.NumVertices, "Just a healthy check to ensure everything is correct up to this point");
@@ -545,20 +1914,9 @@ namespace Neb
                 // Buffer views are optional in specification of glTF 2.0, but they are required in tinygltf
                 // because tinygltf does not support sparse accessors
                 tinygltf::BufferView& bufferView = m_GLTFModel.bufferViews[accessor.bufferView];
-                tinygltf::Buffer& bytes = m_GLTFModel.buffers[bufferView.buffer];
-
-                // Copy buffer info, we treat it as a byte-stream
-                submesh.Attributes[type].clear();
-                submesh.Attributes[type].resize(bufferView.byteLength);
-                std::memcpy(
-                    submesh.Attributes[type].data(),
-                    bytes.data.data() + bufferView.byteOffset + accessor.byteOffset,
-                    bufferView.byteLength - accessor.byteOffset);
 
-                if (type == nri::eAttributeType_Tangents)
-                {
-                    auto x= 0; x =x;
-                }
+                // View buffer info, we treat it as a (possibly strided) byte-stream. Interleaved attributes view the same bytes
+                submesh.Attributes[type] = GetBufferViewBytes(accessor.bufferView).subspan(accessor.byteOffset);
 
                 // Store stride of an attribute as well (in bytes)
                 const UINT stride = UINT(accessor.ByteStride(bufferView));         // may become uint_max
@@ -575,25 +1933,24 @@ namespace Neb
                 };
             }
 
+            // Bounds are computed from positions themselves, as min/max of accessors are optional and may be loose.
+            // They are kept in mesh space, instances transform them themselves
+            ComputeBounds(submesh.Attributes[nri::eAttributeType_Position].data(), submesh.AttributeStrides[nri::eAttributeType_Position], submesh.NumVertices,
+                submesh.LocalBox, submesh.LocalSphere);
+
             // Now process indices
             if (primitive.indices >= 0)
             {
                 tinygltf::Accessor& accessor = m_GLTFModel.accessors[primitive.indices];
                 tinygltf::BufferView& bufferView = m_GLTFModel.bufferViews[accessor.bufferView];
-                tinygltf::Buffer& bytes = m_GLTFModel.buffers[bufferView.buffer];
 
                 // TODO: Check if that makes sense?
                 submesh.NumIndices = accessor.count;
 
-                // Copy buffer info, we treat it as a byte-stream
+                // View buffer info, we treat it as a byte-stream
                 submesh.IndicesStride = accessor.ByteStride(bufferView);
                 submesh.IndicesOffset = bufferView.byteOffset + accessor.byteOffset;
-                submesh.Indices.clear();
-                submesh.Indices.resize(bufferView.byteLength);
-                std::memcpy(
-                    submesh.Indices.data(),
-                    bytes.data.data() + bufferView.byteOffset + accessor.byteOffset,
-                    bufferView.byteLength - accessor.byteOffset);
+                submesh.Indices = GetBufferViewBytes(accessor.bufferView).subspan(accessor.byteOffset);
 
                 DXGI_FORMAT format;
                 switch (accessor.componentType)
@@ -636,96 +1993,31 @@ namespace Neb
                 NEB_ASSERT(primitive.mode == TINYGLTF_MODE_TRIANGLES, "We currently only support triangles");
                 NEB_ASSERT(submesh.NumIndices > 0 && submesh.NumIndices % 3 == 0, "Just to clarify there are no leftover indices");
 
-                Vec3* normals = reinterpret_cast<Vec3*>(submesh.Attributes[nri::eAttributeType_Normal].data());
-                Vec3* positions = reinterpret_cast<Vec3*>(submesh.Attributes[nri::eAttributeType_Position].data());
-                Vec2* texCoords = reinterpret_cast<Vec2*>(submesh.Attributes[nri::eAttributeType_TexCoords].data());
-
-                // Resize the target array of tangents
+                // Tangents are the only stream that is materialized, as it does not exist in the source.
+                // Storage is allocated right away, but filled later in GenerateSubmeshTangents() together with every other submesh
                 submesh.AttributeOffsets[nri::eAttributeType_Tangents] = 0;
                 submesh.AttributeStrides[nri::eAttributeType_Tangents] = sizeof(Vec4);
-                submesh.Attributes[nri::eAttributeType_Tangents].resize(sizeof(Vec4) * submesh.NumVertices);
-                Vec4* tangents = reinterpret_cast<Vec4*>(submesh.Attributes[nri::eAttributeType_Tangents].data());
-
-                // Needed for tangent and hardedness calculation
-                std::vector<Vec3> tan1(submesh.NumVertices);
-                std::vector<Vec3> tan2(submesh.NumVertices);
-
-                uint32_t numPrimitives = submesh.NumIndices / 3;
-                for (uint32_t i = 0; i < numPrimitives; ++i)
-                {
-                    static constexpr size_t kIndices32Stride = sizeof(uint32_t);
-                    static constexpr size_t kIndices16Stride = sizeof(uint16_t);
-
-                    // we handle both 32bit and 16bit indices here
-                    // https://gamedev.stackexchange.com/questions/68612/how-to-compute-tangent-and-bitangent-vectors
-                    uint32_t i0, i1, i2;
-                    if (submesh.IndicesStride == kIndices32Stride)
-                    {
-                        uint32_t* indices = reinterpret_cast<uint32_t*>(submesh.Indices.data());
-                        i0 = indices[(i * 3) + 0];
-                        i1 = indices[(i * 3) + 1];
-                        i2 = indices[(i * 3) + 2];
-                    }
-                    else
-                    {
-                        NEB_ASSERT(submesh.IndicesStride == kIndices16Stride,
-                            "Stride of indices should either be {} or {}",
-                            kIndices32Stride,
-                            kIndices16Stride);
-
-                        uint16_t* indices = reinterpret_cast<uint16_t*>(submesh.Indices.data());
-                        i0 = indices[(i * 3) + 0];
-                        i1 = indices[(i * 3) + 1];
-                        i2 = indices[(i * 3) + 2];
-                    }
-
-                    const Vec3& pos0 = positions[i0];
-                    const Vec3& pos1 = positions[i1];
-                    const Vec3& pos2 = positions[i2];
-                    Vec3 deltaPos1 = pos1 - pos0;
-                    Vec3 deltaPos2 = pos2 - pos0;
-
-                    const Vec2& uv0 = texCoords[i0];
-                    const Vec2& uv1 = texCoords[i1];
-                    const Vec2& uv2 = texCoords[i2];
-                    Vec2 deltaUv1 = uv1 - uv0;
-                    Vec2 deltaUv2 = uv2 - uv0;
-
-                    float r = 1.0f / (deltaUv1.x * deltaUv2.y - deltaUv1.y * deltaUv2.x);
-                    Vec3 sd = (deltaPos1 * deltaUv2.y - deltaPos2 * deltaUv1.y) * r;
-                    Vec3 td = (deltaPos2 * deltaUv1.x - deltaPos1 * deltaUv2.x) * r;
-
-                    // TODO: From glTF 2.0 spec https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#geometry-overview
-                    // Tangent is stored in Vec4, where Vec4.w is a sign value indicating handedness of the tangent basis
-                    // We can use that information to calculate bitangent efficiently
-                    // We will manually convert signed tangents from glTF to vec3 tangents/bitangents
-                    tan1[i0] += sd;
-                    tan2[i0] += td;
-                    tan1[i1] += sd;
-                    tan2[i1] += td;
-                    tan1[i2] += sd;
-                    tan2[i2] += td;
-                }
-
-                for (uint32_t i = 0; i < submesh.NumVertices; ++i)
-                {
-                    const Vec3& n = normals[i];
-                    const Vec3& t = tan1[i];
-
-                    // Gram-Schmidt orthogonalize
-                    Vec3 tangent;
-                    tangent = (t - n * n.Dot(t));
-                    tangent.Normalize();
-
-                    tangents[i].x = tangent.x;
-                    tangents[i].y = tangent.y;
-                    tangents[i].z = tangent.z;
-
-                    // calculate handedness
-                    tangents[i].w = (n.Cross(t).Dot(tan2[i]) < 0.0f) ? -1.0f : 1.0f;
-                }
+                submesh.MaterializeAttribute(nri::eAttributeType_Tangents, std::vector<std::byte>(sizeof(Vec4) * submesh.NumVertices));
+                m_numCopiedBytes += submesh.AttributeStorage[nri::eAttributeType_Tangents].size();
+
+                // Storage of a vector is not relocated when submesh is moved, so it is safe to reference it
+                m_tangentGenerationDescs.push_back(TangentGenerationDesc{
+                    .NumVertices = submesh.NumVertices,
+                    .Positions = submesh.Attributes[nri::eAttributeType_Position].data(),
+                    .PositionsStride = submesh.AttributeStrides[nri::eAttributeType_Position],
+                    .Normals = submesh.Attributes[nri::eAttributeType_Normal].data(),
+                    .NormalsStride = submesh.AttributeStrides[nri::eAttributeType_Normal],
+                    .TexCoords = submesh.Attributes[nri::eAttributeType_TexCoords].data(),
+                    .TexCoordsStride = submesh.AttributeStrides[nri::eAttributeType_TexCoords],
+                    .NumIndices = submesh.NumIndices,
+                    .IndicesStride = submesh.IndicesStride,
+                    .Indices = submesh.Indices.data(),
+                    .Tangents = reinterpret_cast<float*>(submesh.AttributeStorage[nri::eAttributeType_Tangents].data()),
+                });
             }
 
+            m_submeshMaterialIndices.push_back((primitive.material >= 0) ? uint32_t(primitive.material) : SceneCacheInvalidIndex);
+
             // Process submesh material
             nri::Material& material = mesh.SubmeshMaterials.emplace_back();
 
@@ -771,10 +2063,12 @@ namespace Neb
                 NEB_LOG_WARN("Submesh of mesh {} doesnt have material. Skipping material part", src.name);
             }
         }
+
+        mesh.UpdateBounds();
         return true;
     }
 
-    Mat4 GLTFSceneImporter::GetTransformationMatrix(tinygltf::Node& node)
+    SceneNodeTransform GLTFSceneImporter::GetNodeTransform(tinygltf::Node& node)
     {
         const bool hasTransformationMatrix = !node.matrix.empty();
 
@@ -791,14 +2085,20 @@ namespace Neb
                     transform(col, row) = node.matrix.at(row * 4 + col);
                 }
             }
-            return transform;
+
+            // Graph only stores TRS, glTF requires matrices to be decomposable anyway
+            SceneNodeTransform result;
+            if (!DecomposeSceneNodeTransform(transform, result))
+                NEB_LOG_WARN("GLTFSceneImporter -> Matrix of node \"{}\" is not a TRS transform, its shear is dropped", node.name);
+            return result;
         }
 
         // else if no ready transformation to use - construct own
-        Mat4 t = Mat4::CreateTranslation(node.translation.empty() ? Vec3() : Vec3(node.translation[0], node.translation[1], node.translation[2]));
-        Mat4 r = Mat4::CreateFromQuaternion(node.rotation.empty() ? Quaternion() : Quaternion(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]));
-        Mat4 s = Mat4::CreateScale(node.scale.empty() ? Vec3(1.0f) : Vec3(node.scale[0], node.scale[1], node.scale[2]));
-        return s * r * t;
+        return SceneNodeTransform{
+            .Translation = node.translation.empty() ? Vec3() : Vec3(node.translation[0], node.translation[1], node.translation[2]),
+            .Rotation = node.rotation.empty() ? Quaternion() : Quaternion(node.rotation[0], node.rotation[1], node.rotation[2], node.rotation[3]),
+            .Scale = node.scale.empty() ? Vec3(1.0f) : Vec3(node.scale[0], node.scale[1], node.scale[2]),
+        };
     }
 
     nri::D3D12Rc<ID3D12Resource> GLTFSceneImporter::GetTextureFromGLTFScene(int32_t index)
@@ -810,7 +2110,7 @@ namespace Neb
         tinygltf::Texture& location = m_GLTFModel.textures[index];
 
         NEB_ASSERT(location.source >= 0, "Texture should always have a location? Not sure. Check if hit");
-        nri::D3D12Rc<ID3D12Resource> srcTexture = m_GLTFTextures[location.source];
+        nri::D3D12Rc<ID3D12Resource> srcTexture = m_GLTFTextures[m_imageSources[location.source]];
         return srcTexture;
     }
 
@@ -827,7 +2127,9 @@ namespace Neb
         // https://microsoft.github.io/DirectX-Specs/d3d/ResourceBinding.html#null-descriptors
         // passing NULL for the resource pointer in the descriptor definition achieves the effect of an 'unbound' resource.
         nri::NRIDevice& device = nri::NRIDevice::Get();
-        device.GetD3D12Device()->CreateShaderResourceView(resource, (resource) ? nullptr : &NullDescriptorSrvDesc, handle);
+        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
+        const bool hasSrvDesc = nri::GetMaterialTextureSrvDesc(srvDesc, resource, type);
+        device.GetD3D12Device()->CreateShaderResourceView(resource, (resource) ? (hasSrvDesc ? &srvDesc : nullptr) : &NullDescriptorSrvDesc, handle);
     }
 
 } // Neb namespace
\ No newline at end of file
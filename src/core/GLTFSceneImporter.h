@@ -1,9 +1,18 @@
 #pragma once
 
 #include "Scene.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshTangents.h"
+#include "SceneCache.h"
+#include "TextureCompression.h"
+#include "TextureProcessing.h"
+#include "TextureRegistry.h"
+#include "VertexCompression.h"
 #include "../nri/stdafx.h"
 #include "../nri/DescriptorHeapAllocation.h"
-#include "../nri/CommandAllocatorPool.h"
+#include "../nri/UploadService.h"
 #include "../util/ScopedPointer.h"
 
 #include <TinyGLTF/tiny_gltf.h>
@@ -11,6 +20,7 @@
 #include <filesystem>
 #include <vector>
 #include <memory>
+#include <span>
 
 namespace Neb
 {
@@ -24,14 +34,34 @@ namespace Neb
         Binary
     };
 
+    // Of the last import, the same numbers that are logged
+    struct GLTFImportStats
+    {
+        bool IsWarm = false; // imported from the scene cache
+        float Milliseconds = 0.0f;
+        uint64_t NumCopiedBytes = 0; // into CPU-side storage, excluding GPU staging
+        uint64_t NumMappedBytes = 0; // of the scene cache, warm imports only
+    };
+
     class GLTFSceneImporter
     {
     public:
-        GLTFSceneImporter();
+        GLTFSceneImporter() = default;
+
+        // Textures are shared through sharedTextureRegistry instead of the own one, so that separate importers
+        // (see SceneLoader) share textures with each other. Every job of the import (including upload fills) runs on threadPool
+        // instead of the shared ThreadPool::Get(), if there is one. Both should outlive the importer
+        explicit GLTFSceneImporter(TextureRegistry* sharedTextureRegistry, ThreadPool* threadPool = nullptr)
+            : m_sharedTextureRegistry(sharedTextureRegistry)
+            , m_threadPool(threadPool)
+        {
+        }
 
         bool ImportScenesFromFile(const std::filesystem::path& filepath, EGLTFType type = EGLTFType::AsciiFile);
         void Clear();
 
+        const GLTFImportStats& GetImportStats() const { return m_importStats; }
+
         // Maybe make them private? Dont really care now
         std::vector<Scoped<Scene>> ImportedScenes;
 
@@ -40,38 +70,125 @@ namespace Neb
         // some warning will be logged
         bool ImportScene(Scene* scene, tinygltf::Scene& src);
 
+        // Warm path. Feeds the upload path directly from the memory-mapped .nebscene, tinygltf is not touched at all
+        bool ImportScenesFromCache(const SceneCacheReader& reader);
+        bool SubmitD3D12ResourcesFromCache(const SceneCacheReader& reader);
+        void InitMaterialFromCache(nri::Material& material, const SceneCacheMaterial& src);
+
+        // Cold path. Everything is baked at the very end from imported scenes, thus generated tangents are baked as well
+        bool WriteSceneCache(const std::filesystem::path& cachePath, const std::filesystem::path& filepath, uint64_t bakedPasses);
+
+        // External files of buffers and images of the parsed glTF, relative to it. Sorted, data uris are not files
+        std::vector<std::filesystem::path> GetSourceFiles() const;
+
+        nri::D3D12Rc<ID3D12Resource> CreateDefaultBuffer(UINT64 numBytes);
+
+        // Resolves bytes of every glTF buffer. For binary glTF the BIN chunk is viewed in the mapping instead of tinygltf copy
+        void InitBufferViews();
+        std::span<const std::byte> GetBufferViewBytes(int32_t bufferViewIndex) const;
+
         // We want to immediately convert all the images of the scene to D3D12 resources
         // so that we avoid lazy-loading them as well as loading them more than once
+        bool DecodeImages();
+
+        // Hashes decoded texels of every image (see TextureRegistryKey). Images with the same contents as an earlier one
+        // are dropped before any processing, materials use the first one instead
+        void DeduplicateImages(uint64_t processingSeed);
+        void GenerateImageMips(); // optional (EConfigKey::GenerateMipmaps), filtering of each image depends on the material slots it uses
+
+        // Optional pass (EConfigKey::CompressTextures). Block format of each image depends on the material slots it uses,
+        // images of sizes that are not a multiple of 4 stay uncompressed. Runs after mips are generated, so they are compressed as well
+        void CompressImages();
+
+        // Bit (1 << nri::EMaterialTextureType) is set for every material slot that the glTF image is used in
+        std::vector<uint32_t> GetImageMaterialSlots() const;
+
+        // Subresources of the image as they are uploaded and baked (compressed, mips) with their format. Rows are tightly packed
+        DXGI_FORMAT GetImageSubresources(uint32_t imageIndex, std::vector<SceneCacheSubresourceSource>& subresources) const;
+
+        // Copies of every resource go into a single batch of the upload service, see m_uploadTicket
         bool SubmitD3D12Resources();
-        bool SubmitD3D12Images();
-        bool SubmitD3D12Buffers();
+        bool SubmitD3D12Images(nri::UploadBatch& batch);
+        bool SubmitD3D12Buffers(nri::UploadBatch& batch);
         void WaitD3D12ResourcesOnCopyQueue();
 
-        bool IsTangentPostprocessingNeeded();
+        // Tangents of every submesh that has none in the source are generated at once, after all scenes are imported
+        void GenerateSubmeshTangents();
+
+        // Optional pass (EConfigKey::OptimizeMeshes), that reorders triangles and vertices of every submesh for
+        // post-transform cache and vertex fetch. Runs after tangents are generated, so they are reordered as well
+        void OptimizeSubmeshes();
+
+        // Optional pass (EConfigKey::BuildMeshLods). LOD indices are appended to the indices of each submesh and baked
+        void BuildSubmeshLods();
+
+        // Optional pass (EConfigKey::BuildMeshlets). Meshlets are not baked, so it runs on both cold and warm imports
+        void BuildSubmeshMeshlets();
+
+        // Optional pass (EConfigKey::OcclusionCulling). Occluders are not baked, they are merged from submeshes (or their LODs) on both
+        // cold and warm imports. Runs after every pass that rewrites positions or indices
+        void BuildMeshOccluders();
+
+        // Optional pass (EConfigKey::CompactVertexFormat). Runs last on the cold path, as every other pass expects float streams.
+        // Compressed streams are baked, submeshes that do not fit the format (see IsVertexCompressionErrorAcceptable) stay in the full one
+        void CompressSubmeshVertices();
+
+        // Streams that were materialized on import (generated tangents, optimized geometry) have no GPU buffers yet
+        bool IsGeometryPostprocessingNeeded();
         bool SubmitPostprocessingD3D12Resources();
-        bool SubmitTangentPostprocessingD3D12Buffer();
+        bool SubmitGeometryPostprocessingD3D12Buffer(nri::UploadBatch& batch);
 
         // Node processing
-        bool ImportGLTFNode(Scene* scene, tinygltf::Scene& src, int32_t nodeID);
-        bool ImportStaticMesh(nri::StaticMesh& mesh, tinygltf::Mesh& src, AABB* pUpdatedSceneAABB);
+        bool ImportGLTFNode(Scene* scene, tinygltf::Scene& src, int32_t nodeID, uint32_t parentNodeIndex);
+        bool ImportStaticMesh(nri::StaticMesh& mesh, tinygltf::Mesh& src);
+
+        SceneNodeTransform GetNodeTransform(tinygltf::Node& node);
 
-        Mat4 GetTransformationMatrix(tinygltf::Node& node);
+        TextureRegistry& GetTextureRegistry() { return m_sharedTextureRegistry ? *m_sharedTextureRegistry : m_textureRegistry; }
+        ThreadPool& GetThreadPool() const { return m_threadPool ? *m_threadPool : ThreadPool::Get(); }
 
         nri::D3D12Rc<ID3D12Resource> GetTextureFromGLTFScene(int32_t index);
         void InitMaterialTextureDescriptor(ID3D12Resource* resource, nri::EMaterialTextureType type, const nri::DescriptorHeapAllocation& heapAllocation);
 
+        // Only valid during cold import, if scene cache is enabled
+        Scoped<SceneCacheWriter> m_sceneCacheWriter;
+
+        // Sources that imported scenes view into. They are only released in Clear() together with scenes
+        MappedFile m_sourceFile; // binary glTF only
+        SceneCacheReader m_sceneCacheReader;
+        std::vector<std::span<const std::byte>> m_bufferBytes; // per glTF buffer
+
+        // glTF mesh index -> index of the static mesh in the scene that is currently imported, if it was imported already
+        std::vector<uint32_t> m_sceneMeshIndices;
+
+        // Submeshes, that need their tangents generated. Filled by ImportStaticMesh
+        std::vector<TangentGenerationDesc> m_tangentGenerationDescs;
+
+        // glTF material index of every imported submesh in import order, needed to bake submeshes into the cache
+        std::vector<uint32_t> m_submeshMaterialIndices;
+
+        // Import statistics, amount of bytes copied into CPU-side storage (excluding GPU staging)
+        uint64_t m_numCopiedBytes = 0;
+        GLTFImportStats m_importStats;
+
         tinygltf::TinyGLTF m_GLTFLoader;
         tinygltf::Model m_GLTFModel;
 
         std::vector<nri::D3D12Rc<ID3D12Resource>> m_GLTFTextures;
+        std::vector<uint64_t> m_imageContentHashes; // per glTF image, 0 if it failed to decode
+        std::vector<uint32_t> m_imageSources; // per glTF image, index of the first image with the same contents (itself if unique)
+        std::vector<TextureMipChain> m_imageMipChains; // per glTF image, empty if mips were not generated
+        std::vector<CompressedTexture> m_compressedImages; // per glTF image, without levels if it was not compressed
         std::vector<nri::D3D12Rc<ID3D12Resource>> m_GLTFBuffers;
-        std::vector<nri::D3D12Rc<ID3D12Resource>> m_stagingBuffers; // upload resources that are currently being used
 
-        // TODO: I am not sure how to handle this best, but I think using own command allocators and fences here
-        // would make it more sustainable + we could handle renderer waiting on assets better on outer layer in Nebulae easier
-        nri::D3D12Rc<ID3D12GraphicsCommandList> m_stagingCommandList;
-        nri::D3D12Rc<ID3D12Fence> m_copyFence;
-        UINT64 m_copyFenceValue = 0;
+        // Not cleaned in Clear(), so that textures are shared with scenes of earlier imports that are still alive.
+        // Own registry is only used if there is no shared one, see GetTextureRegistry()
+        TextureRegistry m_textureRegistry;
+        TextureRegistry* m_sharedTextureRegistry = nullptr;
+        ThreadPool* m_threadPool = nullptr;
+
+        // Last submission to the upload service, imported resources can only be used by the GPU once it is completed
+        nri::UploadTicket m_uploadTicket = 0;
     };
 
 }
\ No newline at end of file
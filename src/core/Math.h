@@ -3,6 +3,7 @@
 #include <numbers>
 #include <concepts>
 #include <limits>
+#include <cstdint>
 
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN // Exclude rarely-used stuff from Windows headers.
@@ -67,6 +68,30 @@ namespace Neb
         Vec3 max = Vec3(-Inf);
     };
 
+    inline void ExtendAABB(AABB& box, const AABB& other)
+    {
+        box.min = Vec3::Min(box.min, other.min);
+        box.max = Vec3::Max(box.max, other.max);
+    }
+
+    // Transforming only min and max is not enough under rotation, box of all 8 corners is taken instead
+    inline AABB TransformAABB(const AABB& box, const Mat4& transform)
+    {
+        AABB result;
+        for (uint32_t i = 0; i < 8; ++i)
+        {
+            const Vec3 corner = Vec3(
+                (i & 1) ? box.max.x : box.min.x,
+                (i & 2) ? box.max.y : box.min.y,
+                (i & 4) ? box.max.z : box.min.z);
+
+            const Vec3 transformed = Vec3::Transform(corner, transform);
+            result.min = Vec3::Min(result.min, transformed);
+            result.max = Vec3::Max(result.max, transformed);
+        }
+        return result;
+    }
+
 #if 0
     template<typename T> 
     int32_t Signum(T val) { return (T(0) < val) - (val < T(0)); }
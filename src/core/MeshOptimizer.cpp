@@ -0,0 +1,268 @@
+#include "MeshOptimizer.h"
+
+#include "../common/Assert.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace Neb
+{
+
+    namespace
+    {
+        static constexpr uint32_t InvalidTriangleIndex = UINT32_MAX;
+
+        // Scoring parameters are the ones from the original paper
+        static constexpr uint32_t ForsythCacheSize = 32;
+        static constexpr float ForsythCacheDecayPower = 1.5f;
+        static constexpr float ForsythLastTriangleScore = 0.75f;
+        static constexpr float ForsythValenceBoostScale = 2.0f;
+        static constexpr float ForsythValenceBoostPower = 0.5f;
+        static constexpr uint32_t ForsythMaxPrecomputedValence = 32;
+
+        struct ForsythScoreTable
+        {
+            ForsythScoreTable()
+            {
+                for (uint32_t i = 0; i < ForsythCacheSize; ++i)
+                {
+                    if (i < 3)
+                    {
+                        // Vertices of the last triangle get a fixed score, otherwise it is too easy to pick the same triangle
+                        // (from the other side) again, which is bad for strip-like orders
+                        CachePositionScores[i] = ForsythLastTriangleScore;
+                        continue;
+                    }
+
+                    const float scaler = 1.0f / (ForsythCacheSize - 3);
+                    CachePositionScores[i] = std::pow(1.0f - (i - 3) * scaler, ForsythCacheDecayPower);
+                }
+
+                ValenceScores[0] = 0.0f;
+                for (uint32_t i = 1; i < ForsythMaxPrecomputedValence; ++i)
+                    ValenceScores[i] = ForsythValenceBoostScale * std::pow(float(i), -ForsythValenceBoostPower);
+            }
+
+            std::array<float, ForsythCacheSize> CachePositionScores;
+            std::array<float, ForsythMaxPrecomputedValence> ValenceScores;
+        };
+
+        float GetForsythVertexScore(const ForsythScoreTable& table, uint32_t cachePosition, uint32_t numRemainingTriangles)
+        {
+            // Vertex is not needed anymore
+            if (numRemainingTriangles == 0)
+                return -1.0f;
+
+            float score = (cachePosition < ForsythCacheSize) ? table.CachePositionScores[cachePosition] : 0.0f;
+
+            // Bonus for vertices with few remaining triangles, so that lone triangles are not left behind
+            score += (numRemainingTriangles < ForsythMaxPrecomputedValence)
+                ? table.ValenceScores[numRemainingTriangles]
+                : ForsythValenceBoostScale * std::pow(float(numRemainingTriangles), -ForsythValenceBoostPower);
+            return score;
+        }
+    } // anonymous namespace
+
+    VertexCacheStatistics SimulateVertexCache(std::span<const uint32_t> indices, uint32_t numVertices, uint32_t cacheSize)
+    {
+        NEB_ASSERT(indices.size() % 3 == 0, "Only triangle lists are supported");
+        NEB_ASSERT(cacheSize > 0, "Cache should hold at least one vertex");
+
+        VertexCacheStatistics statistics;
+        statistics.NumTriangles = static_cast<uint32_t>(indices.size() / 3);
+
+        // Instead of an actual FIFO each vertex remembers the time it entered the cache.
+        // It is still in the cache if less than cacheSize other vertices have entered it since then
+        std::vector<uint32_t> timestamps(numVertices, 0);
+        uint32_t time = cacheSize + 1;
+        for (uint32_t index : indices)
+        {
+            NEB_ASSERT(index < numVertices, "Index {} is out of bounds ({} vertices)", index, numVertices);
+            if (timestamps[index] == 0)
+                ++statistics.NumReferencedVertices;
+
+            if (time - timestamps[index] > cacheSize)
+            {
+                timestamps[index] = time++;
+                ++statistics.NumTransformedVertices;
+            }
+        }
+
+        if (statistics.NumTriangles > 0)
+        {
+            statistics.ACMR = float(statistics.NumTransformedVertices) / statistics.NumTriangles;
+            statistics.ATVR = float(statistics.NumTransformedVertices) / statistics.NumReferencedVertices;
+        }
+        return statistics;
+    }
+
+    void OptimizeVertexCache(std::span<uint32_t> dstIndices, std::span<const uint32_t> indices, uint32_t numVertices)
+    {
+        NEB_ASSERT(dstIndices.size() == indices.size(), "Destination should be able to hold every index");
+        NEB_ASSERT(dstIndices.data() != indices.data(), "Vertex cache optimization cannot be done in-place");
+        NEB_ASSERT(indices.size() % 3 == 0, "Only triangle lists are supported");
+
+        const uint32_t numTriangles = static_cast<uint32_t>(indices.size() / 3);
+        if (numTriangles == 0)
+            return;
+
+        static const ForsythScoreTable scoreTable;
+
+        // Vertex -> triangles adjacency. Triangles of a vertex are kept in [offset, offset + numRemaining),
+        // emitted triangles are swapped out of that range
+        std::vector<uint32_t> numRemainingTriangles(numVertices, 0);
+        for (uint32_t index : indices)
+        {
+            NEB_ASSERT(index < numVertices, "Index {} is out of bounds ({} vertices)", index, numVertices);
+            ++numRemainingTriangles[index];
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(numVertices, 0);
+        for (uint32_t v = 1; v < numVertices; ++v)
+            adjacencyOffsets[v] = adjacencyOffsets[v - 1] + numRemainingTriangles[v - 1];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> cursors = adjacencyOffsets;
+            for (uint32_t t = 0; t < numTriangles; ++t)
+                for (uint32_t k = 0; k < 3; ++k)
+                    adjacency[cursors[indices[t * 3 + k]]++] = t;
+        }
+
+        std::vector<uint32_t> cachePositions(numVertices, InvalidVertexIndex);
+        std::vector<float> vertexScores(numVertices);
+        for (uint32_t v = 0; v < numVertices; ++v)
+            vertexScores[v] = GetForsythVertexScore(scoreTable, InvalidVertexIndex, numRemainingTriangles[v]);
+
+        std::vector<float> triangleScores(numTriangles);
+        std::vector<bool> isEmitted(numTriangles, false);
+
+        uint32_t bestTriangle = 0;
+        for (uint32_t t = 0; t < numTriangles; ++t)
+        {
+            const uint32_t* triangle = &indices[t * 3];
+            triangleScores[t] = vertexScores[triangle[0]] + vertexScores[triangle[1]] + vertexScores[triangle[2]];
+            if (triangleScores[t] > triangleScores[bestTriangle])
+                bestTriangle = t;
+        }
+
+        // Cache holds 3 more entries, for vertices that are pushed out by the triangle just emitted, so that their scores are updated
+        std::array<uint32_t, ForsythCacheSize + 3> cache;
+        std::array<uint32_t, ForsythCacheSize + 3> newCache;
+        uint32_t cacheCount = 0;
+        uint32_t deadEndCursor = 0;
+
+        for (uint32_t numEmitted = 0; numEmitted < numTriangles; ++numEmitted)
+        {
+            if (bestTriangle == InvalidTriangleIndex)
+            {
+                // None of the triangles in the cache is left, continue from the first one of the source order that is not emitted
+                while (isEmitted[deadEndCursor])
+                    ++deadEndCursor;
+                bestTriangle = deadEndCursor;
+            }
+
+            const uint32_t* triangle = &indices[bestTriangle * 3];
+            std::memcpy(&dstIndices[numEmitted * 3], triangle, sizeof(uint32_t) * 3);
+            isEmitted[bestTriangle] = true;
+
+            // Remove the triangle from adjacency of its vertices. Degenerate triangles reference the same vertex more than once,
+            // they are removed just once, other references simply do not find it anymore
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t v = triangle[k];
+                uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+                uint32_t* end = begin + numRemainingTriangles[v];
+                uint32_t* it = std::find(begin, end, bestTriangle);
+                if (it != end)
+                {
+                    std::swap(*it, *(end - 1));
+                    --numRemainingTriangles[v];
+                }
+            }
+
+            // Vertices of the triangle go to the front (LRU), the rest of the cache is shifted back
+            uint32_t newCacheCount = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t v = triangle[k];
+                if (std::find(newCache.begin(), newCache.begin() + newCacheCount, v) == newCache.begin() + newCacheCount)
+                    newCache[newCacheCount++] = v;
+            }
+
+            for (uint32_t i = 0; i < cacheCount; ++i)
+            {
+                const uint32_t v = cache[i];
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    newCache[newCacheCount++] = v;
+            }
+
+            // Update scores of every vertex that was in the cache, including the ones that were just evicted
+            for (uint32_t i = 0; i < newCacheCount; ++i)
+            {
+                const uint32_t v = newCache[i];
+                cachePositions[v] = (i < ForsythCacheSize) ? i : InvalidVertexIndex;
+                vertexScores[v] = GetForsythVertexScore(scoreTable, cachePositions[v], numRemainingTriangles[v]);
+            }
+
+            // Next best triangle is searched only among the ones, that touch the cache
+            bestTriangle = InvalidTriangleIndex;
+            float bestScore = -1.0f;
+            for (uint32_t i = 0; i < newCacheCount; ++i)
+            {
+                const uint32_t v = newCache[i];
+                const uint32_t offset = adjacencyOffsets[v];
+                for (uint32_t j = 0; j < numRemainingTriangles[v]; ++j)
+                {
+                    const uint32_t t = adjacency[offset + j];
+                    const uint32_t* adjacent = &indices[t * 3];
+                    triangleScores[t] = vertexScores[adjacent[0]] + vertexScores[adjacent[1]] + vertexScores[adjacent[2]];
+                    if (triangleScores[t] > bestScore)
+                    {
+                        bestScore = triangleScores[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            cacheCount = std::min(newCacheCount, ForsythCacheSize);
+            std::copy_n(newCache.begin(), cacheCount, cache.begin());
+        }
+    }
+
+    uint32_t OptimizeVertexFetchRemap(std::span<uint32_t> remap, std::span<const uint32_t> indices)
+    {
+        std::ranges::fill(remap, InvalidVertexIndex);
+
+        uint32_t numRemappedVertices = 0;
+        for (uint32_t index : indices)
+        {
+            NEB_ASSERT(index < remap.size(), "Index {} is out of bounds ({} vertices)", index, remap.size());
+            if (remap[index] == InvalidVertexIndex)
+                remap[index] = numRemappedVertices++;
+        }
+        return numRemappedVertices;
+    }
+
+    void RemapIndices(std::span<uint32_t> indices, std::span<const uint32_t> remap)
+    {
+        for (uint32_t& index : indices)
+        {
+            NEB_ASSERT(remap[index] != InvalidVertexIndex, "Referenced vertex {} was removed by the remap", index);
+            index = remap[index];
+        }
+    }
+
+    void RemapVertexStream(std::byte* dst, const std::byte* src, uint32_t srcStride, uint32_t elementSize, std::span<const uint32_t> remap)
+    {
+        for (size_t v = 0; v < remap.size(); ++v)
+        {
+            if (remap[v] != InvalidVertexIndex)
+                std::memcpy(dst + size_t(remap[v]) * elementSize, src + v * srcStride, elementSize);
+        }
+    }
+
+} // Neb namespace
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Neb
+{
+
+    static constexpr uint32_t InvalidVertexIndex = UINT32_MAX;
+
+    // Post-transform cache is modelled as a FIFO of that many vertices. Real hardware does not have a strict FIFO,
+    // but it is the usual proxy and it is what ACMR/ATVR numbers are normally compared in
+    static constexpr uint32_t SimulatedVertexCacheSize = 16;
+
+    struct VertexCacheStatistics
+    {
+        uint32_t NumTransformedVertices = 0; // cache misses
+        uint32_t NumTriangles = 0;
+        uint32_t NumReferencedVertices = 0;
+
+        float ACMR = 0.0f; // average cache miss ratio, transformed vertices per triangle. 0.5 is the best possible, 3.0 is the worst
+        float ATVR = 0.0f; // average transformed vertex ratio, transformed vertices per referenced vertex. 1.0 is the best possible
+    };
+
+    // CPU simulation of the post-transform cache for an indexed triangle list, so that optimizations can be measured without a GPU
+    VertexCacheStatistics SimulateVertexCache(std::span<const uint32_t> indices, uint32_t numVertices, uint32_t cacheSize = SimulatedVertexCacheSize);
+
+    // Reorders triangles for post-transform cache reuse, following Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+    // (https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html). When the cache runs out of good candidates the next
+    // triangle is taken in the source order instead of a full rescan, which keeps it linear for huge meshes.
+    // dstIndices must not alias indices
+    void OptimizeVertexCache(std::span<uint32_t> dstIndices, std::span<const uint32_t> indices, uint32_t numVertices);
+
+    // Builds a remap table, that orders vertices by their first use in indices (for vertex fetch locality).
+    // Vertices that are not referenced at all are removed (remapped to InvalidVertexIndex). Returns the amount of remaining vertices
+    uint32_t OptimizeVertexFetchRemap(std::span<uint32_t> remap, std::span<const uint32_t> indices);
+
+    void RemapIndices(std::span<uint32_t> indices, std::span<const uint32_t> remap);
+
+    // Gathers a (possibly strided) vertex stream into a tight stream of elementSize elements in remapped order
+    void RemapVertexStream(std::byte* dst, const std::byte* src, uint32_t srcStride, uint32_t elementSize, std::span<const uint32_t> remap);
+
+} // Neb namespace
@@ -0,0 +1,474 @@
+#include "MeshSimplifier.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace Neb
+{
+
+    namespace
+    {
+        struct Float3
+        {
+            float x, y, z;
+        };
+
+        Float3 Sub(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+        float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        Float3 Cross(const Float3& a, const Float3& b) { return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+        template<typename T>
+        T LoadElement(const std::byte* stream, uint32_t stride, uint32_t index)
+        {
+            T v;
+            std::memcpy(&v, stream + size_t(index) * stride, sizeof(T));
+            return v;
+        }
+
+        uint32_t LoadIndex(const MeshSimplifierSourceDesc& src, size_t i)
+        {
+            if (src.IndicesStride == sizeof(uint16_t))
+                return LoadElement<uint16_t>(src.Indices, sizeof(uint16_t), uint32_t(i));
+
+            return LoadElement<uint32_t>(src.Indices, sizeof(uint32_t), uint32_t(i));
+        }
+
+        // Symmetric 4x4 matrix of the plane quadric, kept in doubles as sums of many planes lose precision in floats quickly
+        struct Quadric
+        {
+            double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+            double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+            double c = 0.0;
+            double Weight = 0.0;
+        };
+
+        void AddPlaneQuadric(Quadric& q, const Float3& n, float d, double weight)
+        {
+            q.a00 += weight * n.x * n.x;
+            q.a01 += weight * n.x * n.y;
+            q.a02 += weight * n.x * n.z;
+            q.a11 += weight * n.y * n.y;
+            q.a12 += weight * n.y * n.z;
+            q.a22 += weight * n.z * n.z;
+            q.b0 += weight * n.x * d;
+            q.b1 += weight * n.y * d;
+            q.b2 += weight * n.z * d;
+            q.c += weight * d * d;
+            q.Weight += weight;
+        }
+
+        void AddQuadric(Quadric& q, const Quadric& other)
+        {
+            q.a00 += other.a00; q.a01 += other.a01; q.a02 += other.a02;
+            q.a11 += other.a11; q.a12 += other.a12; q.a22 += other.a22;
+            q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+            q.c += other.c;
+            q.Weight += other.Weight;
+        }
+
+        // Weighted average of squared distances to every plane of the quadric
+        double EvaluateQuadric(const Quadric& q, const Float3& p)
+        {
+            if (q.Weight == 0.0)
+                return 0.0;
+
+            const double x = p.x, y = p.y, z = p.z;
+            const double result =
+                q.a00 * x * x + 2.0 * q.a01 * x * y + 2.0 * q.a02 * x * z +
+                q.a11 * y * y + 2.0 * q.a12 * y * z +
+                q.a22 * z * z +
+                2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+            return std::max(result, 0.0) / q.Weight;
+        }
+
+        struct PositionKey
+        {
+            uint32_t Bits[3];
+            bool operator==(const PositionKey&) const = default;
+        };
+
+        struct PositionKeyHasher
+        {
+            size_t operator()(const PositionKey& key) const
+            {
+                return size_t((key.Bits[0] * 73856093u) ^ (key.Bits[1] * 19349663u) ^ (key.Bits[2] * 83492791u));
+            }
+        };
+
+        struct Collapse
+        {
+            float Cost = 0.0f;
+            float Error = 0.0f; // positional part of the cost
+            uint32_t From = 0;
+            uint32_t To = 0;
+
+            bool operator<(const Collapse& other) const
+            {
+                if (Cost != other.Cost)
+                    return Cost < other.Cost;
+                return (From != other.From) ? (From < other.From) : (To < other.To);
+            }
+        };
+
+        // Everything that does not change while simplifying
+        struct SimplifierContext
+        {
+            std::vector<Float3> Positions; // normalized into [0, 1]
+            std::vector<uint32_t> PositionIndices; // vertex -> first vertex with the same position
+            std::vector<bool> IsLocked;
+
+            std::vector<float> Attributes; // weighted normal and tex coords
+            uint32_t NumAttributes = 0;
+        };
+
+        float GetAttributeError(const SimplifierContext& context, uint32_t a, uint32_t b)
+        {
+            float error = 0.0f;
+            for (uint32_t i = 0; i < context.NumAttributes; ++i)
+            {
+                const float d = context.Attributes[size_t(a) * context.NumAttributes + i] - context.Attributes[size_t(b) * context.NumAttributes + i];
+                error += d * d;
+            }
+            return error;
+        }
+
+        void InitSimplifierContext(SimplifierContext& context, std::span<const uint32_t> indices, const MeshSimplifierSourceDesc& src, const MeshSimplifierDesc& desc)
+        {
+            const uint32_t numVertices = src.NumVertices;
+            const float scale = GetMeshSimplifierScale(src);
+            const float invScale = (scale > 0.0f) ? 1.0f / scale : 0.0f;
+
+            Float3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+            for (uint32_t v = 0; v < numVertices; ++v)
+            {
+                const Float3 p = LoadElement<Float3>(src.Positions, src.PositionsStride, v);
+                min = Float3{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+            }
+
+            context.Positions.resize(numVertices);
+            for (uint32_t v = 0; v < numVertices; ++v)
+            {
+                const Float3 p = LoadElement<Float3>(src.Positions, src.PositionsStride, v);
+                context.Positions[v] = Float3{ (p.x - min.x) * invScale, (p.y - min.y) * invScale, (p.z - min.z) * invScale };
+            }
+
+            // Vertices with the same position are wedges of a single point, split by attribute seams
+            std::vector<uint32_t> numWedges(numVertices, 0);
+            context.PositionIndices.resize(numVertices);
+            {
+                std::unordered_map<PositionKey, uint32_t, PositionKeyHasher> positionMap;
+                positionMap.reserve(numVertices);
+                for (uint32_t v = 0; v < numVertices; ++v)
+                {
+                    PositionKey key;
+                    std::memcpy(key.Bits, &context.Positions[v], sizeof(key.Bits));
+                    const uint32_t positionIndex = positionMap.try_emplace(key, v).first->second;
+                    context.PositionIndices[v] = positionIndex;
+                    ++numWedges[positionIndex];
+                }
+            }
+
+            // Edges, that are used by a single triangle (open borders) or by more than two of them (non-manifold)
+            std::vector<uint64_t> edges;
+            edges.reserve(indices.size());
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t a = context.PositionIndices[indices[i + k]];
+                    const uint32_t b = context.PositionIndices[indices[i + (k + 1) % 3]];
+                    if (a != b)
+                        edges.push_back((uint64_t(std::min(a, b)) << 32) | std::max(a, b));
+                }
+            }
+            std::ranges::sort(edges);
+
+            std::vector<bool> isBorder(numVertices, false);
+            for (size_t i = 0; i < edges.size();)
+            {
+                size_t j = i + 1;
+                while (j < edges.size() && edges[j] == edges[i])
+                    ++j;
+
+                if (j - i != 2)
+                {
+                    isBorder[uint32_t(edges[i] >> 32)] = true;
+                    isBorder[uint32_t(edges[i] & UINT32_MAX)] = true;
+                }
+                i = j;
+            }
+
+            context.IsLocked.resize(numVertices);
+            for (uint32_t v = 0; v < numVertices; ++v)
+            {
+                const uint32_t positionIndex = context.PositionIndices[v];
+                context.IsLocked[v] = numWedges[positionIndex] > 1 || isBorder[positionIndex];
+            }
+
+            // Normals are unit, tex coords are usually in [0, 1], so both are comparable with normalized positions
+            context.NumAttributes = (src.Normals ? 3 : 0) + (src.TexCoords ? 2 : 0);
+            context.Attributes.resize(size_t(numVertices) * context.NumAttributes);
+            const float normalWeight = std::sqrt(desc.NormalWeight);
+            const float texCoordWeight = std::sqrt(desc.TexCoordWeight);
+            for (uint32_t v = 0; v < numVertices; ++v)
+            {
+                float* attributes = &context.Attributes[size_t(v) * context.NumAttributes];
+                if (src.Normals)
+                {
+                    const Float3 n = LoadElement<Float3>(src.Normals, src.NormalsStride, v);
+                    *attributes++ = n.x * normalWeight;
+                    *attributes++ = n.y * normalWeight;
+                    *attributes++ = n.z * normalWeight;
+                }
+
+                if (src.TexCoords)
+                {
+                    float uv[2];
+                    std::memcpy(uv, src.TexCoords + size_t(v) * src.TexCoordsStride, sizeof(uv));
+                    *attributes++ = uv[0] * texCoordWeight;
+                    *attributes++ = uv[1] * texCoordWeight;
+                }
+            }
+        }
+
+        // Collapse must not flip (or degenerate) any of the triangles around the collapsed vertex
+        bool IsCollapseValid(const SimplifierContext& context, std::span<const uint32_t> indices, std::span<const uint32_t> triangles, uint32_t from, uint32_t to)
+        {
+            for (uint32_t t : triangles)
+            {
+                const uint32_t* triangle = &indices[size_t(t) * 3];
+                if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                    continue; // triangle is removed by the collapse
+
+                Float3 p[3], q[3];
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    p[k] = context.Positions[triangle[k]];
+                    q[k] = context.Positions[(triangle[k] == from) ? to : triangle[k]];
+                }
+
+                const Float3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+                const Float3 after = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+
+                // Rejects flips as well as rotations of the normal of more than ~75 degrees
+                const float d = Dot(before, after);
+                if (d <= 0.25f * std::sqrt(Dot(before, before) * Dot(after, after)))
+                    return false;
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    float GetMeshSimplifierScale(const MeshSimplifierSourceDesc& src)
+    {
+        if (src.NumVertices == 0)
+            return 0.0f;
+
+        Float3 min = LoadElement<Float3>(src.Positions, src.PositionsStride, 0);
+        Float3 max = min;
+        for (uint32_t v = 1; v < src.NumVertices; ++v)
+        {
+            const Float3 p = LoadElement<Float3>(src.Positions, src.PositionsStride, v);
+            min = Float3{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+            max = Float3{ std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+        }
+        return std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+    }
+
+    size_t SimplifyMesh(std::span<uint32_t> dstIndices, std::span<const uint32_t> indices, const MeshSimplifierSourceDesc& src,
+        size_t targetNumIndices, const MeshSimplifierDesc& desc, float* relativeError)
+    {
+        NEB_ASSERT(dstIndices.size() >= indices.size(), "Destination should be able to hold every index");
+        NEB_ASSERT(indices.size() % 3 == 0, "Only triangle lists are supported");
+
+        const uint32_t numVertices = src.NumVertices;
+        std::vector<uint32_t> current(indices.begin(), indices.end());
+        float maxError = 0.0f;
+
+        if (current.size() > targetNumIndices && numVertices > 0)
+        {
+            SimplifierContext context;
+            InitSimplifierContext(context, current, src, desc);
+
+            // Quadrics are shared by every wedge of a position, as they describe the surface and not the attributes
+            std::vector<Quadric> quadrics(numVertices);
+            for (size_t i = 0; i < current.size(); i += 3)
+            {
+                const Float3& p0 = context.Positions[current[i + 0]];
+                const Float3 n = Cross(Sub(context.Positions[current[i + 1]], p0), Sub(context.Positions[current[i + 2]], p0));
+                const float length = std::sqrt(Dot(n, n));
+                if (length == 0.0f)
+                    continue;
+
+                // Area weighted, so that small triangles do not dominate the error
+                const Float3 unitNormal = Float3{ n.x / length, n.y / length, n.z / length };
+                for (uint32_t k = 0; k < 3; ++k)
+                    AddPlaneQuadric(quadrics[context.PositionIndices[current[i + k]]], unitNormal, -Dot(unitNormal, p0), length * 0.5);
+            }
+
+            const float maxCostAllowed = desc.MaxRelativeError * desc.MaxRelativeError;
+            std::vector<uint32_t> triangleOffsets(numVertices + 1);
+            std::vector<uint32_t> adjacency;
+            std::vector<Collapse> collapses;
+            std::vector<uint32_t> collapseRemap(numVertices);
+            std::vector<bool> isTouched(numVertices);
+
+            // Collapses are done in passes. Each pass collapses the cheapest edges, that do not touch each other's neighbourhood,
+            // so that all of the checks done at the beginning of the pass stay valid
+            while (current.size() > targetNumIndices)
+            {
+                const uint32_t numTriangles = static_cast<uint32_t>(current.size() / 3);
+
+                std::ranges::fill(triangleOffsets, 0);
+                for (uint32_t index : current)
+                    ++triangleOffsets[index + 1];
+                for (uint32_t v = 0; v < numVertices; ++v)
+                    triangleOffsets[v + 1] += triangleOffsets[v];
+
+                adjacency.resize(current.size());
+                {
+                    std::vector<uint32_t> cursors(triangleOffsets.begin(), triangleOffsets.end() - 1);
+                    for (uint32_t t = 0; t < numTriangles; ++t)
+                        for (uint32_t k = 0; k < 3; ++k)
+                            adjacency[cursors[current[size_t(t) * 3 + k]]++] = t;
+                }
+
+                collapses.clear();
+                for (size_t i = 0; i < current.size(); i += 3)
+                {
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        const uint32_t a = current[i + k];
+                        const uint32_t b = current[i + (k + 1) % 3];
+                        for (const auto& [from, to] : { std::pair(a, b), std::pair(b, a) })
+                        {
+                            if (context.IsLocked[from] || context.PositionIndices[from] == context.PositionIndices[to])
+                                continue;
+
+                            Quadric q = quadrics[context.PositionIndices[from]];
+                            AddQuadric(q, quadrics[context.PositionIndices[to]]);
+                            const float error = float(EvaluateQuadric(q, context.Positions[to]));
+                            const float cost = error + GetAttributeError(context, from, to);
+                            if (cost <= maxCostAllowed)
+                                collapses.push_back(Collapse{ .Cost = cost, .Error = error, .From = from, .To = to });
+                        }
+                    }
+                }
+                std::sort(collapses.begin(), collapses.end());
+
+                for (uint32_t v = 0; v < numVertices; ++v)
+                    collapseRemap[v] = v;
+                std::fill(isTouched.begin(), isTouched.end(), false);
+
+                const size_t numTrianglesToRemove = (current.size() - targetNumIndices + 2) / 3;
+                size_t numRemovedTriangles = 0;
+                size_t numCollapses = 0;
+                for (const Collapse& collapse : collapses)
+                {
+                    if (isTouched[collapse.From] || isTouched[collapse.To])
+                        continue;
+
+                    std::span<const uint32_t> triangles(&adjacency[triangleOffsets[collapse.From]], triangleOffsets[collapse.From + 1] - triangleOffsets[collapse.From]);
+                    if (!IsCollapseValid(context, current, triangles, collapse.From, collapse.To))
+                        continue;
+
+                    collapseRemap[collapse.From] = collapse.To;
+                    AddQuadric(quadrics[context.PositionIndices[collapse.To]], quadrics[context.PositionIndices[collapse.From]]);
+                    maxError = std::max(maxError, collapse.Error);
+                    ++numCollapses;
+
+                    for (uint32_t t : triangles)
+                    {
+                        const uint32_t* triangle = &current[size_t(t) * 3];
+                        if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To)
+                            ++numRemovedTriangles;
+
+                        isTouched[triangle[0]] = isTouched[triangle[1]] = isTouched[triangle[2]] = true;
+                    }
+
+                    if (numRemovedTriangles >= numTrianglesToRemove)
+                        break;
+                }
+
+                if (numCollapses == 0)
+                    break; // nothing can be collapsed within the error limit
+
+                size_t numIndices = 0;
+                for (size_t i = 0; i < current.size(); i += 3)
+                {
+                    const uint32_t a = collapseRemap[current[i + 0]];
+                    const uint32_t b = collapseRemap[current[i + 1]];
+                    const uint32_t c = collapseRemap[current[i + 2]];
+                    if (a == b || b == c || c == a)
+                        continue;
+
+                    current[numIndices++] = a;
+                    current[numIndices++] = b;
+                    current[numIndices++] = c;
+                }
+                current.resize(numIndices);
+            }
+        }
+
+        std::ranges::copy(current, dstIndices.begin());
+        if (relativeError)
+            *relativeError = std::sqrt(maxError);
+        return current.size();
+    }
+
+    void BuildMeshLodChain(MeshLodChain& dst, const MeshSimplifierSourceDesc& src, const MeshLodDesc& desc)
+    {
+        NEB_ASSERT(src.IndicesStride == sizeof(uint16_t) || src.IndicesStride == sizeof(uint32_t), "Unsupported index stride {}", src.IndicesStride);
+        NEB_ASSERT(desc.MaxLods > 0, "There should be at least the full resolution level");
+
+        dst = MeshLodChain();
+        dst.Indices.resize(src.NumIndices);
+        for (size_t i = 0; i < dst.Indices.size(); ++i)
+            dst.Indices[i] = LoadIndex(src, i);
+        dst.Lods.push_back(MeshLod{ .FirstIndex = 0, .NumIndices = src.NumIndices, .Error = 0.0f });
+
+        const float scale = GetMeshSimplifierScale(src);
+        float accumulatedError = 0.0f;
+        std::vector<uint32_t> lodIndices;
+        while (dst.Lods.size() < desc.MaxLods)
+        {
+            const MeshLod& previous = dst.Lods.back();
+            if (previous.NumIndices / 3 <= desc.MinTriangles)
+                break;
+
+            std::span<const uint32_t> previousIndices(dst.Indices.data() + previous.FirstIndex, previous.NumIndices);
+            const size_t targetNumIndices = std::max<size_t>(size_t(previous.NumIndices / 3 * desc.ReductionRatio) * 3, size_t(desc.MinTriangles) * 3);
+
+            float relativeError = 0.0f;
+            lodIndices.resize(previousIndices.size());
+            const size_t numIndices = SimplifyMesh(lodIndices, previousIndices, src, targetNumIndices, desc.Simplifier, &relativeError);
+            if (numIndices == 0 || numIndices > previous.NumIndices * desc.MinReductionRatio)
+                break;
+
+            // Each level is simplified from the previous one, thus its error bound is the sum of errors of every step
+            accumulatedError += relativeError;
+
+            const uint32_t firstIndex = static_cast<uint32_t>(dst.Indices.size());
+            dst.Indices.insert(dst.Indices.end(), lodIndices.begin(), lodIndices.begin() + numIndices);
+            dst.Lods.push_back(MeshLod{ .FirstIndex = firstIndex, .NumIndices = static_cast<uint32_t>(numIndices), .Error = accumulatedError * scale });
+        }
+    }
+
+    void BuildMeshLodChains(std::span<MeshLodChain> dst, std::span<const MeshSimplifierSourceDesc> srcs, const MeshLodDesc& desc, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(dst.size() == srcs.size(), "Each source should have its own LOD chain");
+
+        // Submeshes are independent, each of them is simplified as a whole on a single thread
+        threadPool.ParallelFor(srcs.size(), [&dst, &srcs, &desc](size_t i)
+            {
+                BuildMeshLodChain(dst[i], srcs[i], desc);
+            });
+    }
+
+} // Neb namespace
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Source geometry of a single indexed triangle list. Streams may be strided (interleaved), indices are either 16 or 32 bit.
+    // Normals and tex coords are optional, if present they are taken into account by the collapse cost
+    struct MeshSimplifierSourceDesc
+    {
+        uint32_t NumVertices = 0;
+        const std::byte* Positions = nullptr; // float3
+        uint32_t PositionsStride = sizeof(float) * 3;
+        const std::byte* Normals = nullptr;   // float3
+        uint32_t NormalsStride = sizeof(float) * 3;
+        const std::byte* TexCoords = nullptr; // float2
+        uint32_t TexCoordsStride = sizeof(float) * 2;
+
+        uint32_t NumIndices = 0;
+        uint32_t IndicesStride = 0;
+        const std::byte* Indices = nullptr;
+    };
+
+    struct MeshSimplifierDesc
+    {
+        // Errors are relative to the largest extent of the mesh, so that the same settings work for meshes of any scale.
+        // The limit applies to the whole collapse cost, including the attribute part
+        float MaxRelativeError = 0.05f;
+
+        // Attribute differences of the two collapsed vertices are added to the squared positional error with these weights
+        float NormalWeight = 0.25f;
+        float TexCoordWeight = 0.5f;
+    };
+
+    // Simplifies a triangle list with vertex-to-vertex edge collapses, ordered by quadric error (Garland & Heckbert,
+    // "Surface Simplification Using Quadric Error Metrics"). Vertices are never moved or created, so the result
+    // indexes the same vertex buffer. Vertices on open borders and on attribute seams (several vertices with the same position)
+    // are never collapsed, which keeps meshes watertight and uv charts intact.
+    // Returns the amount of indices written to dstIndices (at most indices.size()). relativeError receives the max positional error
+    // of the collapses (distance to the planes of the source surface, attributes are not included)
+    size_t SimplifyMesh(std::span<uint32_t> dstIndices, std::span<const uint32_t> indices, const MeshSimplifierSourceDesc& src,
+        size_t targetNumIndices, const MeshSimplifierDesc& desc = {}, float* relativeError = nullptr);
+
+    // Largest extent of the source positions. Multiply relative errors by it to get errors in mesh space
+    float GetMeshSimplifierScale(const MeshSimplifierSourceDesc& src);
+
+    struct MeshLod
+    {
+        uint32_t FirstIndex = 0;
+        uint32_t NumIndices = 0;
+        float Error = 0.0f; // in mesh space, conservative bound of the deviation from the full resolution surface
+    };
+
+    struct MeshLodDesc
+    {
+        uint32_t MaxLods = 6; // including the full resolution one
+        float ReductionRatio = 0.5f;
+        uint32_t MinTriangles = 64;
+
+        // Level is not worth keeping if it has more than that ratio of triangles of the previous one
+        float MinReductionRatio = 0.85f;
+
+        MeshSimplifierDesc Simplifier;
+    };
+
+    struct MeshLodChain
+    {
+        std::vector<uint32_t> Indices; // indices of every level, one after another
+        std::vector<MeshLod> Lods;     // Lods[0] is always the source itself with 0 error
+    };
+
+    // Each level is simplified from the previous one, errors are accumulated, so they only grow with the level
+    void BuildMeshLodChain(MeshLodChain& dst, const MeshSimplifierSourceDesc& src, const MeshLodDesc& desc = {});
+
+    // Builds chains of every source on the thread pool. dst and srcs are expected to be of the same size
+    void BuildMeshLodChains(std::span<MeshLodChain> dst, std::span<const MeshSimplifierSourceDesc> srcs, const MeshLodDesc& desc, ThreadPool& threadPool);
+
+} // Neb namespace
@@ -0,0 +1,501 @@
+#include "MeshTangents.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include <vector>
+
+namespace Neb
+{
+
+    namespace
+    {
+        // Chunks are large enough for scheduling to be negligible, yet small enough to balance a single huge submesh
+        static constexpr uint32_t NumTrianglesPerChunk = 8192;
+        static constexpr uint32_t NumVerticesPerChunk = 16384;
+
+        struct Float2
+        {
+            float x, y;
+        };
+
+        struct Float3
+        {
+            float x, y, z;
+        };
+
+        struct alignas(16) Float4
+        {
+            float x, y, z, w;
+        };
+
+        // Scratch of a single submesh. Corners are contributions of each triangle corner (in index order),
+        // xyz is the angle-weighted tangent and w is the angle-weighted orientation of uv mapping
+        struct TangentScratch
+        {
+            std::vector<Float4> Corners;
+            std::vector<Float4> Accumulated;
+        };
+
+        struct WorkRange
+        {
+            uint32_t DescIndex = 0;
+            uint32_t Begin = 0;
+            uint32_t End = 0;
+        };
+
+        template<typename IndexType>
+        uint32_t LoadIndex(const std::byte* indices, size_t i)
+        {
+            IndexType index;
+            std::memcpy(&index, indices + i * sizeof(IndexType), sizeof(IndexType));
+            return static_cast<uint32_t>(index);
+        }
+
+        Float3 LoadFloat3(const std::byte* stream, uint32_t stride, uint32_t index)
+        {
+            Float3 v;
+            std::memcpy(&v, stream + size_t(index) * stride, sizeof(Float3));
+            return v;
+        }
+
+        Float2 LoadFloat2(const std::byte* stream, uint32_t stride, uint32_t index)
+        {
+            Float2 v;
+            std::memcpy(&v, stream + size_t(index) * stride, sizeof(Float2));
+            return v;
+        }
+
+        // Scalar math. Every operation here has its exact counterpart (same order of operations) in the SIMD path below,
+        // so that both produce bitwise identical results
+        Float3 Sub(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+        Float3 Scale(const Float3& a, float s) { return Float3{ a.x * s, a.y * s, a.z * s }; }
+        float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+        // Projects v onto the plane of a unit normal n and normalizes it. Returns false and zero vector if the projection is degenerate
+        bool ProjectNormalized(const Float3& v, const Float3& n, Float3& result)
+        {
+            result = Sub(v, Scale(n, Dot(n, v)));
+
+            const float lengthSq = Dot(result, result);
+            if (lengthSq > FLT_MIN)
+            {
+                const float length = std::sqrt(lengthSq);
+                result = Float3{ result.x / length, result.y / length, result.z / length };
+                return true;
+            }
+
+            result = Float3{};
+            return false;
+        }
+
+        void EvaluateTriangle(const Float3 p[3], const Float3 n[3], const Float2 uv[3], Float4 corners[3])
+        {
+            const Float3 d1 = Sub(p[1], p[0]);
+            const Float3 d2 = Sub(p[2], p[0]);
+            const float s1 = uv[1].x - uv[0].x;
+            const float t1 = uv[1].y - uv[0].y;
+            const float s2 = uv[2].x - uv[0].x;
+            const float t2 = uv[2].y - uv[0].y;
+
+            // Eq. 18 of MikkTSpace, orientation of uv mapping is folded into the tangent direction
+            const float signedArea = s1 * t2 - t1 * s2;
+            const Float3 os = Sub(Scale(d1, t2), Scale(d2, t1));
+            const float osLengthSq = Dot(os, os);
+            if (!(std::abs(signedArea) > FLT_MIN && osLengthSq > FLT_MIN))
+            {
+                // Degenerate triangles do not contribute
+                corners[0] = corners[1] = corners[2] = Float4{};
+                return;
+            }
+
+            const float orientation = (signedArea > 0.0f) ? 1.0f : -1.0f;
+            const Float3 tangent = Scale(os, orientation / std::sqrt(osLengthSq));
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                Float3 t, e1, e2;
+                ProjectNormalized(tangent, n[k], t);
+                ProjectNormalized(Sub(p[(k + 1) % 3], p[k]), n[k], e1);
+                ProjectNormalized(Sub(p[(k + 2) % 3], p[k]), n[k], e2);
+
+                const float angle = std::acos(std::clamp(Dot(e1, e2), -1.0f, 1.0f));
+                corners[k] = Float4{ t.x * angle, t.y * angle, t.z * angle, orientation * angle };
+            }
+        }
+
+        void FinalizeVertex(const Float4& accumulated, const Float3& n, float* tangent)
+        {
+            // Gram-Schmidt orthogonalize accumulated tangent against the normal
+            Float3 t;
+            if (!ProjectNormalized(Float3{ accumulated.x, accumulated.y, accumulated.z }, n, t))
+            {
+                // No contribution, any tangent orthogonal to the normal will do
+                // https://jcgt.org/published/0006/01/01/
+                const float sign = std::copysign(1.0f, n.z);
+                const float a = -1.0f / (sign + n.z);
+                const float b = n.x * n.y * a;
+                t = Float3{ 1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x };
+            }
+
+            tangent[0] = t.x;
+            tangent[1] = t.y;
+            tangent[2] = t.z;
+            tangent[3] = (accumulated.w < 0.0f) ? -1.0f : 1.0f;
+        }
+
+#if defined(__AVX2__)
+        using FloatV = __m256;
+        static constexpr uint32_t SimdWidth = 8;
+
+        FloatV SetV(float v) { return _mm256_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm256_load_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm256_store_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        FloatV SubV(FloatV a, FloatV b) { return _mm256_sub_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        FloatV DivV(FloatV a, FloatV b) { return _mm256_div_ps(a, b); }
+        FloatV SqrtV(FloatV a) { return _mm256_sqrt_ps(a); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm256_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm256_max_ps(a, b); }
+        FloatV AndV(FloatV a, FloatV b) { return _mm256_and_ps(a, b); }
+        FloatV AndNotV(FloatV a, FloatV b) { return _mm256_andnot_ps(a, b); }
+        FloatV OrV(FloatV a, FloatV b) { return _mm256_or_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm256_blendv_ps(b, a, mask); }
+#else
+        // SSE2 is always there on x64
+        using FloatV = __m128;
+        static constexpr uint32_t SimdWidth = 4;
+
+        FloatV SetV(float v) { return _mm_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm_load_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm_store_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        FloatV SubV(FloatV a, FloatV b) { return _mm_sub_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        FloatV DivV(FloatV a, FloatV b) { return _mm_div_ps(a, b); }
+        FloatV SqrtV(FloatV a) { return _mm_sqrt_ps(a); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm_max_ps(a, b); }
+        FloatV AndV(FloatV a, FloatV b) { return _mm_and_ps(a, b); }
+        FloatV AndNotV(FloatV a, FloatV b) { return _mm_andnot_ps(a, b); }
+        FloatV OrV(FloatV a, FloatV b) { return _mm_or_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm_cmpgt_ps(a, b); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm_cmplt_ps(a, b); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+
+        // SIMD_WIDTH vectors in SoA layout
+        struct Float3V
+        {
+            FloatV x, y, z;
+        };
+
+        // Lanes are gathered from (and scattered to) AoS streams through aligned arrays, as strided streams and
+        // random indices do not allow for anything smarter without hardware gathers
+        struct alignas(32) LaneArray
+        {
+            float Values[SimdWidth];
+
+            FloatV Load() const { return LoadV(Values); }
+            void Store(FloatV v) { StoreV(Values, v); }
+        };
+
+        struct Float3Lanes
+        {
+            LaneArray x, y, z;
+
+            void Set(uint32_t lane, const Float3& v)
+            {
+                x.Values[lane] = v.x;
+                y.Values[lane] = v.y;
+                z.Values[lane] = v.z;
+            }
+
+            Float3V Load() const { return Float3V{ x.Load(), y.Load(), z.Load() }; }
+        };
+
+        Float3V SubV(const Float3V& a, const Float3V& b) { return Float3V{ SubV(a.x, b.x), SubV(a.y, b.y), SubV(a.z, b.z) }; }
+        Float3V ScaleV(const Float3V& a, FloatV s) { return Float3V{ MulV(a.x, s), MulV(a.y, s), MulV(a.z, s) }; }
+        FloatV DotV(const Float3V& a, const Float3V& b) { return AddV(AddV(MulV(a.x, b.x), MulV(a.y, b.y)), MulV(a.z, b.z)); }
+
+        // Same as ProjectNormalized, returns mask of lanes that are not degenerate
+        FloatV ProjectNormalizedV(const Float3V& v, const Float3V& n, Float3V& result)
+        {
+            const Float3V projected = SubV(v, ScaleV(n, DotV(n, v)));
+            const FloatV lengthSq = DotV(projected, projected);
+            const FloatV length = SqrtV(lengthSq);
+            const FloatV mask = GreaterV(lengthSq, SetV(FLT_MIN));
+
+            const FloatV zero = SetV(0.0f);
+            result.x = SelectV(mask, DivV(projected.x, length), zero);
+            result.y = SelectV(mask, DivV(projected.y, length), zero);
+            result.z = SelectV(mask, DivV(projected.z, length), zero);
+            return mask;
+        }
+
+        template<typename IndexType>
+        void EvaluateTriangles(const TangentGenerationDesc& desc, Float4* corners, uint32_t beginTriangle, uint32_t endTriangle)
+        {
+            auto loadTriangle = [&desc](uint32_t triangle, Float3 p[3], Float3 n[3], Float2 uv[3])
+            {
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const uint32_t index = LoadIndex<IndexType>(desc.Indices, size_t(triangle) * 3 + k);
+                    NEB_ASSERT(index < desc.NumVertices, "Index {} is out of bounds ({} vertices)", index, desc.NumVertices);
+
+                    p[k] = LoadFloat3(desc.Positions, desc.PositionsStride, index);
+                    n[k] = LoadFloat3(desc.Normals, desc.NormalsStride, index);
+                    uv[k] = LoadFloat2(desc.TexCoords, desc.TexCoordsStride, index);
+                }
+            };
+
+            uint32_t triangle = beginTriangle;
+            for (; triangle + SimdWidth <= endTriangle; triangle += SimdWidth)
+            {
+                Float3Lanes pLanes[3], nLanes[3];
+                LaneArray uLanes[3], vLanes[3];
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                {
+                    Float3 p[3], n[3];
+                    Float2 uv[3];
+                    loadTriangle(triangle + lane, p, n, uv);
+                    for (uint32_t k = 0; k < 3; ++k)
+                    {
+                        pLanes[k].Set(lane, p[k]);
+                        nLanes[k].Set(lane, n[k]);
+                        uLanes[k].Values[lane] = uv[k].x;
+                        vLanes[k].Values[lane] = uv[k].y;
+                    }
+                }
+
+                const Float3V p[3] = { pLanes[0].Load(), pLanes[1].Load(), pLanes[2].Load() };
+                const Float3V d1 = SubV(p[1], p[0]);
+                const Float3V d2 = SubV(p[2], p[0]);
+                const FloatV s1 = SubV(uLanes[1].Load(), uLanes[0].Load());
+                const FloatV t1 = SubV(vLanes[1].Load(), vLanes[0].Load());
+                const FloatV s2 = SubV(uLanes[2].Load(), uLanes[0].Load());
+                const FloatV t2 = SubV(vLanes[2].Load(), vLanes[0].Load());
+
+                const FloatV signedArea = SubV(MulV(s1, t2), MulV(t1, s2));
+                const Float3V os = SubV(ScaleV(d1, t2), ScaleV(d2, t1));
+                const FloatV osLengthSq = DotV(os, os);
+
+                const FloatV zero = SetV(0.0f);
+                const FloatV absSignedArea = AndNotV(SetV(-0.0f), signedArea);
+                const FloatV isValid = AndV(GreaterV(absSignedArea, SetV(FLT_MIN)), GreaterV(osLengthSq, SetV(FLT_MIN)));
+                const FloatV orientation = SelectV(GreaterV(signedArea, zero), SetV(1.0f), SetV(-1.0f));
+                const Float3V tangent = ScaleV(os, DivV(orientation, SqrtV(osLengthSq)));
+
+                for (uint32_t k = 0; k < 3; ++k)
+                {
+                    const Float3V n = nLanes[k].Load();
+
+                    Float3V t, e1, e2;
+                    ProjectNormalizedV(tangent, n, t);
+                    ProjectNormalizedV(SubV(p[(k + 1) % 3], p[k]), n, e1);
+                    ProjectNormalizedV(SubV(p[(k + 2) % 3], p[k]), n, e2);
+
+                    // There is no vector acos in SSE/AVX, just go through the lanes
+                    LaneArray angleLanes;
+                    angleLanes.Store(MinV(MaxV(DotV(e1, e2), SetV(-1.0f)), SetV(1.0f)));
+                    for (float& angle : angleLanes.Values)
+                        angle = std::acos(angle);
+
+                    const FloatV angle = angleLanes.Load();
+                    LaneArray x, y, z, w;
+                    x.Store(SelectV(isValid, MulV(t.x, angle), zero));
+                    y.Store(SelectV(isValid, MulV(t.y, angle), zero));
+                    z.Store(SelectV(isValid, MulV(t.z, angle), zero));
+                    w.Store(SelectV(isValid, MulV(orientation, angle), zero));
+                    for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                        corners[size_t(triangle + lane) * 3 + k] = Float4{ x.Values[lane], y.Values[lane], z.Values[lane], w.Values[lane] };
+                }
+            }
+
+            // Leftovers go through scalar path, which is bitwise identical
+            for (; triangle < endTriangle; ++triangle)
+            {
+                Float3 p[3], n[3];
+                Float2 uv[3];
+                loadTriangle(triangle, p, n, uv);
+                EvaluateTriangle(p, n, uv, corners + size_t(triangle) * 3);
+            }
+        }
+
+        template<typename IndexType>
+        void AccumulateCorners(const TangentGenerationDesc& desc, const Float4* corners, Float4* accumulated)
+        {
+            // Accumulation is kept serial and in index order, so that result does not depend on how triangles were split
+            for (uint32_t i = 0; i < desc.NumIndices; ++i)
+            {
+                Float4& dst = accumulated[LoadIndex<IndexType>(desc.Indices, i)];
+                _mm_store_ps(&dst.x, _mm_add_ps(_mm_load_ps(&dst.x), _mm_load_ps(&corners[i].x)));
+            }
+        }
+
+        void FinalizeVertices(const TangentGenerationDesc& desc, const Float4* accumulated, uint32_t beginVertex, uint32_t endVertex)
+        {
+            uint32_t vertex = beginVertex;
+            for (; vertex + SimdWidth <= endVertex; vertex += SimdWidth)
+            {
+                Float3Lanes accumulatedLanes, nLanes;
+                LaneArray wLanes;
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                {
+                    const Float4& src = accumulated[vertex + lane];
+                    accumulatedLanes.Set(lane, Float3{ src.x, src.y, src.z });
+                    wLanes.Values[lane] = src.w;
+                    nLanes.Set(lane, LoadFloat3(desc.Normals, desc.NormalsStride, vertex + lane));
+                }
+
+                // Gram-Schmidt orthogonalize, same as FinalizeVertex
+                const Float3V n = nLanes.Load();
+                Float3V t;
+                const FloatV isValid = ProjectNormalizedV(accumulatedLanes.Load(), n, t);
+
+                const FloatV one = SetV(1.0f);
+                const FloatV sign = OrV(AndV(n.z, SetV(-0.0f)), one);
+                const FloatV a = DivV(SetV(-1.0f), AddV(sign, n.z));
+                const FloatV b = MulV(MulV(n.x, n.y), a);
+                const FloatV signX = MulV(sign, n.x);
+
+                LaneArray x, y, z, w;
+                x.Store(SelectV(isValid, t.x, AddV(one, MulV(MulV(signX, n.x), a))));
+                y.Store(SelectV(isValid, t.y, MulV(sign, b)));
+                z.Store(SelectV(isValid, t.z, SubV(SetV(0.0f), signX)));
+                w.Store(SelectV(LessV(wLanes.Load(), SetV(0.0f)), SetV(-1.0f), one));
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                {
+                    float* tangent = desc.Tangents + size_t(vertex + lane) * 4;
+                    tangent[0] = x.Values[lane];
+                    tangent[1] = y.Values[lane];
+                    tangent[2] = z.Values[lane];
+                    tangent[3] = w.Values[lane];
+                }
+            }
+
+            for (; vertex < endVertex; ++vertex)
+                FinalizeVertex(accumulated[vertex], LoadFloat3(desc.Normals, desc.NormalsStride, vertex), desc.Tangents + size_t(vertex) * 4);
+        }
+
+        bool IsValidDesc(const TangentGenerationDesc& desc)
+        {
+            NEB_ASSERT(desc.IndicesStride == sizeof(uint16_t) || desc.IndicesStride == sizeof(uint32_t), "Indices should either be 16 or 32 bit");
+            NEB_ASSERT(desc.NumIndices % 3 == 0, "Only triangle lists are supported");
+            return desc.NumVertices > 0 && desc.Positions && desc.Normals && desc.TexCoords && desc.Tangents
+                && desc.Indices && desc.NumIndices >= 3;
+        }
+    } // anonymous namespace
+
+    void GenerateTangents(std::span<const TangentGenerationDesc> descs, ThreadPool& threadPool)
+    {
+        std::vector<TangentScratch> scratch(descs.size());
+        std::vector<WorkRange> triangleRanges;
+        std::vector<WorkRange> vertexRanges;
+        for (uint32_t i = 0; i < descs.size(); ++i)
+        {
+            const TangentGenerationDesc& desc = descs[i];
+            if (!IsValidDesc(desc))
+                continue;
+
+            scratch[i].Corners.resize(desc.NumIndices);
+            scratch[i].Accumulated.assign(desc.NumVertices, Float4{});
+
+            const uint32_t numTriangles = desc.NumIndices / 3;
+            for (uint32_t begin = 0; begin < numTriangles; begin += NumTrianglesPerChunk)
+                triangleRanges.push_back(WorkRange{ i, begin, std::min(begin + NumTrianglesPerChunk, numTriangles) });
+
+            for (uint32_t begin = 0; begin < desc.NumVertices; begin += NumVerticesPerChunk)
+                vertexRanges.push_back(WorkRange{ i, begin, std::min(begin + NumVerticesPerChunk, desc.NumVertices) });
+        }
+
+        threadPool.ParallelFor(triangleRanges.size(), [&](size_t i)
+            {
+                const WorkRange& range = triangleRanges[i];
+                const TangentGenerationDesc& desc = descs[range.DescIndex];
+                Float4* corners = scratch[range.DescIndex].Corners.data();
+                if (desc.IndicesStride == sizeof(uint32_t))
+                    EvaluateTriangles<uint32_t>(desc, corners, range.Begin, range.End);
+                else
+                    EvaluateTriangles<uint16_t>(desc, corners, range.Begin, range.End);
+            });
+
+        threadPool.ParallelFor(descs.size(), [&](size_t i)
+            {
+                const TangentGenerationDesc& desc = descs[i];
+                if (scratch[i].Corners.empty())
+                    return;
+
+                if (desc.IndicesStride == sizeof(uint32_t))
+                    AccumulateCorners<uint32_t>(desc, scratch[i].Corners.data(), scratch[i].Accumulated.data());
+                else
+                    AccumulateCorners<uint16_t>(desc, scratch[i].Corners.data(), scratch[i].Accumulated.data());
+
+                // Corners are not needed anymore, release them early as they are the largest part of the scratch
+                scratch[i].Corners = {};
+            });
+
+        threadPool.ParallelFor(vertexRanges.size(), [&](size_t i)
+            {
+                const WorkRange& range = vertexRanges[i];
+                FinalizeVertices(descs[range.DescIndex], scratch[range.DescIndex].Accumulated.data(), range.Begin, range.End);
+            });
+    }
+
+    void GenerateTangentsReference(const TangentGenerationDesc& desc)
+    {
+        if (!IsValidDesc(desc))
+            return;
+
+        auto loadIndex = [&desc](size_t i)
+        {
+            return (desc.IndicesStride == sizeof(uint32_t)) ? LoadIndex<uint32_t>(desc.Indices, i) : LoadIndex<uint16_t>(desc.Indices, i);
+        };
+
+        std::vector<Float4> accumulated(desc.NumVertices, Float4{});
+        for (uint32_t triangle = 0; triangle < desc.NumIndices / 3; ++triangle)
+        {
+            uint32_t indices[3];
+            Float3 p[3], n[3];
+            Float2 uv[3];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                indices[k] = loadIndex(size_t(triangle) * 3 + k);
+                p[k] = LoadFloat3(desc.Positions, desc.PositionsStride, indices[k]);
+                n[k] = LoadFloat3(desc.Normals, desc.NormalsStride, indices[k]);
+                uv[k] = LoadFloat2(desc.TexCoords, desc.TexCoordsStride, indices[k]);
+            }
+
+            Float4 corners[3];
+            EvaluateTriangle(p, n, uv, corners);
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                Float4& dst = accumulated[indices[k]];
+                dst.x += corners[k].x;
+                dst.y += corners[k].y;
+                dst.z += corners[k].z;
+                dst.w += corners[k].w;
+            }
+        }
+
+        for (uint32_t vertex = 0; vertex < desc.NumVertices; ++vertex)
+            FinalizeVertex(accumulated[vertex], LoadFloat3(desc.Normals, desc.NormalsStride, vertex), desc.Tangents + size_t(vertex) * 4);
+    }
+
+    float GetMaxTangentDifference(const float* lhs, const float* rhs, uint32_t numVertices)
+    {
+        float maxDifference = 0.0f;
+        for (size_t i = 0; i < size_t(numVertices) * 4; ++i)
+            maxDifference = std::max(maxDifference, std::abs(lhs[i] - rhs[i]));
+
+        return maxDifference;
+    }
+
+} // Neb namespace
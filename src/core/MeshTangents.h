@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Input and output of tangent generation for a single indexed triangle list.
+    // Streams may be strided (interleaved), indices are either 16 or 32 bit
+    struct TangentGenerationDesc
+    {
+        uint32_t NumVertices = 0;
+
+        const std::byte* Positions = nullptr; // float3
+        uint32_t PositionsStride = sizeof(float) * 3;
+        const std::byte* Normals = nullptr;   // float3, expected to be normalized
+        uint32_t NormalsStride = sizeof(float) * 3;
+        const std::byte* TexCoords = nullptr; // float2
+        uint32_t TexCoordsStride = sizeof(float) * 2;
+
+        uint32_t NumIndices = 0;
+        uint32_t IndicesStride = 0;
+        const std::byte* Indices = nullptr;
+
+        // float4 per vertex, tightly packed. xyz is a unit tangent, orthogonal to the normal,
+        // w is the handedness, so that bitangent = w * cross(normal, tangent) (same convention as glTF)
+        float* Tangents = nullptr;
+    };
+
+    // Tangent generation follows MikkTSpace (http://www.mikktspace.com/) for already split vertices, which is always
+    // the case for glTF: per-triangle tangents from the uv parametrization, projected onto the tangent plane of each corner
+    // and weighted by the corner angle. Triangles with degenerate uvs do not contribute, vertices without any contribution
+    // get an arbitrary tangent orthogonal to the normal.
+    //
+    // Work is split over submeshes and within large submeshes on the thread pool. The per-triangle and per-vertex math
+    // is vectorized with SSE (or AVX2 if the build targets it), while accumulation into vertices is done in index order,
+    // so the result is deterministic and does not depend on the number of threads
+    void GenerateTangents(std::span<const TangentGenerationDesc> descs, ThreadPool& threadPool);
+
+    // Scalar single-threaded implementation of exactly the same math. Used to validate GenerateTangents
+    void GenerateTangentsReference(const TangentGenerationDesc& desc);
+
+    // Max absolute difference of tangents (including handedness) of two tangent streams of numVertices
+    float GetMaxTangentDifference(const float* lhs, const float* rhs, uint32_t numVertices);
+
+} // Neb namespace
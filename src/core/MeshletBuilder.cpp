@@ -0,0 +1,225 @@
+#include "MeshletBuilder.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Neb
+{
+
+    namespace
+    {
+        static constexpr uint32_t InvalidMeshletVertex = UINT32_MAX;
+
+        // Cones wider than that are considered useless for culling (mostly flat or spherical meshlets)
+        static constexpr float MinConeDotProduct = 0.1f;
+
+        struct Float3
+        {
+            float x, y, z;
+        };
+
+        Float3 Sub(const Float3& a, const Float3& b) { return Float3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+        float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+        Float3 Cross(const Float3& a, const Float3& b) { return Float3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+        uint32_t LoadIndex(const MeshletSourceDesc& src, size_t i)
+        {
+            if (src.IndicesStride == sizeof(uint16_t))
+            {
+                uint16_t index;
+                std::memcpy(&index, src.Indices + i * sizeof(uint16_t), sizeof(uint16_t));
+                return index;
+            }
+
+            uint32_t index;
+            std::memcpy(&index, src.Indices + i * sizeof(uint32_t), sizeof(uint32_t));
+            return index;
+        }
+
+        Float3 LoadPosition(const MeshletSourceDesc& src, uint32_t index)
+        {
+            Float3 v;
+            std::memcpy(&v, src.Positions + size_t(index) * src.PositionsStride, sizeof(Float3));
+            return v;
+        }
+
+        void ComputeMeshletBounds(MeshletBounds& bounds, const MeshletData& data, const Meshlet& meshlet, const MeshletSourceDesc& src)
+        {
+            // Sphere around the center of the box, it is not the tightest one but it is cheap and stable
+            Float3 min = LoadPosition(src, data.Vertices[meshlet.VertexOffset]);
+            Float3 max = min;
+            for (uint32_t i = 1; i < meshlet.NumVertices; ++i)
+            {
+                const Float3 p = LoadPosition(src, data.Vertices[meshlet.VertexOffset + i]);
+                min = Float3{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+                max = Float3{ std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+            }
+
+            const Float3 center = Float3{ (min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f };
+            float radiusSquared = 0.0f;
+            for (uint32_t i = 0; i < meshlet.NumVertices; ++i)
+            {
+                const Float3 d = Sub(LoadPosition(src, data.Vertices[meshlet.VertexOffset + i]), center);
+                radiusSquared = std::max(radiusSquared, Dot(d, d));
+            }
+
+            bounds.Center[0] = center.x;
+            bounds.Center[1] = center.y;
+            bounds.Center[2] = center.z;
+            bounds.Radius = std::sqrt(radiusSquared);
+
+            // Normal cone. Axis is the average of unit triangle normals (CCW winding), degenerate triangles are ignored
+            const uint8_t* triangles = &data.Triangles[meshlet.TriangleOffset];
+            auto getTriangle = [&](uint32_t t, Float3& p0, Float3& normal) -> bool
+                {
+                    p0 = LoadPosition(src, data.Vertices[meshlet.VertexOffset + triangles[t * 3 + 0]]);
+                    const Float3 p1 = LoadPosition(src, data.Vertices[meshlet.VertexOffset + triangles[t * 3 + 1]]);
+                    const Float3 p2 = LoadPosition(src, data.Vertices[meshlet.VertexOffset + triangles[t * 3 + 2]]);
+
+                    normal = Cross(Sub(p1, p0), Sub(p2, p0));
+                    const float length = std::sqrt(Dot(normal, normal));
+                    if (length == 0.0f)
+                        return false;
+
+                    normal = Float3{ normal.x / length, normal.y / length, normal.z / length };
+                    return true;
+                };
+
+            Float3 axis = {};
+            for (uint32_t t = 0; t < meshlet.NumTriangles; ++t)
+            {
+                Float3 p0, normal;
+                if (getTriangle(t, p0, normal))
+                    axis = Float3{ axis.x + normal.x, axis.y + normal.y, axis.z + normal.z };
+            }
+
+            const float axisLength = std::sqrt(Dot(axis, axis));
+            if (axisLength == 0.0f)
+                return; // cone stays disabled
+
+            axis = Float3{ axis.x / axisLength, axis.y / axisLength, axis.z / axisLength };
+
+            float minDot = 1.0f;
+            for (uint32_t t = 0; t < meshlet.NumTriangles; ++t)
+            {
+                Float3 p0, normal;
+                if (getTriangle(t, p0, normal))
+                    minDot = std::min(minDot, Dot(axis, normal));
+            }
+
+            bounds.ConeAxis[0] = axis.x;
+            bounds.ConeAxis[1] = axis.y;
+            bounds.ConeAxis[2] = axis.z;
+            if (minDot <= MinConeDotProduct)
+                return;
+
+            // Apex is moved back along the axis until every triangle plane is in front of it,
+            // so that the test against the apex is conservative for every point of the meshlet
+            float maxT = 0.0f;
+            for (uint32_t t = 0; t < meshlet.NumTriangles; ++t)
+            {
+                Float3 p0, normal;
+                if (getTriangle(t, p0, normal))
+                    maxT = std::max(maxT, Dot(Sub(center, p0), normal) / Dot(axis, normal));
+            }
+
+            bounds.ConeApex[0] = center.x - axis.x * maxT;
+            bounds.ConeApex[1] = center.y - axis.y * maxT;
+            bounds.ConeApex[2] = center.z - axis.z * maxT;
+            bounds.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+    } // anonymous namespace
+
+    void BuildMeshlets(MeshletData& dst, const MeshletSourceDesc& src, const MeshletBuilderDesc& desc)
+    {
+        NEB_ASSERT(desc.MaxVertices >= 3 && desc.MaxVertices <= MeshletMaxVerticesLimit, "Invalid meshlet vertex limit {}", desc.MaxVertices);
+        NEB_ASSERT(desc.MaxTriangles >= 1 && desc.MaxTriangles <= MeshletMaxTrianglesLimit, "Invalid meshlet triangle limit {}", desc.MaxTriangles);
+        NEB_ASSERT(src.NumIndices % 3 == 0, "Only triangle lists are supported");
+        NEB_ASSERT(src.IndicesStride == sizeof(uint16_t) || src.IndicesStride == sizeof(uint32_t), "Unsupported index stride {}", src.IndicesStride);
+
+        dst = MeshletData();
+
+        const uint32_t numTriangles = src.NumIndices / 3;
+        if (numTriangles == 0)
+            return;
+
+        // Rough estimation, most of the meshlets are limited by triangles for well-connected meshes
+        const size_t expectedNumMeshlets = (numTriangles + desc.MaxTriangles - 1) / desc.MaxTriangles;
+        dst.Meshlets.reserve(expectedNumMeshlets);
+        dst.Bounds.reserve(expectedNumMeshlets);
+        dst.Vertices.reserve(std::min<size_t>(src.NumVertices + src.NumVertices / 2, expectedNumMeshlets * desc.MaxVertices));
+        dst.Triangles.reserve(size_t(numTriangles) * 3);
+
+        // Local index of every mesh vertex in the current meshlet
+        std::vector<uint32_t> meshletVertices(src.NumVertices, InvalidMeshletVertex);
+        Meshlet meshlet;
+
+        auto flushMeshlet = [&]()
+            {
+                if (meshlet.NumTriangles == 0)
+                    return;
+
+                for (uint32_t i = 0; i < meshlet.NumVertices; ++i)
+                    meshletVertices[dst.Vertices[meshlet.VertexOffset + i]] = InvalidMeshletVertex;
+
+                dst.Meshlets.push_back(meshlet);
+                ComputeMeshletBounds(dst.Bounds.emplace_back(), dst, meshlet, src);
+
+                meshlet = Meshlet{
+                    .VertexOffset = static_cast<uint32_t>(dst.Vertices.size()),
+                    .TriangleOffset = static_cast<uint32_t>(dst.Triangles.size()),
+                };
+            };
+
+        for (uint32_t t = 0; t < numTriangles; ++t)
+        {
+            uint32_t triangle[3];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                triangle[k] = LoadIndex(src, size_t(t) * 3 + k);
+                NEB_ASSERT(triangle[k] < src.NumVertices, "Index {} is out of bounds ({} vertices)", triangle[k], src.NumVertices);
+            }
+
+            // Degenerate triangles reference the same vertex more than once, it should only be counted once
+            uint32_t numNewVertices = 0;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const bool isDuplicate = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+                if (!isDuplicate && meshletVertices[triangle[k]] == InvalidMeshletVertex)
+                    ++numNewVertices;
+            }
+
+            if (meshlet.NumVertices + numNewVertices > desc.MaxVertices || meshlet.NumTriangles + 1 > desc.MaxTriangles)
+                flushMeshlet();
+
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t& local = meshletVertices[triangle[k]];
+                if (local == InvalidMeshletVertex)
+                {
+                    local = meshlet.NumVertices++;
+                    dst.Vertices.push_back(triangle[k]);
+                }
+                dst.Triangles.push_back(static_cast<uint8_t>(local));
+            }
+            ++meshlet.NumTriangles;
+        }
+        flushMeshlet();
+    }
+
+    void BuildMeshlets(std::span<MeshletData> dst, std::span<const MeshletSourceDesc> srcs, const MeshletBuilderDesc& desc, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(dst.size() == srcs.size(), "Each source should have its own meshlet data");
+
+        // Submeshes are independent, each of them is built as a whole on a single thread
+        threadPool.ParallelFor(srcs.size(), [&dst, &srcs, &desc](size_t i)
+            {
+                BuildMeshlets(dst[i], srcs[i], desc);
+            });
+    }
+
+} // Neb namespace
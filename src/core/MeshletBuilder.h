@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Output limits of a D3D12 mesh shader (https://microsoft.github.io/DirectX-Specs/d3d/MeshShader.html#limits)
+    static constexpr uint32_t MeshletMaxVerticesLimit = 256;
+    static constexpr uint32_t MeshletMaxTrianglesLimit = 256;
+
+    struct MeshletBuilderDesc
+    {
+        // Defaults are the usual recommendation for NVIDIA and AMD hardware
+        uint32_t MaxVertices = 64;
+        uint32_t MaxTriangles = 124;
+    };
+
+    // Source geometry of a single indexed triangle list. Positions may be strided (interleaved), indices are either 16 or 32 bit
+    struct MeshletSourceDesc
+    {
+        uint32_t NumVertices = 0;
+        const std::byte* Positions = nullptr; // float3
+        uint32_t PositionsStride = sizeof(float) * 3;
+
+        uint32_t NumIndices = 0;
+        uint32_t IndicesStride = 0;
+        const std::byte* Indices = nullptr;
+    };
+
+    struct Meshlet
+    {
+        uint32_t VertexOffset = 0;   // into MeshletData::Vertices
+        uint32_t TriangleOffset = 0; // in bytes, into MeshletData::Triangles
+        uint32_t NumVertices = 0;
+        uint32_t NumTriangles = 0;
+    };
+
+    // Culling bounds of a meshlet in mesh space. The meshlet is entirely backfacing (and can be culled) if
+    // dot(normalize(ConeApex - cameraPosition), ConeAxis) >= ConeCutoff. ConeCutoff is 1 if the cone is too wide to ever cull
+    struct MeshletBounds
+    {
+        float Center[3] = {};
+        float Radius = 0.0f;
+
+        float ConeApex[3] = {};
+        float ConeAxis[3] = {};
+        float ConeCutoff = 1.0f; // sine of the cone half-angle
+    };
+
+    struct MeshletData
+    {
+        std::vector<Meshlet> Meshlets;
+        std::vector<MeshletBounds> Bounds; // per meshlet
+
+        // Mesh vertex index of every meshlet vertex
+        std::vector<uint32_t> Vertices;
+
+        // Micro-indices into meshlet vertices, 3 bytes per triangle, tightly packed with no padding between meshlets
+        std::vector<uint8_t> Triangles;
+    };
+
+    // Meshlets are built by walking triangles in index order, so the source is expected to be optimized for vertex cache first
+    // (see MeshOptimizer.h), which gives meshlets good locality. A new meshlet is started as soon as the next triangle would
+    // exceed any of the limits. The result only depends on the source, which makes it deterministic
+    void BuildMeshlets(MeshletData& dst, const MeshletSourceDesc& src, const MeshletBuilderDesc& desc = {});
+
+    // Builds meshlets of every source on the thread pool. dst and srcs are expected to be of the same size
+    void BuildMeshlets(std::span<MeshletData> dst, std::span<const MeshletSourceDesc> srcs, const MeshletBuilderDesc& desc, ThreadPool& threadPool);
+
+} // Neb namespace
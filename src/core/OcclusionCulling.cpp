@@ -0,0 +1,482 @@
+#include "OcclusionCulling.h"
+
+#include "../common/Assert.h"
+#include "../common/TimeWatch.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace Neb
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        static constexpr float ClearDepth = 1.0f;
+
+#if defined(__AVX2__)
+        using FloatV = __m256;
+        static constexpr uint32_t SimdWidth = 8;
+
+        FloatV SetV(float v) { return _mm256_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm256_loadu_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm256_storeu_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm256_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm256_max_ps(a, b); }
+        FloatV AndV(FloatV a, FloatV b) { return _mm256_and_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        FloatV GreaterEqualV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        FloatV LessEqualV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm256_blendv_ps(b, a, mask); }
+        uint32_t MoveMaskV(FloatV mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask)); }
+        FloatV PixelCentersV() { return _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f); }
+#else
+        // SSE2 is always there on x64
+        using FloatV = __m128;
+        static constexpr uint32_t SimdWidth = 4;
+
+        FloatV SetV(float v) { return _mm_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm_loadu_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm_storeu_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm_max_ps(a, b); }
+        FloatV AndV(FloatV a, FloatV b) { return _mm_and_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm_cmpgt_ps(a, b); }
+        FloatV GreaterEqualV(FloatV a, FloatV b) { return _mm_cmpge_ps(a, b); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm_cmplt_ps(a, b); }
+        FloatV LessEqualV(FloatV a, FloatV b) { return _mm_cmple_ps(a, b); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        uint32_t MoveMaskV(FloatV mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask)); }
+        FloatV PixelCentersV() { return _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f); }
+#endif
+
+        struct ClipVertex
+        {
+            float X, Y, Z, W;
+        };
+
+        ClipVertex TransformToClip(const Vec3& p, const Mat4& m)
+        {
+            return ClipVertex{
+                .X = p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+                .Y = p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+                .Z = p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+                .W = p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44,
+            };
+        }
+
+        // Vertices in front of the near plane (D3D clip z >= 0)
+        bool IsInFrontOfNearPlane(const ClipVertex& v) { return v.Z >= 0.0f && v.W > 0.0f; }
+
+        int32_t ClampPixel(float v, uint32_t size) { return static_cast<int32_t>(std::clamp(v, -1.0f, float(size))); }
+
+        // Triangles that cross the near plane are not clipped, but skipped. Returns false if the triangle is not going to be rasterized
+        bool SetupOccluderTriangle(OccluderTriangle& triangle, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t width, uint32_t height)
+        {
+            triangle.MinX = triangle.MinY = 1;
+            triangle.MaxX = triangle.MaxY = 0;
+
+            const ClipVertex* vertices[3] = { &v0, &v1, &v2 };
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                const ClipVertex& v = *vertices[i];
+                if (!IsInFrontOfNearPlane(v))
+                    return false;
+
+                const float invW = 1.0f / v.W;
+                triangle.X[i] = (v.X * invW * 0.5f + 0.5f) * float(width);
+                triangle.Y[i] = (0.5f - v.Y * invW * 0.5f) * float(height);
+                triangle.Z[i] = v.Z * invW;
+            }
+
+            // Rasterizer expects positive area, that is E(p) > 0 inside for every edge function (see GetEdgeFunction)
+            const float area = (triangle.X[1] - triangle.X[0]) * (triangle.Y[2] - triangle.Y[0]) - (triangle.X[2] - triangle.X[0]) * (triangle.Y[1] - triangle.Y[0]);
+            if (!(std::abs(area) > 1e-6f))
+                return false;
+
+            if (area < 0.0f)
+            {
+                std::swap(triangle.X[1], triangle.X[2]);
+                std::swap(triangle.Y[1], triangle.Y[2]);
+                std::swap(triangle.Z[1], triangle.Z[2]);
+            }
+
+            // Pixels whose centers (x + 0.5) are within the bounds of the triangle
+            const float minX = std::min({ triangle.X[0], triangle.X[1], triangle.X[2] });
+            const float maxX = std::max({ triangle.X[0], triangle.X[1], triangle.X[2] });
+            const float minY = std::min({ triangle.Y[0], triangle.Y[1], triangle.Y[2] });
+            const float maxY = std::max({ triangle.Y[0], triangle.Y[1], triangle.Y[2] });
+            triangle.MinX = std::max(ClampPixel(std::ceil(minX - 0.5f), width), 0);
+            triangle.MaxX = std::min(ClampPixel(std::floor(maxX - 0.5f), width), int32_t(width) - 1);
+            triangle.MinY = std::max(ClampPixel(std::ceil(minY - 0.5f), height), 0);
+            triangle.MaxY = std::min(ClampPixel(std::floor(maxY - 0.5f), height), int32_t(height) - 1);
+            return triangle.MinX <= triangle.MaxX && triangle.MinY <= triangle.MaxY;
+        }
+
+        // E(p) = A * x + B * y + C, positive on the inner side of the edge from a to b. Edges shared by two triangles are evaluated
+        // with exactly negated coefficients, thus exactly one of them includes points on the edge (top-left rule)
+        struct EdgeFunction
+        {
+            float A, B, C;
+            bool IsInclusive;
+        };
+
+        EdgeFunction GetEdgeFunction(float ax, float ay, float bx, float by)
+        {
+            const float a = ay - by;
+            const float b = bx - ax;
+            return EdgeFunction{ .A = a, .B = b, .C = ax * by - ay * bx, .IsInclusive = a > 0.0f || (a == 0.0f && b > 0.0f) };
+        }
+
+        // Depth is a plane in screen space, z(p) = A * x + B * y + C
+        struct DepthPlane
+        {
+            float A, B, C;
+        };
+
+        DepthPlane GetDepthPlane(const OccluderTriangle& t)
+        {
+            const float area = (t.X[1] - t.X[0]) * (t.Y[2] - t.Y[0]) - (t.X[2] - t.X[0]) * (t.Y[1] - t.Y[0]);
+            const float a = ((t.Z[1] - t.Z[0]) * (t.Y[2] - t.Y[0]) - (t.Z[2] - t.Z[0]) * (t.Y[1] - t.Y[0])) / area;
+            const float b = ((t.X[1] - t.X[0]) * (t.Z[2] - t.Z[0]) - (t.X[2] - t.X[0]) * (t.Z[1] - t.Z[0])) / area;
+            return DepthPlane{ .A = a, .B = b, .C = t.Z[0] - a * t.X[0] - b * t.Y[0] };
+        }
+
+        // Pixel rectangle and the closest depth of a box. Returns false if the box crosses the near plane or is off screen
+        bool ProjectBox(const AABB& box, const Mat4& viewProj, uint32_t width, uint32_t height, int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1, float& minZ)
+        {
+            float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+            minZ = FLT_MAX;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const Vec3 corner = Vec3((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+                const ClipVertex v = TransformToClip(corner, viewProj);
+                if (!IsInFrontOfNearPlane(v))
+                    return false;
+
+                const float invW = 1.0f / v.W;
+                const float x = (v.X * invW * 0.5f + 0.5f) * float(width);
+                const float y = (0.5f - v.Y * invW * 0.5f) * float(height);
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                minZ = std::min(minZ, v.Z * invW);
+            }
+
+            if (!(maxX >= 0.0f && minX < float(width) && maxY >= 0.0f && minY < float(height)))
+                return false;
+
+            // Every pixel the rectangle touches
+            x0 = static_cast<int32_t>(std::max(minX, 0.0f));
+            x1 = static_cast<int32_t>(std::min(maxX, float(width - 1)));
+            y0 = static_cast<int32_t>(std::max(minY, 0.0f));
+            y1 = static_cast<int32_t>(std::min(maxY, float(height - 1)));
+            return true;
+        }
+    } // anonymous namespace
+
+    void BuildOccluderMesh(OccluderMesh& dst, std::span<const OccluderSourceDesc> srcs)
+    {
+        dst.Positions.clear();
+        dst.Indices.clear();
+
+        std::vector<uint32_t> remap;
+        for (const OccluderSourceDesc& src : srcs)
+        {
+            NEB_ASSERT(src.IndicesStride == sizeof(uint16_t) || src.IndicesStride == sizeof(uint32_t), "Unsupported index stride {}", src.IndicesStride);
+            NEB_ASSERT(src.NumIndices % 3 == 0, "Occluders are made of triangle lists");
+
+            remap.assign(src.NumVertices, UINT32_MAX);
+            for (uint32_t i = 0; i < src.NumIndices; ++i)
+            {
+                uint32_t index = 0;
+                std::memcpy(&index, src.Indices + size_t(i) * src.IndicesStride, src.IndicesStride);
+                NEB_ASSERT(index < src.NumVertices, "Index {} is out of range ({} vertices)", index, src.NumVertices);
+
+                if (remap[index] == UINT32_MAX)
+                {
+                    Vec3 position;
+                    const std::byte* element = src.Positions + size_t(index) * src.PositionsStride;
+                    if (src.Quantization)
+                    {
+                        CompactPosition compact;
+                        std::memcpy(&compact, element, sizeof(CompactPosition));
+                        DecodePositions(&position.x, std::span(&compact, 1), *src.Quantization);
+                    }
+                    else std::memcpy(&position.x, element, sizeof(float) * 3);
+
+                    remap[index] = static_cast<uint32_t>(dst.Positions.size());
+                    dst.Positions.push_back(position);
+                }
+                dst.Indices.push_back(remap[index]);
+            }
+        }
+    }
+
+    void OcclusionCuller::Init(const OcclusionCullerDesc& desc)
+    {
+        NEB_ASSERT(desc.Width > 0 && desc.Height > 0 && desc.Width % TileSize == 0 && desc.Height % TileSize == 0,
+            "Resolution of the occlusion buffer should be a multiple of {} ({}x{})", TileSize, desc.Width, desc.Height);
+        NEB_ASSERT(desc.MinTriangles <= desc.MaxTriangles, "Invalid triangle budget");
+
+        m_desc = desc;
+        m_numTilesX = desc.Width / TileSize;
+        m_numTilesY = desc.Height / TileSize;
+        m_numBinsX = (desc.Width + BinWidth - 1) / BinWidth;
+        m_numBinsY = (desc.Height + BinHeight - 1) / BinHeight;
+
+        m_depth.assign(size_t(desc.Width) * desc.Height, ClearDepth);
+        m_tileDepth.assign(size_t(m_numTilesX) * m_numTilesY, ClearDepth);
+        m_triangleBudget = std::clamp(desc.MaxTriangles / 4, desc.MinTriangles, desc.MaxTriangles);
+        m_stats = OcclusionStats();
+    }
+
+    void OcclusionCuller::BeginFrame(const Mat4& viewProj)
+    {
+        // Depth is cleared by bins in Rasterize(), together with rasterization
+        m_viewProj = viewProj;
+        m_occluders.clear();
+        m_isBudgetExhausted = false;
+        m_stats = OcclusionStats{ .TriangleBudget = m_triangleBudget };
+    }
+
+    bool OcclusionCuller::AddOccluder(const OccluderMesh& mesh, const Mat4& meshToWorld)
+    {
+        const uint32_t numTriangles = mesh.GetNumTriangles();
+        if (numTriangles == 0)
+            return true;
+
+        if (m_stats.NumTriangles + numTriangles > m_triangleBudget)
+        {
+            m_isBudgetExhausted = true;
+            return false;
+        }
+
+        m_occluders.push_back(Occluder{ .Mesh = &mesh, .MeshToClip = meshToWorld * m_viewProj, .FirstTriangle = m_stats.NumTriangles });
+        m_stats.NumOccluders += 1;
+        m_stats.NumTriangles += numTriangles;
+        return true;
+    }
+
+    void OcclusionCuller::Rasterize(ThreadPool& threadPool)
+    {
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        m_triangles.resize(m_stats.NumTriangles);
+        threadPool.ParallelFor(m_occluders.size(), [this](size_t i) { SetupTriangles(m_occluders[i]); });
+        threadPool.ParallelFor(size_t(m_numBinsX) * m_numBinsY, [this](size_t bin)
+            {
+                RasterizeBin(static_cast<uint32_t>(bin % m_numBinsX), static_cast<uint32_t>(bin / m_numBinsX));
+            });
+
+        for (const Occluder& occluder : m_occluders)
+            m_stats.NumRasterized += occluder.NumRasterized;
+        m_stats.RasterMilliseconds = timeWatch.Elapsed<MillisecondsF32>().count();
+
+        // Shrink the budget if rasterization took too long, only grow it if it limited occluders of this frame
+        const float budgetMilliseconds = m_desc.BudgetMilliseconds;
+        const float elapsedMilliseconds = std::max(m_stats.RasterMilliseconds, 1e-3f);
+        float scale = 1.0f;
+        if (elapsedMilliseconds > budgetMilliseconds)
+            scale = std::max(budgetMilliseconds / elapsedMilliseconds, 0.5f);
+        else if (m_isBudgetExhausted && elapsedMilliseconds < budgetMilliseconds * 0.8f)
+            scale = std::min(budgetMilliseconds / elapsedMilliseconds, 1.25f);
+
+        m_triangleBudget = std::clamp(static_cast<uint32_t>(float(m_triangleBudget) * scale), m_desc.MinTriangles, m_desc.MaxTriangles);
+    }
+
+    void OcclusionCuller::SetupTriangles(Occluder& occluder)
+    {
+        const OccluderMesh& mesh = *occluder.Mesh;
+        std::vector<ClipVertex> vertices(mesh.Positions.size());
+        for (size_t i = 0; i < mesh.Positions.size(); ++i)
+            vertices[i] = TransformToClip(mesh.Positions[i], occluder.MeshToClip);
+
+        occluder.MinX = occluder.MinY = INT32_MAX;
+        occluder.MaxX = occluder.MaxY = INT32_MIN;
+        occluder.NumRasterized = 0;
+        for (uint32_t i = 0; i < mesh.GetNumTriangles(); ++i)
+        {
+            OccluderTriangle& triangle = m_triangles[occluder.FirstTriangle + i];
+            const uint32_t* indices = &mesh.Indices[size_t(i) * 3];
+            if (!SetupOccluderTriangle(triangle, vertices[indices[0]], vertices[indices[1]], vertices[indices[2]], m_desc.Width, m_desc.Height))
+                continue;
+
+            occluder.MinX = std::min(occluder.MinX, triangle.MinX);
+            occluder.MinY = std::min(occluder.MinY, triangle.MinY);
+            occluder.MaxX = std::max(occluder.MaxX, triangle.MaxX);
+            occluder.MaxY = std::max(occluder.MaxY, triangle.MaxY);
+            occluder.NumRasterized += 1;
+        }
+    }
+
+    void OcclusionCuller::RasterizeBin(uint32_t binX, uint32_t binY)
+    {
+        const int32_t binMinX = int32_t(binX * BinWidth);
+        const int32_t binMinY = int32_t(binY * BinHeight);
+        const int32_t binMaxX = std::min(binMinX + int32_t(BinWidth), int32_t(m_desc.Width)) - 1;
+        const int32_t binMaxY = std::min(binMinY + int32_t(BinHeight), int32_t(m_desc.Height)) - 1;
+
+        for (int32_t y = binMinY; y <= binMaxY; ++y)
+            std::fill_n(m_depth.data() + size_t(y) * m_desc.Width + binMinX, binMaxX - binMinX + 1, ClearDepth);
+
+        // Whole occluders are skipped first, as most of them only cover a few bins
+        for (const Occluder& occluder : m_occluders)
+        {
+            if (occluder.MinX > binMaxX || occluder.MaxX < binMinX || occluder.MinY > binMaxY || occluder.MaxY < binMinY)
+                continue;
+
+            const uint32_t numTriangles = occluder.Mesh->GetNumTriangles();
+            for (uint32_t i = 0; i < numTriangles; ++i)
+            {
+                const OccluderTriangle& triangle = m_triangles[occluder.FirstTriangle + i];
+                const int32_t minX = std::max(triangle.MinX, binMinX);
+                const int32_t maxX = std::min(triangle.MaxX, binMaxX);
+                const int32_t minY = std::max(triangle.MinY, binMinY);
+                const int32_t maxY = std::min(triangle.MaxY, binMaxY);
+                if (minX <= maxX && minY <= maxY)
+                    RasterizeTriangle(triangle, minX, minY, maxX, maxY);
+            }
+        }
+
+        // Bins are made of whole tiles
+        for (uint32_t tileY = uint32_t(binMinY) / TileSize; tileY <= uint32_t(binMaxY) / TileSize; ++tileY)
+            for (uint32_t tileX = uint32_t(binMinX) / TileSize; tileX <= uint32_t(binMaxX) / TileSize; ++tileX)
+                BuildTileDepth(tileX, tileY);
+    }
+
+    void OcclusionCuller::RasterizeTriangle(const OccluderTriangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY)
+    {
+        const EdgeFunction edges[3] = {
+            GetEdgeFunction(triangle.X[0], triangle.Y[0], triangle.X[1], triangle.Y[1]),
+            GetEdgeFunction(triangle.X[1], triangle.Y[1], triangle.X[2], triangle.Y[2]),
+            GetEdgeFunction(triangle.X[2], triangle.Y[2], triangle.X[0], triangle.Y[0]),
+        };
+        const DepthPlane plane = GetDepthPlane(triangle);
+
+        const FloatV zero = SetV(0.0f);
+        const FloatV pixelCenters = PixelCentersV();
+        const FloatV minPixelX = SetV(float(minX) + 0.5f);
+        const FloatV maxPixelX = SetV(float(maxX) + 0.5f);
+        const FloatV edgeA[3] = { SetV(edges[0].A), SetV(edges[1].A), SetV(edges[2].A) };
+        const FloatV edgeC[3] = { SetV(edges[0].C), SetV(edges[1].C), SetV(edges[2].C) };
+        const FloatV depthA = SetV(plane.A);
+        const FloatV depthC = SetV(plane.C);
+
+        // Interpolated depth never leaves the range of the vertices, even where rounding would take it there
+        const FloatV minDepth = SetV(std::min({ triangle.Z[0], triangle.Z[1], triangle.Z[2] }));
+        const FloatV maxDepth = SetV(std::max({ triangle.Z[0], triangle.Z[1], triangle.Z[2] }));
+
+        // Rows are split into SIMD blocks, that never cross bins (bins start at multiples of the SIMD width)
+        const int32_t beginX = minX & ~int32_t(SimdWidth - 1);
+        for (int32_t y = minY; y <= maxY; ++y)
+        {
+            const float pixelY = float(y) + 0.5f;
+            const FloatV edgeBY[3] = { SetV(edges[0].B * pixelY), SetV(edges[1].B * pixelY), SetV(edges[2].B * pixelY) };
+            const FloatV depthBY = SetV(plane.B * pixelY);
+
+            float* row = m_depth.data() + size_t(y) * m_desc.Width;
+            for (int32_t x = beginX; x <= maxX; x += SimdWidth)
+            {
+                const FloatV pixelX = AddV(SetV(float(x)), pixelCenters);
+                FloatV isCovered = AndV(GreaterEqualV(pixelX, minPixelX), LessEqualV(pixelX, maxPixelX));
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    const FloatV e = AddV(AddV(MulV(edgeA[i], pixelX), edgeBY[i]), edgeC[i]);
+                    isCovered = AndV(isCovered, edges[i].IsInclusive ? GreaterEqualV(e, zero) : GreaterV(e, zero));
+                }
+
+                if (MoveMaskV(isCovered) == 0)
+                    continue;
+
+                const FloatV z = MinV(MaxV(AddV(AddV(MulV(depthA, pixelX), depthBY), depthC), minDepth), maxDepth);
+                const FloatV depth = LoadV(row + x);
+                StoreV(row + x, SelectV(AndV(isCovered, LessV(z, depth)), z, depth));
+            }
+        }
+    }
+
+    void OcclusionCuller::BuildTileDepth(uint32_t tileX, uint32_t tileY)
+    {
+        float farthest = 0.0f;
+        for (uint32_t y = tileY * TileSize; y < (tileY + 1) * TileSize; ++y)
+        {
+            const float* row = m_depth.data() + size_t(y) * m_desc.Width + tileX * TileSize;
+            farthest = std::max(farthest, *std::max_element(row, row + TileSize));
+        }
+        m_tileDepth[size_t(tileY) * m_numTilesX + tileX] = farthest;
+    }
+
+    bool OcclusionCuller::IsVisible(const AABB& worldBox) const
+    {
+        int32_t x0, y0, x1, y1;
+        float minZ;
+        if (!ProjectBox(worldBox, m_viewProj, m_desc.Width, m_desc.Height, x0, y0, x1, y1, minZ))
+            return true;
+
+        // Box is hidden behind a pixel if the occluder there is closer than any point of the box
+        for (int32_t tileY = y0 / int32_t(TileSize); tileY <= y1 / int32_t(TileSize); ++tileY)
+        {
+            for (int32_t tileX = x0 / int32_t(TileSize); tileX <= x1 / int32_t(TileSize); ++tileX)
+            {
+                if (m_tileDepth[size_t(tileY) * m_numTilesX + tileX] < minZ)
+                    continue;
+
+                const int32_t beginX = std::max(x0, tileX * int32_t(TileSize));
+                const int32_t endX = std::min(x1, (tileX + 1) * int32_t(TileSize) - 1);
+                const int32_t beginY = std::max(y0, tileY * int32_t(TileSize));
+                const int32_t endY = std::min(y1, (tileY + 1) * int32_t(TileSize) - 1);
+                for (int32_t y = beginY; y <= endY; ++y)
+                {
+                    const float* row = m_depth.data() + size_t(y) * m_desc.Width;
+                    for (int32_t x = beginX; x <= endX; ++x)
+                    {
+                        if (row[x] >= minZ)
+                            return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    uint32_t OcclusionCuller::TestBoxes(std::span<const AABB> boxes, std::span<uint8_t> visible, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(boxes.size() == visible.size(), "Every box should have its result");
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        std::atomic<uint32_t> numOccluded = 0;
+        threadPool.ParallelForRange(boxes.size(), 512, [&](size_t begin, size_t end)
+            {
+                uint32_t numOccludedInRange = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    visible[i] = IsVisible(boxes[i]) ? 1 : 0;
+                    numOccludedInRange += visible[i] ? 0 : 1;
+                }
+                numOccluded.fetch_add(numOccludedInRange, std::memory_order_relaxed);
+            });
+
+        m_stats.NumTested += static_cast<uint32_t>(boxes.size());
+        m_stats.NumOccluded += numOccluded.load(std::memory_order_relaxed);
+        m_stats.TestMilliseconds += timeWatch.Elapsed<MillisecondsF32>().count();
+        return numOccluded.load(std::memory_order_relaxed);
+    }
+
+} // Neb namespace
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Math.h"
+#include "VertexCompression.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Simplified geometry of a mesh, that is rasterized into the occlusion buffer. Indexed triangles in mesh space
+    struct OccluderMesh
+    {
+        std::vector<Vec3> Positions;
+        std::vector<uint32_t> Indices;
+
+        uint32_t GetNumTriangles() const { return static_cast<uint32_t>(Indices.size() / 3); }
+    };
+
+    // Single submesh (or LOD of it) to be merged into an occluder. Positions may be strided
+    struct OccluderSourceDesc
+    {
+        uint32_t NumVertices = 0;
+        const std::byte* Positions = nullptr; // float3, or CompactPosition if Quantization is set
+        uint32_t PositionsStride = sizeof(float) * 3;
+        const PositionQuantization* Quantization = nullptr;
+
+        uint32_t NumIndices = 0;
+        uint32_t IndicesStride = 0; // 2 or 4
+        const std::byte* Indices = nullptr; // already offset to the first index of the LOD
+    };
+
+    // Merges sources into a single occluder, only vertices referenced by indices are kept
+    void BuildOccluderMesh(OccluderMesh& dst, std::span<const OccluderSourceDesc> srcs);
+
+    struct OcclusionCullerDesc
+    {
+        // Resolution of the depth buffer, should be a multiple of OcclusionCuller::TileSize
+        uint32_t Width = 320;
+        uint32_t Height = 192;
+
+        // Occluder triangles of a frame are limited by a budget, which is adjusted each frame so that
+        // rasterization takes about BudgetMilliseconds. The budget never goes beyond MaxTriangles
+        uint32_t MaxTriangles = 65536;
+        uint32_t MinTriangles = 1024;
+        float BudgetMilliseconds = 1.0f;
+    };
+
+    // Triangle of an occluder in screen space (pixels, y goes down, D3D depth) with positive area
+    struct OccluderTriangle
+    {
+        float X[3];
+        float Y[3];
+        float Z[3];
+        int32_t MinX, MinY, MaxX, MaxY; // inclusive pixel bounds, MinX > MaxX if the triangle is not rasterized
+    };
+
+    struct OcclusionStats
+    {
+        uint32_t NumOccluders = 0;
+        uint32_t NumTriangles = 0;     // of every added occluder
+        uint32_t NumRasterized = 0;    // triangles that reached the depth buffer (in front of the near plane and not degenerate)
+        uint32_t NumTested = 0;
+        uint32_t NumOccluded = 0;
+        uint32_t TriangleBudget = 0;   // of the frame
+        float RasterMilliseconds = 0.0f;
+        float TestMilliseconds = 0.0f;
+    };
+
+    // Software occlusion culling. Occluders are rasterized on the CPU into a low resolution depth buffer, which is split
+    // into bins rasterized in parallel (each bin by a single thread, thus without any synchronization). Pixels are covered
+    // SIMD-width at a time with edge functions and the top-left rule, so that shared edges are neither left open nor covered twice.
+    // Depth is D3D depth (0 at the near plane), each pixel keeps the closest occluder.
+    //
+    // Draws are tested with the screen-space rectangle and the closest depth of their world box. The test is hierarchical:
+    // each 8x8 tile keeps the farthest depth of its pixels, only tiles that cannot reject the box on their own are tested per pixel.
+    // Occluders are never clipped, triangles that cross the near plane are skipped. Both make the culler conservative
+    class OcclusionCuller
+    {
+    public:
+        static constexpr uint32_t TileSize = 8;
+        static constexpr uint32_t BinWidth = 64;
+        static constexpr uint32_t BinHeight = 32;
+
+        void Init(const OcclusionCullerDesc& desc);
+
+        // Clears the depth buffer and resets occluders of the last frame
+        void BeginFrame(const Mat4& viewProj);
+
+        // Occluder mesh should stay alive until Rasterize(). Returns false (and skips the occluder) if it does not fit the triangle budget
+        bool AddOccluder(const OccluderMesh& mesh, const Mat4& meshToWorld);
+
+        // Rasterizes every added occluder and builds the depth hierarchy, then adjusts the triangle budget for the next frame
+        void Rasterize(ThreadPool& threadPool);
+
+        // Thread-safe after Rasterize(). Boxes that are not occluded or cannot be projected (cross the near plane) are visible
+        bool IsVisible(const AABB& worldBox) const;
+
+        // visible[i] = IsVisible(boxes[i]), in parallel. Returns amount of occluded boxes
+        uint32_t TestBoxes(std::span<const AABB> boxes, std::span<uint8_t> visible, ThreadPool& threadPool);
+
+        const OcclusionCullerDesc& GetDesc() const { return m_desc; }
+        const Mat4& GetViewProj() const { return m_viewProj; }
+        const OcclusionStats& GetStats() const { return m_stats; }
+        uint32_t GetWidth() const { return m_desc.Width; }
+        uint32_t GetHeight() const { return m_desc.Height; }
+        std::span<const float> GetDepth() const { return m_depth; }
+
+    private:
+        struct Occluder
+        {
+            const OccluderMesh* Mesh = nullptr;
+            Mat4 MeshToClip;
+            uint32_t FirstTriangle = 0; // into m_triangles
+            uint32_t NumRasterized = 0;
+            int32_t MinX = 0, MinY = 0, MaxX = -1, MaxY = -1; // pixel bounds of rasterized triangles, bins skip occluders outside of them
+        };
+
+        void SetupTriangles(Occluder& occluder);
+        void RasterizeBin(uint32_t binX, uint32_t binY);
+        void RasterizeTriangle(const OccluderTriangle& triangle, int32_t minX, int32_t minY, int32_t maxX, int32_t maxY);
+        void BuildTileDepth(uint32_t tileX, uint32_t tileY);
+
+        OcclusionCullerDesc m_desc;
+        uint32_t m_numTilesX = 0;
+        uint32_t m_numTilesY = 0;
+        uint32_t m_numBinsX = 0;
+        uint32_t m_numBinsY = 0;
+
+        Mat4 m_viewProj;
+        std::vector<float> m_depth;     // Width * Height
+        std::vector<float> m_tileDepth; // farthest depth of each tile
+
+        std::vector<Occluder> m_occluders;
+        std::vector<OccluderTriangle> m_triangles;
+        uint32_t m_triangleBudget = 0;
+        bool m_isBudgetExhausted = false; // some occluder was rejected this frame
+
+        OcclusionStats m_stats;
+    };
+
+} // Neb namespace
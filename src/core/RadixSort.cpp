@@ -0,0 +1,119 @@
+#include "RadixSort.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace Neb
+{
+
+    void RadixSorter::Sort(std::span<uint64_t> keys, std::span<uint32_t> values, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(keys.size() == values.size(), "Radix sort has {} keys while {} values", keys.size(), values.size());
+        NEB_ASSERT(keys.size() <= UINT32_MAX, "Radix sort offsets are 32-bit");
+
+        const size_t numKeys = keys.size();
+        m_numSkippedPasses = NumPasses;
+        if (numKeys <= 1)
+            return;
+
+        // Single block per thread, scattering from more blocks would only split writes of a bucket into more streams
+        const size_t numBlocks = std::clamp<size_t>(numKeys / MinBlockSize, 1, threadPool.GetNumThreads());
+        const size_t blockSize = (numKeys + numBlocks - 1) / numBlocks;
+        auto getBlockRange = [numKeys, blockSize](size_t blockIndex)
+            {
+                return std::make_pair(blockIndex * blockSize, std::min(numKeys, (blockIndex + 1) * blockSize));
+            };
+
+        m_scratchKeys.resize(numKeys);
+        m_scratchValues.resize(numKeys);
+        m_blockHistograms.resize(numBlocks * NumBuckets);
+
+        // Bits that differ between any two keys, digits where none of them do are already sorted
+        m_blockBits.resize(numBlocks * 2);
+        threadPool.ParallelFor(numBlocks, [&](size_t blockIndex)
+            {
+                const auto [begin, end] = getBlockRange(blockIndex);
+                uint64_t andBits = UINT64_MAX;
+                uint64_t orBits = 0;
+                for (size_t i = begin; i < end; ++i)
+                {
+                    andBits &= keys[i];
+                    orBits |= keys[i];
+                }
+                m_blockBits[blockIndex * 2 + 0] = andBits;
+                m_blockBits[blockIndex * 2 + 1] = orBits;
+            });
+
+        uint64_t andBits = UINT64_MAX;
+        uint64_t orBits = 0;
+        for (size_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+        {
+            andBits &= m_blockBits[blockIndex * 2 + 0];
+            orBits |= m_blockBits[blockIndex * 2 + 1];
+        }
+        const uint64_t differentBits = andBits ^ orBits;
+
+        std::span<uint64_t> srcKeys = keys;
+        std::span<uint32_t> srcValues = values;
+        std::span<uint64_t> dstKeys = m_scratchKeys;
+        std::span<uint32_t> dstValues = m_scratchValues;
+        for (uint32_t pass = 0; pass < NumPasses; ++pass)
+        {
+            const uint32_t shift = pass * NumDigitBits;
+            if (((differentBits >> shift) & (NumBuckets - 1)) == 0)
+                continue;
+
+            --m_numSkippedPasses;
+            threadPool.ParallelFor(numBlocks, [&](size_t blockIndex)
+                {
+                    const auto [begin, end] = getBlockRange(blockIndex);
+                    uint32_t* histogram = m_blockHistograms.data() + blockIndex * NumBuckets;
+                    std::fill_n(histogram, NumBuckets, 0);
+                    for (size_t i = begin; i < end; ++i)
+                        ++histogram[(srcKeys[i] >> shift) & (NumBuckets - 1)];
+                });
+
+            // Exclusive offsets, for each bucket blocks follow each other in their order
+            uint32_t offset = 0;
+            for (uint32_t bucket = 0; bucket < NumBuckets; ++bucket)
+            {
+                for (size_t blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+                {
+                    uint32_t& count = m_blockHistograms[blockIndex * NumBuckets + bucket];
+                    const uint32_t numInBucket = count;
+                    count = offset;
+                    offset += numInBucket;
+                }
+            }
+
+            threadPool.ParallelFor(numBlocks, [&](size_t blockIndex)
+                {
+                    const auto [begin, end] = getBlockRange(blockIndex);
+                    uint32_t* offsets = m_blockHistograms.data() + blockIndex * NumBuckets;
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        const uint32_t dst = offsets[(srcKeys[i] >> shift) & (NumBuckets - 1)]++;
+                        dstKeys[dst] = srcKeys[i];
+                        dstValues[dst] = srcValues[i];
+                    }
+                });
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcValues, dstValues);
+        }
+
+        // Odd amount of passes leaves sorted keys in scratch memory
+        if (srcKeys.data() != keys.data())
+        {
+            threadPool.ParallelForRange(numKeys, MinBlockSize * 4, [&](size_t begin, size_t end)
+                {
+                    std::copy(srcKeys.begin() + begin, srcKeys.begin() + end, keys.begin() + begin);
+                    std::copy(srcValues.begin() + begin, srcValues.begin() + end, values.begin() + begin);
+                });
+        }
+    }
+
+} // Neb namespace
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Stable LSD radix sort of 64-bit keys together with 32-bit values (usually indices of whatever is sorted), a byte per pass.
+    // Each pass splits keys into blocks, histograms of blocks are built in parallel and then every block scatters its keys
+    // into offsets of its own, which keeps the sort stable without any synchronization between threads.
+    // Passes of bytes that are the same in every key are skipped, so keys that only use some of their bits are cheaper.
+    // Scratch memory is kept between sorts, thus sorting every frame does not allocate once it is warmed up
+    class RadixSorter
+    {
+    public:
+        static constexpr uint32_t NumDigitBits = 8;
+        static constexpr uint32_t NumBuckets = 1 << NumDigitBits;
+        static constexpr uint32_t NumPasses = 64 / NumDigitBits;
+
+        // Keys smaller than that are sorted by a single block on the calling thread
+        static constexpr uint32_t MinBlockSize = 16384;
+
+        // Sorts keys in place, values are reordered the same way. Both should be of the same size
+        void Sort(std::span<uint64_t> keys, std::span<uint32_t> values, ThreadPool& threadPool);
+
+        // Of the last sort
+        uint32_t GetNumSkippedPasses() const { return m_numSkippedPasses; }
+
+    private:
+        std::vector<uint64_t> m_scratchKeys;
+        std::vector<uint32_t> m_scratchValues;
+        std::vector<uint32_t> m_blockHistograms; // NumBuckets per block, turned into scatter offsets of blocks
+        std::vector<uint64_t> m_blockBits;       // AND and OR of keys of each block
+        uint32_t m_numSkippedPasses = 0;
+    };
+
+} // Neb namespace
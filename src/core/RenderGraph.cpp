@@ -0,0 +1,345 @@
+#include "RenderGraph.h"
+
+#include "../common/Assert.h"
+
+#include <algorithm>
+
+namespace Neb
+{
+
+    void RenderGraph::Reset()
+    {
+        m_resources.clear();
+        m_passes.clear();
+        m_accesses.clear();
+        m_resourceAccesses.clear();
+        m_order.clear();
+        m_passPositions.clear();
+        m_barriers.clear();
+        m_barrierOffsets.clear();
+        m_stats = RenderGraphStats();
+    }
+
+    uint32_t RenderGraph::AddResource(RenderGraphStates initialState, RenderGraphStates finalState, ERenderGraphResourceFlags flags)
+    {
+        m_resources.push_back(Resource{ .InitialState = initialState, .FinalState = finalState, .Flags = flags });
+        m_resourceAccesses.push_back(InvalidIndex);
+        return static_cast<uint32_t>(m_resources.size() - 1);
+    }
+
+    uint32_t RenderGraph::AddPass(std::span<const RenderGraphAccess> accesses, ERenderGraphPassFlags flags)
+    {
+        const uint32_t firstAccess = static_cast<uint32_t>(m_accesses.size());
+        for (const RenderGraphAccess& access : accesses)
+        {
+            NEB_ASSERT(access.Resource < m_resources.size(), "Render graph has no resource {}", access.Resource);
+            NEB_ASSERT(access.Type == eRenderGraphAccess_Read || !IsReadOnlyRenderGraphState(access.State), "Resources cannot be written in read-only states");
+
+            // Last access of the resource is of this pass already, both are merged
+            const uint32_t lastAccess = m_resourceAccesses[access.Resource];
+            if (lastAccess != InvalidIndex && lastAccess >= firstAccess)
+            {
+                RenderGraphAccess& merged = m_accesses[lastAccess];
+                merged.State |= access.State;
+                if (merged.Type != access.Type)
+                    merged.Type = eRenderGraphAccess_ReadWrite;
+
+                NEB_ASSERT(merged.Type == eRenderGraphAccess_Read || !IsReadOnlyRenderGraphState(merged.State), "Resources cannot be written in read-only states");
+                continue;
+            }
+
+            m_resourceAccesses[access.Resource] = static_cast<uint32_t>(m_accesses.size());
+            m_accesses.push_back(access);
+        }
+
+        m_passes.push_back(Pass{ .FirstAccess = firstAccess, .NumAccesses = static_cast<uint32_t>(m_accesses.size()) - firstAccess, .Flags = flags });
+        return static_cast<uint32_t>(m_passes.size() - 1);
+    }
+
+    std::span<const RenderGraphAccess> RenderGraph::GetAccesses(uint32_t pass) const
+    {
+        const Pass& p = m_passes[pass];
+        return std::span(m_accesses).subspan(p.FirstAccess, p.NumAccesses);
+    }
+
+    std::span<const RenderGraphBarrier> RenderGraph::GetBarriers(uint32_t position) const
+    {
+        NEB_ASSERT(position + 1 < m_barrierOffsets.size(), "Render graph has no barriers at {}, it was not compiled", position);
+        return std::span(m_barriers).subspan(m_barrierOffsets[position], m_barrierOffsets[position + 1] - m_barrierOffsets[position]);
+    }
+
+    void RenderGraph::Compile(const RenderGraphCompileOptions& options)
+    {
+        m_stats = RenderGraphStats{ .NumPasses = GetNumPasses() };
+
+        CullPasses();
+        OrderPasses(options.ReorderPasses);
+        BuildBarriers(options);
+    }
+
+    void RenderGraph::CullPasses()
+    {
+        // Walking passes backwards, a pass is needed when it writes a resource that a later needed pass reads (or that is external).
+        // Writes that overwrite a resource as a whole end the need of its previous contents
+        m_isResourceNeeded.resize(m_resources.size());
+        for (size_t i = 0; i < m_resources.size(); ++i)
+            m_isResourceNeeded[i] = (m_resources[i].Flags & eRenderGraphResourceFlag_External) != 0;
+
+        m_passPositions.assign(m_passes.size(), InvalidIndex);
+        for (uint32_t pass = GetNumPasses(); pass-- > 0;)
+        {
+            std::span<const RenderGraphAccess> accesses = GetAccesses(pass);
+            bool isNeeded = (m_passes[pass].Flags & eRenderGraphPassFlag_SideEffects) != 0;
+            for (const RenderGraphAccess& access : accesses)
+                isNeeded = isNeeded || (access.Type != eRenderGraphAccess_Read && m_isResourceNeeded[access.Resource]);
+
+            if (!isNeeded)
+            {
+                ++m_stats.NumCulledPasses;
+                continue;
+            }
+
+            m_passPositions[pass] = 0; // ordered later
+            for (const RenderGraphAccess& access : accesses)
+            {
+                if (access.Type == eRenderGraphAccess_Write)
+                    m_isResourceNeeded[access.Resource] = false;
+            }
+            for (const RenderGraphAccess& access : accesses)
+            {
+                if (access.Type != eRenderGraphAccess_Write)
+                    m_isResourceNeeded[access.Resource] = true;
+            }
+        }
+    }
+
+    void RenderGraph::OrderPasses(bool reorder)
+    {
+        // Level of a pass is one after the levels of passes it depends on: the last writer of what it reads, and for writes also
+        // every reader since then. Reads in states that are not read-only are ordered as writes, so that reads of the same level
+        // are always combined into a single state. Levels are stored one-based in the scratch, zero means no such pass
+        m_passLevels.resize(m_passes.size());
+        m_resourceWriterLevels.assign(m_resources.size(), 0);
+        m_resourceReaderLevels.assign(m_resources.size(), 0);
+        uint32_t sideEffectLevel = 0;
+        uint32_t numLevels = 0;
+        for (uint32_t pass = 0; pass < GetNumPasses(); ++pass)
+        {
+            if (m_passPositions[pass] == InvalidIndex)
+                continue;
+
+            const bool hasSideEffects = (m_passes[pass].Flags & eRenderGraphPassFlag_SideEffects) != 0;
+            uint32_t level = hasSideEffects ? sideEffectLevel : 0;
+            for (const RenderGraphAccess& access : GetAccesses(pass))
+            {
+                level = std::max(level, m_resourceWriterLevels[access.Resource]);
+                if (access.Type != eRenderGraphAccess_Read || !IsReadOnlyRenderGraphState(access.State))
+                    level = std::max(level, m_resourceReaderLevels[access.Resource]);
+            }
+
+            for (const RenderGraphAccess& access : GetAccesses(pass))
+            {
+                if (access.Type == eRenderGraphAccess_Read && IsReadOnlyRenderGraphState(access.State))
+                {
+                    m_resourceReaderLevels[access.Resource] = std::max(m_resourceReaderLevels[access.Resource], level + 1);
+                }
+                else
+                {
+                    m_resourceWriterLevels[access.Resource] = level + 1;
+                    m_resourceReaderLevels[access.Resource] = 0;
+                }
+            }
+
+            if (hasSideEffects)
+                sideEffectLevel = level + 1;
+
+            m_passLevels[pass] = level;
+            numLevels = std::max(numLevels, level + 1);
+        }
+        m_stats.NumLevels = numLevels;
+
+        m_order.clear();
+        m_barrierSlots.clear();
+        if (!reorder)
+        {
+            for (uint32_t pass = 0; pass < GetNumPasses(); ++pass)
+            {
+                if (m_passPositions[pass] == InvalidIndex)
+                    continue;
+
+                const uint32_t position = static_cast<uint32_t>(m_order.size());
+                m_barrierSlots.push_back(position);
+                m_order.push_back(pass);
+            }
+        }
+        else
+        {
+            // Counting sort by level keeps the order passes were added in within a level
+            m_levelOffsets.assign(numLevels + 1, 0);
+            for (uint32_t pass = 0; pass < GetNumPasses(); ++pass)
+            {
+                if (m_passPositions[pass] != InvalidIndex)
+                    ++m_levelOffsets[m_passLevels[pass] + 1];
+            }
+            for (uint32_t level = 0; level < numLevels; ++level)
+                m_levelOffsets[level + 1] += m_levelOffsets[level];
+
+            m_order.resize(m_levelOffsets[numLevels]);
+            m_barrierSlots.resize(m_order.size());
+            for (uint32_t pass = 0; pass < GetNumPasses(); ++pass)
+            {
+                if (m_passPositions[pass] != InvalidIndex)
+                    m_order[m_levelOffsets[m_passLevels[pass]]++] = pass;
+            }
+
+            // Offsets were advanced to the ends of their levels. Barriers of a level are issued before its first pass
+            for (uint32_t level = 0; level < numLevels; ++level)
+            {
+                const uint32_t first = (level == 0) ? 0 : m_levelOffsets[level - 1];
+                for (uint32_t position = first; position < m_levelOffsets[level]; ++position)
+                    m_barrierSlots[position] = first;
+            }
+        }
+
+        for (uint32_t position = 0; position < GetNumExecutedPasses(); ++position)
+            m_passPositions[m_order[position]] = position;
+    }
+
+    void RenderGraph::AddTransition(uint32_t resource, RenderGraphStates stateBefore, RenderGraphStates stateAfter, uint32_t position)
+    {
+        const RenderGraphBarrier barrier = RenderGraphBarrier{ .Resource = resource, .StateBefore = stateBefore, .StateAfter = stateAfter };
+        const uint32_t slot = (position < GetNumExecutedPasses()) ? m_barrierSlots[position] : position;
+        m_pendingBarriers.push_back(PendingBarrier{ .Position = slot, .Barrier = barrier });
+        ++m_stats.NumTransitions;
+    }
+
+    void RenderGraph::BuildBarriers(const RenderGraphCompileOptions& options)
+    {
+        const uint32_t numExecuted = GetNumExecutedPasses();
+
+        // Consecutive reads of a resource in read-only states are combined into the state of the first one of them,
+        // walking the order backwards with the next access of every resource
+        m_readStates.resize(m_accesses.size());
+        std::ranges::fill(m_resourceAccesses, InvalidIndex);
+        for (uint32_t position = numExecuted; position-- > 0;)
+        {
+            const Pass& pass = m_passes[m_order[position]];
+            for (uint32_t i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; ++i)
+            {
+                const RenderGraphAccess& access = m_accesses[i];
+                const uint32_t next = m_resourceAccesses[access.Resource];
+
+                RenderGraphStates states = access.State;
+                if (access.Type == eRenderGraphAccess_Read && IsReadOnlyRenderGraphState(access.State) && next != InvalidIndex
+                    && m_accesses[next].Type == eRenderGraphAccess_Read && IsReadOnlyRenderGraphState(m_accesses[next].State))
+                {
+                    states |= m_readStates[next];
+                }
+
+                m_readStates[i] = states;
+                m_resourceAccesses[access.Resource] = i;
+            }
+        }
+
+        const size_t numResources = m_resources.size();
+        m_resourceStates.resize(numResources);
+        for (size_t i = 0; i < numResources; ++i)
+            m_resourceStates[i] = m_resources[i].InitialState;
+        m_resourcePositions.assign(numResources, InvalidIndex);
+        m_resourceWasWritten.assign(numResources, false);
+        m_resourceIsPromoted.assign(numResources, false);
+
+        m_pendingBarriers.clear();
+        for (uint32_t position = 0; position < numExecuted; ++position)
+        {
+            const Pass& pass = m_passes[m_order[position]];
+            for (uint32_t i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; ++i)
+            {
+                const RenderGraphAccess& access = m_accesses[i];
+                const uint32_t resource = access.Resource;
+                const bool isWrite = access.Type != eRenderGraphAccess_Read;
+                const bool isBuffer = (m_resources[resource].Flags & eRenderGraphResourceFlag_Buffer) != 0;
+                RenderGraphStates& state = m_resourceStates[resource];
+
+                // Buffers are promoted from Common to whatever state they are used in, promoted read-only states are combined
+                const bool isPromoted = m_resourceIsPromoted[resource] && IsReadOnlyRenderGraphState(state) && IsReadOnlyRenderGraphState(access.State);
+                if (isBuffer && (state == eRenderGraphState_Common || isPromoted))
+                {
+                    if (state != access.State)
+                        ++m_stats.NumSkippedTransitions;
+
+                    state = (state == eRenderGraphState_Common) ? access.State : (state | access.State);
+                    m_resourceIsPromoted[resource] = true;
+                }
+                else if (state == access.State || (IsReadOnlyRenderGraphState(access.State) && IsReadOnlyRenderGraphState(state) && (state & access.State) == access.State))
+                {
+                    if (state != access.State)
+                        ++m_stats.NumSkippedTransitions;
+
+                    // Unordered accesses of the same state still wait for writes before them, as well as writes wait for reads
+                    const bool wasAccessed = m_resourcePositions[resource] != InvalidIndex;
+                    if (state == eRenderGraphState_UnorderedAccess && wasAccessed && (isWrite || m_resourceWasWritten[resource]))
+                    {
+                        const RenderGraphBarrier barrier = RenderGraphBarrier{ .Resource = resource, .Type = eRenderGraphBarrier_UnorderedAccess };
+                        m_pendingBarriers.push_back(PendingBarrier{ .Position = m_barrierSlots[position], .Barrier = barrier });
+                        ++m_stats.NumUnorderedAccessBarriers;
+                    }
+                }
+                else
+                {
+                    AddTransition(resource, state, m_readStates[i], position);
+                    state = m_readStates[i];
+                    m_resourceIsPromoted[resource] = false;
+                }
+
+                m_resourcePositions[resource] = position;
+                m_resourceWasWritten[resource] = isWrite;
+            }
+
+            if (!options.PassesAreSubmissions)
+                continue;
+
+            for (uint32_t i = pass.FirstAccess; i < pass.FirstAccess + pass.NumAccesses; ++i)
+            {
+                const uint32_t resource = m_accesses[i].Resource;
+                if ((m_resources[resource].Flags & eRenderGraphResourceFlag_Buffer) != 0)
+                {
+                    m_resourceStates[resource] = eRenderGraphState_Common;
+                    m_resourceIsPromoted[resource] = false;
+                    m_resourceWasWritten[resource] = false;
+                }
+            }
+        }
+
+        // The graph ends a submission as well, buffers decay to Common after it on their own
+        for (uint32_t resource = 0; resource < numResources; ++resource)
+        {
+            const RenderGraphStates finalState = m_resources[resource].FinalState;
+            const bool isBuffer = (m_resources[resource].Flags & eRenderGraphResourceFlag_Buffer) != 0;
+            if (m_resourceStates[resource] == finalState || (isBuffer && finalState == eRenderGraphState_Common))
+                continue;
+
+            AddTransition(resource, m_resourceStates[resource], finalState, numExecuted);
+        }
+
+        // Barriers are grouped by position, keeping the order they were added in
+        m_barrierOffsets.assign(numExecuted + 2, 0);
+        for (const PendingBarrier& pending : m_pendingBarriers)
+            ++m_barrierOffsets[pending.Position + 1];
+        for (uint32_t position = 0; position <= numExecuted; ++position)
+        {
+            m_stats.NumBarrierBatches += (m_barrierOffsets[position + 1] > 0) ? 1 : 0;
+            m_barrierOffsets[position + 1] += m_barrierOffsets[position];
+        }
+
+        m_barriers.resize(m_pendingBarriers.size());
+        for (const PendingBarrier& pending : m_pendingBarriers)
+            m_barriers[m_barrierOffsets[pending.Position]++] = pending.Barrier;
+
+        // Scatter advanced offsets to the ends of their positions, shift them back
+        for (uint32_t position = numExecuted + 1; position > 0; --position)
+            m_barrierOffsets[position] = m_barrierOffsets[position - 1];
+        m_barrierOffsets[0] = 0;
+    }
+
+} // Neb namespace
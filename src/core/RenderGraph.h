@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    // Resource states of the render graph, values are the same as of D3D12_RESOURCE_STATES, so that barriers are passed to D3D12 as they are.
+    // The graph itself does not depend on D3D12 though and is compiled on the CPU only
+    enum ERenderGraphState : uint32_t
+    {
+        eRenderGraphState_Common = 0,
+        eRenderGraphState_VertexAndConstantBuffer = 0x1,
+        eRenderGraphState_IndexBuffer = 0x2,
+        eRenderGraphState_RenderTarget = 0x4,
+        eRenderGraphState_UnorderedAccess = 0x8,
+        eRenderGraphState_DepthWrite = 0x10,
+        eRenderGraphState_DepthRead = 0x20,
+        eRenderGraphState_NonPixelShaderResource = 0x40,
+        eRenderGraphState_PixelShaderResource = 0x80,
+        eRenderGraphState_IndirectArgument = 0x200,
+        eRenderGraphState_CopyDest = 0x400,
+        eRenderGraphState_CopySource = 0x800,
+    };
+    using RenderGraphStates = uint32_t; // combination of ERenderGraphState
+
+    static constexpr RenderGraphStates RenderGraphReadOnlyStates = eRenderGraphState_VertexAndConstantBuffer
+        | eRenderGraphState_IndexBuffer
+        | eRenderGraphState_DepthRead
+        | eRenderGraphState_NonPixelShaderResource
+        | eRenderGraphState_PixelShaderResource
+        | eRenderGraphState_IndirectArgument
+        | eRenderGraphState_CopySource;
+
+    // Read-only states can be combined, a resource in a combination of them is read by every state of it without barriers in between.
+    // Common is not a read-only state, passes that access a resource in Common transition it on their own
+    constexpr bool IsReadOnlyRenderGraphState(RenderGraphStates states)
+    {
+        return states != eRenderGraphState_Common && (states & ~RenderGraphReadOnlyStates) == 0;
+    }
+
+    enum ERenderGraphResourceFlags : uint32_t
+    {
+        eRenderGraphResourceFlag_None = 0,
+        eRenderGraphResourceFlag_External = 1 << 0, // contents are used after the graph, thus its last writer is never culled
+        eRenderGraphResourceFlag_Buffer = 1 << 1,   // promoted implicitly from Common and decays back to it, see RenderGraphCompileOptions
+    };
+
+    enum ERenderGraphPassFlags : uint32_t
+    {
+        eRenderGraphPassFlag_None = 0,
+        eRenderGraphPassFlag_SideEffects = 1 << 0, // touches something the graph does not track, never culled and never reordered against other such passes
+    };
+
+    enum ERenderGraphAccessType : uint8_t
+    {
+        eRenderGraphAccess_Read = 0,
+        eRenderGraphAccess_Write,     // previous contents are overwritten as a whole, so passes that only wrote them before may be culled
+        eRenderGraphAccess_ReadWrite, // e.g. accumulation into an unordered access view
+    };
+
+    struct RenderGraphAccess
+    {
+        uint32_t Resource = 0;
+        RenderGraphStates State = eRenderGraphState_Common;
+        ERenderGraphAccessType Type = eRenderGraphAccess_Read;
+    };
+
+    enum ERenderGraphBarrierType : uint8_t
+    {
+        eRenderGraphBarrier_Transition = 0,
+        eRenderGraphBarrier_UnorderedAccess,
+    };
+
+    struct RenderGraphBarrier
+    {
+        uint32_t Resource = 0;
+        RenderGraphStates StateBefore = eRenderGraphState_Common;
+        RenderGraphStates StateAfter = eRenderGraphState_Common;
+        ERenderGraphBarrierType Type = eRenderGraphBarrier_Transition;
+
+        bool operator==(const RenderGraphBarrier&) const = default;
+    };
+
+    struct RenderGraphCompileOptions
+    {
+        // Passes are ordered by their dependency levels instead of the order they were added in, passes of the same level are independent
+        // of each other. Barriers of a level are then issued together, before the first pass of it
+        bool ReorderPasses = false;
+
+        // Every pass is executed by a command list of its own, buffers decay to Common after each of them
+        bool PassesAreSubmissions = false;
+    };
+
+    struct RenderGraphStats
+    {
+        uint32_t NumPasses = 0;
+        uint32_t NumCulledPasses = 0;
+        uint32_t NumLevels = 0;            // of dependencies, equals the amount of executed passes if nothing could run side by side
+        uint32_t NumTransitions = 0;
+        uint32_t NumUnorderedAccessBarriers = 0;
+        uint32_t NumBarrierBatches = 0;    // ResourceBarrier calls
+        uint32_t NumSkippedTransitions = 0; // accesses in a different state than the one before, that still needed no barrier (read states combined or promoted)
+    };
+
+    // Passes declare the resources they read and write together with the states they need them in. Compilation culls passes whose writes
+    // are never read (unless they have side effects or write an external resource), puts the rest in an order of execution and derives
+    // barriers before every pass: consecutive reads in different states are combined into a single transition, states that already match
+    // need none and unordered accesses after writes get UAV barriers.
+    // Final barriers bring resources back to the states the graph was told to leave them in.
+    // Handles of resources and passes are indices in the order they were added. Memory is kept between resets, so that the graph
+    // may be rebuilt and compiled every frame
+    class RenderGraph
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+        void Reset();
+
+        uint32_t AddResource(RenderGraphStates initialState, RenderGraphStates finalState, ERenderGraphResourceFlags flags = eRenderGraphResourceFlag_None);
+
+        // Accesses of the same resource are merged, states are combined and the access becomes ReadWrite if any of them writes
+        uint32_t AddPass(std::span<const RenderGraphAccess> accesses, ERenderGraphPassFlags flags = eRenderGraphPassFlag_None);
+
+        void Compile(const RenderGraphCompileOptions& options);
+
+        // Of the last compilation
+        std::span<const uint32_t> GetExecutionOrder() const { return m_order; }
+        uint32_t GetNumExecutedPasses() const { return static_cast<uint32_t>(m_order.size()); }
+        uint32_t GetPassPosition(uint32_t pass) const { return m_passPositions[pass]; } // in the order of execution, InvalidIndex if culled
+        bool IsPassCulled(uint32_t pass) const { return m_passPositions[pass] == InvalidIndex; }
+
+        // Barriers to issue before the pass at the given position of execution, at GetNumExecutedPasses() are final barriers after the last pass
+        std::span<const RenderGraphBarrier> GetBarriers(uint32_t position) const;
+
+        const RenderGraphStats& GetStats() const { return m_stats; }
+
+        uint32_t GetNumResources() const { return static_cast<uint32_t>(m_resources.size()); }
+        uint32_t GetNumPasses() const { return static_cast<uint32_t>(m_passes.size()); }
+        std::span<const RenderGraphAccess> GetAccesses(uint32_t pass) const;
+
+    private:
+        struct Resource
+        {
+            RenderGraphStates InitialState;
+            RenderGraphStates FinalState;
+            ERenderGraphResourceFlags Flags;
+        };
+
+        struct Pass
+        {
+            uint32_t FirstAccess;
+            uint32_t NumAccesses;
+            ERenderGraphPassFlags Flags;
+        };
+
+        void CullPasses();
+        void OrderPasses(bool reorder);
+        void BuildBarriers(const RenderGraphCompileOptions& options);
+        void AddTransition(uint32_t resource, RenderGraphStates stateBefore, RenderGraphStates stateAfter, uint32_t position);
+
+        std::vector<Resource> m_resources;
+        std::vector<Pass> m_passes;
+        std::vector<RenderGraphAccess> m_accesses;
+
+        std::vector<uint32_t> m_order;
+        std::vector<uint32_t> m_passPositions;
+        std::vector<RenderGraphBarrier> m_barriers;    // grouped by position
+        std::vector<uint32_t> m_barrierOffsets;         // GetNumExecutedPasses() + 2, first barrier of every position
+        RenderGraphStats m_stats;
+
+        // Scratch of compilation, kept between frames
+        struct PendingBarrier
+        {
+            uint32_t Position;
+            RenderGraphBarrier Barrier;
+        };
+        std::vector<PendingBarrier> m_pendingBarriers;
+        std::vector<uint8_t> m_isResourceNeeded;
+        std::vector<uint32_t> m_passLevels;
+        std::vector<uint32_t> m_levelOffsets;
+        std::vector<uint32_t> m_resourceWriterLevels;
+        std::vector<uint32_t> m_resourceReaderLevels;
+        std::vector<uint32_t> m_barrierSlots;        // per position, the position its barriers are issued at (first of its level if reordered)
+        std::vector<RenderGraphStates> m_readStates; // per access, read states combined up to the next write of its resource
+        std::vector<uint32_t> m_resourceAccesses;    // last access of a resource while passes are added, next one while barriers are built
+        std::vector<RenderGraphStates> m_resourceStates;
+        std::vector<uint32_t> m_resourcePositions;   // last position that accessed a resource, InvalidIndex before the first
+        std::vector<uint8_t> m_resourceWasWritten;   // whether the last access wrote
+        std::vector<uint8_t> m_resourceIsPromoted;
+    };
+
+} // Neb namespace
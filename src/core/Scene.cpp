@@ -7,6 +7,7 @@
 #include "../input/InputManager.h"
 
 #include "../nri/imgui/UiContext.h"
+#include "../util/ThreadPool.h"
 
 namespace Neb
 {
@@ -81,4 +82,27 @@ namespace Neb
         }
     }
 
+    bool Scene::UpdateTransforms()
+    {
+        if (!Graph.IsDirty())
+            return false;
+
+        // Falls back to a serial update on small graphs, as dirty subtrees then fit into a single task
+        Graph.UpdateWorldMatricesParallel(ThreadPool::Get());
+
+        // Boxes of all 8 corners, so SceneBox stays conservative under rotation
+        SceneBox = AABB();
+        for (nri::StaticMeshInstance& instance : StaticMeshInstances)
+        {
+            const nri::StaticMesh& mesh = StaticMeshes[instance.MeshIndex];
+            instance.InstanceToWorld = Graph.GetWorldMatrix(instance.NodeIndex);
+            instance.WorldBox = TransformAABBFast(mesh.LocalBox, instance.InstanceToWorld);
+            instance.WorldSphere = TransformSphere(mesh.LocalSphere, instance.InstanceToWorld);
+            ExtendAABB(SceneBox, instance.WorldBox);
+        }
+
+        ++TransformVersion;
+        return true;
+    }
+
 } // Neb namespace
\ No newline at end of file
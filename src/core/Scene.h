@@ -3,6 +3,7 @@
 #include <vector>
 #include "../nri/StaticMesh.h"
 #include "InspectCamera.h"
+#include "SceneGraph.h"
 
 #include "input/Mouse.h"
 #include "input/Keyboard.h"
@@ -21,7 +22,17 @@ namespace Neb
 
         void OnKeyboardInteract(const KeyboardEvent_KeyInteraction& event);
 
+        // Propagates dirty transforms of the graph into world matrices and bounds of instances and recomputes SceneBox.
+        // Returns false if nothing has changed
+        bool UpdateTransforms();
+
+        // Unique geometry of the scene and its placements. Many instances may reference the same mesh
         std::vector<nri::StaticMesh> StaticMeshes;
+        std::vector<nri::StaticMeshInstance> StaticMeshInstances;
+
+        // Transform hierarchy (glTF nodes) of the scene, instances are attached to its nodes
+        SceneGraph Graph;
+        uint32_t TransformVersion = 0; // incremented each time UpdateTransforms() changes anything, lets renderers know when to refresh bounds
 
         // TODO: Camera related stuff. Will be moved/removed
         InspectCamera Camera;
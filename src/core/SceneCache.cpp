@@ -0,0 +1,468 @@
+#include "SceneCache.h"
+
+#include "../common/Assert.h"
+#include "../common/Log.h"
+#include "../util/Hash.h"
+#include "../util/Memory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Neb
+{
+
+    namespace
+    {
+        uint64_t HashMappedFile(const std::filesystem::path& filepath, uint64_t seed)
+        {
+            MappedFile file;
+            if (!file.Open(filepath))
+                return seed;
+
+            return HashBytes64(file.GetBytes(), seed);
+        }
+    } // anonymous namespace
+
+    uint64_t HashSceneCacheSource(const std::filesystem::path& filepath, std::span<const std::filesystem::path> sourceFiles, uint64_t seed)
+    {
+        uint64_t hash = HashMappedFile(filepath, HashBytes64(&seed, sizeof(seed), SceneCacheVersion));
+
+        // Paths go into the hash as well, so that renamed references are not mistaken for the same source
+        for (const std::filesystem::path& sourceFile : sourceFiles)
+        {
+            const std::u8string name = sourceFile.generic_u8string();
+            hash = HashBytes64(name.data(), name.size(), hash);
+            hash = HashMappedFile(filepath.parent_path() / sourceFile, hash);
+        }
+        return hash;
+    }
+
+    std::filesystem::path GetSceneCachePath(const std::filesystem::path& filepath)
+    {
+        std::filesystem::path cachePath = filepath;
+        cachePath.replace_extension(".nebscene");
+        return cachePath;
+    }
+
+    void SceneCacheWriter::BeginScene()
+    {
+        m_scenes.push_back(SceneCacheScene{
+            .FirstMesh = static_cast<uint32_t>(m_meshes.size()),
+            .FirstNode = static_cast<uint32_t>(m_nodes.size()),
+            .FirstInstance = static_cast<uint32_t>(m_instances.size()),
+        });
+    }
+
+    void SceneCacheWriter::EndScene(const float boxMin[3], const float boxMax[3])
+    {
+        NEB_ASSERT(!m_scenes.empty(), "BeginScene() was not called");
+        SceneCacheScene& scene = m_scenes.back();
+        scene.NumMeshes = static_cast<uint32_t>(m_meshes.size()) - scene.FirstMesh;
+        scene.NumNodes = static_cast<uint32_t>(m_nodes.size()) - scene.FirstNode;
+        scene.NumInstances = static_cast<uint32_t>(m_instances.size()) - scene.FirstInstance;
+        std::memcpy(scene.BoxMin, boxMin, sizeof(scene.BoxMin));
+        std::memcpy(scene.BoxMax, boxMax, sizeof(scene.BoxMax));
+    }
+
+    void SceneCacheWriter::BeginMesh()
+    {
+        NEB_ASSERT(!m_scenes.empty(), "Meshes should always belong to a scene");
+        SceneCacheMesh& mesh = m_meshes.emplace_back();
+        mesh.FirstSubmesh = static_cast<uint32_t>(m_submeshes.size());
+    }
+
+    void SceneCacheWriter::AddNode(const SceneCacheNode& node)
+    {
+        NEB_ASSERT(!m_scenes.empty(), "Nodes should always belong to a scene");
+        NEB_ASSERT(node.Parent == SceneCacheInvalidIndex || m_scenes.back().FirstNode + node.Parent < m_nodes.size(), "Node should be added after its parent {}", node.Parent);
+        m_nodes.push_back(node);
+    }
+
+    void SceneCacheWriter::AddInstance(uint32_t nodeIndex, uint32_t meshIndex)
+    {
+        NEB_ASSERT(!m_scenes.empty(), "Instances should always belong to a scene");
+        NEB_ASSERT(m_scenes.back().FirstMesh + meshIndex < m_meshes.size(), "Instance references mesh {} that was not added", meshIndex);
+        NEB_ASSERT(m_scenes.back().FirstNode + nodeIndex < m_nodes.size(), "Instance references node {} that was not added", nodeIndex);
+
+        m_instances.push_back(SceneCacheInstance{ .NodeIndex = nodeIndex, .MeshIndex = meshIndex });
+    }
+
+    void SceneCacheWriter::AddSubmesh(const SceneCacheSubmeshSource& src)
+    {
+        NEB_ASSERT(!m_meshes.empty(), "Submeshes should always belong to a mesh");
+
+        SceneCacheSubmesh& submesh = m_submeshes.emplace_back();
+        submesh.NumVertices = src.NumVertices;
+        submesh.NumIndices = src.NumIndices;
+        submesh.IndicesStride = src.IndicesStride;
+        submesh.MaterialIndex = src.MaterialIndex;
+
+        NEB_ASSERT(src.NumLods <= SceneCacheMaxLods, "Too many LODs ({})", src.NumLods);
+        submesh.NumLods = src.NumLods;
+        std::copy_n(src.Lods, src.NumLods, submesh.Lods);
+
+        NEB_ASSERT(src.VertexFormat < SceneCacheNumVertexFormats, "Unknown vertex format {}", src.VertexFormat);
+        submesh.VertexFormat = src.VertexFormat;
+        std::copy_n(src.PositionScale, 3, submesh.PositionScale);
+        std::copy_n(src.PositionBias, 3, submesh.PositionBias);
+
+        std::copy_n(src.BoxMin, 3, submesh.BoxMin);
+        std::copy_n(src.BoxMax, 3, submesh.BoxMax);
+        std::copy_n(src.SphereCenter, 3, submesh.SphereCenter);
+        submesh.SphereRadius = src.SphereRadius;
+
+        for (uint32_t i = 0; i < SceneCacheNumAttributes; ++i)
+        {
+            const uint32_t elementSize = src.AttributeElementSizes[i];
+            if (!src.Attributes[i] || elementSize == 0)
+                continue;
+
+            submesh.AttributeStrides[i] = elementSize;
+            if (src.AttributeStrides[i] == elementSize)
+            {
+                // Already tight, just a single copy
+                submesh.AttributeOffsets[i] = AppendGeometry(src.Attributes[i], size_t(elementSize) * src.NumVertices);
+                continue;
+            }
+
+            // Interleaved, repack into a tight stream
+            submesh.AttributeOffsets[i] = AppendGeometry(nullptr, size_t(elementSize) * src.NumVertices);
+            std::byte* dst = m_geometry.data() + submesh.AttributeOffsets[i];
+            for (uint32_t v = 0; v < src.NumVertices; ++v)
+                std::memcpy(dst + size_t(v) * elementSize, src.Attributes[i] + size_t(v) * src.AttributeStrides[i], elementSize);
+        }
+
+        if (src.Indices && src.NumIndices > 0)
+            submesh.IndicesOffset = AppendGeometry(src.Indices, size_t(src.IndicesStride) * src.NumIndices);
+
+        m_meshes.back().NumSubmeshes = static_cast<uint32_t>(m_submeshes.size()) - m_meshes.back().FirstSubmesh;
+    }
+
+    uint32_t SceneCacheWriter::AddMaterial(const SceneCacheMaterial& material)
+    {
+        m_materials.push_back(material);
+        return static_cast<uint32_t>(m_materials.size() - 1);
+    }
+
+    uint32_t SceneCacheWriter::AddTexture(uint32_t format, uint64_t contentHash, std::span<const SceneCacheSubresourceSource> subresources)
+    {
+        SceneCacheTexture& texture = m_textures.emplace_back();
+        texture.ContentHash = contentHash;
+        texture.Format = format;
+        texture.MipLevels = static_cast<uint32_t>(subresources.size());
+        texture.FirstSubresource = static_cast<uint32_t>(m_subresources.size());
+
+        if (!subresources.empty())
+        {
+            texture.Width = subresources.front().Width;
+            texture.Height = subresources.front().Height;
+        }
+
+        for (const SceneCacheSubresourceSource& src : subresources)
+        {
+            // Lay out the texels exactly like GetCopyableFootprints() would for the upload buffer
+            SceneCacheSubresource& subresource = m_subresources.emplace_back();
+            subresource.Offset = AlignUp(static_cast<uint64_t>(m_texels.size()), SceneCacheTexelPlacementAlignment);
+            subresource.Width = src.Width;
+            subresource.Height = src.Height;
+            subresource.RowPitch = static_cast<uint32_t>(AlignUp(static_cast<uint64_t>(src.NumBytesInRow), SceneCacheTexelPitchAlignment));
+            subresource.NumRows = src.NumRows;
+
+            m_texels.resize(subresource.Offset + uint64_t(subresource.RowPitch) * src.NumRows);
+            std::byte* dst = m_texels.data() + subresource.Offset;
+            for (uint32_t row = 0; row < src.NumRows; ++row)
+                std::memcpy(dst + size_t(row) * subresource.RowPitch, src.Data + size_t(row) * src.NumBytesInRow, src.NumBytesInRow);
+        }
+
+        return static_cast<uint32_t>(m_textures.size() - 1);
+    }
+
+    uint64_t SceneCacheWriter::AppendGeometry(const std::byte* data, size_t numBytes)
+    {
+        const uint64_t offset = AlignUp(static_cast<uint64_t>(m_geometry.size()), SceneCacheGeometryAlignment);
+        m_geometry.resize(offset + numBytes);
+        if (data)
+            std::memcpy(m_geometry.data() + offset, data, numBytes);
+
+        return offset;
+    }
+
+    bool SceneCacheWriter::WriteToFile(const std::filesystem::path& filepath, uint64_t sourceHash, std::span<const std::filesystem::path> sourceFiles) const
+    {
+        std::vector<char8_t> sourceFileNames;
+        for (const std::filesystem::path& sourceFile : sourceFiles)
+        {
+            const std::u8string name = sourceFile.generic_u8string();
+            sourceFileNames.insert(sourceFileNames.end(), name.begin(), name.end());
+            sourceFileNames.push_back(u8'\0');
+        }
+
+        SceneCacheHeader header = {};
+        header.SourceHash = sourceHash;
+        header.NumScenes = static_cast<uint32_t>(m_scenes.size());
+        header.NumMeshes = static_cast<uint32_t>(m_meshes.size());
+        header.NumNodes = static_cast<uint32_t>(m_nodes.size());
+        header.NumInstances = static_cast<uint32_t>(m_instances.size());
+        header.NumSubmeshes = static_cast<uint32_t>(m_submeshes.size());
+        header.NumMaterials = static_cast<uint32_t>(m_materials.size());
+        header.NumTextures = static_cast<uint32_t>(m_textures.size());
+        header.NumSubresources = static_cast<uint32_t>(m_subresources.size());
+
+        uint64_t offset = sizeof(SceneCacheHeader);
+        auto placeTable = [&offset](uint64_t numBytes) -> uint64_t
+        {
+            const uint64_t tableOffset = AlignUp(offset, SceneCacheGeometryAlignment);
+            offset = tableOffset + numBytes;
+            return tableOffset;
+        };
+
+        header.ScenesOffset = placeTable(m_scenes.size() * sizeof(SceneCacheScene));
+        header.MeshesOffset = placeTable(m_meshes.size() * sizeof(SceneCacheMesh));
+        header.NodesOffset = placeTable(m_nodes.size() * sizeof(SceneCacheNode));
+        header.InstancesOffset = placeTable(m_instances.size() * sizeof(SceneCacheInstance));
+        header.SubmeshesOffset = placeTable(m_submeshes.size() * sizeof(SceneCacheSubmesh));
+        header.MaterialsOffset = placeTable(m_materials.size() * sizeof(SceneCacheMaterial));
+        header.TexturesOffset = placeTable(m_textures.size() * sizeof(SceneCacheTexture));
+        header.SubresourcesOffset = placeTable(m_subresources.size() * sizeof(SceneCacheSubresource));
+        header.SourceFilesOffset = placeTable(sourceFileNames.size());
+        header.SourceFilesSize = sourceFileNames.size();
+
+        // Keep texel section placement-aligned in the file as well, so that subresource offsets stay aligned when mapped
+        header.GeometryOffset = AlignUp(offset, SceneCacheTexelPlacementAlignment);
+        header.GeometrySize = m_geometry.size();
+        header.TexelsOffset = AlignUp(header.GeometryOffset + header.GeometrySize, SceneCacheTexelPlacementAlignment);
+        header.TexelsSize = m_texels.size();
+
+        const std::filesystem::path tmpPath = std::filesystem::path(filepath).concat(".tmp");
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                NEB_LOG_WARN("SceneCacheWriter -> Failed to open '{}' for writing", tmpPath.string());
+                return false;
+            }
+
+            uint64_t written = 0;
+            auto write = [&out, &written](uint64_t at, const void* data, uint64_t numBytes)
+            {
+                static constexpr char Zeros[SceneCacheTexelPlacementAlignment] = {};
+                NEB_ASSERT(at >= written && at - written <= sizeof(Zeros), "Unexpected padding in scene cache");
+                out.write(Zeros, static_cast<std::streamsize>(at - written));
+                out.write(static_cast<const char*>(data), static_cast<std::streamsize>(numBytes));
+                written = at + numBytes;
+            };
+
+            write(0, &header, sizeof(header));
+            write(header.ScenesOffset, m_scenes.data(), m_scenes.size() * sizeof(SceneCacheScene));
+            write(header.MeshesOffset, m_meshes.data(), m_meshes.size() * sizeof(SceneCacheMesh));
+            write(header.NodesOffset, m_nodes.data(), m_nodes.size() * sizeof(SceneCacheNode));
+            write(header.InstancesOffset, m_instances.data(), m_instances.size() * sizeof(SceneCacheInstance));
+            write(header.SubmeshesOffset, m_submeshes.data(), m_submeshes.size() * sizeof(SceneCacheSubmesh));
+            write(header.MaterialsOffset, m_materials.data(), m_materials.size() * sizeof(SceneCacheMaterial));
+            write(header.TexturesOffset, m_textures.data(), m_textures.size() * sizeof(SceneCacheTexture));
+            write(header.SubresourcesOffset, m_subresources.data(), m_subresources.size() * sizeof(SceneCacheSubresource));
+            write(header.SourceFilesOffset, sourceFileNames.data(), sourceFileNames.size());
+            write(header.GeometryOffset, m_geometry.data(), m_geometry.size());
+            write(header.TexelsOffset, m_texels.data(), m_texels.size());
+
+            if (!out)
+            {
+                NEB_LOG_WARN("SceneCacheWriter -> Failed to write '{}'", tmpPath.string());
+                return false;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tmpPath, filepath, error);
+        if (error)
+        {
+            NEB_LOG_WARN("SceneCacheWriter -> Failed to move '{}' to '{}' ({})", tmpPath.string(), filepath.string(), error.message());
+            std::filesystem::remove(tmpPath, error);
+            return false;
+        }
+        return true;
+    }
+
+    bool SceneCacheReader::Open(const std::filesystem::path& filepath, const std::filesystem::path& sourcePath, uint64_t seed)
+    {
+        Close();
+        if (!m_file.Open(filepath))
+            return false;
+
+        if (m_file.GetSize() < sizeof(SceneCacheHeader))
+        {
+            NEB_LOG_WARN("SceneCacheReader -> '{}' is too small to be a scene cache", filepath.string());
+            Close();
+            return false;
+        }
+
+        m_header = reinterpret_cast<const SceneCacheHeader*>(m_file.GetData());
+        if (m_header->Magic != SceneCacheMagic || m_header->Version != SceneCacheVersion)
+        {
+            NEB_LOG_INFO("SceneCacheReader -> '{}' is of another version ({}, expected {}), it will be rebuilt", filepath.string(), m_header->Version, SceneCacheVersion);
+            Close();
+            return false;
+        }
+
+        // Source files are read from the cache, thus it is validated before they are hashed
+        if (!Validate())
+        {
+            NEB_LOG_WARN("SceneCacheReader -> '{}' is corrupted", filepath.string());
+            Close();
+            return false;
+        }
+
+        const std::vector<std::filesystem::path> sourceFiles = GetSourceFiles();
+        if (m_header->SourceHash != HashSceneCacheSource(sourcePath, sourceFiles, seed))
+        {
+            NEB_LOG_INFO("SceneCacheReader -> '{}' is stale, source has changed since it was baked", filepath.string());
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void SceneCacheReader::Close()
+    {
+        m_header = nullptr;
+        m_file.Close();
+    }
+
+    std::vector<std::filesystem::path> SceneCacheReader::GetSourceFiles() const
+    {
+        const char8_t* names = reinterpret_cast<const char8_t*>(m_file.GetData() + m_header->SourceFilesOffset);
+        const char8_t* namesEnd = names + m_header->SourceFilesSize;
+
+        std::vector<std::filesystem::path> sourceFiles;
+        while (names != namesEnd)
+        {
+            const char8_t* nameEnd = std::find(names, namesEnd, u8'\0');
+            sourceFiles.emplace_back(std::u8string(names, nameEnd));
+            names = nameEnd + 1;
+        }
+        return sourceFiles;
+    }
+
+    bool SceneCacheReader::Validate() const
+    {
+        const uint64_t fileSize = m_file.GetSize();
+        auto isInFile = [fileSize](uint64_t offset, uint64_t numBytes)
+        {
+            return offset <= fileSize && numBytes <= fileSize - offset;
+        };
+
+        const SceneCacheHeader& header = *m_header;
+        if (!isInFile(header.ScenesOffset, uint64_t(header.NumScenes) * sizeof(SceneCacheScene)) ||
+            !isInFile(header.MeshesOffset, uint64_t(header.NumMeshes) * sizeof(SceneCacheMesh)) ||
+            !isInFile(header.NodesOffset, uint64_t(header.NumNodes) * sizeof(SceneCacheNode)) ||
+            !isInFile(header.InstancesOffset, uint64_t(header.NumInstances) * sizeof(SceneCacheInstance)) ||
+            !isInFile(header.SubmeshesOffset, uint64_t(header.NumSubmeshes) * sizeof(SceneCacheSubmesh)) ||
+            !isInFile(header.MaterialsOffset, uint64_t(header.NumMaterials) * sizeof(SceneCacheMaterial)) ||
+            !isInFile(header.TexturesOffset, uint64_t(header.NumTextures) * sizeof(SceneCacheTexture)) ||
+            !isInFile(header.SubresourcesOffset, uint64_t(header.NumSubresources) * sizeof(SceneCacheSubresource)) ||
+            !isInFile(header.SourceFilesOffset, header.SourceFilesSize) ||
+            !isInFile(header.GeometryOffset, header.GeometrySize) ||
+            !isInFile(header.TexelsOffset, header.TexelsSize))
+            return false;
+
+        // Every path of source files is null-terminated, including the last one
+        if (header.SourceFilesSize > 0 && m_file.GetData()[header.SourceFilesOffset + header.SourceFilesSize - 1] != std::byte(0))
+            return false;
+
+        // Tables are only walked once here, so that the importer can trust every index and range afterwards
+        for (const SceneCacheScene& scene : GetScenes())
+        {
+            if (scene.FirstMesh > header.NumMeshes || scene.NumMeshes > header.NumMeshes - scene.FirstMesh)
+                return false;
+
+            if (scene.FirstNode > header.NumNodes || scene.NumNodes > header.NumNodes - scene.FirstNode)
+                return false;
+
+            if (scene.FirstInstance > header.NumInstances || scene.NumInstances > header.NumInstances - scene.FirstInstance)
+                return false;
+
+            // Nodes should be in pre-order, thus parent of each node is either the previous node or one of its ancestors
+            std::vector<uint32_t> ancestors;
+            std::span<const SceneCacheNode> nodes = GetNodes().subspan(scene.FirstNode, scene.NumNodes);
+            for (uint32_t i = 0; i < nodes.size(); ++i)
+            {
+                while (!ancestors.empty() && ancestors.back() != nodes[i].Parent)
+                    ancestors.pop_back();
+
+                if (nodes[i].Parent != SceneCacheInvalidIndex && ancestors.empty())
+                    return false;
+
+                ancestors.push_back(i);
+            }
+
+            for (const SceneCacheInstance& instance : GetInstances().subspan(scene.FirstInstance, scene.NumInstances))
+            {
+                if (instance.MeshIndex >= scene.NumMeshes || instance.NodeIndex >= scene.NumNodes)
+                    return false;
+            }
+        }
+
+        for (const SceneCacheMesh& mesh : GetMeshes())
+        {
+            if (mesh.FirstSubmesh > header.NumSubmeshes || mesh.NumSubmeshes > header.NumSubmeshes - mesh.FirstSubmesh)
+                return false;
+        }
+
+        auto isInSection = [](uint64_t size, uint64_t offset, uint64_t numBytes)
+        {
+            return offset <= size && numBytes <= size - offset;
+        };
+
+        for (const SceneCacheSubmesh& submesh : GetSubmeshes())
+        {
+            if (submesh.MaterialIndex != SceneCacheInvalidIndex && submesh.MaterialIndex >= header.NumMaterials)
+                return false;
+
+            if (submesh.VertexFormat >= SceneCacheNumVertexFormats)
+                return false;
+
+            for (uint32_t i = 0; i < SceneCacheNumAttributes; ++i)
+            {
+                if (!isInSection(header.GeometrySize, submesh.AttributeOffsets[i], uint64_t(submesh.AttributeStrides[i]) * submesh.NumVertices))
+                    return false;
+            }
+
+            if (!isInSection(header.GeometrySize, submesh.IndicesOffset, uint64_t(submesh.IndicesStride) * submesh.NumIndices))
+                return false;
+
+            if (submesh.NumLods > SceneCacheMaxLods)
+                return false;
+
+            for (const SceneCacheLod& lod : std::span(submesh.Lods, submesh.NumLods))
+            {
+                if (lod.FirstIndex > submesh.NumIndices || lod.NumIndices > submesh.NumIndices - lod.FirstIndex)
+                    return false;
+            }
+        }
+
+        for (const SceneCacheMaterial& material : GetMaterials())
+        {
+            for (uint32_t textureIndex : material.TextureIndices)
+            {
+                if (textureIndex != SceneCacheInvalidIndex && textureIndex >= header.NumTextures)
+                    return false;
+            }
+        }
+
+        for (const SceneCacheTexture& texture : GetTextures())
+        {
+            if (texture.FirstSubresource > header.NumSubresources || texture.MipLevels > header.NumSubresources - texture.FirstSubresource)
+                return false;
+        }
+
+        for (const SceneCacheSubresource& subresource : GetSubresources())
+        {
+            if (!IsAligned(subresource.Offset, SceneCacheTexelPlacementAlignment) ||
+                !isInSection(header.TexelsSize, subresource.Offset, uint64_t(subresource.RowPitch) * subresource.NumRows))
+                return false;
+        }
+        return true;
+    }
+
+} // Neb namespace
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "../util/MappedFile.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    // Baked scene cache (.nebscene)
+    //
+    // The cache is written by GLTFSceneImporter on the first (cold) import of a glTF file and is used on every
+    // consecutive (warm) import instead of tinygltf, if the content hash of the source still matches.
+    // Everything inside of the cache is laid out in a way, that allows it to be memory-mapped and handed to the upload path
+    // as is, without any per-element parsing:
+    //
+    //  [SceneCacheHeader]
+    //  [SceneCacheScene x NumScenes]
+    //  [SceneCacheMesh x NumMeshes]
+    //  [SceneCacheNode x NumNodes]
+    //  [SceneCacheInstance x NumInstances]
+    //  [SceneCacheSubmesh x NumSubmeshes]
+    //  [SceneCacheMaterial x NumMaterials]
+    //  [SceneCacheTexture x NumTextures]
+    //  [SceneCacheSubresource x NumSubresources]
+    //  [Source files]     - null-terminated UTF-8 paths of files the glTF references, relative to it (see HashSceneCacheSource)
+    //  [Geometry section] - tightly packed attribute streams and indices of every submesh, uploaded as a single buffer
+    //  [Texel section]    - texel data of every subresource, already placed with D3D12 copyable footprint alignments,
+    //                       thus can be uploaded as a single buffer and copied with CopyTextureRegion directly
+    //
+    // The cache does not depend on D3D12 in any way, so it can be read headlessly (see SceneCacheReader)
+
+    static constexpr uint32_t SceneCacheMagic = 0x5342454E; // 'NEBS'
+
+    // Bump the version each time the layout of the cache (or the data importer puts into it) changes.
+    // Caches of other versions are just considered stale and are rebuilt
+    static constexpr uint32_t SceneCacheVersion = 9;
+
+    // Mirror D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT and D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+    static constexpr uint64_t SceneCacheTexelPlacementAlignment = 512;
+    static constexpr uint64_t SceneCacheTexelPitchAlignment = 256;
+    static constexpr uint64_t SceneCacheGeometryAlignment = 16;
+
+    static constexpr uint32_t SceneCacheInvalidIndex = UINT32_MAX;
+
+    // Same order as nri::EAttributeType
+    static constexpr uint32_t SceneCacheNumAttributes = 4;
+
+    static constexpr uint32_t SceneCacheMaxLods = 8;
+
+    // Same order as nri::EVertexFormat
+    static constexpr uint32_t SceneCacheNumVertexFormats = 2;
+
+    struct SceneCacheHeader
+    {
+        uint32_t Magic = SceneCacheMagic;
+        uint32_t Version = SceneCacheVersion;
+        uint64_t SourceHash = 0;
+
+        uint32_t NumScenes = 0;
+        uint32_t NumMeshes = 0;
+        uint32_t NumNodes = 0;
+        uint32_t NumInstances = 0;
+        uint32_t NumSubmeshes = 0;
+        uint32_t NumMaterials = 0;
+        uint32_t NumTextures = 0;
+        uint32_t NumSubresources = 0;
+
+        // All offsets are absolute (from the beginning of the file)
+        uint64_t ScenesOffset = 0;
+        uint64_t MeshesOffset = 0;
+        uint64_t NodesOffset = 0;
+        uint64_t InstancesOffset = 0;
+        uint64_t SubmeshesOffset = 0;
+        uint64_t MaterialsOffset = 0;
+        uint64_t TexturesOffset = 0;
+        uint64_t SubresourcesOffset = 0;
+        uint64_t SourceFilesOffset = 0;
+        uint64_t SourceFilesSize = 0;
+
+        uint64_t GeometryOffset = 0;
+        uint64_t GeometrySize = 0;
+        uint64_t TexelsOffset = 0;
+        uint64_t TexelsSize = 0;
+    };
+
+    struct SceneCacheScene
+    {
+        uint32_t FirstMesh = 0;
+        uint32_t NumMeshes = 0;
+        uint32_t FirstNode = 0;
+        uint32_t NumNodes = 0;
+        uint32_t FirstInstance = 0;
+        uint32_t NumInstances = 0;
+        float BoxMin[3] = {};
+        float BoxMax[3] = {};
+    };
+
+    // Meshes are unique geometry of a scene, each of them is baked once no matter how many instances it has.
+    // Bounds of a mesh are not stored, they are merged from bounds of its submeshes
+    struct SceneCacheMesh
+    {
+        uint32_t FirstSubmesh = 0;
+        uint32_t NumSubmeshes = 0;
+    };
+
+    // Nodes of a scene are stored in the order of SceneGraph (pre-order), thus Parent is always less than the index of the node
+    struct SceneCacheNode
+    {
+        float Translation[3] = {};
+        float Rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f }; // quaternion, xyzw
+        float Scale[3] = { 1.0f, 1.0f, 1.0f };
+        uint32_t Parent = SceneCacheInvalidIndex; // relative to SceneCacheScene::FirstNode, SceneCacheInvalidIndex for roots
+    };
+
+    struct SceneCacheInstance
+    {
+        uint32_t NodeIndex = 0; // relative to SceneCacheScene::FirstNode
+        uint32_t MeshIndex = 0; // relative to SceneCacheScene::FirstMesh
+    };
+
+    struct SceneCacheLod
+    {
+        uint32_t FirstIndex = 0;
+        uint32_t NumIndices = 0;
+        float Error = 0.0f;
+    };
+
+    struct SceneCacheSubmesh
+    {
+        uint32_t NumVertices = 0;
+        uint32_t NumIndices = 0; // indices of every LOD if there are any, full resolution is Lods[0] then
+        uint32_t IndicesStride = 0;
+        uint32_t MaterialIndex = SceneCacheInvalidIndex;
+
+        uint32_t NumLods = 0;
+        SceneCacheLod Lods[SceneCacheMaxLods] = {};
+
+        // Quantization is only meaningful for the compact format, see VertexCompression.h
+        uint32_t VertexFormat = 0;
+        float PositionScale[3] = { 1.0f, 1.0f, 1.0f };
+        float PositionBias[3] = {};
+
+        // Bounds of full precision positions in mesh space, see ComputeBounds()
+        float BoxMin[3] = {};
+        float BoxMax[3] = {};
+        float SphereCenter[3] = {};
+        float SphereRadius = 0.0f;
+
+        // Offsets are relative to the geometry section. Strides are always tight
+        std::array<uint64_t, SceneCacheNumAttributes> AttributeOffsets = {};
+        std::array<uint32_t, SceneCacheNumAttributes> AttributeStrides = {};
+        uint64_t IndicesOffset = 0;
+    };
+
+    struct SceneCacheMaterial
+    {
+        float AlbedoFactor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        float RoughnessMetalnessFactor[2] = { 1.0f, 0.0f };
+        uint32_t Flags = 0;
+
+        // Same order as nri::EMaterialTextureType. SceneCacheInvalidIndex if no texture
+        uint32_t TextureIndices[3] = { SceneCacheInvalidIndex, SceneCacheInvalidIndex, SceneCacheInvalidIndex };
+    };
+
+    struct SceneCacheTexture
+    {
+        uint64_t ContentHash = 0; // see TextureRegistryKey
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t Format = 0; // DXGI_FORMAT
+        uint32_t MipLevels = 0; // 0 if texture is absent (failed to decode or was empty in the source)
+        uint32_t FirstSubresource = 0;
+    };
+
+    struct SceneCacheSubresource
+    {
+        uint64_t Offset = 0; // relative to the texel section, aligned to SceneCacheTexelPlacementAlignment
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t RowPitch = 0; // aligned to SceneCacheTexelPitchAlignment
+        uint32_t NumRows = 0;  // for block-compressed formats this is the amount of block rows
+    };
+
+    // Source data of a submesh to be baked. Attribute views may be strided (interleaved),
+    // the writer will repack them into tight streams
+    struct SceneCacheSubmeshSource
+    {
+        uint32_t NumVertices = 0;
+        std::array<const std::byte*, SceneCacheNumAttributes> Attributes = {};
+        std::array<uint32_t, SceneCacheNumAttributes> AttributeStrides = {};
+        std::array<uint32_t, SceneCacheNumAttributes> AttributeElementSizes = {};
+
+        uint32_t NumIndices = 0; // including every LOD
+        uint32_t IndicesStride = 0;
+        const std::byte* Indices = nullptr;
+
+        uint32_t MaterialIndex = SceneCacheInvalidIndex;
+
+        uint32_t NumLods = 0;
+        SceneCacheLod Lods[SceneCacheMaxLods] = {};
+
+        uint32_t VertexFormat = 0;
+        float PositionScale[3] = { 1.0f, 1.0f, 1.0f };
+        float PositionBias[3] = {};
+
+        float BoxMin[3] = {};
+        float BoxMax[3] = {};
+        float SphereCenter[3] = {};
+        float SphereRadius = 0.0f;
+    };
+
+    // Source data of a single texture subresource with tightly packed rows
+    struct SceneCacheSubresourceSource
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t NumBytesInRow = 0;
+        uint32_t NumRows = 0;
+        const std::byte* Data = nullptr;
+    };
+
+    // Hashes the glTF file and every file it references (buffers and images, both for ascii and binary glTF), paths of sourceFiles
+    // are relative to the glTF file. References are only known once the glTF is parsed, thus cold imports store them in the cache
+    // and warm imports hash the same files again without touching the json
+    uint64_t HashSceneCacheSource(const std::filesystem::path& filepath, std::span<const std::filesystem::path> sourceFiles, uint64_t seed);
+
+    // By default cache is placed next to the source file
+    std::filesystem::path GetSceneCachePath(const std::filesystem::path& filepath);
+
+    class SceneCacheWriter
+    {
+    public:
+        void BeginScene();
+        void EndScene(const float boxMin[3], const float boxMax[3]);
+
+        void BeginMesh();
+        void AddSubmesh(const SceneCacheSubmeshSource& src);
+
+        // Indices are relative to the first node and mesh of the current scene. Nodes should be added in pre-order
+        void AddNode(const SceneCacheNode& node);
+        void AddInstance(uint32_t nodeIndex, uint32_t meshIndex);
+
+        uint32_t AddMaterial(const SceneCacheMaterial& material);
+
+        // Adds a texture with all its subresources (mips). Passing empty subresources adds an absent texture,
+        // which is needed to keep texture indices of materials valid
+        uint32_t AddTexture(uint32_t format, uint64_t contentHash, std::span<const SceneCacheSubresourceSource> subresources);
+
+        uint64_t GetNumGeometryBytes() const { return m_geometry.size(); }
+        uint64_t GetNumTexelBytes() const { return m_texels.size(); }
+
+        // The file is written to a temporary location first and then renamed, so that partially written caches are never read
+        bool WriteToFile(const std::filesystem::path& filepath, uint64_t sourceHash, std::span<const std::filesystem::path> sourceFiles) const;
+
+    private:
+        uint64_t AppendGeometry(const std::byte* data, size_t numBytes);
+
+        std::vector<SceneCacheScene> m_scenes;
+        std::vector<SceneCacheMesh> m_meshes;
+        std::vector<SceneCacheNode> m_nodes;
+        std::vector<SceneCacheInstance> m_instances;
+        std::vector<SceneCacheSubmesh> m_submeshes;
+        std::vector<SceneCacheMaterial> m_materials;
+        std::vector<SceneCacheTexture> m_textures;
+        std::vector<SceneCacheSubresource> m_subresources;
+
+        std::vector<std::byte> m_geometry;
+        std::vector<std::byte> m_texels;
+    };
+
+    // Headless reader of the baked cache. Maps the file and validates all of the tables once on open,
+    // after that every getter is just a view into the mapping
+    class SceneCacheReader
+    {
+    public:
+        // Returns false if there is no cache, its version mismatches or it is corrupted. Source files stored in the cache are hashed
+        // with the seed the cache was baked with (see HashSceneCacheSource), the cache is stale if that does not match its source hash
+        bool Open(const std::filesystem::path& filepath, const std::filesystem::path& sourcePath, uint64_t seed);
+        void Close();
+
+        bool IsValid() const { return m_header != nullptr; }
+
+        const SceneCacheHeader& GetHeader() const { return *m_header; }
+        std::span<const SceneCacheScene> GetScenes() const { return GetTable<SceneCacheScene>(m_header->ScenesOffset, m_header->NumScenes); }
+        std::span<const SceneCacheMesh> GetMeshes() const { return GetTable<SceneCacheMesh>(m_header->MeshesOffset, m_header->NumMeshes); }
+        std::span<const SceneCacheNode> GetNodes() const { return GetTable<SceneCacheNode>(m_header->NodesOffset, m_header->NumNodes); }
+        std::span<const SceneCacheInstance> GetInstances() const { return GetTable<SceneCacheInstance>(m_header->InstancesOffset, m_header->NumInstances); }
+        std::span<const SceneCacheSubmesh> GetSubmeshes() const { return GetTable<SceneCacheSubmesh>(m_header->SubmeshesOffset, m_header->NumSubmeshes); }
+        std::span<const SceneCacheMaterial> GetMaterials() const { return GetTable<SceneCacheMaterial>(m_header->MaterialsOffset, m_header->NumMaterials); }
+        std::span<const SceneCacheTexture> GetTextures() const { return GetTable<SceneCacheTexture>(m_header->TexturesOffset, m_header->NumTextures); }
+        std::span<const SceneCacheSubresource> GetSubresources() const { return GetTable<SceneCacheSubresource>(m_header->SubresourcesOffset, m_header->NumSubresources); }
+
+        std::vector<std::filesystem::path> GetSourceFiles() const;
+
+        std::span<const std::byte> GetGeometryBytes() const { return m_file.GetBytes().subspan(m_header->GeometryOffset, m_header->GeometrySize); }
+        std::span<const std::byte> GetTexelBytes() const { return m_file.GetBytes().subspan(m_header->TexelsOffset, m_header->TexelsSize); }
+
+        size_t GetNumMappedBytes() const { return m_file.GetSize(); }
+
+    private:
+        bool Validate() const;
+
+        template<typename T>
+        std::span<const T> GetTable(uint64_t offset, uint32_t count) const
+        {
+            return std::span<const T>(reinterpret_cast<const T*>(m_file.GetData() + offset), count);
+        }
+
+        MappedFile m_file;
+        const SceneCacheHeader* m_header = nullptr;
+    };
+
+} // Neb namespace
@@ -0,0 +1,261 @@
+#include "SceneGraph.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Neb
+{
+
+    namespace
+    {
+        bool IsMatrixNearlyEqual(const Mat4& lhs, const Mat4& rhs, float tolerance)
+        {
+            const float* a = &lhs._11;
+            const float* b = &rhs._11;
+
+            float magnitude = 1.0f;
+            for (uint32_t i = 0; i < 16; ++i)
+                magnitude = std::max(magnitude, std::abs(b[i]));
+
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (!(std::abs(a[i] - b[i]) <= tolerance * magnitude))
+                    return false;
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    Mat4 ComposeSceneNodeTransform(const Vec3& translation, const Quaternion& rotation, const Vec3& scale)
+    {
+        // Scaling from the left just scales rows of the rotation, translation from the right only sets the last row
+        Mat4 m = Mat4::CreateFromQuaternion(rotation);
+        m._11 *= scale.x; m._12 *= scale.x; m._13 *= scale.x;
+        m._21 *= scale.y; m._22 *= scale.y; m._23 *= scale.y;
+        m._31 *= scale.z; m._32 *= scale.z; m._33 *= scale.z;
+        m._41 = translation.x;
+        m._42 = translation.y;
+        m._43 = translation.z;
+        return m;
+    }
+
+    bool DecomposeSceneNodeTransform(const Mat4& matrix, SceneNodeTransform& transform)
+    {
+        Mat4 m = matrix;
+        if (!m.Decompose(transform.Scale, transform.Rotation, transform.Translation))
+            return false;
+
+        // Decompose() happily drops shear and projection, so check the roundtrip
+        return IsMatrixNearlyEqual(ComposeSceneNodeTransform(transform.Translation, transform.Rotation, transform.Scale), matrix, 1e-4f);
+    }
+
+    uint32_t SceneGraph::AddNode(uint32_t parentIndex, const SceneNodeTransform& localTransform)
+    {
+        const uint32_t nodeIndex = GetNumNodes();
+        NEB_ASSERT(parentIndex == SceneGraphInvalidNode || (parentIndex < nodeIndex && parentIndex + m_subtreeSizes[parentIndex] == nodeIndex),
+            "Nodes should be added in pre-order, parent {} is not an ancestor of the last added node", parentIndex);
+
+        m_parents.push_back(parentIndex);
+        m_subtreeSizes.push_back(1);
+        m_translations.push_back(localTransform.Translation);
+        m_rotations.push_back(localTransform.Rotation);
+        m_scales.push_back(localTransform.Scale);
+        m_worldMatrices.push_back(Mat4::Identity);
+        m_dirty.push_back(0);
+        MarkDirty(nodeIndex);
+
+        for (uint32_t ancestor = parentIndex; ancestor != SceneGraphInvalidNode; ancestor = m_parents[ancestor])
+            ++m_subtreeSizes[ancestor];
+
+        return nodeIndex;
+    }
+
+    void SceneGraph::Reserve(uint32_t numNodes)
+    {
+        m_parents.reserve(numNodes);
+        m_subtreeSizes.reserve(numNodes);
+        m_translations.reserve(numNodes);
+        m_rotations.reserve(numNodes);
+        m_scales.reserve(numNodes);
+        m_worldMatrices.reserve(numNodes);
+        m_dirty.reserve(numNodes);
+    }
+
+    void SceneGraph::Clear()
+    {
+        m_parents.clear();
+        m_subtreeSizes.clear();
+        m_translations.clear();
+        m_rotations.clear();
+        m_scales.clear();
+        m_worldMatrices.clear();
+        m_dirty.clear();
+        m_dirtyNodes.clear();
+    }
+
+    SceneNodeTransform SceneGraph::GetLocalTransform(uint32_t nodeIndex) const
+    {
+        return SceneNodeTransform{
+            .Translation = m_translations[nodeIndex],
+            .Rotation = m_rotations[nodeIndex],
+            .Scale = m_scales[nodeIndex],
+        };
+    }
+
+    void SceneGraph::SetLocalTransform(uint32_t nodeIndex, const SceneNodeTransform& localTransform)
+    {
+        m_translations[nodeIndex] = localTransform.Translation;
+        m_rotations[nodeIndex] = localTransform.Rotation;
+        m_scales[nodeIndex] = localTransform.Scale;
+        MarkDirty(nodeIndex);
+    }
+
+    void SceneGraph::SetLocalTranslation(uint32_t nodeIndex, const Vec3& translation)
+    {
+        m_translations[nodeIndex] = translation;
+        MarkDirty(nodeIndex);
+    }
+
+    void SceneGraph::SetLocalRotation(uint32_t nodeIndex, const Quaternion& rotation)
+    {
+        m_rotations[nodeIndex] = rotation;
+        MarkDirty(nodeIndex);
+    }
+
+    void SceneGraph::SetLocalScale(uint32_t nodeIndex, const Vec3& scale)
+    {
+        m_scales[nodeIndex] = scale;
+        MarkDirty(nodeIndex);
+    }
+
+    uint32_t SceneGraph::UpdateWorldMatrices()
+    {
+        if (!IsDirty())
+            return 0;
+
+        CollectDirtyRanges(m_dirtyRanges);
+
+        uint32_t numUpdatedNodes = 0;
+        for (const UpdateRange& range : m_dirtyRanges)
+        {
+            for (uint32_t i = range.Begin; i < range.End; ++i)
+                UpdateNode(i);
+
+            numUpdatedNodes += range.End - range.Begin;
+        }
+
+        ClearDirtyNodes();
+        return numUpdatedNodes;
+    }
+
+    uint32_t SceneGraph::UpdateWorldMatricesParallel(ThreadPool& threadPool, uint32_t minNodesPerTask)
+    {
+        if (!IsDirty())
+            return 0;
+
+        minNodesPerTask = std::max(minNodesPerTask, 1u);
+        CollectDirtyRanges(m_dirtyRanges);
+
+        // Subtrees that are too large are split into subtrees of children, their root is updated serially beforehand
+        m_tasks.clear();
+        m_serialNodes.clear();
+        while (!m_dirtyRanges.empty())
+        {
+            const UpdateRange range = m_dirtyRanges.back();
+            m_dirtyRanges.pop_back();
+
+            if (range.End - range.Begin <= minNodesPerTask)
+            {
+                m_tasks.push_back(range);
+                continue;
+            }
+
+            m_serialNodes.push_back(range.Begin);
+            for (uint32_t child = range.Begin + 1; child < range.End; child += m_subtreeSizes[child])
+                m_dirtyRanges.push_back(UpdateRange{ .Begin = child, .End = child + m_subtreeSizes[child] });
+        }
+
+        // Ancestors before descendants
+        std::ranges::sort(m_serialNodes);
+        for (uint32_t nodeIndex : m_serialNodes)
+            UpdateNode(nodeIndex);
+
+        // Small subtrees (e.g. single dirty leaves) are batched, so that each batch has about minNodesPerTask nodes
+        std::ranges::sort(m_tasks, {}, &UpdateRange::Begin);
+        m_taskBatches.clear();
+
+        uint32_t numUpdatedNodes = static_cast<uint32_t>(m_serialNodes.size());
+        uint32_t numBatchNodes = minNodesPerTask;
+        for (uint32_t i = 0; i < m_tasks.size(); ++i)
+        {
+            if (numBatchNodes >= minNodesPerTask)
+            {
+                m_taskBatches.push_back(i);
+                numBatchNodes = 0;
+            }
+
+            numBatchNodes += m_tasks[i].End - m_tasks[i].Begin;
+            numUpdatedNodes += m_tasks[i].End - m_tasks[i].Begin;
+        }
+        m_taskBatches.push_back(static_cast<uint32_t>(m_tasks.size()));
+
+        threadPool.ParallelFor(m_taskBatches.size() - 1, [this](size_t batchIndex)
+            {
+                for (uint32_t taskIndex = m_taskBatches[batchIndex]; taskIndex < m_taskBatches[batchIndex + 1]; ++taskIndex)
+                {
+                    const UpdateRange& task = m_tasks[taskIndex];
+                    for (uint32_t i = task.Begin; i < task.End; ++i)
+                        UpdateNode(i);
+                }
+            });
+
+        ClearDirtyNodes();
+        return numUpdatedNodes;
+    }
+
+    void SceneGraph::MarkDirty(uint32_t nodeIndex)
+    {
+        if (m_dirty[nodeIndex])
+            return;
+
+        m_dirty[nodeIndex] = 1;
+        m_dirtyNodes.push_back(nodeIndex);
+    }
+
+    void SceneGraph::UpdateNode(uint32_t nodeIndex)
+    {
+        const Mat4 local = ComposeSceneNodeTransform(m_translations[nodeIndex], m_rotations[nodeIndex], m_scales[nodeIndex]);
+
+        const uint32_t parentIndex = m_parents[nodeIndex];
+        m_worldMatrices[nodeIndex] = (parentIndex == SceneGraphInvalidNode) ? local : local * m_worldMatrices[parentIndex];
+    }
+
+    void SceneGraph::CollectDirtyRanges(std::vector<UpdateRange>& ranges)
+    {
+        ranges.clear();
+        std::ranges::sort(m_dirtyNodes);
+
+        // Subtrees are either nested or disjoint. As nodes are sorted, a node is either inside of the last collected subtree or after it
+        uint32_t coveredEnd = 0;
+        for (uint32_t nodeIndex : m_dirtyNodes)
+        {
+            if (nodeIndex < coveredEnd)
+                continue;
+
+            coveredEnd = nodeIndex + m_subtreeSizes[nodeIndex];
+            ranges.push_back(UpdateRange{ .Begin = nodeIndex, .End = coveredEnd });
+        }
+    }
+
+    void SceneGraph::ClearDirtyNodes()
+    {
+        for (uint32_t nodeIndex : m_dirtyNodes)
+            m_dirty[nodeIndex] = 0;
+
+        m_dirtyNodes.clear();
+    }
+
+} // Neb namespace
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Math.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    static constexpr uint32_t SceneGraphInvalidNode = UINT32_MAX;
+
+    // Local transform of a node relative to its parent. Applied as scale, rotation and then translation, same as glTF
+    struct SceneNodeTransform
+    {
+        Vec3 Translation = Vec3(0.0f);
+        Quaternion Rotation = Quaternion::Identity;
+        Vec3 Scale = Vec3(1.0f);
+    };
+
+    // Local matrix of the transform, equal to CreateScale() * CreateFromQuaternion() * CreateTranslation()
+    Mat4 ComposeSceneNodeTransform(const Vec3& translation, const Quaternion& rotation, const Vec3& scale);
+
+    // Returns false if the matrix cannot be represented as TRS (glTF requires node matrices to be decomposable)
+    bool DecomposeSceneNodeTransform(const Mat4& matrix, SceneNodeTransform& transform);
+
+    // Flat transform hierarchy (glTF nodes). Every attribute of nodes is stored in its own array (SoA) and nodes are sorted
+    // by parents in depth-first pre-order: a parent always precedes its children and every subtree is contiguous, thus
+    // the subtree of node i is [i, i + GetSubtreeSize(i)).
+    //
+    // Changing a local transform only marks the node as dirty. World matrices of dirty nodes and all of their descendants
+    // are recomputed on update in a single linear pass over the dirty subtrees, clean subtrees are never touched
+    class SceneGraph
+    {
+    public:
+        // Nodes should be added in depth-first pre-order, thus parentIndex is either the last added node or one of its ancestors.
+        // Returns the index of the node
+        uint32_t AddNode(uint32_t parentIndex, const SceneNodeTransform& localTransform);
+        void Reserve(uint32_t numNodes);
+        void Clear();
+
+        uint32_t GetNumNodes() const { return static_cast<uint32_t>(m_parents.size()); }
+        uint32_t GetParent(uint32_t nodeIndex) const { return m_parents[nodeIndex]; }
+        uint32_t GetSubtreeSize(uint32_t nodeIndex) const { return m_subtreeSizes[nodeIndex]; } // including the node itself
+
+        SceneNodeTransform GetLocalTransform(uint32_t nodeIndex) const;
+        void SetLocalTransform(uint32_t nodeIndex, const SceneNodeTransform& localTransform);
+        void SetLocalTranslation(uint32_t nodeIndex, const Vec3& translation);
+        void SetLocalRotation(uint32_t nodeIndex, const Quaternion& rotation);
+        void SetLocalScale(uint32_t nodeIndex, const Vec3& scale);
+
+        // World matrices are only valid for clean nodes, i.e. after an update
+        const Mat4& GetWorldMatrix(uint32_t nodeIndex) const { return m_worldMatrices[nodeIndex]; }
+        std::span<const Mat4> GetWorldMatrices() const { return m_worldMatrices; }
+
+        bool IsDirty() const { return !m_dirtyNodes.empty(); }
+        uint32_t GetNumDirtyNodes() const { return static_cast<uint32_t>(m_dirtyNodes.size()); }
+
+        // Both return the amount of recomputed world matrices
+        uint32_t UpdateWorldMatrices();
+
+        // Dirty subtrees are split into tasks of at most minNodesPerTask nodes (roots of split subtrees are updated serially first)
+        // and the tasks are updated in parallel, as subtrees never depend on each other
+        uint32_t UpdateWorldMatricesParallel(ThreadPool& threadPool, uint32_t minNodesPerTask = 4096);
+
+    private:
+        struct UpdateRange
+        {
+            uint32_t Begin = 0;
+            uint32_t End = 0;
+        };
+
+        void MarkDirty(uint32_t nodeIndex);
+        void UpdateNode(uint32_t nodeIndex);
+
+        // Sorts dirty nodes and returns disjoint subtrees, that cover all of them
+        void CollectDirtyRanges(std::vector<UpdateRange>& ranges);
+        void ClearDirtyNodes();
+
+        std::vector<uint32_t> m_parents;
+        std::vector<uint32_t> m_subtreeSizes;
+        std::vector<Vec3> m_translations;
+        std::vector<Quaternion> m_rotations;
+        std::vector<Vec3> m_scales;
+        std::vector<Mat4> m_worldMatrices;
+
+        // Dirty bit of every node and the list of dirty nodes, so that updates never scan the whole graph
+        std::vector<uint8_t> m_dirty;
+        std::vector<uint32_t> m_dirtyNodes;
+
+        // Scratch of updates, kept to avoid reallocations each update
+        std::vector<UpdateRange> m_dirtyRanges;
+        std::vector<UpdateRange> m_tasks;
+        std::vector<uint32_t> m_taskBatches; // first task of each batch, the last entry is the amount of tasks
+        std::vector<uint32_t> m_serialNodes;
+    };
+
+} // Neb namespace
@@ -0,0 +1,121 @@
+#include "SceneLoader.h"
+
+#include "../common/Assert.h"
+#include "../common/Log.h"
+#include "../common/TimeWatch.h"
+
+#include <exception>
+
+namespace Neb
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+    } // anonymous namespace
+
+    SceneLoader::SceneLoader(uint32_t numWorkers)
+        : m_threadPool(numWorkers)
+    {
+        m_thread = std::thread(&SceneLoader::LoaderThread, this);
+    }
+
+    SceneLoader::~SceneLoader()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopRequested = true;
+        }
+        m_requestCondition.notify_one();
+        m_thread.join();
+
+        // Published, but never taken
+        delete m_loadedScene.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    void SceneLoader::RequestLoad(const std::filesystem::path& filepath, EGLTFType type)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            if (!m_pendingRequest.has_value())
+                m_numPendingLoads.fetch_add(1, std::memory_order_acq_rel);
+
+            m_pendingRequest = LoadRequest{ .Filepath = filepath, .Type = type };
+        }
+        m_requestCondition.notify_one();
+    }
+
+    Scoped<LoadedScene> SceneLoader::TakeLoaded()
+    {
+        // Cheap enough to be polled every frame
+        if (!m_loadedScene.load(std::memory_order_relaxed))
+            return Scoped<LoadedScene>();
+
+        return Scoped<LoadedScene>(m_loadedScene.exchange(nullptr, std::memory_order_acq_rel));
+    }
+
+    void SceneLoader::LoaderThread()
+    {
+        while (true)
+        {
+            LoadRequest request;
+            {
+                std::unique_lock lock(m_mutex);
+                m_requestCondition.wait(lock, [this]() { return m_stopRequested || m_pendingRequest.has_value(); });
+                if (m_stopRequested)
+                    return;
+
+                request = std::move(*m_pendingRequest);
+                m_pendingRequest.reset();
+            }
+
+            Scoped<LoadedScene> loadedScene = Load(request);
+            if (loadedScene.IsValid())
+            {
+                // Earlier scene that was not taken yet is never going to be rendered
+                LoadedScene* publishedScene = loadedScene.ptr;
+                loadedScene.ptr = nullptr; // ownership is passed to m_loadedScene
+                delete m_loadedScene.exchange(publishedScene, std::memory_order_acq_rel);
+            }
+            else
+            {
+                m_numFailedLoads.fetch_add(1, std::memory_order_relaxed);
+            }
+            m_numPendingLoads.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    Scoped<LoadedScene> SceneLoader::Load(const LoadRequest& request)
+    {
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        // Errors of the import (including D3D12 ones) should not take down the render thread, the scene is just not published
+        Scoped<LoadedScene> loadedScene = MakeScoped<LoadedScene>();
+        try
+        {
+            loadedScene->Filepath = request.Filepath;
+            loadedScene->Importer = MakeScoped<GLTFSceneImporter>(&m_textureRegistry, &m_threadPool);
+            if (!loadedScene->Importer->ImportScenesFromFile(request.Filepath, request.Type) || loadedScene->Importer->ImportedScenes.empty())
+            {
+                NEB_LOG_ERROR("SceneLoader -> Failed to import '{}'", request.Filepath.string());
+                return Scoped<LoadedScene>();
+            }
+
+            // Uploads of both are completed before they return
+            Scene* scene = loadedScene->GetScene();
+            loadedScene->GIScene = MakeScoped<nri::GIProcessedScene>();
+            nri::ThrowIfFalse(loadedScene->GIScene->InitScene(scene->StaticMeshes, scene->StaticMeshInstances), "Failed to initialize GI scene for pathtracer");
+        }
+        catch (const std::exception& exception)
+        {
+            NEB_LOG_ERROR("SceneLoader -> Failed to load '{}': {}", request.Filepath.string(), exception.what());
+            return Scoped<LoadedScene>();
+        }
+
+        loadedScene->LoadMilliseconds = timeWatch.Elapsed<MillisecondsF32>().count();
+        NEB_LOG_INFO("SceneLoader -> Loaded '{}' in background in {:.1f}ms", request.Filepath.filename().string(), loadedScene->LoadMilliseconds);
+        return loadedScene;
+    }
+
+} // Neb namespace
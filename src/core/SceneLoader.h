@@ -0,0 +1,83 @@
+#pragma once
+
+#include "GLTFSceneImporter.h"
+#include "TextureRegistry.h"
+#include "../nri/GIProcessedScene.h"
+#include "../util/ScopedPointer.h"
+#include "../util/ThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace Neb
+{
+
+    // Everything that is needed to render an imported scene. Built on the loader thread, so that
+    // the render thread only ever gets scenes, that are complete and resident on the GPU
+    struct LoadedScene
+    {
+        Scene* GetScene() { return Importer->ImportedScenes.front(); }
+
+        std::filesystem::path Filepath;
+        Scoped<GLTFSceneImporter> Importer; // owns imported scenes and their resources
+        Scoped<nri::GIProcessedScene> GIScene; // of the first imported scene
+        float LoadMilliseconds = 0.0f;
+    };
+
+    // Imports scenes on a background thread. Completed scenes are published with an atomic exchange and should be taken
+    // at a frame boundary with TakeLoaded(), which never blocks. Each load gets its own importer, thus scenes that are still
+    // rendered are never touched, while textures are still shared between loads through a single registry.
+    //
+    // Jobs of the import run on a pool of the loader. ThreadPool is FIFO, so on the shared pool culling and sorting jobs
+    // of the render thread would wait behind every decode and compression job of the load
+    class SceneLoader
+    {
+    public:
+        // Half of the default workers by default, so that the render thread and its pool are not starved of cores while loading
+        explicit SceneLoader(uint32_t numWorkers = ThreadPool::GetDefaultNumWorkers() / 2);
+        ~SceneLoader(); // waits for the current load, if any
+
+        SceneLoader(const SceneLoader&) = delete;
+        SceneLoader& operator=(const SceneLoader&) = delete;
+
+        // Replaces the request that was not started yet, if any. The current load is not cancelled
+        void RequestLoad(const std::filesystem::path& filepath, EGLTFType type = EGLTFType::AsciiFile);
+
+        // True from the request until the scene is published (or failed to load)
+        bool IsLoading() const { return m_numPendingLoads.load(std::memory_order_acquire) > 0; }
+        uint32_t GetNumFailedLoads() const { return m_numFailedLoads.load(std::memory_order_relaxed); }
+
+        // Lock-free. Returns the last published scene once, empty if there is none. Scenes that were published
+        // but never taken are dropped in favor of later ones
+        Scoped<LoadedScene> TakeLoaded();
+
+    private:
+        struct LoadRequest
+        {
+            std::filesystem::path Filepath;
+            EGLTFType Type = EGLTFType::AsciiFile;
+        };
+
+        void LoaderThread();
+        Scoped<LoadedScene> Load(const LoadRequest& request);
+
+        // Only touched by the loader thread
+        TextureRegistry m_textureRegistry;
+        ThreadPool m_threadPool;
+
+        std::mutex m_mutex;
+        std::condition_variable m_requestCondition;
+        std::optional<LoadRequest> m_pendingRequest;
+        bool m_stopRequested = false;
+
+        std::atomic<uint32_t> m_numPendingLoads = 0;
+        std::atomic<uint32_t> m_numFailedLoads = 0;
+        std::atomic<LoadedScene*> m_loadedScene = nullptr;
+        std::thread m_thread;
+    };
+
+} // Neb namespace
@@ -0,0 +1,1165 @@
+#include "TextureCompression.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <immintrin.h>
+
+namespace Neb
+{
+
+    namespace
+    {
+        static constexpr uint32_t NumChannels = 4;
+        static constexpr uint32_t NumBlockTexels = 16;
+        static constexpr uint16_t AllBlockTexels = 0xffff;
+
+        // Roughly the amount of blocks per job of CompressTextures
+        static constexpr uint32_t NumBlocksPerJob = 1024;
+
+        // Least squares refinements of the endpoints per quality, refinement stops early once it does not improve the error
+        static constexpr uint32_t NumRefinements[eTextureCompressionQuality_NumQualities] = { 0, 1, 3 };
+
+        // Partitions of BC7 mode 1 that are fully encoded, picked by the estimated error of their subsets
+        static constexpr uint32_t NumPartitionCandidates = 4;
+
+        // Interpolation weights of palette positions, positions are ordered by weight. Palette entry of the position is
+        // ((Denominator - Weight) * e0 + Weight * e1 + Denominator / 2) / Denominator, with integer division
+        static constexpr uint8_t Bc1Weights[4] = { 0, 1, 2, 3 };
+        static constexpr uint8_t Bc4Weights[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+        static constexpr uint8_t Bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+        static constexpr uint8_t Bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // BC1 and BC4 store their endpoints as the first two codes
+        static constexpr uint8_t Bc1PositionToCode[4] = { 0, 2, 3, 1 };
+        static constexpr uint8_t Bc4PositionToCode[8] = { 0, 2, 3, 4, 5, 6, 7, 1 };
+
+        // BC7 partitions of 2 subsets, bit i is set if texel i belongs to the second subset
+        static constexpr uint16_t Bc7Partitions2[64] = {
+            0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+            0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+            0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+            0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+        };
+
+        // Anchor texels of the second subset of Bc7Partitions2, the first subset is always anchored at texel 0
+        static constexpr uint8_t Bc7Anchors2[64] = {
+            15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+            15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+            15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+             6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+        };
+
+#if defined(__AVX2__)
+        using FloatV = __m256;
+        static constexpr uint32_t SimdWidth = 8;
+
+        FloatV SetV(float v) { return _mm256_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm256_load_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm256_store_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        FloatV SubV(FloatV a, FloatV b) { return _mm256_sub_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm256_blendv_ps(b, a, mask); }
+#else
+        // SSE2 is always there on x64
+        using FloatV = __m128;
+        static constexpr uint32_t SimdWidth = 4;
+
+        FloatV SetV(float v) { return _mm_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm_load_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm_store_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        FloatV SubV(FloatV a, FloatV b) { return _mm_sub_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm_cmplt_ps(a, b); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#endif
+
+        static_assert(NumBlockTexels % SimdWidth == 0, "Texels of a block are processed in whole vectors");
+
+        // Texels of a single block, channels are split so that texels are loaded as vectors. Values are 8-bit codes,
+        // so squared distances between them (and their sums over a block) are exact in floats
+        struct Block
+        {
+            alignas(32) float Texels[NumChannels][NumBlockTexels];
+            uint32_t NumUsedChannels = 0;
+        };
+
+        struct PaletteDesc
+        {
+            const uint8_t* Weights = nullptr;
+            uint32_t NumEntries = 0;
+            uint32_t Denominator = 0;
+        };
+
+        static constexpr PaletteDesc Bc1Palette = { .Weights = Bc1Weights, .NumEntries = 4, .Denominator = 3 };
+        static constexpr PaletteDesc Bc4Palette = { .Weights = Bc4Weights, .NumEntries = 8, .Denominator = 7 };
+        static constexpr PaletteDesc Bc7Palette3 = { .Weights = Bc7Weights3, .NumEntries = 8, .Denominator = 64 };
+        static constexpr PaletteDesc Bc7Palette4 = { .Weights = Bc7Weights4, .NumEntries = 16, .Denominator = 64 };
+
+        struct Palette
+        {
+            float Entries[16][NumChannels];
+            uint32_t NumEntries = 0;
+        };
+
+        // Endpoints as stored by the format (codes and p-bits) and as decoded by it (values, 8-bit)
+        struct Endpoints
+        {
+            uint32_t Codes[2][NumChannels] = {};
+            uint32_t PBits[2] = {};
+            int32_t Values[2][NumChannels] = {};
+        };
+
+        // Rounds float endpoints to the closest representable ones, p-bits of the combination are fixed
+        struct EndpointQuantizer
+        {
+            uint32_t NumPBitCombinations = 1;
+            void (*Quantize)(Endpoints& dst, const float (&endpoints)[2][NumChannels], uint32_t numChannels, uint32_t pbits) = nullptr;
+        };
+
+        // Closest code of the value, expand() decodes codes to 8 bits and is expected to be monotonic
+        template<typename Expand>
+        uint32_t QuantizeChannel(float value, uint32_t maxCode, Expand&& expand)
+        {
+            const int32_t estimate = static_cast<int32_t>(value * maxCode / 255.0f + 0.5f);
+            uint32_t bestCode = 0;
+            float bestDistance = FLT_MAX;
+            for (int32_t code = std::max(estimate - 1, 0); code <= std::min(estimate + 1, int32_t(maxCode)); ++code)
+            {
+                const float distance = std::abs(float(expand(uint32_t(code))) - value);
+                if (distance < bestDistance)
+                {
+                    bestCode = uint32_t(code);
+                    bestDistance = distance;
+                }
+            }
+            return bestCode;
+        }
+
+        uint32_t Expand5(uint32_t code) { return (code << 3) | (code >> 2); }
+        uint32_t Expand6(uint32_t code) { return (code << 2) | (code >> 4); }
+        uint32_t Expand7(uint32_t code) { return (code << 1) | (code >> 6); }
+
+        void QuantizeBc1(Endpoints& dst, const float (&endpoints)[2][NumChannels], uint32_t numChannels, uint32_t)
+        {
+            NEB_ASSERT(numChannels == 3, "BC1 endpoints are rgb");
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                for (uint32_t c = 0; c < numChannels; ++c)
+                {
+                    const bool isGreen = (c == 1);
+                    dst.Codes[e][c] = isGreen ? QuantizeChannel(endpoints[e][c], 63, Expand6) : QuantizeChannel(endpoints[e][c], 31, Expand5);
+                    dst.Values[e][c] = int32_t(isGreen ? Expand6(dst.Codes[e][c]) : Expand5(dst.Codes[e][c]));
+                }
+            }
+        }
+
+        void QuantizeBc4(Endpoints& dst, const float (&endpoints)[2][NumChannels], uint32_t numChannels, uint32_t)
+        {
+            NEB_ASSERT(numChannels == 1, "BC4 endpoints are single channel");
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                dst.Codes[e][0] = static_cast<uint32_t>(std::clamp(endpoints[e][0] + 0.5f, 0.0f, 255.0f));
+                dst.Values[e][0] = int32_t(dst.Codes[e][0]);
+            }
+        }
+
+        // Mode 6 endpoints are 7 bits per channel with a p-bit per endpoint, which is the lowest bit of every channel
+        void QuantizeBc7Mode6(Endpoints& dst, const float (&endpoints)[2][NumChannels], uint32_t numChannels, uint32_t pbits)
+        {
+            NEB_ASSERT(numChannels == 4, "BC7 mode 6 endpoints are rgba");
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                const uint32_t pbit = (pbits >> e) & 1;
+                auto expand = [pbit](uint32_t code) { return (code << 1) | pbit; };
+
+                dst.PBits[e] = pbit;
+                for (uint32_t c = 0; c < numChannels; ++c)
+                {
+                    dst.Codes[e][c] = QuantizeChannel(endpoints[e][c], 127, expand);
+                    dst.Values[e][c] = int32_t(expand(dst.Codes[e][c]));
+                }
+            }
+        }
+
+        // Mode 1 endpoints are 6 bits per channel with a p-bit shared by both endpoints of the subset
+        void QuantizeBc7Mode1(Endpoints& dst, const float (&endpoints)[2][NumChannels], uint32_t numChannels, uint32_t pbits)
+        {
+            NEB_ASSERT(numChannels == 3, "BC7 mode 1 endpoints are rgb");
+            const uint32_t pbit = pbits & 1;
+            auto expand = [pbit](uint32_t code) { return Expand7((code << 1) | pbit); };
+
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                dst.PBits[e] = pbit;
+                for (uint32_t c = 0; c < numChannels; ++c)
+                {
+                    dst.Codes[e][c] = QuantizeChannel(endpoints[e][c], 63, expand);
+                    dst.Values[e][c] = int32_t(expand(dst.Codes[e][c]));
+                }
+            }
+        }
+
+        static constexpr EndpointQuantizer Bc1Quantizer = { .NumPBitCombinations = 1, .Quantize = QuantizeBc1 };
+        static constexpr EndpointQuantizer Bc4Quantizer = { .NumPBitCombinations = 1, .Quantize = QuantizeBc4 };
+        static constexpr EndpointQuantizer Bc7Mode6Quantizer = { .NumPBitCombinations = 4, .Quantize = QuantizeBc7Mode6 };
+        static constexpr EndpointQuantizer Bc7Mode1Quantizer = { .NumPBitCombinations = 2, .Quantize = QuantizeBc7Mode1 };
+
+        int32_t Interpolate(int32_t e0, int32_t e1, uint32_t weight, uint32_t denominator)
+        {
+            return ((int32_t(denominator) - int32_t(weight)) * e0 + int32_t(weight) * e1 + int32_t(denominator / 2)) / int32_t(denominator);
+        }
+
+        void BuildPalette(Palette& dst, const PaletteDesc& desc, const Endpoints& endpoints, uint32_t numChannels)
+        {
+            dst.NumEntries = desc.NumEntries;
+            for (uint32_t i = 0; i < desc.NumEntries; ++i)
+            {
+                for (uint32_t c = 0; c < numChannels; ++c)
+                    dst.Entries[i][c] = float(Interpolate(endpoints.Values[0][c], endpoints.Values[1][c], desc.Weights[i], desc.Denominator));
+            }
+        }
+
+        // Closest palette entry of every texel of the block, with its squared distance. Ties go to the lower entry
+        void FindClosestEntries(uint8_t (&indices)[NumBlockTexels], float (&errors)[NumBlockTexels], const Block& block, const Palette& palette)
+        {
+            alignas(32) float lanes[SimdWidth];
+            alignas(32) float laneErrors[SimdWidth];
+            for (uint32_t t = 0; t < NumBlockTexels; t += SimdWidth)
+            {
+                FloatV texels[NumChannels];
+                for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                    texels[c] = LoadV(&block.Texels[c][t]);
+
+                FloatV bestError = SetV(FLT_MAX);
+                FloatV bestEntry = SetV(0.0f);
+                for (uint32_t i = 0; i < palette.NumEntries; ++i)
+                {
+                    FloatV error = SetV(0.0f);
+                    for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                    {
+                        const FloatV diff = SubV(texels[c], SetV(palette.Entries[i][c]));
+                        error = AddV(error, MulV(diff, diff));
+                    }
+
+                    const FloatV isCloser = LessV(error, bestError);
+                    bestError = SelectV(isCloser, error, bestError);
+                    bestEntry = SelectV(isCloser, SetV(float(i)), bestEntry);
+                }
+
+                StoreV(lanes, bestEntry);
+                StoreV(laneErrors, bestError);
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                {
+                    indices[t + lane] = static_cast<uint8_t>(lanes[lane]);
+                    errors[t + lane] = laneErrors[lane];
+                }
+            }
+        }
+
+        uint32_t CountTexels(uint16_t mask) { return static_cast<uint32_t>(std::popcount(mask)); }
+        bool HasTexel(uint16_t mask, uint32_t t) { return (mask >> t) & 1; }
+
+        struct TexelStatistics
+        {
+            float Mean[NumChannels] = {};
+            float Min[NumChannels] = {};
+            float Max[NumChannels] = {};
+            float Covariance[NumChannels][NumChannels] = {};
+        };
+
+        TexelStatistics ComputeStatistics(const Block& block, uint16_t mask)
+        {
+            TexelStatistics stats;
+            const uint32_t numTexels = CountTexels(mask);
+            for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+            {
+                stats.Min[c] = 255.0f;
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                {
+                    if (!HasTexel(mask, t))
+                        continue;
+
+                    stats.Mean[c] += block.Texels[c][t];
+                    stats.Min[c] = std::min(stats.Min[c], block.Texels[c][t]);
+                    stats.Max[c] = std::max(stats.Max[c], block.Texels[c][t]);
+                }
+                stats.Mean[c] /= float(numTexels);
+            }
+
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+            {
+                if (!HasTexel(mask, t))
+                    continue;
+
+                for (uint32_t i = 0; i < block.NumUsedChannels; ++i)
+                    for (uint32_t j = i; j < block.NumUsedChannels; ++j)
+                        stats.Covariance[i][j] += (block.Texels[i][t] - stats.Mean[i]) * (block.Texels[j][t] - stats.Mean[j]);
+            }
+
+            for (uint32_t i = 0; i < block.NumUsedChannels; ++i)
+                for (uint32_t j = 0; j < i; ++j)
+                    stats.Covariance[i][j] = stats.Covariance[j][i];
+
+            return stats;
+        }
+
+        // Starts from the bounding box diagonal, flipped along channels that are anticorrelated with the one of the largest variance
+        void GetDiagonalAxis(float (&axis)[NumChannels], const TexelStatistics& stats, uint32_t numChannels)
+        {
+            uint32_t reference = 0;
+            for (uint32_t c = 1; c < numChannels; ++c)
+                reference = (stats.Covariance[c][c] > stats.Covariance[reference][reference]) ? c : reference;
+
+            for (uint32_t c = 0; c < numChannels; ++c)
+                axis[c] = (stats.Covariance[reference][c] < 0.0f) ? stats.Min[c] - stats.Max[c] : stats.Max[c] - stats.Min[c];
+        }
+
+        // Returns the length of the vector before normalization, vectors of (nearly) zero length are left as is
+        float Normalize(float (&v)[NumChannels], uint32_t numChannels)
+        {
+            float length = 0.0f;
+            for (uint32_t c = 0; c < numChannels; ++c)
+                length += v[c] * v[c];
+
+            length = std::sqrt(length);
+            if (length <= FLT_EPSILON)
+                return 0.0f;
+
+            for (uint32_t c = 0; c < numChannels; ++c)
+                v[c] /= length;
+
+            return length;
+        }
+
+        // Principal axis of the covariance with power iteration starting from the given axis,
+        // returns its eigenvalue (0 for texels of a single color)
+        float GetPrincipalAxis(float (&axis)[NumChannels], const float (&covariance)[NumChannels][NumChannels], uint32_t numChannels, uint32_t numIterations)
+        {
+            if (Normalize(axis, numChannels) == 0.0f)
+                return 0.0f;
+
+            float eigenvalue = 0.0f;
+            for (uint32_t iteration = 0; iteration < numIterations; ++iteration)
+            {
+                float next[NumChannels] = {};
+                for (uint32_t i = 0; i < numChannels; ++i)
+                    for (uint32_t j = 0; j < numChannels; ++j)
+                        next[i] += covariance[i][j] * axis[j];
+
+                eigenvalue = Normalize(next, numChannels);
+                if (eigenvalue == 0.0f)
+                    return 0.0f;
+
+                std::memcpy(axis, next, sizeof(next));
+            }
+            return eigenvalue;
+        }
+
+        // Endpoints on a line through the texels of the mask. Fast quality takes the bounding box diagonal, inset a bit
+        // as extremes are rarely worth an endpoint, otherwise the line goes along the principal axis and is cut by the projections of the texels
+        void FitEndpoints(float (&dst)[2][NumChannels], const Block& block, uint16_t mask, bool usePrincipalAxis)
+        {
+            const TexelStatistics stats = ComputeStatistics(block, mask);
+            if (!usePrincipalAxis)
+            {
+                float axis[NumChannels];
+                GetDiagonalAxis(axis, stats, block.NumUsedChannels);
+                for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                {
+                    const float inset = (stats.Max[c] - stats.Min[c]) / 16.0f;
+                    const bool isFlipped = (axis[c] < 0.0f);
+                    dst[0][c] = isFlipped ? stats.Max[c] - inset : stats.Min[c] + inset;
+                    dst[1][c] = isFlipped ? stats.Min[c] + inset : stats.Max[c] - inset;
+                }
+                return;
+            }
+
+            float axis[NumChannels];
+            GetDiagonalAxis(axis, stats, block.NumUsedChannels);
+            if (GetPrincipalAxis(axis, stats.Covariance, block.NumUsedChannels, 8) == 0.0f)
+            {
+                for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                    dst[0][c] = dst[1][c] = stats.Mean[c];
+
+                return;
+            }
+
+            float minProjection = FLT_MAX;
+            float maxProjection = -FLT_MAX;
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+            {
+                if (!HasTexel(mask, t))
+                    continue;
+
+                float projection = 0.0f;
+                for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                    projection += (block.Texels[c][t] - stats.Mean[c]) * axis[c];
+
+                minProjection = std::min(minProjection, projection);
+                maxProjection = std::max(maxProjection, projection);
+            }
+
+            for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+            {
+                dst[0][c] = std::clamp(stats.Mean[c] + minProjection * axis[c], 0.0f, 255.0f);
+                dst[1][c] = std::clamp(stats.Mean[c] + maxProjection * axis[c], 0.0f, 255.0f);
+            }
+        }
+
+        // Least squares endpoints for the texels of the mask with their palette positions fixed.
+        // Returns false if every texel uses the same weight, in which case the system is degenerate
+        bool RefineEndpoints(float (&dst)[2][NumChannels], const Block& block, uint16_t mask, const uint8_t (&indices)[NumBlockTexels], const PaletteDesc& desc)
+        {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float ax[NumChannels] = {};
+            float bx[NumChannels] = {};
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+            {
+                if (!HasTexel(mask, t))
+                    continue;
+
+                const float b = float(desc.Weights[indices[t]]) / float(desc.Denominator);
+                const float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                {
+                    ax[c] += a * block.Texels[c][t];
+                    bx[c] += b * block.Texels[c][t];
+                }
+            }
+
+            const float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) <= 1e-4f)
+                return false;
+
+            for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+            {
+                dst[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+                dst[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+            }
+            return true;
+        }
+
+        struct SubsetFit
+        {
+            Endpoints Quantized;
+            uint8_t Indices[NumBlockTexels] = {}; // palette positions, only texels of the subset are meaningful
+            float Error = FLT_MAX;
+        };
+
+        // P-bit combinations are either all tried, or only the one that rounds the endpoints best is
+        void EvaluateEndpoints(SubsetFit& best, const Block& block, uint16_t mask, const float (&endpoints)[2][NumChannels],
+            const PaletteDesc& desc, const EndpointQuantizer& quantizer, bool tryEveryPBitCombination)
+        {
+            uint32_t firstPBits = 0;
+            uint32_t endPBits = quantizer.NumPBitCombinations;
+            if (!tryEveryPBitCombination && quantizer.NumPBitCombinations > 1)
+            {
+                float bestRoundingError = FLT_MAX;
+                for (uint32_t pbits = 0; pbits < quantizer.NumPBitCombinations; ++pbits)
+                {
+                    Endpoints quantized;
+                    quantizer.Quantize(quantized, endpoints, block.NumUsedChannels, pbits);
+
+                    float roundingError = 0.0f;
+                    for (uint32_t e = 0; e < 2; ++e)
+                        for (uint32_t c = 0; c < block.NumUsedChannels; ++c)
+                            roundingError += (float(quantized.Values[e][c]) - endpoints[e][c]) * (float(quantized.Values[e][c]) - endpoints[e][c]);
+
+                    if (roundingError < bestRoundingError)
+                    {
+                        firstPBits = pbits;
+                        bestRoundingError = roundingError;
+                    }
+                }
+                endPBits = firstPBits + 1;
+            }
+
+            for (uint32_t pbits = firstPBits; pbits < endPBits; ++pbits)
+            {
+                Endpoints quantized;
+                quantizer.Quantize(quantized, endpoints, block.NumUsedChannels, pbits);
+
+                Palette palette;
+                BuildPalette(palette, desc, quantized, block.NumUsedChannels);
+
+                uint8_t indices[NumBlockTexels];
+                float errors[NumBlockTexels];
+                FindClosestEntries(indices, errors, block, palette);
+
+                float error = 0.0f;
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                    error += HasTexel(mask, t) ? errors[t] : 0.0f;
+
+                if (error < best.Error)
+                {
+                    best.Quantized = quantized;
+                    std::memcpy(best.Indices, indices, sizeof(indices));
+                    best.Error = error;
+                }
+            }
+        }
+
+        SubsetFit FitSubset(const Block& block, uint16_t mask, const PaletteDesc& desc, const EndpointQuantizer& quantizer, ETextureCompressionQuality quality)
+        {
+            float endpoints[2][NumChannels];
+            FitEndpoints(endpoints, block, mask, quality != eTextureCompressionQuality_Fast);
+
+            const bool tryEveryPBitCombination = (quality == eTextureCompressionQuality_High);
+
+            SubsetFit best;
+            EvaluateEndpoints(best, block, mask, endpoints, desc, quantizer, tryEveryPBitCombination);
+            for (uint32_t i = 0; i < NumRefinements[quality] && best.Error > 0.0f; ++i)
+            {
+                const float error = best.Error;
+                if (!RefineEndpoints(endpoints, block, mask, best.Indices, desc))
+                    break;
+
+                EvaluateEndpoints(best, block, mask, endpoints, desc, quantizer, tryEveryPBitCombination);
+                if (best.Error >= error)
+                    break;
+            }
+            return best;
+        }
+
+        // Swaps endpoints of the subset, positions are mirrored so that the decoded texels stay the same
+        void SwapEndpoints(SubsetFit& fit, uint16_t mask, uint32_t numPositions)
+        {
+            std::swap(fit.Quantized.Codes[0], fit.Quantized.Codes[1]);
+            std::swap(fit.Quantized.Values[0], fit.Quantized.Values[1]);
+            std::swap(fit.Quantized.PBits[0], fit.Quantized.PBits[1]);
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                fit.Indices[t] = HasTexel(mask, t) ? static_cast<uint8_t>(numPositions - 1 - fit.Indices[t]) : fit.Indices[t];
+        }
+
+        void LoadBlock(Block& dst, const TextureLevelDesc& src, uint32_t blockX, uint32_t blockY, const uint32_t* channels, uint32_t numChannels)
+        {
+            dst.NumUsedChannels = numChannels;
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                const uint32_t srcY = std::min(blockY * 4 + y, src.Height - 1);
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint32_t srcX = std::min(blockX * 4 + x, src.Width - 1);
+                    const std::byte* texel = src.Texels + (size_t(srcY) * src.Width + srcX) * NumChannels;
+                    for (uint32_t c = 0; c < numChannels; ++c)
+                        dst.Texels[c][y * 4 + x] = float(static_cast<uint8_t>(texel[channels[c]]));
+                }
+            }
+        }
+
+        void EncodeBc1Block(std::byte* dst, const Block& block, ETextureCompressionQuality quality)
+        {
+            SubsetFit fit = FitSubset(block, AllBlockTexels, Bc1Palette, Bc1Quantizer, quality);
+
+            // 4-color mode requires color0 > color1, the 3-color one would decode the last code as black
+            auto pack565 = [](const uint32_t (&codes)[NumChannels]) { return uint16_t((codes[0] << 11) | (codes[1] << 5) | codes[2]); };
+            if (pack565(fit.Quantized.Codes[0]) < pack565(fit.Quantized.Codes[1]))
+                SwapEndpoints(fit, AllBlockTexels, 4);
+
+            const uint16_t colors[2] = { pack565(fit.Quantized.Codes[0]), pack565(fit.Quantized.Codes[1]) };
+            uint32_t indices = 0;
+            if (colors[0] != colors[1])
+            {
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                    indices |= uint32_t(Bc1PositionToCode[fit.Indices[t]]) << (t * 2);
+            }
+
+            std::memcpy(dst, colors, sizeof(colors));
+            std::memcpy(dst + sizeof(colors), &indices, sizeof(indices));
+        }
+
+        void EncodeBc4Block(std::byte* dst, const Block& block, ETextureCompressionQuality quality)
+        {
+            SubsetFit fit = FitSubset(block, AllBlockTexels, Bc4Palette, Bc4Quantizer, quality);
+
+            // 8-value mode requires red0 > red1, the 6-value one interpolates differently
+            if (fit.Quantized.Codes[0][0] < fit.Quantized.Codes[1][0])
+                SwapEndpoints(fit, AllBlockTexels, 8);
+
+            uint64_t bits = uint64_t(fit.Quantized.Codes[0][0]) | (uint64_t(fit.Quantized.Codes[1][0]) << 8);
+            if (fit.Quantized.Codes[0][0] != fit.Quantized.Codes[1][0])
+            {
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                    bits |= uint64_t(Bc4PositionToCode[fit.Indices[t]]) << (16 + t * 3);
+            }
+            std::memcpy(dst, &bits, sizeof(bits));
+        }
+
+        // BC7 blocks are a single 128-bit little endian value, fields are written from the lowest bit
+        struct BitWriter
+        {
+            uint64_t Bits[2] = {};
+            uint32_t Offset = 0;
+
+            void Write(uint32_t value, uint32_t numBits)
+            {
+                NEB_ASSERT(Offset + numBits <= 128 && (numBits == 32 || (value >> numBits) == 0), "BC7 field overflow");
+                if (Offset < 64)
+                {
+                    Bits[0] |= uint64_t(value) << Offset;
+                    if (Offset + numBits > 64)
+                        Bits[1] |= uint64_t(value) >> (64 - Offset);
+                }
+                else
+                {
+                    Bits[1] |= uint64_t(value) << (Offset - 64);
+                }
+                Offset += numBits;
+            }
+        };
+
+        struct BitReader
+        {
+            uint64_t Bits[2] = {};
+            uint32_t Offset = 0;
+
+            uint32_t Read(uint32_t numBits)
+            {
+                uint32_t value = 0;
+                for (uint32_t i = 0; i < numBits; ++i, ++Offset)
+                    value |= uint32_t((Bits[Offset / 64] >> (Offset % 64)) & 1) << i;
+
+                return value;
+            }
+        };
+
+        // Mode 6: 7-bit rgba endpoints with a p-bit per endpoint, a single subset with 4-bit indices
+        void WriteBc7Mode6(std::byte* dst, SubsetFit fit)
+        {
+            // Highest index bit of the anchor texel is implicitly 0
+            if (fit.Indices[0] >= 8)
+                SwapEndpoints(fit, AllBlockTexels, 16);
+
+            BitWriter writer;
+            writer.Write(1u << 6, 7);
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                writer.Write(fit.Quantized.Codes[0][c], 7);
+                writer.Write(fit.Quantized.Codes[1][c], 7);
+            }
+            writer.Write(fit.Quantized.PBits[0], 1);
+            writer.Write(fit.Quantized.PBits[1], 1);
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                writer.Write(fit.Indices[t], (t == 0) ? 3 : 4);
+
+            NEB_ASSERT(writer.Offset == 128, "BC7 mode 6 block should be 128 bits");
+            std::memcpy(dst, writer.Bits, sizeof(writer.Bits));
+        }
+
+        // Mode 1: 6-bit rgb endpoints with a p-bit per subset, 2 subsets with 3-bit indices
+        void WriteBc7Mode1(std::byte* dst, uint32_t partition, SubsetFit (&subsets)[2])
+        {
+            const uint16_t masks[2] = { uint16_t(~Bc7Partitions2[partition]), Bc7Partitions2[partition] };
+            const uint32_t anchors[2] = { 0, Bc7Anchors2[partition] };
+            for (uint32_t s = 0; s < 2; ++s)
+            {
+                if (subsets[s].Indices[anchors[s]] >= 4)
+                    SwapEndpoints(subsets[s], masks[s], 8);
+            }
+
+            BitWriter writer;
+            writer.Write(1u << 1, 2);
+            writer.Write(partition, 6);
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                for (uint32_t s = 0; s < 2; ++s)
+                {
+                    writer.Write(subsets[s].Quantized.Codes[0][c], 6);
+                    writer.Write(subsets[s].Quantized.Codes[1][c], 6);
+                }
+            }
+            writer.Write(subsets[0].Quantized.PBits[0], 1);
+            writer.Write(subsets[1].Quantized.PBits[0], 1);
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+            {
+                const uint32_t s = HasTexel(masks[1], t) ? 1 : 0;
+                writer.Write(subsets[s].Indices[t], (t == anchors[s]) ? 2 : 3);
+            }
+
+            NEB_ASSERT(writer.Offset == 128, "BC7 mode 1 block should be 128 bits");
+            std::memcpy(dst, writer.Bits, sizeof(writer.Bits));
+        }
+
+        // Errors left after projecting the texels of both subsets of every partition onto their principal axes. Cheap estimate
+        // of mode 1 fits (quantization is not accounted for). Moments of the subsets are summed from the moments of every subset
+        // of every row of the block, as a partition mask is just 4 row masks
+        void EstimatePartitionErrors(float (&errors)[64], const Block& block)
+        {
+            static constexpr uint32_t NumMoments = 10; // count, 3 sums and 6 products of rgb
+            float rowMoments[4][16][NumMoments] = {};
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    const uint32_t t = y * 4 + x;
+                    const float r = block.Texels[0][t], g = block.Texels[1][t], b = block.Texels[2][t];
+                    const float moments[NumMoments] = { 1.0f, r, g, b, r * r, r * g, r * b, g * g, g * b, b * b };
+
+                    // Every row subset with the texel is a subset without it (already summed) plus the texel
+                    const uint32_t bit = 1u << x;
+                    for (uint32_t rowMask = bit; rowMask < (bit << 1); ++rowMask)
+                        for (uint32_t m = 0; m < NumMoments; ++m)
+                            rowMoments[y][rowMask][m] = rowMoments[y][rowMask & ~bit][m] + moments[m];
+                }
+            }
+
+            auto estimateSubsetError = [](const float (&moments)[NumMoments]) -> float
+                {
+                    if (moments[0] == 0.0f)
+                        return 0.0f;
+
+                    const float* sums = &moments[1];
+                    const float* products = &moments[4];
+                    const float covariance[NumChannels][NumChannels] = {
+                        { products[0] - sums[0] * sums[0] / moments[0], products[1] - sums[0] * sums[1] / moments[0], products[2] - sums[0] * sums[2] / moments[0] },
+                        { products[1] - sums[0] * sums[1] / moments[0], products[3] - sums[1] * sums[1] / moments[0], products[4] - sums[1] * sums[2] / moments[0] },
+                        { products[2] - sums[0] * sums[2] / moments[0], products[4] - sums[1] * sums[2] / moments[0], products[5] - sums[2] * sums[2] / moments[0] },
+                    };
+
+                    // Column of the largest variance is a good start for the power iteration
+                    uint32_t start = 0;
+                    for (uint32_t c = 1; c < 3; ++c)
+                        start = (covariance[c][c] > covariance[start][start]) ? c : start;
+
+                    float axis[NumChannels] = { covariance[0][start], covariance[1][start], covariance[2][start] };
+                    const float variance = covariance[0][0] + covariance[1][1] + covariance[2][2];
+                    return variance - GetPrincipalAxis(axis, covariance, 3, 3);
+                };
+
+            for (uint32_t partition = 0; partition < 64; ++partition)
+            {
+                float moments[2][NumMoments] = {};
+                for (uint32_t y = 0; y < 4; ++y)
+                {
+                    const uint32_t rowMask = (Bc7Partitions2[partition] >> (y * 4)) & 0xf;
+                    for (uint32_t m = 0; m < NumMoments; ++m)
+                    {
+                        moments[0][m] += rowMoments[y][rowMask ^ 0xf][m];
+                        moments[1][m] += rowMoments[y][rowMask][m];
+                    }
+                }
+
+                errors[partition] = estimateSubsetError(moments[0]) + estimateSubsetError(moments[1]);
+            }
+        }
+
+        void EncodeBc7Block(std::byte* dst, const Block& block, ETextureCompressionQuality quality)
+        {
+            const SubsetFit mode6 = FitSubset(block, AllBlockTexels, Bc7Palette4, Bc7Mode6Quantizer, quality);
+
+            bool isOpaque = true;
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                isOpaque &= (block.Texels[3][t] == 255.0f);
+
+            if (quality == eTextureCompressionQuality_High && isOpaque && mode6.Error > 0.0f)
+            {
+                Block rgb = block;
+                rgb.NumUsedChannels = 3;
+
+                // Only the partitions of the best estimates are encoded
+                uint32_t candidates[NumPartitionCandidates];
+                float candidateErrors[NumPartitionCandidates];
+                std::fill(std::begin(candidateErrors), std::end(candidateErrors), FLT_MAX);
+
+                float estimates[64];
+                EstimatePartitionErrors(estimates, rgb);
+                for (uint32_t partition = 0; partition < 64; ++partition)
+                {
+                    float error = estimates[partition];
+                    uint32_t candidate = partition;
+                    for (uint32_t i = 0; i < NumPartitionCandidates; ++i)
+                    {
+                        if (error < candidateErrors[i])
+                        {
+                            std::swap(error, candidateErrors[i]);
+                            std::swap(candidate, candidates[i]);
+                        }
+                    }
+                }
+
+                // Candidates are compared with quicker fits, only the best one is refined at full quality
+                uint32_t bestPartition = candidates[0];
+                float bestCandidateError = FLT_MAX;
+                for (uint32_t i = 0; i < NumPartitionCandidates; ++i)
+                {
+                    const uint16_t mask = Bc7Partitions2[candidates[i]];
+                    const float error = FitSubset(rgb, uint16_t(~mask), Bc7Palette3, Bc7Mode1Quantizer, eTextureCompressionQuality_Normal).Error +
+                        FitSubset(rgb, mask, Bc7Palette3, Bc7Mode1Quantizer, eTextureCompressionQuality_Normal).Error;
+
+                    if (error < bestCandidateError)
+                    {
+                        bestPartition = candidates[i];
+                        bestCandidateError = error;
+                    }
+                }
+
+                const uint16_t mask = Bc7Partitions2[bestPartition];
+                SubsetFit bestSubsets[2] = {
+                    FitSubset(rgb, uint16_t(~mask), Bc7Palette3, Bc7Mode1Quantizer, quality),
+                    FitSubset(rgb, mask, Bc7Palette3, Bc7Mode1Quantizer, quality),
+                };
+
+                const float bestError = bestSubsets[0].Error + bestSubsets[1].Error;
+                if (bestError < mode6.Error)
+                {
+                    WriteBc7Mode1(dst, bestPartition, bestSubsets);
+                    return;
+                }
+            }
+
+            WriteBc7Mode6(dst, mode6);
+        }
+
+        void EncodeBlock(std::byte* dst, const TextureLevelDesc& src, uint32_t blockX, uint32_t blockY, const TextureCompressionSourceDesc& desc, ETextureCompressionQuality quality)
+        {
+            static constexpr uint32_t RgbaChannels[NumChannels] = { 0, 1, 2, 3 };
+
+            Block block;
+            switch (desc.Format)
+            {
+            case eTextureBlockFormat_BC1:
+                LoadBlock(block, src, blockX, blockY, RgbaChannels, 3);
+                EncodeBc1Block(dst, block, quality);
+                break;
+            case eTextureBlockFormat_BC4:
+                LoadBlock(block, src, blockX, blockY, &desc.Channels[0], 1);
+                EncodeBc4Block(dst, block, quality);
+                break;
+            case eTextureBlockFormat_BC5:
+                LoadBlock(block, src, blockX, blockY, &desc.Channels[0], 1);
+                EncodeBc4Block(dst, block, quality);
+                LoadBlock(block, src, blockX, blockY, &desc.Channels[1], 1);
+                EncodeBc4Block(dst + 8, block, quality);
+                break;
+            case eTextureBlockFormat_BC7:
+                LoadBlock(block, src, blockX, blockY, RgbaChannels, 4);
+                EncodeBc7Block(dst, block, quality);
+                break;
+            default:
+                NEB_ASSERT(false, "Unknown block format {}", uint32_t(desc.Format));
+                break;
+            }
+        }
+
+        using DecodedBlock = uint8_t[NumBlockTexels][NumChannels];
+
+        void DecodeBc1Block(DecodedBlock& dst, const std::byte* src)
+        {
+            uint16_t colors[2];
+            uint32_t indices;
+            std::memcpy(colors, src, sizeof(colors));
+            std::memcpy(&indices, src + sizeof(colors), sizeof(indices));
+
+            int32_t palette[4][NumChannels];
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                palette[e][0] = int32_t(Expand5((colors[e] >> 11) & 31));
+                palette[e][1] = int32_t(Expand6((colors[e] >> 5) & 63));
+                palette[e][2] = int32_t(Expand5(colors[e] & 31));
+                palette[e][3] = 255;
+            }
+
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                if (colors[0] > colors[1])
+                {
+                    palette[2][c] = Interpolate(palette[0][c], palette[1][c], 1, 3);
+                    palette[3][c] = Interpolate(palette[0][c], palette[1][c], 2, 3);
+                }
+                else
+                {
+                    palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                    palette[3][c] = 0;
+                }
+            }
+            palette[2][3] = 255;
+            palette[3][3] = (colors[0] > colors[1]) ? 255 : 0;
+
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                for (uint32_t c = 0; c < NumChannels; ++c)
+                    dst[t][c] = static_cast<uint8_t>(palette[(indices >> (t * 2)) & 3][c]);
+        }
+
+        void DecodeBc4Block(DecodedBlock& dst, const std::byte* src, uint32_t channel)
+        {
+            uint64_t bits;
+            std::memcpy(&bits, src, sizeof(bits));
+
+            const int32_t red0 = int32_t(bits & 0xff);
+            const int32_t red1 = int32_t((bits >> 8) & 0xff);
+            int32_t palette[8] = { red0, red1 };
+            for (uint32_t code = 2; code < 8; ++code)
+            {
+                if (red0 > red1)
+                    palette[code] = Interpolate(red0, red1, code - 1, 7);
+                else
+                    palette[code] = (code < 6) ? Interpolate(red0, red1, code - 1, 5) : (code == 6 ? 0 : 255);
+            }
+
+            for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                dst[t][channel] = static_cast<uint8_t>(palette[(bits >> (16 + t * 3)) & 7]);
+        }
+
+        void DecodeBc7Block(DecodedBlock& dst, const std::byte* src)
+        {
+            BitReader reader;
+            std::memcpy(reader.Bits, src, sizeof(reader.Bits));
+
+            uint32_t mode = 0;
+            while (mode < 8 && reader.Read(1) == 0)
+                ++mode;
+
+            if (mode == 6)
+            {
+                int32_t endpoints[2][NumChannels];
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    endpoints[0][c] = int32_t(reader.Read(7));
+                    endpoints[1][c] = int32_t(reader.Read(7));
+                }
+                for (uint32_t e = 0; e < 2; ++e)
+                {
+                    const int32_t pbit = int32_t(reader.Read(1));
+                    for (uint32_t c = 0; c < 4; ++c)
+                        endpoints[e][c] = (endpoints[e][c] << 1) | pbit;
+                }
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                {
+                    const uint32_t index = reader.Read((t == 0) ? 3 : 4);
+                    for (uint32_t c = 0; c < 4; ++c)
+                        dst[t][c] = static_cast<uint8_t>(Interpolate(endpoints[0][c], endpoints[1][c], Bc7Weights4[index], 64));
+                }
+                return;
+            }
+
+            if (mode == 1)
+            {
+                const uint32_t partition = reader.Read(6);
+                int32_t endpoints[2][2][NumChannels];
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    for (uint32_t s = 0; s < 2; ++s)
+                    {
+                        endpoints[s][0][c] = int32_t(reader.Read(6));
+                        endpoints[s][1][c] = int32_t(reader.Read(6));
+                    }
+                }
+                for (uint32_t s = 0; s < 2; ++s)
+                {
+                    const uint32_t pbit = reader.Read(1);
+                    for (uint32_t e = 0; e < 2; ++e)
+                        for (uint32_t c = 0; c < 3; ++c)
+                            endpoints[s][e][c] = int32_t(Expand7((uint32_t(endpoints[s][e][c]) << 1) | pbit));
+                }
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                {
+                    const uint32_t s = (Bc7Partitions2[partition] >> t) & 1;
+                    const bool isAnchor = (t == 0) || (t == Bc7Anchors2[partition]);
+                    const uint32_t index = reader.Read(isAnchor ? 2 : 3);
+                    for (uint32_t c = 0; c < 3; ++c)
+                        dst[t][c] = static_cast<uint8_t>(Interpolate(endpoints[s][0][c], endpoints[s][1][c], Bc7Weights3[index], 64));
+                    dst[t][3] = 255;
+                }
+                return;
+            }
+
+            NEB_ASSERT(false, "BC7 mode {} is not supported by the decoder", mode);
+            std::memset(dst, 0, sizeof(DecodedBlock));
+        }
+
+        void DecodeBlock(DecodedBlock& dst, const std::byte* src, ETextureBlockFormat format)
+        {
+            switch (format)
+            {
+            case eTextureBlockFormat_BC1:
+                DecodeBc1Block(dst, src);
+                break;
+            case eTextureBlockFormat_BC4:
+            case eTextureBlockFormat_BC5:
+                for (uint32_t t = 0; t < NumBlockTexels; ++t)
+                {
+                    dst[t][0] = dst[t][1] = dst[t][2] = 0;
+                    dst[t][3] = 255;
+                }
+                DecodeBc4Block(dst, src, 0);
+                if (format == eTextureBlockFormat_BC5)
+                    DecodeBc4Block(dst, src + 8, 1);
+                break;
+            case eTextureBlockFormat_BC7:
+                DecodeBc7Block(dst, src);
+                break;
+            default:
+                NEB_ASSERT(false, "Unknown block format {}", uint32_t(format));
+                break;
+            }
+        }
+
+        void AllocateCompressedTexture(CompressedTexture& dst, const TextureCompressionSourceDesc& src)
+        {
+            dst = CompressedTexture();
+            dst.Format = src.Format;
+            dst.Levels.resize(src.Levels.size());
+
+            const size_t blockSize = GetBlockSize(src.Format);
+            size_t numBytes = 0;
+            for (size_t i = 0; i < src.Levels.size(); ++i)
+            {
+                const TextureLevelDesc& level = src.Levels[i];
+                dst.Levels[i] = CompressedTextureLevel{
+                    .Width = level.Width,
+                    .Height = level.Height,
+                    .NumBlocksX = (level.Width + 3) / 4,
+                    .NumBlocksY = (level.Height + 3) / 4,
+                    .Offset = numBytes,
+                };
+                numBytes += blockSize * dst.Levels[i].NumBlocksX * dst.Levels[i].NumBlocksY;
+            }
+            dst.Blocks.resize(numBytes);
+        }
+
+        void CompressBlockRows(CompressedTexture& dst, const TextureCompressionSourceDesc& src, uint32_t level, uint32_t rowBegin, uint32_t rowEnd, ETextureCompressionQuality quality)
+        {
+            const CompressedTextureLevel& dstLevel = dst.Levels[level];
+            const size_t blockSize = GetBlockSize(src.Format);
+            for (uint32_t y = rowBegin; y < rowEnd; ++y)
+            {
+                std::byte* row = dst.Blocks.data() + dstLevel.Offset + blockSize * dstLevel.NumBlocksX * y;
+                for (uint32_t x = 0; x < dstLevel.NumBlocksX; ++x)
+                    EncodeBlock(row + blockSize * x, src.Levels[level], x, y, src, quality);
+            }
+        }
+    } // anonymous namespace
+
+    uint32_t GetBlockSize(ETextureBlockFormat format)
+    {
+        return (format == eTextureBlockFormat_BC1 || format == eTextureBlockFormat_BC4) ? 8 : 16;
+    }
+
+    void CompressTexture(CompressedTexture& dst, const TextureCompressionSourceDesc& src, ETextureCompressionQuality quality)
+    {
+        NEB_ASSERT(src.Format < eTextureBlockFormat_NumFormats, "Unknown block format {}", uint32_t(src.Format));
+        NEB_ASSERT(quality < eTextureCompressionQuality_NumQualities, "Unknown compression quality {}", uint32_t(quality));
+
+        AllocateCompressedTexture(dst, src);
+        for (uint32_t level = 0; level < static_cast<uint32_t>(dst.Levels.size()); ++level)
+            CompressBlockRows(dst, src, level, 0, dst.Levels[level].NumBlocksY, quality);
+    }
+
+    void CompressTextures(std::span<CompressedTexture> dst, std::span<const TextureCompressionSourceDesc> srcs, ETextureCompressionQuality quality, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(dst.size() == srcs.size(), "Each source should have its own compressed texture");
+        NEB_ASSERT(quality < eTextureCompressionQuality_NumQualities, "Unknown compression quality {}", uint32_t(quality));
+
+        // Every level has its own source, block rows of any level are independent
+        struct RowJob
+        {
+            uint32_t Texture;
+            uint32_t Level;
+            uint32_t RowBegin;
+            uint32_t RowEnd;
+        };
+        std::vector<RowJob> jobs;
+        for (uint32_t i = 0; i < static_cast<uint32_t>(dst.size()); ++i)
+        {
+            AllocateCompressedTexture(dst[i], srcs[i]);
+            for (uint32_t level = 0; level < static_cast<uint32_t>(dst[i].Levels.size()); ++level)
+            {
+                const CompressedTextureLevel& dstLevel = dst[i].Levels[level];
+                const uint32_t numRowsPerJob = std::max(NumBlocksPerJob / std::max(dstLevel.NumBlocksX, 1u), 1u);
+                for (uint32_t row = 0; row < dstLevel.NumBlocksY; row += numRowsPerJob)
+                    jobs.push_back(RowJob{ .Texture = i, .Level = level, .RowBegin = row, .RowEnd = std::min(row + numRowsPerJob, dstLevel.NumBlocksY) });
+            }
+        }
+
+        threadPool.ParallelFor(jobs.size(), [&dst, &srcs, &jobs, quality](size_t j)
+            {
+                const RowJob& job = jobs[j];
+                CompressBlockRows(dst[job.Texture], srcs[job.Texture], job.Level, job.RowBegin, job.RowEnd, quality);
+            });
+    }
+
+    void DecompressTextureLevel(std::byte* dst, const CompressedTexture& src, uint32_t level)
+    {
+        const CompressedTextureLevel& srcLevel = src.Levels[level];
+        const size_t blockSize = GetBlockSize(src.Format);
+        for (uint32_t blockY = 0; blockY < srcLevel.NumBlocksY; ++blockY)
+        {
+            for (uint32_t blockX = 0; blockX < srcLevel.NumBlocksX; ++blockX)
+            {
+                DecodedBlock block;
+                DecodeBlock(block, src.Blocks.data() + srcLevel.Offset + blockSize * (size_t(blockY) * srcLevel.NumBlocksX + blockX), src.Format);
+
+                // Texels outside of the level are dropped
+                for (uint32_t y = 0; y < 4 && blockY * 4 + y < srcLevel.Height; ++y)
+                    for (uint32_t x = 0; x < 4 && blockX * 4 + x < srcLevel.Width; ++x)
+                        std::memcpy(dst + ((size_t(blockY) * 4 + y) * srcLevel.Width + blockX * 4 + x) * NumChannels, block[y * 4 + x], NumChannels);
+            }
+        }
+    }
+
+    TextureCompressionError MeasureTextureCompressionError(const CompressedTexture& compressed, const TextureCompressionSourceDesc& src)
+    {
+        NEB_ASSERT(compressed.Levels.size() == src.Levels.size(), "Compressed texture should have every level of the source");
+
+        // Decoded channels and the source channels they are compared against
+        uint32_t numChannels = 0;
+        uint32_t srcChannels[NumChannels] = { 0, 1, 2, 3 };
+        switch (compressed.Format)
+        {
+        case eTextureBlockFormat_BC1: numChannels = 3; break;
+        case eTextureBlockFormat_BC4: numChannels = 1; srcChannels[0] = src.Channels[0]; break;
+        case eTextureBlockFormat_BC5: numChannels = 2; srcChannels[0] = src.Channels[0]; srcChannels[1] = src.Channels[1]; break;
+        case eTextureBlockFormat_BC7: numChannels = 4; break;
+        default: break;
+        }
+
+        TextureCompressionError error;
+        uint64_t squaredError = 0;
+        std::vector<std::byte> decoded;
+        for (uint32_t level = 0; level < static_cast<uint32_t>(compressed.Levels.size()); ++level)
+        {
+            const TextureLevelDesc& srcLevel = src.Levels[level];
+            const size_t numTexels = size_t(srcLevel.Width) * srcLevel.Height;
+            decoded.resize(numTexels * NumChannels);
+            DecompressTextureLevel(decoded.data(), compressed, level);
+
+            for (size_t t = 0; t < numTexels; ++t)
+            {
+                for (uint32_t c = 0; c < numChannels; ++c)
+                {
+                    const int32_t expected = static_cast<uint8_t>(srcLevel.Texels[t * NumChannels + srcChannels[c]]);
+                    const int32_t actual = static_cast<uint8_t>(decoded[t * NumChannels + c]);
+                    const uint32_t diff = static_cast<uint32_t>(std::abs(expected - actual));
+                    error.MaxError = std::max(error.MaxError, diff);
+                    squaredError += uint64_t(diff) * diff;
+                }
+            }
+            error.NumTexels += numTexels;
+        }
+
+        const double numSamples = double(error.NumTexels) * numChannels;
+        error.Psnr = (squaredError == 0) ? std::numeric_limits<double>::infinity() : 10.0 * std::log10(255.0 * 255.0 * numSamples / double(squaredError));
+        return error;
+    }
+
+    bool IsTextureCompressionErrorAcceptable(const TextureCompressionError& error, ETextureBlockFormat format)
+    {
+        // BC1 has the fewest bits per channel, single and two channel formats interpolate 8-bit endpoints with 8 values
+        static constexpr double MinPsnr[eTextureBlockFormat_NumFormats] = { 28.0, 34.0, 34.0, 32.0 };
+        return error.NumTexels == 0 || error.Psnr >= MinPsnr[format];
+    }
+
+} // Neb namespace
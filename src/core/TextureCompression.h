@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Block formats are the same as their DXGI_FORMAT_BCn_UNORM counterparts, every block covers 4x4 texels
+    enum ETextureBlockFormat
+    {
+        eTextureBlockFormat_BC1 = 0, // rgb with 565 endpoints, 8 bytes per block, alpha is dropped
+        eTextureBlockFormat_BC4,     // single channel, 8 bytes per block
+        eTextureBlockFormat_BC5,     // two channels, 16 bytes per block
+        eTextureBlockFormat_BC7,     // rgba, 16 bytes per block. Only modes 6 and 1 are used
+        eTextureBlockFormat_NumFormats,
+    };
+
+    enum ETextureCompressionQuality
+    {
+        eTextureCompressionQuality_Fast = 0, // bounding box endpoints, no refinement
+        eTextureCompressionQuality_Normal,   // principal axis endpoints, refined once with least squares
+        eTextureCompressionQuality_High,     // more refinement, BC7 also tries 2-subset partitions (mode 1) on opaque blocks
+        eTextureCompressionQuality_NumQualities,
+    };
+
+    // Single level of the source, rows are tightly packed RGBA8
+    struct TextureLevelDesc
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        const std::byte* Texels = nullptr;
+    };
+
+    struct TextureCompressionSourceDesc
+    {
+        ETextureBlockFormat Format = eTextureBlockFormat_BC7;
+        uint32_t Channels[2] = { 0, 1 }; // source channels stored in the red and green channels of BC4/BC5
+        std::span<const TextureLevelDesc> Levels;
+    };
+
+    struct CompressedTextureLevel
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        uint32_t NumBlocksX = 0;
+        uint32_t NumBlocksY = 0;
+        size_t Offset = 0; // in bytes, into CompressedTexture::Blocks
+    };
+
+    // Block rows of every level are tightly packed, texels outside of the level (for levels that are not a multiple of 4)
+    // replicate the edge ones
+    struct CompressedTexture
+    {
+        ETextureBlockFormat Format = eTextureBlockFormat_BC7;
+        std::vector<CompressedTextureLevel> Levels;
+        std::vector<std::byte> Blocks;
+    };
+
+    uint32_t GetBlockSize(ETextureBlockFormat format);
+
+    // Endpoints are fitted per block (or per subset of BC7 mode 1), texels are then assigned to the closest palette entries.
+    // The closest entry search is vectorized with SSE (or AVX2 if the build targets it), distances are exact integers
+    // in both paths, thus results do not depend on the vector width
+    void CompressTexture(CompressedTexture& dst, const TextureCompressionSourceDesc& src, ETextureCompressionQuality quality);
+
+    // Compresses every source on the thread pool. Levels do not depend on each other, so block rows of every level
+    // of every source are split between threads at once. dst and srcs are expected to be of the same size
+    void CompressTextures(std::span<CompressedTexture> dst, std::span<const TextureCompressionSourceDesc> srcs, ETextureCompressionQuality quality, ThreadPool& threadPool);
+
+    // Decodes a level to tightly packed RGBA8. BC4/BC5 decode to red (and green), missing channels are 0 and alpha is 255.
+    // Only BC7 modes written by the encoder are supported
+    void DecompressTextureLevel(std::byte* dst, const CompressedTexture& src, uint32_t level);
+
+    struct TextureCompressionError
+    {
+        double Psnr = 0.0;    // in dB, over the channels stored by the format of every level, infinity if lossless
+        uint32_t MaxError = 0; // in 8-bit codes
+        uint64_t NumTexels = 0;
+    };
+
+    // Decodes every level and compares it to the source
+    TextureCompressionError MeasureTextureCompressionError(const CompressedTexture& compressed, const TextureCompressionSourceDesc& src);
+
+    // Bounds are set well below what natural textures get, so that only broken encodes (or noise-like sources) fail
+    bool IsTextureCompressionErrorAcceptable(const TextureCompressionError& error, ETextureBlockFormat format);
+
+} // Neb namespace
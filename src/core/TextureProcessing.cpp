@@ -0,0 +1,544 @@
+#include "TextureProcessing.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace Neb
+{
+
+    namespace
+    {
+        static constexpr uint32_t NumChannels = 4;
+
+        // Roughly the amount of destination texels per job of GenerateMipChains
+        static constexpr uint32_t NumTexelsPerJob = 16 * 1024;
+
+        // Linear to sRGB8 table is indexed by the exponent and the top 8 bits of the mantissa of values in [2^-13, 1).
+        // Everything below encodes to 0 anyway (12.92 * 2^-13 * 255 is less than 0.5)
+        static constexpr uint32_t LinearToSrgbMinBits = 0x39000000; // 2^-13
+        static constexpr uint32_t LinearToSrgbMaxBits = 0x3f7fffff; // largest float below 1
+        static constexpr uint32_t LinearToSrgbShift = 15;
+        static constexpr uint32_t LinearToSrgbTableSize = ((0x3f800000 - LinearToSrgbMinBits) >> LinearToSrgbShift);
+
+        double SrgbToLinear(double c) { return (c <= 0.04045) ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4); }
+        double LinearToSrgb(double l) { return (l <= 0.0031308) ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055; }
+
+        struct TextureTables
+        {
+            float Decode[eTextureContent_NumContents][NumChannels][256];
+            uint8_t LinearToSrgb8[LinearToSrgbTableSize];
+        };
+
+        TextureTables BuildTextureTables()
+        {
+            TextureTables tables = {};
+            for (uint32_t c = 0; c < 256; ++c)
+            {
+                const double unorm = c / 255.0;
+                for (uint32_t channel = 0; channel < NumChannels; ++channel)
+                {
+                    const bool isAlpha = (channel == 3);
+                    tables.Decode[eTextureContent_Color][channel][c] = float(isAlpha ? unorm : SrgbToLinear(unorm));
+                    tables.Decode[eTextureContent_Normal][channel][c] = float(isAlpha ? unorm : unorm * 2.0 - 1.0);
+                    tables.Decode[eTextureContent_Linear][channel][c] = float(unorm);
+                }
+            }
+
+            // Each entry is the code of the center of its bucket
+            for (uint32_t i = 0; i < LinearToSrgbTableSize; ++i)
+            {
+                const float center = std::bit_cast<float>(LinearToSrgbMinBits + (i << LinearToSrgbShift) + (1u << (LinearToSrgbShift - 1)));
+                tables.LinearToSrgb8[i] = static_cast<uint8_t>(std::nearbyint(LinearToSrgb(center) * 255.0));
+            }
+            return tables;
+        }
+
+        const TextureTables& GetTextureTables()
+        {
+            static const TextureTables tables = BuildTextureTables();
+            return tables;
+        }
+
+        // Per channel encoding of filtered values: code = round(clamp(v * scale + bias, 0, 1) * 255), unless the channel is sRGB
+        struct ChannelEncoding
+        {
+            float Scale[NumChannels];
+            float Bias[NumChannels];
+            bool IsSrgb[NumChannels];
+        };
+
+        static constexpr ChannelEncoding ChannelEncodings[eTextureContent_NumContents] = {
+            ChannelEncoding{ .Scale = { 1.0f, 1.0f, 1.0f, 1.0f }, .Bias = {}, .IsSrgb = { true, true, true, false } },
+            ChannelEncoding{ .Scale = { 0.5f, 0.5f, 0.5f, 1.0f }, .Bias = { 0.5f, 0.5f, 0.5f, 0.0f }, .IsSrgb = {} },
+            ChannelEncoding{ .Scale = { 1.0f, 1.0f, 1.0f, 1.0f }, .Bias = {}, .IsSrgb = {} },
+        };
+
+        // Same semantics as maxps/minps (second operand is returned for NaNs), so that scalar and SIMD paths match
+        float MaxS(float a, float b) { return (a > b) ? a : b; }
+        float MinS(float a, float b) { return (a < b) ? a : b; }
+        int32_t RoundToInt(float v) { return static_cast<int32_t>(std::lrint(v)); } // nearest-even, same as cvtps2dq
+
+        uint32_t GetLinearToSrgbIndex(float v)
+        {
+            const float clamped = MinS(MaxS(v, std::bit_cast<float>(LinearToSrgbMinBits)), std::bit_cast<float>(LinearToSrgbMaxBits));
+            return (std::bit_cast<uint32_t>(clamped) - LinearToSrgbMinBits) >> LinearToSrgbShift;
+        }
+
+        int32_t EncodeUnorm8(float v, float scale, float bias) { return RoundToInt(MinS(MaxS(v * scale + bias, 0.0f), 1.0f) * 255.0f); }
+
+#if defined(__AVX2__)
+        using FloatV = __m256;
+        using IntV = __m256i;
+        static constexpr uint32_t SimdWidth = 8;
+
+        FloatV SetV(float v) { return _mm256_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm256_loadu_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm256_storeu_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        FloatV DivV(FloatV a, FloatV b) { return _mm256_div_ps(a, b); }
+        FloatV SqrtV(FloatV a) { return _mm256_sqrt_ps(a); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm256_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm256_max_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm256_blendv_ps(b, a, mask); }
+        IntV RoundToIntV(FloatV a) { return _mm256_cvtps_epi32(a); }
+        IntV CastToIntV(FloatV a) { return _mm256_castps_si256(a); }
+        IntV SubIntV(IntV a, IntV b) { return _mm256_sub_epi32(a, b); }
+        IntV ShiftRightIntV(IntV a, int32_t shift) { return _mm256_srli_epi32(a, shift); }
+        IntV SetIntV(int32_t v) { return _mm256_set1_epi32(v); }
+        void StoreIntV(int32_t* p, IntV v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+#else
+        // SSE2 is always there on x64
+        using FloatV = __m128;
+        using IntV = __m128i;
+        static constexpr uint32_t SimdWidth = 4;
+
+        FloatV SetV(float v) { return _mm_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm_loadu_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm_storeu_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        FloatV DivV(FloatV a, FloatV b) { return _mm_div_ps(a, b); }
+        FloatV SqrtV(FloatV a) { return _mm_sqrt_ps(a); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm_max_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm_cmpgt_ps(a, b); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        IntV RoundToIntV(FloatV a) { return _mm_cvtps_epi32(a); }
+        IntV CastToIntV(FloatV a) { return _mm_castps_si128(a); }
+        IntV SubIntV(IntV a, IntV b) { return _mm_sub_epi32(a, b); }
+        IntV ShiftRightIntV(IntV a, int32_t shift) { return _mm_srli_epi32(a, shift); }
+        IntV SetIntV(int32_t v) { return _mm_set1_epi32(v); }
+        void StoreIntV(int32_t* p, IntV v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+#endif
+
+        // Lanes are gathered from (and scattered to) interleaved texels through aligned arrays, same as in MeshTangents.cpp
+        struct alignas(32) LaneArray
+        {
+            float Values[SimdWidth];
+
+            FloatV Load() const { return LoadV(Values); }
+            void Store(FloatV v) { StoreV(Values, v); }
+        };
+
+        struct alignas(32) IntLaneArray
+        {
+            int32_t Values[SimdWidth];
+
+            void Store(IntV v) { StoreIntV(Values, v); }
+        };
+
+        // Per channel constants repeated over the lanes, SimdWidth is always a multiple of the amount of channels
+        LaneArray GetChannelLanes(const float (&values)[NumChannels])
+        {
+            LaneArray lanes;
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                lanes.Values[lane] = values[lane % NumChannels];
+
+            return lanes;
+        }
+
+        // Box filter footprint of a destination texel along one axis. Odd sizes (2n + 1) are reduced to n texels
+        // with 3 taps each (polyphase box), so that every source texel contributes with the same weight
+        struct FilterTaps
+        {
+            uint32_t First = 0;
+            uint32_t NumTaps = 0;
+            float Weights[3] = {};
+        };
+
+        FilterTaps GetFilterTaps(uint32_t srcSize, uint32_t dstIndex)
+        {
+            if (srcSize == 1)
+                return FilterTaps{ .First = 0, .NumTaps = 1, .Weights = { 1.0f } };
+
+            if (srcSize % 2 == 0)
+                return FilterTaps{ .First = dstIndex * 2, .NumTaps = 2, .Weights = { 0.5f, 0.5f } };
+
+            const uint32_t n = srcSize / 2;
+            return FilterTaps{
+                .First = dstIndex * 2,
+                .NumTaps = 3,
+                .Weights = { float(n - dstIndex) / float(srcSize), float(n) / float(srcSize), float(dstIndex + 1) / float(srcSize) },
+            };
+        }
+
+        struct LevelView
+        {
+            uint32_t Width = 0;
+            uint32_t Height = 0;
+            const std::byte* Texels = nullptr;
+        };
+
+        void DecodeRow(float* dst, const std::byte* src, uint32_t width, ETextureContent content)
+        {
+            const auto& decode = GetTextureTables().Decode[content];
+            for (uint32_t i = 0; i < width * NumChannels; ++i)
+                dst[i] = decode[i % NumChannels][static_cast<uint8_t>(src[i])];
+        }
+
+        // dst = rows[0] * weights[0] + rows[1] * weights[1] (+ rows[2] * weights[2]), over every float of the row
+        void FilterVertical(float* dst, const float* const* rows, const FilterTaps& taps, uint32_t numFloats)
+        {
+            uint32_t i = 0;
+            for (; i + SimdWidth <= numFloats; i += SimdWidth)
+            {
+                FloatV sum = MulV(LoadV(rows[0] + i), SetV(taps.Weights[0]));
+                for (uint32_t tap = 1; tap < taps.NumTaps; ++tap)
+                    sum = AddV(sum, MulV(LoadV(rows[tap] + i), SetV(taps.Weights[tap])));
+
+                StoreV(dst + i, sum);
+            }
+
+            for (; i < numFloats; ++i)
+            {
+                float sum = rows[0][i] * taps.Weights[0];
+                for (uint32_t tap = 1; tap < taps.NumTaps; ++tap)
+                    sum = sum + rows[tap][i] * taps.Weights[tap];
+
+                dst[i] = sum;
+            }
+        }
+
+        // Each texel is a single SSE vector of its 4 channels. Even widths with AVX2 do 2 texels at once
+        void FilterHorizontal(float* dst, const float* src, uint32_t srcWidth, uint32_t dstWidth)
+        {
+            uint32_t x = 0;
+#if defined(__AVX2__)
+            if (srcWidth % 2 == 0)
+            {
+                const __m256 half = _mm256_set1_ps(0.5f);
+                for (; x + 2 <= dstWidth; x += 2)
+                {
+                    const __m256 a = _mm256_loadu_ps(src + size_t(x) * 8);     // texels 2x, 2x + 1
+                    const __m256 b = _mm256_loadu_ps(src + size_t(x) * 8 + 8); // texels 2x + 2, 2x + 3
+                    const __m256 even = _mm256_permute2f128_ps(a, b, 0x20);
+                    const __m256 odd = _mm256_permute2f128_ps(a, b, 0x31);
+                    _mm256_storeu_ps(dst + size_t(x) * 4, _mm256_add_ps(_mm256_mul_ps(even, half), _mm256_mul_ps(odd, half)));
+                }
+            }
+#endif
+            for (; x < dstWidth; ++x)
+            {
+                const FilterTaps taps = GetFilterTaps(srcWidth, x);
+                const float* texel = src + size_t(taps.First) * NumChannels;
+
+                __m128 sum = _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(taps.Weights[0]));
+                for (uint32_t tap = 1; tap < taps.NumTaps; ++tap)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel + tap * NumChannels), _mm_set1_ps(taps.Weights[tap])));
+
+                _mm_storeu_ps(dst + size_t(x) * NumChannels, sum);
+            }
+        }
+
+        // Filtered normals are shorter than unit (or even zero) where the source ones diverge
+        void RenormalizeNormals(float* texels, uint32_t width)
+        {
+            uint32_t x = 0;
+            for (; x + SimdWidth <= width; x += SimdWidth)
+            {
+                LaneArray components[3];
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                    for (uint32_t c = 0; c < 3; ++c)
+                        components[c].Values[lane] = texels[size_t(x + lane) * NumChannels + c];
+
+                const FloatV nx = components[0].Load();
+                const FloatV ny = components[1].Load();
+                const FloatV nz = components[2].Load();
+                const FloatV length = SqrtV(AddV(AddV(MulV(nx, nx), MulV(ny, ny)), MulV(nz, nz)));
+                const FloatV isValid = GreaterV(length, SetV(0.0f));
+                const FloatV safeLength = SelectV(isValid, length, SetV(1.0f));
+                components[0].Store(SelectV(isValid, DivV(nx, safeLength), SetV(0.0f)));
+                components[1].Store(SelectV(isValid, DivV(ny, safeLength), SetV(0.0f)));
+                components[2].Store(SelectV(isValid, DivV(nz, safeLength), SetV(1.0f)));
+
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                    for (uint32_t c = 0; c < 3; ++c)
+                        texels[size_t(x + lane) * NumChannels + c] = components[c].Values[lane];
+            }
+
+            for (; x < width; ++x)
+            {
+                float* n = texels + size_t(x) * NumChannels;
+                const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                if (length > 0.0f)
+                {
+                    n[0] = n[0] / length;
+                    n[1] = n[1] / length;
+                    n[2] = n[2] / length;
+                }
+                else
+                {
+                    n[0] = 0.0f;
+                    n[1] = 0.0f;
+                    n[2] = 1.0f;
+                }
+            }
+        }
+
+        void EncodeRow(std::byte* dst, const float* src, uint32_t width, ETextureContent content)
+        {
+            const TextureTables& tables = GetTextureTables();
+            const ChannelEncoding& encoding = ChannelEncodings[content];
+            const LaneArray scale = GetChannelLanes(encoding.Scale);
+            const LaneArray bias = GetChannelLanes(encoding.Bias);
+
+            const uint32_t numFloats = width * NumChannels;
+            uint32_t i = 0;
+            for (; i + SimdWidth <= numFloats; i += SimdWidth)
+            {
+                const FloatV v = LoadV(src + i);
+
+                IntLaneArray unorm;
+                unorm.Store(RoundToIntV(MulV(MinV(MaxV(AddV(MulV(v, scale.Load()), bias.Load()), SetV(0.0f)), SetV(1.0f)), SetV(255.0f))));
+
+                IntLaneArray srgbIndices;
+                const FloatV clamped = MinV(MaxV(v, SetV(std::bit_cast<float>(LinearToSrgbMinBits))), SetV(std::bit_cast<float>(LinearToSrgbMaxBits)));
+                srgbIndices.Store(ShiftRightIntV(SubIntV(CastToIntV(clamped), SetIntV(int32_t(LinearToSrgbMinBits))), LinearToSrgbShift));
+
+                for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                {
+                    const uint32_t code = encoding.IsSrgb[lane % NumChannels] ? tables.LinearToSrgb8[srgbIndices.Values[lane]] : uint32_t(unorm.Values[lane]);
+                    dst[i + lane] = static_cast<std::byte>(code);
+                }
+            }
+
+            for (; i < numFloats; ++i)
+            {
+                const uint32_t channel = i % NumChannels;
+                const uint32_t code = encoding.IsSrgb[channel] ? tables.LinearToSrgb8[GetLinearToSrgbIndex(src[i])] : uint32_t(EncodeUnorm8(src[i], encoding.Scale[channel], encoding.Bias[channel]));
+                dst[i] = static_cast<std::byte>(code);
+            }
+        }
+
+        // Filters rows [rowBegin, rowEnd) of dst from src
+        void DownsampleRows(std::byte* dst, uint32_t dstWidth, const LevelView& src, ETextureContent content, uint32_t rowBegin, uint32_t rowEnd)
+        {
+            const size_t numSrcFloats = size_t(src.Width) * NumChannels;
+            const size_t numDstFloats = size_t(dstWidth) * NumChannels;
+
+            // 3 decoded source rows, vertically filtered row and the destination row
+            std::vector<float> scratch(numSrcFloats * 4 + numDstFloats);
+            float* decodedRows[3] = { scratch.data(), scratch.data() + numSrcFloats, scratch.data() + numSrcFloats * 2 };
+            float* filteredRow = scratch.data() + numSrcFloats * 3;
+            float* dstRow = scratch.data() + numSrcFloats * 4;
+
+            for (uint32_t y = rowBegin; y < rowEnd; ++y)
+            {
+                const FilterTaps taps = GetFilterTaps(src.Height, y);
+                for (uint32_t tap = 0; tap < taps.NumTaps; ++tap)
+                    DecodeRow(decodedRows[tap], src.Texels + size_t(taps.First + tap) * src.Width * NumChannels, src.Width, content);
+
+                FilterVertical(filteredRow, decodedRows, taps, static_cast<uint32_t>(numSrcFloats));
+                FilterHorizontal(dstRow, filteredRow, src.Width, dstWidth);
+                if (content == eTextureContent_Normal)
+                    RenormalizeNormals(dstRow, dstWidth);
+
+                EncodeRow(dst + size_t(y) * numDstFloats, dstRow, dstWidth, content);
+            }
+        }
+
+        void AllocateMipChain(TextureMipChain& dst, const TextureSourceDesc& src, uint32_t maxLevels)
+        {
+            dst = TextureMipChain();
+            if (src.Width == 0 || src.Height == 0)
+                return;
+
+            const uint32_t numLevels = GetNumMipLevels(src.Width, src.Height);
+            dst.NumLevels = (maxLevels == 0) ? numLevels : std::min(numLevels, maxLevels);
+            dst.Levels.resize(dst.NumLevels - 1);
+
+            size_t numBytes = 0;
+            uint32_t width = src.Width, height = src.Height;
+            for (TextureMipLevel& level : dst.Levels)
+            {
+                width = std::max(width / 2, 1u);
+                height = std::max(height / 2, 1u);
+                level = TextureMipLevel{ .Width = width, .Height = height, .Offset = numBytes };
+                numBytes += size_t(width) * height * NumChannels;
+            }
+            dst.Texels.resize(numBytes);
+        }
+
+        // Source of the level (1-based) of the chain, which is the previous level
+        LevelView GetSourceLevel(const TextureMipChain& chain, const TextureSourceDesc& src, uint32_t level)
+        {
+            if (level == 1)
+                return LevelView{ .Width = src.Width, .Height = src.Height, .Texels = src.Texels };
+
+            const TextureMipLevel& prev = chain.Levels[level - 2];
+            return LevelView{ .Width = prev.Width, .Height = prev.Height, .Texels = chain.Texels.data() + prev.Offset };
+        }
+    } // anonymous namespace
+
+    uint32_t GetNumMipLevels(uint32_t width, uint32_t height)
+    {
+        return std::bit_width(std::max(width, height));
+    }
+
+    void GenerateMipChain(TextureMipChain& dst, const TextureSourceDesc& src, uint32_t maxLevels)
+    {
+        NEB_ASSERT(src.Content < eTextureContent_NumContents, "Unknown texture content {}", uint32_t(src.Content));
+
+        AllocateMipChain(dst, src, maxLevels);
+        for (uint32_t level = 1; level < dst.NumLevels; ++level)
+        {
+            const TextureMipLevel& mip = dst.Levels[level - 1];
+            DownsampleRows(dst.Texels.data() + mip.Offset, mip.Width, GetSourceLevel(dst, src, level), src.Content, 0, mip.Height);
+        }
+    }
+
+    void GenerateMipChains(std::span<TextureMipChain> dst, std::span<const TextureSourceDesc> srcs, ThreadPool& threadPool, uint32_t maxLevels)
+    {
+        NEB_ASSERT(dst.size() == srcs.size(), "Each source should have its own mip chain");
+
+        uint32_t numLevels = 0;
+        for (size_t i = 0; i < srcs.size(); ++i)
+        {
+            AllocateMipChain(dst[i], srcs[i], maxLevels);
+            numLevels = std::max(numLevels, dst[i].NumLevels);
+        }
+
+        // Level N only depends on level N - 1, rows within the level are independent
+        struct RowJob
+        {
+            uint32_t Image;
+            uint32_t RowBegin;
+            uint32_t RowEnd;
+        };
+        std::vector<RowJob> jobs;
+        for (uint32_t level = 1; level < numLevels; ++level)
+        {
+            jobs.clear();
+            for (uint32_t i = 0; i < static_cast<uint32_t>(dst.size()); ++i)
+            {
+                if (level >= dst[i].NumLevels)
+                    continue;
+
+                const TextureMipLevel& mip = dst[i].Levels[level - 1];
+                const uint32_t numRowsPerJob = std::max(NumTexelsPerJob / mip.Width, 1u);
+                for (uint32_t row = 0; row < mip.Height; row += numRowsPerJob)
+                    jobs.push_back(RowJob{ .Image = i, .RowBegin = row, .RowEnd = std::min(row + numRowsPerJob, mip.Height) });
+            }
+
+            threadPool.ParallelFor(jobs.size(), [&dst, &srcs, &jobs, level](size_t j)
+                {
+                    const RowJob& job = jobs[j];
+                    TextureMipChain& chain = dst[job.Image];
+                    const TextureMipLevel& mip = chain.Levels[level - 1];
+                    DownsampleRows(chain.Texels.data() + mip.Offset, mip.Width, GetSourceLevel(chain, srcs[job.Image], level), srcs[job.Image].Content, job.RowBegin, job.RowEnd);
+                });
+        }
+    }
+
+    TextureMipChainError MeasureMipChainError(const TextureMipChain& chain, const TextureSourceDesc& src)
+    {
+        TextureMipChainError error;
+        const ChannelEncoding& encoding = ChannelEncodings[src.Content];
+
+        auto decode = [&src](uint8_t code, uint32_t channel) -> double
+            {
+                const double unorm = code / 255.0;
+                if (channel == 3 || src.Content == eTextureContent_Linear)
+                    return unorm;
+
+                return (src.Content == eTextureContent_Color) ? SrgbToLinear(unorm) : unorm * 2.0 - 1.0;
+            };
+
+        // Weights are exact here, unlike the float ones of GetFilterTaps
+        auto getWeights = [](uint32_t srcSize, uint32_t dstIndex, double (&weights)[3]) -> FilterTaps
+            {
+                const FilterTaps taps = GetFilterTaps(srcSize, dstIndex);
+                const uint32_t n = srcSize / 2;
+                weights[0] = (taps.NumTaps == 3) ? double(n - dstIndex) / srcSize : taps.Weights[0];
+                weights[1] = (taps.NumTaps == 3) ? double(n) / srcSize : taps.Weights[1];
+                weights[2] = (taps.NumTaps == 3) ? double(dstIndex + 1) / srcSize : 0.0;
+                return taps;
+            };
+
+        for (uint32_t level = 1; level < chain.NumLevels; ++level)
+        {
+            const LevelView prev = GetSourceLevel(chain, src, level);
+            const TextureMipLevel& mip = chain.Levels[level - 1];
+            const std::byte* texels = chain.Texels.data() + mip.Offset;
+
+            for (uint32_t y = 0; y < mip.Height; ++y)
+            {
+                double weightsY[3];
+                const FilterTaps tapsY = getWeights(prev.Height, y, weightsY);
+                for (uint32_t x = 0; x < mip.Width; ++x)
+                {
+                    double weightsX[3];
+                    const FilterTaps tapsX = getWeights(prev.Width, x, weightsX);
+
+                    double value[NumChannels] = {};
+                    for (uint32_t ty = 0; ty < tapsY.NumTaps; ++ty)
+                        for (uint32_t tx = 0; tx < tapsX.NumTaps; ++tx)
+                        {
+                            const std::byte* texel = prev.Texels + (size_t(tapsY.First + ty) * prev.Width + tapsX.First + tx) * NumChannels;
+                            for (uint32_t c = 0; c < NumChannels; ++c)
+                                value[c] += decode(static_cast<uint8_t>(texel[c]), c) * weightsY[ty] * weightsX[tx];
+                        }
+
+                    if (src.Content == eTextureContent_Normal)
+                    {
+                        const double length = std::sqrt(value[0] * value[0] + value[1] * value[1] + value[2] * value[2]);
+                        for (uint32_t c = 0; c < 3; ++c)
+                            value[c] = (length > 0.0) ? value[c] / length : (c == 2 ? 1.0 : 0.0);
+                    }
+
+                    bool isMismatched = false;
+                    for (uint32_t c = 0; c < NumChannels; ++c)
+                    {
+                        const double encoded = encoding.IsSrgb[c] ?
+                            LinearToSrgb(std::clamp(value[c], 0.0, 1.0)) :
+                            std::clamp(value[c] * encoding.Scale[c] + encoding.Bias[c], 0.0, 1.0);
+
+                        const int32_t expected = static_cast<int32_t>(std::nearbyint(encoded * 255.0));
+                        const int32_t actual = static_cast<int32_t>(texels[(size_t(y) * mip.Width + x) * NumChannels + c]);
+                        const uint32_t diff = static_cast<uint32_t>(std::abs(expected - actual));
+                        error.MaxError = std::max(error.MaxError, diff);
+                        isMismatched |= (diff != 0);
+                    }
+
+                    error.NumMismatchedTexels += isMismatched ? 1 : 0;
+                    ++error.NumTexels;
+                }
+            }
+        }
+        return error;
+    }
+
+    bool IsMipChainErrorAcceptable(const TextureMipChainError& error)
+    {
+        return error.MaxError <= 1;
+    }
+
+} // Neb namespace
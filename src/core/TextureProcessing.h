@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Decides how texels are filtered. Every content is RGBA8, alpha is always linear
+    enum ETextureContent
+    {
+        eTextureContent_Color = 0, // sRGB encoded rgb (albedo), filtered in linear space
+        eTextureContent_Normal,    // tangent space normal encoded as unorm, renormalized after filtering
+        eTextureContent_Linear,    // independent linear channels (roughness/metalness, masks)
+        eTextureContent_NumContents,
+    };
+
+    // Source level of a single image, rows are tightly packed
+    struct TextureSourceDesc
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        const std::byte* Texels = nullptr; // RGBA8
+        ETextureContent Content = eTextureContent_Linear;
+    };
+
+    struct TextureMipLevel
+    {
+        uint32_t Width = 0;
+        uint32_t Height = 0;
+        size_t Offset = 0; // in bytes, into TextureMipChain::Texels
+    };
+
+    // Mips below the source one, the source itself is not copied. Levels[i] is mip i + 1, rows are tightly packed RGBA8
+    struct TextureMipChain
+    {
+        uint32_t NumLevels = 0; // including the source
+        std::vector<TextureMipLevel> Levels;
+        std::vector<std::byte> Texels;
+    };
+
+    // Full chain down to 1x1, same as D3D12 (each dimension is halved and rounded down)
+    uint32_t GetNumMipLevels(uint32_t width, uint32_t height);
+
+    // Each level is filtered from the previous one with a box filter, odd dimensions use a 3-tap polyphase box
+    // so that every source texel contributes with the same weight. Math is vectorized with SSE (or AVX2 if the build
+    // targets it), leftovers go through the scalar path, which gives bitwise identical results.
+    // maxLevels of 0 means the full chain
+    void GenerateMipChain(TextureMipChain& dst, const TextureSourceDesc& src, uint32_t maxLevels = 0);
+
+    // Generates chains of every source on the thread pool. Levels are processed one after another, rows of the level
+    // are split between threads across all images at once, so that a single large image does not serialize the work.
+    // dst and srcs are expected to be of the same size
+    void GenerateMipChains(std::span<TextureMipChain> dst, std::span<const TextureSourceDesc> srcs, ThreadPool& threadPool, uint32_t maxLevels = 0);
+
+    struct TextureMipChainError
+    {
+        uint32_t MaxError = 0; // in 8-bit codes, max over every channel of every level
+        uint64_t NumMismatchedTexels = 0;
+        uint64_t NumTexels = 0;
+    };
+
+    // Filters every level from the previous one of the chain with a scalar double precision reference (exact sRGB curve)
+    // and compares the results. Errors do not accumulate between levels, as both start from the same texels
+    TextureMipChainError MeasureMipChainError(const TextureMipChain& chain, const TextureSourceDesc& src);
+
+    // Fast sRGB encoding is table based and may be off by a single code near the boundaries of the codes
+    bool IsMipChainErrorAcceptable(const TextureMipChainError& error);
+
+} // Neb namespace
@@ -0,0 +1,44 @@
+#include "TextureRegistry.h"
+
+#include "../common/Assert.h"
+
+namespace Neb
+{
+
+    nri::D3D12Rc<ID3D12Resource> TextureRegistry::Find(const TextureRegistryKey& key) const
+    {
+        auto it = m_textures.find(key);
+        return (it != m_textures.end()) ? it->second.Resource : nullptr;
+    }
+
+    void TextureRegistry::Add(const TextureRegistryKey& key, nri::D3D12Rc<ID3D12Resource> resource, uint64_t numBytes)
+    {
+        NEB_ASSERT(resource, "Resource cannot be null");
+        NEB_ASSERT(!m_textures.contains(key), "Texture with content hash {:016x} is already registered", key.ContentHash);
+
+        m_textures.emplace(key, Entry{ .Resource = std::move(resource), .NumBytes = numBytes });
+        m_numBytes += numBytes;
+    }
+
+    uint32_t TextureRegistry::ReleaseUnreferenced()
+    {
+        uint32_t numReleased = 0;
+        for (auto it = m_textures.begin(); it != m_textures.end();)
+        {
+            // Release() returns the new reference count, if it is 1 the registry is the only owner
+            ID3D12Resource* resource = it->second.Resource.Get();
+            resource->AddRef();
+            if (resource->Release() > 1)
+            {
+                ++it;
+                continue;
+            }
+
+            m_numBytes -= it->second.NumBytes;
+            it = m_textures.erase(it);
+            ++numReleased;
+        }
+        return numReleased;
+    }
+
+} // Neb namespace
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../nri/stdafx.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace Neb
+{
+
+    // Identifies texture contents regardless of where they came from. ContentHash is a hash of the decoded source texels
+    // together with everything that decides what is uploaded from them (dimensions, material slots, mips and compression).
+    // Format is the format of the uploaded resource
+    struct TextureRegistryKey
+    {
+        uint64_t ContentHash = 0;
+        uint32_t Format = 0; // DXGI_FORMAT
+
+        bool operator==(const TextureRegistryKey&) const = default;
+    };
+
+    struct TextureRegistryKeyHasher
+    {
+        size_t operator()(const TextureRegistryKey& key) const noexcept
+        {
+            // Content hash is already well distributed
+            return static_cast<size_t>(key.ContentHash ^ (uint64_t(key.Format) << 56));
+        }
+    };
+
+    // Textures uploaded by the importer, shared between every material (and every import) that uses the same contents.
+    // The registry holds a reference to each texture, those that nothing else references anymore are released
+    // with ReleaseUnreferenced()
+    class TextureRegistry
+    {
+    public:
+        // Null if there is no such texture
+        nri::D3D12Rc<ID3D12Resource> Find(const TextureRegistryKey& key) const;
+
+        // numBytes is the size of the texture in video memory, only used for statistics
+        void Add(const TextureRegistryKey& key, nri::D3D12Rc<ID3D12Resource> resource, uint64_t numBytes);
+
+        // Returns the amount of released textures
+        uint32_t ReleaseUnreferenced();
+
+        uint32_t GetNumTextures() const { return static_cast<uint32_t>(m_textures.size()); }
+        uint64_t GetNumBytes() const { return m_numBytes; }
+
+    private:
+        struct Entry
+        {
+            nri::D3D12Rc<ID3D12Resource> Resource;
+            uint64_t NumBytes = 0;
+        };
+
+        std::unordered_map<TextureRegistryKey, Entry, TextureRegistryKeyHasher> m_textures;
+        uint64_t m_numBytes = 0;
+    };
+
+} // Neb namespace
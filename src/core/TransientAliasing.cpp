@@ -0,0 +1,202 @@
+#include "TransientAliasing.h"
+
+#include "../common/Assert.h"
+#include "../util/Memory.h"
+
+#include <algorithm>
+
+namespace Neb
+{
+
+    namespace
+    {
+        constexpr bool AreLifetimesOverlapping(const TransientResourceDesc& a, const TransientResourceDesc& b)
+        {
+            return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+        }
+
+        constexpr bool AreRangesOverlapping(uint64_t offsetA, uint64_t sizeA, uint64_t offsetB, uint64_t sizeB)
+        {
+            return offsetA < offsetB + sizeB && offsetB < offsetA + sizeA;
+        }
+    } // anonymous namespace
+
+    void TransientAliasingPlanner::Reset()
+    {
+        m_resources.clear();
+        m_placements.clear();
+        m_heapSizes.clear();
+        m_heapGroups.clear();
+        m_barriers.clear();
+        m_barrierOffsets.clear();
+        m_stats = TransientAliasingStats();
+    }
+
+    uint32_t TransientAliasingPlanner::AddResource(const TransientResourceDesc& desc)
+    {
+        NEB_ASSERT(desc.FirstPass <= desc.LastPass, "Lifetime of a transient resource ends before it begins");
+        NEB_CHECK_POW2_ALIGNMENT(desc.Alignment);
+        m_resources.push_back(desc);
+        return static_cast<uint32_t>(m_resources.size() - 1);
+    }
+
+    void TransientAliasingPlanner::Plan()
+    {
+        const uint32_t numResources = GetNumResources();
+        m_placements.assign(numResources, TransientPlacement());
+        m_heapSizes.clear();
+        m_heapGroups.clear();
+        m_stats = TransientAliasingStats{ .NumResources = numResources };
+
+        m_sortedResources.resize(numResources);
+        for (uint32_t i = 0; i < numResources; ++i)
+            m_sortedResources[i] = i;
+
+        // Larger resources are placed first, smaller ones then fill gaps between them. Of the same size, the earlier one goes first,
+        // so that resources of a single size are coloured in the order of their starts, which takes as few colours as the most
+        // resources alive at once
+        std::ranges::sort(m_sortedResources, [this](uint32_t a, uint32_t b)
+            {
+                const TransientResourceDesc& descA = m_resources[a];
+                const TransientResourceDesc& descB = m_resources[b];
+                if (descA.HeapGroup != descB.HeapGroup)
+                    return descA.HeapGroup < descB.HeapGroup;
+                if (descA.Size != descB.Size)
+                    return descA.Size > descB.Size;
+                if (descA.FirstPass != descB.FirstPass)
+                    return descA.FirstPass < descB.FirstPass;
+                return a < b;
+            });
+
+        for (uint32_t first = 0; first < numResources;)
+        {
+            const uint32_t heapGroup = m_resources[m_sortedResources[first]].HeapGroup;
+            uint32_t last = first + 1;
+            while (last < numResources && m_resources[m_sortedResources[last]].HeapGroup == heapGroup)
+                ++last;
+
+            PlaceHeapGroup(heapGroup, std::span(m_sortedResources).subspan(first, last - first));
+            first = last;
+        }
+
+        BuildAliasingBarriers();
+        m_stats.NumHeaps = GetNumHeaps();
+        m_stats.NumAliasingBarriers = static_cast<uint32_t>(m_barriers.size());
+    }
+
+    std::span<const TransientAliasingBarrier> TransientAliasingPlanner::GetAliasingBarriers(uint32_t pass) const
+    {
+        if (pass + 1 >= m_barrierOffsets.size())
+            return {};
+
+        return std::span(m_barriers).subspan(m_barrierOffsets[pass], m_barrierOffsets[pass + 1] - m_barrierOffsets[pass]);
+    }
+
+    void TransientAliasingPlanner::PlaceHeapGroup(uint32_t heapGroup, std::span<const uint32_t> resources)
+    {
+        const uint32_t heap = GetNumHeaps();
+        uint64_t heapSize = 0;
+
+        m_placedResources.clear();
+        m_liveBytes.clear();
+        for (uint32_t resource : resources)
+        {
+            const TransientResourceDesc& desc = m_resources[resource];
+
+            // Memory of resources alive at the same time, then the lowest offset between them that fits
+            m_occupiedRanges.clear();
+            for (uint32_t placed : m_placedResources)
+            {
+                const TransientResourceDesc& placedDesc = m_resources[placed];
+                if (placedDesc.Size != 0 && AreLifetimesOverlapping(desc, placedDesc))
+                    m_occupiedRanges.push_back(Range{ .Begin = m_placements[placed].Offset, .End = m_placements[placed].Offset + placedDesc.Size });
+            }
+            std::ranges::sort(m_occupiedRanges, {}, &Range::Begin);
+
+            uint64_t offset = 0;
+            for (const Range& range : m_occupiedRanges)
+            {
+                if (range.End <= offset)
+                    continue;
+                if (offset + desc.Size <= range.Begin)
+                    break;
+                offset = AlignUp(range.End, desc.Alignment);
+            }
+
+            m_placements[resource] = TransientPlacement{ .Heap = heap, .Offset = offset };
+            m_placedResources.push_back(resource);
+            heapSize = std::max(heapSize, offset + desc.Size);
+
+            if (m_liveBytes.size() <= desc.LastPass)
+                m_liveBytes.resize(desc.LastPass + 1, 0);
+            for (uint32_t pass = desc.FirstPass; pass <= desc.LastPass; ++pass)
+                m_liveBytes[pass] += desc.Size;
+
+            m_stats.NaiveBytes += AlignUp(desc.Size, desc.Alignment);
+        }
+
+        m_heapSizes.push_back(heapSize);
+        m_heapGroups.push_back(heapGroup);
+        m_stats.HeapBytes += heapSize;
+        m_stats.PeakBytes += m_liveBytes.empty() ? 0 : *std::ranges::max_element(m_liveBytes);
+    }
+
+    void TransientAliasingPlanner::BuildAliasingBarriers()
+    {
+        const uint32_t numResources = GetNumResources();
+        m_numSharers.assign(numResources, 0);
+        m_lastSharers.assign(numResources, InvalidIndex);
+
+        // Resources are sorted by groups, so that only resources of the same heap are compared
+        uint32_t numPasses = 0;
+        for (uint32_t i = 0; i < numResources; ++i)
+        {
+            const uint32_t a = m_sortedResources[i];
+            const TransientResourceDesc& descA = m_resources[a];
+            numPasses = std::max(numPasses, descA.LastPass + 1);
+
+            for (uint32_t j = i + 1; j < numResources; ++j)
+            {
+                const uint32_t b = m_sortedResources[j];
+                if (m_placements[b].Heap != m_placements[a].Heap)
+                    break;
+
+                if (!AreRangesOverlapping(m_placements[a].Offset, descA.Size, m_placements[b].Offset, m_resources[b].Size))
+                    continue;
+
+                ++m_numSharers[a];
+                ++m_numSharers[b];
+                m_lastSharers[a] = b;
+                m_lastSharers[b] = a;
+            }
+        }
+
+        // Bucketed by the first pass of every resource, resources of a pass are in the order they were added
+        m_barrierOffsets.assign(numPasses + 1, 0);
+        for (uint32_t resource = 0; resource < numResources; ++resource)
+        {
+            if (m_numSharers[resource] != 0)
+                ++m_barrierOffsets[m_resources[resource].FirstPass + 1];
+        }
+        for (uint32_t pass = 0; pass < numPasses; ++pass)
+            m_barrierOffsets[pass + 1] += m_barrierOffsets[pass];
+
+        m_barriers.resize(m_barrierOffsets[numPasses]);
+        for (uint32_t resource = 0; resource < numResources; ++resource)
+        {
+            if (m_numSharers[resource] == 0)
+                continue;
+
+            // Start of the bucket is moved along while it is filled, then restored below
+            uint32_t& slot = m_barrierOffsets[m_resources[resource].FirstPass];
+            m_barriers[slot++] = TransientAliasingBarrier{
+                .ResourceBefore = (m_numSharers[resource] == 1) ? m_lastSharers[resource] : InvalidIndex,
+                .ResourceAfter = resource,
+            };
+        }
+        for (uint32_t pass = numPasses; pass > 0; --pass)
+            m_barrierOffsets[pass] = m_barrierOffsets[pass - 1];
+        m_barrierOffsets[0] = 0;
+    }
+
+} // Neb namespace
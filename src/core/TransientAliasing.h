@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    struct TransientResourceDesc
+    {
+        // Lifetime in passes of a frame, both inclusive
+        uint32_t FirstPass = 0;
+        uint32_t LastPass = 0;
+
+        // As of GetResourceAllocationInfo, alignment is a power of two
+        uint64_t Size = 0;
+        uint64_t Alignment = 1;
+
+        // Resources of different groups never share a heap, e.g. render targets and other textures on resource heap tier 1
+        uint32_t HeapGroup = 0;
+    };
+
+    struct TransientPlacement
+    {
+        uint32_t Heap = 0;
+        uint64_t Offset = 0;
+    };
+
+    // Issued before the first pass of ResourceAfter, ResourceBefore is InvalidIndex when more than a single resource shares memory
+    // with it (null resource of D3D12, that stands for any of them)
+    struct TransientAliasingBarrier
+    {
+        uint32_t ResourceBefore = 0;
+        uint32_t ResourceAfter = 0;
+
+        bool operator==(const TransientAliasingBarrier&) const = default;
+    };
+
+    struct TransientAliasingStats
+    {
+        uint32_t NumResources = 0;
+        uint32_t NumHeaps = 0;
+        uint32_t NumAliasingBarriers = 0;
+        uint64_t HeapBytes = 0;  // of every heap
+        uint64_t PeakBytes = 0;  // most bytes alive in a single pass of every group, the least heaps could take regardless of alignment
+        uint64_t NaiveBytes = 0; // of separate allocations of every resource
+    };
+
+    // Packs resources, that live in ranges of passes of a frame, into heaps: resources whose lifetimes overlap never share memory,
+    // others may be placed at the same offsets of a heap. This is colouring of the interval graph of lifetimes with ranges of bytes,
+    // resources go from the largest to the smallest one and each takes the lowest aligned offset, that is free for its whole lifetime.
+    // Resources that share memory with others are activated by aliasing barriers before their first pass. Memory repeats every frame,
+    // so a resource placed over ones that live later in the frame is aliased from the previous frame.
+    // Handles of resources are indices in the order they were added. Memory is kept between resets
+    class TransientAliasingPlanner
+    {
+    public:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
+        void Reset();
+
+        uint32_t AddResource(const TransientResourceDesc& desc);
+
+        void Plan();
+
+        // Of the last plan
+        const TransientPlacement& GetPlacement(uint32_t resource) const { return m_placements[resource]; }
+        uint32_t GetNumHeaps() const { return static_cast<uint32_t>(m_heapSizes.size()); }
+        uint64_t GetHeapSize(uint32_t heap) const { return m_heapSizes[heap]; }
+        uint32_t GetHeapGroup(uint32_t heap) const { return m_heapGroups[heap]; }
+
+        // Aliasing barriers to issue before the given pass, none for passes after the last one of every resource
+        std::span<const TransientAliasingBarrier> GetAliasingBarriers(uint32_t pass) const;
+
+        const TransientAliasingStats& GetStats() const { return m_stats; }
+
+        uint32_t GetNumResources() const { return static_cast<uint32_t>(m_resources.size()); }
+        const TransientResourceDesc& GetResource(uint32_t resource) const { return m_resources[resource]; }
+
+    private:
+        void PlaceHeapGroup(uint32_t heapGroup, std::span<const uint32_t> resources);
+        void BuildAliasingBarriers();
+
+        std::vector<TransientResourceDesc> m_resources;
+
+        std::vector<TransientPlacement> m_placements;
+        std::vector<uint64_t> m_heapSizes;
+        std::vector<uint32_t> m_heapGroups;
+        std::vector<TransientAliasingBarrier> m_barriers; // grouped by pass
+        std::vector<uint32_t> m_barrierOffsets;           // number of passes + 1, first barrier of every pass
+        TransientAliasingStats m_stats;
+
+        // Scratch of planning, kept between plans
+        struct Range
+        {
+            uint64_t Begin;
+            uint64_t End;
+        };
+        std::vector<uint32_t> m_sortedResources; // by group, then from the largest one
+        std::vector<uint32_t> m_placedResources; // of the group being placed
+        std::vector<Range> m_occupiedRanges;
+        std::vector<uint64_t> m_liveBytes;       // per pass, of the group being placed
+        std::vector<uint32_t> m_numSharers;      // per resource, resources that share memory with it
+        std::vector<uint32_t> m_lastSharers;
+    };
+
+} // Neb namespace
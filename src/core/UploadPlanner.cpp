@@ -0,0 +1,202 @@
+#include "UploadPlanner.h"
+
+#include "../common/Assert.h"
+#include "../util/Memory.h"
+
+#include <algorithm>
+
+namespace Neb
+{
+
+    void PlanUploads(UploadPlan& plan, std::span<const UploadRequestDesc> requests, uint64_t chunkSize)
+    {
+        NEB_ASSERT(chunkSize > 0, "Chunk size cannot be 0");
+
+        plan.Chunks.clear();
+        plan.Pieces.clear();
+
+        UploadChunk chunk;
+        auto closeChunk = [&plan, &chunk]()
+            {
+                if (chunk.NumPieces > 0)
+                    plan.Chunks.push_back(chunk);
+
+                chunk = UploadChunk{ .FirstPiece = static_cast<uint32_t>(plan.Pieces.size()) };
+            };
+
+        auto addPiece = [&plan, &chunk](uint32_t request, uint64_t requestOffset, uint64_t numBytes, uint64_t chunkOffset, uint64_t alignment)
+            {
+                plan.Pieces.push_back(UploadPiece{ .Request = request, .RequestOffset = requestOffset, .NumBytes = numBytes, .ChunkOffset = chunkOffset });
+                chunk.NumBytes = chunkOffset + numBytes;
+                chunk.Alignment = std::max(chunk.Alignment, alignment);
+                ++chunk.NumPieces;
+            };
+
+        for (uint32_t i = 0; i < static_cast<uint32_t>(requests.size()); ++i)
+        {
+            const UploadRequestDesc& request = requests[i];
+            NEB_CHECK_POW2_ALIGNMENT(request.Alignment);
+
+            uint64_t requestOffset = 0;
+            while (requestOffset < request.NumBytes)
+            {
+                const uint64_t numRemainingBytes = request.NumBytes - requestOffset;
+                const uint64_t chunkOffset = AlignUp(chunk.NumBytes, request.Alignment);
+                const uint64_t numFreeBytes = (chunkOffset < chunkSize) ? chunkSize - chunkOffset : 0;
+
+                // The rest of the request fits as is
+                if (numRemainingBytes <= numFreeBytes)
+                {
+                    addPiece(i, requestOffset, numRemainingBytes, chunkOffset, request.Alignment);
+                    requestOffset = request.NumBytes;
+                    continue;
+                }
+
+                // As many whole granules as there is space for, the rest goes into the next chunk
+                const uint64_t granularity = request.SplitGranularity;
+                const uint64_t numSplitBytes = (granularity > 0) ? (numFreeBytes / granularity) * granularity : 0;
+                if (numSplitBytes > 0)
+                {
+                    addPiece(i, requestOffset, numSplitBytes, chunkOffset, request.Alignment);
+                    requestOffset += numSplitBytes;
+                    closeChunk();
+                    continue;
+                }
+
+                if (chunk.NumPieces > 0)
+                {
+                    closeChunk();
+                    continue;
+                }
+
+                // Even an empty chunk cannot hold a single granule (or the whole unsplittable request), it gets an oversized chunk
+                const uint64_t numBytes = (granularity > 0) ? std::min(numRemainingBytes, granularity) : numRemainingBytes;
+                addPiece(i, requestOffset, numBytes, 0, request.Alignment);
+                requestOffset += numBytes;
+                closeChunk();
+            }
+        }
+        closeChunk();
+    }
+
+    bool ValidateUploadPlan(const UploadPlan& plan, std::span<const UploadRequestDesc> requests, uint64_t chunkSize)
+    {
+        // Pieces of each request have to be in order, as requests are planned in order
+        std::vector<uint64_t> numCoveredBytes(requests.size(), 0);
+        uint32_t expectedFirstPiece = 0;
+        for (const UploadChunk& chunk : plan.Chunks)
+        {
+            if (chunk.FirstPiece != expectedFirstPiece || chunk.NumPieces == 0 || uint64_t(chunk.FirstPiece) + chunk.NumPieces > plan.Pieces.size())
+                return false;
+
+            if (chunk.NumBytes > chunkSize && chunk.NumPieces != 1)
+                return false;
+
+            uint64_t chunkEnd = 0;
+            for (uint32_t p = chunk.FirstPiece; p < chunk.FirstPiece + chunk.NumPieces; ++p)
+            {
+                const UploadPiece& piece = plan.Pieces[p];
+                if (piece.Request >= requests.size() || piece.NumBytes == 0)
+                    return false;
+
+                const UploadRequestDesc& request = requests[piece.Request];
+                if (piece.ChunkOffset < chunkEnd || piece.ChunkOffset % request.Alignment != 0 || request.Alignment > chunk.Alignment)
+                    return false;
+
+                if (piece.RequestOffset != numCoveredBytes[piece.Request] || piece.RequestOffset + piece.NumBytes > request.NumBytes)
+                    return false;
+
+                if (request.SplitGranularity == 0 ? piece.NumBytes != request.NumBytes : piece.RequestOffset % request.SplitGranularity != 0)
+                    return false;
+
+                numCoveredBytes[piece.Request] += piece.NumBytes;
+                chunkEnd = piece.ChunkOffset + piece.NumBytes;
+            }
+
+            if (chunkEnd != chunk.NumBytes)
+                return false;
+
+            expectedFirstPiece = chunk.FirstPiece + chunk.NumPieces;
+        }
+
+        if (expectedFirstPiece != plan.Pieces.size())
+            return false;
+
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            if (numCoveredBytes[i] != requests[i].NumBytes)
+                return false;
+        }
+        return true;
+    }
+
+    StagingRing::StagingRing(uint64_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    uint64_t StagingRing::GetAllocationBegin(uint64_t numBytes, uint64_t alignment) const
+    {
+        NEB_CHECK_POW2_ALIGNMENT(alignment);
+        NEB_ASSERT(m_capacity % alignment == 0, "Ring capacity {} is not a multiple of alignment {}", m_capacity, alignment);
+
+        // Allocations never wrap, if it does not fit before the end of the ring it starts from the beginning
+        const uint64_t begin = AlignUp(m_head, alignment);
+        const uint64_t physicalBegin = begin % m_capacity;
+        return (physicalBegin + numBytes > m_capacity) ? begin + (m_capacity - physicalBegin) : begin;
+    }
+
+    uint64_t StagingRing::Allocate(uint64_t numBytes, uint64_t alignment, uint64_t fenceValue)
+    {
+        NEB_ASSERT(fenceValue > 0, "Fence value 0 is reserved, as it is always completed");
+        NEB_ASSERT(m_allocations.empty() || m_allocations.back().FenceValue <= fenceValue, "Fence values of the ring should not decrease");
+        if (numBytes == 0 || numBytes > m_capacity)
+            return InvalidOffset;
+
+        const uint64_t begin = GetAllocationBegin(numBytes, alignment);
+        const uint64_t end = begin + numBytes;
+        if (end - m_tail > m_capacity)
+            return InvalidOffset;
+
+        m_allocations.push_back(Allocation{ .End = end, .FenceValue = fenceValue });
+        m_head = end;
+        return begin % m_capacity;
+    }
+
+    void StagingRing::Release(uint64_t completedFenceValue)
+    {
+        while (!m_allocations.empty() && m_allocations.front().FenceValue <= completedFenceValue)
+        {
+            m_tail = m_allocations.front().End;
+            m_allocations.pop_front();
+        }
+
+        // Empty ring starts over, so that skipped tail does not keep large allocations from fitting
+        if (m_allocations.empty())
+        {
+            m_head = 0;
+            m_tail = 0;
+        }
+    }
+
+    uint64_t StagingRing::GetFenceValueToAllocate(uint64_t numBytes, uint64_t alignment) const
+    {
+        if (numBytes == 0 || numBytes > m_capacity)
+            return UINT64_MAX;
+
+        // Releasing allocations does not move the head, so the allocation begins at the same place no matter how many are released
+        const uint64_t end = GetAllocationBegin(numBytes, alignment) + numBytes;
+        if (end - m_tail <= m_capacity)
+            return 0;
+
+        for (const Allocation& allocation : m_allocations)
+        {
+            if (end - allocation.End <= m_capacity)
+                return allocation.FenceValue;
+        }
+
+        // Only fits once the ring is empty and starts over
+        return m_allocations.empty() ? 0 : m_allocations.back().FenceValue;
+    }
+
+} // Neb namespace
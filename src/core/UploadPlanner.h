@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    // CPU side of staging uploads, does not depend on D3D12 (see nri::UploadService for the GPU side).
+    //
+    // Uploads are planned as pieces of requests packed into chunks. Each chunk is allocated from the staging ring at once,
+    // filled and then copied from by a single command list, so that the copy queue can drain a chunk while the next one is filled
+
+    // Staging range of a single upload (a buffer or a subresource of a texture)
+    struct UploadRequestDesc
+    {
+        uint64_t NumBytes = 0;
+        uint64_t Alignment = 1;        // of the staging offset of every piece, power of 2
+        uint64_t SplitGranularity = 0; // pieces are multiples of it (row pitch of textures), 0 if the request cannot be split
+    };
+
+    struct UploadPiece
+    {
+        uint32_t Request = 0;
+        uint64_t RequestOffset = 0; // in bytes, into the request. Always a multiple of its split granularity
+        uint64_t NumBytes = 0;
+        uint64_t ChunkOffset = 0;   // in bytes, aligned to the request alignment
+    };
+
+    struct UploadChunk
+    {
+        uint64_t NumBytes = 0;  // including alignment padding between pieces
+        uint64_t Alignment = 1; // max alignment of its pieces, the chunk has to be allocated with it
+        uint32_t FirstPiece = 0;
+        uint32_t NumPieces = 0;
+    };
+
+    struct UploadPlan
+    {
+        std::vector<UploadChunk> Chunks;
+        std::vector<UploadPiece> Pieces;
+    };
+
+    // Requests are packed in order, so that chunks can be submitted as soon as they are filled. Splittable requests are split
+    // between chunks when they do not fit. Requests that cannot be split (or granules) larger than chunkSize get a chunk of their own,
+    // that is larger than chunkSize
+    void PlanUploads(UploadPlan& plan, std::span<const UploadRequestDesc> requests, uint64_t chunkSize);
+
+    // Checks that every byte of every request is covered exactly once, pieces are aligned and do not overlap
+    // and chunks only exceed chunkSize if they hold a single piece that does not fit otherwise
+    bool ValidateUploadPlan(const UploadPlan& plan, std::span<const UploadRequestDesc> requests, uint64_t chunkSize);
+
+    // Ring allocator over fixed-size staging memory. Every allocation is tagged with the fence value of the submission
+    // that reads from it, allocations are released in order once that value is completed. Offsets are never split
+    // across the end of the ring, the tail of the ring is skipped instead
+    class StagingRing
+    {
+    public:
+        static constexpr uint64_t InvalidOffset = UINT64_MAX;
+
+        StagingRing() = default;
+
+        // Capacity should be a multiple of every alignment that is going to be requested
+        explicit StagingRing(uint64_t capacity);
+
+        // Returns InvalidOffset if there is not enough contiguous free space. Fence values should not decrease and cannot be 0
+        uint64_t Allocate(uint64_t numBytes, uint64_t alignment, uint64_t fenceValue);
+
+        // Releases every allocation, whose fence value is completed
+        void Release(uint64_t completedFenceValue);
+
+        // Fence value that has to be completed before the allocation fits, 0 if it fits already.
+        // UINT64_MAX if it never fits (larger than capacity)
+        uint64_t GetFenceValueToAllocate(uint64_t numBytes, uint64_t alignment) const;
+
+        uint64_t GetCapacity() const { return m_capacity; }
+        uint64_t GetNumUsedBytes() const { return m_head - m_tail; } // including skipped tails
+        uint32_t GetNumAllocations() const { return static_cast<uint32_t>(m_allocations.size()); }
+
+    private:
+        // Offsets are virtual and only ever grow, physical offset is virtual one modulo capacity
+        uint64_t GetAllocationBegin(uint64_t numBytes, uint64_t alignment) const;
+
+        struct Allocation
+        {
+            uint64_t End = 0;
+            uint64_t FenceValue = 0;
+        };
+
+        uint64_t m_capacity = 0;
+        uint64_t m_head = 0;
+        uint64_t m_tail = 0;
+        std::deque<Allocation> m_allocations;
+    };
+
+} // Neb namespace
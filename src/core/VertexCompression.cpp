@@ -0,0 +1,665 @@
+#include "VertexCompression.h"
+
+#include "../common/Assert.h"
+#include "../util/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+// F16C comes with every AVX2 CPU, MSVC does not define a separate macro for it
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define NEB_VERTEX_COMPRESSION_F16C 1
+#endif
+
+namespace Neb
+{
+
+    namespace
+    {
+        static constexpr float Snorm16Max = 32767.0f;
+        static constexpr float Unorm16Max = 65535.0f;
+        static constexpr float Unorm15Max = 32767.0f;
+        static constexpr uint32_t TangentHandednessBit = 1u << 31;
+
+        // Theoretical bounds of the format with a bit of slack for float math. Angular bounds are a bit more than the half-diagonal
+        // of a quantization cell, scaled by the largest stretch of the octahedral mapping
+        static constexpr float MaxAcceptablePositionError = (0.5f / Snorm16Max) * 1.01f + 1e-6f;
+        static constexpr float MaxAcceptableNormalAngle = 1e-4f;
+        static constexpr float MaxAcceptableTangentAngle = 2e-4f;
+        static constexpr float MaxAcceptableTexCoordError = 1.0f / 2048.0f * 1.001f; // half has 11 bits of precision
+        static constexpr float MinNormalHalf = 1.0f / 16384.0f;
+
+        struct Float2
+        {
+            float x, y;
+        };
+
+        struct Float3
+        {
+            float x, y, z;
+        };
+
+        struct Float4
+        {
+            float x, y, z, w;
+        };
+
+        Float2 LoadFloat2(const std::byte* src, uint32_t stride, size_t i) { Float2 v; std::memcpy(&v, src + i * stride, sizeof(Float2)); return v; }
+        Float3 LoadFloat3(const std::byte* src, uint32_t stride, size_t i) { Float3 v; std::memcpy(&v, src + i * stride, sizeof(Float3)); return v; }
+        Float4 LoadFloat4(const std::byte* src, uint32_t stride, size_t i) { Float4 v; std::memcpy(&v, src + i * stride, sizeof(Float4)); return v; }
+
+        float SignNotZero(float v) { return (v > 0.0f) ? 1.0f : -1.0f; }
+        int32_t RoundToInt(float v) { return static_cast<int32_t>(std::lrint(v)); } // nearest-even, same as cvtps2dq
+
+        // Oct16_FastPack, vectors of zero length go to the center of the octahedron
+        Float2 OctahedralEncode(const Float3& v)
+        {
+            const float l1 = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+            const float px = (l1 > 0.0f) ? v.x / l1 : 0.0f;
+            const float py = (l1 > 0.0f) ? v.y / l1 : 0.0f;
+            if (v.z < 0.0f)
+                return Float2{ (1.0f - std::abs(py)) * SignNotZero(px), (1.0f - std::abs(px)) * SignNotZero(py) };
+
+            return Float2{ px, py };
+        }
+
+        // Oct16_FastUnpack
+        Float3 OctahedralDecode(float ex, float ey)
+        {
+            Float3 v = Float3{ ex, ey, 1.0f - std::abs(ex) - std::abs(ey) };
+            if (v.z < 0.0f)
+            {
+                v.x = (1.0f - std::abs(ey)) * SignNotZero(ex);
+                v.y = (1.0f - std::abs(ex)) * SignNotZero(ey);
+            }
+
+            const float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+            return Float3{ v.x / length, v.y / length, v.z / length };
+        }
+
+        int32_t EncodeSnorm16(float v) { return RoundToInt(std::clamp(v, -1.0f, 1.0f) * Snorm16Max); }
+        float DecodeSnorm16(int16_t v) { return std::max(float(v) / Snorm16Max, -1.0f); }
+
+        uint32_t PackSnorm16x2(int32_t x, int32_t y) { return (uint32_t(x) & 0xffff) | (uint32_t(y) << 16); }
+        int16_t UnpackSnorm16(uint32_t packed, uint32_t shift) { return static_cast<int16_t>((packed >> shift) & 0xffff); }
+
+        uint32_t EncodeTangentBits(int32_t x, int32_t y, float w) { return uint32_t(x) | (uint32_t(y) << 16) | ((w < 0.0f) ? TangentHandednessBit : 0u); }
+
+        // IEEE 754 binary16 with round to nearest even, same as F16C. Overflow goes to infinity, NaN stays NaN
+        uint16_t FloatToHalf(float v)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &v, sizeof(float));
+
+            const uint32_t sign = (bits >> 16) & 0x8000;
+            const uint32_t absBits = bits & 0x7fffffff;
+            if (absBits >= 0x7f800000)
+                return static_cast<uint16_t>(sign | 0x7c00 | ((absBits > 0x7f800000) ? 0x200 : 0));
+
+            // 65520 and more round to infinity
+            if (absBits >= 0x477ff000)
+                return static_cast<uint16_t>(sign | 0x7c00);
+
+            if (absBits < 0x38800000)
+            {
+                // Subnormal half (or zero). Shift the mantissa with implicit bit into place and round
+                if (absBits < 0x33000000)
+                    return static_cast<uint16_t>(sign);
+
+                const uint32_t exponent = absBits >> 23;
+                const uint32_t mantissa = (absBits & 0x7fffff) | 0x800000;
+                const uint32_t shift = 126 - exponent;
+                const uint32_t halfMantissa = mantissa >> shift;
+                const uint32_t remainder = mantissa & ((1u << shift) - 1);
+                const uint32_t halfway = 1u << (shift - 1);
+                const uint32_t roundUp = (remainder > halfway || (remainder == halfway && (halfMantissa & 1))) ? 1 : 0;
+                return static_cast<uint16_t>(sign | (halfMantissa + roundUp));
+            }
+
+            // Normal half. Rebias the exponent and round away 13 bits of mantissa, carry into the exponent is fine
+            const uint32_t rebiased = absBits - (112u << 23);
+            const uint32_t roundUp = ((rebiased & 0x1fff) > 0x1000 || ((rebiased & 0x1fff) == 0x1000 && (rebiased & 0x2000))) ? 1 : 0;
+            return static_cast<uint16_t>(sign | ((rebiased >> 13) + roundUp));
+        }
+
+        float HalfToFloat(uint16_t h)
+        {
+            const uint32_t sign = uint32_t(h & 0x8000) << 16;
+            const uint32_t exponent = (h >> 10) & 0x1f;
+            const uint32_t mantissa = h & 0x3ff;
+
+            uint32_t bits;
+            if (exponent == 0x1f)
+                bits = sign | 0x7f800000 | (mantissa << 13);
+            else if (exponent != 0)
+                bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+            else
+            {
+                const float subnormal = float(mantissa) * (1.0f / 16777216.0f); // 2^-24
+                std::memcpy(&bits, &subnormal, sizeof(float));
+                bits |= sign;
+            }
+
+            float v;
+            std::memcpy(&v, &bits, sizeof(float));
+            return v;
+        }
+
+#if defined(__AVX2__)
+        using FloatV = __m256;
+        using IntV = __m256i;
+        static constexpr uint32_t SimdWidth = 8;
+
+        FloatV SetV(float v) { return _mm256_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm256_load_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm256_store_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+        FloatV SubV(FloatV a, FloatV b) { return _mm256_sub_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+        FloatV DivV(FloatV a, FloatV b) { return _mm256_div_ps(a, b); }
+        FloatV SqrtV(FloatV a) { return _mm256_sqrt_ps(a); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm256_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm256_max_ps(a, b); }
+        FloatV AndNotV(FloatV a, FloatV b) { return _mm256_andnot_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm256_blendv_ps(b, a, mask); }
+        IntV RoundToIntV(FloatV a) { return _mm256_cvtps_epi32(a); }
+        FloatV IntToFloatV(IntV a) { return _mm256_cvtepi32_ps(a); }
+        IntV LoadIntV(const int32_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+        void StoreIntV(int32_t* p, IntV v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+#else
+        // SSE2 is always there on x64
+        using FloatV = __m128;
+        using IntV = __m128i;
+        static constexpr uint32_t SimdWidth = 4;
+
+        FloatV SetV(float v) { return _mm_set1_ps(v); }
+        FloatV LoadV(const float* p) { return _mm_load_ps(p); }
+        void StoreV(float* p, FloatV v) { _mm_store_ps(p, v); }
+        FloatV AddV(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+        FloatV SubV(FloatV a, FloatV b) { return _mm_sub_ps(a, b); }
+        FloatV MulV(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+        FloatV DivV(FloatV a, FloatV b) { return _mm_div_ps(a, b); }
+        FloatV SqrtV(FloatV a) { return _mm_sqrt_ps(a); }
+        FloatV MinV(FloatV a, FloatV b) { return _mm_min_ps(a, b); }
+        FloatV MaxV(FloatV a, FloatV b) { return _mm_max_ps(a, b); }
+        FloatV AndNotV(FloatV a, FloatV b) { return _mm_andnot_ps(a, b); }
+        FloatV GreaterV(FloatV a, FloatV b) { return _mm_cmpgt_ps(a, b); }
+        FloatV LessV(FloatV a, FloatV b) { return _mm_cmplt_ps(a, b); }
+        FloatV SelectV(FloatV mask, FloatV a, FloatV b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+        IntV RoundToIntV(FloatV a) { return _mm_cvtps_epi32(a); }
+        FloatV IntToFloatV(IntV a) { return _mm_cvtepi32_ps(a); }
+        IntV LoadIntV(const int32_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+        void StoreIntV(int32_t* p, IntV v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+#endif
+
+        // Lanes are gathered from (and scattered to) strided streams through aligned arrays, same as in MeshTangents.cpp
+        struct alignas(32) LaneArray
+        {
+            float Values[SimdWidth];
+
+            FloatV Load() const { return LoadV(Values); }
+            void Store(FloatV v) { StoreV(Values, v); }
+        };
+
+        struct alignas(32) IntLaneArray
+        {
+            int32_t Values[SimdWidth];
+
+            IntV Load() const { return LoadIntV(Values); }
+            void Store(IntV v) { StoreIntV(Values, v); }
+        };
+
+        FloatV AbsV(FloatV a) { return AndNotV(SetV(-0.0f), a); }
+        FloatV SignNotZeroV(FloatV a) { return SelectV(GreaterV(a, SetV(0.0f)), SetV(1.0f), SetV(-1.0f)); }
+        FloatV ClampV(FloatV a, float min, float max) { return MinV(MaxV(a, SetV(min)), SetV(max)); }
+
+        // Same as OctahedralEncode
+        void OctahedralEncodeV(FloatV x, FloatV y, FloatV z, FloatV& ex, FloatV& ey)
+        {
+            const FloatV zero = SetV(0.0f);
+            const FloatV l1 = AddV(AddV(AbsV(x), AbsV(y)), AbsV(z));
+            const FloatV isValid = GreaterV(l1, zero);
+            const FloatV safeL1 = SelectV(isValid, l1, SetV(1.0f));
+            const FloatV px = SelectV(isValid, DivV(x, safeL1), zero);
+            const FloatV py = SelectV(isValid, DivV(y, safeL1), zero);
+
+            const FloatV one = SetV(1.0f);
+            const FloatV isLowerHemisphere = LessV(z, zero);
+            ex = SelectV(isLowerHemisphere, MulV(SubV(one, AbsV(py)), SignNotZeroV(px)), px);
+            ey = SelectV(isLowerHemisphere, MulV(SubV(one, AbsV(px)), SignNotZeroV(py)), py);
+        }
+
+        // Same as OctahedralDecode
+        void OctahedralDecodeV(FloatV ex, FloatV ey, FloatV& x, FloatV& y, FloatV& z)
+        {
+            const FloatV one = SetV(1.0f);
+            const FloatV vz = SubV(SubV(one, AbsV(ex)), AbsV(ey));
+            const FloatV isLowerHemisphere = LessV(vz, SetV(0.0f));
+            const FloatV vx = SelectV(isLowerHemisphere, MulV(SubV(one, AbsV(ey)), SignNotZeroV(ex)), ex);
+            const FloatV vy = SelectV(isLowerHemisphere, MulV(SubV(one, AbsV(ex)), SignNotZeroV(ey)), ey);
+
+            const FloatV length = SqrtV(AddV(AddV(MulV(vx, vx), MulV(vy, vy)), MulV(vz, vz)));
+            x = DivV(vx, length);
+            y = DivV(vy, length);
+            z = DivV(vz, length);
+        }
+
+        FloatV DecodeSnorm16V(FloatV v) { return MaxV(DivV(v, SetV(Snorm16Max)), SetV(-1.0f)); }
+
+        double GetAngleBetween(const Float3& a, const Float3& b)
+        {
+            // atan2 keeps precision for tiny angles, unlike acos of the dot product
+            const double cx = double(a.y) * b.z - double(a.z) * b.y;
+            const double cy = double(a.z) * b.x - double(a.x) * b.z;
+            const double cz = double(a.x) * b.y - double(a.y) * b.x;
+            const double dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+            return std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), dot);
+        }
+    } // anonymous namespace
+
+    PositionQuantization ComputePositionQuantization(const std::byte* positions, uint32_t stride, uint32_t numVertices)
+    {
+        PositionQuantization quantization;
+        if (numVertices == 0)
+            return quantization;
+
+        Float3 min = LoadFloat3(positions, stride, 0);
+        Float3 max = min;
+        for (uint32_t i = 1; i < numVertices; ++i)
+        {
+            const Float3 p = LoadFloat3(positions, stride, i);
+            min = Float3{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+            max = Float3{ std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+        }
+
+        const float mins[3] = { min.x, min.y, min.z };
+        const float maxs[3] = { max.x, max.y, max.z };
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            quantization.Bias[axis] = (mins[axis] + maxs[axis]) * 0.5f;
+
+            // Flat axis is encoded as zeroes, any non-zero scale decodes it exactly
+            const float halfExtent = (maxs[axis] - mins[axis]) * 0.5f;
+            quantization.Scale[axis] = (halfExtent > 0.0f) ? halfExtent : 1.0f;
+        }
+        return quantization;
+    }
+
+    void EncodePositions(std::span<CompactPosition> dst, const std::byte* positions, uint32_t stride, const PositionQuantization& quantization)
+    {
+        const float invScale[3] = { 1.0f / quantization.Scale[0], 1.0f / quantization.Scale[1], 1.0f / quantization.Scale[2] };
+
+        const uint32_t numVertices = static_cast<uint32_t>(dst.size());
+        uint32_t vertex = 0;
+        for (; vertex + SimdWidth <= numVertices; vertex += SimdWidth)
+        {
+            LaneArray lanes[3];
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                const Float3 p = LoadFloat3(positions, stride, vertex + lane);
+                lanes[0].Values[lane] = p.x;
+                lanes[1].Values[lane] = p.y;
+                lanes[2].Values[lane] = p.z;
+            }
+
+            IntLaneArray encoded[3];
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                const FloatV normalized = MulV(SubV(lanes[axis].Load(), SetV(quantization.Bias[axis])), SetV(invScale[axis]));
+                encoded[axis].Store(RoundToIntV(MulV(ClampV(normalized, -1.0f, 1.0f), SetV(Snorm16Max))));
+            }
+
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                dst[vertex + lane] = CompactPosition{
+                    static_cast<int16_t>(encoded[0].Values[lane]),
+                    static_cast<int16_t>(encoded[1].Values[lane]),
+                    static_cast<int16_t>(encoded[2].Values[lane]),
+                    0 };
+            }
+        }
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const Float3 p = LoadFloat3(positions, stride, vertex);
+            dst[vertex] = CompactPosition{
+                static_cast<int16_t>(EncodeSnorm16((p.x - quantization.Bias[0]) * invScale[0])),
+                static_cast<int16_t>(EncodeSnorm16((p.y - quantization.Bias[1]) * invScale[1])),
+                static_cast<int16_t>(EncodeSnorm16((p.z - quantization.Bias[2]) * invScale[2])),
+                0 };
+        }
+    }
+
+    void EncodeNormals(std::span<uint32_t> dst, const std::byte* normals, uint32_t stride)
+    {
+        const uint32_t numVertices = static_cast<uint32_t>(dst.size());
+        uint32_t vertex = 0;
+        for (; vertex + SimdWidth <= numVertices; vertex += SimdWidth)
+        {
+            LaneArray x, y, z;
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                const Float3 n = LoadFloat3(normals, stride, vertex + lane);
+                x.Values[lane] = n.x;
+                y.Values[lane] = n.y;
+                z.Values[lane] = n.z;
+            }
+
+            FloatV ex, ey;
+            OctahedralEncodeV(x.Load(), y.Load(), z.Load(), ex, ey);
+
+            IntLaneArray encodedX, encodedY;
+            encodedX.Store(RoundToIntV(MulV(ClampV(ex, -1.0f, 1.0f), SetV(Snorm16Max))));
+            encodedY.Store(RoundToIntV(MulV(ClampV(ey, -1.0f, 1.0f), SetV(Snorm16Max))));
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                dst[vertex + lane] = PackSnorm16x2(encodedX.Values[lane], encodedY.Values[lane]);
+        }
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const Float2 e = OctahedralEncode(LoadFloat3(normals, stride, vertex));
+            dst[vertex] = PackSnorm16x2(EncodeSnorm16(e.x), EncodeSnorm16(e.y));
+        }
+    }
+
+    void EncodeTexCoords(std::span<uint32_t> dst, const std::byte* texCoords, uint32_t stride)
+    {
+        const uint32_t numVertices = static_cast<uint32_t>(dst.size());
+        uint32_t vertex = 0;
+#if defined(NEB_VERTEX_COMPRESSION_F16C)
+        // 4 texcoords (8 floats) at a time
+        for (; vertex + 4 <= numVertices; vertex += 4)
+        {
+            alignas(32) float values[8];
+            for (uint32_t i = 0; i < 4; ++i)
+                std::memcpy(&values[i * 2], texCoords + size_t(vertex + i) * stride, sizeof(Float2));
+
+            const __m128i halves = _mm256_cvtps_ph(_mm256_load_ps(values), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&dst[vertex]), halves);
+        }
+#endif
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const Float2 uv = LoadFloat2(texCoords, stride, vertex);
+            dst[vertex] = uint32_t(FloatToHalf(uv.x)) | (uint32_t(FloatToHalf(uv.y)) << 16);
+        }
+    }
+
+    void EncodeTangents(std::span<uint32_t> dst, const std::byte* tangents, uint32_t stride)
+    {
+        const uint32_t numVertices = static_cast<uint32_t>(dst.size());
+        uint32_t vertex = 0;
+        for (; vertex + SimdWidth <= numVertices; vertex += SimdWidth)
+        {
+            LaneArray x, y, z, w;
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                const Float4 t = LoadFloat4(tangents, stride, vertex + lane);
+                x.Values[lane] = t.x;
+                y.Values[lane] = t.y;
+                z.Values[lane] = t.z;
+                w.Values[lane] = t.w;
+            }
+
+            FloatV ex, ey;
+            OctahedralEncodeV(x.Load(), y.Load(), z.Load(), ex, ey);
+
+            // [-1, 1] -> [0, 1] -> unorm
+            const FloatV half = SetV(0.5f);
+            IntLaneArray encodedX, encodedY;
+            encodedX.Store(RoundToIntV(MulV(AddV(MulV(ClampV(ex, -1.0f, 1.0f), half), half), SetV(Unorm16Max))));
+            encodedY.Store(RoundToIntV(MulV(AddV(MulV(ClampV(ey, -1.0f, 1.0f), half), half), SetV(Unorm15Max))));
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                dst[vertex + lane] = EncodeTangentBits(encodedX.Values[lane], encodedY.Values[lane], w.Values[lane]);
+        }
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const Float4 t = LoadFloat4(tangents, stride, vertex);
+            const Float2 e = OctahedralEncode(Float3{ t.x, t.y, t.z });
+            dst[vertex] = EncodeTangentBits(
+                RoundToInt((std::clamp(e.x, -1.0f, 1.0f) * 0.5f + 0.5f) * Unorm16Max),
+                RoundToInt((std::clamp(e.y, -1.0f, 1.0f) * 0.5f + 0.5f) * Unorm15Max),
+                t.w);
+        }
+    }
+
+    void DecodePositions(float* dst, std::span<const CompactPosition> src, const PositionQuantization& quantization)
+    {
+        const uint32_t numVertices = static_cast<uint32_t>(src.size());
+        uint32_t vertex = 0;
+        for (; vertex + SimdWidth <= numVertices; vertex += SimdWidth)
+        {
+            IntLaneArray lanes[3];
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                lanes[0].Values[lane] = src[vertex + lane].x;
+                lanes[1].Values[lane] = src[vertex + lane].y;
+                lanes[2].Values[lane] = src[vertex + lane].z;
+            }
+
+            LaneArray decoded[3];
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                const FloatV normalized = DecodeSnorm16V(IntToFloatV(lanes[axis].Load()));
+                decoded[axis].Store(AddV(SetV(quantization.Bias[axis]), MulV(SetV(quantization.Scale[axis]), normalized)));
+            }
+
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                    dst[size_t(vertex + lane) * 3 + axis] = decoded[axis].Values[lane];
+        }
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const int16_t encoded[3] = { src[vertex].x, src[vertex].y, src[vertex].z };
+            for (uint32_t axis = 0; axis < 3; ++axis)
+                dst[size_t(vertex) * 3 + axis] = quantization.Bias[axis] + quantization.Scale[axis] * DecodeSnorm16(encoded[axis]);
+        }
+    }
+
+    void DecodeNormals(float* dst, std::span<const uint32_t> src)
+    {
+        const uint32_t numVertices = static_cast<uint32_t>(src.size());
+        uint32_t vertex = 0;
+        for (; vertex + SimdWidth <= numVertices; vertex += SimdWidth)
+        {
+            IntLaneArray encodedX, encodedY;
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                encodedX.Values[lane] = UnpackSnorm16(src[vertex + lane], 0);
+                encodedY.Values[lane] = UnpackSnorm16(src[vertex + lane], 16);
+            }
+
+            FloatV x, y, z;
+            OctahedralDecodeV(DecodeSnorm16V(IntToFloatV(encodedX.Load())), DecodeSnorm16V(IntToFloatV(encodedY.Load())), x, y, z);
+
+            LaneArray decoded[3];
+            decoded[0].Store(x);
+            decoded[1].Store(y);
+            decoded[2].Store(z);
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+                for (uint32_t axis = 0; axis < 3; ++axis)
+                    dst[size_t(vertex + lane) * 3 + axis] = decoded[axis].Values[lane];
+        }
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const Float3 n = OctahedralDecode(DecodeSnorm16(UnpackSnorm16(src[vertex], 0)), DecodeSnorm16(UnpackSnorm16(src[vertex], 16)));
+            std::memcpy(dst + size_t(vertex) * 3, &n, sizeof(Float3));
+        }
+    }
+
+    void DecodeTexCoords(float* dst, std::span<const uint32_t> src)
+    {
+        const uint32_t numVertices = static_cast<uint32_t>(src.size());
+        uint32_t vertex = 0;
+#if defined(NEB_VERTEX_COMPRESSION_F16C)
+        for (; vertex + 4 <= numVertices; vertex += 4)
+        {
+            const __m128i halves = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[vertex]));
+            _mm256_storeu_ps(dst + size_t(vertex) * 2, _mm256_cvtph_ps(halves));
+        }
+#endif
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            dst[size_t(vertex) * 2 + 0] = HalfToFloat(static_cast<uint16_t>(src[vertex] & 0xffff));
+            dst[size_t(vertex) * 2 + 1] = HalfToFloat(static_cast<uint16_t>(src[vertex] >> 16));
+        }
+    }
+
+    void DecodeTangents(float* dst, std::span<const uint32_t> src)
+    {
+        const float scaleX = 2.0f / Unorm16Max;
+        const float scaleY = 2.0f / Unorm15Max;
+
+        const uint32_t numVertices = static_cast<uint32_t>(src.size());
+        uint32_t vertex = 0;
+        for (; vertex + SimdWidth <= numVertices; vertex += SimdWidth)
+        {
+            IntLaneArray encodedX, encodedY;
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                encodedX.Values[lane] = static_cast<int32_t>(src[vertex + lane] & 0xffff);
+                encodedY.Values[lane] = static_cast<int32_t>((src[vertex + lane] >> 16) & 0x7fff);
+            }
+
+            const FloatV one = SetV(1.0f);
+            const FloatV ex = SubV(MulV(IntToFloatV(encodedX.Load()), SetV(scaleX)), one);
+            const FloatV ey = SubV(MulV(IntToFloatV(encodedY.Load()), SetV(scaleY)), one);
+
+            FloatV x, y, z;
+            OctahedralDecodeV(ex, ey, x, y, z);
+
+            LaneArray decoded[3];
+            decoded[0].Store(x);
+            decoded[1].Store(y);
+            decoded[2].Store(z);
+            for (uint32_t lane = 0; lane < SimdWidth; ++lane)
+            {
+                float* tangent = dst + size_t(vertex + lane) * 4;
+                tangent[0] = decoded[0].Values[lane];
+                tangent[1] = decoded[1].Values[lane];
+                tangent[2] = decoded[2].Values[lane];
+                tangent[3] = (src[vertex + lane] & TangentHandednessBit) ? -1.0f : 1.0f;
+            }
+        }
+
+        for (; vertex < numVertices; ++vertex)
+        {
+            const Float3 t = OctahedralDecode(float(src[vertex] & 0xffff) * scaleX - 1.0f, float((src[vertex] >> 16) & 0x7fff) * scaleY - 1.0f);
+            float* tangent = dst + size_t(vertex) * 4;
+            tangent[0] = t.x;
+            tangent[1] = t.y;
+            tangent[2] = t.z;
+            tangent[3] = (src[vertex] & TangentHandednessBit) ? -1.0f : 1.0f;
+        }
+    }
+
+    void CompressVertices(CompressedVertexData& dst, const VertexCompressionSourceDesc& src)
+    {
+        NEB_ASSERT(src.Positions && src.Normals && src.TexCoords && src.Tangents, "Every stream is needed for compression");
+
+        dst.Quantization = ComputePositionQuantization(src.Positions, src.PositionsStride, src.NumVertices);
+        dst.Positions.resize(src.NumVertices);
+        dst.Normals.resize(src.NumVertices);
+        dst.TexCoords.resize(src.NumVertices);
+        dst.Tangents.resize(src.NumVertices);
+
+        EncodePositions(dst.Positions, src.Positions, src.PositionsStride, dst.Quantization);
+        EncodeNormals(dst.Normals, src.Normals, src.NormalsStride);
+        EncodeTexCoords(dst.TexCoords, src.TexCoords, src.TexCoordsStride);
+        EncodeTangents(dst.Tangents, src.Tangents, src.TangentsStride);
+    }
+
+    void CompressVertices(std::span<CompressedVertexData> dst, std::span<const VertexCompressionSourceDesc> srcs, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(dst.size() == srcs.size(), "Each source should have its own compressed data");
+
+        threadPool.ParallelFor(srcs.size(), [&dst, &srcs](size_t i)
+            {
+                CompressVertices(dst[i], srcs[i]);
+            });
+    }
+
+    VertexCompressionError MeasureVertexCompressionError(const CompressedVertexData& compressed, const VertexCompressionSourceDesc& src)
+    {
+        NEB_ASSERT(compressed.Positions.size() == src.NumVertices, "Compressed data does not match the source");
+
+        VertexCompressionError error;
+        const uint32_t numVertices = src.NumVertices;
+
+        std::vector<float> decoded(size_t(numVertices) * 4);
+        DecodePositions(decoded.data(), compressed.Positions, compressed.Quantization);
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const Float3 p = LoadFloat3(src.Positions, src.PositionsStride, i);
+            const float source[3] = { p.x, p.y, p.z };
+            for (uint32_t axis = 0; axis < 3; ++axis)
+            {
+                const float difference = std::abs(decoded[size_t(i) * 3 + axis] - source[axis]);
+                error.MaxPositionError = std::max(error.MaxPositionError, difference / compressed.Quantization.Scale[axis]);
+            }
+        }
+
+        DecodeNormals(decoded.data(), compressed.Normals);
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const Float3 n = LoadFloat3(src.Normals, src.NormalsStride, i);
+            if (n.x * n.x + n.y * n.y + n.z * n.z <= FLT_MIN)
+                continue; // nothing to preserve
+
+            Float3 d;
+            std::memcpy(&d, &decoded[size_t(i) * 3], sizeof(Float3));
+            error.MaxNormalAngle = std::max(error.MaxNormalAngle, float(GetAngleBetween(n, d)));
+        }
+
+        DecodeTexCoords(decoded.data(), compressed.TexCoords);
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const Float2 uv = LoadFloat2(src.TexCoords, src.TexCoordsStride, i);
+            const float source[2] = { uv.x, uv.y };
+            for (uint32_t k = 0; k < 2; ++k)
+            {
+                const float difference = std::abs(decoded[size_t(i) * 2 + k] - source[k]);
+                const float relative = difference / std::max(std::abs(source[k]), MinNormalHalf);
+
+                // Out of range texcoords decode to infinity, make sure that it is never accepted
+                error.MaxTexCoordError = std::max(error.MaxTexCoordError, std::isfinite(relative) ? relative : FLT_MAX);
+            }
+        }
+
+        DecodeTangents(decoded.data(), compressed.Tangents);
+        for (uint32_t i = 0; i < numVertices; ++i)
+        {
+            const Float4 t = LoadFloat4(src.Tangents, src.TangentsStride, i);
+            const float* d = &decoded[size_t(i) * 4];
+            if ((t.w < 0.0f) != (d[3] < 0.0f))
+                ++error.NumHandednessMismatches;
+
+            if (t.x * t.x + t.y * t.y + t.z * t.z <= FLT_MIN)
+                continue;
+
+            error.MaxTangentAngle = std::max(error.MaxTangentAngle, float(GetAngleBetween(Float3{ t.x, t.y, t.z }, Float3{ d[0], d[1], d[2] })));
+        }
+
+        return error;
+    }
+
+    bool IsVertexCompressionErrorAcceptable(const VertexCompressionError& error)
+    {
+        return error.MaxPositionError <= MaxAcceptablePositionError
+            && error.MaxNormalAngle <= MaxAcceptableNormalAngle
+            && error.MaxTexCoordError <= MaxAcceptableTexCoordError
+            && error.MaxTangentAngle <= MaxAcceptableTangentAngle
+            && error.NumHandednessMismatches == 0;
+    }
+
+} // Neb namespace
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb
+{
+
+    class ThreadPool;
+
+    // Compact vertex format is 20 bytes per vertex, split into the same 4 streams as the full one (48 bytes per vertex):
+    // - position: 4x snorm16 (DXGI_FORMAT_R16G16B16A16_SNORM), quantized to the AABB of the submesh, w is always 0
+    // - normal:   2x snorm16 (DXGI_FORMAT_R16G16_SNORM), octahedral encoding
+    // - texcoord: 2x half    (DXGI_FORMAT_R16G16_FLOAT)
+    // - tangent:  uint32     (DXGI_FORMAT_R32_UINT), octahedral encoding, x is unorm16 in bits [0, 16), y is unorm15 in bits [16, 31),
+    //             bit 31 is set if handedness is negative
+    // Octahedral encoding is the same as in octahedron_encoding.hlsli (Oct16_FastPack), decoding of every stream is mirrored in shaders
+    struct CompactPosition
+    {
+        int16_t x, y, z, w;
+    };
+
+    // position = Bias + Scale * snorm(position). Bias is the center of the box and Scale is its half-extent
+    struct PositionQuantization
+    {
+        float Scale[3] = { 1.0f, 1.0f, 1.0f };
+        float Bias[3] = {};
+    };
+
+    // Source streams of a single submesh, may be strided (interleaved)
+    struct VertexCompressionSourceDesc
+    {
+        uint32_t NumVertices = 0;
+        const std::byte* Positions = nullptr; // float3
+        uint32_t PositionsStride = sizeof(float) * 3;
+        const std::byte* Normals = nullptr;   // float3
+        uint32_t NormalsStride = sizeof(float) * 3;
+        const std::byte* TexCoords = nullptr; // float2
+        uint32_t TexCoordsStride = sizeof(float) * 2;
+        const std::byte* Tangents = nullptr;  // float4, w is handedness
+        uint32_t TangentsStride = sizeof(float) * 4;
+    };
+
+    struct CompressedVertexData
+    {
+        PositionQuantization Quantization;
+        std::vector<CompactPosition> Positions;
+        std::vector<uint32_t> Normals;
+        std::vector<uint32_t> TexCoords;
+        std::vector<uint32_t> Tangents;
+    };
+
+    // Max round-trip errors of compressed vertices against their source
+    struct VertexCompressionError
+    {
+        float MaxPositionError = 0.0f; // per axis, relative to the quantization scale of that axis
+        float MaxNormalAngle = 0.0f;   // in radians
+        float MaxTexCoordError = 0.0f; // relative to the magnitude of the texcoord (absolute below the smallest normal half)
+        float MaxTangentAngle = 0.0f;  // in radians
+        uint32_t NumHandednessMismatches = 0;
+    };
+
+    PositionQuantization ComputePositionQuantization(const std::byte* positions, uint32_t stride, uint32_t numVertices);
+
+    // Encoders write exactly dst.size() vertices. Math is vectorized with SSE (or AVX2 if the build targets it),
+    // leftovers go through the scalar path, which gives bitwise identical results
+    void EncodePositions(std::span<CompactPosition> dst, const std::byte* positions, uint32_t stride, const PositionQuantization& quantization);
+    void EncodeNormals(std::span<uint32_t> dst, const std::byte* normals, uint32_t stride);
+    void EncodeTexCoords(std::span<uint32_t> dst, const std::byte* texCoords, uint32_t stride);
+    void EncodeTangents(std::span<uint32_t> dst, const std::byte* tangents, uint32_t stride);
+
+    // Decoders write tightly packed float3 (positions, normals), float2 (texcoords) and float4 (tangents)
+    void DecodePositions(float* dst, std::span<const CompactPosition> src, const PositionQuantization& quantization);
+    void DecodeNormals(float* dst, std::span<const uint32_t> src);
+    void DecodeTexCoords(float* dst, std::span<const uint32_t> src);
+    void DecodeTangents(float* dst, std::span<const uint32_t> src);
+
+    // Compresses every stream of the source
+    void CompressVertices(CompressedVertexData& dst, const VertexCompressionSourceDesc& src);
+
+    // Compresses every source on the thread pool. dst and srcs are expected to be of the same size
+    void CompressVertices(std::span<CompressedVertexData> dst, std::span<const VertexCompressionSourceDesc> srcs, ThreadPool& threadPool);
+
+    // Decodes compressed vertices and compares them to the source
+    VertexCompressionError MeasureVertexCompressionError(const CompressedVertexData& compressed, const VertexCompressionSourceDesc& src);
+
+    // Checks errors against the theoretical bounds of the format. Fails for sources that do not fit the format
+    // (e.g. texcoords outside of half range), such submeshes should be kept in the full format
+    bool IsVertexCompressionErrorAcceptable(const VertexCompressionError& error);
+
+} // Neb namespace
@@ -17,6 +17,8 @@ namespace Neb::nri
 
     DescriptorHeapAllocation DescriptorHeap::AllocateDescriptors(UINT numDescriptors)
     {
+        std::lock_guard lock(m_allocationMutex);
+
         UINT beginIndex = m_nextDescriptorIndex;
         UINT nextIndex = m_nextDescriptorIndex + numDescriptors;
         if (nextIndex >= m_desc.NumDescriptors)
@@ -3,6 +3,8 @@
 #include "DescriptorHeapAllocation.h"
 #include "stdafx.h"
 
+#include <mutex>
+
 namespace Neb::nri
 {
 
@@ -14,6 +16,7 @@ namespace Neb::nri
         const D3D12_DESCRIPTOR_HEAP_DESC& GetDesc() const { return m_desc; }
         ID3D12DescriptorHeap* GetHeap() { return m_heap.Get(); }
 
+        // Thread-safe, scenes are loaded on a separate thread (see SceneLoader)
         DescriptorHeapAllocation AllocateDescriptors(UINT numDescriptors);
 
         // Checks whether or not host/device address is valid for this descriptor heap
@@ -28,6 +31,7 @@ namespace Neb::nri
         D3D12Rc<ID3D12DescriptorHeap> m_heap;
         UINT m_incrementSize = 0;
         UINT m_nextDescriptorIndex = 0;
+        std::mutex m_allocationMutex;
     };
 
 } // Neb::nri namespace
\ No newline at end of file
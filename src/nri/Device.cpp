@@ -21,6 +21,8 @@ namespace Neb::nri
 
     void NRIDevice::Deinit()
     {
+        m_uploadService.Deinit();
+
         if (NvDriver::Get()->IsValid())
             NvDriver::Get()->ShutD3D12();
 
@@ -89,6 +91,9 @@ namespace Neb::nri
         InitDescriptorHeaps();
 
         InitResourceAllocator();
+
+        // Staging ring lives in the upload heap, thus after the allocator
+        m_uploadService.Init();
     }
 
     BOOL NRIDevice::IsDxgiAdapterSuitable(IDXGIAdapter3* DxgiAdapter, const DXGI_ADAPTER_DESC1& desc) const
@@ -6,6 +6,7 @@
 
 #include "CommandAllocatorPool.h"
 #include "DescriptorHeap.h"
+#include "UploadService.h"
 
 namespace Neb::nri
 {
@@ -84,6 +85,9 @@ namespace Neb::nri
         // Resource-management calls
         D3D12MA::Allocator* GetResourceAllocator() { return m_D3D12Allocator.Get(); }
 
+        // Shared path for CPU -> GPU uploads on the copy queue
+        UploadService& GetUploadService() { return m_uploadService; }
+
     private:
         // All-in-One initialization of D3D12 stuff
         // Below these init functions goes raw D3D12 functions
@@ -120,6 +124,8 @@ namespace Neb::nri
 
         void InitResourceAllocator();
         Rc<D3D12MA::Allocator> m_D3D12Allocator;
+
+        UploadService m_uploadService;
     };
 
 }; // Neb::nri namespace
@@ -0,0 +1,78 @@
+#include "DrawPacket.h"
+
+#include "common/Assert.h"
+#include "util/ThreadPool.h"
+
+#include <unordered_map>
+
+namespace Neb::nri
+{
+
+    void DrawPacketCache::Build(std::span<const StaticMesh> meshes, std::span<const StaticMeshInstance> instances)
+    {
+        m_packets.clear();
+        m_geometries.clear();
+        m_localBoxes.clear();
+        m_quantizations.clear();
+
+        // Geometries of a mesh are contiguous, the first one of each mesh is remembered
+        std::vector<uint32_t> firstGeometries(meshes.size());
+        for (size_t meshIndex = 0; meshIndex < meshes.size(); ++meshIndex)
+        {
+            const StaticMesh& staticMesh = meshes[meshIndex];
+            NEB_ASSERT(staticMesh.Submeshes.size() == staticMesh.SubmeshMaterials.size(),
+                "Static mesh is invalid. It has {} submeshes while only {} materials",
+                staticMesh.Submeshes.size(), staticMesh.SubmeshMaterials.size());
+
+            firstGeometries[meshIndex] = static_cast<uint32_t>(m_geometries.size());
+            for (const StaticSubmesh& submesh : staticMesh.Submeshes)
+            {
+                m_geometries.push_back(DrawGeometry{
+                    .VertexViews = submesh.AttributeViews,
+                    .IndexView = submesh.IBView,
+                    .NumIndices = submesh.NumIndices,
+                    .VertexFormat = submesh.VertexFormat,
+                });
+                m_localBoxes.push_back(submesh.LocalBox);
+                m_quantizations.push_back(submesh.Quantization);
+            }
+        }
+
+        // Materials are identified by their descriptor tables, the same table is the same material state
+        std::unordered_map<UINT64, uint32_t> materialIndices;
+        for (uint32_t instanceIndex = 0; instanceIndex < instances.size(); ++instanceIndex)
+        {
+            const uint32_t meshIndex = instances[instanceIndex].MeshIndex;
+            const StaticMesh& staticMesh = meshes[meshIndex];
+            for (uint32_t submeshIndex = 0; submeshIndex < staticMesh.Submeshes.size(); ++submeshIndex)
+            {
+                const Material& material = staticMesh.SubmeshMaterials[submeshIndex];
+                const uint32_t geometryIndex = firstGeometries[meshIndex] + submeshIndex;
+                const uint32_t materialIndex = materialIndices.try_emplace(material.SrvRange.GpuAddress.ptr, static_cast<uint32_t>(materialIndices.size())).first->second;
+
+                m_packets.push_back(DrawPacket{
+                    .SortKey = MakeDrawSortKey(m_geometries[geometryIndex].VertexFormat, materialIndex, geometryIndex),
+                    .MaterialTable = material.SrvRange.GpuAddress,
+                    .GeometryIndex = geometryIndex,
+                    .TransformIndex = instanceIndex,
+                    .MaterialFlags = material.Flags,
+                });
+            }
+        }
+        m_numMaterials = static_cast<uint32_t>(materialIndices.size());
+    }
+
+    void DrawPacketSorter::Sort(const DrawPacketCache& cache, std::span<uint32_t> packetIndices, std::span<const float> distances, float nearZ, float farZ, ThreadPool& threadPool)
+    {
+        NEB_ASSERT(packetIndices.size() == distances.size(), "Draw packet sorter has {} packets while {} distances", packetIndices.size(), distances.size());
+
+        m_keys.resize(packetIndices.size());
+        threadPool.ParallelForRange(packetIndices.size(), 4096, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    m_keys[i] = cache.GetPacket(packetIndices[i]).SortKey | MakeDrawDepthBucket(distances[i], nearZ, farZ);
+            });
+        m_sorter.Sort(m_keys, packetIndices, threadPool);
+    }
+
+} // Neb::nri namespace
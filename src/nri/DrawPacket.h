@@ -0,0 +1,191 @@
+#pragma once
+
+#include "stdafx.h"
+#include "FrameUploadAllocator.h"
+#include "StaticMesh.h"
+#include "../core/Bounds.h"
+#include "../core/DrawBatching.h"
+#include "../core/RadixSort.h"
+#include "../core/VertexCompression.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Neb::nri
+{
+
+    // Hot part of a submesh, only what the command list needs to draw it. Shared by every instance of the mesh
+    struct DrawGeometry
+    {
+        std::array<D3D12_VERTEX_BUFFER_VIEW, eAttributeType_NumTypes> VertexViews = {};
+        D3D12_INDEX_BUFFER_VIEW IndexView = {};
+        UINT NumIndices = 0;
+        EVertexFormat VertexFormat = eVertexFormat_Full;
+    };
+
+    // Single draw of a submesh instance. Packets are kept compact (two per cache line) so that per-frame passes
+    // stream through them instead of chasing instances, meshes and materials of the scene
+    struct alignas(32) DrawPacket
+    {
+        uint64_t SortKey = 0; // see MakeDrawSortKey()
+        D3D12_GPU_DESCRIPTOR_HANDLE MaterialTable = {}; // Material::SrvRange
+        uint32_t GeometryIndex = 0;  // into DrawPacketCache geometries
+        uint32_t TransformIndex = 0; // into Scene::StaticMeshInstances
+        uint32_t MaterialFlags = 0;  // EMaterialFlags
+    };
+    static_assert(sizeof(DrawPacket) == 32, "Draw packets are expected to be two per cache line");
+
+    // Most significant state goes first, so that sorted packets change pipelines least often, then material tables and then
+    // geometry (vertex and index buffers). Draws of the same state are drawn front to back by the depth bucket in the lowest bits
+    static constexpr uint32_t DrawSortKeyDepthBits = 16;
+    static constexpr uint32_t DrawSortKeyGeometryBits = 24;
+    static constexpr uint32_t DrawSortKeyMaterialBits = 20;
+    static constexpr uint32_t DrawSortKeyPipelineBits = 4;
+
+    inline uint64_t MakeDrawSortKey(uint32_t pipelineIndex, uint32_t materialIndex, uint32_t geometryIndex, uint32_t depthBucket = 0)
+    {
+        auto field = [](uint32_t value, uint32_t numBits) { return uint64_t(value) & ((uint64_t(1) << numBits) - 1); };
+        return (field(pipelineIndex, DrawSortKeyPipelineBits) << (DrawSortKeyMaterialBits + DrawSortKeyGeometryBits + DrawSortKeyDepthBits))
+            | (field(materialIndex, DrawSortKeyMaterialBits) << (DrawSortKeyGeometryBits + DrawSortKeyDepthBits))
+            | (field(geometryIndex, DrawSortKeyGeometryBits) << DrawSortKeyDepthBits)
+            | field(depthBucket, DrawSortKeyDepthBits);
+    }
+
+    // Distance from the camera is bucketed logarithmically between near and far planes, so that close draws are told apart more precisely
+    inline uint32_t MakeDrawDepthBucket(float distance, float nearZ, float farZ)
+    {
+        static constexpr uint32_t MaxBucket = (1 << DrawSortKeyDepthBits) - 1;
+        const float t = std::log2(std::max(distance, nearZ) / nearZ) / std::log2(farZ / nearZ);
+        return static_cast<uint32_t>(std::clamp(t, 0.0f, 1.0f) * MaxBucket);
+    }
+
+    // Draw packets of every submesh of every instance of the scene, in the order of instances. Built once the scene changes,
+    // transforms are not part of packets (they are referenced by TransformIndex), thus moving instances does not invalidate them.
+    // Cold data of geometries (bounds, quantization) is kept apart, it is only needed when constants or boxes are updated
+    class DrawPacketCache
+    {
+    public:
+        void Build(std::span<const StaticMesh> meshes, std::span<const StaticMeshInstance> instances);
+
+        std::span<const DrawPacket> GetPackets() const { return m_packets; }
+        uint32_t GetNumPackets() const { return static_cast<uint32_t>(m_packets.size()); }
+        uint32_t GetNumGeometries() const { return static_cast<uint32_t>(m_geometries.size()); }
+        uint32_t GetNumMaterials() const { return m_numMaterials; }
+
+        const DrawPacket& GetPacket(uint32_t packetIndex) const { return m_packets[packetIndex]; }
+        const DrawGeometry& GetGeometry(uint32_t geometryIndex) const { return m_geometries[geometryIndex]; }
+        const AABB& GetLocalBox(uint32_t geometryIndex) const { return m_localBoxes[geometryIndex]; }
+        const PositionQuantization& GetQuantization(uint32_t geometryIndex) const { return m_quantizations[geometryIndex]; }
+
+    private:
+        std::vector<DrawPacket> m_packets;
+        std::vector<DrawGeometry> m_geometries;
+        std::vector<AABB> m_localBoxes;
+        std::vector<PositionQuantization> m_quantizations;
+        uint32_t m_numMaterials = 0; // distinct material tables
+    };
+
+    struct DrawRecordDesc
+    {
+        std::array<ID3D12PipelineState*, eVertexFormat_NumFormats> Pipelines = {}; // by DrawGeometry::VertexFormat
+        UINT FirstInstanceRootIndex = 0; // single 32-bit root constant, per-instance data of a draw is at FirstInstance + SV_InstanceID
+        UINT MaterialTableRootIndex = 0;
+    };
+
+    // State changes of recorded draw calls. Changes of a state that is already bound are redundant and are skipped,
+    // e.g. NumDrawCalls - NumMaterialChanges draw calls did not set their material table
+    struct DrawRecordStats
+    {
+        uint32_t NumDrawCalls = 0;
+        uint32_t NumInstances = 0;
+        uint32_t NumPipelineChanges = 0;
+        uint32_t NumMaterialChanges = 0;
+        uint32_t NumVertexBufferChanges = 0;
+        uint32_t NumIndexBufferChanges = 0;
+
+        uint32_t GetNumRedundantChanges() const { return NumDrawCalls * 4 - (NumPipelineChanges + NumMaterialChanges + NumVertexBufferChanges + NumIndexBufferChanges); }
+    };
+
+    // Records a single instanced draw call for every batch of packets, packetIndices are compacted so that packets of a batch follow
+    // each other (see DrawBatcher). Every packet of a batch should share state, the first one of the batch is drawn. i-th packet of
+    // packetIndices is the i-th instance of the frame, whose data is expected at the same index. State is only set when it differs
+    // from the one of the last draw call, draws should be sorted by their keys for that to pay off (see DrawPacketSorter).
+    // CommandList is ID3D12GraphicsCommandList (or anything with the same methods, tests and benchmarks record into a stub)
+    template<typename CommandList>
+    DrawRecordStats RecordDrawPackets(CommandList* commandList,
+        const DrawPacketCache& cache,
+        std::span<const uint32_t> packetIndices,
+        std::span<const DrawBatch> batches,
+        const DrawRecordDesc& desc)
+    {
+        DrawRecordStats stats = DrawRecordStats{ .NumDrawCalls = static_cast<uint32_t>(batches.size()), .NumInstances = static_cast<uint32_t>(packetIndices.size()) };
+        if (batches.empty())
+            return stats;
+
+        commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+        ID3D12PipelineState* currentPipelineState = nullptr;
+        std::optional<UINT64> currentMaterialTable;
+        const DrawGeometry* currentGeometry = nullptr;
+        for (const DrawBatch& batch : batches)
+        {
+            const DrawPacket& packet = cache.GetPacket(packetIndices[batch.FirstDraw]);
+            const DrawGeometry& geometry = cache.GetGeometry(packet.GeometryIndex);
+
+            ID3D12PipelineState* pipelineState = desc.Pipelines[geometry.VertexFormat];
+            if (pipelineState != currentPipelineState)
+            {
+                commandList->SetPipelineState(pipelineState);
+                currentPipelineState = pipelineState;
+                ++stats.NumPipelineChanges;
+            }
+
+            if (currentMaterialTable != packet.MaterialTable.ptr)
+            {
+                commandList->SetGraphicsRootDescriptorTable(desc.MaterialTableRootIndex, packet.MaterialTable);
+                currentMaterialTable = packet.MaterialTable.ptr;
+                ++stats.NumMaterialChanges;
+            }
+
+            // Distinct geometries may still share buffers, views are compared when geometry changes
+            if (&geometry != currentGeometry)
+            {
+                if (!currentGeometry || std::memcmp(geometry.VertexViews.data(), currentGeometry->VertexViews.data(), sizeof(geometry.VertexViews)) != 0)
+                {
+                    commandList->IASetVertexBuffers(0, eAttributeType_NumTypes, geometry.VertexViews.data());
+                    ++stats.NumVertexBufferChanges;
+                }
+                if (!currentGeometry || std::memcmp(&geometry.IndexView, &currentGeometry->IndexView, sizeof(geometry.IndexView)) != 0)
+                {
+                    commandList->IASetIndexBuffer(&geometry.IndexView);
+                    ++stats.NumIndexBufferChanges;
+                }
+                currentGeometry = &geometry;
+            }
+
+            // SV_InstanceID always starts from 0, StartInstanceLocation only offsets instanced vertex attributes
+            commandList->SetGraphicsRoot32BitConstant(desc.FirstInstanceRootIndex, batch.FirstDraw, 0);
+            commandList->DrawIndexedInstanced(geometry.NumIndices, batch.NumDraws, 0, 0, 0);
+        }
+        return stats;
+    }
+
+    // Per-frame sort of visible packets. Keys of packets are completed with depth buckets of distances, then packet indices are
+    // radix sorted by them. distances[i] is the distance of packetIndices[i] from the camera
+    class DrawPacketSorter
+    {
+    public:
+        void Sort(const DrawPacketCache& cache, std::span<uint32_t> packetIndices, std::span<const float> distances, float nearZ, float farZ, ThreadPool& threadPool);
+
+    private:
+        std::vector<uint64_t> m_keys;
+        RadixSorter m_sorter;
+    };
+
+} // Neb::nri namespace
@@ -0,0 +1,130 @@
+#include "FrameUploadAllocator.h"
+
+#include "nri/Device.h"
+
+#include "common/Assert.h"
+#include "common/Configuration.h"
+#include "common/Log.h"
+#include "util/Memory.h"
+
+#include <algorithm>
+
+namespace Neb::nri
+{
+
+    void FrameUploadAllocator::Init()
+    {
+        NRIDevice& device = NRIDevice::Get();
+
+        const UINT64 ringSizeMb = std::max(Config::GetValue<int32_t>(EConfigKey::FrameUploadRingSizeMb, 32), 1);
+        const UINT64 ringCapacity = ringSizeMb * 1024 * 1024;
+        m_ring = FrameRing(ringCapacity);
+
+        D3D12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{ .SizeInBytes = ringCapacity, .Alignment = 0 });
+        D3D12MA::ALLOCATION_DESC allocDesc = {
+            .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+            .HeapType = D3D12_HEAP_TYPE_UPLOAD,
+        };
+
+        Rc<D3D12MA::Allocation> allocation;
+        ThrowIfFailed(device.GetResourceAllocator()->CreateResource(
+            &allocDesc,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ, // This is the required starting state for an upload heap
+            nullptr, allocation.GetAddressOf(),
+            IID_PPV_ARGS(m_buffer.ReleaseAndGetAddressOf())));
+        NEB_SET_HANDLE_NAME(m_buffer, "FrameUploadAllocator: Frame ring ({} MB)", ringSizeMb);
+
+        // Upload heaps are fine to be mapped for their whole lifetime
+        void* mapping = nullptr;
+        ThrowIfFailed(m_buffer->Map(0, nullptr, &mapping));
+        m_mapping = static_cast<std::byte*>(mapping);
+        m_gpuAddress = m_buffer->GetGPUVirtualAddress();
+
+        m_fenceValue = 0;
+        ThrowIfFailed(device.GetD3D12Device()->CreateFence(
+            m_fenceValue,
+            D3D12_FENCE_FLAG_NONE,
+            IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+    }
+
+    void FrameUploadAllocator::BeginFrame()
+    {
+        NEB_ASSERT(m_fence, "FrameUploadAllocator is not initialized");
+        m_ring.Release(m_fence->GetCompletedValue());
+    }
+
+    void FrameUploadAllocator::EndFrame(ID3D12CommandQueue* queue)
+    {
+        NEB_ASSERT(queue, "Queue cannot be null");
+
+        // Fence is only signaled by the allocator, every frame gets the next value
+        ++m_fenceValue;
+        ThrowIfFailed(queue->Signal(m_fence.Get(), m_fenceValue));
+        m_ring.EndFrame(m_fenceValue);
+    }
+
+    FrameUploadAllocation FrameUploadAllocator::Allocate(UINT64 numBytes, UINT64 alignment)
+    {
+        NEB_ASSERT(m_fence, "FrameUploadAllocator is not initialized");
+
+        const UINT64 waitFenceValue = m_ring.GetFenceValueToAllocate(numBytes, alignment);
+        NEB_ASSERT(waitFenceValue != UINT64_MAX, "Frame ring of {} bytes cannot fit {} more bytes of the frame ({} bytes allocated already)",
+            m_ring.GetCapacity(), numBytes, m_ring.GetNumOpenFrameBytes());
+        if (waitFenceValue > 0)
+        {
+            Wait(waitFenceValue);
+            m_ring.Release(m_fence->GetCompletedValue());
+        }
+
+        const UINT64 offset = m_ring.Allocate(numBytes, alignment);
+        NEB_ASSERT(offset != FrameRing::InvalidOffset, "Allocation of {} bytes should fit the ring after waiting", numBytes);
+        return FrameUploadAllocation{
+            .Mapping = m_mapping + offset,
+            .GpuAddress = m_gpuAddress + offset,
+            .Resource = m_buffer.Get(),
+            .Offset = offset,
+            .NumBytes = numBytes,
+            .Stride = numBytes,
+            .NumElements = 1,
+        };
+    }
+
+    FrameUploadAllocation FrameUploadAllocator::AllocateConstants(UINT numElements, UINT64 numBytesPerElement)
+    {
+        if (numElements == 0)
+            return FrameUploadAllocation();
+
+        const UINT64 stride = AlignUp(numBytesPerElement, UINT64(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT));
+        FrameUploadAllocation allocation = Allocate(stride * numElements);
+        allocation.Stride = stride;
+        allocation.NumElements = numElements;
+        return allocation;
+    }
+
+    FrameUploadAllocation FrameUploadAllocator::AllocateStructured(UINT numElements, UINT64 numBytesPerElement)
+    {
+        if (numElements == 0)
+            return FrameUploadAllocation();
+
+        FrameUploadAllocation allocation = Allocate(numBytesPerElement * numElements);
+        allocation.Stride = numBytesPerElement;
+        allocation.NumElements = numElements;
+        return allocation;
+    }
+
+    void FrameUploadAllocator::Wait(UINT64 fenceValue) const
+    {
+        if (m_fence->GetCompletedValue() >= fenceValue)
+            return;
+
+        // Wait until the fence is completed.
+        HANDLE fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+        NEB_ASSERT(fenceEvent != NULL, "Failed to create HANDLE for event");
+
+        ThrowIfFailed(m_fence->SetEventOnCompletion(fenceValue, fenceEvent));
+        WaitForSingleObject(fenceEvent, INFINITE);
+        CloseHandle(fenceEvent);
+    }
+
+} // Neb::nri namespace
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "stdafx.h"
+#include "../core/FrameRing.h"
+
+#include <cstddef>
+#include <cstring>
+
+namespace Neb::nri
+{
+
+    // Sub-allocation of FrameUploadAllocator, valid until the end of the frame it was allocated in.
+    // Bulk allocations hold NumElements elements, each of them Stride bytes apart. Resource and Offset are the source of copies
+    struct FrameUploadAllocation
+    {
+        std::byte* Mapping = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+        ID3D12Resource* Resource = nullptr;
+        UINT64 Offset = 0;
+        UINT64 NumBytes = 0;
+        UINT64 Stride = 0;
+        UINT NumElements = 0;
+
+        template<typename T>
+        T* GetElement(UINT index) const { NEB_ASSERT(index < NumElements); return reinterpret_cast<T*>(Mapping + Stride * index); }
+        D3D12_GPU_VIRTUAL_ADDRESS GetElementGpuAddress(UINT index) const { NEB_ASSERT(index < NumElements); return GpuAddress + Stride * index; }
+    };
+
+    // Transient per-frame upload memory (constants of draws and alike) over a single persistently mapped upload buffer.
+    // Allocations are linear within a frame (see FrameRing) and recycled once the GPU is done with the frame,
+    // which is tracked by a fence the allocator signals on the graphics queue at the end of every frame.
+    // Not thread-safe, meant to be used by the render thread only. Memory is write-combined, thus it should only be written to
+    class FrameUploadAllocator
+    {
+    public:
+        FrameUploadAllocator() = default;
+
+        FrameUploadAllocator(const FrameUploadAllocator&) = delete;
+        FrameUploadAllocator& operator=(const FrameUploadAllocator&) = delete;
+
+        // Ring size is taken from EConfigKey::FrameUploadRingSizeMb
+        void Init();
+
+        // Releases memory of every frame completed by the GPU
+        void BeginFrame();
+
+        // Should be called after every command list of the frame is submitted to the queue
+        void EndFrame(ID3D12CommandQueue* queue);
+
+        // Waits for frames in flight if the ring is full. Alignment is 256 by default, so that allocations can be bound as constant buffers
+        FrameUploadAllocation Allocate(UINT64 numBytes, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+        // Bulk path, a single contiguous allocation of numElements constant buffers. Elements are filled in place
+        // (possibly in parallel) and bound one by one with GetElementGpuAddress()
+        FrameUploadAllocation AllocateConstants(UINT numElements, UINT64 numBytesPerElement);
+
+        template<typename T>
+        FrameUploadAllocation AllocateConstants(UINT numElements) { return AllocateConstants(numElements, sizeof(T)); }
+
+        // Elements of a structured buffer, tightly packed one after another. Bound as a whole (e.g. as a root SRV)
+        FrameUploadAllocation AllocateStructured(UINT numElements, UINT64 numBytesPerElement);
+
+        template<typename T>
+        FrameUploadAllocation AllocateStructured(UINT numElements) { return AllocateStructured(numElements, sizeof(T)); }
+
+        template<typename T>
+        D3D12_GPU_VIRTUAL_ADDRESS UploadConstants(const T& t)
+        {
+            const FrameUploadAllocation allocation = Allocate(sizeof(T));
+            std::memcpy(allocation.Mapping, &t, sizeof(T));
+            return allocation.GpuAddress;
+        }
+
+        UINT64 GetCapacity() const { return m_ring.GetCapacity(); }
+        UINT64 GetNumFrameBytes() const { return m_ring.GetNumOpenFrameBytes(); }
+
+    private:
+        void Wait(UINT64 fenceValue) const;
+
+        FrameRing m_ring;
+        Rc<ID3D12Resource> m_buffer;
+        std::byte* m_mapping = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS m_gpuAddress = 0;
+
+        Rc<ID3D12Fence> m_fence;
+        UINT64 m_fenceValue = 0; // signaled by the last closed frame
+    };
+
+} // Neb::nri namespace
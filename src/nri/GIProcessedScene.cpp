@@ -13,56 +13,91 @@
 namespace Neb::nri
 {
 
-    bool GIProcessedScene::InitScene(std::span<const StaticMesh> staticMeshes, bool createResourceContext)
+    bool GIProcessedScene::InitScene(std::span<const StaticMesh> staticMeshes, std::span<const StaticMeshInstance> instances, bool createResourceContext)
     {
-        if (staticMeshes.empty())
+        if (staticMeshes.empty() || instances.empty())
         {
-            NEB_LOG_ERROR("GIProcessedScene -> static meshes span is empty");
+            NEB_LOG_ERROR("GIProcessedScene -> static meshes or instances span is empty");
             return false;
         }
 
         // setup the state
         m_staticMeshes = staticMeshes;
+        m_instances = instances;
         m_meshGeometries.clear();
         m_meshMaterials.clear();
+        m_instanceGeometryOffsets.clear();
 
         // - - - - - - - - - - - - - - - 
-        // Nebulae handles RT meshes a bit differently due to deadlines
+        // Nebulae handles RT meshes the following way
         // 
-        // TLDR:
-        // MATCH THIS: Instead of properly handling InstanceIDs and TLAS we just pack the entire scene into a single scene:
-        //      thus -> only 1 InstanceID() value possible (see RTTopLevelInstance::GetD3D12InstanceDesc)
+        // MATCH THIS: Every StaticMesh has a single BLAS, where each Submesh has a corresponding D3D12_RAYTRACING_GEOMETRY_DESC
+        //      (see RTAccelerationStructureBuilder::QueryGeometryDescArray)
+        //      thus -> each StaticSubmesh gets its own respective GeometryIndex() based on submission order, which is 'consequtive' (no sorting)
         // 
-        // MATCH THIS: Every instance of StaticMesh is treated as an array of geometries (see RTAccelerationStructureBuilder::QueryGeometryDescArray)
-        //      thus -> as each StaticMesh consists of array of Submeshes, each Submesh would have a corresponding D3D12_RAYTRACING_GEOMETRY_DESC
-        //              representation inside BLAS
-        //      thus -> each StaticSubmesh instance would get its own respective GeometryIndex() based on submission order, which is 'consequtive' (no sorting)
+        // MATCH THIS: Every StaticMeshInstance has a single TLAS instance, referencing BLAS of its mesh.
+        //      Geometry data is stored per instance per submesh (instance-major), and InstanceID() of a TLAS instance
+        //      is the index of its first geometry entry (see GetInstanceGeometryOffset)
+        //      thus -> geometry data of a hit is at InstanceID() + GeometryIndex()
         // 
         // MATCH THIS: Respectively, as StaticSubmeshes correspond to 'geometry', Material (see Material.h) instances correspond to 'material' and get their own index as well
-        //      materials are not queried by raytracing intrinsics though, but instead should be accessed using materialIndex stored inside GeometryData
+        //      materials are not queried by raytracing intrinsics though, but instead should be accessed using materialIndex stored inside GeometryData.
+        //      Materials are stored per mesh, thus instances of the same mesh share them
         // 
-        // Remark: To correspond for missing 'instances', each geometry entry would have a mat4x4 'surfaceToWorld' that can be used to reconstruct data into world space
+        // Remark: each geometry entry has a mat4x4 'surfaceToWorld' of its instance, that can be used to reconstruct data into world space
         // - - - - - - - - - - - - - - - 
 
         // start pre-processing
         // calculate the amount of static meshes (And thus materials/attributes)
         uint32_t numStaticMeshes = static_cast<uint32_t>(GetStaticMeshes().size());
+        std::vector<uint32_t> meshMaterialOffsets(numStaticMeshes);
         for (uint32_t meshIndex = 0; meshIndex < numStaticMeshes; ++meshIndex)
         {
             const StaticMesh& staticMesh = GetStaticMeshes()[meshIndex];
+            meshMaterialOffsets[meshIndex] = static_cast<uint32_t>(m_meshMaterials.size());
+
+            for (const Material& material : staticMesh.SubmeshMaterials)
+            {
+                StaticMeshMaterialData& materialData = m_meshMaterials.emplace_back(StaticMeshMaterialData());
+                materialData.albedo = material.AlbedoFactor;
+                materialData.roughnessMetalness = material.RoughnessMetalnessFactor;
+
+                for (uint32_t i = 0; i < eMaterialTextureType_NumTypes; ++i)
+                {
+                    EMaterialTextureType type = EMaterialTextureType(i);
+                    materialData.textureIndices[type] = (material.Textures[type]) ? m_bindlessTextures.AddResource(material.Textures[type]) : PathtracerInvalidBindlessIndex;
+                    if (m_bindlessTextures.GetSize() > m_bindlessTextureTypes.size())
+                        m_bindlessTextureTypes.push_back(type);
+                }
+            }
+        }
+
+        for (const StaticMeshInstance& instance : GetStaticMeshInstances())
+        {
+            NEB_ASSERT(instance.MeshIndex < numStaticMeshes, "Instance references invalid mesh {}", instance.MeshIndex);
+            const StaticMesh& staticMesh = GetStaticMeshes()[instance.MeshIndex];
+
+            // Only 24 bits of InstanceID are available
+            NEB_ASSERT(m_meshGeometries.size() < (1u << 24), "Too many geometries to be addressed with InstanceID");
+            m_instanceGeometryOffsets.push_back(static_cast<uint32_t>(m_meshGeometries.size()));
 
             uint32_t numSubmeshes = static_cast<uint32_t>(staticMesh.Submeshes.size());
+            NEB_ASSERT(numSubmeshes == staticMesh.SubmeshMaterials.size(), "Every submesh should have a material");
             for (uint32_t geometryIndex = 0; geometryIndex < numSubmeshes; ++geometryIndex)
             {
                 const StaticSubmesh& submesh = staticMesh.Submeshes.at(geometryIndex);
 
                 StaticMeshGeometryData& geometryData = m_meshGeometries.emplace_back(StaticMeshGeometryData());
-                geometryData.surfaceToWorld = staticMesh.InstanceToWorld;
+                geometryData.surfaceToWorld = instance.InstanceToWorld;
+                geometryData.materialIndex = meshMaterialOffsets[instance.MeshIndex] + geometryIndex;
                 geometryData.indexBufferIndex = (submesh.IndexBuffer) ? m_bindlessBuffers.AddResource(submesh.IndexBuffer) : PathtracerInvalidBindlessIndex;
                 geometryData.indexBufferOffset = submesh.IndicesOffset;
                 geometryData.indexBufferStride = submesh.IndicesStride;
                 geometryData.indexBufferSizeInbytes = submesh.NumIndices * submesh.IndicesStride;
                 geometryData.numVertices = submesh.NumVertices;
+                geometryData.vertexFormat = submesh.VertexFormat;
+                geometryData.positionScale = Vec3(submesh.Quantization.Scale[0], submesh.Quantization.Scale[1], submesh.Quantization.Scale[2]);
+                geometryData.positionBias = Vec3(submesh.Quantization.Bias[0], submesh.Quantization.Bias[1], submesh.Quantization.Bias[2]);
 
                 for (uint32_t i = 0; i < eAttributeType_NumTypes; ++i)
                 {
@@ -73,22 +108,6 @@ namespace Neb::nri
                     geometryData.attributeBufferOffsets[type] = submesh.AttributeOffsets[type];
                     geometryData.attributeBufferStrides[type] = submesh.AttributeStrides[type];
                 }
-
-                const Material& material = staticMesh.SubmeshMaterials.at(geometryIndex);
-
-                // Get next material index
-                uint32_t materialIndex = static_cast<uint32_t>(m_meshMaterials.size());
-                geometryData.materialIndex = materialIndex;
-
-                StaticMeshMaterialData& materialData = m_meshMaterials.emplace_back(StaticMeshMaterialData());
-                materialData.albedo = material.AlbedoFactor;
-                materialData.roughnessMetalness = material.RoughnessMetalnessFactor;
-
-                for (uint32_t i = 0; i < eMaterialTextureType_NumTypes; ++i)
-                {
-                    EMaterialTextureType type = EMaterialTextureType(i);
-                    materialData.textureIndices[type] = (material.Textures[type]) ? m_bindlessTextures.AddResource(material.Textures[type]) : PathtracerInvalidBindlessIndex;
-                }
             }
         }
 
@@ -140,37 +159,11 @@ namespace Neb::nri
     {
         NRIDevice& device = NRIDevice::Get();
 
-        if (!m_stagingCommandList)
+        UploadBatch batch;
         {
-            NEB_ASSERT(!m_copyFence, "Copy fence was initialized before staging command list?");
-
-            ThrowIfFailed(device.GetD3D12Device()->CreateCommandList1(0,
-                D3D12_COMMAND_LIST_TYPE_COPY,
-                D3D12_COMMAND_LIST_FLAG_NONE,
-                IID_PPV_ARGS(m_stagingCommandList.GetAddressOf())));
-
-            ThrowIfFailed(device.GetD3D12Device()->CreateFence(
-                m_copyFenceValue,
-                D3D12_FENCE_FLAG_NONE,
-                IID_PPV_ARGS(m_copyFence.GetAddressOf())));
-
-            m_copyFenceValue = 0;
+            ThrowIfFalse(CreateAndUploadResources(batch));
         }
-
-        CommandAllocatorPool& allocatorPool = device.GetCommandAllocatorPool(nri::eCommandContextType_Copy);
-        D3D12Rc<ID3D12CommandAllocator> allocator = allocatorPool.QueryAllocator();
-        ThrowIfFailed(m_stagingCommandList->Reset(allocator.Get(), nullptr));
-        {
-            ThrowIfFalse(CreateAndUploadResources());
-        }
-        ThrowIfFailed(m_stagingCommandList->Close());
-
-        ID3D12CommandList* pCommandLists[] = { m_stagingCommandList.Get() };
-        ID3D12CommandQueue* copyQueue = device.GetCommandQueue(nri::eCommandContextType_Copy);
-        copyQueue->ExecuteCommandLists(_countof(pCommandLists), pCommandLists);
-
-        ThrowIfFailed(copyQueue->Signal(m_copyFence.Get(), ++m_copyFenceValue));
-        allocatorPool.DiscardAllocator(allocator, m_copyFence.Get(), m_copyFenceValue);
+        m_uploadTicket = device.GetUploadService().Submit(batch);
         return true;
     }
 
@@ -179,19 +172,11 @@ namespace Neb::nri
         NRIDevice& device = NRIDevice::Get();
 
         // At the very end, when we are done - wait asset processing for completion
-        if (m_copyFence->GetCompletedValue() < m_copyFenceValue)
-        {
-            // Wait until the fence is completed.
-            HANDLE fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
-            NEB_ASSERT(fenceEvent != NULL, "Failed to create HANDLE for event");
-
-            ThrowIfFailed(m_copyFence->SetEventOnCompletion(m_copyFenceValue, fenceEvent));
-            WaitForSingleObject(fenceEvent, INFINITE);
-        }
+        device.GetUploadService().Wait(m_uploadTicket);
     }
 
     template<typename T>
-    Rc<ID3D12Resource> CreateResourceAndUpload(ID3D12GraphicsCommandList* commandList, std::span<const T> range, std::string_view resourceName, std::vector<Rc<ID3D12Resource>>& stagingResources)
+    Rc<ID3D12Resource> CreateResourceAndUpload(UploadBatch& batch, std::span<const T> range, std::string_view resourceName)
     {
         NRIDevice& device = NRIDevice::Get();
         
@@ -221,41 +206,16 @@ namespace Neb::nri
                 NEB_SET_HANDLE_NAME(resource, "{} ({} bytes)", resourceName.data(), numBytes);
             }
 
-            // upload buffer
-            Rc<ID3D12Resource> uploadBuffer;
-            {
-                D3D12MA::ALLOCATION_DESC allocDesc = {
-                    .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
-                    .HeapType = D3D12_HEAP_TYPE_UPLOAD,
-                };
-                Rc<D3D12MA::Allocation> allocation;
-                ThrowIfFailed(allocator->CreateResource(&allocDesc, &desc, D3D12_RESOURCE_STATE_GENERIC_READ, // This is the required starting state for an upload heap
-                                  nullptr, allocation.GetAddressOf(),
-                                  IID_PPV_ARGS(uploadBuffer.GetAddressOf())),
-                    "Failed to create upload buffer for geometry data");
-
-                NEB_SET_HANDLE_NAME(uploadBuffer, "{} (upload buffer)", resourceName.data());
-
-                stagingResources.push_back(uploadBuffer);
-
-                void* data;
-                ThrowIfFailed(uploadBuffer->Map(0, nullptr, &data));
-                std::memcpy(data, range.data(), numBytes);
-                uploadBuffer->Unmap(0, nullptr);
-            }
-            commandList->CopyBufferRegion(resource.Get(), 0, uploadBuffer.Get(), 0, numBytes);
+            // range is only read when the batch is submitted
+            batch.AddBuffer(resource.Get(), 0, std::as_bytes(range));
             return resource;
         }
     }
 
-    bool GIProcessedScene::CreateAndUploadResources()
+    bool GIProcessedScene::CreateAndUploadResources(UploadBatch& batch)
     {
-        NRIDevice& device = NRIDevice::Get();
-        ID3D12GraphicsCommandList* commandList = m_stagingCommandList.Get();
-
-        m_stagingResources.clear();
-        m_geometryData = CreateResourceAndUpload(commandList, std::span(m_meshGeometries.cbegin(), m_meshGeometries.cend()), "GeometryData buffer", m_stagingResources);
-        m_materialData = CreateResourceAndUpload(commandList, std::span(m_meshMaterials.cbegin(), m_meshMaterials.cend()), "MaterialData buffer", m_stagingResources);
+        m_geometryData = CreateResourceAndUpload(batch, std::span(m_meshGeometries.cbegin(), m_meshGeometries.cend()), "GeometryData buffer");
+        m_materialData = CreateResourceAndUpload(batch, std::span(m_meshMaterials.cbegin(), m_meshMaterials.cend()), "MaterialData buffer");
         return true;
     }
 
@@ -299,7 +259,9 @@ namespace Neb::nri
                 // https://microsoft.github.io/DirectX-Specs/d3d/ResourceBinding.html#null-descriptors
                 // passing NULL for the resource pointer in the descriptor definition achieves the effect of an 'unbound' resource.
                 Rc<ID3D12Resource> texture = m_bindlessTextures.resources.at(i);
-                device.GetD3D12Device()->CreateShaderResourceView(texture.Get(), (texture) ? nullptr : &NullDescriptorSrvDesc, m_bindlessTextureHeap.CpuAt(i));
+                D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
+                const bool hasSrvDesc = GetMaterialTextureSrvDesc(srvDesc, texture.Get(), m_bindlessTextureTypes.at(i));
+                device.GetD3D12Device()->CreateShaderResourceView(texture.Get(), (texture) ? (hasSrvDesc ? &srvDesc : nullptr) : &NullDescriptorSrvDesc, m_bindlessTextureHeap.CpuAt(i));
             }
         }
 
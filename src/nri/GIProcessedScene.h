@@ -5,6 +5,7 @@
 #include "nri/Material.h"
 #include "nri/stdafx.h"
 #include "nri/DescriptorHeapAllocation.h"
+#include "nri/UploadService.h"
 
 #include <vector>
 #include <span>
@@ -28,6 +29,10 @@ namespace Neb::nri
         uint32_t attributeBufferOffsets[eAttributeType_NumTypes]; // in bytes
         uint32_t attributeBufferStrides[eAttributeType_NumTypes]; // in bytes
         uint32_t numVertices; // all attributes match this number of elements
+
+        uint32_t vertexFormat; // refer to EVertexFormat, attributes of eVertexFormat_Compact are quantized
+        Vec3 positionScale;    // dequantization of compact positions, see PositionQuantization
+        Vec3 positionBias;
     };
 
     struct StaticMeshMaterialData
@@ -69,10 +74,14 @@ namespace Neb::nri
     public:
         GIProcessedScene() = default;
 
-        bool InitScene(std::span<const StaticMesh> staticMeshes, bool createResourceContext = true);
+        bool InitScene(std::span<const StaticMesh> staticMeshes, std::span<const StaticMeshInstance> instances, bool createResourceContext = true);
         bool IsInitialized() const { return !GetStaticMeshes().empty(); }
 
         std::span<const StaticMesh> GetStaticMeshes() const { return m_staticMeshes; }
+        std::span<const StaticMeshInstance> GetStaticMeshInstances() const { return m_instances; }
+
+        // Index of the first geometry data entry of an instance. Should be used as InstanceID of its TLAS instance
+        uint32_t GetInstanceGeometryOffset(uint32_t instanceIndex) const { return m_instanceGeometryOffsets.at(instanceIndex); }
 
         ID3D12Resource* GetGeometryDataBuffer() const { return m_geometryData.Get(); }
         ID3D12Resource* GetMaterialDataBuffer() const { return m_materialData.Get(); }
@@ -89,6 +98,8 @@ namespace Neb::nri
         // for now in Nebulae this information should be enough to properly construct 
         // all descriptors/resources needed for pathtracing
         std::span<const StaticMesh> m_staticMeshes;
+        std::span<const StaticMeshInstance> m_instances;
+        std::vector<uint32_t> m_instanceGeometryOffsets;
 
         std::vector<StaticMeshGeometryData> m_meshGeometries;
         std::vector<StaticMeshMaterialData> m_meshMaterials;
@@ -96,19 +107,16 @@ namespace Neb::nri
         // collected during scene processing
         GIBindlessBuffer m_bindlessBuffers;
         GIBindlessBuffer m_bindlessTextures;
+        std::vector<EMaterialTextureType> m_bindlessTextureTypes; // material slot each bindless texture was first added for, decides its view
 
         bool CreateResources();
-        bool CreateAndUploadResources();
+        bool CreateAndUploadResources(UploadBatch& batch);
         void WaitResourcesOnHost();
         bool CreateDescriptors();
 
-        // Using own allocators, command list, copy fence
-        // same way as in GLTFSceneImporter - there is definitely a better way to go around it
-        Rc<ID3D12GraphicsCommandList> m_stagingCommandList;
-        Rc<ID3D12Fence> m_copyFence;
-        UINT64 m_copyFenceValue = 0;
+        // Uploads go through the upload service of the device, same as in GLTFSceneImporter
+        UploadTicket m_uploadTicket = 0;
 
-        std::vector<Rc<ID3D12Resource>> m_stagingResources;
         Rc<ID3D12Resource> m_geometryData;
         Rc<ID3D12Resource> m_materialData;
         DescriptorHeapAllocation m_meshGeometryDataHeap;
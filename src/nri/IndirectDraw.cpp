@@ -0,0 +1,130 @@
+#include "IndirectDraw.h"
+
+#include "common/Assert.h"
+#include "util/ThreadPool.h"
+
+#include <cstring>
+
+namespace Neb::nri
+{
+
+    namespace
+    {
+        AABB GetRecordBox(const IndirectDrawRecord& record)
+        {
+            return AABB{ .min = record.BoxMin, .max = record.BoxMax };
+        }
+    } // anonymous namespace
+
+    std::array<D3D12_INDIRECT_ARGUMENT_DESC, eAttributeType_NumTypes + 3> GetIndirectDrawArgumentDescs(UINT drawInfoRootIndex)
+    {
+        std::array<D3D12_INDIRECT_ARGUMENT_DESC, eAttributeType_NumTypes + 3> descs = {};
+        descs[0] = D3D12_INDIRECT_ARGUMENT_DESC{
+            .Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT,
+            .Constant = { .RootParameterIndex = drawInfoRootIndex, .DestOffsetIn32BitValues = 0, .Num32BitValuesToSet = 2 },
+        };
+        for (UINT slot = 0; slot < eAttributeType_NumTypes; ++slot)
+        {
+            descs[1 + slot] = D3D12_INDIRECT_ARGUMENT_DESC{
+                .Type = D3D12_INDIRECT_ARGUMENT_TYPE_VERTEX_BUFFER_VIEW,
+                .VertexBuffer = { .Slot = slot },
+            };
+        }
+        descs[1 + eAttributeType_NumTypes] = D3D12_INDIRECT_ARGUMENT_DESC{ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_INDEX_BUFFER_VIEW };
+        descs[2 + eAttributeType_NumTypes] = D3D12_INDIRECT_ARGUMENT_DESC{ .Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED };
+        return descs;
+    }
+
+    void IndirectDrawList::Build(const DrawPacketCache& cache, D3D12_GPU_DESCRIPTOR_HANDLE descriptorHeapStart, UINT descriptorIncrementSize)
+    {
+        NEB_ASSERT(descriptorIncrementSize > 0, "Descriptor increment size should be queried from the device");
+
+        const AABB emptyBox = AABB();
+        m_records.resize(cache.GetNumPackets());
+        for (uint32_t i = 0; i < cache.GetNumPackets(); ++i)
+        {
+            const DrawPacket& packet = cache.GetPacket(i);
+            const DrawGeometry& geometry = cache.GetGeometry(packet.GeometryIndex);
+            NEB_ASSERT(packet.MaterialTable.ptr >= descriptorHeapStart.ptr, "Material table of packet {} is not in the descriptor heap", i);
+
+            m_records[i] = IndirectDrawRecord{
+                .BoxMin = emptyBox.min,
+                .NumIndices = geometry.NumIndices,
+                .BoxMax = emptyBox.max,
+                .InstanceIndex = i,
+                .GeometryIndex = packet.GeometryIndex,
+                .MaterialIndex = static_cast<uint32_t>((packet.MaterialTable.ptr - descriptorHeapStart.ptr) / descriptorIncrementSize),
+                .StreamIndex = geometry.VertexFormat,
+            };
+        }
+
+        m_geometries.resize(cache.GetNumGeometries());
+        for (uint32_t i = 0; i < cache.GetNumGeometries(); ++i)
+        {
+            const DrawGeometry& geometry = cache.GetGeometry(i);
+            m_geometries[i] = IndirectGeometry{ .VertexViews = geometry.VertexViews, .IndexView = geometry.IndexView };
+        }
+    }
+
+    void IndirectDrawList::Build(std::span<const IndirectDrawRecord> records, std::span<const IndirectGeometry> geometries)
+    {
+        m_records.assign(records.begin(), records.end());
+        m_geometries.assign(geometries.begin(), geometries.end());
+    }
+
+    void IndirectDrawList::SetBox(uint32_t recordIndex, const AABB& box)
+    {
+        NEB_ASSERT(recordIndex < m_records.size(), "Record {} is out of range ({} records)", recordIndex, m_records.size());
+        m_records[recordIndex].BoxMin = box.min;
+        m_records[recordIndex].BoxMax = box.max;
+    }
+
+    IndirectDrawCounts IndirectDrawList::CullAndCompact(const Frustum& frustum, std::span<IndirectDrawArguments> arguments, ThreadPool& threadPool)
+    {
+        const uint32_t numRecords = GetNumRecords();
+        NEB_ASSERT(arguments.size() >= size_t(numRecords) * NumIndirectDrawStreams, "Arguments hold {} commands, while {} streams of {} records are expected",
+            arguments.size(), NumIndirectDrawStreams, numRecords);
+
+        // Ranges count their visible records first, then each of them writes its records at offsets of its own in every stream
+        m_visibility.resize(numRecords);
+        m_rangeOffsets.assign((numRecords + MinRecordsPerTask - 1) / MinRecordsPerTask, IndirectDrawCounts{});
+        threadPool.ParallelForRange(numRecords, MinRecordsPerTask, [&](size_t begin, size_t end)
+            {
+                IndirectDrawCounts& counts = m_rangeOffsets[begin / MinRecordsPerTask];
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const IndirectDrawRecord& record = m_records[i];
+                    const bool isVisible = IsAABBInFrustum(frustum, GetRecordBox(record));
+                    m_visibility[i] = isVisible ? 1 : 0;
+                    counts[record.StreamIndex] += isVisible ? 1 : 0;
+                }
+            });
+
+        IndirectDrawCounts counts = {};
+        for (IndirectDrawCounts& offsets : m_rangeOffsets)
+        {
+            for (uint32_t stream = 0; stream < NumIndirectDrawStreams; ++stream)
+            {
+                const uint32_t numInRange = offsets[stream];
+                offsets[stream] = stream * numRecords + counts[stream];
+                counts[stream] += numInRange;
+            }
+        }
+
+        threadPool.ParallelForRange(numRecords, MinRecordsPerTask, [&](size_t begin, size_t end)
+            {
+                IndirectDrawCounts& offsets = m_rangeOffsets[begin / MinRecordsPerTask];
+                for (size_t i = begin; i < end; ++i)
+                {
+                    if (!m_visibility[i])
+                        continue;
+
+                    const IndirectDrawRecord& record = m_records[i];
+                    const IndirectDrawArguments drawArguments = MakeIndirectDrawArguments(record, m_geometries[record.GeometryIndex]);
+                    std::memcpy(&arguments[offsets[record.StreamIndex]++], &drawArguments, sizeof(IndirectDrawArguments));
+                }
+            });
+        return counts;
+    }
+
+} // Neb::nri namespace
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "stdafx.h"
+#include "DrawPacket.h"
+#include "StaticMesh.h"
+#include "../core/FrustumCulling.h"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Neb::nri
+{
+
+    // Draws of a pipeline (vertex format) are compacted into an argument stream of their own, ExecuteIndirect cannot change pipelines
+    static constexpr uint32_t NumIndirectDrawStreams = eVertexFormat_NumFormats;
+    using IndirectDrawCounts = std::array<uint32_t, NumIndirectDrawStreams>;
+
+    // Persistent record of a single G-buffer draw, refer to IndirectDrawRecord of gbuffer_cull.hlsl. Box is the world box the draw is culled by
+    struct IndirectDrawRecord
+    {
+        Vec3 BoxMin;
+        uint32_t NumIndices = 0;
+        Vec3 BoxMax;
+        uint32_t InstanceIndex = 0; // into per-frame instances of the G-buffer, set as DrawInfo::FirstInstance
+        uint32_t GeometryIndex = 0; // into IndirectGeometry records
+        uint32_t MaterialIndex = 0; // first descriptor of material textures in the shader-visible heap, set as DrawInfo::MaterialIndex
+        uint32_t StreamIndex = 0;   // EVertexFormat
+        uint32_t _pad0 = 0;
+    };
+    static_assert(sizeof(IndirectDrawRecord) == 48, "Layout of indirect draw records is shared with gbuffer_cull.hlsl");
+
+    // Buffer views of a geometry, copied as they are into arguments of every visible draw of it
+    struct IndirectGeometry
+    {
+        std::array<D3D12_VERTEX_BUFFER_VIEW, eAttributeType_NumTypes> VertexViews = {};
+        D3D12_INDEX_BUFFER_VIEW IndexView = {};
+    };
+    static_assert(sizeof(IndirectGeometry) == 80, "Layout of indirect geometries is shared with gbuffer_cull.hlsl");
+
+    // Arguments of a single command, in the order of GetIndirectDrawArgumentDescs(). Padding is always zero, so that streams can be compared as bytes
+    struct IndirectDrawArguments
+    {
+        uint32_t InstanceIndex = 0;
+        uint32_t MaterialIndex = 0;
+        std::array<D3D12_VERTEX_BUFFER_VIEW, eAttributeType_NumTypes> VertexViews = {};
+        D3D12_INDEX_BUFFER_VIEW IndexView = {};
+        D3D12_DRAW_INDEXED_ARGUMENTS Draw = {};
+        uint32_t _pad0 = 0;
+    };
+    static_assert(sizeof(IndirectDrawArguments) == 112, "Layout of indirect draw arguments is shared with gbuffer_cull.hlsl");
+
+    inline IndirectDrawArguments MakeIndirectDrawArguments(const IndirectDrawRecord& record, const IndirectGeometry& geometry)
+    {
+        return IndirectDrawArguments{
+            .InstanceIndex = record.InstanceIndex,
+            .MaterialIndex = record.MaterialIndex,
+            .VertexViews = geometry.VertexViews,
+            .IndexView = geometry.IndexView,
+            .Draw = D3D12_DRAW_INDEXED_ARGUMENTS{ .IndexCountPerInstance = record.NumIndices, .InstanceCount = 1 },
+        };
+    }
+
+    // Command signature layout of IndirectDrawArguments. drawInfoRootIndex is the root of two 32-bit constants (first instance and material index)
+    std::array<D3D12_INDIRECT_ARGUMENT_DESC, eAttributeType_NumTypes + 3> GetIndirectDrawArgumentDescs(UINT drawInfoRootIndex);
+
+    // Records of every G-buffer draw and the CPU reference of their per-frame cull and compaction (the same as CSMain of gbuffer_cull.hlsl).
+    // Records that intersect the frustum (see IsAABBInFrustum) are compacted into the stream of their pipeline, stream s starts at
+    // argument s * GetNumRecords(). Compaction keeps the order of records both here and on the GPU, so streams of both are the same
+    // bit by bit. Also the fallback when the GPU does not cull, arguments are then written to upload memory and executed from there
+    class IndirectDrawList
+    {
+    public:
+        static constexpr uint32_t MinRecordsPerTask = 16384;
+
+        // Records are in the order of packets, InstanceIndex of a record is its packet. Boxes are empty (never visible) until set.
+        // Material tables are turned into indices of descriptors from the start of the heap they are in
+        void Build(const DrawPacketCache& cache, D3D12_GPU_DESCRIPTOR_HANDLE descriptorHeapStart, UINT descriptorIncrementSize);
+        void Build(std::span<const IndirectDrawRecord> records, std::span<const IndirectGeometry> geometries);
+
+        void SetBox(uint32_t recordIndex, const AABB& box);
+
+        std::span<const IndirectDrawRecord> GetRecords() const { return m_records; }
+        std::span<const IndirectGeometry> GetGeometries() const { return m_geometries; }
+        uint32_t GetNumRecords() const { return static_cast<uint32_t>(m_records.size()); }
+
+        // Arguments should hold NumIndirectDrawStreams * GetNumRecords() commands, only the first counts[s] of each stream are written.
+        // Every command is written as a whole, thus arguments may be write-combined memory
+        IndirectDrawCounts CullAndCompact(const Frustum& frustum, std::span<IndirectDrawArguments> arguments, ThreadPool& threadPool);
+
+    private:
+        std::vector<IndirectDrawRecord> m_records;
+        std::vector<IndirectGeometry> m_geometries;
+
+        // Scratch of parallel compaction, visibility of records and offsets of ranges in every stream
+        std::vector<uint8_t> m_visibility;
+        std::vector<IndirectDrawCounts> m_rangeOffsets;
+    };
+
+} // Neb::nri namespace
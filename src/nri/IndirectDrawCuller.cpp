@@ -0,0 +1,146 @@
+#include "IndirectDrawCuller.h"
+
+#include "nri/Device.h"
+#include "nri/PIXRuntime.h"
+#include "nri/ShaderCompiler.h"
+
+#include "common/Assert.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Neb::nri
+{
+
+    namespace
+    {
+        // Buffers are never empty, so that they can always be bound
+        Rc<ID3D12Resource> CreateBuffer(UINT64 numBytes, D3D12_RESOURCE_FLAGS flags, const char* name)
+        {
+            D3D12MA::Allocator* allocator = NRIDevice::Get().GetResourceAllocator();
+            D3D12MA::ALLOCATION_DESC allocDesc = {
+                .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+                .HeapType = D3D12_HEAP_TYPE_DEFAULT,
+            };
+
+            const D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(std::max<UINT64>(numBytes, 4), flags);
+            Rc<D3D12MA::Allocation> allocation;
+            Rc<ID3D12Resource> buffer;
+            ThrowIfFailed(allocator->CreateResource(&allocDesc, &desc, D3D12_RESOURCE_STATE_COMMON,
+                nullptr,
+                allocation.GetAddressOf(),
+                IID_PPV_ARGS(buffer.ReleaseAndGetAddressOf())));
+            NEB_SET_HANDLE_NAME(buffer, "{}", name);
+            return buffer;
+        }
+    } // anonymous namespace
+
+    void IndirectDrawCuller::Init(const std::filesystem::path& shaderDirectory)
+    {
+        NRIDevice& device = NRIDevice::Get();
+        ShaderCompiler* compiler = ShaderCompiler::Get();
+
+        const std::string shaderFilepath = (shaderDirectory / "gbuffer_cull.hlsl").string();
+        m_csCount = compiler->CompileShader(shaderFilepath, ShaderCompilationDesc("CSCount", EShaderModel::sm_6_5, EShaderType::Compute));
+        m_csScanGroups = compiler->CompileShader(shaderFilepath, ShaderCompilationDesc("CSScanGroups", EShaderModel::sm_6_5, EShaderType::Compute));
+        m_csCompact = compiler->CompileShader(shaderFilepath, ShaderCompilationDesc("CSCompact", EShaderModel::sm_6_5, EShaderType::Compute));
+
+        m_rootSignature = RootSignature(ROOTS_NUM_ROOTS)
+                              .AddParamCbv(ROOTS_CULL_INFO, 0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC)
+                              .AddParamSrv(ROOTS_RECORDS, 0, 0)
+                              .AddParamSrv(ROOTS_GEOMETRIES, 1, 0)
+                              .AddParamUav(ROOTS_ARGUMENTS, 0, 0)
+                              .AddParamUav(ROOTS_COUNTS, 1, 0)
+                              .AddParamUav(ROOTS_GROUP_OFFSETS, 2, 0);
+        ThrowIfFalse(m_rootSignature.Init(&device));
+
+        auto createPipeline = [&](Rc<ID3D12PipelineState>& pipeline, const Shader& shader)
+            {
+                D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+                psoDesc.pRootSignature = m_rootSignature.GetD3D12RootSignature();
+                psoDesc.CS = shader.GetBinaryBytecode();
+                ThrowIfFailed(device.GetD3D12Device()->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(pipeline.ReleaseAndGetAddressOf())));
+            };
+        createPipeline(m_countPipeline, m_csCount);
+        createPipeline(m_scanGroupsPipeline, m_csScanGroups);
+        createPipeline(m_compactPipeline, m_csCompact);
+    }
+
+    void IndirectDrawCuller::Resize(const IndirectDrawList& drawList)
+    {
+        m_numRecords = drawList.GetNumRecords();
+        NEB_ASSERT(m_numRecords <= MaxNumRecords, "{} records do not fit a single dispatch (at most {})", m_numRecords, MaxNumRecords);
+
+        const UINT64 numRecords = m_numRecords;
+        const UINT64 numGroups = (numRecords + NumRecordsPerGroup - 1) / NumRecordsPerGroup;
+        m_recordBuffer = CreateBuffer(numRecords * sizeof(IndirectDrawRecord), D3D12_RESOURCE_FLAG_NONE, "Indirect records");
+        m_geometryBuffer = CreateBuffer(drawList.GetGeometries().size_bytes(), D3D12_RESOURCE_FLAG_NONE, "Indirect geometries");
+        m_argumentBuffer = CreateBuffer(numRecords * NumIndirectDrawStreams * sizeof(IndirectDrawArguments), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, "Indirect arguments");
+        m_countBuffer = CreateBuffer(sizeof(IndirectDrawCounts), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, "Indirect counts");
+        m_groupOffsetBuffer = CreateBuffer(numGroups * NumIndirectDrawStreams * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, "Indirect group offsets");
+    }
+
+    void IndirectDrawCuller::UploadRecords(ID3D12GraphicsCommandList* commandList, const IndirectDrawList& drawList, FrameUploadAllocator& uploadAllocator)
+    {
+        NEB_ASSERT(drawList.GetNumRecords() == m_numRecords, "Culler is sized for {} records, while the list has {}", m_numRecords, drawList.GetNumRecords());
+        if (m_numRecords == 0)
+            return;
+
+        const std::span<const IndirectDrawRecord> records = drawList.GetRecords();
+        const std::span<const IndirectGeometry> geometries = drawList.GetGeometries();
+        const FrameUploadAllocation recordUpload = uploadAllocator.Allocate(records.size_bytes());
+        const FrameUploadAllocation geometryUpload = uploadAllocator.Allocate(std::max<UINT64>(geometries.size_bytes(), 1));
+        std::memcpy(recordUpload.Mapping, records.data(), records.size_bytes());
+        std::memcpy(geometryUpload.Mapping, geometries.data(), geometries.size_bytes());
+
+        // Buffers decay to common after every submission, thus they are promoted to copy destination here, but not to shader resource afterwards
+        commandList->CopyBufferRegion(m_recordBuffer.Get(), 0, recordUpload.Resource, recordUpload.Offset, records.size_bytes());
+        commandList->CopyBufferRegion(m_geometryBuffer.Get(), 0, geometryUpload.Resource, geometryUpload.Offset, geometries.size_bytes());
+        std::array barriers = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_recordBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_geometryBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+        };
+        commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+    }
+
+    void IndirectDrawCuller::CullAndCompact(ID3D12GraphicsCommandList* commandList, const Frustum& frustum, FrameUploadAllocator& uploadAllocator)
+    {
+        if (m_numRecords == 0)
+            return;
+
+        NEB_PIX_SCOPED_EVENT(commandList, "Indirect cull and compact");
+
+        const UINT numGroups = (m_numRecords + NumRecordsPerGroup - 1) / NumRecordsPerGroup;
+        CbIndirectCullInfo cullInfo = CbIndirectCullInfo{ .NumRecords = m_numRecords, .StreamCapacity = m_numRecords, .NumGroups = numGroups };
+        std::copy(std::begin(frustum.Planes), std::end(frustum.Planes), std::begin(cullInfo.FrustumPlanes));
+
+        commandList->SetComputeRootSignature(m_rootSignature.GetD3D12RootSignature());
+        commandList->SetComputeRootConstantBufferView(ROOTS_CULL_INFO, uploadAllocator.UploadConstants(cullInfo));
+        commandList->SetComputeRootShaderResourceView(ROOTS_RECORDS, m_recordBuffer->GetGPUVirtualAddress());
+        commandList->SetComputeRootShaderResourceView(ROOTS_GEOMETRIES, m_geometryBuffer->GetGPUVirtualAddress());
+        commandList->SetComputeRootUnorderedAccessView(ROOTS_ARGUMENTS, m_argumentBuffer->GetGPUVirtualAddress());
+        commandList->SetComputeRootUnorderedAccessView(ROOTS_COUNTS, m_countBuffer->GetGPUVirtualAddress());
+        commandList->SetComputeRootUnorderedAccessView(ROOTS_GROUP_OFFSETS, m_groupOffsetBuffer->GetGPUVirtualAddress());
+
+        // Each dispatch reads group offsets written by the previous one
+        const D3D12_RESOURCE_BARRIER groupOffsetsBarrier = CD3DX12_RESOURCE_BARRIER::UAV(m_groupOffsetBuffer.Get());
+        commandList->SetPipelineState(m_countPipeline.Get());
+        commandList->Dispatch(numGroups, 1, 1);
+        commandList->ResourceBarrier(1, &groupOffsetsBarrier);
+
+        commandList->SetPipelineState(m_scanGroupsPipeline.Get());
+        commandList->Dispatch(1, 1, 1);
+        commandList->ResourceBarrier(1, &groupOffsetsBarrier);
+
+        commandList->SetPipelineState(m_compactPipeline.Get());
+        commandList->Dispatch(numGroups, 1, 1);
+
+        std::array barriers = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_argumentBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_countBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+        };
+        commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+    }
+
+} // Neb::nri namespace
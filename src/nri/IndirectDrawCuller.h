@@ -0,0 +1,76 @@
+#pragma once
+
+#include "stdafx.h"
+#include "FrameUploadAllocator.h"
+#include "IndirectDraw.h"
+#include "RootSignature.h"
+#include "Shader.h"
+
+#include <cstdint>
+#include <filesystem>
+
+namespace Neb::nri
+{
+
+    CONSTANT_BUFFER_STRUCT CbIndirectCullInfo
+    {
+        Vec4 FrustumPlanes[Frustum::NumPlanes];
+        uint32_t NumRecords;
+        uint32_t StreamCapacity; // see IndirectDrawList
+        uint32_t NumGroups;
+    };
+
+    // GPU side of IndirectDrawList::CullAndCompact (see gbuffer_cull.hlsl) over persistent buffers of records and argument streams.
+    // Records are culled in groups of NumRecordsPerGroup: groups count their visible records, a single group scans the counts
+    // into offsets of groups in the streams and then every group writes its visible records at its offsets. Thus streams are
+    // the same as ones of the CPU bit by bit, while the amount of records is only limited by the dispatch size
+    class IndirectDrawCuller
+    {
+    public:
+        static constexpr uint32_t NumRecordsPerGroup = 256;
+        static constexpr uint32_t MaxNumRecords = NumRecordsPerGroup * D3D12_CS_DISPATCH_MAX_THREAD_GROUPS_PER_DIMENSION;
+
+        void Init(const std::filesystem::path& shaderDirectory);
+
+        // Buffers are recreated for the records of the list, the GPU should be done with the previous ones
+        void Resize(const IndirectDrawList& drawList);
+
+        // Records (and geometries) are copied from upload memory of the frame, should be called whenever boxes of the list change
+        void UploadRecords(ID3D12GraphicsCommandList* commandList, const IndirectDrawList& drawList, FrameUploadAllocator& uploadAllocator);
+
+        // Stream s starts at argument s * GetNumRecords() of the argument buffer, its count is uint32_t s of the count buffer.
+        // Both are left in D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT. Nothing is recorded if there are no records
+        void CullAndCompact(ID3D12GraphicsCommandList* commandList, const Frustum& frustum, FrameUploadAllocator& uploadAllocator);
+
+        uint32_t GetNumRecords() const { return m_numRecords; }
+        ID3D12Resource* GetArgumentBuffer() const { return m_argumentBuffer.Get(); }
+        ID3D12Resource* GetCountBuffer() const { return m_countBuffer.Get(); }
+
+    private:
+        enum ERoots
+        {
+            ROOTS_CULL_INFO = 0,
+            ROOTS_RECORDS,
+            ROOTS_GEOMETRIES,
+            ROOTS_ARGUMENTS,
+            ROOTS_COUNTS,
+            ROOTS_GROUP_OFFSETS,
+            ROOTS_NUM_ROOTS,
+        };
+        RootSignature m_rootSignature;
+        Shader m_csCount;
+        Shader m_csScanGroups;
+        Shader m_csCompact;
+        Rc<ID3D12PipelineState> m_countPipeline;
+        Rc<ID3D12PipelineState> m_scanGroupsPipeline;
+        Rc<ID3D12PipelineState> m_compactPipeline;
+
+        uint32_t m_numRecords = 0;
+        Rc<ID3D12Resource> m_recordBuffer;
+        Rc<ID3D12Resource> m_geometryBuffer;
+        Rc<ID3D12Resource> m_argumentBuffer;
+        Rc<ID3D12Resource> m_countBuffer;
+        Rc<ID3D12Resource> m_groupOffsetBuffer; // NumIndirectDrawStreams offsets per group
+    };
+
+} // Neb::nri namespace
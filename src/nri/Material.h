@@ -24,6 +24,31 @@ namespace Neb::nri
         eMaterialFlag_HasRoughnessMetalnessMap = 4,
     };
 
+    // Block compressed roughness-metalness textures only store green and blue channels (in red and green of BC5, or just green
+    // in red of BC4, when metalness is empty), the view moves them back to where shaders read them.
+    // Returns false if the default view of the resource should be used
+    inline bool GetMaterialTextureSrvDesc(D3D12_SHADER_RESOURCE_VIEW_DESC& desc, ID3D12Resource* resource, EMaterialTextureType type)
+    {
+        if (!resource || type != eMaterialTextureType_RoughnessMetalness)
+            return false;
+
+        const D3D12_RESOURCE_DESC resourceDesc = resource->GetDesc();
+        if (resourceDesc.Format != DXGI_FORMAT_BC4_UNORM && resourceDesc.Format != DXGI_FORMAT_BC5_UNORM)
+            return false;
+
+        desc = D3D12_SHADER_RESOURCE_VIEW_DESC{
+            .Format = resourceDesc.Format,
+            .ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+            .Shader4ComponentMapping = D3D12_ENCODE_SHADER_4_COMPONENT_MAPPING(
+                D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_0,
+                D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_0,
+                D3D12_SHADER_COMPONENT_MAPPING_FROM_MEMORY_COMPONENT_1, // BC4 has no second component, it reads as 0
+                D3D12_SHADER_COMPONENT_MAPPING_FORCE_VALUE_1),
+            .Texture2D = D3D12_TEX2D_SRV{ .MipLevels = resourceDesc.MipLevels },
+        };
+        return true;
+    }
+
     // Defines the entire material itself. Material definition based upon glTF 2.0 spec
     // For more info: https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#reference-material-pbrmetallicroughness
     //
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <array>
+#include <span>
 #include <vector>
 
 #include "stdafx.h"
 #include "Material.h"
+#include "../core/Bounds.h"
 #include "../core/Math.h"
+#include "../core/MeshletBuilder.h"
+#include "../core/MeshSimplifier.h"
+#include "../core/OcclusionCulling.h"
+#include "../core/VertexCompression.h"
 
 namespace Neb::nri
 {
@@ -20,6 +27,19 @@ namespace Neb::nri
         eAttributeType_NumTypes
     };
 
+    enum EVertexFormat
+    {
+        eVertexFormat_Full = 0, // see StaticMeshInputLayout
+        eVertexFormat_Compact,  // see StaticMeshCompactInputLayout and core/VertexCompression.h
+        eVertexFormat_NumFormats
+    };
+
+    // Element sizes of attributes of every vertex format
+    static constexpr std::array<std::array<UINT, eAttributeType_NumTypes>, eVertexFormat_NumFormats> StaticMeshAttributeSizes = {
+        std::array<UINT, eAttributeType_NumTypes>{ sizeof(float) * 3, sizeof(float) * 3, sizeof(float) * 2, sizeof(float) * 4 },
+        std::array<UINT, eAttributeType_NumTypes>{ sizeof(CompactPosition), sizeof(uint32_t), sizeof(uint32_t), sizeof(uint32_t) },
+    };
+
     struct StaticSubmesh
     {
         // Decided to go for SoA instead AoS, because its natively in glTF and is easier to parse that way
@@ -28,29 +48,96 @@ namespace Neb::nri
         // to determine correct offset into the buffer use AttributeOffsets and AttributeStrides
         std::array<UINT, eAttributeType_NumTypes> AttributeStrides = {};
         std::array<size_t, eAttributeType_NumTypes> AttributeOffsets = {}; // in bytes
-        std::array<std::vector<std::byte>, eAttributeType_NumTypes> Attributes;
+
+        // Attributes are non-owning (possibly strided) views. They point into the source the scene was imported from
+        // (memory-mapped .glb or .nebscene, tinygltf buffers), which is kept alive by the importer as long as the scene.
+        // Only streams that do not exist in the source (e.g. generated tangents) are materialized into AttributeStorage
+        std::array<std::span<const std::byte>, eAttributeType_NumTypes> Attributes;
+        std::array<std::vector<std::byte>, eAttributeType_NumTypes> AttributeStorage;
 
         std::array<D3D12Rc<ID3D12Resource>, eAttributeType_NumTypes> AttributeBuffers;
         std::array<D3D12_VERTEX_BUFFER_VIEW, eAttributeType_NumTypes> AttributeViews = {};
 
         // Indices may be in uint16_t or uint32_t - we handle both cases here
+        // NumIndices is always the amount of full resolution indices, LODs (if any) are stored right after them
         UINT NumIndices = 0;
         UINT IndicesStride = 0;
         size_t IndicesOffset = 0; // in bytes
-        std::vector<std::byte> Indices;
+        std::span<const std::byte> Indices; // non-owning view, same as Attributes
+        std::vector<std::byte> IndexStorage; // only used if indices were rewritten on import (e.g. by mesh optimization)
 
         D3D12Rc<ID3D12Resource> IndexBuffer;
         D3D12_INDEX_BUFFER_VIEW IBView = {};
+
+        // Compact submeshes are only produced if EConfigKey::CompactVertexFormat is set. Their positions are quantized
+        // to the box of the submesh, Quantization is needed to get them back into mesh space (see core/VertexCompression.h)
+        EVertexFormat VertexFormat = eVertexFormat_Full;
+        PositionQuantization Quantization;
+
+        // CPU-side meshlets for the mesh shader path, only built if EConfigKey::BuildMeshlets is set
+        MeshletData Meshlets;
+
+        // Discrete LODs, only built if EConfigKey::BuildMeshLods is set. Lods[0] is the full resolution [0, NumIndices),
+        // FirstIndex of every other level is relative to the beginning of Indices. Empty if there are no LODs
+        std::vector<MeshLod> Lods;
+
+        // Tight bounds of positions in mesh space, computed on import before vertices are compressed
+        AABB LocalBox;
+        Sphere LocalSphere;
+
+        UINT GetNumStoredIndices() const { return Lods.empty() ? NumIndices : Lods.back().FirstIndex + Lods.back().NumIndices; }
+
+        void MaterializeAttribute(EAttributeType type, std::vector<std::byte>&& bytes)
+        {
+            AttributeStorage[type] = std::move(bytes);
+            Attributes[type] = AttributeStorage[type];
+        }
+
+        void MaterializeIndices(std::vector<std::byte>&& bytes)
+        {
+            IndexStorage = std::move(bytes);
+            Indices = IndexStorage;
+        }
     };
 
+    // Static mesh is a geometry asset (glTF mesh), it is imported once and shared by all of its instances
     struct StaticMesh
     {
-        // for the time being, static meshes themselves store transformation matrices
-        Mat4 InstanceToWorld;
-
         // Static mesh is pretty much an array of submeshes
         std::vector<StaticSubmesh> Submeshes;
         std::vector<Material> SubmeshMaterials; // TODO: Maybe replace with proxies, figure out best way to cache
+
+        // In mesh space, instances transform them themselves. Enclose bounds of every submesh, see UpdateBounds()
+        AABB LocalBox;
+        Sphere LocalSphere;
+
+        // Merged geometry of submeshes for software occlusion culling, only built if EConfigKey::OcclusionCulling is set.
+        // Empty if the mesh is too detailed to be an occluder
+        OccluderMesh Occluder;
+
+        void UpdateBounds()
+        {
+            LocalBox = AABB();
+            for (const StaticSubmesh& submesh : Submeshes)
+                ExtendAABB(LocalBox, submesh.LocalBox);
+
+            // Centered in the box, which is usually tighter than merging spheres pairwise
+            LocalSphere = Sphere{ .center = IsEmptyAABB(LocalBox) ? Vec3(0.0f) : (LocalBox.min + LocalBox.max) * 0.5f };
+            for (const StaticSubmesh& submesh : Submeshes)
+                LocalSphere.radius = std::max(LocalSphere.radius, Vec3::Distance(LocalSphere.center, submesh.LocalSphere.center) + submesh.LocalSphere.radius);
+        }
+    };
+
+    // Lightweight placement of a static mesh in the scene (glTF node)
+    struct StaticMeshInstance
+    {
+        Mat4 InstanceToWorld; // world matrix of the node, copied by Scene::UpdateTransforms()
+        uint32_t MeshIndex = 0; // into Scene::StaticMeshes
+        uint32_t NodeIndex = 0; // into Scene::Graph
+
+        // World bounds of the mesh, updated together with InstanceToWorld
+        AABB WorldBox;
+        Sphere WorldSphere;
     };
 
     static constexpr std::array StaticMeshInputLayout = {
@@ -80,4 +167,32 @@ namespace Neb::nri
         }
     };
 
+    // Same slots and semantics, shaders decode attributes themselves (see deferred_gbuffers.hlsl)
+    static constexpr std::array StaticMeshCompactInputLayout = {
+        D3D12_INPUT_ELEMENT_DESC{
+            .SemanticName = "POSITION",
+            .SemanticIndex = 0,
+            .Format = DXGI_FORMAT_R16G16B16A16_SNORM,
+            .InputSlot = 0,
+        },
+        D3D12_INPUT_ELEMENT_DESC{
+            .SemanticName = "NORMAL",
+            .SemanticIndex = 0,
+            .Format = DXGI_FORMAT_R16G16_SNORM,
+            .InputSlot = 1,
+        },
+        D3D12_INPUT_ELEMENT_DESC{
+            .SemanticName = "TEXCOORD",
+            .SemanticIndex = 0,
+            .Format = DXGI_FORMAT_R16G16_FLOAT,
+            .InputSlot = 2,
+        },
+        D3D12_INPUT_ELEMENT_DESC{
+            .SemanticName = "TANGENT",
+            .SemanticIndex = 0,
+            .Format = DXGI_FORMAT_R32_UINT,
+            .InputSlot = 3,
+        }
+    };
+
 } // Neb::nri namespace
\ No newline at end of file
@@ -0,0 +1,301 @@
+#include "UploadService.h"
+
+#include "nri/Device.h"
+
+#include "common/Assert.h"
+#include "common/Configuration.h"
+#include "common/Log.h"
+#include "common/TimeWatch.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Neb::nri
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        // Staging offsets of buffer pieces do not need any alignment, it is only kept for memcpy
+        static constexpr UINT64 BufferPieceAlignment = 16;
+
+        // Chunks are a quarter of the ring, so that up to 4 of them are in flight on the copy queue
+        static constexpr UINT64 NumChunksPerRing = 4;
+    } // anonymous namespace
+
+    void UploadBatch::AddBuffer(ID3D12Resource* dst, UINT64 dstOffset, std::span<const std::byte> data)
+    {
+        NEB_ASSERT(dst, "Destination buffer cannot be null");
+        if (data.empty())
+            return;
+
+        m_copies.push_back(Copy{
+            .Dst = dst,
+            .DstOffset = dstOffset,
+            .NumBytesInRow = data.size(),
+            .Data = data.data(),
+            .DataRowPitch = data.size(),
+        });
+        m_requests.push_back(UploadRequestDesc{ .NumBytes = data.size(), .Alignment = BufferPieceAlignment, .SplitGranularity = BufferPieceAlignment });
+    }
+
+    void UploadBatch::AddTexture(ID3D12Resource* dst, UINT subresource, const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+        UINT numRows, UINT64 numBytesInRow, const std::byte* data, UINT64 dataRowPitch)
+    {
+        NEB_ASSERT(dst, "Destination texture cannot be null");
+        NEB_ASSERT(numBytesInRow <= footprint.RowPitch && numBytesInRow <= dataRowPitch, "Rows do not fit the footprint or the source");
+        if (numRows == 0)
+            return;
+
+        // Footprints of block-compressed formats are block-aligned, so every row covers the same amount of texel rows
+        NEB_ASSERT(footprint.Depth == 1 && footprint.Height % numRows == 0, "Only 2D subresources with whole rows are supported");
+
+        m_copies.push_back(Copy{
+            .Dst = dst,
+            .Subresource = subresource,
+            .Footprint = footprint,
+            .NumRows = numRows,
+            .NumBytesInRow = numBytesInRow,
+            .Data = data,
+            .DataRowPitch = dataRowPitch,
+        });
+
+        // Pieces are whole rows, thus they can be copied as footprints of their own
+        m_requests.push_back(UploadRequestDesc{
+            .NumBytes = UINT64(footprint.RowPitch) * numRows,
+            .Alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT,
+            .SplitGranularity = footprint.RowPitch,
+        });
+    }
+
+    void UploadBatch::Clear()
+    {
+        m_copies.clear();
+        m_requests.clear();
+    }
+
+    void UploadService::Init()
+    {
+        NRIDevice& device = NRIDevice::Get();
+
+        const UINT64 ringSizeMb = std::max(Config::GetValue<int32_t>(EConfigKey::UploadRingSizeMb, 64), 1);
+        const UINT64 ringCapacity = ringSizeMb * 1024 * 1024;
+        m_ring = StagingRing(ringCapacity);
+        m_chunkSize = ringCapacity / NumChunksPerRing;
+
+        m_ringBuffer = CreateUploadBuffer(ringCapacity);
+        NEB_SET_HANDLE_NAME(m_ringBuffer, "UploadService: Staging ring ({} MB)", ringSizeMb);
+
+        // Upload heaps are fine to be mapped for their whole lifetime
+        void* mapping = nullptr;
+        ThrowIfFailed(m_ringBuffer->Map(0, nullptr, &mapping));
+        m_ringMapping = static_cast<std::byte*>(mapping);
+
+        ThrowIfFailed(device.GetD3D12Device()->CreateCommandList1(0,
+            D3D12_COMMAND_LIST_TYPE_COPY,
+            D3D12_COMMAND_LIST_FLAG_NONE,
+            IID_PPV_ARGS(m_commandList.ReleaseAndGetAddressOf())));
+
+        m_fenceValue = 0;
+        ThrowIfFailed(device.GetD3D12Device()->CreateFence(
+            m_fenceValue,
+            D3D12_FENCE_FLAG_NONE,
+            IID_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+    }
+
+    void UploadService::Deinit()
+    {
+        if (!m_fence)
+            return;
+
+        Wait(m_fenceValue);
+        m_dedicatedBuffers.clear();
+        m_ringBuffer->Unmap(0, nullptr);
+        m_ringMapping = nullptr;
+        m_ringBuffer.Reset();
+        m_commandList.Reset();
+        m_fence.Reset();
+    }
+
+    UploadTicket UploadService::Submit(const UploadBatch& batch, ThreadPool& threadPool)
+    {
+        if (batch.IsEmpty())
+            return 0;
+
+        std::lock_guard lock(m_mutex);
+        NEB_ASSERT(m_fence, "UploadService is not initialized");
+
+        TimeWatch timeWatch;
+        timeWatch.Begin();
+
+        PlanUploads(m_plan, batch.m_requests, m_chunkSize);
+
+        while (!m_dedicatedBuffers.empty() && m_dedicatedBuffers.front().FenceValue <= m_fence->GetCompletedValue())
+            m_dedicatedBuffers.pop_front();
+
+        UINT64 numBytes = 0;
+        UINT32 numDedicatedChunks = 0;
+        MillisecondsF32 waitTime = MillisecondsF32(0.0f);
+        for (const UploadChunk& chunk : m_plan.Chunks)
+        {
+            numBytes += chunk.NumBytes;
+
+            // The copy fence is only signaled by the service, so the next submission gets the next value
+            const UINT64 fenceValue = m_fenceValue + 1;
+            const UINT64 waitFenceValue = m_ring.GetFenceValueToAllocate(chunk.NumBytes, chunk.Alignment);
+            if (waitFenceValue == UINT64_MAX)
+            {
+                Rc<ID3D12Resource> uploadBuffer = CreateUploadBuffer(chunk.NumBytes);
+                NEB_SET_HANDLE_NAME(uploadBuffer, "UploadService: Dedicated upload buffer ({} bytes)", chunk.NumBytes);
+
+                void* mapping = nullptr;
+                ThrowIfFailed(uploadBuffer->Map(0, nullptr, &mapping));
+                SubmitChunk(batch, chunk, uploadBuffer.Get(), 0, static_cast<std::byte*>(mapping), threadPool);
+                uploadBuffer->Unmap(0, nullptr);
+
+                m_dedicatedBuffers.push_back(DedicatedUploadBuffer{ .Buffer = uploadBuffer, .FenceValue = m_fenceValue });
+                ++numDedicatedChunks;
+                continue;
+            }
+
+            if (m_fence->GetCompletedValue() < waitFenceValue)
+            {
+                TimeWatch waitWatch;
+                waitWatch.Begin();
+                Wait(waitFenceValue);
+                waitTime += waitWatch.Elapsed<MillisecondsF32>();
+            }
+            m_ring.Release(m_fence->GetCompletedValue());
+
+            const UINT64 offset = m_ring.Allocate(chunk.NumBytes, chunk.Alignment, fenceValue);
+            NEB_ASSERT(offset != StagingRing::InvalidOffset, "Chunk of {} bytes should fit the ring after waiting", chunk.NumBytes);
+            SubmitChunk(batch, chunk, m_ringBuffer.Get(), offset, m_ringMapping + offset, threadPool);
+        }
+
+        const MillisecondsF32 elapsed = timeWatch.Elapsed<MillisecondsF32>();
+        NEB_LOG_INFO("UploadService -> Submitted {:.1f} MB of {} copies in {} chunks ({} dedicated) in {:.2f}ms ({:.0f} MB/s), {:.2f}ms waiting for the ring",
+            numBytes / (1024.0f * 1024.0f),
+            batch.m_copies.size(),
+            m_plan.Chunks.size(),
+            numDedicatedChunks,
+            elapsed.count(),
+            (numBytes / (1024.0f * 1024.0f)) / std::max(elapsed.count() / 1000.0f, 1e-6f),
+            waitTime.count());
+        return m_fenceValue;
+    }
+
+    bool UploadService::IsCompleted(UploadTicket ticket) const
+    {
+        return ticket == 0 || m_fence->GetCompletedValue() >= ticket;
+    }
+
+    void UploadService::Wait(UploadTicket ticket) const
+    {
+        if (IsCompleted(ticket))
+            return;
+
+        // Wait until the fence is completed.
+        HANDLE fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+        NEB_ASSERT(fenceEvent != NULL, "Failed to create HANDLE for event");
+
+        ThrowIfFailed(m_fence->SetEventOnCompletion(ticket, fenceEvent));
+        WaitForSingleObject(fenceEvent, INFINITE);
+        CloseHandle(fenceEvent);
+    }
+
+    void UploadService::SubmitChunk(const UploadBatch& batch, const UploadChunk& chunk, ID3D12Resource* staging, UINT64 stagingOffset, std::byte* mapping, ThreadPool& threadPool)
+    {
+        NRIDevice& device = NRIDevice::Get();
+        std::span<const UploadPiece> pieces = std::span(m_plan.Pieces).subspan(chunk.FirstPiece, chunk.NumPieces);
+
+        // Pieces never overlap, thus they are filled independently. Previous chunk is being copied in the meantime
+        threadPool.ParallelFor(pieces.size(), [&batch, &pieces, mapping](size_t i)
+            {
+                const UploadPiece& piece = pieces[i];
+                const UploadBatch::Copy& copy = batch.m_copies[piece.Request];
+                std::byte* dst = mapping + piece.ChunkOffset;
+                if (copy.Subresource == UploadBatch::BufferSubresource)
+                {
+                    std::memcpy(dst, copy.Data + piece.RequestOffset, piece.NumBytes);
+                    return;
+                }
+
+                // Rows of the source that are already laid out as the footprint are copied at once
+                const UINT64 rowPitch = copy.Footprint.RowPitch;
+                const UINT64 firstRow = piece.RequestOffset / rowPitch;
+                const UINT64 numRows = piece.NumBytes / rowPitch;
+                if (copy.DataRowPitch == rowPitch && copy.NumBytesInRow == rowPitch)
+                {
+                    std::memcpy(dst, copy.Data + firstRow * rowPitch, piece.NumBytes);
+                    return;
+                }
+
+                for (UINT64 row = 0; row < numRows; ++row)
+                    std::memcpy(dst + row * rowPitch, copy.Data + (firstRow + row) * copy.DataRowPitch, copy.NumBytesInRow);
+            });
+
+        CommandAllocatorPool& allocatorPool = device.GetCommandAllocatorPool(eCommandContextType_Copy);
+        D3D12Rc<ID3D12CommandAllocator> allocator = allocatorPool.QueryAllocator();
+        ThrowIfFailed(m_commandList->Reset(allocator.Get(), nullptr));
+
+        for (const UploadPiece& piece : pieces)
+        {
+            const UploadBatch::Copy& copy = batch.m_copies[piece.Request];
+            const UINT64 srcOffset = stagingOffset + piece.ChunkOffset;
+            if (copy.Subresource == UploadBatch::BufferSubresource)
+            {
+                m_commandList->CopyBufferRegion(copy.Dst, copy.DstOffset + piece.RequestOffset, staging, srcOffset, piece.NumBytes);
+                continue;
+            }
+
+            // Each piece is a range of rows, texel height of a row is 4 for block-compressed formats
+            const UINT rowPitch = copy.Footprint.RowPitch;
+            const UINT rowHeight = copy.Footprint.Height / copy.NumRows;
+            const UINT firstRow = static_cast<UINT>(piece.RequestOffset / rowPitch);
+            const UINT numRows = static_cast<UINT>(piece.NumBytes / rowPitch);
+
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {
+                .Offset = srcOffset,
+                .Footprint = copy.Footprint,
+            };
+            footprint.Footprint.Height = numRows * rowHeight;
+
+            D3D12_TEXTURE_COPY_LOCATION dstLocation = CD3DX12_TEXTURE_COPY_LOCATION(copy.Dst, copy.Subresource);
+            D3D12_TEXTURE_COPY_LOCATION srcLocation = CD3DX12_TEXTURE_COPY_LOCATION(staging, footprint);
+            m_commandList->CopyTextureRegion(&dstLocation, 0, firstRow * rowHeight, 0, &srcLocation, nullptr);
+        }
+        ThrowIfFailed(m_commandList->Close());
+
+        ID3D12CommandList* pCommandLists[] = { m_commandList.Get() };
+        ID3D12CommandQueue* copyQueue = device.GetCommandQueue(eCommandContextType_Copy);
+        copyQueue->ExecuteCommandLists(_countof(pCommandLists), pCommandLists);
+
+        ThrowIfFailed(copyQueue->Signal(m_fence.Get(), ++m_fenceValue));
+        allocatorPool.DiscardAllocator(allocator, m_fence.Get(), m_fenceValue);
+    }
+
+    Rc<ID3D12Resource> UploadService::CreateUploadBuffer(UINT64 numBytes)
+    {
+        NRIDevice& device = NRIDevice::Get();
+
+        D3D12_RESOURCE_DESC uploadDesc = CD3DX12_RESOURCE_DESC::Buffer(D3D12_RESOURCE_ALLOCATION_INFO{ .SizeInBytes = numBytes, .Alignment = 0 });
+        D3D12MA::Allocator* allocator = device.GetResourceAllocator();
+        D3D12MA::ALLOCATION_DESC allocDesc = {
+            .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+            .HeapType = D3D12_HEAP_TYPE_UPLOAD,
+        };
+
+        Rc<ID3D12Resource> uploadBuffer;
+        Rc<D3D12MA::Allocation> allocation;
+        ThrowIfFailed(allocator->CreateResource(
+            &allocDesc,
+            &uploadDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ, // This is the required starting state for an upload heap
+            nullptr, allocation.GetAddressOf(),
+            IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
+        return uploadBuffer;
+    }
+
+} // Neb::nri namespace
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "stdafx.h"
+#include "../core/UploadPlanner.h"
+#include "../util/ThreadPool.h"
+
+#include <deque>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace Neb::nri
+{
+
+    // Fence value of the copy queue submission, that completes the upload. 0 is always completed
+    using UploadTicket = UINT64;
+
+    // Copies of a single submission to UploadService. Sources are only read during UploadService::Submit,
+    // while destinations have to stay alive until the ticket of the submission is completed
+    class UploadBatch
+    {
+    public:
+        void AddBuffer(ID3D12Resource* dst, UINT64 dstOffset, std::span<const std::byte> data);
+
+        // Footprint of the subresource as returned by GetCopyableFootprints (offset is not needed). Rows of the source are
+        // dataRowPitch apart, rows of block-compressed formats are rows of blocks
+        void AddTexture(ID3D12Resource* dst, UINT subresource, const D3D12_SUBRESOURCE_FOOTPRINT& footprint,
+            UINT numRows, UINT64 numBytesInRow, const std::byte* data, UINT64 dataRowPitch);
+
+        bool IsEmpty() const { return m_copies.empty(); }
+        void Clear();
+
+    private:
+        friend class UploadService;
+
+        static constexpr UINT BufferSubresource = UINT(-1);
+
+        struct Copy
+        {
+            ID3D12Resource* Dst = nullptr;
+            UINT Subresource = BufferSubresource;
+            UINT64 DstOffset = 0; // buffers only
+            D3D12_SUBRESOURCE_FOOTPRINT Footprint = {}; // textures only
+            UINT NumRows = 1;
+            UINT64 NumBytesInRow = 0;
+            const std::byte* Data = nullptr;
+            UINT64 DataRowPitch = 0;
+        };
+
+        std::vector<Copy> m_copies;
+        std::vector<UploadRequestDesc> m_requests; // staging layout of every copy, see PlanUploads
+    };
+
+    // Shared path for every CPU -> GPU upload of the engine. Instead of creating an upload buffer per resource, copies are
+    // planned into chunks of a single persistently mapped staging ring (see UploadPlanner.h). Each chunk is submitted
+    // to the copy queue as soon as it is filled, so the copy queue drains earlier chunks while later ones are filled
+    // on the thread pool. Only chunks that do not fit the whole ring get an upload buffer of their own
+    class UploadService
+    {
+    public:
+        UploadService() = default;
+
+        UploadService(const UploadService&) = delete;
+        UploadService& operator=(const UploadService&) = delete;
+
+        // Ring size is taken from EConfigKey::UploadRingSizeMb
+        void Init();
+        void Deinit(); // waits for every submission
+
+        // Thread-safe. Blocks only while the ring is full, until the copy queue releases enough of it. Chunks are filled
+        // on threadPool, so that loads on a pool of their own (see SceneLoader) do not queue jobs on the shared one
+        UploadTicket Submit(const UploadBatch& batch, ThreadPool& threadPool = ThreadPool::Get());
+
+        bool IsCompleted(UploadTicket ticket) const;
+        void Wait(UploadTicket ticket) const;
+
+    private:
+        // Pieces of the chunk are filled on the thread pool and copied with a single command list
+        void SubmitChunk(const UploadBatch& batch, const UploadChunk& chunk, ID3D12Resource* staging, UINT64 stagingOffset, std::byte* mapping, ThreadPool& threadPool);
+        Rc<ID3D12Resource> CreateUploadBuffer(UINT64 numBytes);
+
+        std::mutex m_mutex;
+        StagingRing m_ring;
+        UploadPlan m_plan; // reused between submissions
+        UINT64 m_chunkSize = 0;
+
+        Rc<ID3D12Resource> m_ringBuffer;
+        std::byte* m_ringMapping = nullptr;
+
+        Rc<ID3D12GraphicsCommandList> m_commandList;
+        Rc<ID3D12Fence> m_fence;
+        UINT64 m_fenceValue = 0;
+
+        // Upload buffers of chunks larger than the ring, released once their copies are completed
+        struct DedicatedUploadBuffer
+        {
+            Rc<ID3D12Resource> Buffer;
+            UINT64 FenceValue = 0;
+        };
+        std::deque<DedicatedUploadBuffer> m_dedicatedBuffers;
+    };
+
+} // Neb::nri namespace
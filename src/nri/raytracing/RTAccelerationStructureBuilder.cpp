@@ -5,24 +5,69 @@
 
 #include "util/Memory.h"
 
+#include <algorithm>
 #include <ranges>
 #include <cstring>
 
 namespace Neb::nri
 {
 
-    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> RTAccelerationStructureBuilder::QueryGeometryDescArray(const StaticMesh& mesh) const
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> RTAccelerationStructureBuilder::QueryGeometryDescArray(const StaticMesh& mesh, Rc<ID3D12Resource>& transformBuffer) const
     {
         std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> result(mesh.Submeshes.size());
 
+        // Compact positions are snorm in the box of the submesh, BLAS dequantizes them with a 3x4 row-major transform per submesh
+        static constexpr UINT64 TransformStride = sizeof(float) * 12;
+        static_assert(TransformStride % D3D12_RAYTRACING_TRANSFORM3X4_BYTE_ALIGNMENT == 0);
+
+        float* transforms = nullptr;
+        transformBuffer = nullptr;
+        if (std::ranges::any_of(mesh.Submeshes, [](const StaticSubmesh& submesh) { return submesh.VertexFormat == eVertexFormat_Compact; }))
+        {
+            D3D12MA::ALLOCATION_DESC allocDesc = { .HeapType = D3D12_HEAP_TYPE_UPLOAD };
+            D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(TransformStride * mesh.Submeshes.size(), D3D12_RESOURCE_FLAG_NONE);
+
+            nri::Rc<D3D12MA::Allocation> allocation;
+            ThrowIfFailed(NRIDevice::Get().GetResourceAllocator()->CreateResource(&allocDesc, &desc, D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                allocation.GetAddressOf(),
+                IID_PPV_ARGS(transformBuffer.GetAddressOf())));
+
+            ThrowIfFailed(transformBuffer->Map(0, nullptr, reinterpret_cast<void**>(&transforms)),
+                "Could not map memory of BLAS transform buffer");
+        }
+
         // populate geometryDescArray with submesh geometry data
-        for (auto [submesh, geometryDesc] : std::views::zip(mesh.Submeshes, result))
+        for (size_t i = 0; i < mesh.Submeshes.size(); ++i)
         {
+            const StaticSubmesh& submesh = mesh.Submeshes[i];
+            D3D12_RAYTRACING_GEOMETRY_DESC& geometryDesc = result[i];
+
             RTBottomLevelGeometry submeshGeometry;
-            submeshGeometry.positionBufferRange = RTBufferRange::Create<Vec3>(
-                submesh.AttributeBuffers[eAttributeType_Position],
-                submesh.AttributeOffsets[eAttributeType_Position],
-                submesh.NumVertices);
+            if (submesh.VertexFormat == eVertexFormat_Compact)
+            {
+                submeshGeometry.positionBufferRange = RTBufferRange::Create<CompactPosition>(
+                    submesh.AttributeBuffers[eAttributeType_Position],
+                    submesh.AttributeOffsets[eAttributeType_Position],
+                    submesh.NumVertices);
+                submeshGeometry.positionFormat = DXGI_FORMAT_R16G16B16A16_SNORM;
+
+                const PositionQuantization& quantization = submesh.Quantization;
+                const float transform[12] = {
+                    quantization.Scale[0], 0.0f, 0.0f, quantization.Bias[0],
+                    0.0f, quantization.Scale[1], 0.0f, quantization.Bias[1],
+                    0.0f, 0.0f, quantization.Scale[2], quantization.Bias[2],
+                };
+                std::memcpy(transforms + i * 12, transform, sizeof(transform));
+                submeshGeometry.transform3x4 = transformBuffer->GetGPUVirtualAddress() + i * TransformStride;
+            }
+            else
+            {
+                submeshGeometry.positionBufferRange = RTBufferRange::Create<Vec3>(
+                    submesh.AttributeBuffers[eAttributeType_Position],
+                    submesh.AttributeOffsets[eAttributeType_Position],
+                    submesh.NumVertices);
+            }
 
             submeshGeometry.indexBufferRange = RTBufferRange(
                 submesh.IndexBuffer,
@@ -37,6 +82,9 @@ namespace Neb::nri
             };
         }
 
+        if (transformBuffer)
+            transformBuffer->Unmap(0, nullptr);
+
         return result;
     }
 
@@ -97,6 +145,16 @@ namespace Neb::nri
         return blas;
     }
 
+    RTBlasBuffers RTAccelerationStructureBuilder::CreateBlas(ID3D12GraphicsCommandList4* commandList, const StaticMesh& mesh) const
+    {
+        Rc<ID3D12Resource> transformBuffer;
+        std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryArray = this->QueryGeometryDescArray(mesh, transformBuffer);
+
+        RTBlasBuffers blas = this->CreateBlas(commandList, geometryArray);
+        blas.transformBuffer = transformBuffer;
+        return blas;
+    }
+
     RTTlasBuffers RTAccelerationStructureBuilder::CreateTlas(ID3D12GraphicsCommandList4* commandList, std::span<const RTTopLevelInstance> instances, const RTTlasBuffers& updateTlas)
     {
         UINT numInstances = static_cast<UINT>(instances.size());
@@ -15,12 +15,14 @@ namespace Neb::nri
     public:
         RTAccelerationStructureBuilder() = default;
 
-        // Pre-build BLAS info
-        std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> QueryGeometryDescArray(const StaticMesh& mesh) const;
+        // Pre-build BLAS info. If any of the submeshes is in the compact vertex format, transformBuffer receives an upload buffer
+        // with their dequantization transforms, it should be kept alive until the BLAS is built
+        std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> QueryGeometryDescArray(const StaticMesh& mesh, Rc<ID3D12Resource>& transformBuffer) const;
         RTPrebuildInfo GetPrebuildInfo(const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs) const;
 
         // remark: only support for TLAS updates now, BLAS are static
         RTBlasBuffers CreateBlas(ID3D12GraphicsCommandList4* commandList, std::span<const D3D12_RAYTRACING_GEOMETRY_DESC> geometryArray) const;
+        RTBlasBuffers CreateBlas(ID3D12GraphicsCommandList4* commandList, const StaticMesh& mesh) const;
         RTTlasBuffers CreateTlas(ID3D12GraphicsCommandList4* commandList, std::span<const RTTopLevelInstance> instances, const RTTlasBuffers& updateTlas = RTTlasBuffers());
 
     private:
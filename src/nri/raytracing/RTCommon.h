@@ -20,6 +20,7 @@ namespace Neb::nri
 
         Rc<ID3D12Resource> scratchBuffer;
         Rc<ID3D12Resource> accelerationStructureBuffer;
+        Rc<ID3D12Resource> transformBuffer; // dequantization transforms of compact submeshes, only needed during the build
     };
 
     struct RTTlasBuffers
@@ -61,12 +62,14 @@ namespace Neb::nri
         inline D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC GetD3D12TrianglesDesc() const
         {
             D3D12_RAYTRACING_GEOMETRY_TRIANGLES_DESC geometryDesc = {};
-            geometryDesc.Transform3x4 = NULL; // we are not using transformation in BLAS
+            geometryDesc.Transform3x4 = transform3x4; // only used to dequantize compact positions, instances are not transformed in BLAS
 
-            NEB_ASSERT(positionBufferRange.elementStride == sizeof(Vec3), "We assume position format to be DXGI_FORMAT_R32G32B32_FLOAT");
+            NEB_ASSERT((positionFormat == DXGI_FORMAT_R32G32B32_FLOAT && positionBufferRange.elementStride == sizeof(Vec3)) ||
+                (positionFormat == DXGI_FORMAT_R16G16B16A16_SNORM && positionBufferRange.elementStride == sizeof(uint16_t) * 4),
+                "Position format should be either DXGI_FORMAT_R32G32B32_FLOAT or DXGI_FORMAT_R16G16B16A16_SNORM (compact vertex format)");
             geometryDesc.VertexBuffer.StartAddress = positionBufferRange.buffer->GetGPUVirtualAddress() + positionBufferRange.offsetInBytes;
             geometryDesc.VertexBuffer.StrideInBytes = positionBufferRange.elementStride;
-            geometryDesc.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT; // just assert this for the entire Nebulae rt
+            geometryDesc.VertexFormat = positionFormat;
             geometryDesc.VertexCount = positionBufferRange.numElements;
 
             geometryDesc.IndexBuffer = indexBufferRange.buffer->GetGPUVirtualAddress() + indexBufferRange.offsetInBytes;
@@ -77,6 +80,10 @@ namespace Neb::nri
 
         RTBufferRange positionBufferRange;
         RTBufferRange indexBufferRange;
+
+        // Both R32G32B32_FLOAT and R16G16B16A16_SNORM are supported by DXR tier 1.0, the latter is expected to come with transform3x4
+        DXGI_FORMAT positionFormat = DXGI_FORMAT_R32G32B32_FLOAT;
+        D3D12_GPU_VIRTUAL_ADDRESS transform3x4 = NULL;
     };
 
     // Represents TLAS instance data needed to initialize to initialize the acceleration structure
@@ -12,23 +12,22 @@ namespace Neb::nri
         m_blasBuffers.clear();
         m_blasBuffers.resize(m_scene->StaticMeshes.size());
 
-        // TODO: Remark -> right now we have 1 tlas instance per 1 blas ALWAYS
-        // if this is to change, we need to properly push instances back (and rewrite half the thing actually)
-        std::vector<RTTopLevelInstance> instances(m_scene->StaticMeshes.size());
-
         for (UINT i = 0; i < m_scene->StaticMeshes.size(); ++i)
         {
             StaticMesh& mesh = m_scene->StaticMeshes[i];
-            std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryArray = m_asBuilder.QueryGeometryDescArray(mesh);
 
-            // BLAS creation should happen per-mesh as every submesh inside the mesh will share the same
-            // instanceToWorld transformation
-            m_blasBuffers[i] = m_asBuilder.CreateBlas(commandList, geometryArray);
+            // BLAS creation should happen per-mesh, instances of the mesh only reference it with their own transformation
+            m_blasBuffers[i] = m_asBuilder.CreateBlas(commandList, mesh);
             ThrowIfFalse(m_blasBuffers[i].IsValid(), "Created blas buffers are not valid!");
+        }
 
+        std::vector<RTTopLevelInstance> instances(m_scene->StaticMeshInstances.size());
+        for (UINT i = 0; i < m_scene->StaticMeshInstances.size(); ++i)
+        {
+            const StaticMeshInstance& instance = m_scene->StaticMeshInstances[i];
             instances[i] = RTTopLevelInstance{
-                .blasAccelerationStructure = m_blasBuffers[i].accelerationStructureBuffer,
-                .transformation = mesh.InstanceToWorld,
+                .blasAccelerationStructure = m_blasBuffers[instance.MeshIndex].accelerationStructureBuffer,
+                .transformation = instance.InstanceToWorld,
                 .instanceID = i,
                 .hitGroupIndex = 0, // TODO: Change to actually match SBT entry
                 .flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_FRONT_COUNTERCLOCKWISE,
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <span>
+
+namespace Neb
+{
+
+    // 64-bit non-cryptographic content hash, follows XXH64 (https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md)
+    // We use it to key baked caches and deduplicate resources by their contents, so it should be fast on large inputs
+    namespace detail
+    {
+        static constexpr uint64_t HashPrime1 = 0x9E3779B185EBCA87ull;
+        static constexpr uint64_t HashPrime2 = 0xC2B2AE3D27D4EB4Full;
+        static constexpr uint64_t HashPrime3 = 0x165667B19E3779F9ull;
+        static constexpr uint64_t HashPrime4 = 0x85EBCA77C2B2AE63ull;
+        static constexpr uint64_t HashPrime5 = 0x27D4EB2F165667C5ull;
+
+        inline uint64_t HashRead64(const std::byte* p) noexcept
+        {
+            uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint32_t HashRead32(const std::byte* p) noexcept
+        {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        inline uint64_t HashRound(uint64_t acc, uint64_t input) noexcept
+        {
+            acc += input * HashPrime2;
+            acc = std::rotl(acc, 31);
+            return acc * HashPrime1;
+        }
+
+        inline uint64_t HashMergeRound(uint64_t acc, uint64_t val) noexcept
+        {
+            acc ^= HashRound(0, val);
+            return acc * HashPrime1 + HashPrime4;
+        }
+    } // detail namespace
+
+    inline uint64_t HashBytes64(const void* data, size_t numBytes, uint64_t seed = 0) noexcept
+    {
+        using namespace detail;
+
+        const std::byte* p = static_cast<const std::byte*>(data);
+        const std::byte* end = p + numBytes;
+
+        uint64_t h;
+        if (numBytes >= 32)
+        {
+            uint64_t v1 = seed + HashPrime1 + HashPrime2;
+            uint64_t v2 = seed + HashPrime2;
+            uint64_t v3 = seed;
+            uint64_t v4 = seed - HashPrime1;
+
+            const std::byte* limit = end - 32;
+            do
+            {
+                v1 = HashRound(v1, HashRead64(p));
+                v2 = HashRound(v2, HashRead64(p + 8));
+                v3 = HashRound(v3, HashRead64(p + 16));
+                v4 = HashRound(v4, HashRead64(p + 24));
+                p += 32;
+            } while (p <= limit);
+
+            h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+            h = HashMergeRound(h, v1);
+            h = HashMergeRound(h, v2);
+            h = HashMergeRound(h, v3);
+            h = HashMergeRound(h, v4);
+        }
+        else
+        {
+            h = seed + HashPrime5;
+        }
+
+        h += static_cast<uint64_t>(numBytes);
+
+        for (; p + 8 <= end; p += 8)
+        {
+            h ^= HashRound(0, HashRead64(p));
+            h = std::rotl(h, 27) * HashPrime1 + HashPrime4;
+        }
+
+        if (p + 4 <= end)
+        {
+            h ^= static_cast<uint64_t>(HashRead32(p)) * HashPrime1;
+            h = std::rotl(h, 23) * HashPrime2 + HashPrime3;
+            p += 4;
+        }
+
+        for (; p < end; ++p)
+        {
+            h ^= static_cast<uint64_t>(*p) * HashPrime5;
+            h = std::rotl(h, 11) * HashPrime1;
+        }
+
+        // final avalanche
+        h ^= h >> 33;
+        h *= HashPrime2;
+        h ^= h >> 29;
+        h *= HashPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    inline uint64_t HashBytes64(std::span<const std::byte> bytes, uint64_t seed = 0) noexcept
+    {
+        return HashBytes64(bytes.data(), bytes.size(), seed);
+    }
+
+    // Combines two hashes, order-dependent
+    inline uint64_t HashCombine64(uint64_t seed, uint64_t value) noexcept
+    {
+        return seed ^ (value + detail::HashPrime1 + (seed << 6) + (seed >> 2));
+    }
+
+} // Neb namespace
@@ -0,0 +1,86 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+namespace Neb
+{
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : m_file(std::exchange(other.m_file, INVALID_HANDLE_VALUE))
+        , m_mapping(std::exchange(other.m_mapping, (HANDLE)NULL))
+        , m_view(std::exchange(other.m_view, nullptr))
+        , m_numBytes(std::exchange(other.m_numBytes, 0))
+    {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            m_file = std::exchange(other.m_file, INVALID_HANDLE_VALUE);
+            m_mapping = std::exchange(other.m_mapping, (HANDLE)NULL);
+            m_view = std::exchange(other.m_view, nullptr);
+            m_numBytes = std::exchange(other.m_numBytes, 0);
+        }
+        return *this;
+    }
+
+    bool MappedFile::Open(const std::filesystem::path& filepath)
+    {
+        Close();
+
+        m_file = CreateFileW(filepath.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            NULL);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER fileSize = {};
+        if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+        {
+            // CreateFileMapping fails on empty files, just treat them as invalid
+            Close();
+            return false;
+        }
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == NULL)
+        {
+            Close();
+            return false;
+        }
+
+        m_view = static_cast<const std::byte*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!m_view)
+        {
+            Close();
+            return false;
+        }
+
+        m_numBytes = static_cast<size_t>(fileSize.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_view)
+            UnmapViewOfFile(m_view);
+
+        if (m_mapping != NULL)
+            CloseHandle(m_mapping);
+
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = NULL;
+        m_view = nullptr;
+        m_numBytes = 0;
+    }
+
+} // Neb namespace
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../Win.h"
+
+#include <filesystem>
+#include <span>
+
+namespace Neb
+{
+
+    // Read-only memory mapping of a whole file. Pages are faulted in by the OS on first access,
+    // thus opening the mapping is cheap and only the touched ranges are ever read from disk.
+    // Views handed out by the mapping are only valid while the mapping is alive
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        // returns false if file does not exist or could not be mapped. Empty files cannot be mapped
+        bool Open(const std::filesystem::path& filepath);
+        void Close();
+
+        bool IsValid() const { return m_view != nullptr; }
+
+        std::span<const std::byte> GetBytes() const { return std::span<const std::byte>(m_view, m_numBytes); }
+        const std::byte* GetData() const { return m_view; }
+        size_t GetSize() const { return m_numBytes; }
+
+    private:
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = NULL;
+        const std::byte* m_view = nullptr;
+        size_t m_numBytes = 0;
+    };
+
+} // Neb namespace
@@ -0,0 +1,147 @@
+#include "ThreadPool.h"
+
+#include "common/Assert.h"
+#include "common/Configuration.h"
+
+namespace Neb
+{
+
+    ThreadPool::ThreadPool(uint32_t numWorkers)
+    {
+        StartWorkers(numWorkers);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        StopWorkers();
+    }
+
+    ThreadPool& ThreadPool::Get()
+    {
+        // Configured value is the total amount of threads, including the calling one. 0 means use all hardware threads
+        static ThreadPool instance([]()
+            {
+                const int32_t numThreads = Config::GetValue<int32_t>(EConfigKey::NumWorkerThreads, 0);
+                return numThreads > 0 ? uint32_t(numThreads - 1) : GetDefaultNumWorkers();
+            }());
+        return instance;
+    }
+
+    uint32_t ThreadPool::GetDefaultNumWorkers()
+    {
+        const uint32_t numHardwareThreads = std::thread::hardware_concurrency();
+        return numHardwareThreads > 1 ? numHardwareThreads - 1 : 0;
+    }
+
+    void ThreadPool::Resize(uint32_t numWorkers)
+    {
+        StopWorkers();
+        StartWorkers(numWorkers);
+    }
+
+    void ThreadPool::Dispatch(size_t numChunks, std::function<void(size_t)> func)
+    {
+        std::shared_ptr<Job> job = std::make_shared<Job>();
+        job->Func = std::move(func);
+        job->NumChunks = numChunks;
+        {
+            std::scoped_lock _(m_mutex);
+            m_jobs.push_back(job);
+        }
+        m_wakeCondition.notify_all();
+
+        // Calling thread participates as well, afterwards wait for the chunks that workers are still executing
+        ExecuteChunks(*job);
+        {
+            std::unique_lock lock(m_mutex);
+            m_doneCondition.wait(lock, [&job]() { return job->NumCompletedChunks.load() == job->NumChunks; });
+
+            auto it = std::find(m_jobs.begin(), m_jobs.end(), job);
+            if (it != m_jobs.end())
+                m_jobs.erase(it);
+        }
+
+        if (job->Exception)
+            std::rethrow_exception(job->Exception);
+    }
+
+    size_t ThreadPool::ExecuteChunks(Job& job)
+    {
+        size_t numExecuted = 0;
+        while (true)
+        {
+            const size_t chunk = job.NextChunk.fetch_add(1);
+            if (chunk >= job.NumChunks)
+                break;
+
+            try
+            {
+                job.Func(chunk);
+            }
+            catch (...)
+            {
+                std::scoped_lock _(job.ExceptionMutex);
+                if (!job.Exception)
+                    job.Exception = std::current_exception();
+            }
+
+            ++numExecuted;
+            if (job.NumCompletedChunks.fetch_add(1) + 1 == job.NumChunks)
+            {
+                // Lock to not lose the wakeup in between predicate check and wait of the dispatching thread
+                std::scoped_lock _(m_mutex);
+                m_doneCondition.notify_all();
+            }
+        }
+        return numExecuted;
+    }
+
+    void ThreadPool::StartWorkers(uint32_t numWorkers)
+    {
+        NEB_ASSERT(m_workers.empty(), "Workers should be stopped before starting new ones");
+
+        m_isStopping = false;
+        m_workers.reserve(numWorkers);
+        for (uint32_t i = 0; i < numWorkers; ++i)
+            m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    void ThreadPool::StopWorkers()
+    {
+        {
+            std::scoped_lock _(m_mutex);
+            m_isStopping = true;
+        }
+        m_wakeCondition.notify_all();
+
+        for (std::thread& worker : m_workers)
+            worker.join();
+
+        m_workers.clear();
+    }
+
+    void ThreadPool::WorkerLoop()
+    {
+        while (true)
+        {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wakeCondition.wait(lock, [this]() { return m_isStopping || !m_jobs.empty(); });
+                if (m_isStopping)
+                    return;
+
+                job = m_jobs.front();
+                if (job->NextChunk.load() >= job->NumChunks)
+                {
+                    // Every chunk is already taken, the job will be finished by whoever took them
+                    m_jobs.pop_front();
+                    continue;
+                }
+            }
+
+            ExecuteChunks(*job);
+        }
+    }
+
+} // Neb namespace
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Neb
+{
+
+    // Simple fork-join worker pool for CPU-side data-parallel work (asset processing, culling, sorting etc.)
+    //
+    // The only primitive is ParallelFor, which splits [0, count) into chunks of grainSize and runs them on workers.
+    // The calling thread always participates in the work, thus ParallelFor can be safely called from within
+    // another ParallelFor (nested jobs are never starved) and a pool with 0 workers just runs everything inline
+    class ThreadPool
+    {
+    public:
+        // numWorkers = 0 means everything is executed on the calling thread
+        explicit ThreadPool(uint32_t numWorkers = GetDefaultNumWorkers());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Shared pool for engine subsystems. Number of workers can be configured with EConfigKey::NumWorkerThreads
+        static ThreadPool& Get();
+
+        // One worker less than hardware threads, as calling thread always participates
+        static uint32_t GetDefaultNumWorkers();
+
+        // Waits for all running jobs and recreates workers. Must not be called from a worker
+        void Resize(uint32_t numWorkers);
+
+        uint32_t GetNumWorkers() const { return static_cast<uint32_t>(m_workers.size()); }
+
+        // Number of threads that may execute a job concurrently, including the calling one
+        uint32_t GetNumThreads() const { return GetNumWorkers() + 1; }
+
+        // func is called as func(size_t begin, size_t end) for each chunk. Blocks until every chunk is processed.
+        // If any chunk throws, the first exception is rethrown on the calling thread after all chunks are done
+        template<typename Func>
+        void ParallelForRange(size_t count, size_t grainSize, Func&& func)
+        {
+            if (count == 0)
+                return;
+
+            grainSize = grainSize == 0 ? 1 : grainSize;
+            const size_t numChunks = (count + grainSize - 1) / grainSize;
+            if (numChunks == 1 || m_workers.empty())
+            {
+                func(size_t(0), count);
+                return;
+            }
+
+            Dispatch(numChunks, [&func, count, grainSize](size_t chunk)
+                {
+                    const size_t begin = chunk * grainSize;
+                    const size_t end = std::min(begin + grainSize, count);
+                    func(begin, end);
+                });
+        }
+
+        // func is called as func(size_t index) for each index in [0, count)
+        template<typename Func>
+        void ParallelFor(size_t count, Func&& func, size_t grainSize = 1)
+        {
+            ParallelForRange(count, grainSize, [&func](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                        func(i);
+                });
+        }
+
+    private:
+        struct Job
+        {
+            std::function<void(size_t)> Func;
+            size_t NumChunks = 0;
+            std::atomic<size_t> NextChunk = 0;
+            std::atomic<size_t> NumCompletedChunks = 0;
+
+            std::mutex ExceptionMutex;
+            std::exception_ptr Exception;
+        };
+
+        void Dispatch(size_t numChunks, std::function<void(size_t)> func);
+
+        // Executes chunks of the job until there are none left to take. Returns number of executed chunks
+        size_t ExecuteChunks(Job& job);
+
+        void StartWorkers(uint32_t numWorkers);
+        void StopWorkers();
+        void WorkerLoop();
+
+        std::vector<std::thread> m_workers;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeCondition;
+        std::condition_variable m_doneCondition;
+        std::deque<std::shared_ptr<Job>> m_jobs;
+        bool m_isStopping = false;
+    };
+
+} // Neb namespace
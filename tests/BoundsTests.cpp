@@ -0,0 +1,161 @@
+#include "Test.h"
+
+#include "core/Bounds.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <random>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        bool IsVectorNearlyEqual(const Vec3& lhs, const Vec3& rhs, float tolerance)
+        {
+            const float magnitude = std::max({ 1.0f, std::abs(rhs.x), std::abs(rhs.y), std::abs(rhs.z) });
+            return std::abs(lhs.x - rhs.x) <= tolerance * magnitude &&
+                std::abs(lhs.y - rhs.y) <= tolerance * magnitude &&
+                std::abs(lhs.z - rhs.z) <= tolerance * magnitude;
+        }
+
+        // Non-uniform scale, arbitrary rotation and translation
+        Mat4 GenerateTransform(std::mt19937_64& random)
+        {
+            std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+            std::uniform_real_distribution<float> scaleDistribution(0.25f, 4.0f);
+
+            Vec3 axis = Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random));
+            axis = (axis.LengthSquared() > 1e-6f) ? axis : Vec3::UnitY;
+            axis.Normalize();
+
+            return Mat4::CreateScale(scaleDistribution(random), scaleDistribution(random), scaleDistribution(random)) *
+                Mat4::CreateFromAxisAngle(axis, unitDistribution(random) * std::numbers::pi_v<float>) *
+                Mat4::CreateTranslation(Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random)) * 100.0f);
+        }
+
+        AABB GenerateBox(std::mt19937_64& random)
+        {
+            std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+            std::uniform_real_distribution<float> scaleDistribution(0.25f, 4.0f);
+
+            const Vec3 center = Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random)) * 10.0f;
+            const Vec3 extent = Vec3(scaleDistribution(random), scaleDistribution(random), scaleDistribution(random));
+            return AABB{ .min = center - extent, .max = center + extent };
+        }
+    } // anonymous namespace
+
+    // Unit cube rotated by 45 degrees around Y is sqrt(2) wide along X and Z. Transforming only min and max would give a flat box
+    NEB_TEST(Bounds, RotatedBox)
+    {
+        const float h = std::numbers::sqrt2_v<float>;
+        const AABB box = TransformAABBFast(AABB{ .min = Vec3(-1.0f), .max = Vec3(1.0f) }, Mat4::CreateRotationY(ToRadians(45.0f)) * Mat4::CreateTranslation(5.0f, 0.0f, 0.0f));
+        NEB_EXPECT(IsVectorNearlyEqual(box.min, Vec3(5.0f - h, -1.0f, -h), 1e-5f), "min is ({}, {}, {})", box.min.x, box.min.y, box.min.z);
+        NEB_EXPECT(IsVectorNearlyEqual(box.max, Vec3(5.0f + h, 1.0f, h), 1e-5f), "max is ({}, {}, {})", box.max.x, box.max.y, box.max.z);
+
+        NEB_EXPECT(IsEmptyAABB(TransformAABBFast(AABB(), Mat4::CreateTranslation(1.0f, 2.0f, 3.0f))), "empty box is not empty after transform");
+        return true;
+    }
+
+    NEB_TEST(Bounds, MatchesEightCornerTransform)
+    {
+        std::mt19937_64 random(0xB0C5);
+        for (uint32_t i = 0; i < 4096; ++i)
+        {
+            const AABB box = GenerateBox(random);
+            const Mat4 transform = GenerateTransform(random);
+
+            const AABB reference = TransformAABB(box, transform);
+            const AABB result = TransformAABBFast(box, transform);
+            NEB_EXPECT(IsVectorNearlyEqual(result.min, reference.min, 1e-5f) && IsVectorNearlyEqual(result.max, reference.max, 1e-5f),
+                "transformed box {} does not match the scalar 8-corner transform", i);
+        }
+        return true;
+    }
+
+    // Every point is inside of both its box and sphere, spheres stay conservative under transforms
+    NEB_TEST(Bounds, PointCloudsAreConservative)
+    {
+        std::mt19937_64 random(0xB0C5);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+        std::vector<Vec3> points;
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            const AABB cluster = GenerateBox(random);
+            const uint32_t numPoints = 1 + static_cast<uint32_t>(random() % 1024);
+            points.resize(numPoints);
+            for (Vec3& point : points)
+                point = cluster.min + (cluster.max - cluster.min) * Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random));
+
+            AABB box;
+            Sphere sphere;
+            ComputeBounds(reinterpret_cast<const std::byte*>(points.data()), sizeof(Vec3), numPoints, box, sphere);
+
+            const Mat4 transform = GenerateTransform(random);
+            const Sphere transformedSphere = TransformSphere(sphere, transform);
+            for (const Vec3& point : points)
+            {
+                const bool isInBox = point.x >= box.min.x && point.y >= box.min.y && point.z >= box.min.z &&
+                    point.x <= box.max.x && point.y <= box.max.y && point.z <= box.max.z;
+                const bool isInSphere = Vec3::Distance(point, sphere.center) <= sphere.radius * (1.0f + 1e-5f) + 1e-5f;
+                const bool isInTransformedSphere = Vec3::Distance(Vec3::Transform(point, transform), transformedSphere.center) <= transformedSphere.radius * (1.0f + 1e-4f) + 1e-4f;
+                NEB_EXPECT(isInBox && isInSphere && isInTransformedSphere, "bounds of point cloud {} ({} points) are not conservative", i, numPoints);
+            }
+        }
+        return true;
+    }
+
+    // Strided positions (of interleaved vertices) give the same bounds, a single point is a sphere of zero radius
+    NEB_TEST(Bounds, StridedPositions)
+    {
+        const float vertices[][5] = {
+            { -1.0f, 0.0f, 0.0f, 7.0f, 7.0f },
+            { 3.0f, 2.0f, 0.0f, 7.0f, 7.0f },
+            { 1.0f, -2.0f, 4.0f, 7.0f, 7.0f },
+        };
+
+        AABB box;
+        Sphere sphere;
+        ComputeBounds(reinterpret_cast<const std::byte*>(vertices), sizeof(vertices[0]), 3, box, sphere);
+        NEB_EXPECT(IsVectorNearlyEqual(box.min, Vec3(-1.0f, -2.0f, 0.0f), 0.0f) && IsVectorNearlyEqual(box.max, Vec3(3.0f, 2.0f, 4.0f), 0.0f));
+
+        ComputeBounds(reinterpret_cast<const std::byte*>(vertices), sizeof(vertices[0]), 1, box, sphere);
+        NEB_EXPECT(sphere.radius == 0.0f && IsVectorNearlyEqual(sphere.center, Vec3(-1.0f, 0.0f, 0.0f), 0.0f));
+
+        ComputeBounds(nullptr, sizeof(vertices[0]), 0, box, sphere);
+        NEB_EXPECT(IsEmptyAABB(box) && sphere.radius == 0.0f);
+        return true;
+    }
+
+    // Boxes transformed on the thread pool are bitwise the same as ones transformed one after another
+    NEB_TEST(Bounds, ParallelMatchesSerial)
+    {
+        static constexpr uint32_t NumBoxes = 100'000;
+
+        std::mt19937_64 random(0xB0C5);
+        std::vector<AABB> boxes(NumBoxes);
+        std::vector<Mat4> transforms(NumBoxes);
+        for (uint32_t i = 0; i < NumBoxes; ++i)
+        {
+            boxes[i] = GenerateBox(random);
+            transforms[i] = GenerateTransform(random);
+        }
+
+        ThreadPool threadPool(3);
+        std::vector<AABB> transformed(NumBoxes);
+        TransformAABBs(transformed, boxes, transforms, threadPool);
+
+        for (uint32_t i = 0; i < NumBoxes; ++i)
+        {
+            const AABB reference = TransformAABBFast(boxes[i], transforms[i]);
+            NEB_EXPECT(std::memcmp(&reference, &transformed[i], sizeof(AABB)) == 0, "box {} differs", i);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,135 @@
+#include "Test.h"
+
+#include "core/DrawBatching.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Reference keeps a list of draws for every state, states are in the order of their first draws
+        bool MatchesReference(DrawBatcher& batcher, std::span<const uint64_t> keys, uint32_t maxDrawsPerBatch)
+        {
+            std::vector<uint64_t> states;
+            std::unordered_map<uint64_t, std::vector<uint32_t>> stateDraws;
+            for (uint32_t i = 0; i < keys.size(); ++i)
+            {
+                std::vector<uint32_t>& draws = stateDraws[keys[i]];
+                if (draws.empty())
+                    states.push_back(keys[i]);
+                draws.push_back(i);
+            }
+
+            const DrawBatchStats stats = batcher.Build(keys, maxDrawsPerBatch);
+            const std::span<const DrawBatch> batches = batcher.GetBatches();
+            const std::span<const uint32_t> order = batcher.GetOrder();
+            if (stats.NumDraws != keys.size() || stats.NumBatches != batches.size() || order.size() != keys.size())
+                return false;
+
+            uint32_t batchIndex = 0;
+            uint32_t drawIndex = 0;
+            for (uint64_t state : states)
+            {
+                const std::vector<uint32_t>& draws = stateDraws[state];
+                for (uint32_t offset = 0; offset < draws.size(); offset += maxDrawsPerBatch)
+                {
+                    const uint32_t numBatchDraws = std::min<uint32_t>(maxDrawsPerBatch, static_cast<uint32_t>(draws.size()) - offset);
+                    if (batchIndex >= batches.size() || batches[batchIndex].FirstDraw != drawIndex || batches[batchIndex].NumDraws != numBatchDraws)
+                        return false;
+
+                    for (uint32_t i = 0; i < numBatchDraws; ++i)
+                    {
+                        if (order[drawIndex + i] != draws[offset + i])
+                            return false;
+                    }
+
+                    ++batchIndex;
+                    drawIndex += numBatchDraws;
+                }
+            }
+            return batchIndex == batches.size() && drawIndex == keys.size();
+        }
+    } // anonymous namespace
+
+    // Draws of a state are compacted in their relative order, batches follow in the order of first draws and are split by the limit
+    NEB_TEST(DrawBatching, Compaction)
+    {
+        const uint64_t keys[] = { 7, 3, 7, 7, 5, 3, 7 };
+
+        DrawBatcher batcher;
+        const DrawBatchStats stats = batcher.Build(keys, /*maxDrawsPerBatch*/ 3);
+        NEB_EXPECT(stats.NumDraws == 7 && stats.NumBatches == 4 && stats.NumInstancedBatches == 2 && stats.MaxBatchSize == 3,
+            "{} batches ({} instanced, largest of {})", stats.NumBatches, stats.NumInstancedBatches, stats.MaxBatchSize);
+
+        const uint32_t expectedOrder[] = { 0, 2, 3, 6, 1, 5, 4 };
+        NEB_EXPECT(std::ranges::equal(batcher.GetOrder(), expectedOrder));
+
+        const DrawBatch expectedBatches[] = { { 0, 3 }, { 3, 1 }, { 4, 2 }, { 6, 1 } };
+        NEB_EXPECT(batcher.GetBatches().size() == std::size(expectedBatches));
+        for (size_t i = 0; i < std::size(expectedBatches); ++i)
+        {
+            const DrawBatch& batch = batcher.GetBatches()[i];
+            NEB_EXPECT(batch.FirstDraw == expectedBatches[i].FirstDraw && batch.NumDraws == expectedBatches[i].NumDraws,
+                "batch {} is [{}, +{}), expected [{}, +{})", i, batch.FirstDraw, batch.NumDraws, expectedBatches[i].FirstDraw, expectedBatches[i].NumDraws);
+        }
+        return true;
+    }
+
+    // Sorted keys keep their order, batches are runs of equal keys
+    NEB_TEST(DrawBatching, SortedKeysKeepOrder)
+    {
+        const uint64_t keys[] = { 1, 1, 2, 4, 4, 4, 9 };
+
+        DrawBatcher batcher;
+        const DrawBatchStats stats = batcher.Build(keys, UINT32_MAX);
+        NEB_EXPECT(stats.NumBatches == 4 && stats.MaxBatchSize == 3);
+        for (uint32_t i = 0; i < std::size(keys); ++i)
+            NEB_EXPECT(batcher.GetOrder()[i] == i);
+
+        // Batches of a single draw draw everything one by one
+        NEB_EXPECT(batcher.Build(keys, 1).NumBatches == std::size(keys));
+        NEB_EXPECT(batcher.Build({}, 1).NumBatches == 0 && batcher.GetOrder().empty());
+        return true;
+    }
+
+    // Sorted and unsorted keys of several sizes and amounts of states, with and without batch limits
+    NEB_TEST(DrawBatching, MatchesReference)
+    {
+        const auto sizes = std::to_array<uint32_t>({ 0, 1, 2, 17, 1000, 100'000 });
+        const auto numStates = std::to_array<uint32_t>({ 1, 2, 64, 4096, UINT32_MAX });
+        const auto batchLimits = std::to_array<uint32_t>({ 1, 3, 64, UINT32_MAX });
+
+        std::mt19937_64 random(0x42A7);
+        DrawBatcher batcher; // shared, so that scratch of previous builds is reused
+        std::vector<uint64_t> keys;
+        for (uint32_t size : sizes)
+        {
+            for (uint32_t states : numStates)
+            {
+                keys.resize(size);
+                for (uint64_t& key : keys)
+                    key = (states == UINT32_MAX) ? random() : (random() % states) * 0x9E3779B97F4A7C15ull;
+
+                for (bool isSorted : { false, true })
+                {
+                    if (isSorted)
+                        std::ranges::sort(keys);
+
+                    for (uint32_t maxDrawsPerBatch : batchLimits)
+                    {
+                        NEB_EXPECT(MatchesReference(batcher, keys, maxDrawsPerBatch), "{} {} keys of {} states with {} draws per batch differ from the reference",
+                            size, isSorted ? "sorted" : "unsorted", states, maxDrawsPerBatch);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,355 @@
+#include "Test.h"
+
+#include "common/Assert.h"
+#include "core/DrawBatching.h"
+#include "nri/DrawPacket.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Stands for ID3D12GraphicsCommandList. Commands are not recorded, the stub only keeps state that is bound and folds it into
+        // a hash for every instance that is drawn, together with the index of its per-instance data (the same way the G-buffer
+        // vertex shader finds it). Thus hashes match for the same instances drawn with the same state, no matter how many commands
+        // were skipped or how instances were batched
+        class StubCommandList
+        {
+        public:
+            static constexpr UINT MaxRoots = 4;
+
+            explicit StubCommandList(UINT firstInstanceRootIndex)
+                : m_firstInstanceRootIndex(firstInstanceRootIndex)
+            {
+            }
+
+            void SetPipelineState(ID3D12PipelineState* pipelineState) { m_pipelineState = pipelineState; ++m_numCommands; }
+            void SetGraphicsRoot32BitConstant(UINT rootIndex, UINT value, UINT offset) { NEB_ASSERT(offset == 0); m_roots[rootIndex] = value; ++m_numCommands; }
+            void SetGraphicsRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table) { m_roots[rootIndex] = table.ptr; ++m_numCommands; }
+            void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) { m_topology = topology; ++m_numCommands; }
+
+            void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views)
+            {
+                std::copy_n(views, numViews, m_vertexViews.begin() + startSlot);
+                ++m_numCommands;
+            }
+
+            void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) { m_indexView = *view; ++m_numCommands; }
+
+            void DrawIndexedInstanced(UINT numIndices, UINT numInstances, UINT firstIndex, INT baseVertex, UINT firstInstance)
+            {
+                for (UINT instance = 0; instance < numInstances; ++instance)
+                {
+                    Mix(reinterpret_cast<uintptr_t>(m_pipelineState));
+                    for (UINT rootIndex = 0; rootIndex < MaxRoots; ++rootIndex)
+                        Mix(rootIndex == m_firstInstanceRootIndex ? m_roots[rootIndex] + instance : m_roots[rootIndex]);
+                    Mix(uint64_t(m_topology));
+                    for (const D3D12_VERTEX_BUFFER_VIEW& view : m_vertexViews)
+                        Mix(view.BufferLocation ^ (uint64_t(view.SizeInBytes) << 32 | view.StrideInBytes));
+                    Mix(m_indexView.BufferLocation ^ (uint64_t(m_indexView.SizeInBytes) << 32 | uint64_t(m_indexView.Format)));
+
+                    Mix(numIndices);
+                    Mix(firstIndex);
+                    Mix(uint64_t(int64_t(baseVertex)));
+                    Mix(firstInstance);
+                }
+                m_numInstances += numInstances;
+                ++m_numCommands;
+            }
+
+            uint64_t GetHash() const { return m_hash; }
+            uint64_t GetNumCommands() const { return m_numCommands; }
+            uint64_t GetNumInstances() const { return m_numInstances; }
+
+        private:
+            void Mix(uint64_t value) { m_hash = (m_hash ^ value) * 0x100000001B3ull; }
+
+            UINT m_firstInstanceRootIndex = 0;
+            ID3D12PipelineState* m_pipelineState = nullptr;
+            std::array<uint64_t, MaxRoots> m_roots = {};
+            D3D12_PRIMITIVE_TOPOLOGY m_topology = {};
+            std::array<D3D12_VERTEX_BUFFER_VIEW, eAttributeType_NumTypes> m_vertexViews = {};
+            D3D12_INDEX_BUFFER_VIEW m_indexView = {};
+
+            uint64_t m_hash = 0xCBF29CE484222325ull;
+            uint64_t m_numCommands = 0;
+            uint64_t m_numInstances = 0;
+        };
+
+        // Synthetic scene, resources are never touched by the stub, so views and tables are just distinct addresses.
+        // Draws are submeshes of instances in scene order, the same order packets are built in
+        struct DrawScene
+        {
+            struct Draw
+            {
+                uint32_t InstanceIndex = 0;
+                uint32_t SubmeshIndex = 0;
+            };
+
+            std::vector<nri::StaticMesh> Meshes;
+            std::vector<nri::StaticMeshInstance> Instances;
+            std::vector<Draw> Draws;
+        };
+
+        void BuildDrawScene(DrawScene& scene, uint32_t numDraws, std::mt19937_64& random)
+        {
+            static constexpr uint32_t MaxSubmeshes = 4;
+            static constexpr uint32_t NumMaterials = 256;
+            const uint32_t numMeshes = std::max(numDraws / 64, 1u);
+
+            scene.Meshes.resize(numMeshes);
+            for (nri::StaticMesh& staticMesh : scene.Meshes)
+            {
+                staticMesh.Submeshes.resize(1 + random() % MaxSubmeshes);
+                staticMesh.SubmeshMaterials.resize(staticMesh.Submeshes.size());
+                for (size_t submeshIndex = 0; submeshIndex < staticMesh.Submeshes.size(); ++submeshIndex)
+                {
+                    nri::StaticSubmesh& submesh = staticMesh.Submeshes[submeshIndex];
+                    submesh.VertexFormat = static_cast<nri::EVertexFormat>(random() % nri::eVertexFormat_NumFormats);
+                    submesh.NumVertices = static_cast<UINT>(3 + random() % 4096);
+                    for (uint32_t type = 0; type < nri::eAttributeType_NumTypes; ++type)
+                    {
+                        const UINT stride = nri::StaticMeshAttributeSizes[submesh.VertexFormat][type];
+                        submesh.AttributeViews[type] = D3D12_VERTEX_BUFFER_VIEW{
+                            .BufferLocation = (random() & 0xFFFFFFFF) << 16,
+                            .SizeInBytes = stride * submesh.NumVertices,
+                            .StrideInBytes = stride,
+                        };
+                    }
+
+                    submesh.NumIndices = static_cast<UINT>(3 * (1 + random() % 8192));
+                    submesh.IBView = D3D12_INDEX_BUFFER_VIEW{
+                        .BufferLocation = (random() & 0xFFFFFFFF) << 16,
+                        .SizeInBytes = static_cast<UINT>(submesh.NumIndices * sizeof(uint32_t)),
+                        .Format = DXGI_FORMAT_R32_UINT,
+                    };
+
+                    nri::Material& material = staticMesh.SubmeshMaterials[submeshIndex];
+                    material.SrvRange.GpuAddress.ptr = 0x100000 + (random() % NumMaterials) * nri::eMaterialTextureType_NumTypes * 32;
+                    material.Flags = static_cast<nri::EMaterialFlags>(random() % 8);
+                }
+            }
+
+            while (scene.Draws.size() < numDraws)
+            {
+                const uint32_t instanceIndex = static_cast<uint32_t>(scene.Instances.size());
+                scene.Instances.push_back(nri::StaticMeshInstance{ .MeshIndex = static_cast<uint32_t>(random() % numMeshes) });
+                for (uint32_t submeshIndex = 0; submeshIndex < scene.Meshes[scene.Instances.back().MeshIndex].Submeshes.size(); ++submeshIndex)
+                    scene.Draws.push_back(DrawScene::Draw{ .InstanceIndex = instanceIndex, .SubmeshIndex = submeshIndex });
+            }
+        }
+
+        // The way G-buffer draws were recorded before packets, walking instances, meshes, submeshes and materials of the scene
+        // and drawing every one of them on its own
+        void RecordSceneDraws(StubCommandList* commandList, const DrawScene& scene, std::span<const uint32_t> drawIndices, const nri::DrawRecordDesc& desc)
+        {
+            ID3D12PipelineState* currentPipelineState = nullptr;
+            for (UINT i = 0; i < drawIndices.size(); ++i)
+            {
+                const DrawScene::Draw& draw = scene.Draws[drawIndices[i]];
+                const nri::StaticMesh& staticMesh = scene.Meshes[scene.Instances[draw.InstanceIndex].MeshIndex];
+                const nri::StaticSubmesh& submesh = staticMesh.Submeshes[draw.SubmeshIndex];
+                const nri::Material& material = staticMesh.SubmeshMaterials[draw.SubmeshIndex];
+
+                ID3D12PipelineState* pipelineState = desc.Pipelines[submesh.VertexFormat];
+                if (pipelineState != currentPipelineState)
+                {
+                    commandList->SetPipelineState(pipelineState);
+                    currentPipelineState = pipelineState;
+                }
+
+                commandList->SetGraphicsRoot32BitConstant(desc.FirstInstanceRootIndex, i, 0);
+                commandList->SetGraphicsRootDescriptorTable(desc.MaterialTableRootIndex, material.SrvRange.GpuAddress);
+
+                commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+                commandList->IASetVertexBuffers(0, nri::eAttributeType_NumTypes, submesh.AttributeViews.data());
+                commandList->IASetIndexBuffer(&submesh.IBView);
+                commandList->DrawIndexedInstanced(submesh.NumIndices, 1, 0, 0, 0);
+            }
+        }
+
+        const nri::DrawRecordDesc StubRecordDesc = nri::DrawRecordDesc{
+            .Pipelines = { reinterpret_cast<ID3D12PipelineState*>(uintptr_t(0x1000)), reinterpret_cast<ID3D12PipelineState*>(uintptr_t(0x2000)) },
+            .FirstInstanceRootIndex = 0,
+            .MaterialTableRootIndex = 1,
+        };
+
+        // Draws are compacted into batches of the same state and recorded from packets, the reference draws the same instances
+        // one by one from scene objects. Returns stats of the packets
+        bool RecordAndCompare(const DrawScene& scene, const nri::DrawPacketCache& cache, std::span<const uint32_t> draws, uint32_t maxDrawsPerBatch, nri::DrawRecordStats& stats)
+        {
+            std::vector<uint64_t> stateKeys(draws.size());
+            for (size_t i = 0; i < draws.size(); ++i)
+                stateKeys[i] = cache.GetPacket(draws[i]).SortKey;
+
+            DrawBatcher batcher;
+            const DrawBatchStats batchStats = batcher.Build(stateKeys, maxDrawsPerBatch);
+            std::vector<uint32_t> compactedDraws(draws.size());
+            for (size_t i = 0; i < draws.size(); ++i)
+                compactedDraws[i] = draws[batcher.GetOrder()[i]];
+
+            StubCommandList sceneCommandList(StubRecordDesc.FirstInstanceRootIndex);
+            RecordSceneDraws(&sceneCommandList, scene, compactedDraws, StubRecordDesc);
+
+            StubCommandList packetCommandList(StubRecordDesc.FirstInstanceRootIndex);
+            stats = nri::RecordDrawPackets(&packetCommandList, cache, compactedDraws, batcher.GetBatches(), StubRecordDesc);
+
+            return sceneCommandList.GetHash() == packetCommandList.GetHash()
+                && packetCommandList.GetNumInstances() == draws.size()
+                && stats.NumDrawCalls == batchStats.NumBatches
+                && stats.NumInstances == draws.size();
+        }
+    } // anonymous namespace
+
+    // Fields of sort keys keep to their bits, depth buckets grow with distance and are clamped to the planes
+    NEB_TEST(DrawPacket, SortKeys)
+    {
+        using namespace nri;
+
+        NEB_EXPECT(MakeDrawSortKey(1, 0, 0) > MakeDrawSortKey(0, (1 << DrawSortKeyMaterialBits) - 1, (1 << DrawSortKeyGeometryBits) - 1, (1 << DrawSortKeyDepthBits) - 1));
+        NEB_EXPECT(MakeDrawSortKey(0, 1, 0) > MakeDrawSortKey(0, 0, (1 << DrawSortKeyGeometryBits) - 1, (1 << DrawSortKeyDepthBits) - 1));
+        NEB_EXPECT(MakeDrawSortKey(0, 0, 1) > MakeDrawSortKey(0, 0, 0, (1 << DrawSortKeyDepthBits) - 1));
+        NEB_EXPECT(MakeDrawSortKey(0, 0, 0, 1 << DrawSortKeyDepthBits) == 0, "depth bucket overflows into geometry");
+        NEB_EXPECT((MakeDrawSortKey(3, 0, 0) >> (64 - DrawSortKeyPipelineBits)) == 3);
+
+        static constexpr float NearZ = 0.1f;
+        static constexpr float FarZ = 100.0f;
+        NEB_EXPECT(MakeDrawDepthBucket(0.0f, NearZ, FarZ) == 0 && MakeDrawDepthBucket(NearZ, NearZ, FarZ) == 0);
+        NEB_EXPECT(MakeDrawDepthBucket(FarZ, NearZ, FarZ) == (1 << DrawSortKeyDepthBits) - 1 && MakeDrawDepthBucket(FarZ * 10.0f, NearZ, FarZ) == (1 << DrawSortKeyDepthBits) - 1);
+
+        uint32_t lastBucket = 0;
+        for (float distance = NearZ; distance < FarZ; distance *= 1.01f)
+        {
+            const uint32_t bucket = MakeDrawDepthBucket(distance, NearZ, FarZ);
+            NEB_EXPECT(bucket >= lastBucket, "bucket of {} is {}, less than {}", distance, bucket, lastBucket);
+            lastBucket = bucket;
+        }
+        return true;
+    }
+
+    // Packets are in the order of submeshes of instances, with their state, geometries are shared by instances of a mesh
+    NEB_TEST(DrawPacket, CacheMatchesScene)
+    {
+        std::mt19937_64 random(0xD4A);
+        DrawScene scene;
+        BuildDrawScene(scene, 10'000, random);
+
+        nri::DrawPacketCache cache;
+        cache.Build(scene.Meshes, scene.Instances);
+        NEB_EXPECT(cache.GetNumPackets() == scene.Draws.size(), "{} packets, expected {}", cache.GetNumPackets(), scene.Draws.size());
+        NEB_EXPECT(cache.GetNumMaterials() <= 256);
+
+        size_t numSubmeshes = 0;
+        for (const nri::StaticMesh& staticMesh : scene.Meshes)
+            numSubmeshes += staticMesh.Submeshes.size();
+        NEB_EXPECT(cache.GetNumGeometries() == numSubmeshes);
+
+        for (uint32_t i = 0; i < cache.GetNumPackets(); ++i)
+        {
+            const nri::DrawPacket& packet = cache.GetPacket(i);
+            const nri::StaticMesh& staticMesh = scene.Meshes[scene.Instances[scene.Draws[i].InstanceIndex].MeshIndex];
+            const nri::StaticSubmesh& submesh = staticMesh.Submeshes[scene.Draws[i].SubmeshIndex];
+            const nri::Material& material = staticMesh.SubmeshMaterials[scene.Draws[i].SubmeshIndex];
+            NEB_EXPECT(packet.TransformIndex == scene.Draws[i].InstanceIndex && packet.MaterialFlags == material.Flags && packet.MaterialTable.ptr == material.SrvRange.GpuAddress.ptr,
+                "state of packet {} differs from its submesh", i);
+            NEB_EXPECT(cache.GetGeometry(packet.GeometryIndex).NumIndices == submesh.NumIndices && (packet.SortKey >> (64 - nri::DrawSortKeyPipelineBits)) == uint64_t(submesh.VertexFormat),
+                "geometry of packet {} differs from its submesh", i);
+        }
+        return true;
+    }
+
+    // Every instance is drawn with the same state as from scene objects, in scene order and sorted, one by one and instanced
+    NEB_TEST(DrawPacket, RecordingMatchesSceneObjects)
+    {
+        std::mt19937_64 random(0xD4A);
+        DrawScene scene;
+        BuildDrawScene(scene, 20'000, random);
+
+        nri::DrawPacketCache cache;
+        cache.Build(scene.Meshes, scene.Instances);
+
+        // About half of the draws survive culling, in scene order
+        std::vector<uint32_t> visibleDraws;
+        for (uint32_t i = 0; i < scene.Draws.size(); ++i)
+        {
+            if (random() % 2 == 0)
+                visibleDraws.push_back(i);
+        }
+
+        std::vector<float> distances(visibleDraws.size());
+        for (float& distance : distances)
+            distance = std::uniform_real_distribution<float>(0.0f, 150.0f)(random);
+
+        ThreadPool threadPool(3);
+        std::vector<uint32_t> sortedDraws = visibleDraws;
+        nri::DrawPacketSorter sorter;
+        sorter.Sort(cache, sortedDraws, distances, 0.1f, 100.0f, threadPool);
+
+        for (uint32_t maxDrawsPerBatch : { 1u, UINT32_MAX })
+        {
+            nri::DrawRecordStats sceneOrderStats;
+            nri::DrawRecordStats sortedStats;
+            NEB_EXPECT(RecordAndCompare(scene, cache, visibleDraws, maxDrawsPerBatch, sceneOrderStats), "draws in scene order ({} per batch) differ", maxDrawsPerBatch);
+            NEB_EXPECT(RecordAndCompare(scene, cache, sortedDraws, maxDrawsPerBatch, sortedStats), "sorted draws ({} per batch) differ", maxDrawsPerBatch);
+
+            // Batches are the same for any order of draws, sorted ones only bind each state once
+            NEB_EXPECT(sortedStats.NumDrawCalls == sceneOrderStats.NumDrawCalls);
+            NEB_EXPECT(sortedStats.NumMaterialChanges < sceneOrderStats.NumMaterialChanges, "{} per batch: {} material changes sorted, {} in scene order",
+                maxDrawsPerBatch, sortedStats.NumMaterialChanges, sceneOrderStats.NumMaterialChanges);
+            NEB_EXPECT(sortedStats.NumPipelineChanges <= nri::eVertexFormat_NumFormats);
+        }
+
+        nri::DrawRecordStats emptyStats;
+        NEB_EXPECT(RecordAndCompare(scene, cache, {}, 1, emptyStats) && emptyStats.NumDrawCalls == 0);
+        return true;
+    }
+
+    // Sorted packets are a permutation of the visible ones, ordered by their keys completed with depth buckets
+    NEB_TEST(DrawPacket, SorterOrdersByKeys)
+    {
+        static constexpr float NearZ = 0.1f;
+        static constexpr float FarZ = 100.0f;
+
+        std::mt19937_64 random(0xD4A);
+        DrawScene scene;
+        BuildDrawScene(scene, 50'000, random);
+
+        nri::DrawPacketCache cache;
+        cache.Build(scene.Meshes, scene.Instances);
+
+        std::vector<uint32_t> packetIndices;
+        std::vector<float> packetDistances(cache.GetNumPackets());
+        for (uint32_t i = 0; i < cache.GetNumPackets(); ++i)
+        {
+            if (random() % 3 != 0)
+            {
+                packetDistances[i] = std::uniform_real_distribution<float>(0.0f, FarZ * 1.5f)(random);
+                packetIndices.push_back(i);
+            }
+        }
+
+        std::vector<float> distances(packetIndices.size());
+        for (size_t i = 0; i < packetIndices.size(); ++i)
+            distances[i] = packetDistances[packetIndices[i]];
+
+        ThreadPool threadPool(3);
+        std::vector<uint32_t> sorted = packetIndices;
+        nri::DrawPacketSorter sorter;
+        sorter.Sort(cache, sorted, distances, NearZ, FarZ, threadPool);
+
+        auto getSortKey = [&](uint32_t packetIndex) { return cache.GetPacket(packetIndex).SortKey | nri::MakeDrawDepthBucket(packetDistances[packetIndex], NearZ, FarZ); };
+        for (size_t i = 1; i < sorted.size(); ++i)
+            NEB_EXPECT(getSortKey(sorted[i - 1]) <= getSortKey(sorted[i]), "packets {} and {} are out of order", i - 1, i);
+
+        std::ranges::sort(sorted);
+        NEB_EXPECT(sorted == packetIndices, "sorted packets are not a permutation of visible ones");
+        return true;
+    }
+
+} // Neb::test namespace
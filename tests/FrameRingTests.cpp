@@ -0,0 +1,163 @@
+#include "Test.h"
+
+#include "core/FrameRing.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Ring invariants on a long randomized sequence of frames, that complete with a random latency. Ranges of live
+        // allocations should never overlap, allocations should only fail when the ring is really full
+        bool CheckFrameRing(uint64_t capacity, uint32_t numFrames, uint64_t seed)
+        {
+            struct LiveRange
+            {
+                uint64_t Begin;
+                uint64_t End;
+                uint64_t FenceValue;
+            };
+
+            FrameRing ring(capacity);
+            std::deque<LiveRange> liveRanges;
+            std::mt19937_64 random(seed);
+
+            // Fence value of the open frame, frames are closed with it
+            uint64_t fenceValue = 1;
+            uint64_t completedFenceValue = 0;
+            auto release = [&](uint64_t value)
+                {
+                    completedFenceValue = value;
+                    ring.Release(completedFenceValue);
+                    while (!liveRanges.empty() && liveRanges.front().FenceValue <= completedFenceValue)
+                        liveRanges.pop_front();
+                };
+
+            for (uint32_t frame = 0; frame < numFrames; ++frame)
+            {
+                const uint32_t numAllocations = static_cast<uint32_t>(random() % 48);
+                for (uint32_t i = 0; i < numAllocations; ++i)
+                {
+                    const uint64_t alignment = uint64_t(1) << (random() % 9);
+                    const uint64_t numBytes = 1 + random() % std::max<uint64_t>(capacity / 16, 1);
+
+                    const uint64_t waitFenceValue = ring.GetFenceValueToAllocate(numBytes, alignment);
+                    if (waitFenceValue == UINT64_MAX)
+                    {
+                        // Open frame is too large already, allocations of it can never be released before it is closed
+                        NEB_EXPECT(ring.Allocate(numBytes, alignment) == FrameRing::InvalidOffset, "allocation of {} bytes in frame {} fits", numBytes, frame);
+                        continue;
+                    }
+
+                    if (waitFenceValue > 0)
+                    {
+                        // Should really be full until then, and only closed frames can be waited for
+                        NEB_EXPECT(waitFenceValue < fenceValue, "allocation in frame {} waits for {}, open frame is {}", frame, waitFenceValue, fenceValue);
+                        NEB_EXPECT(ring.Allocate(numBytes, alignment) == FrameRing::InvalidOffset, "allocation of {} bytes in frame {} fits without waiting", numBytes, frame);
+                        release(waitFenceValue);
+                    }
+
+                    const uint64_t offset = ring.Allocate(numBytes, alignment);
+                    NEB_EXPECT(offset != FrameRing::InvalidOffset && offset % alignment == 0 && offset + numBytes <= capacity,
+                        "allocation of {} bytes aligned to {} in frame {} is at {}", numBytes, alignment, frame, offset);
+
+                    for (const LiveRange& range : liveRanges)
+                        NEB_EXPECT(offset >= range.End || range.Begin >= offset + numBytes, "allocation in frame {} overlaps [{}, {})", frame, range.Begin, range.End);
+                    liveRanges.push_back(LiveRange{ .Begin = offset, .End = offset + numBytes, .FenceValue = fenceValue });
+                }
+
+                ring.EndFrame(fenceValue++);
+
+                // GPU completes frames with a random latency, but never lags more than 3 frames behind (as the swapchain would block)
+                const uint64_t lastClosedFenceValue = fenceValue - 1;
+                if (lastClosedFenceValue - completedFenceValue > 3 || random() % 2 == 0)
+                {
+                    const uint64_t latency = std::min<uint64_t>(random() % 4, lastClosedFenceValue);
+                    release(std::max(lastClosedFenceValue - latency, completedFenceValue));
+                }
+
+                NEB_EXPECT(ring.GetNumFramesInFlight() == lastClosedFenceValue - completedFenceValue && ring.GetNumOpenFrameBytes() == 0,
+                    "{} frames in flight after frame {}, {} bytes of the open frame", ring.GetNumFramesInFlight(), frame, ring.GetNumOpenFrameBytes());
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    // Allocation that does not fit before the end of the ring skips its tail, and fits once the frame in front of it is released
+    NEB_TEST(FrameRing, SkipsTail)
+    {
+        FrameRing ring(1024);
+        NEB_EXPECT(ring.Allocate(600, 1) == 0);
+        ring.EndFrame(1);
+        NEB_EXPECT(ring.Allocate(200, 256) == 768);
+
+        NEB_EXPECT(ring.Allocate(100, 1) == FrameRing::InvalidOffset);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(100, 1) == 1);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(800, 1) == UINT64_MAX, "open frame keeps 800 bytes from ever fitting");
+
+        ring.EndFrame(2);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(800, 1) == 2);
+
+        ring.Release(1);
+        NEB_EXPECT(ring.GetNumFramesInFlight() == 1);
+        NEB_EXPECT(ring.Allocate(100, 1) == 0);
+        NEB_EXPECT(ring.GetNumUsedBytes() == 524 && ring.GetNumOpenFrameBytes() == 156, "{} used bytes, {} bytes of the open frame", ring.GetNumUsedBytes(), ring.GetNumOpenFrameBytes());
+        return true;
+    }
+
+    // Frames are released in order of their fence values, empty frames included. Empty ring starts over
+    NEB_TEST(FrameRing, ReleasedByFenceValue)
+    {
+        FrameRing ring(1024);
+        NEB_EXPECT(ring.Allocate(256, 256) == 0);
+        ring.EndFrame(1);
+        ring.EndFrame(2);
+        NEB_EXPECT(ring.Allocate(256, 256) == 256);
+        ring.EndFrame(3);
+        NEB_EXPECT(ring.GetNumFramesInFlight() == 3 && ring.GetNumUsedBytes() == 512);
+
+        ring.Release(0);
+        NEB_EXPECT(ring.GetNumFramesInFlight() == 3);
+        ring.Release(2);
+        NEB_EXPECT(ring.GetNumFramesInFlight() == 1 && ring.GetNumUsedBytes() == 256);
+
+        ring.Release(3);
+        NEB_EXPECT(ring.GetNumFramesInFlight() == 0 && ring.GetNumUsedBytes() == 0);
+        NEB_EXPECT(ring.Allocate(1024, 512) == 0, "empty ring should start over");
+        return true;
+    }
+
+    // Allocation of the whole capacity behind an empty open frame waits for the last closed frame, after which the ring starts over
+    NEB_TEST(FrameRing, WholeCapacity)
+    {
+        FrameRing ring(1024);
+        NEB_EXPECT(ring.Allocate(0, 1) == FrameRing::InvalidOffset);
+        NEB_EXPECT(ring.Allocate(2048, 1) == FrameRing::InvalidOffset);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(2048, 1) == UINT64_MAX);
+
+        NEB_EXPECT(ring.Allocate(1000, 1) == 0);
+        ring.EndFrame(1);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(1024, 1) == 1);
+
+        ring.Release(1);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(1024, 1) == 0);
+        NEB_EXPECT(ring.Allocate(1024, 1) == 0);
+        return true;
+    }
+
+    // Live allocations never overlap on long randomized sequences of frames, allocations only fail when the ring is really full
+    NEB_TEST(FrameRing, Invariants)
+    {
+        for (uint64_t seed = 0; seed < 8; ++seed)
+        {
+            NEB_EXPECT(CheckFrameRing(64 * 1024, 1 << 14, seed), "ring of 64 KB failed with seed {}", seed);
+            NEB_EXPECT(CheckFrameRing(4 * 1024, 1 << 12, seed), "ring of 4 KB failed with seed {}", seed);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,118 @@
+#include "Test.h"
+
+#include "core/Bounds.h"
+#include "core/FrustumCulling.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Same camera setup as in DeferredRenderer, looking down -Z
+        Frustum GetCameraFrustum()
+        {
+            const Mat4 viewProj = Mat4::CreateLookAt(Vec3(0.0f), Vec3(0.0f, 0.0f, -1.0f), Vec3::UnitY) *
+                Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+            return ExtractFrustum(viewProj);
+        }
+
+        AABB GenerateBox(std::mt19937_64& random)
+        {
+            std::uniform_real_distribution<float> positionDistribution(-150.0f, 150.0f);
+            std::uniform_real_distribution<float> extentDistribution(0.1f, 5.0f);
+
+            const Vec3 center = Vec3(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+            const Vec3 extent = Vec3(extentDistribution(random), extentDistribution(random), extentDistribution(random));
+            return AABB{ .min = center - extent, .max = center + extent };
+        }
+    } // anonymous namespace
+
+    NEB_TEST(FrustumCulling, KnownBoxes)
+    {
+        struct KnownBox
+        {
+            AABB Box;
+            bool IsVisible;
+            const char* Name;
+        };
+        const KnownBox knownBoxes[] = {
+            { AABB{ .min = Vec3(-1.0f, -1.0f, -11.0f), .max = Vec3(1.0f, 1.0f, -9.0f) }, true, "in front" },
+            { AABB{ .min = Vec3(-1.0f, -1.0f, 9.0f), .max = Vec3(1.0f, 1.0f, 11.0f) }, false, "behind" },
+            { AABB{ .min = Vec3(-1.0f, -1.0f, -0.5f), .max = Vec3(1.0f, 1.0f, 0.5f) }, true, "crossing near plane" },
+            { AABB{ .min = Vec3(-1.0f, -1.0f, -201.0f), .max = Vec3(1.0f, 1.0f, -199.0f) }, false, "beyond far plane" },
+            { AABB{ .min = Vec3(-1.0f, -1.0f, -101.0f), .max = Vec3(1.0f, 1.0f, -99.0f) }, true, "crossing far plane" },
+            { AABB{ .min = Vec3(-101.0f, -1.0f, -11.0f), .max = Vec3(-99.0f, 1.0f, -9.0f) }, false, "left" },
+            { AABB{ .min = Vec3(-1.0f, 99.0f, -11.0f), .max = Vec3(1.0f, 101.0f, -9.0f) }, false, "above" },
+            { AABB{ .min = Vec3(-1000.0f, -1.0f, -11.0f), .max = Vec3(1000.0f, 1.0f, -9.0f) }, true, "wider than frustum" },
+            { AABB(), false, "empty" },
+        };
+
+        const Frustum frustum = GetCameraFrustum();
+        for (const KnownBox& known : knownBoxes)
+            NEB_EXPECT(IsAABBInFrustum(frustum, known.Box) == known.IsVisible, "box {} is expected to be {}", known.Name, known.IsVisible ? "visible" : "culled");
+        return true;
+    }
+
+    // Serial and parallel culls match the scalar reference draw by draw, the amount of draws is not a multiple of SIMD width on purpose
+    NEB_TEST(FrustumCulling, MatchesScalarReference)
+    {
+        static constexpr uint32_t NumDraws = 100'003;
+
+        const Frustum frustum = GetCameraFrustum();
+        std::mt19937_64 random(0xF5C);
+
+        FrustumCuller culler;
+        culler.Resize(NumDraws);
+
+        std::vector<uint32_t> reference;
+        for (uint32_t i = 0; i < NumDraws; ++i)
+        {
+            const AABB box = (i % 97 == 0) ? AABB() : GenerateBox(random);
+            culler.SetBox(i, box);
+            if (IsAABBInFrustum(frustum, box))
+                reference.push_back(i);
+        }
+        NEB_EXPECT(!reference.empty() && reference.size() < NumDraws);
+
+        ThreadPool threadPool(3);
+        for (uint32_t minDrawsPerTask : { UINT32_MAX, 1000u, 1u })
+        {
+            const CullingStats stats = culler.Cull(frustum, threadPool, minDrawsPerTask);
+            const std::span<const uint32_t> visibleDraws = culler.GetVisibleDraws();
+            NEB_EXPECT(stats.NumVisible == reference.size() && stats.NumVisible + stats.NumCulled == NumDraws,
+                "{} draws per task: {} visible, expected {}", minDrawsPerTask, stats.NumVisible, reference.size());
+            NEB_EXPECT(std::equal(visibleDraws.begin(), visibleDraws.end(), reference.begin(), reference.end()), "visible draws of {} draws per task differ", minDrawsPerTask);
+        }
+        return true;
+    }
+
+    // Boxes round-trip through SoA, new draws stay culled until their boxes are set
+    NEB_TEST(FrustumCulling, Resize)
+    {
+        const Frustum frustum = GetCameraFrustum();
+        const AABB visibleBox = { .min = Vec3(-1.0f, -1.0f, -11.0f), .max = Vec3(1.0f, 1.0f, -9.0f) };
+
+        FrustumCuller culler;
+        culler.Resize(3);
+        culler.SetBox(1, visibleBox);
+        const AABB box = culler.GetBox(1);
+        NEB_EXPECT(box.min == visibleBox.min && box.max == visibleBox.max);
+
+        ThreadPool threadPool(1);
+        NEB_EXPECT(culler.Cull(frustum, threadPool).NumVisible == 1 && culler.GetVisibleDraws()[0] == 1);
+
+        culler.Resize(21);
+        NEB_EXPECT(culler.GetNumDraws() == 21 && IsEmptyAABB(culler.GetBox(20)));
+        NEB_EXPECT(culler.Cull(frustum, threadPool).NumVisible == 1);
+
+        culler.Resize(0);
+        NEB_EXPECT(culler.Cull(frustum, threadPool).NumVisible == 0 && culler.GetVisibleDraws().empty());
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,127 @@
+#include "Test.h"
+#include "TestIndirectDraws.h"
+
+#include "nri/Device.h"
+#include "nri/FrameUploadAllocator.h"
+#include "nri/IndirectDrawCuller.h"
+#include "util/ThreadPool.h"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        nri::Rc<ID3D12Resource> CreateReadbackBuffer(UINT64 numBytes)
+        {
+            D3D12MA::ALLOCATION_DESC allocDesc = {
+                .Flags = D3D12MA::ALLOCATION_FLAG_COMMITTED,
+                .HeapType = D3D12_HEAP_TYPE_READBACK,
+            };
+            const D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(numBytes);
+
+            nri::Rc<D3D12MA::Allocation> allocation;
+            nri::Rc<ID3D12Resource> buffer;
+            nri::ThrowIfFailed(nri::NRIDevice::Get().GetResourceAllocator()->CreateResource(&allocDesc, &desc, D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                allocation.GetAddressOf(),
+                IID_PPV_ARGS(buffer.ReleaseAndGetAddressOf())));
+            return buffer;
+        }
+
+        void WaitForFence(ID3D12Fence* fence, UINT64 fenceValue)
+        {
+            if (fence->GetCompletedValue() >= fenceValue)
+                return;
+
+            HANDLE fenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+            nri::ThrowIfFailed(fence->SetEventOnCompletion(fenceValue, fenceEvent));
+            WaitForSingleObject(fenceEvent, INFINITE);
+            CloseHandle(fenceEvent);
+        }
+    } // anonymous namespace
+
+    // Argument streams and counts of gbuffer_cull.hlsl are read back and compared bit by bit against IndirectDrawList::CullAndCompact.
+    // Sizes cover partial groups and more groups than CSScanGroups scans at once
+    NEB_TEST(IndirectDrawGpu, MatchesCpu)
+    {
+        nri::NRIDevice& device = nri::NRIDevice::Get();
+        ID3D12CommandQueue* queue = device.GetCommandQueue(nri::eCommandContextType_Graphics);
+        nri::CommandAllocatorPool& allocatorPool = device.GetCommandAllocatorPool(nri::eCommandContextType_Graphics);
+
+        nri::Rc<ID3D12GraphicsCommandList> commandList;
+        nri::ThrowIfFailed(device.GetD3D12Device()->CreateCommandList1(0, D3D12_COMMAND_LIST_TYPE_DIRECT, D3D12_COMMAND_LIST_FLAG_NONE,
+            IID_PPV_ARGS(commandList.ReleaseAndGetAddressOf())));
+        nri::Rc<ID3D12Fence> fence;
+        UINT64 fenceValue = 0;
+        nri::ThrowIfFailed(device.GetD3D12Device()->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence.ReleaseAndGetAddressOf())));
+
+        nri::FrameUploadAllocator uploadAllocator;
+        uploadAllocator.Init();
+        nri::IndirectDrawCuller culler;
+        culler.Init(NEB_TEST_SHADER_DIR);
+
+        const Frustum frustum = GetIndirectDrawFrustum();
+        static constexpr uint32_t GroupSize = nri::IndirectDrawCuller::NumRecordsPerGroup;
+        const auto sizes = std::to_array<uint32_t>({ 1, GroupSize - 1, GroupSize + 1, GroupSize * GroupSize + 3 * GroupSize + 17, 200'000 });
+        for (uint32_t size : sizes)
+        {
+            const IndirectDrawScene scene(size, size);
+            nri::IndirectDrawList drawList;
+            drawList.Build(scene.Records, scene.Geometries);
+
+            std::vector<nri::IndirectDrawArguments> reference(size_t(size) * nri::NumIndirectDrawStreams);
+            const nri::IndirectDrawCounts referenceCounts = drawList.CullAndCompact(frustum, reference, ThreadPool::Get());
+
+            culler.Resize(drawList);
+            const UINT64 numArgumentBytes = reference.size() * sizeof(nri::IndirectDrawArguments);
+            nri::Rc<ID3D12Resource> readback = CreateReadbackBuffer(numArgumentBytes + sizeof(nri::IndirectDrawCounts));
+
+            nri::D3D12Rc<ID3D12CommandAllocator> allocator = allocatorPool.QueryAllocator();
+            nri::ThrowIfFailed(commandList->Reset(allocator.Get(), nullptr));
+            uploadAllocator.BeginFrame();
+
+            culler.UploadRecords(commandList.Get(), drawList, uploadAllocator);
+            culler.CullAndCompact(commandList.Get(), frustum, uploadAllocator);
+
+            std::array barriers = {
+                CD3DX12_RESOURCE_BARRIER::Transition(culler.GetArgumentBuffer(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_SOURCE),
+                CD3DX12_RESOURCE_BARRIER::Transition(culler.GetCountBuffer(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_SOURCE),
+            };
+            commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+            commandList->CopyBufferRegion(readback.Get(), 0, culler.GetArgumentBuffer(), 0, numArgumentBytes);
+            commandList->CopyBufferRegion(readback.Get(), numArgumentBytes, culler.GetCountBuffer(), 0, sizeof(nri::IndirectDrawCounts));
+            nri::ThrowIfFailed(commandList->Close());
+
+            ID3D12CommandList* commandLists[] = { commandList.Get() };
+            queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+            uploadAllocator.EndFrame(queue);
+            nri::ThrowIfFailed(queue->Signal(fence.Get(), ++fenceValue));
+            allocatorPool.DiscardAllocator(allocator, fence.Get(), fenceValue);
+            WaitForFence(fence.Get(), fenceValue);
+
+            void* mapping = nullptr;
+            nri::ThrowIfFailed(readback->Map(0, nullptr, &mapping));
+            const std::byte* bytes = static_cast<const std::byte*>(mapping);
+
+            nri::IndirectDrawCounts counts = {};
+            std::memcpy(counts.data(), bytes + numArgumentBytes, sizeof(nri::IndirectDrawCounts));
+            bool areStreamsEqual = counts == referenceCounts;
+            for (uint32_t stream = 0; stream < nri::NumIndirectDrawStreams && areStreamsEqual; ++stream)
+            {
+                // Only the first counts[s] commands of each stream are written
+                const size_t first = size_t(stream) * size;
+                areStreamsEqual = std::memcmp(bytes + first * sizeof(nri::IndirectDrawArguments), &reference[first], counts[stream] * sizeof(nri::IndirectDrawArguments)) == 0;
+            }
+            readback->Unmap(0, nullptr);
+
+            NEB_EXPECT(counts == referenceCounts, "{} records: GPU finds {} and {} visible, CPU {} and {}", size, counts[0], counts[1], referenceCounts[0], referenceCounts[1]);
+            NEB_EXPECT(areStreamsEqual, "streams of {} records differ", size);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,117 @@
+#include "Test.h"
+#include "TestIndirectDraws.h"
+
+#include "util/ThreadPool.h"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        AABB GetRecordBox(const nri::IndirectDrawRecord& record)
+        {
+            return AABB{ .min = record.BoxMin, .max = record.BoxMax };
+        }
+
+        uint32_t GetNumVisible(const nri::IndirectDrawCounts& counts)
+        {
+            uint32_t numVisible = 0;
+            for (uint32_t count : counts)
+                numVisible += count;
+            return numVisible;
+        }
+    } // anonymous namespace
+
+    // Streams compacted by ranges of records (on the calling thread and on the pool) are the same bit by bit as ones
+    // a serial reference appends visible records to one by one. Sizes cover empty lists and partial ranges
+    NEB_TEST(IndirectDraw, MatchesSerialReference)
+    {
+        const Frustum frustum = GetIndirectDrawFrustum();
+        ThreadPool serialPool(0);
+        ThreadPool threadPool(3);
+
+        const auto sizes = std::to_array<uint32_t>({ 0, 1, 2, nri::IndirectDrawList::MinRecordsPerTask - 1, nri::IndirectDrawList::MinRecordsPerTask * 3 + 7, 100'000 });
+        for (uint32_t size : sizes)
+        {
+            const IndirectDrawScene scene(size, size);
+            nri::IndirectDrawList drawList;
+            drawList.Build(scene.Records, scene.Geometries);
+
+            std::vector<nri::IndirectDrawArguments> reference(size_t(size) * nri::NumIndirectDrawStreams);
+            nri::IndirectDrawCounts referenceCounts = {};
+            for (const nri::IndirectDrawRecord& record : scene.Records)
+            {
+                if (IsAABBInFrustum(frustum, GetRecordBox(record)))
+                    reference[record.StreamIndex * size + referenceCounts[record.StreamIndex]++] = nri::MakeIndirectDrawArguments(record, scene.Geometries[record.GeometryIndex]);
+            }
+
+            for (ThreadPool* pool : { &serialPool, &threadPool })
+            {
+                std::vector<nri::IndirectDrawArguments> arguments(reference.size());
+                const nri::IndirectDrawCounts counts = drawList.CullAndCompact(frustum, arguments, *pool);
+                NEB_EXPECT(counts == referenceCounts, "{} records on {} threads: {} visible, expected {}", size, pool->GetNumThreads(), GetNumVisible(counts), GetNumVisible(referenceCounts));
+                NEB_EXPECT(std::memcmp(arguments.data(), reference.data(), reference.size() * sizeof(nri::IndirectDrawArguments)) == 0,
+                    "streams of {} records on {} threads differ", size, pool->GetNumThreads());
+            }
+        }
+        return true;
+    }
+
+    // Visible records are the same ones FrustumCuller finds
+    NEB_TEST(IndirectDraw, MatchesFrustumCuller)
+    {
+        static constexpr uint32_t NumRecords = 50'000;
+        const Frustum frustum = GetIndirectDrawFrustum();
+        const IndirectDrawScene scene(NumRecords, 0x1D1);
+        ThreadPool threadPool(3);
+
+        nri::IndirectDrawList drawList;
+        drawList.Build(scene.Records, scene.Geometries);
+        FrustumCuller culler;
+        culler.Resize(NumRecords);
+        for (uint32_t i = 0; i < NumRecords; ++i)
+            culler.SetBox(i, GetRecordBox(scene.Records[i]));
+
+        std::vector<nri::IndirectDrawArguments> arguments(size_t(NumRecords) * nri::NumIndirectDrawStreams);
+        const uint32_t numVisible = GetNumVisible(drawList.CullAndCompact(frustum, arguments, threadPool));
+        const CullingStats stats = culler.Cull(frustum, threadPool);
+        NEB_EXPECT(numVisible == stats.NumVisible, "{} records are visible, FrustumCuller finds {}", numVisible, stats.NumVisible);
+        NEB_EXPECT(numVisible > 0 && numVisible < NumRecords);
+        return true;
+    }
+
+    // Records are of empty boxes until SetBox, those are never visible. Arguments of a visible record are the ones of MakeIndirectDrawArguments
+    NEB_TEST(IndirectDraw, EmptyBoxesAreCulled)
+    {
+        const Frustum frustum = GetIndirectDrawFrustum();
+        const IndirectDrawScene scene(3, 7);
+        std::vector<nri::IndirectDrawRecord> records = scene.Records;
+        for (nri::IndirectDrawRecord& record : records)
+        {
+            record.BoxMin = AABB().min;
+            record.BoxMax = AABB().max;
+        }
+
+        ThreadPool serialPool(0);
+        nri::IndirectDrawList drawList;
+        drawList.Build(records, scene.Geometries);
+        std::vector<nri::IndirectDrawArguments> arguments(records.size() * nri::NumIndirectDrawStreams);
+        NEB_EXPECT(GetNumVisible(drawList.CullAndCompact(frustum, arguments, serialPool)) == 0);
+
+        // Right in front of the camera
+        drawList.SetBox(1, AABB{ .min = Vec3(-1.0f, -1.0f, -11.0f), .max = Vec3(1.0f, 1.0f, -9.0f) });
+        const nri::IndirectDrawCounts counts = drawList.CullAndCompact(frustum, arguments, serialPool);
+        const uint32_t stream = records[1].StreamIndex;
+        NEB_EXPECT(counts[stream] == 1 && GetNumVisible(counts) == 1);
+
+        const nri::IndirectDrawArguments expected = nri::MakeIndirectDrawArguments(drawList.GetRecords()[1], scene.Geometries[records[1].GeometryIndex]);
+        NEB_EXPECT(std::memcmp(&arguments[stream * records.size()], &expected, sizeof(nri::IndirectDrawArguments)) == 0);
+        NEB_EXPECT(expected.InstanceIndex == 1 && expected.Draw.IndexCountPerInstance == records[1].NumIndices && expected.Draw.InstanceCount == 1);
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,148 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include "core/MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Triangles rotated so that their smallest index is the first one (winding is kept), then sorted
+        std::vector<std::array<uint32_t, 3>> GetSortedTriangles(std::span<const uint32_t> indices)
+        {
+            std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+            for (size_t t = 0; t < triangles.size(); ++t)
+            {
+                std::array<uint32_t, 3> triangle = { indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2] };
+                std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+                triangles[t] = triangle;
+            }
+            std::ranges::sort(triangles);
+            return triangles;
+        }
+
+        std::vector<uint32_t> ShuffleTriangles(std::span<const uint32_t> indices, uint64_t seed)
+        {
+            std::vector<uint32_t> order(indices.size() / 3);
+            for (uint32_t t = 0; t < order.size(); ++t)
+                order[t] = t;
+
+            std::mt19937_64 random(seed);
+            std::ranges::shuffle(order, random);
+
+            std::vector<uint32_t> shuffled;
+            shuffled.reserve(indices.size());
+            for (uint32_t t : order)
+                shuffled.insert(shuffled.end(), { indices[t * 3 + 0], indices[t * 3 + 1], indices[t * 3 + 2] });
+            return shuffled;
+        }
+    } // anonymous namespace
+
+    // Misses of a FIFO counted by hand. Vertex 7 is never referenced
+    NEB_TEST(MeshOptimizer, SimulatedCacheMisses)
+    {
+        static constexpr auto Indices = std::to_array<uint32_t>({ 0, 1, 2, 2, 1, 3, 4, 5, 6, 0, 1, 2 });
+
+        // 0 1 2 miss, 2 1 hit, 3 miss (evicts 0), 4 5 6 miss, 0 1 2 miss again
+        const VertexCacheStatistics small = SimulateVertexCache(Indices, 8, /*cacheSize*/ 3);
+        NEB_EXPECT(small.NumTransformedVertices == 10 && small.NumTriangles == 4 && small.NumReferencedVertices == 7,
+            "{} transformed, {} triangles, {} referenced", small.NumTransformedVertices, small.NumTriangles, small.NumReferencedVertices);
+        NEB_EXPECT(small.ACMR == 2.5f && small.ATVR == 10.0f / 7.0f, "ACMR {}, ATVR {}", small.ACMR, small.ATVR);
+
+        // Every vertex stays in the cache once it is transformed
+        const VertexCacheStatistics large = SimulateVertexCache(Indices, 8);
+        NEB_EXPECT(large.NumTransformedVertices == 7 && large.ATVR == 1.0f, "{} transformed", large.NumTransformedVertices);
+
+        const VertexCacheStatistics empty = SimulateVertexCache({}, 8);
+        NEB_EXPECT(empty.NumTransformedVertices == 0 && empty.NumTriangles == 0 && empty.ACMR == 0.0f);
+        return true;
+    }
+
+    // Optimized order has exactly the source triangles with their winding. It is no worse than the row order of a grid
+    // and brings a shuffled grid back close to it
+    NEB_TEST(MeshOptimizer, VertexCacheOrder)
+    {
+        const GridMesh grid(64, 0.5f);
+        const std::vector<uint32_t> shuffled = ShuffleTriangles(grid.Indices, 0x0C4);
+
+        std::vector<uint32_t> optimizedGrid(grid.Indices.size());
+        OptimizeVertexCache(optimizedGrid, grid.Indices, grid.NumVertices);
+        std::vector<uint32_t> optimizedShuffled(shuffled.size());
+        OptimizeVertexCache(optimizedShuffled, shuffled, grid.NumVertices);
+
+        const auto sourceTriangles = GetSortedTriangles(grid.Indices);
+        NEB_EXPECT(GetSortedTriangles(optimizedGrid) == sourceTriangles);
+        NEB_EXPECT(GetSortedTriangles(optimizedShuffled) == sourceTriangles);
+
+        const float gridACMR = SimulateVertexCache(grid.Indices, grid.NumVertices).ACMR;
+        const float shuffledACMR = SimulateVertexCache(shuffled, grid.NumVertices).ACMR;
+        const float optimizedGridACMR = SimulateVertexCache(optimizedGrid, grid.NumVertices).ACMR;
+        const float optimizedShuffledACMR = SimulateVertexCache(optimizedShuffled, grid.NumVertices).ACMR;
+        NEB_EXPECT(optimizedGridACMR <= gridACMR, "ACMR of the grid {:.3f} -> {:.3f}", gridACMR, optimizedGridACMR);
+        NEB_EXPECT(optimizedShuffledACMR <= 1.1f * gridACMR, "ACMR of the shuffled grid {:.3f} -> {:.3f}, grid is {:.3f}", shuffledACMR, optimizedShuffledACMR, gridACMR);
+
+        std::vector<uint32_t> single(3);
+        OptimizeVertexCache(single, std::to_array<uint32_t>({ 2, 0, 1 }), 3);
+        NEB_EXPECT(single == std::vector<uint32_t>({ 2, 0, 1 }));
+        return true;
+    }
+
+    // Vertices are ordered by their first use, unreferenced ones are dropped
+    NEB_TEST(MeshOptimizer, FetchRemapDropsUnreferenced)
+    {
+        static constexpr auto Indices = std::to_array<uint32_t>({ 5, 2, 7, 7, 2, 0 });
+
+        std::array<uint32_t, 8> remap;
+        NEB_EXPECT(OptimizeVertexFetchRemap(remap, Indices) == 4);
+
+        static constexpr uint32_t X = InvalidVertexIndex;
+        NEB_EXPECT(remap == std::to_array<uint32_t>({ 3, X, 1, X, X, 0, X, 2 }));
+
+        std::vector<uint32_t> indices(Indices.begin(), Indices.end());
+        RemapIndices(indices, remap);
+        NEB_EXPECT(indices == std::vector<uint32_t>({ 0, 1, 2, 2, 1, 3 }));
+        return true;
+    }
+
+    // Remapped indices fetch the same positions from the remapped stream as source indices from the strided source stream
+    NEB_TEST(MeshOptimizer, RemapRoundTrip)
+    {
+        static constexpr uint32_t PositionSize = sizeof(float) * 3;
+
+        // Triangles of the first row of quads are dropped, so that vertices of the first row are unreferenced
+        const GridMesh grid(16, 1.0f);
+        const std::vector<uint32_t> shuffled = ShuffleTriangles(std::span<const uint32_t>(grid.Indices).subspan(15 * 6), 0x0C5);
+        std::vector<uint32_t> indices(shuffled.size());
+        OptimizeVertexCache(indices, shuffled, grid.NumVertices);
+
+        std::vector<uint32_t> remap(grid.NumVertices);
+        const uint32_t numVertices = OptimizeVertexFetchRemap(remap, indices);
+        NEB_EXPECT(numVertices == grid.NumVertices - 16, "{} of {} vertices are left", numVertices, grid.NumVertices);
+
+        std::vector<uint32_t> remappedIndices = indices;
+        RemapIndices(remappedIndices, remap);
+        std::vector<std::byte> positions(size_t(numVertices) * PositionSize);
+        RemapVertexStream(positions.data(), grid.GetPositions(), GridMesh::VertexStride, PositionSize, remap);
+
+        uint32_t numSeenVertices = 0;
+        for (size_t k = 0; k < indices.size(); ++k)
+        {
+            NEB_EXPECT(remappedIndices[k] <= numSeenVertices, "vertex {} is not in the order of first use", remappedIndices[k]);
+            numSeenVertices = std::max(numSeenVertices, remappedIndices[k] + 1);
+
+            const std::byte* remapped = positions.data() + size_t(remappedIndices[k]) * PositionSize;
+            const std::byte* source = grid.GetPositions() + size_t(indices[k]) * GridMesh::VertexStride;
+            NEB_EXPECT(std::memcmp(remapped, source, PositionSize) == 0, "position of index {} differs", k);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
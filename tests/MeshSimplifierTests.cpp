@@ -0,0 +1,228 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include "core/MeshSimplifier.h"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        MeshSimplifierSourceDesc GetSimplifierSource(const GridMesh& grid, bool use16BitIndices)
+        {
+            return MeshSimplifierSourceDesc{
+                .NumVertices = grid.NumVertices,
+                .Positions = grid.GetPositions(),
+                .PositionsStride = GridMesh::VertexStride,
+                .Normals = grid.GetNormals(),
+                .NormalsStride = GridMesh::VertexStride,
+                .TexCoords = grid.GetTexCoords(),
+                .TexCoordsStride = GridMesh::VertexStride,
+                .NumIndices = static_cast<uint32_t>(grid.Indices.size()),
+                .IndicesStride = use16BitIndices ? uint32_t(sizeof(uint16_t)) : uint32_t(sizeof(uint32_t)),
+                .Indices = grid.GetIndices(use16BitIndices),
+            };
+        }
+
+        // Splits the grid along a column of vertices: quads right of it use copies of its vertices with u shifted by one,
+        // as a uv chart border would. Copies are appended after the grid vertices
+        GridMesh SplitGridColumn(const GridMesh& grid, uint32_t numVerticesPerSide, uint32_t column)
+        {
+            GridMesh split = grid;
+            for (uint32_t z = 0; z < numVerticesPerSide; ++z)
+            {
+                const float* vertex = &grid.Vertices[size_t(z * numVerticesPerSide + column) * 8];
+                split.Vertices.insert(split.Vertices.end(), vertex, vertex + 8);
+                split.Vertices.end()[-2] += 1.0f;
+            }
+
+            const uint32_t numQuadsPerSide = numVerticesPerSide - 1;
+            for (size_t i = 0; i < split.Indices.size(); ++i)
+            {
+                const uint32_t quad = static_cast<uint32_t>(i / 6);
+                uint32_t& index = split.Indices[i];
+                if (quad % numQuadsPerSide >= column && index % numVerticesPerSide == column)
+                    index = grid.NumVertices + index / numVerticesPerSide;
+            }
+
+            split.NumVertices += numVerticesPerSide;
+            split.Indices16.assign(split.Indices.begin(), split.Indices.end());
+            return split;
+        }
+
+        // Triangles of the bent grid all face +y, none of them should be turned over or degenerate
+        bool CheckFacesUp(const GridMesh& grid, std::span<const uint32_t> indices)
+        {
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                float p[3][3];
+                for (uint32_t k = 0; k < 3; ++k)
+                    std::memcpy(p[k], grid.GetPositions() + size_t(indices[i + k]) * GridMesh::VertexStride, sizeof(p[k]));
+
+                // y of the cross product of the edges
+                const float normalY = (p[1][2] - p[0][2]) * (p[2][0] - p[0][0]) - (p[1][0] - p[0][0]) * (p[2][2] - p[0][2]);
+                NEB_EXPECT(normalY > 0.0f, "triangle {} faces down ({})", i / 3, normalY);
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    // Without an error limit a smooth grid is reduced to the target, the last pass overshoots by at most a couple of triangles
+    NEB_TEST(MeshSimplifier, TargetIndexCount)
+    {
+        const GridMesh grid(32, 0.5f);
+        const MeshSimplifierSourceDesc src = GetSimplifierSource(grid, false);
+
+        std::vector<uint32_t> indices(grid.Indices.size());
+        for (size_t target : { grid.Indices.size() / 2, grid.Indices.size() / 4 })
+        {
+            const size_t numIndices = SimplifyMesh(indices, grid.Indices, src, target, MeshSimplifierDesc{ .MaxRelativeError = 1.0f });
+            NEB_EXPECT(numIndices % 3 == 0 && numIndices <= target && numIndices + 6 >= target, "{} indices for the target of {}", numIndices, target);
+            NEB_EXPECT(std::ranges::all_of(std::span(indices).first(numIndices), [&grid](uint32_t index) { return index < grid.NumVertices; }));
+        }
+
+        // Source is already below the target
+        NEB_EXPECT(SimplifyMesh(indices, grid.Indices, src, grid.Indices.size()) == grid.Indices.size());
+        NEB_EXPECT(std::ranges::equal(indices, grid.Indices));
+        return true;
+    }
+
+    // Vertices on the outline of the grid and on both sides of a uv seam are never collapsed, so they stay referenced
+    NEB_TEST(MeshSimplifier, BorderAndSeamLocked)
+    {
+        static constexpr uint32_t NumVerticesPerSide = 32;
+        static constexpr uint32_t Column = NumVerticesPerSide / 2;
+        const GridMesh grid = SplitGridColumn(GridMesh(NumVerticesPerSide, 0.5f), NumVerticesPerSide, Column);
+        const MeshSimplifierSourceDesc src = GetSimplifierSource(grid, false);
+
+        std::vector<uint32_t> indices(grid.Indices.size());
+        const size_t numIndices = SimplifyMesh(indices, grid.Indices, src, 0, MeshSimplifierDesc{ .MaxRelativeError = 1.0f });
+        NEB_EXPECT(numIndices < grid.Indices.size() / 4, "{} of {} indices are left", numIndices, grid.Indices.size());
+
+        std::vector<bool> isReferenced(grid.NumVertices, false);
+        for (size_t i = 0; i < numIndices; ++i)
+            isReferenced[indices[i]] = true;
+
+        for (uint32_t v = 0; v < grid.NumVertices; ++v)
+        {
+            const uint32_t x = v % NumVerticesPerSide;
+            const uint32_t z = v / NumVerticesPerSide;
+            const bool isBorder = x == 0 || x == NumVerticesPerSide - 1 || z == 0 || z == NumVerticesPerSide - 1;
+            const bool isSeam = x == Column || v >= NumVerticesPerSide * NumVerticesPerSide;
+            NEB_EXPECT(isReferenced[v] || !(isBorder || isSeam), "vertex {} ({}, {}) is collapsed", v, x, z);
+        }
+
+        // Triangles never cross the seam, those right of it only use the copies
+        for (size_t i = 0; i < numIndices; i += 3)
+        {
+            bool isLeft = false, isRight = false;
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                const uint32_t index = indices[i + k];
+                const uint32_t x = index % NumVerticesPerSide;
+                if (index >= NumVerticesPerSide * NumVerticesPerSide || x > Column)
+                    isRight = true;
+                else if (x < Column)
+                    isLeft = true;
+            }
+            NEB_EXPECT(!(isLeft && isRight), "triangle {} crosses the seam", i / 3);
+        }
+        return true;
+    }
+
+    // Collapses never turn a triangle over, at any level
+    NEB_TEST(MeshSimplifier, NoFlips)
+    {
+        const GridMesh grid(48, 1.0f);
+        NEB_EXPECT(CheckFacesUp(grid, grid.Indices));
+
+        MeshLodChain chain;
+        BuildMeshLodChain(chain, GetSimplifierSource(grid, false), MeshLodDesc{ .MinTriangles = 16, .Simplifier = { .MaxRelativeError = 1.0f } });
+        NEB_EXPECT(chain.Lods.size() > 2, "{} levels", chain.Lods.size());
+        for (const MeshLod& lod : chain.Lods)
+            NEB_EXPECT(CheckFacesUp(grid, std::span(chain.Indices).subspan(lod.FirstIndex, lod.NumIndices)));
+        return true;
+    }
+
+    // 16 bit indices give the same chain as 32 bit ones, the first level is the source
+    NEB_TEST(MeshSimplifier, IndexStrides)
+    {
+        const GridMesh grid(48, 0.5f);
+
+        MeshLodChain chain16;
+        BuildMeshLodChain(chain16, GetSimplifierSource(grid, true));
+        MeshLodChain chain32;
+        BuildMeshLodChain(chain32, GetSimplifierSource(grid, false));
+
+        NEB_EXPECT(chain32.Lods.size() > 1, "{} levels", chain32.Lods.size());
+        NEB_EXPECT(chain16.Indices == chain32.Indices);
+        NEB_EXPECT(chain16.Lods.size() == chain32.Lods.size());
+        for (size_t level = 0; level < chain32.Lods.size(); ++level)
+        {
+            NEB_EXPECT(chain16.Lods[level].FirstIndex == chain32.Lods[level].FirstIndex && chain16.Lods[level].NumIndices == chain32.Lods[level].NumIndices
+                && chain16.Lods[level].Error == chain32.Lods[level].Error, "level {} differs", level);
+        }
+
+        const MeshLod& source = chain32.Lods[0];
+        NEB_EXPECT(source.FirstIndex == 0 && source.NumIndices == grid.Indices.size() && source.Error == 0.0f);
+        NEB_EXPECT(std::ranges::equal(std::span(chain32.Indices).first(source.NumIndices), grid.Indices));
+        return true;
+    }
+
+    // Levels follow each other in the index buffer, each has fewer triangles and no smaller error than the previous one
+    NEB_TEST(MeshSimplifier, LodChainErrors)
+    {
+        const GridMesh grid(64, 1.0f);
+        const MeshLodDesc desc = { .MaxLods = 8, .MinTriangles = 16, .Simplifier = { .MaxRelativeError = 0.2f } };
+
+        MeshLodChain chain;
+        BuildMeshLodChain(chain, GetSimplifierSource(grid, false), desc);
+        NEB_EXPECT(chain.Lods.size() > 2 && chain.Lods.size() <= desc.MaxLods, "{} levels", chain.Lods.size());
+
+        for (size_t level = 1; level < chain.Lods.size(); ++level)
+        {
+            const MeshLod& previous = chain.Lods[level - 1];
+            const MeshLod& lod = chain.Lods[level];
+            NEB_EXPECT(lod.FirstIndex == previous.FirstIndex + previous.NumIndices);
+            NEB_EXPECT(lod.NumIndices % 3 == 0 && lod.NumIndices <= previous.NumIndices * desc.MinReductionRatio,
+                "level {} has {} indices, previous one {}", level, lod.NumIndices, previous.NumIndices);
+            NEB_EXPECT(lod.Error >= previous.Error, "error of level {} is {}, previous one {}", level, lod.Error, previous.Error);
+        }
+
+        const MeshLod& last = chain.Lods.back();
+        NEB_EXPECT(last.FirstIndex + last.NumIndices == chain.Indices.size());
+        NEB_EXPECT(std::ranges::all_of(chain.Indices, [&grid](uint32_t index) { return index < grid.NumVertices; }));
+        return true;
+    }
+
+    // Simplification stops before the target once every collapse left costs more than MaxRelativeError, which also bounds the reported error
+    NEB_TEST(MeshSimplifier, MaxRelativeErrorStop)
+    {
+        const GridMesh grid(32, 1.0f);
+        const MeshSimplifierSourceDesc src = GetSimplifierSource(grid, false);
+
+        std::vector<uint32_t> indices(grid.Indices.size());
+        size_t previousNumIndices = grid.Indices.size();
+        for (float maxRelativeError : { 0.01f, 0.05f, 0.2f })
+        {
+            float relativeError = -1.0f;
+            const size_t numIndices = SimplifyMesh(indices, grid.Indices, src, 0, MeshSimplifierDesc{ .MaxRelativeError = maxRelativeError }, &relativeError);
+            NEB_EXPECT(numIndices > 0 && numIndices <= previousNumIndices, "{} indices with the limit of {}", numIndices, maxRelativeError);
+            NEB_EXPECT(relativeError >= 0.0f && relativeError <= maxRelativeError, "error {} with the limit of {}", relativeError, maxRelativeError);
+            previousNumIndices = numIndices;
+        }
+        NEB_EXPECT(previousNumIndices < grid.Indices.size() / 4, "{} of {} indices are left", previousNumIndices, grid.Indices.size());
+
+        // Nothing fits into no error at all, as tex coords differ between every two vertices
+        float relativeError = -1.0f;
+        NEB_EXPECT(SimplifyMesh(indices, grid.Indices, src, 0, MeshSimplifierDesc{ .MaxRelativeError = 0.0f }, &relativeError) == grid.Indices.size());
+        NEB_EXPECT(relativeError == 0.0f);
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,120 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include "core/MeshTangents.h"
+#include "util/ThreadPool.h"
+
+#include <cmath>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Tangents of the grid are written into a stream of its own
+        struct TangentGridMesh : GridMesh
+        {
+            TangentGridMesh(uint32_t numVerticesPerSide, float bend)
+                : GridMesh(numVerticesPerSide, bend)
+                , Tangents(size_t(NumVertices) * 4)
+            {
+            }
+
+            TangentGenerationDesc GetDesc(bool use16BitIndices)
+            {
+                return TangentGenerationDesc{
+                    .NumVertices = NumVertices,
+                    .Positions = GetPositions(),
+                    .PositionsStride = VertexStride,
+                    .Normals = GetNormals(),
+                    .NormalsStride = VertexStride,
+                    .TexCoords = GetTexCoords(),
+                    .TexCoordsStride = VertexStride,
+                    .NumIndices = static_cast<uint32_t>(Indices.size()),
+                    .IndicesStride = use16BitIndices ? uint32_t(sizeof(uint16_t)) : uint32_t(sizeof(uint32_t)),
+                    .Indices = GetIndices(use16BitIndices),
+                    .Tangents = Tangents.data(),
+                };
+            }
+
+            std::vector<float> Tangents;
+        };
+    } // anonymous namespace
+
+    // SIMD path on any number of threads gives exactly the same tangents as the scalar reference. The large grid is split
+    // into several chunks of triangles and vertices
+    NEB_TEST(MeshTangents, MatchesReference)
+    {
+        TangentGridMesh small(8, 0.0f);
+        TangentGridMesh medium(64, 1.5f);
+        TangentGridMesh large(200, 3.0f);
+
+        ThreadPool serialPool(0);
+        ThreadPool threadPool(3);
+        for (ThreadPool* pool : { &serialPool, &threadPool })
+        {
+            const TangentGenerationDesc descs[] = { small.GetDesc(true), medium.GetDesc(true), large.GetDesc(false) };
+            GenerateTangents(descs, *pool);
+
+            for (const TangentGenerationDesc& desc : descs)
+            {
+                std::vector<float> referenceTangents(size_t(desc.NumVertices) * 4);
+                TangentGenerationDesc referenceDesc = desc;
+                referenceDesc.Tangents = referenceTangents.data();
+                GenerateTangentsReference(referenceDesc);
+
+                const float maxDifference = GetMaxTangentDifference(desc.Tangents, referenceDesc.Tangents, desc.NumVertices);
+                NEB_EXPECT(maxDifference == 0.0f, "{} vertices on {} threads differ by {}", desc.NumVertices, pool->GetNumThreads(), maxDifference);
+            }
+        }
+        return true;
+    }
+
+    // Flat grid has the tangent along +x (where u grows). v grows along +z, which is -cross(normal, tangent), thus handedness is -1
+    NEB_TEST(MeshTangents, PlanarGrid)
+    {
+        TangentGridMesh grid(16, 0.0f);
+        const TangentGenerationDesc desc = grid.GetDesc(true);
+
+        ThreadPool threadPool(0);
+        GenerateTangents({ &desc, 1 }, threadPool);
+
+        for (uint32_t i = 0; i < grid.NumVertices; ++i)
+        {
+            const float* tangent = &grid.Tangents[size_t(i) * 4];
+            NEB_EXPECT(std::abs(tangent[0] - 1.0f) < 1e-5f && std::abs(tangent[1]) < 1e-5f && std::abs(tangent[2]) < 1e-5f,
+                "tangent of vertex {} is ({}, {}, {})", i, tangent[0], tangent[1], tangent[2]);
+            NEB_EXPECT(tangent[3] == -1.0f, "handedness of vertex {} is {}", i, tangent[3]);
+        }
+        return true;
+    }
+
+    // Triangles with degenerate uvs do not contribute, vertices still get a unit tangent orthogonal to the normal
+    NEB_TEST(MeshTangents, DegenerateTexCoords)
+    {
+        TangentGridMesh grid(16, 2.0f);
+        for (uint32_t i = 0; i < grid.NumVertices; ++i)
+        {
+            grid.Vertices[size_t(i) * 8 + 6] = 0.5f;
+            grid.Vertices[size_t(i) * 8 + 7] = 0.5f;
+        }
+        const TangentGenerationDesc desc = grid.GetDesc(false);
+
+        ThreadPool threadPool(0);
+        GenerateTangents({ &desc, 1 }, threadPool);
+
+        for (uint32_t i = 0; i < grid.NumVertices; ++i)
+        {
+            const float* tangent = &grid.Tangents[size_t(i) * 4];
+            const float* normal = &grid.Vertices[size_t(i) * 8 + 3];
+            const float length = std::sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+            const float cosine = tangent[0] * normal[0] + tangent[1] * normal[1] + tangent[2] * normal[2];
+            NEB_EXPECT(std::abs(length - 1.0f) < 1e-4f, "tangent of vertex {} is of length {}", i, length);
+            NEB_EXPECT(std::abs(cosine) < 1e-4f, "tangent of vertex {} is not orthogonal to the normal (cosine {})", i, cosine);
+            NEB_EXPECT(std::abs(tangent[3]) == 1.0f, "handedness of vertex {} is {}", i, tangent[3]);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
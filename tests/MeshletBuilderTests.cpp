@@ -0,0 +1,158 @@
+#include "Test.h"
+#include "TestMeshes.h"
+
+#include "core/MeshletBuilder.h"
+#include "util/ThreadPool.h"
+
+#include <cmath>
+#include <span>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        MeshletSourceDesc GetMeshletSource(const GridMesh& grid, bool use16BitIndices)
+        {
+            return MeshletSourceDesc{
+                .NumVertices = grid.NumVertices,
+                .Positions = grid.GetPositions(),
+                .PositionsStride = GridMesh::VertexStride,
+                .NumIndices = static_cast<uint32_t>(grid.Indices.size()),
+                .IndicesStride = use16BitIndices ? uint32_t(sizeof(uint16_t)) : uint32_t(sizeof(uint32_t)),
+                .Indices = grid.GetIndices(use16BitIndices),
+            };
+        }
+
+        // Every meshlet respects the limits and meshlet triangles cover exactly the source triangles in the same order
+        bool CheckMeshlets(const MeshletData& meshlets, std::span<const uint32_t> indices, const MeshletBuilderDesc& desc)
+        {
+            NEB_EXPECT(meshlets.Bounds.size() == meshlets.Meshlets.size());
+
+            size_t sourceIndex = 0;
+            for (const Meshlet& meshlet : meshlets.Meshlets)
+            {
+                NEB_EXPECT(meshlet.NumVertices != 0 && meshlet.NumVertices <= desc.MaxVertices && meshlet.NumTriangles != 0 && meshlet.NumTriangles <= desc.MaxTriangles,
+                    "meshlet of {} vertices and {} triangles", meshlet.NumVertices, meshlet.NumTriangles);
+                NEB_EXPECT(size_t(meshlet.VertexOffset) + meshlet.NumVertices <= meshlets.Vertices.size()
+                    && size_t(meshlet.TriangleOffset) + size_t(meshlet.NumTriangles) * 3 <= meshlets.Triangles.size());
+
+                for (uint32_t i = 0; i < meshlet.NumTriangles * 3; ++i, ++sourceIndex)
+                {
+                    const uint8_t local = meshlets.Triangles[meshlet.TriangleOffset + i];
+                    NEB_EXPECT(local < meshlet.NumVertices && sourceIndex < indices.size());
+                    NEB_EXPECT(meshlets.Vertices[meshlet.VertexOffset + local] == indices[sourceIndex], "index {} differs", sourceIndex);
+                }
+            }
+            NEB_EXPECT(sourceIndex == indices.size(), "{} of {} indices are covered", sourceIndex, indices.size());
+            return true;
+        }
+
+        // Culling test of the shader, see MeshletBounds
+        bool IsBackfacing(const MeshletBounds& bounds, const float (&cameraPosition)[3])
+        {
+            float direction[3];
+            for (uint32_t i = 0; i < 3; ++i)
+                direction[i] = bounds.ConeApex[i] - cameraPosition[i];
+
+            const float length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+            const float cosine = (direction[0] * bounds.ConeAxis[0] + direction[1] * bounds.ConeAxis[1] + direction[2] * bounds.ConeAxis[2]) / length;
+            return cosine >= bounds.ConeCutoff;
+        }
+    } // anonymous namespace
+
+    // Every meshlet respects the limits and meshlet triangles cover exactly the source triangles in the same order
+    NEB_TEST(MeshletBuilder, LimitsAndCoverage)
+    {
+        const GridMesh grid(33, 1.0f);
+        const MeshletBuilderDesc descs[] = {
+            MeshletBuilderDesc{},
+            MeshletBuilderDesc{ .MaxVertices = 3, .MaxTriangles = 1 },
+            MeshletBuilderDesc{ .MaxVertices = 32, .MaxTriangles = 16 },
+            MeshletBuilderDesc{ .MaxVertices = MeshletMaxVerticesLimit, .MaxTriangles = MeshletMaxTrianglesLimit },
+        };
+
+        for (const MeshletBuilderDesc& desc : descs)
+        {
+            for (bool use16BitIndices : { true, false })
+            {
+                const MeshletSourceDesc src = GetMeshletSource(grid, use16BitIndices);
+                MeshletData meshlets;
+                BuildMeshlets(meshlets, src, desc);
+
+                NEB_EXPECT(CheckMeshlets(meshlets, grid.Indices, desc), "meshlets of {} vertices and {} triangles are invalid", desc.MaxVertices, desc.MaxTriangles);
+                NEB_EXPECT(meshlets.Meshlets.size() >= src.NumIndices / 3 / desc.MaxTriangles);
+            }
+        }
+
+        // Single triangle meshlets are just the source triangles
+        MeshletData meshlets;
+        BuildMeshlets(meshlets, GetMeshletSource(grid, true), MeshletBuilderDesc{ .MaxVertices = 3, .MaxTriangles = 1 });
+        NEB_EXPECT(meshlets.Meshlets.size() == grid.Indices.size() / 3);
+        return true;
+    }
+
+    // Every vertex of a meshlet is within its sphere. Flat grid faces +y, thus its meshlets are culled from below and never from above
+    NEB_TEST(MeshletBuilder, Bounds)
+    {
+        const GridMesh grid(33, 0.0f);
+        const MeshletSourceDesc src = GetMeshletSource(grid, false);
+        MeshletData meshlets;
+        BuildMeshlets(meshlets, src, MeshletBuilderDesc{});
+
+        NEB_EXPECT(meshlets.Bounds.size() == meshlets.Meshlets.size());
+        for (size_t i = 0; i < meshlets.Meshlets.size(); ++i)
+        {
+            const Meshlet& meshlet = meshlets.Meshlets[i];
+            const MeshletBounds& bounds = meshlets.Bounds[i];
+            for (uint32_t v = 0; v < meshlet.NumVertices; ++v)
+            {
+                const float* position = &grid.Vertices[size_t(meshlets.Vertices[meshlet.VertexOffset + v]) * 8];
+                const float dx = position[0] - bounds.Center[0];
+                const float dy = position[1] - bounds.Center[1];
+                const float dz = position[2] - bounds.Center[2];
+                NEB_EXPECT(std::sqrt(dx * dx + dy * dy + dz * dz) <= bounds.Radius * 1.0001f, "vertex {} is outside of the sphere of meshlet {}", v, i);
+            }
+
+            NEB_EXPECT(bounds.ConeCutoff < 1.0f, "cone of flat meshlet {} is disabled", i);
+            NEB_EXPECT(IsBackfacing(bounds, { 0.0f, -10.0f, 0.0f }), "meshlet {} is not culled from below", i);
+            NEB_EXPECT(!IsBackfacing(bounds, { 0.0f, 10.0f, 0.0f }), "meshlet {} is culled from above", i);
+            NEB_EXPECT(!IsBackfacing(bounds, { 0.3f, 0.01f, -0.2f }), "meshlet {} is culled from right above the grid", i);
+        }
+        return true;
+    }
+
+    // Meshlets built on the thread pool are the same as ones built one source after another
+    NEB_TEST(MeshletBuilder, ParallelMatchesSerial)
+    {
+        const GridMesh grids[] = { GridMesh(9, 0.0f), GridMesh(33, 1.0f), GridMesh(65, 2.0f) };
+        std::vector<MeshletSourceDesc> srcs;
+        for (const GridMesh& grid : grids)
+            srcs.push_back(GetMeshletSource(grid, true));
+
+        const MeshletBuilderDesc desc;
+        ThreadPool threadPool(3);
+        std::vector<MeshletData> meshlets(srcs.size());
+        BuildMeshlets(meshlets, srcs, desc, threadPool);
+
+        for (size_t i = 0; i < srcs.size(); ++i)
+        {
+            MeshletData reference;
+            BuildMeshlets(reference, srcs[i], desc);
+
+            NEB_EXPECT(meshlets[i].Vertices == reference.Vertices && meshlets[i].Triangles == reference.Triangles, "meshlets of source {} differ", i);
+            NEB_EXPECT(meshlets[i].Meshlets.size() == reference.Meshlets.size(), "source {} has {} meshlets, expected {}", i, meshlets[i].Meshlets.size(), reference.Meshlets.size());
+        }
+        return true;
+    }
+
+    NEB_TEST(MeshletBuilder, EmptySource)
+    {
+        MeshletData meshlets;
+        BuildMeshlets(meshlets, MeshletSourceDesc{ .IndicesStride = sizeof(uint32_t) }, MeshletBuilderDesc{});
+        NEB_EXPECT(meshlets.Meshlets.empty() && meshlets.Vertices.empty() && meshlets.Triangles.empty());
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,537 @@
+#include "Test.h"
+
+#include "core/FrustumCulling.h"
+#include "core/OcclusionCulling.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Scalar reference of OcclusionCuller. Setup of triangles and boxes is the same math as in OcclusionCulling.cpp,
+        // so that the reference rasterizes exactly the same triangles
+        static constexpr float ClearDepth = 1.0f;
+
+        struct ClipVertex
+        {
+            float X, Y, Z, W;
+        };
+
+        ClipVertex TransformToClip(const Vec3& p, const Mat4& m)
+        {
+            return ClipVertex{
+                .X = p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41,
+                .Y = p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42,
+                .Z = p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43,
+                .W = p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44,
+            };
+        }
+
+        // Vertices in front of the near plane (D3D clip z >= 0)
+        bool IsInFrontOfNearPlane(const ClipVertex& v) { return v.Z >= 0.0f && v.W > 0.0f; }
+
+        int32_t ClampPixel(float v, uint32_t size) { return static_cast<int32_t>(std::clamp(v, -1.0f, float(size))); }
+
+        // Triangles that cross the near plane are not clipped, but skipped. Returns false if the triangle is not going to be rasterized
+        bool SetupOccluderTriangle(OccluderTriangle& triangle, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, uint32_t width, uint32_t height)
+        {
+            triangle.MinX = triangle.MinY = 1;
+            triangle.MaxX = triangle.MaxY = 0;
+
+            const ClipVertex* vertices[3] = { &v0, &v1, &v2 };
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                const ClipVertex& v = *vertices[i];
+                if (!IsInFrontOfNearPlane(v))
+                    return false;
+
+                const float invW = 1.0f / v.W;
+                triangle.X[i] = (v.X * invW * 0.5f + 0.5f) * float(width);
+                triangle.Y[i] = (0.5f - v.Y * invW * 0.5f) * float(height);
+                triangle.Z[i] = v.Z * invW;
+            }
+
+            // Rasterizer expects positive area, that is E(p) > 0 inside for every edge function (see GetEdgeFunction)
+            const float area = (triangle.X[1] - triangle.X[0]) * (triangle.Y[2] - triangle.Y[0]) - (triangle.X[2] - triangle.X[0]) * (triangle.Y[1] - triangle.Y[0]);
+            if (!(std::abs(area) > 1e-6f))
+                return false;
+
+            if (area < 0.0f)
+            {
+                std::swap(triangle.X[1], triangle.X[2]);
+                std::swap(triangle.Y[1], triangle.Y[2]);
+                std::swap(triangle.Z[1], triangle.Z[2]);
+            }
+
+            // Pixels whose centers (x + 0.5) are within the bounds of the triangle
+            const float minX = std::min({ triangle.X[0], triangle.X[1], triangle.X[2] });
+            const float maxX = std::max({ triangle.X[0], triangle.X[1], triangle.X[2] });
+            const float minY = std::min({ triangle.Y[0], triangle.Y[1], triangle.Y[2] });
+            const float maxY = std::max({ triangle.Y[0], triangle.Y[1], triangle.Y[2] });
+            triangle.MinX = std::max(ClampPixel(std::ceil(minX - 0.5f), width), 0);
+            triangle.MaxX = std::min(ClampPixel(std::floor(maxX - 0.5f), width), int32_t(width) - 1);
+            triangle.MinY = std::max(ClampPixel(std::ceil(minY - 0.5f), height), 0);
+            triangle.MaxY = std::min(ClampPixel(std::floor(maxY - 0.5f), height), int32_t(height) - 1);
+            return triangle.MinX <= triangle.MaxX && triangle.MinY <= triangle.MaxY;
+        }
+
+        // E(p) = A * x + B * y + C, positive on the inner side of the edge from a to b. Edges shared by two triangles are evaluated
+        // with exactly negated coefficients, thus exactly one of them includes points on the edge (top-left rule)
+        struct EdgeFunction
+        {
+            float A, B, C;
+            bool IsInclusive;
+        };
+
+        EdgeFunction GetEdgeFunction(float ax, float ay, float bx, float by)
+        {
+            const float a = ay - by;
+            const float b = bx - ax;
+            return EdgeFunction{ .A = a, .B = b, .C = ax * by - ay * bx, .IsInclusive = a > 0.0f || (a == 0.0f && b > 0.0f) };
+        }
+
+        // Depth is a plane in screen space, z(p) = A * x + B * y + C
+        struct DepthPlane
+        {
+            float A, B, C;
+        };
+
+        DepthPlane GetDepthPlane(const OccluderTriangle& t)
+        {
+            const float area = (t.X[1] - t.X[0]) * (t.Y[2] - t.Y[0]) - (t.X[2] - t.X[0]) * (t.Y[1] - t.Y[0]);
+            const float a = ((t.Z[1] - t.Z[0]) * (t.Y[2] - t.Y[0]) - (t.Z[2] - t.Z[0]) * (t.Y[1] - t.Y[0])) / area;
+            const float b = ((t.X[1] - t.X[0]) * (t.Z[2] - t.Z[0]) - (t.X[2] - t.X[0]) * (t.Z[1] - t.Z[0])) / area;
+            return DepthPlane{ .A = a, .B = b, .C = t.Z[0] - a * t.X[0] - b * t.Y[0] };
+        }
+
+        // Pixel rectangle and the closest depth of a box. Returns false if the box crosses the near plane or is off screen
+        bool ProjectBox(const AABB& box, const Mat4& viewProj, uint32_t width, uint32_t height, int32_t& x0, int32_t& y0, int32_t& x1, int32_t& y1, float& minZ)
+        {
+            float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+            minZ = FLT_MAX;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const Vec3 corner = Vec3((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+                const ClipVertex v = TransformToClip(corner, viewProj);
+                if (!IsInFrontOfNearPlane(v))
+                    return false;
+
+                const float invW = 1.0f / v.W;
+                const float x = (v.X * invW * 0.5f + 0.5f) * float(width);
+                const float y = (0.5f - v.Y * invW * 0.5f) * float(height);
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                minZ = std::min(minZ, v.Z * invW);
+            }
+
+            if (!(maxX >= 0.0f && minX < float(width) && maxY >= 0.0f && minY < float(height)))
+                return false;
+
+            // Every pixel the rectangle touches
+            x0 = static_cast<int32_t>(std::max(minX, 0.0f));
+            x1 = static_cast<int32_t>(std::min(maxX, float(width - 1)));
+            y0 = static_cast<int32_t>(std::max(minY, 0.0f));
+            y1 = static_cast<int32_t>(std::min(maxY, float(height - 1)));
+            return true;
+        }
+
+        // Every pixel of the triangle bounds is tested one by one. Coverage counts how many triangles covered each pixel
+        void RasterizeReference(std::vector<float>& depth, std::vector<uint32_t>& coverage, uint32_t width, const OccluderTriangle& triangle)
+        {
+            const EdgeFunction edges[3] = {
+                GetEdgeFunction(triangle.X[0], triangle.Y[0], triangle.X[1], triangle.Y[1]),
+                GetEdgeFunction(triangle.X[1], triangle.Y[1], triangle.X[2], triangle.Y[2]),
+                GetEdgeFunction(triangle.X[2], triangle.Y[2], triangle.X[0], triangle.Y[0]),
+            };
+            const DepthPlane plane = GetDepthPlane(triangle);
+            const float minDepth = std::min({ triangle.Z[0], triangle.Z[1], triangle.Z[2] });
+            const float maxDepth = std::max({ triangle.Z[0], triangle.Z[1], triangle.Z[2] });
+
+            for (int32_t y = triangle.MinY; y <= triangle.MaxY; ++y)
+            {
+                for (int32_t x = triangle.MinX; x <= triangle.MaxX; ++x)
+                {
+                    const float pixelX = float(x) + 0.5f;
+                    const float pixelY = float(y) + 0.5f;
+
+                    bool isCovered = true;
+                    for (const EdgeFunction& edge : edges)
+                    {
+                        const float e = edge.A * pixelX + edge.B * pixelY + edge.C;
+                        isCovered = isCovered && (edge.IsInclusive ? e >= 0.0f : e > 0.0f);
+                    }
+                    if (!isCovered)
+                        continue;
+
+                    const size_t pixel = size_t(y) * width + x;
+                    const float z = std::clamp(plane.A * pixelX + plane.B * pixelY + plane.C, minDepth, maxDepth);
+                    depth[pixel] = std::min(depth[pixel], z);
+                    coverage[pixel] += 1;
+                }
+            }
+        }
+
+        struct ReferenceBuffer
+        {
+            std::vector<float> Depth;
+            std::vector<uint32_t> Coverage;
+        };
+
+        ReferenceBuffer RasterizeReference(std::span<const OccluderMesh* const> meshes, std::span<const Mat4> meshToClips, uint32_t width, uint32_t height)
+        {
+            ReferenceBuffer buffer = { .Depth = std::vector<float>(size_t(width) * height, ClearDepth), .Coverage = std::vector<uint32_t>(size_t(width) * height, 0) };
+            for (size_t m = 0; m < meshes.size(); ++m)
+            {
+                const OccluderMesh& mesh = *meshes[m];
+                for (uint32_t i = 0; i < mesh.GetNumTriangles(); ++i)
+                {
+                    ClipVertex v[3];
+                    for (uint32_t k = 0; k < 3; ++k)
+                        v[k] = TransformToClip(mesh.Positions[mesh.Indices[size_t(i) * 3 + k]], meshToClips[m]);
+
+                    OccluderTriangle triangle;
+                    if (SetupOccluderTriangle(triangle, v[0], v[1], v[2], width, height))
+                        RasterizeReference(buffer.Depth, buffer.Coverage, width, triangle);
+                }
+            }
+            return buffer;
+        }
+
+        // Same test as OcclusionCuller::IsVisible(), but without the depth hierarchy
+        bool IsVisibleReference(const AABB& box, const Mat4& viewProj, std::span<const float> depth, uint32_t width, uint32_t height)
+        {
+            int32_t x0, y0, x1, y1;
+            float minZ;
+            if (!ProjectBox(box, viewProj, width, height, x0, y0, x1, y1, minZ))
+                return true;
+
+            for (int32_t y = y0; y <= y1; ++y)
+                for (int32_t x = x0; x <= x1; ++x)
+                {
+                    if (depth[size_t(y) * width + x] >= minZ)
+                        return true;
+                }
+            return false;
+        }
+
+        // Depth buffer of the last Rasterize() matches the reference. Meshes should be the occluders that were added this frame.
+        // If checkWatertight is set, no pixel may be covered twice, which holds for meshes without overlapping triangles:
+        // edges shared by triangles are covered exactly once
+        bool CheckOcclusionDepth(const OcclusionCuller& culler, std::span<const OccluderMesh* const> meshes, std::span<const Mat4> meshToWorlds, bool checkWatertight)
+        {
+            NEB_EXPECT(meshes.size() == meshToWorlds.size());
+
+            // Same product as in AddOccluder(), so that both rasterize exactly the same triangles
+            std::vector<Mat4> meshToClips(meshToWorlds.size());
+            for (size_t i = 0; i < meshToWorlds.size(); ++i)
+                meshToClips[i] = meshToWorlds[i] * culler.GetViewProj();
+
+            const uint32_t width = culler.GetWidth();
+            const ReferenceBuffer reference = RasterizeReference(meshes, meshToClips, width, culler.GetHeight());
+            const std::span<const float> depth = culler.GetDepth();
+            for (size_t pixel = 0; pixel < depth.size(); ++pixel)
+            {
+                NEB_EXPECT(depth[pixel] == reference.Depth[pixel], "depth of pixel ({}, {}) is {}, expected {}", pixel % width, pixel / width, depth[pixel], reference.Depth[pixel]);
+                NEB_EXPECT(!checkWatertight || reference.Coverage[pixel] <= 1, "pixel ({}, {}) is covered {} times", pixel % width, pixel / width, reference.Coverage[pixel]);
+            }
+            return true;
+        }
+
+        // visible[i] matches the per-pixel test of boxes[i] against the depth buffer, i.e. the depth hierarchy never changes results
+        bool CheckOcclusionVisibility(const OcclusionCuller& culler, std::span<const AABB> boxes, std::span<const uint8_t> visible)
+        {
+            NEB_EXPECT(boxes.size() == visible.size());
+
+            for (size_t i = 0; i < boxes.size(); ++i)
+            {
+                NEB_EXPECT(bool(visible[i]) == IsVisibleReference(boxes[i], culler.GetViewProj(), culler.GetDepth(), culler.GetWidth(), culler.GetHeight()),
+                    "visibility of box {} differs from the test without depth hierarchy", i);
+            }
+            return true;
+        }
+
+        OccluderMesh CreateBoxOccluder()
+        {
+            OccluderMesh mesh;
+            for (uint32_t i = 0; i < 8; ++i)
+                mesh.Positions.push_back(Vec3((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f));
+
+            mesh.Indices = {
+                0, 2, 1, 1, 2, 3, // -z
+                4, 5, 6, 5, 7, 6, // +z
+                0, 1, 4, 1, 5, 4, // -y
+                2, 6, 3, 3, 6, 7, // +y
+                0, 4, 2, 2, 4, 6, // -x
+                1, 3, 5, 3, 7, 5, // +x
+            };
+            return mesh;
+        }
+
+        AABB GetBox(const Vec3& center, const Vec3& size)
+        {
+            return AABB{ .min = center - size * 0.5f, .max = center + size * 0.5f };
+        }
+
+        // Positions of meshes are in clip space, view-projection and transforms are identity
+        bool RasterizeClipSpace(OcclusionCuller& culler, const OccluderMesh& mesh, bool checkWatertight, ThreadPool& threadPool)
+        {
+            culler.BeginFrame(Mat4::Identity);
+            culler.AddOccluder(mesh, Mat4::Identity);
+            culler.Rasterize(threadPool);
+
+            const OccluderMesh* meshes[] = { &mesh };
+            const Mat4 meshToWorlds[] = { Mat4::Identity };
+            return CheckOcclusionDepth(culler, meshes, meshToWorlds, checkWatertight);
+        }
+
+        // Camera at the origin looking down -Z, same projection as in DeferredRenderer
+        Mat4 GetViewProj(const Vec3& eye, const OcclusionCullerDesc& desc, float farPlane)
+        {
+            return Mat4::CreateLookAt(eye, eye + Vec3(0.0f, 0.0f, -1.0f), Vec3::UnitY) *
+                Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), float(desc.Width) / float(desc.Height), 0.1f, farPlane);
+        }
+    } // anonymous namespace
+
+    // Two triangles covering the whole screen, every pixel is covered exactly once, the diagonal included
+    NEB_TEST(OcclusionCulling, FullscreenQuad)
+    {
+        OccluderMesh quad;
+        quad.Positions = { Vec3(-1.0f, -1.0f, 0.5f), Vec3(1.0f, -1.0f, 0.5f), Vec3(1.0f, 1.0f, 0.5f), Vec3(-1.0f, 1.0f, 0.5f) };
+        quad.Indices = { 0, 1, 2, 0, 2, 3 };
+
+        ThreadPool threadPool(3);
+        OcclusionCuller culler;
+        culler.Init(OcclusionCullerDesc());
+        NEB_EXPECT(RasterizeClipSpace(culler, quad, /*checkWatertight*/ true, threadPool));
+
+        const std::span<const float> depth = culler.GetDepth();
+        NEB_EXPECT(std::all_of(depth.begin(), depth.end(), [](float z) { return z == 0.5f; }), "fullscreen quad left some pixels uncovered");
+        NEB_EXPECT(culler.GetStats().NumRasterized == 2);
+        return true;
+    }
+
+    // Fans share every inner edge, pixels on them are covered exactly once
+    NEB_TEST(OcclusionCulling, TriangleFansAreWatertight)
+    {
+        std::mt19937_64 random(0x0CC);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        auto getRandom = [&](float min, float max) { return min + (max - min) * unitDistribution(random); };
+
+        ThreadPool threadPool(3);
+        OcclusionCuller culler;
+        culler.Init(OcclusionCullerDesc());
+        for (uint32_t fan = 0; fan < 16; ++fan)
+        {
+            OccluderMesh mesh;
+            const uint32_t numSegments = 3 + static_cast<uint32_t>(random() % 96);
+            const Vec3 center = Vec3(getRandom(-0.5f, 0.5f), getRandom(-0.5f, 0.5f), getRandom(0.1f, 0.9f));
+            const float radius = getRandom(0.1f, 1.5f);
+            mesh.Positions.push_back(center);
+            for (uint32_t i = 0; i < numSegments; ++i)
+            {
+                const float angle = 2.0f * std::numbers::pi_v<float> * float(i) / float(numSegments);
+                mesh.Positions.push_back(Vec3(center.x + radius * std::cos(angle), center.y + radius * std::sin(angle), getRandom(0.1f, 0.9f)));
+                mesh.Indices.insert(mesh.Indices.end(), { 0, 1 + i, 1 + (i + 1) % numSegments });
+            }
+            NEB_EXPECT(RasterizeClipSpace(culler, mesh, /*checkWatertight*/ true, threadPool), "fan {} of {} segments", fan, numSegments);
+        }
+        return true;
+    }
+
+    // Random overlapping triangles, partially off screen and of both windings, keep the closest depth of the reference
+    NEB_TEST(OcclusionCulling, RandomTriangles)
+    {
+        std::mt19937_64 random(0x0CC);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        auto getRandom = [&](float min, float max) { return min + (max - min) * unitDistribution(random); };
+
+        OccluderMesh mesh;
+        for (uint32_t i = 0; i < 1024; ++i)
+        {
+            const float size = (i % 16 == 0) ? 2.0f : 0.2f;
+            const Vec3 origin = Vec3(getRandom(-1.2f, 1.2f), getRandom(-1.2f, 1.2f), 0.0f);
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                mesh.Indices.push_back(static_cast<uint32_t>(mesh.Positions.size()));
+                mesh.Positions.push_back(Vec3(origin.x + getRandom(-size, size), origin.y + getRandom(-size, size), getRandom(0.0f, 1.0f)));
+            }
+        }
+
+        ThreadPool threadPool(3);
+        OcclusionCuller culler;
+        culler.Init(OcclusionCullerDesc());
+        NEB_EXPECT(RasterizeClipSpace(culler, mesh, /*checkWatertight*/ false, threadPool));
+        return true;
+    }
+
+    // 10x10 wall 10 units away, its edges are at 0.5 of the distance to the camera
+    NEB_TEST(OcclusionCulling, KnownBoxes)
+    {
+        const OcclusionCullerDesc desc;
+        ThreadPool threadPool(3);
+        OcclusionCuller culler;
+        culler.Init(desc);
+
+        const OccluderMesh box = CreateBoxOccluder();
+        culler.BeginFrame(GetViewProj(Vec3(0.0f), desc, 100.0f));
+        culler.AddOccluder(box, Mat4::CreateScale(10.0f, 10.0f, 0.1f) * Mat4::CreateTranslation(0.0f, 0.0f, -10.0f));
+        culler.Rasterize(threadPool);
+
+        struct KnownBox
+        {
+            AABB Box;
+            bool IsVisible;
+            const char* Name;
+        };
+        const KnownBox knownBoxes[] = {
+            { GetBox(Vec3(0.0f, 0.0f, -20.0f), Vec3(2.0f)), false, "behind the wall" },
+            { GetBox(Vec3(2.0f, -3.0f, -40.0f), Vec3(4.0f)), false, "far behind the wall" },
+            { GetBox(Vec3(0.0f, 0.0f, -5.0f), Vec3(1.0f)), true, "in front of the wall" },
+            { GetBox(Vec3(12.0f, 0.0f, -20.0f), Vec3(2.0f)), true, "beside the wall" },
+            { GetBox(Vec3(9.5f, 0.0f, -20.0f), Vec3(2.0f)), true, "partially behind the wall" },
+            { GetBox(Vec3(0.0f, 0.0f, -10.0f), Vec3(1.0f)), true, "crossing the wall" },
+            { GetBox(Vec3(0.0f, 0.0f, 0.0f), Vec3(2.0f)), true, "crossing the near plane" },
+        };
+        for (const KnownBox& known : knownBoxes)
+            NEB_EXPECT(culler.IsVisible(known.Box) == known.IsVisible, "box {} is expected to be {}", known.Name, known.IsVisible ? "visible" : "occluded");
+        return true;
+    }
+
+    // Props scattered between blocks of buildings along a street. The depth hierarchy never changes results of TestBoxes()
+    NEB_TEST(OcclusionCulling, City)
+    {
+        std::mt19937_64 random(0x0CC);
+        std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+        auto getRandom = [&](float min, float max) { return min + (max - min) * unitDistribution(random); };
+
+        const OccluderMesh buildingMesh = CreateBoxOccluder();
+        std::vector<Mat4> buildings;
+        for (int32_t x = -10; x <= 10; ++x)
+        {
+            for (int32_t z = 1; z <= 25; ++z)
+            {
+                // The street itself is left empty
+                if (x == 0)
+                    continue;
+
+                const Vec3 size = Vec3(getRandom(10.0f, 14.0f), getRandom(10.0f, 40.0f), getRandom(10.0f, 14.0f));
+                buildings.push_back(Mat4::CreateScale(size) * Mat4::CreateTranslation(Vec3(float(x) * 20.0f, size.y * 0.5f, float(z) * -20.0f)));
+            }
+        }
+
+        std::vector<AABB> draws(20'000);
+        for (AABB& draw : draws)
+            draw = GetBox(Vec3(getRandom(-210.0f, 210.0f), getRandom(0.0f, 6.0f), getRandom(-510.0f, -5.0f)), Vec3(getRandom(0.5f, 2.0f)));
+
+        const OcclusionCullerDesc desc;
+        const Mat4 viewProj = GetViewProj(Vec3(2.0f, 1.7f, 0.0f), desc, 1000.0f);
+        const Frustum frustum = ExtractFrustum(viewProj);
+        std::erase_if(draws, [&frustum](const AABB& draw) { return !IsAABBInFrustum(frustum, draw); });
+
+        ThreadPool threadPool(3);
+        OcclusionCuller culler;
+        culler.Init(desc);
+        culler.BeginFrame(viewProj);
+
+        std::vector<const OccluderMesh*> meshes;
+        std::vector<Mat4> meshToWorlds;
+        for (const Mat4& building : buildings)
+        {
+            if (culler.AddOccluder(buildingMesh, building))
+            {
+                meshes.push_back(&buildingMesh);
+                meshToWorlds.push_back(building);
+            }
+        }
+        culler.Rasterize(threadPool);
+        NEB_EXPECT(CheckOcclusionDepth(culler, meshes, meshToWorlds, /*checkWatertight*/ false));
+
+        std::vector<uint8_t> visible(draws.size());
+        const uint32_t numOccluded = culler.TestBoxes(draws, visible, threadPool);
+        NEB_EXPECT(CheckOcclusionVisibility(culler, draws, visible));
+        NEB_EXPECT(numOccluded > draws.size() / 4 && numOccluded < draws.size(), "{} of {} draws are occluded", numOccluded, draws.size());
+        NEB_EXPECT(culler.GetStats().NumTested == draws.size() && culler.GetStats().NumOccluded == numOccluded);
+        return true;
+    }
+
+    // Occluders that do not fit the triangle budget are rejected, the budget grows back while it limits occluders and rasterization is fast
+    NEB_TEST(OcclusionCulling, TriangleBudget)
+    {
+        const OcclusionCullerDesc desc = { .MaxTriangles = 64, .MinTriangles = 16, .BudgetMilliseconds = 1000.0f };
+        ThreadPool threadPool(1);
+        OcclusionCuller culler;
+        culler.Init(desc);
+
+        const OccluderMesh box = CreateBoxOccluder();
+        const Mat4 transform = Mat4::CreateTranslation(0.0f, 0.0f, -10.0f);
+        culler.BeginFrame(GetViewProj(Vec3(0.0f), desc, 100.0f));
+        NEB_EXPECT(culler.GetStats().TriangleBudget == 16);
+        NEB_EXPECT(culler.AddOccluder(box, transform));
+        NEB_EXPECT(!culler.AddOccluder(box, transform), "second box of 12 triangles does not fit the budget of 16");
+        NEB_EXPECT(culler.GetStats().NumOccluders == 1 && culler.GetStats().NumTriangles == 12);
+        culler.Rasterize(threadPool);
+
+        for (uint32_t frame = 0; frame < 16; ++frame)
+        {
+            culler.BeginFrame(GetViewProj(Vec3(0.0f), desc, 100.0f));
+            while (culler.AddOccluder(box, transform))
+                ;
+            culler.Rasterize(threadPool);
+        }
+        NEB_EXPECT(culler.GetStats().TriangleBudget == desc.MaxTriangles, "budget is {}", culler.GetStats().TriangleBudget);
+        return true;
+    }
+
+    // Submeshes of 16 and 32 bit indices with interleaved vertices are merged, vertices that are not referenced are dropped
+    NEB_TEST(OcclusionCulling, BuildOccluderMesh)
+    {
+        const float vertices[][5] = {
+            { 0.0f, 0.0f, 0.0f, 9.0f, 9.0f },
+            { 1.0f, 0.0f, 0.0f, 9.0f, 9.0f },
+            { 7.0f, 7.0f, 7.0f, 9.0f, 9.0f }, // unused
+            { 0.0f, 1.0f, 0.0f, 9.0f, 9.0f },
+        };
+        const uint16_t indices16[] = { 0, 1, 3 };
+        const uint32_t indices32[] = { 3, 1, 0, 0, 1, 3 };
+
+        const OccluderSourceDesc srcs[] = {
+            {
+                .NumVertices = 4,
+                .Positions = reinterpret_cast<const std::byte*>(vertices),
+                .PositionsStride = sizeof(vertices[0]),
+                .NumIndices = 3,
+                .IndicesStride = sizeof(uint16_t),
+                .Indices = reinterpret_cast<const std::byte*>(indices16),
+            },
+            {
+                .NumVertices = 4,
+                .Positions = reinterpret_cast<const std::byte*>(vertices),
+                .PositionsStride = sizeof(vertices[0]),
+                .NumIndices = 6,
+                .IndicesStride = sizeof(uint32_t),
+                .Indices = reinterpret_cast<const std::byte*>(indices32),
+            },
+        };
+
+        OccluderMesh mesh;
+        BuildOccluderMesh(mesh, srcs);
+        NEB_EXPECT(mesh.GetNumTriangles() == 3 && mesh.Positions.size() == 6, "{} triangles, {} positions", mesh.GetNumTriangles(), mesh.Positions.size());
+
+        const uint32_t expectedIndices[] = { 0, 1, 2, 3, 4, 5, 5, 4, 3 };
+        NEB_EXPECT(std::equal(mesh.Indices.begin(), mesh.Indices.end(), std::begin(expectedIndices), std::end(expectedIndices)));
+        NEB_EXPECT(mesh.Positions[2] == Vec3(0.0f, 1.0f, 0.0f) && mesh.Positions[3] == Vec3(0.0f, 1.0f, 0.0f));
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,105 @@
+#include "Test.h"
+
+#include "core/RadixSort.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Sorts keys with values of their indices and compares both against std::stable_sort
+        bool SortMatchesStableSort(RadixSorter& sorter, std::vector<uint64_t> keys, ThreadPool& threadPool)
+        {
+            std::vector<std::pair<uint64_t, uint32_t>> reference(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                reference[i] = std::make_pair(keys[i], uint32_t(i));
+            std::ranges::stable_sort(reference, {}, &std::pair<uint64_t, uint32_t>::first);
+
+            std::vector<uint32_t> values(keys.size());
+            std::iota(values.begin(), values.end(), 0);
+            sorter.Sort(keys, values, threadPool);
+            for (size_t i = 0; i < keys.size(); ++i)
+            {
+                if (keys[i] != reference[i].first || values[i] != reference[i].second)
+                    return false;
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    // Distributions hit every pass, only a few passes (mostly skipped ones) and long runs of equal keys, where stability matters.
+    // Sizes cover a single block, block boundaries and several blocks, both serially and on the thread pool
+    NEB_TEST(RadixSort, MatchesStableSort)
+    {
+        auto generators = std::to_array<uint64_t(*)(std::mt19937_64&, size_t)>({
+            [](std::mt19937_64& r, size_t) { return uint64_t(r()); },
+            [](std::mt19937_64& r, size_t) { return uint64_t(r() & 0xFF) << 40; },
+            [](std::mt19937_64& r, size_t) { return (uint64_t(r() % 4) << 60) | (r() & 0xFFF); },
+            [](std::mt19937_64&, size_t) { return uint64_t(0x0123456789ABCDEF); },
+            [](std::mt19937_64&, size_t i) { return UINT64_MAX - i; },
+            [](std::mt19937_64&, size_t i) { return uint64_t(i) << 16; },
+        });
+        const auto sizes = std::to_array<size_t>({ 0, 1, 2, 255, 256, 257, RadixSorter::MinBlockSize - 1, RadixSorter::MinBlockSize * 5 + 3, 1 << 18 });
+
+        std::mt19937_64 random(0x5047);
+        ThreadPool serialPool(0);
+        ThreadPool threadPool(3);
+        RadixSorter sorter; // shared, so that scratch memory of larger sorts is reused by smaller ones
+        for (size_t size : sizes)
+        {
+            for (size_t generatorIndex = 0; generatorIndex < generators.size(); ++generatorIndex)
+            {
+                for (ThreadPool* pool : { &serialPool, &threadPool })
+                {
+                    std::vector<uint64_t> keys(size);
+                    for (size_t i = 0; i < size; ++i)
+                        keys[i] = generators[generatorIndex](random, i);
+
+                    NEB_EXPECT(SortMatchesStableSort(sorter, std::move(keys), *pool), "{} keys of distribution {} on {} threads are not sorted",
+                        size, generatorIndex, pool->GetNumThreads());
+                }
+            }
+        }
+        return true;
+    }
+
+    // Passes of bytes that are the same in every key are skipped, in every block
+    NEB_TEST(RadixSort, SkipsConstantBytes)
+    {
+        std::mt19937_64 random(0x5047);
+        ThreadPool threadPool(3);
+        RadixSorter sorter;
+
+        auto countSkippedPasses = [&](uint64_t mask, uint64_t constantBits)
+            {
+                std::vector<uint64_t> keys(RadixSorter::MinBlockSize * 4);
+                for (uint64_t& key : keys)
+                    key = (random() & mask) | constantBits;
+                std::vector<uint32_t> values(keys.size());
+                sorter.Sort(keys, values, threadPool);
+                return std::ranges::is_sorted(keys) ? sorter.GetNumSkippedPasses() : UINT32_MAX;
+            };
+
+        NEB_EXPECT(countSkippedPasses(UINT64_MAX, 0) == 0);
+        NEB_EXPECT(countSkippedPasses(0, 0xABCD) == RadixSorter::NumPasses);
+        NEB_EXPECT(countSkippedPasses(0xFF0000, 0) == RadixSorter::NumPasses - 1);
+        NEB_EXPECT(countSkippedPasses(0xFFFF00000000FFFF, 0x0000123456780000) == RadixSorter::NumPasses - 4);
+
+        // A single differing bit in the last key is enough for its pass to run
+        std::vector<uint64_t> keys(RadixSorter::MinBlockSize * 4, 0x10);
+        keys.back() = 0x10 | (uint64_t(1) << 63);
+        std::vector<uint32_t> values(keys.size());
+        sorter.Sort(keys, values, threadPool);
+        NEB_EXPECT(sorter.GetNumSkippedPasses() == RadixSorter::NumPasses - 1 && std::ranges::is_sorted(keys));
+        return true;
+    }
+
+} // Neb::test namespace
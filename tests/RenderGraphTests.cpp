@@ -0,0 +1,453 @@
+#include "Test.h"
+
+#include "core/RenderGraph.h"
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <random>
+#include <span>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        using B = RenderGraphBarrier;
+        constexpr RenderGraphStates Srv = eRenderGraphState_NonPixelShaderResource;
+        constexpr RenderGraphStates PixelSrv = eRenderGraphState_PixelShaderResource;
+        constexpr RenderGraphStates Uav = eRenderGraphState_UnorderedAccess;
+        constexpr RenderGraphStates Rtv = eRenderGraphState_RenderTarget;
+        constexpr RenderGraphStates Dsv = eRenderGraphState_DepthWrite;
+        constexpr RenderGraphStates Common = eRenderGraphState_Common;
+        constexpr auto Read = eRenderGraphAccess_Read;
+        constexpr auto Write = eRenderGraphAccess_Write;
+        constexpr auto ReadWrite = eRenderGraphAccess_ReadWrite;
+        constexpr auto External = eRenderGraphResourceFlag_External;
+        constexpr auto SideEffects = eRenderGraphPassFlag_SideEffects;
+
+        bool ExpectBarriers(const RenderGraph& graph, uint32_t position, std::initializer_list<B> expected)
+        {
+            return std::ranges::equal(graph.GetBarriers(position), expected);
+        }
+
+        B UavBarrier(uint32_t resource)
+        {
+            return B{ .Resource = resource, .Type = eRenderGraphBarrier_UnorderedAccess };
+        }
+
+        struct ReplayResource
+        {
+            RenderGraphStates InitialState;
+            RenderGraphStates FinalState;
+            ERenderGraphResourceFlags Flags;
+        };
+
+        // Replays barriers and accesses of a compiled graph with the rules D3D12 has for resource states: accesses need their exact state
+        // (or a combination of read-only states that includes theirs), buffers are promoted from Common, unordered accesses after writes
+        // are separated by UAV barriers. Also checks that culled passes had no needed writes and that the order keeps every dependency
+        bool ReplayRenderGraph(const RenderGraph& graph, std::span<const ReplayResource> resources, std::span<const ERenderGraphPassFlags> passFlags, const RenderGraphCompileOptions& options)
+        {
+            const uint32_t numPasses = graph.GetNumPasses();
+            const uint32_t numExecuted = graph.GetNumExecutedPasses();
+
+            std::vector<RenderGraphStates> states(resources.size());
+            std::vector<uint8_t> isPromoted(resources.size(), false);
+            std::vector<uint8_t> wasUnorderedAccess(resources.size(), false);
+            std::vector<uint8_t> wasWritten(resources.size(), false);
+            for (size_t i = 0; i < resources.size(); ++i)
+                states[i] = resources[i].InitialState;
+
+            auto applyBarriers = [&](uint32_t position)
+                {
+                    for (const RenderGraphBarrier& barrier : graph.GetBarriers(position))
+                    {
+                        const uint32_t r = barrier.Resource;
+                        if (barrier.Type == eRenderGraphBarrier_UnorderedAccess)
+                        {
+                            if (states[r] != eRenderGraphState_UnorderedAccess)
+                                return false;
+
+                            wasUnorderedAccess[r] = false;
+                            continue;
+                        }
+
+                        if (barrier.StateBefore == barrier.StateAfter || states[r] != barrier.StateBefore)
+                            return false;
+
+                        states[r] = barrier.StateAfter;
+                        isPromoted[r] = false;
+                        wasUnorderedAccess[r] = false;
+                    }
+                    return true;
+                };
+
+            for (uint32_t position = 0; position < numExecuted; ++position)
+            {
+                if (!applyBarriers(position))
+                    return false;
+
+                const uint32_t pass = graph.GetExecutionOrder()[position];
+                for (const RenderGraphAccess& access : graph.GetAccesses(pass))
+                {
+                    const uint32_t r = access.Resource;
+                    const bool isWrite = access.Type != eRenderGraphAccess_Read;
+                    const bool isBuffer = (resources[r].Flags & eRenderGraphResourceFlag_Buffer) != 0;
+                    if (isBuffer && states[r] == eRenderGraphState_Common)
+                    {
+                        states[r] = access.State;
+                        isPromoted[r] = true;
+                    }
+                    else if (isBuffer && isPromoted[r] && IsReadOnlyRenderGraphState(states[r]) && IsReadOnlyRenderGraphState(access.State))
+                    {
+                        states[r] |= access.State;
+                    }
+                    else if (IsReadOnlyRenderGraphState(access.State))
+                    {
+                        if (!IsReadOnlyRenderGraphState(states[r]) || (states[r] & access.State) != access.State)
+                            return false;
+                    }
+                    else if (states[r] != access.State)
+                    {
+                        return false;
+                    }
+
+                    if (access.State == eRenderGraphState_UnorderedAccess)
+                    {
+                        if (wasUnorderedAccess[r] && (wasWritten[r] || isWrite))
+                            return false;
+
+                        wasUnorderedAccess[r] = true;
+                    }
+                    wasWritten[r] = isWrite;
+                }
+
+                if (!options.PassesAreSubmissions)
+                    continue;
+
+                for (const RenderGraphAccess& access : graph.GetAccesses(pass))
+                {
+                    if ((resources[access.Resource].Flags & eRenderGraphResourceFlag_Buffer) != 0)
+                    {
+                        states[access.Resource] = eRenderGraphState_Common;
+                        isPromoted[access.Resource] = false;
+                        wasUnorderedAccess[access.Resource] = false;
+                    }
+                }
+            }
+
+            if (!applyBarriers(numExecuted))
+                return false;
+
+            for (size_t i = 0; i < resources.size(); ++i)
+            {
+                const bool decays = (resources[i].Flags & eRenderGraphResourceFlag_Buffer) != 0 && resources[i].FinalState == eRenderGraphState_Common;
+                if (!decays && states[i] != resources[i].FinalState)
+                    return false;
+            }
+
+            // A write of a pass is needed if a later executed pass reads it before an executed pass overwrites it, or if it is never
+            // overwritten and the resource is external. Passes are culled exactly when none of their writes is needed
+            for (uint32_t pass = 0; pass < numPasses; ++pass)
+            {
+                bool isNeeded = (passFlags[pass] & eRenderGraphPassFlag_SideEffects) != 0;
+                for (const RenderGraphAccess& access : graph.GetAccesses(pass))
+                {
+                    if (access.Type == eRenderGraphAccess_Read)
+                        continue;
+
+                    bool isOverwritten = false;
+                    for (uint32_t later = pass + 1; later < numPasses && !isNeeded && !isOverwritten; ++later)
+                    {
+                        if (graph.IsPassCulled(later))
+                            continue;
+
+                        for (const RenderGraphAccess& laterAccess : graph.GetAccesses(later))
+                        {
+                            if (laterAccess.Resource != access.Resource)
+                                continue;
+
+                            isNeeded = laterAccess.Type != eRenderGraphAccess_Write;
+                            isOverwritten = !isNeeded;
+                        }
+                    }
+                    isNeeded = isNeeded || (!isOverwritten && (resources[access.Resource].Flags & eRenderGraphResourceFlag_External) != 0);
+                }
+
+                if (graph.IsPassCulled(pass) == isNeeded)
+                    return false;
+            }
+
+            // Executed accesses of a resource keep their order against every write, side effects keep theirs against each other
+            std::vector<uint32_t> writerPositions(resources.size(), RenderGraph::InvalidIndex);
+            std::vector<uint32_t> readerPositions(resources.size(), RenderGraph::InvalidIndex);
+            uint32_t sideEffectPosition = RenderGraph::InvalidIndex;
+            auto isAfter = [](uint32_t position, uint32_t other) { return other == RenderGraph::InvalidIndex || position > other; };
+            for (uint32_t pass = 0; pass < numPasses; ++pass)
+            {
+                const uint32_t position = graph.GetPassPosition(pass);
+                if (position == RenderGraph::InvalidIndex)
+                    continue;
+
+                if ((passFlags[pass] & eRenderGraphPassFlag_SideEffects) != 0)
+                {
+                    if (!isAfter(position, sideEffectPosition))
+                        return false;
+
+                    sideEffectPosition = position;
+                }
+
+                for (const RenderGraphAccess& access : graph.GetAccesses(pass))
+                {
+                    const uint32_t r = access.Resource;
+                    if (!isAfter(position, writerPositions[r]))
+                        return false;
+
+                    if (access.Type == eRenderGraphAccess_Read)
+                    {
+                        readerPositions[r] = (readerPositions[r] == RenderGraph::InvalidIndex) ? position : std::max(readerPositions[r], position);
+                        continue;
+                    }
+
+                    if (!isAfter(position, readerPositions[r]))
+                        return false;
+
+                    writerPositions[r] = position;
+                    readerPositions[r] = RenderGraph::InvalidIndex;
+                }
+            }
+            return true;
+        }
+
+        // Random graph of numPasses passes, that mostly touch resources written not long before them
+        void BuildRandomRenderGraph(RenderGraph& graph, std::vector<ReplayResource>& resources, std::vector<ERenderGraphPassFlags>& passFlags, uint32_t numPasses, std::mt19937_64& random)
+        {
+            static constexpr auto ReadStates = std::to_array<RenderGraphStates>({
+                eRenderGraphState_NonPixelShaderResource,
+                eRenderGraphState_PixelShaderResource,
+                eRenderGraphState_NonPixelShaderResource | eRenderGraphState_PixelShaderResource,
+                eRenderGraphState_DepthRead,
+                eRenderGraphState_CopySource,
+                eRenderGraphState_IndirectArgument,
+                eRenderGraphState_UnorderedAccess,
+                eRenderGraphState_Common,
+            });
+            static constexpr auto WriteStates = std::to_array<RenderGraphStates>({
+                eRenderGraphState_RenderTarget,
+                eRenderGraphState_UnorderedAccess,
+                eRenderGraphState_DepthWrite,
+                eRenderGraphState_CopyDest,
+                eRenderGraphState_Common,
+            });
+
+            graph.Reset();
+            resources.clear();
+            passFlags.clear();
+
+            const uint32_t numResources = std::max(8u, numPasses / 4);
+            for (uint32_t i = 0; i < numResources; ++i)
+            {
+                uint32_t flags = eRenderGraphResourceFlag_None;
+                flags |= (random() % 4 == 0) ? eRenderGraphResourceFlag_External : 0;
+                flags |= (random() % 4 == 0) ? eRenderGraphResourceFlag_Buffer : 0;
+                const RenderGraphStates initialState = (random() % 4 == 0) ? ReadStates[random() % ReadStates.size()] : eRenderGraphState_Common;
+                const RenderGraphStates finalState = (random() % 4 == 0) ? ReadStates[random() % ReadStates.size()] : eRenderGraphState_Common;
+
+                resources.push_back(ReplayResource{ .InitialState = initialState, .FinalState = finalState, .Flags = ERenderGraphResourceFlags(flags) });
+                graph.AddResource(initialState, finalState, ERenderGraphResourceFlags(flags));
+            }
+
+            std::array<RenderGraphAccess, 6> accesses;
+            for (uint32_t pass = 0; pass < numPasses; ++pass)
+            {
+                // Resources of a pass are distinct, mostly out of a window around the pass
+                const uint32_t windowFirst = std::min(pass / 4, numResources - 8);
+                const uint32_t numAccesses = 1 + uint32_t(random() % accesses.size());
+                uint32_t count = 0;
+                for (uint32_t i = 0; i < numAccesses; ++i)
+                {
+                    const uint32_t resource = (random() % 8 == 0) ? uint32_t(random() % numResources) : windowFirst + uint32_t(random() % 8);
+                    if (std::ranges::any_of(std::span(accesses).first(count), [resource](const RenderGraphAccess& a) { return a.Resource == resource; }))
+                        continue;
+
+                    const uint32_t kind = uint32_t(random() % 4);
+                    const ERenderGraphAccessType type = (kind < 2) ? eRenderGraphAccess_Read : (kind == 2 ? eRenderGraphAccess_Write : eRenderGraphAccess_ReadWrite);
+                    const RenderGraphStates state = (type == eRenderGraphAccess_Read) ? ReadStates[random() % ReadStates.size()] : WriteStates[random() % WriteStates.size()];
+                    accesses[count++] = RenderGraphAccess{ .Resource = resource, .State = state, .Type = type };
+                }
+
+                const ERenderGraphPassFlags flags = (random() % 8 == 0) ? eRenderGraphPassFlag_SideEffects : eRenderGraphPassFlag_None;
+                passFlags.push_back(flags);
+                graph.AddPass(std::span(accesses).first(count), flags);
+            }
+        }
+    } // anonymous namespace
+
+    // Frame of DeferredRenderer: G-buffers, a debug view nobody looks at, lighting, path tracing that accumulates into
+    // the lighting result and tonemapping into the backbuffer
+    NEB_TEST(RenderGraph, DeferredFrame)
+    {
+        RenderGraph graph;
+        const uint32_t albedo = graph.AddResource(Common, Common);
+        const uint32_t normals = graph.AddResource(Common, Common, External);
+        const uint32_t depth = graph.AddResource(Common, Common, External);
+        const uint32_t radiance = graph.AddResource(Common, Common);
+        const uint32_t backbuffer = graph.AddResource(Common, Common, External);
+        const uint32_t debug = graph.AddResource(Common, Common);
+
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { albedo, Rtv, Write }, { normals, Rtv, Write }, { depth, Dsv, Write } }));
+        const uint32_t debugPass = graph.AddPass(std::to_array<RenderGraphAccess>({ { albedo, PixelSrv, Read }, { debug, Rtv, Write } }));
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { albedo, Srv, Read }, { normals, Srv, Read }, { depth, Srv, Read }, { radiance, Uav, Write } }));
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { albedo, Srv, Read }, { normals, Srv, Read }, { depth, Srv, Read }, { radiance, Uav, ReadWrite } }), SideEffects);
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { radiance, PixelSrv, Read }, { backbuffer, Rtv, Write } }));
+        graph.Compile(RenderGraphCompileOptions());
+
+        NEB_EXPECT(graph.IsPassCulled(debugPass));
+        NEB_EXPECT(graph.GetNumExecutedPasses() == 4 && graph.GetStats().NumLevels == 4);
+        NEB_EXPECT(ExpectBarriers(graph, 0, { B{ albedo, Common, Rtv }, B{ normals, Common, Rtv }, B{ depth, Common, Dsv } }));
+        NEB_EXPECT(ExpectBarriers(graph, 1, { B{ albedo, Rtv, Srv }, B{ normals, Rtv, Srv }, B{ depth, Dsv, Srv }, B{ radiance, Common, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 2, { UavBarrier(radiance) }));
+        NEB_EXPECT(ExpectBarriers(graph, 3, { B{ radiance, Uav, PixelSrv }, B{ backbuffer, Common, Rtv } }));
+        NEB_EXPECT(ExpectBarriers(graph, 4, { B{ albedo, Srv, Common }, B{ normals, Srv, Common }, B{ depth, Srv, Common }, B{ radiance, PixelSrv, Common }, B{ backbuffer, Rtv, Common } }));
+        return true;
+    }
+
+    // SVGF of DeferredRenderer: temporal accumulation into the current radiance, then A-Trous steps that ping-pong between
+    // both radiance textures and end in the current one. Steps only swap the states of both, variance stays readable throughout
+    NEB_TEST(RenderGraph, DenoiserPingPong)
+    {
+        RenderGraph graph;
+        const uint32_t radiance = graph.AddResource(Common, Common, External);
+        const uint32_t history = graph.AddResource(Common, Common);
+        const uint32_t variance = graph.AddResource(Common, Common);
+        const uint32_t backbuffer = graph.AddResource(Common, Common, External);
+
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { history, Srv, Read }, { radiance, Uav, ReadWrite }, { variance, Uav, Write } }));
+        for (uint32_t step = 0; step < 4; ++step)
+        {
+            const uint32_t input = (step % 2 == 0) ? radiance : history;
+            const uint32_t output = (step % 2 == 0) ? history : radiance;
+            graph.AddPass(std::to_array<RenderGraphAccess>({ { input, Srv, Read }, { variance, Srv, Read }, { output, Uav, Write } }));
+        }
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { radiance, PixelSrv, Read }, { backbuffer, Rtv, Write } }));
+        graph.Compile(RenderGraphCompileOptions());
+
+        NEB_EXPECT(graph.GetNumExecutedPasses() == 6);
+        NEB_EXPECT(ExpectBarriers(graph, 0, { B{ history, Common, Srv }, B{ radiance, Common, Uav }, B{ variance, Common, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 1, { B{ radiance, Uav, Srv }, B{ variance, Uav, Srv }, B{ history, Srv, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 2, { B{ history, Uav, Srv }, B{ radiance, Srv, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 3, { B{ radiance, Uav, Srv }, B{ history, Srv, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 4, { B{ history, Uav, Srv }, B{ radiance, Srv, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 5, { B{ radiance, Uav, PixelSrv }, B{ backbuffer, Common, Rtv } }));
+        NEB_EXPECT(ExpectBarriers(graph, 6, { B{ radiance, PixelSrv, Common }, B{ history, Srv, Common }, B{ variance, Srv, Common }, B{ backbuffer, Rtv, Common } }));
+        NEB_EXPECT(graph.GetStats().NumUnorderedAccessBarriers == 0);
+        return true;
+    }
+
+    // Consecutive reads in different states are a single transition into all of them, unordered accesses wait for writes only
+    NEB_TEST(RenderGraph, CombinedReadsAndUavBarriers)
+    {
+        RenderGraph graph;
+        const uint32_t texture = graph.AddResource(Common, Common);
+        const uint32_t uav = graph.AddResource(Common, Common);
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { texture, Rtv, Write }, { uav, Uav, Write } }), SideEffects);
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { texture, Srv, Read }, { uav, Uav, ReadWrite } }), SideEffects);
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { texture, PixelSrv, Read }, { uav, Uav, Read } }), SideEffects);
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { texture, Srv, Read }, { uav, Uav, Read } }), SideEffects);
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { texture, Uav, Write } }), SideEffects);
+        graph.Compile(RenderGraphCompileOptions());
+
+        NEB_EXPECT(ExpectBarriers(graph, 0, { B{ texture, Common, Rtv }, B{ uav, Common, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 1, { B{ texture, Rtv, Srv | PixelSrv }, UavBarrier(uav) }));
+        NEB_EXPECT(ExpectBarriers(graph, 2, { UavBarrier(uav) }));
+        NEB_EXPECT(ExpectBarriers(graph, 3, {}));
+        NEB_EXPECT(ExpectBarriers(graph, 4, { B{ texture, Srv | PixelSrv, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 5, { B{ texture, Uav, Common }, B{ uav, Uav, Common } }));
+        NEB_EXPECT(graph.GetStats().NumSkippedTransitions == 2);
+        return true;
+    }
+
+    // Buffers are promoted from Common, and need no barriers at all when every pass is a submission of its own
+    NEB_TEST(RenderGraph, BuffersArePromoted)
+    {
+        RenderGraph graph;
+        for (bool submissions : { false, true })
+        {
+            graph.Reset();
+            const uint32_t buffer = graph.AddResource(Common, Common, ERenderGraphResourceFlags(External | eRenderGraphResourceFlag_Buffer));
+            graph.AddPass(std::to_array<RenderGraphAccess>({ { buffer, Srv, Read } }), SideEffects);
+            graph.AddPass(std::to_array<RenderGraphAccess>({ { buffer, eRenderGraphState_IndirectArgument, Read } }), SideEffects);
+            graph.AddPass(std::to_array<RenderGraphAccess>({ { buffer, Uav, Write } }));
+            graph.Compile(RenderGraphCompileOptions{ .PassesAreSubmissions = submissions });
+
+            const RenderGraphStats& stats = graph.GetStats();
+            if (submissions)
+            {
+                NEB_EXPECT(stats.NumTransitions == 0 && stats.NumSkippedTransitions == 3, "{} transitions, {} skipped", stats.NumTransitions, stats.NumSkippedTransitions);
+            }
+            else
+            {
+                NEB_EXPECT(ExpectBarriers(graph, 2, { B{ buffer, Srv | eRenderGraphState_IndirectArgument, Uav } }));
+                NEB_EXPECT(stats.NumTransitions == 1);
+            }
+        }
+        return true;
+    }
+
+    // Overwritten results are culled together with passes that only they feed, independent passes share a level and its barriers
+    NEB_TEST(RenderGraph, CullingAndLevels)
+    {
+        RenderGraph graph;
+        const uint32_t a = graph.AddResource(Common, Common);
+        const uint32_t b = graph.AddResource(Common, Common);
+        const uint32_t c = graph.AddResource(Common, Common, External);
+        const uint32_t d = graph.AddResource(Common, Common, External);
+        const uint32_t unused = graph.AddResource(Common, Common);
+        const uint32_t overwritten = graph.AddPass(std::to_array<RenderGraphAccess>({ { a, Uav, Write } }));
+        const uint32_t feedsUnused = graph.AddPass(std::to_array<RenderGraphAccess>({ { a, Srv, Read }, { unused, Rtv, Write } }));
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { a, Uav, Write } }));
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { a, Srv, Read }, { c, Rtv, Write } }));
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { b, Uav, Write } }));
+        graph.AddPass(std::to_array<RenderGraphAccess>({ { b, Srv, Read }, { d, Rtv, Write } }));
+        graph.Compile(RenderGraphCompileOptions{ .ReorderPasses = true });
+
+        NEB_EXPECT(graph.IsPassCulled(overwritten) && graph.IsPassCulled(feedsUnused));
+        NEB_EXPECT(std::ranges::equal(graph.GetExecutionOrder(), std::to_array<uint32_t>({ 2, 4, 3, 5 })));
+        NEB_EXPECT(ExpectBarriers(graph, 0, { B{ a, Common, Uav }, B{ b, Common, Uav } }));
+        NEB_EXPECT(ExpectBarriers(graph, 1, {}));
+        NEB_EXPECT(ExpectBarriers(graph, 2, { B{ a, Uav, Srv }, B{ c, Common, Rtv }, B{ b, Uav, Srv }, B{ d, Common, Rtv } }));
+        NEB_EXPECT(ExpectBarriers(graph, 3, {}));
+        NEB_EXPECT(ExpectBarriers(graph, 4, { B{ a, Srv, Common }, B{ b, Srv, Common }, B{ c, Rtv, Common }, B{ d, Rtv, Common } }));
+        NEB_EXPECT(graph.GetStats().NumBarrierBatches == 3 && graph.GetStats().NumLevels == 2);
+        return true;
+    }
+
+    // Random graphs are replayed with every combination of options
+    NEB_TEST(RenderGraph, RandomGraphsReplay)
+    {
+        RenderGraph graph;
+        std::mt19937_64 random(0x26A);
+        std::vector<ReplayResource> resources;
+        std::vector<ERenderGraphPassFlags> passFlags;
+        for (uint32_t size : { 1u, 2u, 16u, 100u, 500u })
+        {
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                BuildRandomRenderGraph(graph, resources, passFlags, size, random);
+                for (uint32_t options = 0; options < 4; ++options)
+                {
+                    const RenderGraphCompileOptions compileOptions = RenderGraphCompileOptions{
+                        .ReorderPasses = (options & 1) != 0,
+                        .PassesAreSubmissions = (options & 2) != 0,
+                    };
+                    graph.Compile(compileOptions);
+                    NEB_EXPECT(ReplayRenderGraph(graph, resources, passFlags, compileOptions), "{} passes, reorder {}, submissions {}",
+                        size, compileOptions.ReorderPasses, compileOptions.PassesAreSubmissions);
+                }
+            }
+        }
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,199 @@
+#include "Test.h"
+
+#include "core/SceneGraph.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <random>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        SceneNodeTransform GenerateTransform(std::mt19937_64& random)
+        {
+            std::uniform_real_distribution<float> unitDistribution(-1.0f, 1.0f);
+            std::uniform_real_distribution<float> scaleDistribution(0.9f, 1.1f);
+
+            Vec3 axis = Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random));
+            axis = (axis.LengthSquared() > 1e-6f) ? axis : Vec3::UnitY;
+            axis.Normalize();
+
+            return SceneNodeTransform{
+                .Translation = Vec3(unitDistribution(random), unitDistribution(random), unitDistribution(random)) * 10.0f,
+                .Rotation = Quaternion::CreateFromAxisAngle(axis, unitDistribution(random) * std::numbers::pi_v<float>),
+                .Scale = Vec3(scaleDistribution(random), scaleDistribution(random), scaleDistribution(random)),
+            };
+        }
+
+        // Random pre-order hierarchy. Each node is either a child of the last node or of one of its close ancestors,
+        // which climbs up a bit faster than it descends, thus depth stays reasonable while subtrees are nested
+        void BuildRandomGraph(SceneGraph& graph, uint32_t numNodes, std::mt19937_64& random)
+        {
+            graph.Reserve(numNodes);
+            uint32_t lastNode = SceneGraphInvalidNode;
+            for (uint32_t i = 0; i < numNodes; ++i)
+            {
+                uint32_t parentIndex = lastNode;
+                const uint32_t numLevelsUp = static_cast<uint32_t>(random() % 4);
+                for (uint32_t level = 0; level < numLevelsUp && parentIndex != SceneGraphInvalidNode; ++level)
+                    parentIndex = graph.GetParent(parentIndex);
+
+                lastNode = graph.AddNode(parentIndex, GenerateTransform(random));
+            }
+        }
+
+        bool IsNearlyEqual(const Mat4& lhs, const Mat4& rhs, float tolerance)
+        {
+            const float* a = &lhs._11;
+            const float* b = &rhs._11;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (!(std::abs(a[i] - b[i]) <= tolerance))
+                    return false;
+            }
+            return true;
+        }
+
+        // World matrix of every node matches the composition of local matrices along its parent chain, which does not rely
+        // on any other world matrix. The graph should be updated
+        bool CheckSceneGraph(const SceneGraph& graph)
+        {
+            NEB_EXPECT(!graph.IsDirty());
+
+            for (uint32_t nodeIndex = 0; nodeIndex < graph.GetNumNodes(); ++nodeIndex)
+            {
+                Mat4 reference = Mat4::Identity;
+                uint32_t depth = 0;
+                for (uint32_t i = nodeIndex; i != SceneGraphInvalidNode; i = graph.GetParent(i), ++depth)
+                {
+                    const SceneNodeTransform local = graph.GetLocalTransform(i);
+                    reference = reference * Mat4::CreateScale(local.Scale) * Mat4::CreateFromQuaternion(local.Rotation) * Mat4::CreateTranslation(local.Translation);
+                }
+
+                // Precision is lost with each level, relative to the magnitude of the matrix
+                float magnitude = 1.0f;
+                for (uint32_t i = 0; i < 16; ++i)
+                    magnitude = std::max(magnitude, std::abs((&reference._11)[i]));
+
+                const float tolerance = 1e-5f * static_cast<float>(depth + 1) * magnitude;
+                NEB_EXPECT(IsNearlyEqual(graph.GetWorldMatrix(nodeIndex), reference, tolerance),
+                    "world matrix of node {} (depth {}) does not match its parent chain", nodeIndex, depth);
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    // Composition is the same as the matrix product of glTF order, decomposition of TRS matrices round-trips and sheared ones are rejected
+    NEB_TEST(SceneGraph, ComposeAndDecompose)
+    {
+        std::mt19937_64 random(0x5CE9E);
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            const SceneNodeTransform transform = GenerateTransform(random);
+            const Mat4 composed = ComposeSceneNodeTransform(transform.Translation, transform.Rotation, transform.Scale);
+            const Mat4 reference = Mat4::CreateScale(transform.Scale) * Mat4::CreateFromQuaternion(transform.Rotation) * Mat4::CreateTranslation(transform.Translation);
+            NEB_EXPECT(IsNearlyEqual(composed, reference, 1e-4f), "composition of transform {} differs from the matrix product", i);
+
+            SceneNodeTransform decomposed;
+            NEB_EXPECT(DecomposeSceneNodeTransform(composed, decomposed), "transform {} is not decomposed", i);
+            NEB_EXPECT(IsNearlyEqual(ComposeSceneNodeTransform(decomposed.Translation, decomposed.Rotation, decomposed.Scale), composed, 1e-4f));
+        }
+
+        Mat4 sheared = Mat4::Identity;
+        sheared._21 = 0.5f;
+        SceneNodeTransform transform;
+        NEB_EXPECT(!DecomposeSceneNodeTransform(sheared, transform));
+        return true;
+    }
+
+    // Nodes are in pre-order, every subtree is contiguous
+    NEB_TEST(SceneGraph, Subtrees)
+    {
+        // 0
+        // |- 1
+        // |  |- 2
+        // |  |- 3
+        // |- 4
+        // 5
+        SceneGraph graph;
+        NEB_EXPECT(graph.AddNode(SceneGraphInvalidNode, SceneNodeTransform{}) == 0);
+        NEB_EXPECT(graph.AddNode(0, SceneNodeTransform{}) == 1);
+        NEB_EXPECT(graph.AddNode(1, SceneNodeTransform{}) == 2);
+        NEB_EXPECT(graph.AddNode(1, SceneNodeTransform{}) == 3);
+        NEB_EXPECT(graph.AddNode(0, SceneNodeTransform{}) == 4);
+        NEB_EXPECT(graph.AddNode(SceneGraphInvalidNode, SceneNodeTransform{}) == 5);
+
+        const uint32_t expectedParents[] = { SceneGraphInvalidNode, 0, 1, 1, 0, SceneGraphInvalidNode };
+        const uint32_t expectedSubtreeSizes[] = { 5, 3, 1, 1, 1, 1 };
+        for (uint32_t i = 0; i < graph.GetNumNodes(); ++i)
+        {
+            NEB_EXPECT(graph.GetParent(i) == expectedParents[i], "parent of node {} is {}", i, graph.GetParent(i));
+            NEB_EXPECT(graph.GetSubtreeSize(i) == expectedSubtreeSizes[i], "subtree of node {} is of {} nodes", i, graph.GetSubtreeSize(i));
+        }
+        return true;
+    }
+
+    // Only dirty subtrees are recomputed, each node once even if both it and its ancestor are dirty
+    NEB_TEST(SceneGraph, IncrementalUpdates)
+    {
+        SceneGraph graph;
+        graph.AddNode(SceneGraphInvalidNode, SceneNodeTransform{ .Translation = Vec3(1.0f, 0.0f, 0.0f) });
+        graph.AddNode(0, SceneNodeTransform{ .Translation = Vec3(0.0f, 2.0f, 0.0f) });
+        graph.AddNode(1, SceneNodeTransform{ .Scale = Vec3(3.0f) });
+        graph.AddNode(1, SceneNodeTransform{});
+        graph.AddNode(0, SceneNodeTransform{});
+        graph.AddNode(SceneGraphInvalidNode, SceneNodeTransform{});
+
+        NEB_EXPECT(graph.UpdateWorldMatrices() == 6);
+        NEB_EXPECT(!graph.IsDirty() && CheckSceneGraph(graph));
+        NEB_EXPECT(graph.UpdateWorldMatrices() == 0);
+
+        const Mat4& world = graph.GetWorldMatrix(2);
+        NEB_EXPECT(std::abs(world._41 - 1.0f) < 1e-6f && std::abs(world._42 - 2.0f) < 1e-6f && std::abs(world._11 - 3.0f) < 1e-6f);
+
+        graph.SetLocalTranslation(1, Vec3(0.0f, 5.0f, 0.0f));
+        graph.SetLocalScale(2, Vec3(2.0f));
+        NEB_EXPECT(graph.GetNumDirtyNodes() == 2);
+        NEB_EXPECT(graph.UpdateWorldMatrices() == 3, "subtree of node 1 should be recomputed once");
+        NEB_EXPECT(CheckSceneGraph(graph));
+        NEB_EXPECT(std::abs(graph.GetWorldMatrix(3)._42 - 5.0f) < 1e-6f);
+
+        graph.SetLocalRotation(5, Quaternion::CreateFromAxisAngle(Vec3::UnitY, 1.0f));
+        NEB_EXPECT(graph.UpdateWorldMatrices() == 1);
+        NEB_EXPECT(CheckSceneGraph(graph));
+        return true;
+    }
+
+    // Serial and parallel updates of random hierarchies match composition along parent chains, small tasks split subtrees between threads
+    NEB_TEST(SceneGraph, RandomUpdates)
+    {
+        static constexpr uint32_t NumNodes = 50'000;
+
+        ThreadPool threadPool(3);
+        for (uint64_t seed = 0; seed < 4; ++seed)
+        {
+            std::mt19937_64 random(seed);
+            SceneGraph graph;
+            BuildRandomGraph(graph, NumNodes, random);
+            NEB_EXPECT(graph.UpdateWorldMatrices() == NumNodes);
+            NEB_EXPECT(CheckSceneGraph(graph), "full update with seed {} is invalid", seed);
+
+            for (uint32_t minNodesPerTask : { 0u, 64u, 4096u })
+            {
+                for (uint32_t i = 0; i < NumNodes / 100; ++i)
+                    graph.SetLocalTransform(static_cast<uint32_t>(random() % NumNodes), GenerateTransform(random));
+
+                const uint32_t numDirtyNodes = graph.GetNumDirtyNodes();
+                const uint32_t numUpdatedNodes = (minNodesPerTask == 0) ? graph.UpdateWorldMatrices() : graph.UpdateWorldMatricesParallel(threadPool, minNodesPerTask);
+                NEB_EXPECT(numUpdatedNodes >= numDirtyNodes && numUpdatedNodes <= NumNodes);
+                NEB_EXPECT(CheckSceneGraph(graph), "update with seed {} and tasks of {} nodes is invalid", seed, minNodesPerTask);
+            }
+        }
+        return true;
+    }
+
+} // Neb::test namespace
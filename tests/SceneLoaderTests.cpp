@@ -0,0 +1,100 @@
+#include "Test.h"
+#include "TestScene.h"
+
+#include "common/TimeWatch.h"
+#include "core/SceneLoader.h"
+#include "util/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        using MillisecondsF32 = std::chrono::duration<float, std::milli>;
+
+        // Half of a frame at 60 Hz. Ticks of the stub loop take well under a millisecond unless something blocks them
+        static constexpr float MaxTickMilliseconds = 8.0f;
+        static constexpr float MaxLoadMilliseconds = 120'000.0f;
+
+        std::filesystem::path GetWorkingDirectory()
+        {
+            return std::filesystem::temp_directory_path() / "NebulaeGpuTests";
+        }
+
+        // Stands for the CPU work of Nebulae::Render(), culling and sorting jobs on the shared pool
+        void RunFrameJobs(ThreadPool& threadPool)
+        {
+            std::atomic<uint32_t> checksum = 0;
+            threadPool.ParallelFor(64, [&checksum](size_t i)
+                {
+                    float value = float(i);
+                    for (uint32_t j = 0; j < 256; ++j)
+                        value = std::sqrt(value + float(j));
+                    checksum.fetch_add(static_cast<uint32_t>(value), std::memory_order_relaxed);
+                });
+        }
+    } // anonymous namespace
+
+    // Render thread polls the loader once per tick the way Nebulae::Render() does. No tick should block while the scene is loading,
+    // neither on the loader nor on jobs of the shared pool, that the load would otherwise queue in front of frame jobs
+    NEB_TEST(SceneLoader, TicksDoNotBlockWhileLoading)
+    {
+        const std::filesystem::path filepath = WriteTestScene(GetWorkingDirectory(), TestSceneDesc{ .NumMeshes = 16, .NumGridVertices = 128, .NumTextures = 32, .TextureSize = 1024 });
+
+        SceneLoader loader;
+        TimeWatch loadWatch;
+        loadWatch.Begin();
+        loader.RequestLoad(filepath);
+        NEB_EXPECT(loader.IsLoading());
+
+        Scoped<LoadedScene> loadedScene;
+        uint32_t numTicks = 0;
+        float maxTickMilliseconds = 0.0f;
+        while (loader.IsLoading() && loadWatch.Elapsed<MillisecondsF32>().count() < MaxLoadMilliseconds)
+        {
+            TimeWatch tickWatch;
+            tickWatch.Begin();
+            if (!loadedScene.IsValid())
+                loadedScene = loader.TakeLoaded();
+            RunFrameJobs(ThreadPool::Get());
+
+            const float tickMilliseconds = tickWatch.Elapsed<MillisecondsF32>().count();
+            maxTickMilliseconds = std::max(maxTickMilliseconds, tickMilliseconds);
+            ++numTicks;
+            NEB_EXPECT(tickMilliseconds < MaxTickMilliseconds, "tick {} took {:.2f}ms while loading", numTicks, tickMilliseconds);
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        NEB_EXPECT(!loader.IsLoading(), "scene is still loading after {:.0f}ms", MaxLoadMilliseconds);
+
+        // Scene might have been published after the last tick
+        if (!loadedScene.IsValid())
+            loadedScene = loader.TakeLoaded();
+        NEB_EXPECT(loadedScene.IsValid() && loader.GetNumFailedLoads() == 0);
+        NEB_EXPECT(loadedScene->GetScene()->StaticMeshes.size() == 16, "{} meshes", loadedScene->GetScene()->StaticMeshes.size());
+
+        NEB_LOG_INFO("SceneLoader.TicksDoNotBlockWhileLoading -> loaded in {:.1f}ms, {} ticks, longest tick {:.3f}ms",
+            loadedScene->LoadMilliseconds, numTicks, maxTickMilliseconds);
+        return true;
+    }
+
+    // Failed loads are counted and never published
+    NEB_TEST(SceneLoader, MissingFile)
+    {
+        SceneLoader loader;
+        loader.RequestLoad(GetWorkingDirectory() / "missing" / "scene.gltf");
+        while (loader.IsLoading())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        NEB_EXPECT(loader.GetNumFailedLoads() == 1);
+        NEB_EXPECT(!loader.TakeLoaded().IsValid());
+        return true;
+    }
+
+} // Neb::test namespace
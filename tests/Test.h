@@ -0,0 +1,63 @@
+#pragma once
+
+#include "common/Log.h"
+
+#include <format>
+#include <string_view>
+#include <vector>
+
+namespace Neb::test
+{
+
+    // Test returns false on the first failed expectation, see NEB_EXPECT
+    using TestFunction = bool (*)();
+
+    struct TestCase
+    {
+        std::string_view Suite; // every suite is a separate CTest test, see tests/CMakeLists.txt
+        std::string_view Name;
+        TestFunction Function = nullptr;
+    };
+
+    std::vector<TestCase>& GetTestCases();
+
+    struct TestRegistration
+    {
+        TestRegistration(std::string_view suite, std::string_view name, TestFunction function)
+        {
+            GetTestCases().push_back(TestCase{ .Suite = suite, .Name = name, .Function = function });
+        }
+    };
+
+} // Neb::test namespace
+
+namespace Neb::test::detail
+{
+
+    template<typename... Args>
+    inline void ExpectPrint(std::string_view payload, std::string_view expr, const std::format_string<Args...> fmt, Args&&... args)
+    {
+        NEB_LOG_ERROR("Expectation at {} failed: {} ({})", payload, expr, std::format(fmt, std::forward<Args>(args)...));
+    }
+
+    inline void ExpectPrint(std::string_view payload, std::string_view expr)
+    {
+        NEB_LOG_ERROR("Expectation at {} failed: {}", payload, expr);
+    }
+
+} // Neb::test::detail namespace
+
+#define NEB_TEST(suite, name)                                                                                   \
+    static bool NebTest_##suite##_##name();                                                                     \
+    static const Neb::test::TestRegistration s_nebTest_##suite##_##name(#suite, #name, &NebTest_##suite##_##name); \
+    static bool NebTest_##suite##_##name()
+
+// Logs the failed expression with an optional message and fails the test
+#define NEB_EXPECT(expr, ...)                                                                                   \
+    do                                                                                                          \
+        if (!(expr))                                                                                            \
+        {                                                                                                       \
+            Neb::test::detail::ExpectPrint(std::format("{}:{}", __FILE__, __LINE__), #expr, ##__VA_ARGS__);      \
+            return false;                                                                                       \
+        }                                                                                                       \
+    while (false)
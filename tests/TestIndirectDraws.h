@@ -0,0 +1,61 @@
+#pragma once
+
+#include "core/FrustumCulling.h"
+#include "nri/IndirectDraw.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace Neb::test
+{
+
+    // Random records of draws around the camera of GetIndirectDrawFrustum(), every 89th of them is of an empty box.
+    // Views of geometries are random bytes, they are only copied into arguments
+    struct IndirectDrawScene
+    {
+        IndirectDrawScene(uint32_t numRecords, uint64_t seed)
+        {
+            std::mt19937_64 random(seed);
+            std::uniform_real_distribution<float> positionDistribution(-150.0f, 150.0f);
+            std::uniform_real_distribution<float> extentDistribution(0.1f, 5.0f);
+
+            Geometries.resize(97);
+            for (nri::IndirectGeometry& geometry : Geometries)
+            {
+                for (D3D12_VERTEX_BUFFER_VIEW& view : geometry.VertexViews)
+                    view = D3D12_VERTEX_BUFFER_VIEW{ .BufferLocation = random(), .SizeInBytes = static_cast<UINT>(random()), .StrideInBytes = static_cast<UINT>(random()) };
+                geometry.IndexView = D3D12_INDEX_BUFFER_VIEW{ .BufferLocation = random(), .SizeInBytes = static_cast<UINT>(random()), .Format = DXGI_FORMAT_R32_UINT };
+            }
+
+            Records.resize(numRecords);
+            for (uint32_t i = 0; i < numRecords; ++i)
+            {
+                const Vec3 center = Vec3(positionDistribution(random), positionDistribution(random), positionDistribution(random));
+                const Vec3 extent = Vec3(extentDistribution(random), extentDistribution(random), extentDistribution(random));
+                const AABB box = (i % 89 == 0) ? AABB() : AABB{ .min = center - extent, .max = center + extent };
+                Records[i] = nri::IndirectDrawRecord{
+                    .BoxMin = box.min,
+                    .NumIndices = static_cast<uint32_t>(random() % 30000) * 3,
+                    .BoxMax = box.max,
+                    .InstanceIndex = i,
+                    .GeometryIndex = static_cast<uint32_t>(random() % Geometries.size()),
+                    .MaterialIndex = static_cast<uint32_t>(random() % 4096) * 3,
+                    .StreamIndex = static_cast<uint32_t>(random() % nri::NumIndirectDrawStreams),
+                };
+            }
+        }
+
+        std::vector<nri::IndirectGeometry> Geometries;
+        std::vector<nri::IndirectDrawRecord> Records;
+    };
+
+    // Same camera setup as in DeferredRenderer, looking down -Z
+    inline Frustum GetIndirectDrawFrustum()
+    {
+        const Mat4 viewProj = Mat4::CreateLookAt(Vec3(0.0f), Vec3(0.0f, 0.0f, -1.0f), Vec3::UnitY) *
+            Mat4::CreatePerspectiveFieldOfView(ToRadians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        return ExtractFrustum(viewProj);
+    }
+
+} // Neb::test namespace
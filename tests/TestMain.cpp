@@ -0,0 +1,69 @@
+#include "Test.h"
+
+#include "ArgumentParser.h"
+
+#if defined(NEB_TEST_DEVICE)
+#include "common/Configuration.h"
+#include "nri/Device.h"
+#endif
+
+#include <exception>
+
+namespace Neb::test
+{
+
+    std::vector<TestCase>& GetTestCases()
+    {
+        static std::vector<TestCase> testCases;
+        return testCases;
+    }
+
+} // Neb::test namespace
+
+// NebulaeTests (or NebulaeGpuTests) [--suite=<name>], runs every suite if none is given
+int32_t main(int argc, char* argv[])
+{
+    Neb::ArgumentParser argParser(argc, argv);
+    const std::string_view suite = argParser.Get<std::string_view>(/*key*/ "suite", /*default-value*/ "");
+
+#if defined(NEB_TEST_DEVICE)
+    // Suites of NebulaeGpuTests measure release paths (e.g. how long a frame blocks), debug layers would dominate the numbers
+    Neb::Config::SetValue(Neb::EConfigKey::EnableDebugLayer,        false);
+    Neb::Config::SetValue(Neb::EConfigKey::EnableGpuValidation,     false);
+    Neb::Config::SetValue(Neb::EConfigKey::EnableDeviceDebugging,   false);
+    Neb::Config::SetValue(Neb::EConfigKey::EnableNvDriver,          false);
+    Neb::nri::NRIDevice::Get().Init();
+#endif
+
+    uint32_t numTests = 0;
+    uint32_t numFailed = 0;
+    for (const Neb::test::TestCase& testCase : Neb::test::GetTestCases())
+    {
+        if (!suite.empty() && testCase.Suite != suite)
+            continue;
+
+        bool isPassed = false;
+        try
+        {
+            isPassed = testCase.Function();
+        }
+        catch (const std::exception& exception)
+        {
+            NEB_LOG_ERROR("NebulaeTests -> {}.{} threw: {}", testCase.Suite, testCase.Name, exception.what());
+        }
+
+        ++numTests;
+        if (!isPassed)
+        {
+            NEB_LOG_ERROR("NebulaeTests -> {}.{} failed", testCase.Suite, testCase.Name);
+            ++numFailed;
+        }
+    }
+
+#if defined(NEB_TEST_DEVICE)
+    Neb::nri::NRIDevice::Get().Deinit();
+#endif
+
+    NEB_LOG_INFO("NebulaeTests -> {} of {} tests passed", numTests - numFailed, numTests);
+    return (numTests > 0 && numFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Neb::test
+{
+
+    // Interleaved position, normal and uv of a grid in XZ, that is bent along x so that normals vary. u grows along +x and
+    // v along +z, triangles are CCW when looking from +y
+    struct GridMesh
+    {
+        static constexpr uint32_t VertexStride = sizeof(float) * 8;
+
+        GridMesh(uint32_t numVerticesPerSide, float bend)
+            : NumVertices(numVerticesPerSide * numVerticesPerSide)
+        {
+            Vertices.reserve(size_t(NumVertices) * 8);
+            for (uint32_t z = 0; z < numVerticesPerSide; ++z)
+            {
+                for (uint32_t x = 0; x < numVerticesPerSide; ++x)
+                {
+                    const float u = float(x) / float(numVerticesPerSide - 1);
+                    const float v = float(z) / float(numVerticesPerSide - 1);
+                    const float angle = bend * (u - 0.5f);
+                    Vertices.insert(Vertices.end(), {
+                        u - 0.5f, bend * u * u, v - 0.5f,
+                        -std::sin(angle), std::cos(angle), 0.0f,
+                        u, v });
+                }
+            }
+
+            for (uint32_t z = 0; z + 1 < numVerticesPerSide; ++z)
+            {
+                for (uint32_t x = 0; x + 1 < numVerticesPerSide; ++x)
+                {
+                    const uint32_t i = z * numVerticesPerSide + x;
+                    Indices.insert(Indices.end(), { i, i + numVerticesPerSide, i + 1, i + 1, i + numVerticesPerSide, i + numVerticesPerSide + 1 });
+                }
+            }
+
+            Indices16.assign(Indices.begin(), Indices.end());
+        }
+
+        const std::byte* GetPositions() const { return reinterpret_cast<const std::byte*>(Vertices.data()); }
+        const std::byte* GetNormals() const { return GetPositions() + sizeof(float) * 3; }
+        const std::byte* GetTexCoords() const { return GetPositions() + sizeof(float) * 6; }
+        const std::byte* GetIndices(bool use16BitIndices) const
+        {
+            return use16BitIndices ? reinterpret_cast<const std::byte*>(Indices16.data()) : reinterpret_cast<const std::byte*>(Indices.data());
+        }
+
+        uint32_t NumVertices = 0;
+        std::vector<float> Vertices;
+        std::vector<uint32_t> Indices;
+        std::vector<uint16_t> Indices16; // only valid for grids of less than 65536 vertices
+    };
+
+} // Neb::test namespace
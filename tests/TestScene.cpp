@@ -0,0 +1,153 @@
+#include "TestScene.h"
+
+#include "core/SceneCache.h"
+
+#include <TinyGLTF/tiny_gltf.h>
+#include <TinyGLTF/stb_image_write.h>
+
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Appends the elements to the single buffer of the scene and returns their accessor
+        template<typename T>
+        int32_t AddAccessor(tinygltf::Model& model, const std::vector<T>& elements, int32_t componentType, int32_t type)
+        {
+            tinygltf::Buffer& buffer = model.buffers.front();
+            const size_t byteOffset = buffer.data.size();
+            buffer.data.resize(byteOffset + elements.size() * sizeof(T));
+            std::memcpy(buffer.data.data() + byteOffset, elements.data(), elements.size() * sizeof(T));
+
+            tinygltf::BufferView& bufferView = model.bufferViews.emplace_back();
+            bufferView.buffer = 0;
+            bufferView.byteOffset = byteOffset;
+            bufferView.byteLength = elements.size() * sizeof(T);
+
+            tinygltf::Accessor& accessor = model.accessors.emplace_back();
+            accessor.bufferView = static_cast<int32_t>(model.bufferViews.size() - 1);
+            accessor.componentType = componentType;
+            accessor.type = type;
+            accessor.count = type == TINYGLTF_TYPE_SCALAR ? elements.size() : elements.size() / tinygltf::GetNumComponentsInType(type);
+            return static_cast<int32_t>(model.accessors.size() - 1);
+        }
+
+        void AddGridMesh(tinygltf::Model& model, uint32_t numGridVertices, int32_t materialIndex)
+        {
+            std::vector<float> positions, normals, texCoords;
+            for (uint32_t z = 0; z < numGridVertices; ++z)
+            {
+                for (uint32_t x = 0; x < numGridVertices; ++x)
+                {
+                    const float u = float(x) / float(numGridVertices - 1);
+                    const float v = float(z) / float(numGridVertices - 1);
+                    positions.insert(positions.end(), { u - 0.5f, 0.0f, v - 0.5f });
+                    normals.insert(normals.end(), { 0.0f, 1.0f, 0.0f });
+                    texCoords.insert(texCoords.end(), { u, v });
+                }
+            }
+
+            std::vector<uint32_t> indices;
+            for (uint32_t z = 0; z + 1 < numGridVertices; ++z)
+            {
+                for (uint32_t x = 0; x + 1 < numGridVertices; ++x)
+                {
+                    const uint32_t i = z * numGridVertices + x;
+                    indices.insert(indices.end(), { i, i + numGridVertices, i + 1, i + 1, i + numGridVertices, i + numGridVertices + 1 });
+                }
+            }
+
+            tinygltf::Primitive primitive;
+            primitive.mode = TINYGLTF_MODE_TRIANGLES;
+            primitive.material = materialIndex;
+            primitive.attributes["POSITION"] = AddAccessor(model, positions, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3);
+            primitive.attributes["NORMAL"] = AddAccessor(model, normals, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3);
+            primitive.attributes["TEXCOORD_0"] = AddAccessor(model, texCoords, TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC2);
+            primitive.indices = AddAccessor(model, indices, TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT, TINYGLTF_TYPE_SCALAR);
+
+            tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes["POSITION"]];
+            positionAccessor.minValues = { -0.5, 0.0, -0.5 };
+            positionAccessor.maxValues = { 0.5, 0.0, 0.5 };
+
+            model.meshes.emplace_back().primitives.push_back(std::move(primitive));
+        }
+
+        // Noise, so that decoding, mips and compression of every texture have some work to do
+        bool WriteTexture(const std::filesystem::path& filepath, uint32_t textureIndex, uint32_t size)
+        {
+            std::vector<uint8_t> texels(size_t(size) * size * 4);
+            uint32_t state = 0x9E3779B9u * (textureIndex + 1);
+            for (size_t i = 0; i < texels.size(); i += 4)
+            {
+                state ^= state << 13;
+                state ^= state >> 17;
+                state ^= state << 5;
+
+                texels[i + 0] = static_cast<uint8_t>(state & 0xff);
+                texels[i + 1] = static_cast<uint8_t>((state >> 8) & 0xff);
+                texels[i + 2] = static_cast<uint8_t>((state >> 16) & 0xff);
+                texels[i + 3] = 255;
+            }
+            return stbi_write_png(filepath.string().c_str(), int(size), int(size), 4, texels.data(), int(size * 4)) != 0;
+        }
+    } // anonymous namespace
+
+    std::filesystem::path WriteTestScene(const std::filesystem::path& workingDirectory, const TestSceneDesc& desc)
+    {
+        const std::filesystem::path directory = workingDirectory / std::format("scene_m{}_g{}_t{}x{}",
+            desc.NumMeshes, desc.NumGridVertices, desc.NumTextures, desc.TextureSize);
+        const std::filesystem::path filepath = directory / "scene.gltf";
+        if (std::filesystem::exists(filepath))
+        {
+            std::error_code error;
+            std::filesystem::remove(GetSceneCachePath(filepath), error);
+            return filepath;
+        }
+
+        std::filesystem::create_directories(directory);
+
+        tinygltf::Model model;
+        model.asset.version = "2.0";
+        model.asset.generator = "NebulaeGpuTests";
+        model.buffers.emplace_back().uri = "scene.bin";
+
+        for (uint32_t i = 0; i < desc.NumTextures; ++i)
+        {
+            const std::string uri = std::format("base_color_{}.png", i);
+            if (!WriteTexture(directory / uri, i, desc.TextureSize))
+                throw std::runtime_error(std::format("Failed to write '{}'", (directory / uri).string()));
+
+            tinygltf::Image& image = model.images.emplace_back();
+            image.uri = uri;
+            image.mimeType = "image/png";
+
+            model.textures.emplace_back().source = static_cast<int32_t>(i);
+            model.materials.emplace_back().pbrMetallicRoughness.baseColorTexture.index = static_cast<int32_t>(i);
+        }
+
+        tinygltf::Scene& scene = model.scenes.emplace_back();
+        for (uint32_t i = 0; i < desc.NumMeshes; ++i)
+        {
+            AddGridMesh(model, desc.NumGridVertices, desc.NumTextures > 0 ? int32_t(i % desc.NumTextures) : -1);
+
+            tinygltf::Node& node = model.nodes.emplace_back();
+            node.mesh = static_cast<int32_t>(i);
+            node.translation = { 1.5 * double(i), 0.0, 0.0 };
+            scene.nodes.push_back(static_cast<int32_t>(i));
+        }
+        model.defaultScene = 0;
+
+        tinygltf::TinyGLTF writer;
+        if (!writer.WriteGltfSceneToFile(&model, filepath.string(), /*embedImages*/ false, /*embedBuffers*/ false, /*prettyPrint*/ false, /*writeBinary*/ false))
+            throw std::runtime_error(std::format("Failed to write '{}'", filepath.string()));
+
+        return filepath;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+namespace Neb::test
+{
+
+    // Synthetic glTF scene for tests that load scenes on the device. Meshes are grids with positions, normals and texture coordinates,
+    // mesh i samples texture i % NumTextures and is placed by a node of its own
+    struct TestSceneDesc
+    {
+        uint32_t NumMeshes = 1;
+        uint32_t NumGridVertices = 64; // per side of the grid of every mesh
+        uint32_t NumTextures = 0;      // each texture is of its own contents, thus none are deduplicated
+        uint32_t TextureSize = 256;
+    };
+
+    // Writes .gltf with its buffer and PNG textures next to it into a directory named after the desc and returns the path of the .gltf.
+    // Scenes that were written earlier are reused, their caches are deleted so that every load is a cold one
+    std::filesystem::path WriteTestScene(const std::filesystem::path& workingDirectory, const TestSceneDesc& desc);
+
+} // Neb::test namespace
@@ -0,0 +1,204 @@
+#include "Test.h"
+
+#include "core/TextureCompression.h"
+#include "util/ThreadPool.h"
+
+#include <cmath>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Smooth gradients in every channel, alpha included
+        std::vector<std::byte> MakeGradient(uint32_t width, uint32_t height)
+        {
+            std::vector<std::byte> texels(size_t(width) * height * 4);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    std::byte* texel = &texels[(size_t(y) * width + x) * 4];
+                    texel[0] = std::byte(x * 255 / width);
+                    texel[1] = std::byte(y * 255 / height);
+                    texel[2] = std::byte((x + y) * 255 / (width + height));
+                    texel[3] = std::byte(255 - x * 2);
+                }
+            }
+            return texels;
+        }
+
+        // Waves with a sawtooth in blue, blocks of it do not fit a single line in color space
+        std::vector<std::byte> MakeDetailed(uint32_t width, uint32_t height)
+        {
+            std::vector<std::byte> texels(size_t(width) * height * 4);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    const float wave = std::sin(float(x) * 0.3f) * std::cos(float(y) * 0.2f);
+                    std::byte* texel = &texels[(size_t(y) * width + x) * 4];
+                    texel[0] = std::byte(int32_t(127.0f + 120.0f * wave));
+                    texel[1] = std::byte(int32_t(127.0f - 100.0f * wave));
+                    texel[2] = std::byte((x * 7 + y * 3) & 0xff);
+                    texel[3] = std::byte(200);
+                }
+            }
+            return texels;
+        }
+
+        TextureCompressionError Compress(const std::vector<std::byte>& texels, uint32_t width, uint32_t height, ETextureBlockFormat format, ETextureCompressionQuality quality)
+        {
+            const TextureLevelDesc level = { .Width = width, .Height = height, .Texels = texels.data() };
+            const TextureCompressionSourceDesc src = { .Format = format, .Levels = { &level, 1 } };
+
+            CompressedTexture compressed;
+            CompressTexture(compressed, src, quality);
+            return MeasureTextureCompressionError(compressed, src);
+        }
+
+        const char* GetFormatName(ETextureBlockFormat format)
+        {
+            static constexpr const char* Names[eTextureBlockFormat_NumFormats] = { "BC1", "BC4", "BC5", "BC7" };
+            return Names[format];
+        }
+    } // anonymous namespace
+
+    // Blocks of every level are tightly packed, partial blocks on the edges are still whole blocks
+    NEB_TEST(TextureCompression, Layout)
+    {
+        NEB_EXPECT(GetBlockSize(eTextureBlockFormat_BC1) == 8);
+        NEB_EXPECT(GetBlockSize(eTextureBlockFormat_BC4) == 8);
+        NEB_EXPECT(GetBlockSize(eTextureBlockFormat_BC5) == 16);
+        NEB_EXPECT(GetBlockSize(eTextureBlockFormat_BC7) == 16);
+
+        const std::vector<std::byte> texels = MakeGradient(37, 19);
+        const TextureLevelDesc levels[] = {
+            { .Width = 37, .Height = 19, .Texels = texels.data() },
+            { .Width = 18, .Height = 9, .Texels = texels.data() },
+            { .Width = 1, .Height = 1, .Texels = texels.data() },
+        };
+        const uint32_t expectedBlocks[][2] = { { 10, 5 }, { 5, 3 }, { 1, 1 } };
+
+        CompressedTexture compressed;
+        CompressTexture(compressed, TextureCompressionSourceDesc{ .Format = eTextureBlockFormat_BC1, .Levels = levels }, eTextureCompressionQuality_Fast);
+        NEB_EXPECT(compressed.Levels.size() == 3);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < compressed.Levels.size(); ++i)
+        {
+            const CompressedTextureLevel& level = compressed.Levels[i];
+            NEB_EXPECT(level.NumBlocksX == expectedBlocks[i][0] && level.NumBlocksY == expectedBlocks[i][1], "level {} is of {}x{} blocks", i, level.NumBlocksX, level.NumBlocksY);
+            NEB_EXPECT(level.Offset == offset, "level {} is at {}, expected {}", i, level.Offset, offset);
+            offset += size_t(level.NumBlocksX) * level.NumBlocksY * 8;
+        }
+        NEB_EXPECT(compressed.Blocks.size() == offset);
+        return true;
+    }
+
+    // Fixed PSNR floors of every format on a smooth gradient, well above what the import check accepts
+    NEB_TEST(TextureCompression, GradientPsnr)
+    {
+        static constexpr double MinPsnr[eTextureBlockFormat_NumFormats] = { 36.0, 48.0, 48.0, 38.0 };
+
+        const std::vector<std::byte> texels = MakeGradient(64, 64);
+        for (uint32_t format = 0; format < eTextureBlockFormat_NumFormats; ++format)
+        {
+            const TextureCompressionError error = Compress(texels, 64, 64, ETextureBlockFormat(format), eTextureCompressionQuality_Normal);
+            NEB_EXPECT(error.Psnr >= MinPsnr[format], "{} is {:.2f} dB, expected at least {:.1f} dB", GetFormatName(ETextureBlockFormat(format)), error.Psnr, MinPsnr[format]);
+            NEB_EXPECT(error.NumTexels == 64 * 64);
+        }
+        return true;
+    }
+
+    // Detailed images (and sizes that are not a multiple of 4) stay within bounds of IsTextureCompressionErrorAcceptable,
+    // higher quality is never worse
+    NEB_TEST(TextureCompression, DetailedPsnr)
+    {
+        const uint32_t sizes[][2] = { { 64, 64 }, { 37, 19 } };
+        for (const auto& [width, height] : sizes)
+        {
+            const std::vector<std::byte> texels = MakeDetailed(width, height);
+            for (uint32_t format = 0; format < eTextureBlockFormat_NumFormats; ++format)
+            {
+                const char* name = GetFormatName(ETextureBlockFormat(format));
+                const TextureCompressionError fast = Compress(texels, width, height, ETextureBlockFormat(format), eTextureCompressionQuality_Fast);
+                const TextureCompressionError normal = Compress(texels, width, height, ETextureBlockFormat(format), eTextureCompressionQuality_Normal);
+                const TextureCompressionError high = Compress(texels, width, height, ETextureBlockFormat(format), eTextureCompressionQuality_High);
+
+                NEB_EXPECT(IsTextureCompressionErrorAcceptable(normal, ETextureBlockFormat(format)), "{} of {}x{} is {:.2f} dB", name, width, height, normal.Psnr);
+                NEB_EXPECT(normal.Psnr >= fast.Psnr && high.Psnr >= normal.Psnr, "{} of {}x{}: fast {:.2f} dB, normal {:.2f} dB, high {:.2f} dB",
+                    name, width, height, fast.Psnr, normal.Psnr, high.Psnr);
+            }
+        }
+        return true;
+    }
+
+    // Blocks of a single color are exact for single and two channel formats and within a code for BC7
+    NEB_TEST(TextureCompression, SolidColor)
+    {
+        std::vector<std::byte> texels(size_t(16) * 16 * 4);
+        for (size_t i = 0; i < texels.size(); i += 4)
+        {
+            texels[i + 0] = std::byte(201);
+            texels[i + 1] = std::byte(13);
+            texels[i + 2] = std::byte(97);
+            texels[i + 3] = std::byte(255);
+        }
+
+        NEB_EXPECT(Compress(texels, 16, 16, eTextureBlockFormat_BC4, eTextureCompressionQuality_Normal).MaxError == 0);
+        NEB_EXPECT(Compress(texels, 16, 16, eTextureBlockFormat_BC5, eTextureCompressionQuality_Normal).MaxError == 0);
+        NEB_EXPECT(Compress(texels, 16, 16, eTextureBlockFormat_BC7, eTextureCompressionQuality_Normal).MaxError <= 1);
+        return true;
+    }
+
+    // BC4 stores the selected source channel in red (within half a step of its 8 entry palette), other channels decode to 0 and alpha to 255
+    NEB_TEST(TextureCompression, SingleChannelSource)
+    {
+        const std::vector<std::byte> texels = MakeGradient(16, 16);
+        const TextureLevelDesc level = { .Width = 16, .Height = 16, .Texels = texels.data() };
+        const TextureCompressionSourceDesc src = { .Format = eTextureBlockFormat_BC4, .Channels = { 2, 0 }, .Levels = { &level, 1 } };
+
+        CompressedTexture compressed;
+        CompressTexture(compressed, src, eTextureCompressionQuality_Normal);
+
+        std::vector<std::byte> decoded(texels.size());
+        DecompressTextureLevel(decoded.data(), compressed, 0);
+        for (size_t i = 0; i < decoded.size(); i += 4)
+        {
+            NEB_EXPECT(std::abs(int32_t(decoded[i]) - int32_t(texels[i + 2])) <= 4, "red of texel {} is {}, source blue is {}", i / 4, uint8_t(decoded[i]), uint8_t(texels[i + 2]));
+            NEB_EXPECT(uint8_t(decoded[i + 1]) == 0 && uint8_t(decoded[i + 2]) == 0 && uint8_t(decoded[i + 3]) == 255);
+        }
+        return true;
+    }
+
+    // Block rows are split between threads, results are bitwise the same as ones of a single texture at a time
+    NEB_TEST(TextureCompression, ParallelMatchesSerial)
+    {
+        const std::vector<std::byte> gradient = MakeGradient(128, 64);
+        const std::vector<std::byte> detailed = MakeDetailed(64, 32);
+        const TextureLevelDesc gradientLevels[] = { { .Width = 128, .Height = 64, .Texels = gradient.data() }, { .Width = 64, .Height = 32, .Texels = detailed.data() } };
+        const TextureLevelDesc detailedLevels[] = { { .Width = 64, .Height = 32, .Texels = detailed.data() } };
+
+        std::vector<TextureCompressionSourceDesc> srcs;
+        for (uint32_t format = 0; format < eTextureBlockFormat_NumFormats; ++format)
+        {
+            srcs.push_back(TextureCompressionSourceDesc{ .Format = ETextureBlockFormat(format), .Levels = gradientLevels });
+            srcs.push_back(TextureCompressionSourceDesc{ .Format = ETextureBlockFormat(format), .Levels = detailedLevels });
+        }
+
+        ThreadPool threadPool(3);
+        std::vector<CompressedTexture> compressed(srcs.size());
+        CompressTextures(compressed, srcs, eTextureCompressionQuality_High, threadPool);
+
+        for (size_t i = 0; i < srcs.size(); ++i)
+        {
+            CompressedTexture reference;
+            CompressTexture(reference, srcs[i], eTextureCompressionQuality_High);
+            NEB_EXPECT(compressed[i].Blocks == reference.Blocks, "blocks of texture {} ({}) differ", i, GetFormatName(srcs[i].Format));
+        }
+        return true;
+    }
+
+} // Neb::test namespace
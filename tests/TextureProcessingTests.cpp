@@ -0,0 +1,201 @@
+#include "Test.h"
+
+#include "core/TextureProcessing.h"
+#include "util/ThreadPool.h"
+
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Gradient with noise on top, so that both smooth areas and edges are filtered
+        std::vector<std::byte> MakeTexels(uint32_t width, uint32_t height, uint32_t seed)
+        {
+            std::vector<std::byte> texels(size_t(width) * height * 4);
+            uint32_t state = 0x9E3779B9u * (seed + 1);
+            for (uint32_t y = 0; y < height; ++y)
+            {
+                for (uint32_t x = 0; x < width; ++x)
+                {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+
+                    std::byte* texel = &texels[(size_t(y) * width + x) * 4];
+                    texel[0] = std::byte((x * 255 / width) & 0xff);
+                    texel[1] = std::byte((y * 255 / height) & 0xff);
+                    texel[2] = std::byte(state & 0xff);
+                    texel[3] = std::byte((state >> 8) & 0xff);
+                }
+            }
+            return texels;
+        }
+
+        const std::byte* GetLevelTexels(const TextureMipChain& chain, uint32_t mip)
+        {
+            return chain.Texels.data() + chain.Levels[mip - 1].Offset;
+        }
+    } // anonymous namespace
+
+    NEB_TEST(TextureProcessing, NumMipLevels)
+    {
+        NEB_EXPECT(GetNumMipLevels(1, 1) == 1);
+        NEB_EXPECT(GetNumMipLevels(2, 1) == 2);
+        NEB_EXPECT(GetNumMipLevels(5, 3) == 3);
+        NEB_EXPECT(GetNumMipLevels(256, 256) == 9);
+        NEB_EXPECT(GetNumMipLevels(1024, 1) == 11);
+        NEB_EXPECT(GetNumMipLevels(1000, 600) == 10);
+        return true;
+    }
+
+    // Each dimension is halved and rounded down, odd ones go through the 3-tap filter. maxLevels cuts the chain
+    NEB_TEST(TextureProcessing, LevelSizes)
+    {
+        const std::vector<std::byte> texels = MakeTexels(37, 19, 0);
+        const TextureSourceDesc src = { .Width = 37, .Height = 19, .Texels = texels.data(), .Content = eTextureContent_Linear };
+
+        TextureMipChain chain;
+        GenerateMipChain(chain, src);
+        NEB_EXPECT(chain.NumLevels == 6 && chain.Levels.size() == 5, "{} levels", chain.NumLevels);
+
+        const uint32_t expectedSizes[][2] = { { 18, 9 }, { 9, 4 }, { 4, 2 }, { 2, 1 }, { 1, 1 } };
+        size_t offset = 0;
+        for (size_t i = 0; i < chain.Levels.size(); ++i)
+        {
+            const TextureMipLevel& level = chain.Levels[i];
+            NEB_EXPECT(level.Width == expectedSizes[i][0] && level.Height == expectedSizes[i][1], "mip {} is {}x{}", i + 1, level.Width, level.Height);
+            NEB_EXPECT(level.Offset == offset, "mip {} is at {}, expected {}", i + 1, level.Offset, offset);
+            offset += size_t(level.Width) * level.Height * 4;
+        }
+        NEB_EXPECT(chain.Texels.size() == offset);
+
+        GenerateMipChain(chain, src, /*maxLevels*/ 3);
+        NEB_EXPECT(chain.NumLevels == 3 && chain.Levels.size() == 2, "{} levels", chain.NumLevels);
+        return true;
+    }
+
+    // Box filter of linear content is the exact average, rounded to nearest
+    NEB_TEST(TextureProcessing, LinearAverage)
+    {
+        const uint8_t texels[] = {
+            0, 10, 255, 1,    2, 20, 255, 2,
+            4, 30, 0, 3,      6, 40, 0, 5,
+        };
+        const TextureSourceDesc src = { .Width = 2, .Height = 2, .Texels = reinterpret_cast<const std::byte*>(texels), .Content = eTextureContent_Linear };
+
+        TextureMipChain chain;
+        GenerateMipChain(chain, src);
+        NEB_EXPECT(chain.NumLevels == 2);
+
+        const std::byte* mip = GetLevelTexels(chain, 1);
+        const uint8_t expected[] = { 3, 25, 128, 3 };
+        for (uint32_t c = 0; c < 4; ++c)
+            NEB_EXPECT(uint8_t(mip[c]) == expected[c], "channel {} is {}, expected {}", c, uint8_t(mip[c]), expected[c]);
+        return true;
+    }
+
+    // Color content is filtered in linear space: average of sRGB black and white is sRGB 188, not 128. Constant images stay constant
+    NEB_TEST(TextureProcessing, ColorIsFilteredInLinearSpace)
+    {
+        const uint8_t checker[] = {
+            0, 0, 0, 255,       255, 255, 255, 255,
+            255, 255, 255, 255, 0, 0, 0, 255,
+        };
+        const TextureSourceDesc src = { .Width = 2, .Height = 2, .Texels = reinterpret_cast<const std::byte*>(checker), .Content = eTextureContent_Color };
+
+        TextureMipChain chain;
+        GenerateMipChain(chain, src);
+        const std::byte* mip = GetLevelTexels(chain, 1);
+        for (uint32_t c = 0; c < 3; ++c)
+            NEB_EXPECT(std::abs(int32_t(mip[c]) - 188) <= 1, "channel {} is {}", c, uint8_t(mip[c]));
+        NEB_EXPECT(uint8_t(mip[3]) == 255);
+
+        std::vector<std::byte> constant(size_t(16) * 16 * 4);
+        for (size_t i = 0; i < constant.size(); i += 4)
+        {
+            constant[i + 0] = std::byte(200);
+            constant[i + 1] = std::byte(100);
+            constant[i + 2] = std::byte(30);
+            constant[i + 3] = std::byte(77);
+        }
+        GenerateMipChain(chain, TextureSourceDesc{ .Width = 16, .Height = 16, .Texels = constant.data(), .Content = eTextureContent_Color });
+        for (size_t i = 0; i < chain.Texels.size(); ++i)
+            NEB_EXPECT(std::abs(int32_t(chain.Texels[i]) - int32_t(constant[i % 4])) <= 1, "byte {} of the chain is {}", i, uint8_t(chain.Texels[i]));
+        return true;
+    }
+
+    // Filtered normals are renormalized
+    NEB_TEST(TextureProcessing, NormalsAreRenormalized)
+    {
+        // +x and +y normals average into a normal at 45 degrees, not into a shorter vector
+        const uint8_t normals[] = {
+            255, 128, 128, 255, 128, 255, 128, 255,
+            255, 128, 128, 255, 128, 255, 128, 255,
+        };
+        const TextureSourceDesc src = { .Width = 2, .Height = 2, .Texels = reinterpret_cast<const std::byte*>(normals), .Content = eTextureContent_Normal };
+
+        TextureMipChain chain;
+        GenerateMipChain(chain, src);
+        const std::byte* mip = GetLevelTexels(chain, 1);
+
+        float length = 0.0f;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            const float n = float(uint8_t(mip[c])) / 255.0f * 2.0f - 1.0f;
+            length += n * n;
+        }
+        NEB_EXPECT(std::abs(std::sqrt(length) - 1.0f) < 0.02f, "length of the filtered normal is {}", std::sqrt(length));
+        return true;
+    }
+
+    // Vectorized filter is within a code of the double precision reference for every content and size
+    NEB_TEST(TextureProcessing, MatchesReference)
+    {
+        const uint32_t sizes[][2] = { { 64, 64 }, { 37, 19 }, { 1, 33 }, { 128, 3 } };
+        for (uint32_t content = 0; content < eTextureContent_NumContents; ++content)
+        {
+            for (const auto& [width, height] : sizes)
+            {
+                const std::vector<std::byte> texels = MakeTexels(width, height, content);
+                const TextureSourceDesc src = { .Width = width, .Height = height, .Texels = texels.data(), .Content = ETextureContent(content) };
+
+                TextureMipChain chain;
+                GenerateMipChain(chain, src);
+
+                const TextureMipChainError error = MeasureMipChainError(chain, src);
+                NEB_EXPECT(IsMipChainErrorAcceptable(error), "{}x{} of content {} is off by {} codes", width, height, content, error.MaxError);
+                NEB_EXPECT(error.NumTexels > 0);
+            }
+        }
+        return true;
+    }
+
+    // Rows of levels are split between threads, results are bitwise the same as ones of a single image at a time
+    NEB_TEST(TextureProcessing, ParallelMatchesSerial)
+    {
+        std::vector<std::vector<std::byte>> texels;
+        std::vector<TextureSourceDesc> srcs;
+        const uint32_t sizes[][2] = { { 512, 256 }, { 37, 19 }, { 1, 1 }, { 300, 301 } };
+        for (uint32_t i = 0; i < std::size(sizes); ++i)
+            texels.push_back(MakeTexels(sizes[i][0], sizes[i][1], i));
+        for (uint32_t i = 0; i < std::size(sizes); ++i)
+            srcs.push_back(TextureSourceDesc{ .Width = sizes[i][0], .Height = sizes[i][1], .Texels = texels[i].data(), .Content = ETextureContent(i % eTextureContent_NumContents) });
+
+        ThreadPool threadPool(3);
+        std::vector<TextureMipChain> chains(srcs.size());
+        GenerateMipChains(chains, srcs, threadPool);
+
+        for (size_t i = 0; i < srcs.size(); ++i)
+        {
+            TextureMipChain reference;
+            GenerateMipChain(reference, srcs[i]);
+            NEB_EXPECT(chains[i].NumLevels == reference.NumLevels && chains[i].Texels == reference.Texels, "chain of image {} differs", i);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
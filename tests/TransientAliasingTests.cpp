@@ -0,0 +1,258 @@
+#include "Test.h"
+
+#include "core/TransientAliasing.h"
+#include "util/Memory.h"
+
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <random>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        using B = TransientAliasingBarrier;
+        constexpr uint64_t KiB = 1024;
+        constexpr uint64_t MiB = 1024 * 1024;
+        constexpr uint32_t Invalid = TransientAliasingPlanner::InvalidIndex;
+
+        bool AreLifetimesOverlapping(const TransientResourceDesc& a, const TransientResourceDesc& b)
+        {
+            return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+        }
+
+        bool AreRangesOverlapping(const TransientAliasingPlanner& planner, uint32_t a, uint32_t b)
+        {
+            const TransientPlacement& placementA = planner.GetPlacement(a);
+            const TransientPlacement& placementB = planner.GetPlacement(b);
+            return placementA.Heap == placementB.Heap
+                && placementA.Offset < placementB.Offset + planner.GetResource(b).Size
+                && placementB.Offset < placementA.Offset + planner.GetResource(a).Size;
+        }
+
+        bool ExpectBarriers(const TransientAliasingPlanner& planner, uint32_t pass, std::initializer_list<B> expected)
+        {
+            return std::ranges::equal(planner.GetAliasingBarriers(pass), expected);
+        }
+
+        bool ExpectPlacement(const TransientAliasingPlanner& planner, uint32_t resource, uint32_t heap, uint64_t offset)
+        {
+            const TransientPlacement& placement = planner.GetPlacement(resource);
+            return placement.Heap == heap && placement.Offset == offset;
+        }
+
+        // Placements are aligned, within their heaps and never overlap placements of resources alive at the same time.
+        // Barriers activate exactly the resources that share memory, the one they share it with is named if there is only one
+        bool CheckTransientPlan(const TransientAliasingPlanner& planner)
+        {
+            const uint32_t numResources = planner.GetNumResources();
+            std::vector<uint32_t> numSharers(numResources, 0);
+            std::vector<uint32_t> lastSharers(numResources, Invalid);
+            for (uint32_t a = 0; a < numResources; ++a)
+            {
+                const TransientResourceDesc& desc = planner.GetResource(a);
+                const TransientPlacement& placement = planner.GetPlacement(a);
+                NEB_EXPECT(placement.Heap < planner.GetNumHeaps()
+                    && planner.GetHeapGroup(placement.Heap) == desc.HeapGroup
+                    && placement.Offset % desc.Alignment == 0
+                    && placement.Offset + desc.Size <= planner.GetHeapSize(placement.Heap),
+                    "resource {} is misplaced at {} of heap {}", a, placement.Offset, placement.Heap);
+
+                for (uint32_t b = a + 1; b < numResources; ++b)
+                {
+                    if (!AreRangesOverlapping(planner, a, b))
+                        continue;
+
+                    NEB_EXPECT(!AreLifetimesOverlapping(desc, planner.GetResource(b)), "resources {} and {} are alive at the same time in the same memory", a, b);
+                    ++numSharers[a];
+                    ++numSharers[b];
+                    lastSharers[a] = b;
+                    lastSharers[b] = a;
+                }
+            }
+
+            uint32_t numPasses = 0;
+            for (uint32_t resource = 0; resource < numResources; ++resource)
+                numPasses = std::max(numPasses, planner.GetResource(resource).LastPass + 1);
+
+            uint32_t numBarriers = 0;
+            for (uint32_t pass = 0; pass <= numPasses; ++pass)
+            {
+                for (const TransientAliasingBarrier& barrier : planner.GetAliasingBarriers(pass))
+                {
+                    const uint32_t resource = barrier.ResourceAfter;
+                    const uint32_t expectedBefore = (numSharers[resource] == 1) ? lastSharers[resource] : Invalid;
+                    NEB_EXPECT(planner.GetResource(resource).FirstPass == pass && numSharers[resource] != 0 && barrier.ResourceBefore == expectedBefore,
+                        "aliasing barrier of resource {} before pass {} is invalid", resource, pass);
+                    ++numBarriers;
+                }
+            }
+
+            const uint32_t numExpectedBarriers = static_cast<uint32_t>(std::ranges::count_if(numSharers, [](uint32_t n) { return n != 0; }));
+            const TransientAliasingStats& stats = planner.GetStats();
+            NEB_EXPECT(numBarriers == numExpectedBarriers && stats.NumAliasingBarriers == numBarriers, "{} aliasing barriers, {} expected", numBarriers, numExpectedBarriers);
+
+            uint64_t heapBytes = 0;
+            for (uint32_t heap = 0; heap < planner.GetNumHeaps(); ++heap)
+                heapBytes += planner.GetHeapSize(heap);
+
+            NEB_EXPECT(stats.HeapBytes == heapBytes && stats.HeapBytes >= stats.PeakBytes,
+                "heaps take {} bytes ({} reported), peak is {} bytes", heapBytes, stats.HeapBytes, stats.PeakBytes);
+            return true;
+        }
+    } // anonymous namespace
+
+    // A chain of render targets: the first and the last one never meet and take the same memory, one of the previous frame
+    // is activated before the first pass
+    NEB_TEST(TransientAliasing, RenderTargetChain)
+    {
+        TransientAliasingPlanner planner;
+        const uint32_t a = planner.AddResource(TransientResourceDesc{ .FirstPass = 0, .LastPass = 1, .Size = 4 * MiB, .Alignment = 64 * KiB });
+        const uint32_t b = planner.AddResource(TransientResourceDesc{ .FirstPass = 1, .LastPass = 2, .Size = 2 * MiB, .Alignment = 64 * KiB });
+        const uint32_t c = planner.AddResource(TransientResourceDesc{ .FirstPass = 2, .LastPass = 3, .Size = 4 * MiB, .Alignment = 64 * KiB });
+        planner.Plan();
+
+        const TransientAliasingStats& stats = planner.GetStats();
+        NEB_EXPECT(CheckTransientPlan(planner));
+        NEB_EXPECT(ExpectPlacement(planner, a, 0, 0) && ExpectPlacement(planner, b, 0, 4 * MiB) && ExpectPlacement(planner, c, 0, 0));
+        NEB_EXPECT(stats.NumHeaps == 1 && stats.HeapBytes == 6 * MiB && stats.PeakBytes == 6 * MiB && stats.NaiveBytes == 10 * MiB,
+            "{} heaps of {} bytes, peak is {} bytes", stats.NumHeaps, stats.HeapBytes, stats.PeakBytes);
+        NEB_EXPECT(ExpectBarriers(planner, 0, { B{ c, a } }) && ExpectBarriers(planner, 1, {}) && ExpectBarriers(planner, 2, { B{ a, c } }) && ExpectBarriers(planner, 3, {}));
+        return true;
+    }
+
+    // Alignment leaves a gap after the first resource, the one that needs no more than the gap is not aliased with anything
+    NEB_TEST(TransientAliasing, AlignmentGap)
+    {
+        TransientAliasingPlanner planner;
+        const uint32_t a = planner.AddResource(TransientResourceDesc{ .FirstPass = 0, .LastPass = 1, .Size = 192 * KiB, .Alignment = 64 * KiB });
+        const uint32_t b = planner.AddResource(TransientResourceDesc{ .FirstPass = 1, .LastPass = 1, .Size = 128 * KiB, .Alignment = 128 * KiB });
+        const uint32_t c = planner.AddResource(TransientResourceDesc{ .FirstPass = 2, .LastPass = 2, .Size = 64 * KiB, .Alignment = 64 * KiB });
+        planner.Plan();
+
+        const TransientAliasingStats& stats = planner.GetStats();
+        NEB_EXPECT(CheckTransientPlan(planner));
+        NEB_EXPECT(ExpectPlacement(planner, a, 0, 0) && ExpectPlacement(planner, b, 0, 256 * KiB) && ExpectPlacement(planner, c, 0, 0));
+        NEB_EXPECT(stats.HeapBytes == 384 * KiB && stats.PeakBytes == 320 * KiB && stats.NaiveBytes == 384 * KiB,
+            "heaps take {} bytes, peak is {} bytes", stats.HeapBytes, stats.PeakBytes);
+        NEB_EXPECT(ExpectBarriers(planner, 0, { B{ c, a } }) && ExpectBarriers(planner, 1, {}) && ExpectBarriers(planner, 2, { B{ a, c } }));
+        return true;
+    }
+
+    // A resource shares memory with two others, that are activated after it. It is activated after either of them
+    NEB_TEST(TransientAliasing, SharedWithTwo)
+    {
+        TransientAliasingPlanner planner;
+        const uint32_t d = planner.AddResource(TransientResourceDesc{ .FirstPass = 0, .LastPass = 0, .Size = 2 * MiB, .Alignment = 64 * KiB });
+        const uint32_t e = planner.AddResource(TransientResourceDesc{ .FirstPass = 1, .LastPass = 1, .Size = 1 * MiB, .Alignment = 64 * KiB });
+        const uint32_t f = planner.AddResource(TransientResourceDesc{ .FirstPass = 1, .LastPass = 1, .Size = 1 * MiB, .Alignment = 64 * KiB });
+        planner.Plan();
+
+        NEB_EXPECT(CheckTransientPlan(planner));
+        NEB_EXPECT(ExpectPlacement(planner, d, 0, 0) && ExpectPlacement(planner, e, 0, 0) && ExpectPlacement(planner, f, 0, 1 * MiB));
+        NEB_EXPECT(planner.GetStats().HeapBytes == 2 * MiB, "heaps take {} bytes", planner.GetStats().HeapBytes);
+        NEB_EXPECT(ExpectBarriers(planner, 0, { B{ Invalid, d } }) && ExpectBarriers(planner, 1, { B{ d, e }, B{ d, f } }));
+        return true;
+    }
+
+    // Groups never share heaps, e.g. render targets and unordered access textures on resource heap tier 1
+    NEB_TEST(TransientAliasing, HeapGroups)
+    {
+        TransientAliasingPlanner planner;
+        const uint32_t x = planner.AddResource(TransientResourceDesc{ .FirstPass = 0, .LastPass = 0, .Size = 1 * MiB, .Alignment = 64 * KiB, .HeapGroup = 1 });
+        const uint32_t y = planner.AddResource(TransientResourceDesc{ .FirstPass = 1, .LastPass = 1, .Size = 1 * MiB, .Alignment = 64 * KiB, .HeapGroup = 0 });
+        planner.Plan();
+
+        const TransientAliasingStats& stats = planner.GetStats();
+        NEB_EXPECT(CheckTransientPlan(planner));
+        NEB_EXPECT(ExpectPlacement(planner, y, 0, 0) && ExpectPlacement(planner, x, 1, 0) && planner.GetHeapGroup(1) == 1);
+        NEB_EXPECT(stats.NumHeaps == 2 && stats.HeapBytes == 2 * MiB && stats.PeakBytes == 2 * MiB && stats.NumAliasingBarriers == 0);
+        return true;
+    }
+
+    // Transient targets of DeferredRenderer at 1080p over its frame passes: G-buffers live up to path tracing, NRC debug maps only in it,
+    // SVGF variance from temporal accumulation to the last A-Trous pass. Variance takes G-buffer memory and the heap is no larger
+    // than targets of path tracing
+    NEB_TEST(TransientAliasing, DeferredFrame)
+    {
+        static constexpr uint32_t GbufferPass = 0;
+        static constexpr uint32_t PathtracePass = 2;
+        static constexpr uint32_t TemporalAccumulationPass = 4;
+        static constexpr uint32_t LastATrousPass = TemporalAccumulationPass + 4;
+        static constexpr uint64_t TextureAlignment = 64 * KiB;
+
+        TransientAliasingPlanner planner;
+        auto addTarget = [&planner](uint64_t bytesPerPixel, uint32_t firstPass, uint32_t lastPass)
+            {
+                return planner.AddResource(TransientResourceDesc{
+                    .FirstPass = firstPass,
+                    .LastPass = lastPass,
+                    .Size = AlignUp<uint64_t>(1920 * 1080 * bytesPerPixel, TextureAlignment),
+                    .Alignment = TextureAlignment,
+                });
+            };
+        const auto gbuffers = std::to_array<uint32_t>({
+            addTarget(4, GbufferPass, PathtracePass),
+            addTarget(4, GbufferPass, PathtracePass),
+            addTarget(8, GbufferPass, PathtracePass),
+        });
+        addTarget(8, PathtracePass, PathtracePass);
+        addTarget(2, PathtracePass, PathtracePass);
+        const uint32_t variance = addTarget(2, TemporalAccumulationPass, LastATrousPass);
+        planner.Plan();
+
+        const TransientAliasingStats& stats = planner.GetStats();
+        NEB_EXPECT(CheckTransientPlan(planner));
+        NEB_EXPECT(stats.NumHeaps == 1 && stats.HeapBytes == stats.PeakBytes, "heaps take {} bytes, peak is {} bytes", stats.HeapBytes, stats.PeakBytes);
+        NEB_EXPECT(std::ranges::any_of(gbuffers, [&](uint32_t gbuffer) { return AreRangesOverlapping(planner, variance, gbuffer); }),
+            "variance at {} shares no memory with G-buffers", planner.GetPlacement(variance).Offset);
+        NEB_EXPECT(planner.GetAliasingBarriers(TemporalAccumulationPass).size() == 1);
+        return true;
+    }
+
+    // Random lifetimes, sizes and alignments. Resources of a single size and alignment take exactly as much as the peak
+    NEB_TEST(TransientAliasing, RandomLifetimes)
+    {
+        TransientAliasingPlanner planner;
+        std::mt19937_64 random(0x7A5);
+        for (uint32_t iteration = 0; iteration < 200; ++iteration)
+        {
+            const bool isUniform = (iteration % 4 == 0);
+            const uint32_t numResources = 1 + static_cast<uint32_t>(random() % 64);
+            const uint32_t numPasses = 1 + static_cast<uint32_t>(random() % 16);
+
+            planner.Reset();
+            for (uint32_t i = 0; i < numResources; ++i)
+            {
+                const uint32_t firstPass = random() % numPasses;
+                const uint32_t lastPass = firstPass + static_cast<uint32_t>(random() % (numPasses - firstPass));
+                const uint64_t alignment = isUniform ? 64 * KiB : (4 * KiB) << (random() % 8);
+                uint64_t size = 64 * KiB;
+                if (!isUniform)
+                {
+                    const uint64_t numAlignments = (random() % 4 == 0) ? 0 : 1 + random() % 4;
+                    size = numAlignments * alignment;
+                    size -= (size != 0) ? random() % alignment : 0;
+                }
+                planner.AddResource(TransientResourceDesc{
+                    .FirstPass = firstPass,
+                    .LastPass = lastPass,
+                    .Size = size,
+                    .Alignment = alignment,
+                    .HeapGroup = isUniform ? 0 : static_cast<uint32_t>(random() % 3),
+                });
+            }
+            planner.Plan();
+
+            const TransientAliasingStats& stats = planner.GetStats();
+            NEB_EXPECT(CheckTransientPlan(planner), "plan of {} resources over {} passes", numResources, numPasses);
+            NEB_EXPECT(!isUniform || stats.HeapBytes == stats.PeakBytes,
+                "{} uniform resources over {} passes: heaps take {} bytes, peak is {} bytes", numResources, numPasses, stats.HeapBytes, stats.PeakBytes);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
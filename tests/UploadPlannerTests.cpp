@@ -0,0 +1,251 @@
+#include "Test.h"
+
+#include "core/UploadPlanner.h"
+
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Mix of buffers and texture subresources with D3D12 placement alignment and row pitches, the same as UploadBatch records
+        std::vector<UploadRequestDesc> MakeRequests(uint32_t numRequests, uint64_t maxNumBytes, uint64_t seed)
+        {
+            std::mt19937_64 random(seed);
+            std::vector<UploadRequestDesc> requests(numRequests);
+            for (UploadRequestDesc& request : requests)
+            {
+                switch (random() % 3)
+                {
+                case 0: // buffer
+                    request = UploadRequestDesc{ .NumBytes = 1 + random() % maxNumBytes, .Alignment = 1, .SplitGranularity = 1 };
+                    break;
+                case 1: // texture, rows are 256 byte aligned
+                {
+                    const uint64_t rowPitch = 256 * (1 + random() % 16);
+                    request = UploadRequestDesc{ .NumBytes = rowPitch * (1 + random() % (maxNumBytes / rowPitch + 1)), .Alignment = 512, .SplitGranularity = rowPitch };
+                    break;
+                }
+                default: // cannot be split
+                    request = UploadRequestDesc{ .NumBytes = 1 + random() % maxNumBytes, .Alignment = uint64_t(1) << (random() % 10), .SplitGranularity = 0 };
+                    break;
+                }
+            }
+            return requests;
+        }
+
+        // Ring invariants on a long randomized sequence of allocations and releases. Ranges of live allocations
+        // should never overlap, allocations should only fail when the ring is really full
+        bool CheckStagingRing(uint64_t capacity, uint32_t numAllocations, uint64_t seed)
+        {
+            struct LiveRange
+            {
+                uint64_t Begin;
+                uint64_t End;
+                uint64_t FenceValue;
+            };
+
+            StagingRing ring(capacity);
+            std::deque<LiveRange> liveRanges;
+            std::mt19937_64 random(seed);
+
+            uint64_t fenceValue = 1;
+            uint64_t completedFenceValue = 0;
+            for (uint32_t i = 0; i < numAllocations; ++i)
+            {
+                const uint64_t alignment = uint64_t(1) << (random() % 10);
+                const uint64_t numBytes = 1 + random() % std::max<uint64_t>(capacity / 3, 1);
+
+                // Several allocations share a fence value, the same as pieces of a single submission would
+                if (random() % 3 == 0)
+                    ++fenceValue;
+
+                const uint64_t waitFenceValue = ring.GetFenceValueToAllocate(numBytes, alignment);
+
+                // Ring has to fit anything that is not larger than its capacity once everything is completed
+                NEB_EXPECT(waitFenceValue <= fenceValue, "allocation {} of {} bytes waits for {}, last one is {}", i, numBytes, waitFenceValue, fenceValue);
+
+                if (waitFenceValue > 0)
+                {
+                    // Should really be full until then
+                    NEB_EXPECT(ring.Allocate(numBytes, alignment, fenceValue) == StagingRing::InvalidOffset, "allocation {} fits without waiting", i);
+
+                    // Waiting for allocations of the current submission means it has to be submitted first
+                    fenceValue += (waitFenceValue == fenceValue) ? 1 : 0;
+                    completedFenceValue = waitFenceValue;
+                    ring.Release(completedFenceValue);
+                    while (!liveRanges.empty() && liveRanges.front().FenceValue <= completedFenceValue)
+                        liveRanges.pop_front();
+                }
+
+                const uint64_t offset = ring.Allocate(numBytes, alignment, fenceValue);
+                NEB_EXPECT(offset != StagingRing::InvalidOffset && offset % alignment == 0 && offset + numBytes <= capacity,
+                    "allocation {} of {} bytes aligned to {} is at {}", i, numBytes, alignment, offset);
+
+                for (const LiveRange& range : liveRanges)
+                    NEB_EXPECT(offset >= range.End || range.Begin >= offset + numBytes, "allocation {} overlaps [{}, {})", i, range.Begin, range.End);
+                liveRanges.push_back(LiveRange{ .Begin = offset, .End = offset + numBytes, .FenceValue = fenceValue });
+
+                // Completion lags behind submissions by a random amount, the current one is not submitted yet
+                if (random() % 4 == 0 && completedFenceValue + 1 < fenceValue)
+                {
+                    completedFenceValue += 1 + random() % (fenceValue - 1 - completedFenceValue);
+                    ring.Release(completedFenceValue);
+                    while (!liveRanges.empty() && liveRanges.front().FenceValue <= completedFenceValue)
+                        liveRanges.pop_front();
+                }
+            }
+            NEB_EXPECT(ring.GetNumAllocations() == liveRanges.size());
+            return true;
+        }
+    } // anonymous namespace
+
+    // Requests that fit are packed into a single chunk in order, each piece at the alignment of its request
+    NEB_TEST(UploadPlanner, PackedInOrder)
+    {
+        const UploadRequestDesc requests[] = {
+            { .NumBytes = 100, .Alignment = 1 },
+            { .NumBytes = 1000, .Alignment = 512, .SplitGranularity = 250 },
+            { .NumBytes = 7, .Alignment = 4 },
+        };
+
+        UploadPlan plan;
+        PlanUploads(plan, requests, /*chunkSize*/ 4096);
+        NEB_EXPECT(ValidateUploadPlan(plan, requests, 4096));
+        NEB_EXPECT(plan.Chunks.size() == 1 && plan.Pieces.size() == 3, "{} chunks, {} pieces", plan.Chunks.size(), plan.Pieces.size());
+
+        const uint64_t expectedOffsets[] = { 0, 512, 1512 };
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const UploadPiece& piece = plan.Pieces[i];
+            NEB_EXPECT(piece.Request == i && piece.RequestOffset == 0 && piece.NumBytes == requests[i].NumBytes);
+            NEB_EXPECT(piece.ChunkOffset == expectedOffsets[i], "piece {} is at {}, expected {}", i, piece.ChunkOffset, expectedOffsets[i]);
+        }
+        NEB_EXPECT(plan.Chunks[0].NumBytes == 1519 && plan.Chunks[0].Alignment == 512);
+        return true;
+    }
+
+    // Rows of a texture that does not fit are split between chunks, every piece is a whole number of rows
+    NEB_TEST(UploadPlanner, SplitByGranularity)
+    {
+        const UploadRequestDesc requests[] = {
+            { .NumBytes = 1536, .Alignment = 512 },
+            { .NumBytes = 300 * 10, .Alignment = 512, .SplitGranularity = 300 },
+        };
+
+        UploadPlan plan;
+        PlanUploads(plan, requests, /*chunkSize*/ 2048);
+        NEB_EXPECT(ValidateUploadPlan(plan, requests, 2048));
+
+        // 512 bytes are left after the first request, only a single row of 300 fits there
+        NEB_EXPECT(plan.Pieces.size() == 4, "{} pieces", plan.Pieces.size());
+        const uint64_t expectedNumBytes[] = { 1536, 300, 1800, 900 };
+        for (size_t i = 0; i < plan.Pieces.size(); ++i)
+        {
+            NEB_EXPECT(plan.Pieces[i].NumBytes == expectedNumBytes[i], "piece {} is of {} bytes, expected {}", i, plan.Pieces[i].NumBytes, expectedNumBytes[i]);
+            NEB_EXPECT(plan.Pieces[i].RequestOffset % 300 == 0);
+        }
+        NEB_EXPECT(plan.Chunks.size() == 3);
+        return true;
+    }
+
+    // Requests (or granules) larger than a chunk get an oversized chunk of their own, everything else keeps to chunkSize
+    NEB_TEST(UploadPlanner, OversizedRequests)
+    {
+        const UploadRequestDesc requests[] = {
+            { .NumBytes = 100, .Alignment = 1, .SplitGranularity = 1 },
+            { .NumBytes = 5000, .Alignment = 512 },
+            { .NumBytes = 3 * 3000, .Alignment = 512, .SplitGranularity = 3000 },
+            { .NumBytes = 100, .Alignment = 1, .SplitGranularity = 1 },
+        };
+
+        UploadPlan plan;
+        PlanUploads(plan, requests, /*chunkSize*/ 1024);
+        NEB_EXPECT(ValidateUploadPlan(plan, requests, 1024));
+        NEB_EXPECT(plan.Chunks.size() == 6, "{} chunks", plan.Chunks.size());
+
+        for (const UploadChunk& chunk : plan.Chunks)
+        {
+            if (chunk.NumBytes > 1024)
+                NEB_EXPECT(chunk.NumPieces == 1 && plan.Pieces[chunk.FirstPiece].ChunkOffset == 0);
+        }
+        return true;
+    }
+
+    // Plans that do not cover their requests (or overlap) are rejected
+    NEB_TEST(UploadPlanner, InvalidPlansAreRejected)
+    {
+        const std::vector<UploadRequestDesc> requests = MakeRequests(64, 4096, 0);
+
+        UploadPlan plan;
+        PlanUploads(plan, requests, /*chunkSize*/ 8192);
+        NEB_EXPECT(ValidateUploadPlan(plan, requests, 8192));
+
+        UploadPlan broken = plan;
+        broken.Pieces.back().NumBytes -= 1;
+        NEB_EXPECT(!ValidateUploadPlan(broken, requests, 8192));
+
+        broken = plan;
+        broken.Pieces[1].ChunkOffset = broken.Pieces[0].ChunkOffset;
+        NEB_EXPECT(!ValidateUploadPlan(broken, requests, 8192));
+
+        NEB_EXPECT(!ValidateUploadPlan(plan, requests, /*chunkSize*/ 1024));
+        return true;
+    }
+
+    NEB_TEST(UploadPlanner, RandomPlansAreValid)
+    {
+        for (uint64_t seed = 0; seed < 16; ++seed)
+        {
+            const std::vector<UploadRequestDesc> requests = MakeRequests(512, 64 * 1024, seed);
+            for (uint64_t chunkSize : { uint64_t(4096), uint64_t(64 * 1024), uint64_t(16 * 1024 * 1024) })
+            {
+                UploadPlan plan;
+                PlanUploads(plan, requests, chunkSize);
+                NEB_EXPECT(ValidateUploadPlan(plan, requests, chunkSize), "plan with seed {} and chunks of {} bytes is not valid", seed, chunkSize);
+            }
+        }
+        return true;
+    }
+
+    // Allocation that does not fit before the end of the ring skips its tail and starts from the beginning once it is released
+    NEB_TEST(UploadPlanner, StagingRingSkipsTail)
+    {
+        StagingRing ring(1024);
+        NEB_EXPECT(ring.Allocate(600, 1, 1) == 0);
+        NEB_EXPECT(ring.Allocate(200, 256, 2) == 768);
+
+        NEB_EXPECT(ring.Allocate(100, 1, 3) == StagingRing::InvalidOffset);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(100, 1) == 1);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(800, 1) == 2);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(2048, 1) == UINT64_MAX);
+
+        ring.Release(1);
+        NEB_EXPECT(ring.GetNumAllocations() == 1);
+        NEB_EXPECT(ring.Allocate(100, 1, 3) == 0);
+        NEB_EXPECT(ring.Allocate(1000, 1, 3) == StagingRing::InvalidOffset);
+
+        // Empty ring starts over, so that an allocation of the whole capacity fits
+        ring.Release(3);
+        NEB_EXPECT(ring.GetNumUsedBytes() == 0);
+        NEB_EXPECT(ring.GetFenceValueToAllocate(1024, 512) == 0);
+        NEB_EXPECT(ring.Allocate(1024, 512, 4) == 0);
+        return true;
+    }
+
+    // Live allocations never overlap on long randomized sequences, allocations only fail when the ring is really full
+    NEB_TEST(UploadPlanner, StagingRingInvariants)
+    {
+        for (uint64_t seed = 0; seed < 8; ++seed)
+        {
+            NEB_EXPECT(CheckStagingRing(64 * 1024 * 1024, 1 << 14, seed), "ring of 64 MB failed with seed {}", seed);
+            NEB_EXPECT(CheckStagingRing(64 * 1024, 1 << 14, seed), "ring of 64 KB failed with seed {}", seed);
+        }
+        return true;
+    }
+
+} // Neb::test namespace
@@ -0,0 +1,295 @@
+#include "Test.h"
+
+#include "core/VertexCompression.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+// Same check as in VertexCompression.cpp, tests are built with the same flags as the core library
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define NEB_TEST_F16C 1
+#endif
+
+namespace Neb::test
+{
+
+    namespace
+    {
+        // Separate streams, tangents with handedness in w
+        struct TestVertices
+        {
+            void Add(const float (&position)[3], const float (&normal)[3], const float (&texCoord)[2], const float (&tangent)[4])
+            {
+                Positions.insert(Positions.end(), std::begin(position), std::end(position));
+                Normals.insert(Normals.end(), std::begin(normal), std::end(normal));
+                TexCoords.insert(TexCoords.end(), std::begin(texCoord), std::end(texCoord));
+                Tangents.insert(Tangents.end(), std::begin(tangent), std::end(tangent));
+                ++NumVertices;
+            }
+
+            VertexCompressionSourceDesc GetSource() const
+            {
+                return VertexCompressionSourceDesc{
+                    .NumVertices = NumVertices,
+                    .Positions = reinterpret_cast<const std::byte*>(Positions.data()),
+                    .Normals = reinterpret_cast<const std::byte*>(Normals.data()),
+                    .TexCoords = reinterpret_cast<const std::byte*>(TexCoords.data()),
+                    .Tangents = reinterpret_cast<const std::byte*>(Tangents.data()),
+                };
+            }
+
+            uint32_t NumVertices = 0;
+            std::vector<float> Positions;
+            std::vector<float> Normals;
+            std::vector<float> TexCoords;
+            std::vector<float> Tangents;
+        };
+
+        void GetRandomUnitVector(std::mt19937_64& random, float (&v)[3])
+        {
+            std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+            float lengthSquared = 0.0f;
+            do
+            {
+                for (float& c : v)
+                    c = distribution(random);
+                lengthSquared = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+            } while (lengthSquared > 1.0f || lengthSquared < 1e-4f);
+
+            const float length = std::sqrt(lengthSquared);
+            for (float& c : v)
+                c /= length;
+        }
+
+        TestVertices MakeRandomVertices(uint32_t numVertices, uint64_t seed)
+        {
+            std::mt19937_64 random(seed);
+            std::uniform_real_distribution<float> position(-50.0f, 150.0f);
+            std::uniform_real_distribution<float> texCoord(-4.0f, 4.0f);
+
+            TestVertices vertices;
+            for (uint32_t i = 0; i < numVertices; ++i)
+            {
+                float normal[3], tangent[3];
+                GetRandomUnitVector(random, normal);
+                GetRandomUnitVector(random, tangent);
+                vertices.Add({ position(random), position(random), position(random) }, normal, { texCoord(random), texCoord(random) },
+                    { tangent[0], tangent[1], tangent[2], (random() % 2) ? 1.0f : -1.0f });
+            }
+            return vertices;
+        }
+
+        // Scalar path of the texcoord encoder, a single vertex never goes through the vectorized one
+        uint16_t EncodeHalf(float v)
+        {
+            const float texCoord[2] = { v, 0.0f };
+            uint32_t encoded = 0;
+            EncodeTexCoords(std::span(&encoded, 1), reinterpret_cast<const std::byte*>(texCoord), sizeof(texCoord));
+            return static_cast<uint16_t>(encoded & 0xffff);
+        }
+
+        // Encoding of the first numVertices vertices is the prefix of the encoding of all of them. Vertices move between
+        // the vectorized body and the scalar tail as numVertices changes
+        bool CheckEncodedPrefixes(const TestVertices& vertices)
+        {
+            const VertexCompressionSourceDesc src = vertices.GetSource();
+            CompressedVertexData all;
+            CompressVertices(all, src);
+
+            for (uint32_t numVertices = 1; numVertices <= src.NumVertices; ++numVertices)
+            {
+                std::vector<CompactPosition> positions(numVertices);
+                std::vector<uint32_t> normals(numVertices), texCoords(numVertices), tangents(numVertices);
+                EncodePositions(positions, src.Positions, src.PositionsStride, all.Quantization);
+                EncodeNormals(normals, src.Normals, src.NormalsStride);
+                EncodeTexCoords(texCoords, src.TexCoords, src.TexCoordsStride);
+                EncodeTangents(tangents, src.Tangents, src.TangentsStride);
+
+                for (uint32_t i = 0; i < numVertices; ++i)
+                {
+                    const CompactPosition& a = positions[i];
+                    const CompactPosition& b = all.Positions[i];
+                    NEB_EXPECT(a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w, "position {} of {} differs", i, numVertices);
+                    NEB_EXPECT(normals[i] == all.Normals[i], "normal {} of {}: {:#x} vs {:#x}", i, numVertices, normals[i], all.Normals[i]);
+                    NEB_EXPECT(texCoords[i] == all.TexCoords[i], "texcoord {} of {}: {:#x} vs {:#x}", i, numVertices, texCoords[i], all.TexCoords[i]);
+                    NEB_EXPECT(tangents[i] == all.Tangents[i], "tangent {} of {}: {:#x} vs {:#x}", i, numVertices, tangents[i], all.Tangents[i]);
+                }
+            }
+            return true;
+        }
+    } // anonymous namespace
+
+    // Random unit normals and tangents, positions and texcoords stay within the bounds of the format
+    NEB_TEST(VertexCompression, RandomVerticesAcceptable)
+    {
+        const TestVertices vertices = MakeRandomVertices(10000, 0x5C0);
+        CompressedVertexData compressed;
+        CompressVertices(compressed, vertices.GetSource());
+
+        const VertexCompressionError error = MeasureVertexCompressionError(compressed, vertices.GetSource());
+        NEB_EXPECT(IsVertexCompressionErrorAcceptable(error), "position {}, normal {}, texcoord {}, tangent {}, {} handedness mismatches",
+            error.MaxPositionError, error.MaxNormalAngle, error.MaxTexCoordError, error.MaxTangentAngle, error.NumHandednessMismatches);
+        NEB_EXPECT(error.MaxNormalAngle > 0.0f && error.MaxTexCoordError > 0.0f, "random vertices are not exactly representable");
+        return true;
+    }
+
+    // Axis-aligned vectors, the lower hemisphere and its folds on the axes, zero-length vectors and both handedness signs.
+    // Positions only vary along x, so y and z are flat
+    NEB_TEST(VertexCompression, EdgeCases)
+    {
+        static constexpr float D = 0.57735026f; // 1 / sqrt(3)
+        static constexpr float Vectors[][3] = {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+            { D, D, -D }, { -D, D, -D }, { D, -D, -D }, { -D, -D, -D },
+            { 0.6f, 0.0f, -0.8f }, { 0.0f, -0.6f, -0.8f }, { -0.8f, 0.0f, -0.6f }, { 0.0f, 0.8f, -0.6f },
+            { 0.0f, 0.0f, 0.0f },
+        };
+
+        TestVertices vertices;
+        for (uint32_t i = 0; i < std::size(Vectors); ++i)
+        {
+            const float (&v)[3] = Vectors[i];
+            for (float handedness : { 1.0f, -1.0f })
+                vertices.Add({ float(i), 2.0f, -3.0f }, v, { v[0], v[1] }, { v[0], v[1], v[2], handedness });
+        }
+
+        CompressedVertexData compressed;
+        CompressVertices(compressed, vertices.GetSource());
+        const VertexCompressionError error = MeasureVertexCompressionError(compressed, vertices.GetSource());
+        NEB_EXPECT(IsVertexCompressionErrorAcceptable(error), "position {}, normal {}, texcoord {}, tangent {}, {} handedness mismatches",
+            error.MaxPositionError, error.MaxNormalAngle, error.MaxTexCoordError, error.MaxTangentAngle, error.NumHandednessMismatches);
+
+        // Flat axes are encoded as zeroes and decode exactly
+        std::vector<float> decoded(size_t(vertices.NumVertices) * 4);
+        DecodePositions(decoded.data(), compressed.Positions, compressed.Quantization);
+        for (uint32_t i = 0; i < vertices.NumVertices; ++i)
+        {
+            NEB_EXPECT(compressed.Positions[i].y == 0 && compressed.Positions[i].z == 0 && compressed.Positions[i].w == 0);
+            NEB_EXPECT(decoded[size_t(i) * 3 + 1] == 2.0f && decoded[size_t(i) * 3 + 2] == -3.0f, "position {} is off the flat axes", i);
+        }
+
+        // Zero-length vectors go to the center of the octahedron, which is +z
+        const uint32_t zero = vertices.NumVertices - 2;
+        NEB_EXPECT(compressed.Normals[zero] == 0 && compressed.Normals[zero + 1] == 0, "{:#x}", compressed.Normals[zero]);
+        DecodeNormals(decoded.data(), compressed.Normals);
+        NEB_EXPECT(decoded[size_t(zero) * 3 + 0] == 0.0f && decoded[size_t(zero) * 3 + 1] == 0.0f && decoded[size_t(zero) * 3 + 2] == 1.0f);
+
+        DecodeTangents(decoded.data(), compressed.Tangents);
+        for (uint32_t i = 0; i < vertices.NumVertices; ++i)
+            NEB_EXPECT(decoded[size_t(i) * 4 + 3] == vertices.Tangents[size_t(i) * 4 + 3], "handedness of tangent {}", i);
+
+        // A single vertex has every axis flat
+        TestVertices single;
+        single.Add({ 1.0f, -2.0f, 3.0f }, Vectors[0], { 0.5f, 0.5f }, { 0.0f, 1.0f, 0.0f, -1.0f });
+        CompressVertices(compressed, single.GetSource());
+        NEB_EXPECT(MeasureVertexCompressionError(compressed, single.GetSource()).MaxPositionError == 0.0f);
+        return true;
+    }
+
+    // Texcoords of 65520 and more overflow the half range to infinity and the submesh has to stay in the full format.
+    // 65519 still rounds down to the largest half
+    NEB_TEST(VertexCompression, TexCoordRange)
+    {
+        for (float u : { 65520.0f, -65520.0f, 1e6f, std::numeric_limits<float>::infinity() })
+        {
+            TestVertices vertices = MakeRandomVertices(16, 0x5C1);
+            vertices.TexCoords[10] = u;
+
+            CompressedVertexData compressed;
+            CompressVertices(compressed, vertices.GetSource());
+            const VertexCompressionError error = MeasureVertexCompressionError(compressed, vertices.GetSource());
+            NEB_EXPECT(!IsVertexCompressionErrorAcceptable(error), "texcoord {} is accepted with the error of {}", u, error.MaxTexCoordError);
+        }
+
+        TestVertices vertices = MakeRandomVertices(16, 0x5C1);
+        vertices.TexCoords[10] = 65519.0f;
+        vertices.TexCoords[11] = -65519.0f;
+        CompressedVertexData compressed;
+        CompressVertices(compressed, vertices.GetSource());
+        const VertexCompressionError error = MeasureVertexCompressionError(compressed, vertices.GetSource());
+        NEB_EXPECT(IsVertexCompressionErrorAcceptable(error), "error of {}", error.MaxTexCoordError);
+        return true;
+    }
+
+    // Vectorized body and scalar tail of every encoder give bitwise identical results, on random and on edge case vertices
+    NEB_TEST(VertexCompression, SimdMatchesScalar)
+    {
+        NEB_EXPECT(CheckEncodedPrefixes(MakeRandomVertices(37, 0x5C2)));
+
+        TestVertices vertices;
+        static constexpr float D = 0.70710678f;
+        static constexpr float Vectors[][3] = {
+            { 0.0f, 0.0f, -1.0f }, { D, 0.0f, -D }, { 0.0f, -D, -D }, { 0.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+        };
+        for (uint32_t i = 0; i < 24; ++i)
+        {
+            const float (&v)[3] = Vectors[i % std::size(Vectors)];
+            vertices.Add({ float(i), 0.0f, -float(i) }, v, { 1.0f / float(i + 1), -65504.0f }, { v[0], v[1], v[2], (i % 2) ? 1.0f : -1.0f });
+        }
+        NEB_EXPECT(CheckEncodedPrefixes(vertices));
+        return true;
+    }
+
+    // Round to nearest even on ties, subnormals, the boundary to normals and the overflow to infinity
+    NEB_TEST(VertexCompression, FloatToHalf)
+    {
+        struct HalfCase
+        {
+            float Value;
+            uint16_t Half;
+        };
+
+        static constexpr float Ulp1 = 1.0f / 1024.0f; // of half at 1
+        static constexpr float MinSubnormal = 5.9604645e-8f; // 2^-24
+        static constexpr float MinNormal = 6.1035156e-5f; // 2^-14
+        static constexpr HalfCase Cases[] = {
+            { 0.0f, 0x0000 }, { -0.0f, 0x8000 }, { 1.0f, 0x3c00 }, { -2.0f, 0xc000 },
+            { 1.0f + Ulp1 * 0.5f, 0x3c00 }, { 1.0f + Ulp1 * 1.5f, 0x3c02 }, { 1.0f + Ulp1 * 0.75f, 0x3c01 }, { 2.0f - Ulp1 * 0.5f, 0x4000 },
+            { MinSubnormal, 0x0001 }, { MinSubnormal * 0.5f, 0x0000 }, { MinSubnormal * 0.75f, 0x0001 }, { MinSubnormal * 1.5f, 0x0002 },
+            { MinSubnormal * 2.5f, 0x0002 }, { -MinSubnormal * 0.25f, 0x8000 },
+            { MinNormal, 0x0400 }, { MinNormal - MinSubnormal, 0x03ff }, { MinNormal - MinSubnormal * 0.5f, 0x0400 },
+            { 65504.0f, 0x7bff }, { 65519.0f, 0x7bff }, { 65520.0f, 0x7c00 }, { -65520.0f, 0xfc00 }, { 1e10f, 0x7c00 },
+            { std::numeric_limits<float>::infinity(), 0x7c00 }, { -std::numeric_limits<float>::infinity(), 0xfc00 },
+            { std::numeric_limits<float>::quiet_NaN(), 0x7e00 },
+        };
+
+        for (const HalfCase& c : Cases)
+            NEB_EXPECT(EncodeHalf(c.Value) == c.Half, "{} ({:#x}) -> {:#x}, expected {:#x}", c.Value, std::bit_cast<uint32_t>(c.Value), EncodeHalf(c.Value), c.Half);
+
+#if defined(NEB_TEST_F16C)
+        // Every half, the floats halfway to its neighbours and a few ulps around them, plus random floats
+        std::vector<float> values;
+        for (uint32_t half = 0; half < 0x7c00; ++half)
+        {
+            const float v = _cvtsh_ss(static_cast<uint16_t>(half));
+            const float next = _cvtsh_ss(static_cast<uint16_t>(half + 1));
+            const uint32_t middle = std::bit_cast<uint32_t>(v + (next - v) * 0.5f);
+            for (uint32_t bits = middle - 2; bits <= middle + 2; ++bits)
+                values.insert(values.end(), { v, std::bit_cast<float>(bits), -std::bit_cast<float>(bits) });
+        }
+
+        std::mt19937_64 random(0x5C3);
+        for (uint32_t i = 0; i < 100000; ++i)
+            values.push_back(std::bit_cast<float>(static_cast<uint32_t>(random())));
+
+        for (float v : values)
+        {
+            const uint16_t expected = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+            const uint16_t half = EncodeHalf(v);
+
+            // NaN payloads are not kept, only the NaN itself
+            const bool isNaN = (expected & 0x7c00) == 0x7c00 && (expected & 0x3ff);
+            NEB_EXPECT(isNaN ? ((half & 0x7c00) == 0x7c00 && (half & 0x3ff)) : half == expected, "{} ({:#x}) -> {:#x}, F16C gives {:#x}",
+                v, std::bit_cast<uint32_t>(v), half, expected);
+        }
+#endif
+        return true;
+    }
+
+} // Neb::test namespace